@@ -389,6 +389,8 @@ static gboolean
 gst_dash_demux_stream_advance_subfragment (GstAdaptiveDemuxStream * stream);
 static gboolean gst_dash_demux_stream_select_bitrate (GstAdaptiveDemuxStream *
     stream, guint64 bitrate);
+static guint64 *gst_dash_demux_stream_get_bitrates (GstAdaptiveDemuxStream *
+    stream, guint * n_bitrates);
 static gint64 gst_dash_demux_get_manifest_update_interval (GstAdaptiveDemux *
     demux);
 static GstFlowReturn gst_dash_demux_update_manifest_data (GstAdaptiveDemux *
@@ -638,6 +640,8 @@ gst_dash_demux_class_init (GstDashDemuxClass * klass)
   gstadaptivedemux_class->stream_seek = gst_dash_demux_stream_seek;
   gstadaptivedemux_class->stream_select_bitrate =
       gst_dash_demux_stream_select_bitrate;
+  gstadaptivedemux_class->stream_get_bitrates =
+      gst_dash_demux_stream_get_bitrates;
   gstadaptivedemux_class->stream_update_fragment_info =
       gst_dash_demux_stream_update_fragment_info;
   gstadaptivedemux_class->stream_free = gst_dash_demux_stream_free;
@@ -1060,6 +1064,9 @@ gst_dash_demux_process_manifest (GstAdaptiveDemux * demux, GstBuffer * buf)
   if (ret)
     ret = gst_dash_demux_setup_streams (demux);
 
+  if (ret)
+    gst_buffer_replace (&dashdemux->last_manifest, buf);
+
   return ret;
 }
 
@@ -1119,6 +1126,7 @@ gst_dash_demux_reset (GstAdaptiveDemux * ademux)
   }
   gst_dash_demux_clock_drift_free (demux->clock_drift);
   demux->clock_drift = NULL;
+  gst_buffer_replace (&demux->last_manifest, NULL);
   demux->client = gst_mpd_client_new ();
   gst_mpd_client_set_uri_downloader (demux->client, ademux->downloader);
 
@@ -2289,6 +2297,70 @@ end:
   return ret;
 }
 
+static gint
+gst_dash_demux_compare_bitrates (gconstpointer a, gconstpointer b)
+{
+  guint64 bitrate_a = *(const guint64 *) a;
+  guint64 bitrate_b = *(const guint64 *) b;
+
+  return bitrate_a < bitrate_b ? -1 : (bitrate_a > bitrate_b ? 1 : 0);
+}
+
+static guint64 *
+gst_dash_demux_stream_get_bitrates (GstAdaptiveDemuxStream * stream,
+    guint * n_bitrates)
+{
+  GstDashDemux *demux = GST_DASH_DEMUX_CAST (stream->demux);
+  GstDashDemuxStream *dashstream = (GstDashDemuxStream *) stream;
+  GstActiveStream *active_stream = dashstream->active_stream;
+  GList *rep_list = NULL, *l;
+  guint64 *bitrates;
+  guint n = 0;
+
+  *n_bitrates = 0;
+
+  if (active_stream && active_stream->cur_adapt_set)
+    rep_list = active_stream->cur_adapt_set->Representations;
+  if (!rep_list)
+    return NULL;
+
+  /* Only the representations gst_dash_demux_stream_select_bitrate() can
+   * switch to */
+  bitrates = g_new (guint64, g_list_length (rep_list));
+  for (l = rep_list; l; l = g_list_next (l)) {
+    GstMPDRepresentationNode *rep = l->data;
+    GstMPDRepresentationBaseNode *base = GST_MPD_REPRESENTATION_BASE_NODE (rep);
+    GstXMLFrameRate *framerate = base->frameRate;
+
+    if (!framerate)
+      framerate = base->maxFrameRate;
+
+    if (active_stream->mimeType == GST_STREAM_VIDEO && demux->max_bitrate
+        && rep->bandwidth > demux->max_bitrate)
+      continue;
+    if (demux->max_video_width > 0 && base->width > demux->max_video_width)
+      continue;
+    if (demux->max_video_height > 0 && base->height > demux->max_video_height)
+      continue;
+    if (framerate && demux->max_video_framerate_n > 0
+        && gst_util_fraction_compare (framerate->num, framerate->den,
+            demux->max_video_framerate_n, demux->max_video_framerate_d) > 0)
+      continue;
+
+    bitrates[n++] = rep->bandwidth;
+  }
+
+  if (n == 0) {
+    g_free (bitrates);
+    return NULL;
+  }
+
+  qsort (bitrates, n, sizeof (guint64), gst_dash_demux_compare_bitrates);
+  *n_bitrates = n;
+
+  return bitrates;
+}
+
 #define SEEK_UPDATES_PLAY_POSITION(r, start_type, stop_type) \
   ((r >= 0 && start_type != GST_SEEK_TYPE_NONE) || \
    (r < 0 && stop_type != GST_SEEK_TYPE_NONE))
@@ -2397,6 +2469,20 @@ gst_dash_demux_get_manifest_update_interval (GstAdaptiveDemux * demux)
       SLOW_CLOCK_UPDATE_INTERVAL);
 }
 
+static gboolean
+gst_dash_demux_manifest_equal (GstBuffer * a, GstBuffer * b)
+{
+  GstMapInfo map;
+  gboolean equal;
+
+  if (!gst_buffer_map (a, &map, GST_MAP_READ))
+    return FALSE;
+  equal = gst_buffer_memcmp (b, 0, map.data, map.size) == 0;
+  gst_buffer_unmap (a, &map);
+
+  return equal;
+}
+
 static GstFlowReturn
 gst_dash_demux_update_manifest_data (GstAdaptiveDemux * demux,
     GstBuffer * buffer)
@@ -2407,6 +2493,22 @@ gst_dash_demux_update_manifest_data (GstAdaptiveDemux * demux,
 
   GST_DEBUG_OBJECT (demux, "Updating manifest file from URL");
 
+  /* Live manifests are usually refreshed more often than they change, skip
+   * parsing when nothing did */
+  if (dashdemux->last_manifest
+      && gst_buffer_get_size (dashdemux->last_manifest) ==
+      gst_buffer_get_size (buffer)
+      && g_strcmp0 (dashdemux->client->mpd_uri, demux->manifest_uri) == 0
+      && g_strcmp0 (dashdemux->client->mpd_base_uri,
+          demux->manifest_base_uri) == 0
+      && gst_dash_demux_manifest_equal (dashdemux->last_manifest, buffer)) {
+    GST_DEBUG_OBJECT (demux, "Manifest unchanged");
+    if (dashdemux->clock_drift) {
+      gst_dash_demux_poll_clock_drift (dashdemux);
+    }
+    return GST_FLOW_OK;
+  }
+
   /* parse the manifest file */
   new_client = gst_mpd_client_new ();
   gst_mpd_client_set_uri_downloader (new_client, demux->downloader);
@@ -2426,6 +2528,8 @@ gst_dash_demux_update_manifest_data (GstAdaptiveDemux * demux,
 
     GST_DEBUG_OBJECT (demux, "Updating manifest");
 
+    gst_mpd_client_inherit_segments (new_client, dashdemux->client);
+
     period_id = gst_mpd_client_get_period_id (dashdemux->client);
     period_idx = gst_mpd_client_get_period_index (dashdemux->client);
 
@@ -2516,6 +2620,7 @@ gst_dash_demux_update_manifest_data (GstAdaptiveDemux * demux,
 
     gst_mpd_client_free (dashdemux->client);
     dashdemux->client = new_client;
+    gst_buffer_replace (&dashdemux->last_manifest, buffer);
 
     GST_DEBUG_OBJECT (demux, "Manifest file successfully updated");
     if (dashdemux->clock_drift) {
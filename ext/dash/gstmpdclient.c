@@ -48,6 +48,18 @@ static GstMPDRepresentationNode *gst_mpd_client_get_lowest_representation (GList
 static GstStreamPeriod *gst_mpd_client_get_stream_period (GstMPDClient *
     client);
 
+/* Expanded segment list of a Representation, kept to avoid rebuilding it
+ * when switching back to that Representation or when the manifest is
+ * refreshed */
+typedef struct
+{
+  GPtrArray *segments;          /* array of GstMediaSegment */
+  GstClockTime period_start, period_end;
+  /* SegmentTemplate with SegmentTimeline only, 0 otherwise */
+  guint timescale;
+  guint64 presentation_time_offset;
+} GstMPDCachedSegments;
+
 typedef GstMPDNode *(*MpdClientStringIDFilter) (GList * list, gchar * data);
 typedef GstMPDNode *(*MpdClientIDFilter) (GList * list, guint data);
 
@@ -419,6 +431,10 @@ gst_mpd_client_finalize (GObject * object)
 
   gst_mpd_client_active_streams_free (client);
 
+  g_hash_table_unref (client->segments_cache);
+  if (client->previous_segments_cache)
+    g_hash_table_unref (client->previous_segments_cache);
+
   g_free (client->mpd_uri);
   client->mpd_uri = NULL;
   g_free (client->mpd_base_uri);
@@ -438,9 +454,18 @@ gst_mpd_client_class_init (GstMPDClientClass * klass)
   object_class->finalize = gst_mpd_client_finalize;
 }
 
+static void
+gst_mpd_client_cached_segments_free (GstMPDCachedSegments * cached)
+{
+  g_ptr_array_unref (cached->segments);
+  g_slice_free (GstMPDCachedSegments, cached);
+}
+
 static void
 gst_mpd_client_init (GstMPDClient * client)
 {
+  client->segments_cache = g_hash_table_new_full (g_str_hash, g_str_equal,
+      g_free, (GDestroyNotify) gst_mpd_client_cached_segments_free);
 }
 
 GstMPDClient *
@@ -836,6 +861,208 @@ gst_mpd_client_stream_update_presentation_time_offset (GstMPDClient * client,
       GST_TIME_ARGS (stream->presentationTimeOffset));
 }
 
+/* Identifies a Representation across manifest updates */
+static gchar *
+gst_mpd_client_get_segments_cache_key (GstStreamPeriod * stream_period,
+    GstMPDAdaptationSetNode * adapt_set,
+    GstMPDRepresentationNode * representation)
+{
+  gchar *period_key, *adapt_set_key, *rep_key, *key;
+
+  if (stream_period->period->id)
+    period_key = g_strdup (stream_period->period->id);
+  else
+    period_key = g_strdup_printf ("%" G_GUINT64_FORMAT, stream_period->start);
+
+  if (adapt_set->id)
+    adapt_set_key = g_strdup_printf ("%u", adapt_set->id);
+  else
+    adapt_set_key = g_strdup_printf ("#%d",
+        g_list_index (stream_period->period->AdaptationSets, adapt_set));
+
+  if (representation->id)
+    rep_key = g_strdup (representation->id);
+  else
+    rep_key = g_strdup_printf ("#%d",
+        g_list_index (adapt_set->Representations, representation));
+
+  key = g_strdup_printf ("%s/%s/%s", period_key, adapt_set_key, rep_key);
+  g_free (period_key);
+  g_free (adapt_set_key);
+  g_free (rep_key);
+
+  return key;
+}
+
+static GstMPDCachedSegments *
+gst_mpd_client_lookup_segments (GHashTable * cache, GstActiveStream * stream,
+    GstStreamPeriod * stream_period, GstMPDRepresentationNode * representation)
+{
+  gchar *key;
+  GstMPDCachedSegments *cached;
+
+  if (cache == NULL)
+    return NULL;
+
+  key = gst_mpd_client_get_segments_cache_key (stream_period,
+      stream->cur_adapt_set, representation);
+  cached = g_hash_table_lookup (cache, key);
+  g_free (key);
+
+  return cached;
+}
+
+static void
+gst_mpd_client_store_segments (GstMPDClient * client, GstActiveStream * stream,
+    GstStreamPeriod * stream_period, GstMPDRepresentationNode * representation,
+    GstClockTime period_start, GstClockTime period_end,
+    GstMPDMultSegmentBaseNode * timeline_mult_seg)
+{
+  GstMPDCachedSegments *cached;
+
+  cached = g_slice_new0 (GstMPDCachedSegments);
+  cached->segments = g_ptr_array_ref (stream->segments);
+  cached->period_start = period_start;
+  cached->period_end = period_end;
+  if (timeline_mult_seg) {
+    cached->timescale = timeline_mult_seg->SegmentBase->timescale;
+    cached->presentation_time_offset =
+        timeline_mult_seg->SegmentBase->presentationTimeOffset;
+  }
+
+  g_hash_table_replace (client->segments_cache,
+      gst_mpd_client_get_segments_cache_key (stream_period,
+          stream->cur_adapt_set, representation), cached);
+}
+
+/* Index of the first segment of @segments starting at or after @scale_start,
+ * in timescale units */
+static guint
+gst_mpd_client_find_segment_by_scale_start (GPtrArray * segments,
+    guint64 scale_start)
+{
+  guint lo = 0, hi = segments->len;
+
+  while (lo < hi) {
+    guint mid = lo + (hi - lo) / 2;
+    GstMediaSegment *segment = g_ptr_array_index (segments, mid);
+
+    if (segment->scale_start < scale_start)
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+
+  return lo;
+}
+
+/* Builds the segment list of a SegmentTemplate with a SegmentTimeline. The
+ * entries of @previous, built from the previous version of the manifest,
+ * matching the S elements are copied instead of being computed again so
+ * that in the common case only the newly added S elements are expanded */
+static gboolean
+gst_mpd_client_build_timeline_segments (GstActiveStream * stream,
+    GstMPDMultSegmentBaseNode * mult_seg, GstClockTime PeriodStart,
+    GstClockTime presentationTimeOffset, GstMPDCachedSegments * previous)
+{
+  GstMPDSegmentTimelineNode *timeline = mult_seg->SegmentTimeline;
+  GPtrArray *previous_segments = NULL;
+  guint timescale = mult_seg->SegmentBase->timescale;
+  guint previous_idx = 0, n_reused = 0;
+  GstClockTime start_time = 0, duration;
+  guint64 start = 0;
+  guint i = mult_seg->startNumber;
+  GstMPDSNode *S;
+  GList *list;
+
+  if (previous && previous->timescale == timescale
+      && previous->presentation_time_offset ==
+      mult_seg->SegmentBase->presentationTimeOffset
+      && previous->segments->len > 0)
+    previous_segments = previous->segments;
+
+  for (list = g_queue_peek_head_link (&timeline->S); list;
+      list = g_list_next (list)) {
+    GstMediaSegment *reused = NULL;
+    guint64 scale_start;
+
+    S = (GstMPDSNode *) list->data;
+    GST_LOG ("Processing S node: d=%" G_GUINT64_FORMAT " r=%u t=%"
+        G_GUINT64_FORMAT, S->d, S->r, S->t);
+    scale_start = S->t > 0 ? S->t : start;
+
+    if (previous_segments) {
+      /* Find where the timeline starts in the previous one and then step
+       * through both as long as they match */
+      if (n_reused == 0)
+        previous_idx =
+            gst_mpd_client_find_segment_by_scale_start (previous_segments,
+            scale_start);
+
+      if (previous_idx < previous_segments->len) {
+        GstMediaSegment *segment =
+            g_ptr_array_index (previous_segments, previous_idx);
+
+        if (segment->scale_start == scale_start
+            && segment->scale_duration == S->d && segment->repeat == S->r
+            && segment->number == i)
+          reused = segment;
+      }
+
+      /* Everything after a mismatch is new */
+      if (reused == NULL && n_reused > 0)
+        previous_segments = NULL;
+    }
+
+    if (reused) {
+      GST_LOG ("Reusing segment %u of the previous manifest", reused->number);
+      g_ptr_array_add (stream->segments,
+          g_slice_dup (GstMediaSegment, reused));
+      start_time = reused->start;
+      duration = reused->duration;
+      previous_idx++;
+      n_reused++;
+    } else {
+      duration = gst_util_uint64_scale (S->d, GST_SECOND, timescale);
+      if (S->t > 0) {
+        start_time = gst_util_uint64_scale (S->t, GST_SECOND, timescale)
+            + PeriodStart - presentationTimeOffset;
+      }
+
+      if (!gst_mpd_client_add_media_segment (stream, NULL, i, S->r,
+              scale_start, S->d, start_time, duration)) {
+        return FALSE;
+      }
+    }
+    start = scale_start;
+    i += S->r + 1;
+    start += S->d * (S->r + 1);
+    start_time += duration * (S->r + 1);
+  }
+
+  if (previous)
+    GST_DEBUG ("Reused %u of %u timeline entries from the previous manifest",
+        n_reused, stream->segments->len);
+
+  return TRUE;
+}
+
+/* Lets @client reuse the segment lists built by @previous, the client of the
+ * previous version of the manifest, for the Representations that are still
+ * present so that only the segments added to their SegmentTimeline need to
+ * be built */
+void
+gst_mpd_client_inherit_segments (GstMPDClient * client,
+    GstMPDClient * previous)
+{
+  g_return_if_fail (client != NULL);
+
+  if (client->previous_segments_cache)
+    g_hash_table_unref (client->previous_segments_cache);
+  client->previous_segments_cache =
+      previous ? g_hash_table_ref (previous->segments_cache) : NULL;
+}
+
 gboolean
 gst_mpd_client_setup_representation (GstMPDClient * client,
     GstActiveStream * stream, GstMPDRepresentationNode * representation)
@@ -843,6 +1070,9 @@ gst_mpd_client_setup_representation (GstMPDClient * client,
   GstStreamPeriod *stream_period;
   GList *rep_list;
   GstClockTime PeriodStart, PeriodEnd, start_time, duration;
+  GstMPDCachedSegments *cached;
+  GstMPDMultSegmentBaseNode *timeline_mult_seg = NULL;
+  gboolean cacheable = FALSE, from_cache = FALSE;
   guint i;
   guint64 start;
 
@@ -899,7 +1129,17 @@ gst_mpd_client_setup_representation (GstMPDClient * client,
               PeriodEnd - PeriodStart, PeriodStart, PeriodEnd - PeriodStart)) {
         return FALSE;
       }
+    } else if ((cached = gst_mpd_client_lookup_segments (client->segments_cache,
+                stream, stream_period, representation))
+        && cached->period_start == PeriodStart
+        && cached->period_end == PeriodEnd) {
+      GST_LOG ("Reusing the segment list built for this Representation");
+      g_ptr_array_unref (stream->segments);
+      stream->segments = g_ptr_array_ref (cached->segments);
+      from_cache = TRUE;
     } else {
+      cacheable = TRUE;
+
       /* build the list of GstMediaSegment nodes from the SegmentList node */
       SegmentURL = stream->cur_segment_list->SegmentURL;
       if (SegmentURL == NULL) {
@@ -1014,44 +1254,35 @@ gst_mpd_client_setup_representation (GstMPDClient * client,
           GST_SECOND, mult_seg->SegmentBase->timescale);
       GST_LOG ("presentationTimeOffset = %" GST_TIME_FORMAT,
           GST_TIME_ARGS (presentationTimeOffset));
-      /* build segment list */
-      i = mult_seg->startNumber;
-      start = 0;
-      start_time = 0;
 
       GST_LOG ("Building media segment list using this template: %s",
           stream->cur_seg_template->media);
 
-      if (mult_seg->SegmentTimeline) {
-        GstMPDSegmentTimelineNode *timeline;
-        GstMPDSNode *S;
-        GList *list;
+      if (mult_seg->SegmentTimeline
+          && (cached = gst_mpd_client_lookup_segments (client->segments_cache,
+                  stream, stream_period, representation))
+          && cached->period_start == PeriodStart
+          && cached->period_end == PeriodEnd) {
+        GST_LOG ("Reusing the segment list built for this Representation");
+        stream->segments = g_ptr_array_ref (cached->segments);
+        from_cache = TRUE;
+      } else if (mult_seg->SegmentTimeline) {
+        /* Entries built from an unclipped timeline of the previous version
+         * of the manifest can be carried over */
+        cached = gst_mpd_client_lookup_segments
+            (client->previous_segments_cache, stream, stream_period,
+            representation);
+        if (cached && (cached->period_start != PeriodStart
+                || GST_CLOCK_TIME_IS_VALID (cached->period_end)))
+          cached = NULL;
 
-        timeline = mult_seg->SegmentTimeline;
         gst_mpdparser_init_active_stream_segments (stream);
-        for (list = g_queue_peek_head_link (&timeline->S); list;
-            list = g_list_next (list)) {
-          guint timescale;
-
-          S = (GstMPDSNode *) list->data;
-          GST_LOG ("Processing S node: d=%" G_GUINT64_FORMAT " r=%u t=%"
-              G_GUINT64_FORMAT, S->d, S->r, S->t);
-          timescale = mult_seg->SegmentBase->timescale;
-          duration = gst_util_uint64_scale (S->d, GST_SECOND, timescale);
-          if (S->t > 0) {
-            start = S->t;
-            start_time = gst_util_uint64_scale (S->t, GST_SECOND, timescale)
-                + PeriodStart - presentationTimeOffset;
-          }
+        if (!gst_mpd_client_build_timeline_segments (stream, mult_seg,
+                PeriodStart, presentationTimeOffset, cached))
+          return FALSE;
 
-          if (!gst_mpd_client_add_media_segment (stream, NULL, i, S->r, start,
-                  S->d, start_time, duration)) {
-            return FALSE;
-          }
-          i += S->r + 1;
-          start += S->d * (S->r + 1);
-          start_time += duration * (S->r + 1);
-        }
+        cacheable = TRUE;
+        timeline_mult_seg = mult_seg;
       } else {
         /* NOP - The segment is created on demand with the template, no need
          * to build a list */
@@ -1059,8 +1290,9 @@ gst_mpd_client_setup_representation (GstMPDClient * client,
     }
   }
 
-  /* clip duration of segments to stop at period end */
-  if (stream->segments && stream->segments->len) {
+  /* clip duration of segments to stop at period end, cached lists already
+   * are */
+  if (!from_cache && stream->segments && stream->segments->len) {
     if (GST_CLOCK_TIME_IS_VALID (PeriodEnd)) {
       guint n;
 
@@ -1105,6 +1337,10 @@ gst_mpd_client_setup_representation (GstMPDClient * client,
 #endif
   }
 
+  if (cacheable)
+    gst_mpd_client_store_segments (client, stream, stream_period,
+        representation, PeriodStart, PeriodEnd, timeline_mult_seg);
+
   g_free (stream->baseURL);
   g_free (stream->queryURL);
   stream->baseURL =
@@ -47,6 +47,9 @@ struct _GstMPDClient
   gboolean profile_isoff_ondemand;
 
   GstUriDownloader * downloader;
+
+  GHashTable *segments_cache;                 /* segment lists built per Representation */
+  GHashTable *previous_segments_cache;        /* segments_cache of the previous manifest */
 };
 
 /* Basic initialization/deinitialization functions */
@@ -71,6 +74,7 @@ void gst_mpd_client_fetch_on_load_external_resources (GstMPDClient * client);
 gboolean gst_mpd_client_setup_media_presentation (GstMPDClient *client, GstClockTime time, gint period_index, const gchar *period_id);
 gboolean gst_mpd_client_setup_streaming (GstMPDClient * client, GstMPDAdaptationSetNode * adapt_set);
 gboolean gst_mpd_client_setup_representation (GstMPDClient *client, GstActiveStream *stream, GstMPDRepresentationNode *representation);
+void gst_mpd_client_inherit_segments (GstMPDClient * client, GstMPDClient * previous);
 
 GstClockTime gst_mpd_client_get_next_fragment_duration (GstMPDClient * client, GstActiveStream * stream);
 GstClockTime gst_mpd_client_get_media_presentation_duration (GstMPDClient *client);
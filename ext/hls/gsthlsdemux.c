@@ -62,7 +62,21 @@ GST_DEBUG_CATEGORY (gst_hls_demux_debug);
 #define GST_M3U8_CLIENT_LOCK(l) /* FIXME */
 #define GST_M3U8_CLIENT_UNLOCK(l)       /* FIXME */
 
+enum
+{
+  PROP_0,
+
+  PROP_LOW_LATENCY,
+  PROP_LAST
+};
+
+#define DEFAULT_LOW_LATENCY FALSE
+
 /* GObject */
+static void gst_hls_demux_set_property (GObject * object, guint prop_id,
+    const GValue * value, GParamSpec * pspec);
+static void gst_hls_demux_get_property (GObject * object, guint prop_id,
+    GValue * value, GParamSpec * pspec);
 static void gst_hls_demux_finalize (GObject * obj);
 
 /* GstElement */
@@ -72,6 +86,8 @@ gst_hls_demux_change_state (GstElement * element, GstStateChange transition);
 /* GstHLSDemux */
 static gboolean gst_hls_demux_update_playlist (GstHLSDemux * demux,
     gboolean update, GError ** err);
+static GstFlowReturn gst_hls_demux_reload_playlist (GstHLSDemux * demux,
+    gboolean update, gboolean blocking, GError ** err);
 static gchar *gst_hls_src_buf_to_utf8_playlist (GstBuffer * buf);
 
 /* FIXME: the return value is never used? */
@@ -107,10 +123,15 @@ static gboolean gst_hls_demux_stream_has_next_fragment (GstAdaptiveDemuxStream *
     stream);
 static GstFlowReturn gst_hls_demux_advance_fragment (GstAdaptiveDemuxStream *
     stream);
+static gboolean gst_hls_demux_stream_peek_fragment (GstAdaptiveDemuxStream *
+    stream, guint index, gchar ** uri, gint64 * range_start,
+    gint64 * range_end);
 static GstFlowReturn gst_hls_demux_update_fragment_info (GstAdaptiveDemuxStream
     * stream);
 static gboolean gst_hls_demux_select_bitrate (GstAdaptiveDemuxStream * stream,
     guint64 bitrate);
+static guint64 *gst_hls_demux_stream_get_bitrates (GstAdaptiveDemuxStream *
+    stream, guint * n_bitrates);
 static void gst_hls_demux_reset (GstAdaptiveDemux * demux);
 static gboolean gst_hls_demux_get_live_seek_range (GstAdaptiveDemux * demux,
     gint64 * start, gint64 * stop);
@@ -138,6 +159,38 @@ gst_hls_demux_finalize (GObject * obj)
   G_OBJECT_CLASS (parent_class)->finalize (obj);
 }
 
+static void
+gst_hls_demux_set_property (GObject * object, guint prop_id,
+    const GValue * value, GParamSpec * pspec)
+{
+  GstHLSDemux *demux = GST_HLS_DEMUX (object);
+
+  switch (prop_id) {
+    case PROP_LOW_LATENCY:
+      demux->low_latency = g_value_get_boolean (value);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+}
+
+static void
+gst_hls_demux_get_property (GObject * object, guint prop_id, GValue * value,
+    GParamSpec * pspec)
+{
+  GstHLSDemux *demux = GST_HLS_DEMUX (object);
+
+  switch (prop_id) {
+    case PROP_LOW_LATENCY:
+      g_value_set_boolean (value, demux->low_latency);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+}
+
 static void
 gst_hls_demux_class_init (GstHLSDemuxClass * klass)
 {
@@ -149,8 +202,26 @@ gst_hls_demux_class_init (GstHLSDemuxClass * klass)
   element_class = (GstElementClass *) klass;
   adaptivedemux_class = (GstAdaptiveDemuxClass *) klass;
 
+  gobject_class->set_property = gst_hls_demux_set_property;
+  gobject_class->get_property = gst_hls_demux_get_property;
   gobject_class->finalize = gst_hls_demux_finalize;
 
+  /**
+   * GstHLSDemux:low-latency:
+   *
+   * Play live Low-Latency HLS playlists close to the live edge by
+   * downloading partial segments (EXT-X-PART) and using blocking playlist
+   * reloads when the server supports them. Playlists without partial
+   * segments are played as usual.
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (gobject_class, PROP_LOW_LATENCY,
+      g_param_spec_boolean ("low-latency", "Low latency",
+          "Use partial segments and blocking playlist reloads of "
+          "Low-Latency HLS live streams", DEFAULT_LOW_LATENCY,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
   element_class->change_state = GST_DEBUG_FUNCPTR (gst_hls_demux_change_state);
 
   gst_element_class_add_static_pad_template (element_class, &srctemplate);
@@ -178,7 +249,10 @@ gst_hls_demux_class_init (GstHLSDemuxClass * klass)
   adaptivedemux_class->stream_advance_fragment = gst_hls_demux_advance_fragment;
   adaptivedemux_class->stream_update_fragment_info =
       gst_hls_demux_update_fragment_info;
+  adaptivedemux_class->stream_peek_fragment =
+      gst_hls_demux_stream_peek_fragment;
   adaptivedemux_class->stream_select_bitrate = gst_hls_demux_select_bitrate;
+  adaptivedemux_class->stream_get_bitrates = gst_hls_demux_stream_get_bitrates;
   adaptivedemux_class->stream_free = gst_hls_demux_stream_free;
 
   adaptivedemux_class->start_fragment = gst_hls_demux_start_fragment;
@@ -197,6 +271,7 @@ gst_hls_demux_init (GstHLSDemux * demux)
 
   demux->keys = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, g_free);
   g_mutex_init (&demux->keys_lock);
+  demux->low_latency = DEFAULT_LOW_LATENCY;
 }
 
 static GstStateChangeReturn
@@ -289,7 +364,7 @@ gst_hls_demux_set_current (GstHLSDemux * self, GstM3U8 * m3u8)
   if (m3u8 != self->current) {
     self->current = m3u8;
     self->current->duration = GST_CLOCK_TIME_NONE;
-    self->current->current_file = NULL;
+    self->current->current_file_idx = -1;
 
 #if 0
     // FIXME: this makes no sense after we just set self->current=m3u8 above (tpm)
@@ -404,20 +479,43 @@ gst_hls_demux_seek (GstAdaptiveDemux * demux, GstEvent * seek)
   return TRUE;
 }
 
+/* Number of files of @m3u8 starting before @offset, relative to the start
+ * of the first file, or at @offset too if @inclusive */
+static guint
+gst_hls_demux_count_files_before (GstM3U8 * m3u8, GstClockTime offset,
+    gboolean inclusive)
+{
+  guint lo = 0, hi = m3u8->file_starts->len;
+
+  while (lo < hi) {
+    guint mid = lo + (hi - lo) / 2;
+    GstClockTime start = g_array_index (m3u8->file_starts, GstClockTime, mid);
+
+    if (start < offset || (inclusive && start == offset))
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+
+  return lo;
+}
+
 static GstFlowReturn
 gst_hls_demux_stream_seek (GstAdaptiveDemuxStream * stream, gboolean forward,
     GstSeekFlags flags, GstClockTime ts, GstClockTime * final_ts)
 {
   GstHLSDemuxStream *hls_stream = GST_HLS_DEMUX_STREAM_CAST (stream);
-  GList *walk;
-  GstClockTime current_pos;
+  GstM3U8 *m3u8 = hls_stream->playlist;
+  GstClockTime current_pos, first_pos, offset, total;
   gint64 current_sequence;
   gboolean snap_after, snap_nearest;
   GstM3U8MediaFile *file = NULL;
+  guint n_files, before;
+  gint idx = -1;
 
   current_sequence = 0;
-  current_pos = gst_m3u8_is_live (hls_stream->playlist) ?
-      hls_stream->playlist->first_file_start : 0;
+  first_pos = gst_m3u8_is_live (m3u8) ? m3u8->first_file_start : 0;
+  current_pos = first_pos;
 
   /* Snap to segment boundary. Improves seek performance on slow machines. */
   snap_nearest =
@@ -425,41 +523,85 @@ gst_hls_demux_stream_seek (GstAdaptiveDemuxStream * stream, gboolean forward,
   snap_after = ! !(flags & GST_SEEK_FLAG_SNAP_AFTER);
 
   GST_M3U8_CLIENT_LOCK (hlsdemux->client);
+  n_files = m3u8->files->len;
+  total = 0;
+  if (n_files > 0) {
+    file = g_ptr_array_index (m3u8->files, n_files - 1);
+    total = g_array_index (m3u8->file_starts, GstClockTime, n_files - 1) +
+        file->duration;
+  }
+
   /* FIXME: Here we need proper discont handling */
-  for (walk = hls_stream->playlist->files; walk; walk = walk->next) {
-    file = walk->data;
+  if (ts < first_pos) {
+    /* Only snapping forward can find a fragment before the first one */
+    if ((forward && snap_after) || snap_nearest)
+      idx = n_files > 0 ? 0 : -1;
+  } else {
+    offset = ts - first_pos;
 
-    current_sequence = file->sequence;
     if ((forward && snap_after) || snap_nearest) {
-      if (current_pos >= ts)
-        break;
-      if (snap_nearest && ts - current_pos < file->duration / 2)
-        break;
+      /* The first fragment starting at or after the target, or the one
+       * containing it if the target is in its first half */
+      before = gst_hls_demux_count_files_before (m3u8, offset, FALSE);
+      idx = before < n_files ? before : -1;
+      if (snap_nearest && before > 0) {
+        GstClockTime start = g_array_index (m3u8->file_starts, GstClockTime,
+            before - 1);
+
+        file = g_ptr_array_index (m3u8->files, before - 1);
+        if (offset - start < file->duration / 2)
+          idx = before - 1;
+      }
     } else if (!forward && snap_after) {
       /* check if the next fragment is our target, in this case we want to
        * start from the previous fragment */
-      GstClockTime next_pos = current_pos + file->duration;
+      guint next;
 
-      if (next_pos <= ts && ts < next_pos + file->duration) {
-        break;
+      before = gst_hls_demux_count_files_before (m3u8, offset, TRUE);
+      next = before;
+
+      if (before == n_files && offset >= total)
+        next = n_files + 1;
+      if (next >= 2) {
+        GstClockTime next_pos = next - 1 < n_files ?
+            g_array_index (m3u8->file_starts, GstClockTime, next - 1) : total;
+
+        file = g_ptr_array_index (m3u8->files, next - 2);
+        if (offset < next_pos + file->duration)
+          idx = next - 2;
       }
-    } else if (current_pos <= ts && ts < current_pos + file->duration) {
-      break;
+    } else if ((before = gst_hls_demux_count_files_before (m3u8, offset,
+                TRUE)) > 0) {
+      GstClockTime start = g_array_index (m3u8->file_starts, GstClockTime,
+          before - 1);
+
+      file = g_ptr_array_index (m3u8->files, before - 1);
+      if (offset < start + file->duration)
+        idx = before - 1;
     }
-    current_pos += file->duration;
   }
 
-  if (walk == NULL) {
+  if (idx >= 0) {
+    file = g_ptr_array_index (m3u8->files, idx);
+    current_sequence = file->sequence;
+    current_pos = first_pos + g_array_index (m3u8->file_starts,
+        GstClockTime, idx);
+  } else {
     GST_DEBUG_OBJECT (stream->pad, "seeking further than track duration");
-    current_sequence++;
+    file = n_files > 0 ? g_ptr_array_index (m3u8->files, n_files - 1) : NULL;
+    current_sequence = file ? file->sequence + 1 : 1;
+    current_pos = first_pos + total;
   }
 
   GST_DEBUG_OBJECT (stream->pad, "seeking to sequence %u",
       (guint) current_sequence);
   hls_stream->reset_pts = TRUE;
-  hls_stream->playlist->sequence = current_sequence;
-  hls_stream->playlist->current_file = walk;
-  hls_stream->playlist->sequence_position = current_pos;
+  m3u8->sequence = current_sequence;
+  m3u8->current_file_idx = idx;
+  m3u8->sequence_position = current_pos;
+  /* Seeks always land on segment boundaries */
+  if (m3u8->current_part_idx > 0)
+    m3u8->current_part_idx = 0;
   GST_M3U8_CLIENT_UNLOCK (hlsdemux->client);
 
   /* Play from the end of the current selected segment */
@@ -481,7 +623,13 @@ static GstFlowReturn
 gst_hls_demux_update_manifest (GstAdaptiveDemux * demux)
 {
   GstHLSDemux *hlsdemux = GST_HLS_DEMUX_CAST (demux);
-  if (!gst_hls_demux_update_playlist (hlsdemux, TRUE, NULL))
+  GstFlowReturn ret;
+
+  ret = gst_hls_demux_reload_playlist (hlsdemux, TRUE, hlsdemux->low_latency,
+      NULL);
+  if (ret == GST_FLOW_FLUSHING)
+    return ret;
+  if (ret != GST_FLOW_OK)
     return GST_FLOW_ERROR;
 
   return GST_FLOW_OK;
@@ -717,6 +865,9 @@ gst_hls_demux_set_current_variant (GstHLSDemux * hlsdemux,
     variant->m3u8->sequence_position =
         hlsdemux->current_variant->m3u8->sequence_position;
     variant->m3u8->sequence = hlsdemux->current_variant->m3u8->sequence;
+    variant->m3u8->current_file_idx = -1;
+    variant->m3u8->current_part_idx =
+        hlsdemux->current_variant->m3u8->current_part_idx;
 
     GST_DEBUG_OBJECT (hlsdemux,
         "Switching Variant. Copying over sequence %" G_GINT64_FORMAT
@@ -738,6 +889,9 @@ gst_hls_demux_set_current_variant (GstHLSDemux * hlsdemux,
           GST_LOG_OBJECT (hlsdemux, "new_media '%s' '%s'", new_media->name,
               new_media->uri);
           new_media->playlist->sequence = old_media->playlist->sequence;
+          new_media->playlist->current_file_idx = -1;
+          new_media->playlist->current_part_idx =
+              old_media->playlist->current_part_idx;
           new_media->playlist->sequence_position =
               old_media->playlist->sequence_position;
         } else {
@@ -759,6 +913,35 @@ gst_hls_demux_set_current_variant (GstHLSDemux * hlsdemux,
 
 }
 
+/* Move the current variant and its renditions to the partial segment
+ * PART-HOLD-BACK from the end of a Low-Latency HLS playlist */
+static gboolean
+gst_hls_demux_seek_live_edge_part (GstHLSDemux * demux)
+{
+  GstM3U8 *m3u8 = demux->current_variant->m3u8;
+  gint i;
+
+  if (!gst_m3u8_seek_live_edge_part (m3u8))
+    return FALSE;
+
+  GST_DEBUG_OBJECT (demux, "Starting at sequence %" G_GINT64_FORMAT
+      " part %d, position %" GST_TIME_FORMAT, m3u8->sequence,
+      m3u8->current_part_idx, GST_TIME_ARGS (m3u8->sequence_position));
+
+  for (i = 0; i < GST_HLS_N_MEDIA_TYPES; ++i) {
+    GList *mlist;
+
+    for (mlist = demux->current_variant->media[i]; mlist; mlist = mlist->next) {
+      GstHLSMedia *media = mlist->data;
+
+      if (media->uri != NULL)
+        gst_m3u8_seek_live_edge_part (media->playlist);
+    }
+  }
+
+  return TRUE;
+}
+
 static gboolean
 gst_hls_demux_process_manifest (GstAdaptiveDemux * demux, GstBuffer * buf)
 {
@@ -813,6 +996,8 @@ gst_hls_demux_process_manifest (GstAdaptiveDemux * demux, GstBuffer * buf)
       GST_M3U8_CLIENT_UNLOCK (self);
       return FALSE;
     }
+  } else if (hlsdemux->low_latency) {
+    gst_hls_demux_seek_live_edge_part (hlsdemux);
   }
   GST_M3U8_CLIENT_UNLOCK (self);
 
@@ -1303,6 +1488,32 @@ gst_hls_demux_update_fragment_info (GstAdaptiveDemuxStream * stream)
   return GST_FLOW_OK;
 }
 
+static gboolean
+gst_hls_demux_stream_peek_fragment (GstAdaptiveDemuxStream * stream,
+    guint index, gchar ** uri, gint64 * range_start, gint64 * range_end)
+{
+  GstHLSDemuxStream *hlsdemux_stream = GST_HLS_DEMUX_STREAM_CAST (stream);
+  GstM3U8MediaFile *file;
+  GstM3U8 *m3u8;
+
+  m3u8 = gst_hls_demux_stream_get_m3u8 (hlsdemux_stream);
+
+  file = gst_m3u8_peek_fragment (m3u8, stream->demux->segment.rate > 0, index);
+  if (file == NULL)
+    return FALSE;
+
+  *uri = g_strdup (file->uri);
+  *range_start = file->offset;
+  if (file->size != -1)
+    *range_end = file->offset + file->size - 1;
+  else
+    *range_end = -1;
+
+  gst_m3u8_media_file_unref (file);
+
+  return TRUE;
+}
+
 static gboolean
 gst_hls_demux_select_bitrate (GstAdaptiveDemuxStream * stream, guint64 bitrate)
 {
@@ -1332,6 +1543,45 @@ gst_hls_demux_select_bitrate (GstAdaptiveDemuxStream * stream, guint64 bitrate)
   return changed;
 }
 
+static guint64 *
+gst_hls_demux_stream_get_bitrates (GstAdaptiveDemuxStream * stream,
+    guint * n_bitrates)
+{
+  GstHLSDemux *hlsdemux = GST_HLS_DEMUX_CAST (stream->demux);
+  GstHLSDemuxStream *hls_stream = GST_HLS_DEMUX_STREAM_CAST (stream);
+  guint64 *bitrates = NULL;
+  GList *variants, *l;
+  guint i = 0;
+
+  *n_bitrates = 0;
+
+  /* Only the primary stream switches between variants */
+  if (hls_stream->is_primary_playlist == FALSE)
+    return NULL;
+
+  GST_M3U8_CLIENT_LOCK (hlsdemux->client);
+  if (hlsdemux->master == NULL || hlsdemux->master->is_simple) {
+    GST_M3U8_CLIENT_UNLOCK (hlsdemux->client);
+    return NULL;
+  }
+
+  /* Same list as gst_hls_master_playlist_get_variant_for_bitrate() */
+  if (hlsdemux->current_variant != NULL && hlsdemux->current_variant->iframe)
+    variants = hlsdemux->master->iframe_variants;
+  else
+    variants = hlsdemux->master->variants;
+
+  bitrates = g_new (guint64, g_list_length (variants));
+  for (l = variants; l != NULL; l = l->next) {
+    GstHLSVariantStream *variant = l->data;
+    bitrates[i++] = variant->bandwidth;
+  }
+  *n_bitrates = i;
+  GST_M3U8_CLIENT_UNLOCK (hlsdemux->client);
+
+  return bitrates;
+}
+
 static void
 gst_hls_demux_reset (GstAdaptiveDemux * ademux)
 {
@@ -1451,6 +1701,8 @@ gst_hls_demux_update_variant_playlist (GstHLSDemux * hlsdemux, gchar * data,
       /* FIXME: Deal with losing position due to missing an update */
       variant->m3u8->sequence_position = old->m3u8->sequence_position;
       variant->m3u8->sequence = old->m3u8->sequence;
+      variant->m3u8->current_file_idx = -1;
+      variant->m3u8->current_part_idx = old->m3u8->current_part_idx;
     }
   }
 
@@ -1494,9 +1746,32 @@ out:
   return ret;
 }
 
-static gboolean
+/* Blocking reloads are held by the server for up to a few partial segment
+ * durations, so they are done without the manifest lock. The demuxer state
+ * has to be checked again after this returns */
+static GstFlowReturn
+gst_hls_demux_fetch_blocking_reload (GstHLSDemux * demux, const gchar * uri,
+    GstFragment ** download, GError ** err)
+{
+  GstAdaptiveDemux *adaptive_demux = GST_ADAPTIVE_DEMUX (demux);
+  gchar *main_uri;
+  GstFlowReturn ret;
+
+  GST_LOG_OBJECT (demux, "Blocking playlist reload %s", uri);
+
+  /* The manifest URI can be updated while the lock is released */
+  main_uri = g_strdup (gst_adaptive_demux_get_manifest_ref_uri
+      (adaptive_demux));
+  ret = gst_adaptive_demux_fetch_manifest_unlocked (adaptive_demux, uri,
+      main_uri, download, err);
+  g_free (main_uri);
+
+  return ret;
+}
+
+static GstFlowReturn
 gst_hls_demux_update_rendition_manifest (GstHLSDemux * demux,
-    GstHLSMedia * media, GError ** err)
+    GstHLSMedia * media, gboolean blocking, GError ** err)
 {
   GstAdaptiveDemux *adaptive_demux = GST_ADAPTIVE_DEMUX (demux);
   GstFragment *download;
@@ -1504,20 +1779,40 @@ gst_hls_demux_update_rendition_manifest (GstHLSDemux * demux,
   gchar *playlist;
   const gchar *main_uri;
   GstM3U8 *m3u8;
-  gchar *uri = media->uri;
+  gchar *uri = NULL;
 
-  main_uri = gst_adaptive_demux_get_manifest_ref_uri (adaptive_demux);
-  download =
-      gst_uri_downloader_fetch_uri (adaptive_demux->downloader, uri, main_uri,
-      TRUE, TRUE, TRUE, err);
+  m3u8 = media->playlist;
 
-  if (download == NULL)
-    return FALSE;
+  /* Wait until the rendition is as recent as the variant playlist that was
+   * just reloaded, so that they stay aligned on partial segments */
+  if (blocking)
+    uri = gst_m3u8_get_aligned_blocking_reload_uri (m3u8,
+        demux->current_variant->m3u8);
+  blocking = (uri != NULL);
 
-  m3u8 = media->playlist;
+  if (blocking) {
+    GstFlowReturn ret;
 
-  /* Set the base URI of the playlist to the redirect target if any */
-  if (download->redirect_permanent && download->redirect_uri) {
+    ret = gst_hls_demux_fetch_blocking_reload (demux, uri, &download, err);
+    g_free (uri);
+    if (ret != GST_FLOW_OK)
+      return ret;
+  } else {
+    main_uri = gst_adaptive_demux_get_manifest_ref_uri (adaptive_demux);
+    download =
+        gst_uri_downloader_fetch_uri (adaptive_demux->downloader, media->uri,
+        main_uri, TRUE, TRUE, TRUE, err);
+
+    if (download == NULL)
+      return GST_FLOW_ERROR;
+  }
+
+  /* Set the base URI of the playlist to the redirect target if any. The
+   * URI of a blocking reload carries the delivery directives, so keep the
+   * plain playlist URI in that case */
+  if (blocking) {
+    /* nothing to do */
+  } else if (download->redirect_permanent && download->redirect_uri) {
     gst_m3u8_set_uri (m3u8, download->redirect_uri, NULL, media->name);
   } else {
     gst_m3u8_set_uri (m3u8, download->uri, download->redirect_uri, media->name);
@@ -1532,24 +1827,50 @@ gst_hls_demux_update_rendition_manifest (GstHLSDemux * demux,
     GST_WARNING_OBJECT (demux, "Couldn't validate playlist encoding");
     g_set_error (err, GST_STREAM_ERROR, GST_STREAM_ERROR_WRONG_TYPE,
         "Couldn't validate playlist encoding");
-    return FALSE;
+    return GST_FLOW_ERROR;
   }
 
   if (!gst_m3u8_update (m3u8, playlist)) {
     GST_WARNING_OBJECT (demux, "Couldn't update playlist");
     g_set_error (err, GST_STREAM_ERROR, GST_STREAM_ERROR_FAILED,
         "Couldn't update playlist");
-    return FALSE;
+    return GST_FLOW_ERROR;
   }
 
-  return TRUE;
+  return GST_FLOW_OK;
 }
 
+/* Whether the response to the blocking reload of @uri can still be used
+ * to update @variant, which is not the case if the variant was switched or
+ * its playlist reloaded while the manifest lock was released */
 static gboolean
-gst_hls_demux_update_playlist (GstHLSDemux * demux, gboolean update,
-    GError ** err)
+gst_hls_demux_blocking_reload_is_current (GstHLSDemux * demux,
+    GstHLSVariantStream * variant, const gchar * uri)
+{
+  gchar *current_uri;
+  gboolean ret;
+
+  if (variant != demux->current_variant)
+    return FALSE;
+
+  current_uri = gst_m3u8_get_blocking_reload_uri (variant->m3u8);
+  ret = g_strcmp0 (current_uri, uri) == 0;
+  g_free (current_uri);
+
+  return ret;
+}
+
+/* With @blocking, the server is asked to hold the request until the next
+ * partial segment (or segment) is available instead of polling for it. The
+ * manifest lock is released meanwhile when called from the manifest update
+ * task, so the variant may be switched or the playlist reloaded by someone
+ * else before the response arrives, in which case it is dropped */
+static GstFlowReturn
+gst_hls_demux_reload_playlist (GstHLSDemux * demux, gboolean update,
+    gboolean blocking, GError ** err)
 {
   GstAdaptiveDemux *adaptive_demux = GST_ADAPTIVE_DEMUX (demux);
+  GstHLSVariantStream *variant = NULL;
   GstFragment *download;
   GstBuffer *buf;
   gchar *playlist;
@@ -1557,21 +1878,50 @@ gst_hls_demux_update_playlist (GstHLSDemux * demux, gboolean update,
   const gchar *main_uri;
   GstM3U8 *m3u8;
   gchar *uri;
+  GstFlowReturn ret = GST_FLOW_OK;
   gint i;
 
 retry:
-  uri = gst_m3u8_get_uri (demux->current_variant->m3u8);
-  main_uri = gst_adaptive_demux_get_manifest_ref_uri (adaptive_demux);
-  download =
-      gst_uri_downloader_fetch_uri (adaptive_demux->downloader, uri, main_uri,
-      TRUE, TRUE, TRUE, err);
+  uri = NULL;
+  if (blocking)
+    uri = gst_m3u8_get_blocking_reload_uri (demux->current_variant->m3u8);
+  blocking = (uri != NULL);
+
+  if (blocking) {
+    variant = gst_hls_variant_stream_ref (demux->current_variant);
+    ret = gst_hls_demux_fetch_blocking_reload (demux, uri, &download, err);
+    if (ret == GST_FLOW_FLUSHING) {
+      g_free (uri);
+      gst_hls_variant_stream_unref (variant);
+      return ret;
+    }
+
+    if (download && !gst_hls_demux_blocking_reload_is_current (demux,
+            variant, uri)) {
+      GST_DEBUG_OBJECT (demux, "Playlist changed during the blocking reload");
+      g_object_unref (download);
+      g_free (uri);
+      gst_hls_variant_stream_unref (variant);
+      return GST_FLOW_OK;
+    }
+    gst_hls_variant_stream_unref (variant);
+    variant = NULL;
+  } else {
+    uri = gst_m3u8_get_uri (demux->current_variant->m3u8);
+    main_uri = gst_adaptive_demux_get_manifest_ref_uri (adaptive_demux);
+    download =
+        gst_uri_downloader_fetch_uri (adaptive_demux->downloader, uri,
+        main_uri, TRUE, TRUE, TRUE, err);
+  }
+
   if (download == NULL) {
     gchar *base_uri;
 
+    main_uri = gst_adaptive_demux_get_manifest_ref_uri (adaptive_demux);
     if (!update || main_checked || demux->master->is_simple
         || !gst_adaptive_demux_is_running (GST_ADAPTIVE_DEMUX_CAST (demux))) {
       g_free (uri);
-      return FALSE;
+      return GST_FLOW_ERROR;
     }
     g_clear_error (err);
     GST_INFO_OBJECT (demux,
@@ -1582,7 +1932,7 @@ retry:
         main_uri, NULL, TRUE, TRUE, TRUE, err);
     if (download == NULL) {
       g_free (uri);
-      return FALSE;
+      return GST_FLOW_ERROR;
     }
 
     buf = gst_fragment_get_buffer (download);
@@ -1596,7 +1946,7 @@ retry:
       g_object_unref (download);
       g_set_error (err, GST_STREAM_ERROR, GST_STREAM_ERROR_WRONG_TYPE,
           "Couldn't validate playlist encoding");
-      return FALSE;
+      return GST_FLOW_ERROR;
     }
 
     g_free (uri);
@@ -1613,7 +1963,7 @@ retry:
       g_object_unref (download);
       g_set_error (err, GST_STREAM_ERROR, GST_STREAM_ERROR_FAILED,
           "Couldn't update playlist");
-      return FALSE;
+      return GST_FLOW_ERROR;
     }
 
     g_object_unref (download);
@@ -1625,8 +1975,12 @@ retry:
 
   m3u8 = demux->current_variant->m3u8;
 
-  /* Set the base URI of the playlist to the redirect target if any */
-  if (download->redirect_permanent && download->redirect_uri) {
+  /* Set the base URI of the playlist to the redirect target if any. The
+   * URI of a blocking reload carries the delivery directives, so keep the
+   * plain playlist URI in that case */
+  if (blocking) {
+    /* nothing to do */
+  } else if (download->redirect_permanent && download->redirect_uri) {
     gst_m3u8_set_uri (m3u8, download->redirect_uri, NULL,
         demux->current_variant->name);
   } else {
@@ -1643,14 +1997,14 @@ retry:
     GST_WARNING_OBJECT (demux, "Couldn't validate playlist encoding");
     g_set_error (err, GST_STREAM_ERROR, GST_STREAM_ERROR_WRONG_TYPE,
         "Couldn't validate playlist encoding");
-    return FALSE;
+    return GST_FLOW_ERROR;
   }
 
   if (!gst_m3u8_update (m3u8, playlist)) {
     GST_WARNING_OBJECT (demux, "Couldn't update playlist");
     g_set_error (err, GST_STREAM_ERROR, GST_STREAM_ERROR_FAILED,
         "Couldn't update playlist");
-    return FALSE;
+    return GST_FLOW_ERROR;
   }
 
   for (i = 0; i < GST_HLS_N_MEDIA_TYPES; ++i) {
@@ -1669,23 +2023,48 @@ retry:
           "Updating playlist for media of type %d - %s, uri: %s", i,
           media->name, media->uri);
 
-      if (!gst_hls_demux_update_rendition_manifest (demux, media, err))
-        return FALSE;
+      if (blocking)
+        variant = gst_hls_variant_stream_ref (demux->current_variant);
+
+      ret = gst_hls_demux_update_rendition_manifest (demux, media, blocking,
+          err);
+
+      /* The manifest lock may have been released, the media list is only
+       * valid as long as the variant is the current one */
+      if (variant) {
+        gboolean switched = (variant != demux->current_variant);
+
+        gst_hls_variant_stream_unref (variant);
+        variant = NULL;
+        if (ret == GST_FLOW_OK && switched) {
+          GST_DEBUG_OBJECT (demux, "Variant switched during the reload");
+          return GST_FLOW_OK;
+        }
+      }
+
+      if (ret != GST_FLOW_OK)
+        return ret;
 
       mlist = mlist->next;
     }
   }
 
-  /* If it's a live source, do not let the sequence number go beyond
-   * three fragments before the end of the list */
-  if (update == FALSE && gst_m3u8_is_live (m3u8)) {
+  /* Start Low-Latency HLS playlists at the live edge partial segment,
+   * unless already playing partial segments */
+  if (update == FALSE && demux->low_latency && m3u8->current_part_idx < 0
+      && gst_m3u8_has_partial_segments (m3u8)) {
+    gst_hls_demux_seek_live_edge_part (demux);
+  } else if (update == FALSE && gst_m3u8_is_live (m3u8)) {
+    /* If it's a live source, do not let the sequence number go beyond
+     * three fragments before the end of the list */
     gint64 last_sequence, first_sequence;
 
     GST_M3U8_CLIENT_LOCK (demux->client);
     last_sequence =
-        GST_M3U8_MEDIA_FILE (g_list_last (m3u8->files)->data)->sequence;
+        GST_M3U8_MEDIA_FILE (g_ptr_array_index (m3u8->files,
+            m3u8->files->len - 1))->sequence;
     first_sequence =
-        GST_M3U8_MEDIA_FILE (g_list_first (m3u8->files)->data)->sequence;
+        GST_M3U8_MEDIA_FILE (g_ptr_array_index (m3u8->files, 0))->sequence;
 
     GST_DEBUG_OBJECT (demux,
         "sequence:%" G_GINT64_FORMAT " , first_sequence:%" G_GINT64_FORMAT
@@ -1695,15 +2074,18 @@ retry:
       //demux->need_segment = TRUE;
       /* Make sure we never go below the minimum sequence number */
       m3u8->sequence = MAX (first_sequence, last_sequence - 3);
+      m3u8->current_file_idx = -1;
+      if (m3u8->current_part_idx > 0)
+        m3u8->current_part_idx = 0;
       GST_DEBUG_OBJECT (demux,
           "Sequence is beyond playlist. Moving back to %" G_GINT64_FORMAT,
           m3u8->sequence);
     }
     GST_M3U8_CLIENT_UNLOCK (demux->client);
-  } else if (!gst_m3u8_is_live (m3u8)) {
+  } else if (!gst_m3u8_is_live (m3u8) && m3u8->current_part_idx < 0) {
     GstClockTime current_pos, target_pos;
     guint sequence = 0;
-    GList *walk;
+    gint idx;
 
     /* Sequence numbers are not guaranteed to be the same in different
      * playlists, so get the correct fragment here based on the current
@@ -1726,26 +2108,32 @@ retry:
     GST_LOG_OBJECT (demux, "Looking for sequence position %"
         GST_TIME_FORMAT " in updated playlist", GST_TIME_ARGS (target_pos));
 
-    current_pos = 0;
-    for (walk = m3u8->files; walk; walk = walk->next) {
-      GstM3U8MediaFile *file = walk->data;
-
-      sequence = file->sequence;
-      if (current_pos <= target_pos
-          && target_pos < current_pos + file->duration) {
-        break;
-      }
-      current_pos += file->duration;
+    idx = gst_m3u8_find_file_by_offset (m3u8, target_pos);
+    if (idx >= 0) {
+      sequence = GST_M3U8_MEDIA_FILE (g_ptr_array_index (m3u8->files,
+              idx))->sequence;
+      current_pos = g_array_index (m3u8->file_starts, GstClockTime, idx);
+    } else {
+      /* End of playlist */
+      sequence = GST_M3U8_MEDIA_FILE (g_ptr_array_index (m3u8->files,
+              m3u8->files->len - 1))->sequence + 1;
+      current_pos = m3u8->duration;
     }
-    /* End of playlist */
-    if (!walk)
-      sequence++;
     m3u8->sequence = sequence;
+    m3u8->current_file_idx = idx;
     m3u8->sequence_position = current_pos;
     GST_M3U8_CLIENT_UNLOCK (demux->client);
   }
 
-  return TRUE;
+  return GST_FLOW_OK;
+}
+
+static gboolean
+gst_hls_demux_update_playlist (GstHLSDemux * demux, gboolean update,
+    GError ** err)
+{
+  return gst_hls_demux_reload_playlist (demux, update, FALSE,
+      err) == GST_FLOW_OK;
 }
 
 static gboolean
@@ -2048,8 +2436,18 @@ gst_hls_demux_get_manifest_update_interval (GstAdaptiveDemux * demux)
   GstClockTime target_duration;
 
   if (hlsdemux->current_variant) {
-    target_duration =
-        gst_m3u8_get_target_duration (hlsdemux->current_variant->m3u8);
+    GstM3U8 *m3u8 = hlsdemux->current_variant->m3u8;
+
+    target_duration = gst_m3u8_get_target_duration (m3u8);
+
+    /* New partial segments show up every PART-TARGET. Blocking reloads
+     * wait on the server side, so poll more often than that */
+    if (hlsdemux->low_latency && m3u8->current_part_idx >= 0
+        && gst_m3u8_has_partial_segments (m3u8)) {
+      target_duration = m3u8->part_target;
+      if (m3u8->can_block_reload)
+        target_duration /= 2;
+    }
   } else {
     target_duration = 5 * GST_SECOND;
   }
@@ -150,6 +150,9 @@ struct _GstHLSDemux
   GstHLSVariantStream  *previous_variant;
 
   gboolean streams_aware;
+
+  /* Play Low-Latency HLS partial segments */
+  gboolean low_latency;
 };
 
 struct _GstHLSDemuxClass
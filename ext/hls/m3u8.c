@@ -34,6 +34,7 @@
 static GstM3U8MediaFile *gst_m3u8_media_file_new (gchar * uri,
     gchar * title, GstClockTime duration, guint sequence);
 static void gst_m3u8_init_file_unref (GstM3U8InitFile * self);
+static void gst_m3u8_parse_state_free (GstM3U8ParseState * state);
 static gchar *uri_join (const gchar * uri, const gchar * path);
 
 GstM3U8 *
@@ -43,12 +44,18 @@ gst_m3u8_new (void)
 
   m3u8 = g_new0 (GstM3U8, 1);
 
-  m3u8->current_file = NULL;
+  m3u8->files = g_ptr_array_new_with_free_func ((GDestroyNotify)
+      gst_m3u8_media_file_unref);
+  m3u8->file_starts = g_array_new (FALSE, FALSE, sizeof (GstClockTime));
+  m3u8->current_file_idx = -1;
   m3u8->current_file_duration = GST_CLOCK_TIME_NONE;
   m3u8->sequence = -1;
   m3u8->sequence_position = 0;
   m3u8->highest_sequence_number = -1;
   m3u8->duration = GST_CLOCK_TIME_NONE;
+  m3u8->part_target = GST_CLOCK_TIME_NONE;
+  m3u8->part_hold_back = GST_CLOCK_TIME_NONE;
+  m3u8->current_part_idx = -1;
 
   g_mutex_init (&m3u8->lock);
   m3u8->ref_count = 1;
@@ -105,8 +112,14 @@ gst_m3u8_unref (GstM3U8 * self)
     g_free (self->base_uri);
     g_free (self->name);
 
-    g_list_foreach (self->files, (GFunc) gst_m3u8_media_file_unref, NULL);
-    g_list_free (self->files);
+    g_ptr_array_unref (self->files);
+    g_array_unref (self->file_starts);
+    if (self->partial_segments)
+      g_ptr_array_unref (self->partial_segments);
+    if (self->preload_hint)
+      gst_m3u8_media_file_unref (self->preload_hint);
+    if (self->parse_state)
+      gst_m3u8_parse_state_free (self->parse_state);
 
     g_free (self->last_data);
     g_mutex_clear (&self->lock);
@@ -125,6 +138,7 @@ gst_m3u8_media_file_new (gchar * uri, gchar * title, GstClockTime duration,
   file->title = title;
   file->duration = duration;
   file->sequence = sequence;
+  file->part_index = -1;
   file->ref_count = 1;
 
   return file;
@@ -147,6 +161,8 @@ gst_m3u8_media_file_unref (GstM3U8MediaFile * self)
   if (g_atomic_int_dec_and_test (&self->ref_count)) {
     if (self->init_file)
       gst_m3u8_init_file_unref (self->init_file);
+    if (self->partial_segments)
+      g_ptr_array_unref (self->partial_segments);
     g_free (self->title);
     g_free (self->uri);
     g_free (self->key);
@@ -345,51 +361,50 @@ gst_hls_variant_stream_compare_by_bitrate (gconstpointer a, gconstpointer b)
 /* If we have MEDIA-SEQUENCE, ensure that it's consistent. If it is not,
  * the client SHOULD halt playback (6.3.4), which is what we do then. */
 static gboolean
-check_media_seqnums (GstM3U8 * self, GList * previous_files)
+check_media_seqnums (GstM3U8 * self, GPtrArray * previous_files)
 {
-  GList *l, *m;
   GstM3U8MediaFile *f1 = NULL, *f2 = NULL;
+  guint l, m, lo, hi;
 
   g_return_val_if_fail (previous_files, FALSE);
 
-  if (!self->files) {
+  if (self->files->len == 0) {
     /* Empty playlists are trivially consistent */
     return TRUE;
   }
 
+  if (previous_files->len == 0)
+    return TRUE;
+
   /* Find first case of higher/equal sequence number in new playlist.
    * From there on we can linearly step ahead */
-  for (l = self->files; l; l = l->next) {
-    gboolean match = FALSE;
-
-    f1 = l->data;
-    for (m = previous_files; m; m = m->next) {
-      f2 = m->data;
-
-      if (f1->sequence >= f2->sequence) {
-        match = TRUE;
-        break;
-      }
-    }
-    if (match)
-      break;
+  f2 = g_ptr_array_index (previous_files, 0);
+  lo = 0;
+  hi = self->files->len;
+  while (lo < hi) {
+    guint mid = lo + (hi - lo) / 2;
+
+    f1 = g_ptr_array_index (self->files, mid);
+    if (f1->sequence < f2->sequence)
+      lo = mid + 1;
+    else
+      hi = mid;
   }
 
-  /* We must have seen at least one entry on each list */
-  g_assert (f1 != NULL);
-  g_assert (f2 != NULL);
-
-  if (!l) {
+  if (lo == self->files->len) {
     /* No match, no sequence in the new playlist was higher than
      * any in the old. This is bad! */
+    f1 = g_ptr_array_index (self->files, self->files->len - 1);
+    f2 = g_ptr_array_index (previous_files, previous_files->len - 1);
     GST_ERROR ("Media sequence doesn't continue: last new %" G_GINT64_FORMAT
         " < last old %" G_GINT64_FORMAT, f1->sequence, f2->sequence);
     return FALSE;
   }
 
-  for (; l && m; l = l->next, m = m->next) {
-    f1 = l->data;
-    f2 = m->data;
+  for (l = lo, m = 0; l < self->files->len && m < previous_files->len;
+      l++, m++) {
+    f1 = g_ptr_array_index (self->files, l);
+    f2 = g_ptr_array_index (previous_files, m);
 
     if (f1->sequence == f2->sequence && !g_str_equal (f1->uri, f2->uri)) {
       /* Same sequence, different URI. This is bad! */
@@ -416,42 +431,51 @@ check_media_seqnums (GstM3U8 * self, GList * previous_files)
  * playlist in relation to the old. That is, same URIs get the same number
  * and later URIs get higher numbers */
 static void
-generate_media_seqnums (GstM3U8 * self, GList * previous_files)
+generate_media_seqnums (GstM3U8 * self, GPtrArray * previous_files)
 {
-  GList *l, *m;
   GstM3U8MediaFile *f1 = NULL, *f2 = NULL;
+  GHashTable *previous_uris;
   gint64 mediasequence;
+  guint l, m = 0, i;
+  gboolean match = FALSE;
 
   g_return_if_fail (previous_files);
 
-  /* Find first case of same URI in new playlist.
-   * From there on we can linearly step ahead */
-  for (l = self->files; l; l = l->next) {
-    gboolean match = FALSE;
+  if (previous_files->len == 0)
+    return;
 
-    f1 = l->data;
-    for (m = previous_files; m; m = m->next) {
-      f2 = m->data;
+  /* Index of the first occurrence of each URI in the previous playlist */
+  previous_uris = g_hash_table_new (g_str_hash, g_str_equal);
+  for (i = 0; i < previous_files->len; i++) {
+    f2 = g_ptr_array_index (previous_files, i);
+    if (!g_hash_table_contains (previous_uris, f2->uri))
+      g_hash_table_insert (previous_uris, f2->uri, GUINT_TO_POINTER (i));
+  }
 
-      if (g_str_equal (f1->uri, f2->uri)) {
-        match = TRUE;
-        break;
-      }
-    }
+  /* Find first case of same URI in new playlist.
+   * From there on we can linearly step ahead */
+  for (l = 0; l < self->files->len; l++) {
+    gpointer index;
 
-    if (match)
+    f1 = g_ptr_array_index (self->files, l);
+    if (g_hash_table_lookup_extended (previous_uris, f1->uri, NULL, &index)) {
+      m = GPOINTER_TO_UINT (index);
+      match = TRUE;
       break;
+    }
   }
+  g_hash_table_destroy (previous_uris);
 
-  if (l) {
+  if (match) {
     /* Match, check that all following ones are matching too and continue
      * sequence numbers from there on */
 
-    mediasequence = f2->sequence;
+    mediasequence = GST_M3U8_MEDIA_FILE (g_ptr_array_index (previous_files,
+            m))->sequence;
 
-    for (; l && m; l = l->next, m = m->next) {
-      f1 = l->data;
-      f2 = m->data;
+    for (; l < self->files->len && m < previous_files->len; l++, m++) {
+      f1 = g_ptr_array_index (self->files, l);
+      f2 = g_ptr_array_index (previous_files, m);
 
       f1->sequence = mediasequence;
       mediasequence++;
@@ -462,82 +486,201 @@ generate_media_seqnums (GstM3U8 * self, GList * previous_files)
       }
     }
   } else {
-    /* No match, this means f2 is the last item in the previous playlist
-     * and we have to start our new playlist at that sequence */
+    /* No match, this means we have to start our new playlist after the
+     * last item in the previous playlist */
+    f2 = g_ptr_array_index (previous_files, previous_files->len - 1);
     mediasequence = f2->sequence + 1;
-    l = self->files;
+    l = 0;
   }
 
-  for (; l; l = l->next) {
-    f1 = l->data;
+  for (; l < self->files->len; l++) {
+    f1 = g_ptr_array_index (self->files, l);
 
     f1->sequence = mediasequence;
     mediasequence++;
   }
 }
 
-/*
- * @data: a m3u8 playlist text data, taking ownership
- */
-gboolean
-gst_m3u8_update (GstM3U8 * self, gchar * data)
+/* Parser state carried over from one line to the next */
+struct _GstM3U8ParseState
 {
-  gint val;
   GstClockTime duration;
-  gchar *title, *end;
-  gboolean discontinuity = FALSE;
-  gchar *current_key = NULL;
-  gboolean have_iv = FALSE;
-  guint8 iv[16] = { 0, };
-  gint64 size = -1, offset = -1;
+  gchar *title;
+  gboolean discontinuity;
+  gchar *current_key;
+  gboolean have_iv;
+  guint8 iv[16];
+  gint64 size, offset;
   gint64 mediasequence;
-  GList *previous_files = NULL;
-  gboolean have_mediasequence = FALSE;
-  GstM3U8InitFile *last_init_file = NULL;
+  gboolean have_mediasequence;
+  GstM3U8InitFile *last_init_file;
+  GPtrArray *parts;             /* partial segments of the next segment */
+};
 
-  g_return_val_if_fail (self != NULL, FALSE);
-  g_return_val_if_fail (data != NULL, FALSE);
+static GstM3U8ParseState *
+gst_m3u8_parse_state_new (void)
+{
+  GstM3U8ParseState *state = g_new0 (GstM3U8ParseState, 1);
 
-  GST_M3U8_LOCK (self);
+  state->size = -1;
+  state->offset = -1;
 
-  /* check if the data changed since last update */
-  if (self->last_data && g_str_equal (self->last_data, data)) {
-    GST_DEBUG ("Playlist is the same as previous one");
-    g_free (data);
-    GST_M3U8_UNLOCK (self);
-    return TRUE;
+  return state;
+}
+
+static void
+gst_m3u8_parse_state_free (GstM3U8ParseState * state)
+{
+  g_free (state->title);
+  g_free (state->current_key);
+  if (state->last_init_file)
+    gst_m3u8_init_file_unref (state->last_init_file);
+  if (state->parts)
+    g_ptr_array_unref (state->parts);
+  g_free (state);
+}
+
+/* Partial segment or preload hint inheriting the encryption and
+ * initialization parameters of the segment it belongs to */
+static GstM3U8MediaFile *
+gst_m3u8_partial_segment_new (GstM3U8 * self, gchar * uri,
+    GstClockTime duration, GstM3U8ParseState * state)
+{
+  GstM3U8MediaFile *part;
+
+  part = gst_m3u8_media_file_new (uri, NULL, duration, state->mediasequence);
+  part->part_index = state->parts ? state->parts->len : 0;
+  part->discont = part->part_index == 0 && state->discontinuity;
+
+  part->key = g_strdup (state->current_key);
+  if (part->key) {
+    if (state->have_iv) {
+      memcpy (part->iv, state->iv, sizeof (state->iv));
+    } else {
+      guint8 *iv = part->iv + 12;
+      GST_WRITE_UINT32_BE (iv, part->sequence);
+    }
   }
+  if (state->last_init_file)
+    part->init_file = gst_m3u8_init_file_ref (state->last_init_file);
 
-  if (!g_str_has_prefix (data, "#EXTM3U")) {
-    GST_WARNING ("Data doesn't start with #EXTM3U");
-    g_free (data);
-    GST_M3U8_UNLOCK (self);
-    return FALSE;
+  return part;
+}
+
+/* #EXT-X-PART:<attribute-list> */
+static void
+gst_m3u8_parse_partial_segment (GstM3U8 * self, gchar * data,
+    GstM3U8ParseState * state)
+{
+  GstM3U8MediaFile *part;
+  gchar *v, *a, *uri = NULL;
+  gdouble duration = -1;
+  gint64 size = -1, offset = -1;
+  gboolean independent = FALSE;
+
+  while (data && parse_attributes (&data, &a, &v)) {
+    if (g_str_equal (a, "URI")) {
+      g_free (uri);
+      uri = uri_join (self->base_uri ? self->base_uri : self->uri, v);
+    } else if (g_str_equal (a, "DURATION")) {
+      if (!double_from_string (v, NULL, &duration))
+        duration = -1;
+    } else if (g_str_equal (a, "INDEPENDENT")) {
+      independent = g_ascii_strcasecmp (v, "YES") == 0;
+    } else if (g_str_equal (a, "BYTERANGE")) {
+      if (int64_from_string (v, &v, &size)) {
+        if (*v == '@' && !int64_from_string (v + 1, &v, &offset))
+          size = -1;
+      }
+    } else if (g_str_equal (a, "GAP")) {
+      GST_FIXME ("EXT-X-PART: GAP not supported");
+    }
   }
 
-  if (g_strrstr (data, "\n#EXT-X-STREAM-INF:") != NULL) {
-    GST_WARNING ("Not a media playlist, but a master playlist!");
-    GST_M3U8_UNLOCK (self);
-    return FALSE;
+  if (uri == NULL || duration < 0) {
+    GST_WARNING ("EXT-X-PART without URI or DURATION, dropping");
+    g_free (uri);
+    return;
   }
 
-  GST_TRACE ("data:\n%s", data);
+  part = gst_m3u8_partial_segment_new (self, uri,
+      duration * (gdouble) GST_SECOND, state);
+  part->independent = independent;
+
+  if (size != -1) {
+    part->size = size;
+    if (offset != -1) {
+      part->offset = offset;
+    } else if (state->parts && state->parts->len > 0) {
+      GstM3U8MediaFile *prev =
+          g_ptr_array_index (state->parts, state->parts->len - 1);
+
+      /* Continues the previous range of the same resource */
+      if (g_str_equal (prev->uri, part->uri) && prev->size != -1)
+        part->offset = prev->offset + prev->size;
+    }
+  } else {
+    part->size = -1;
+  }
 
-  g_free (self->last_data);
-  self->last_data = data;
+  if (state->parts == NULL)
+    state->parts = g_ptr_array_new_with_free_func ((GDestroyNotify)
+        gst_m3u8_media_file_unref);
+  g_ptr_array_add (state->parts, part);
+}
 
-  self->current_file = NULL;
-  previous_files = self->files;
-  self->files = NULL;
-  self->duration = GST_CLOCK_TIME_NONE;
-  mediasequence = 0;
+/* #EXT-X-PRELOAD-HINT:<attribute-list> */
+static void
+gst_m3u8_parse_preload_hint (GstM3U8 * self, gchar * data,
+    GstM3U8ParseState * state)
+{
+  GstM3U8MediaFile *hint;
+  gchar *v, *a, *uri = NULL;
+  gint64 offset = 0, size = -1;
+  gboolean is_part = FALSE;
+
+  while (data && parse_attributes (&data, &a, &v)) {
+    if (g_str_equal (a, "TYPE")) {
+      is_part = g_str_equal (v, "PART");
+    } else if (g_str_equal (a, "URI")) {
+      g_free (uri);
+      uri = uri_join (self->base_uri ? self->base_uri : self->uri, v);
+    } else if (g_str_equal (a, "BYTERANGE-START")) {
+      if (!int64_from_string (v, NULL, &offset))
+        offset = 0;
+    } else if (g_str_equal (a, "BYTERANGE-LENGTH")) {
+      if (!int64_from_string (v, NULL, &size))
+        size = -1;
+    }
+  }
 
-  /* By default, allow caching */
-  self->allowcache = TRUE;
+  /* Hints for initialization sections are not used */
+  if (!is_part || uri == NULL) {
+    g_free (uri);
+    return;
+  }
+
+  hint = gst_m3u8_partial_segment_new (self, uri,
+      GST_CLOCK_TIME_IS_VALID (self->part_target) ? self->part_target : 0,
+      state);
+  hint->offset = offset;
+  hint->size = size;
+
+  if (self->preload_hint)
+    gst_m3u8_media_file_unref (self->preload_hint);
+  self->preload_hint = hint;
+}
+
+/* Parses the lines of @data, which is modified, and appends the media files
+ * to self->files. @state is updated so that parsing can be resumed with
+ * lines appended later on.
+ * call with M3U8_LOCK held */
+static void
+gst_m3u8_parse_lines (GstM3U8 * self, gchar * data, GstM3U8ParseState * state)
+{
+  gint val;
+  gchar *end;
 
-  duration = 0;
-  title = NULL;
-  data += 7;
   while (TRUE) {
     gchar *r;
 
@@ -550,7 +693,7 @@ gst_m3u8_update (GstM3U8 * self, gchar * data)
       *r = '\0';
 
     if (data[0] != '#' && data[0] != '\0') {
-      if (duration <= 0) {
+      if (state->duration <= 0) {
         GST_LOG ("%s: got line without EXTINF, dropping", data);
         goto next_line;
       }
@@ -558,47 +701,52 @@ gst_m3u8_update (GstM3U8 * self, gchar * data)
       data = uri_join (self->base_uri ? self->base_uri : self->uri, data);
       if (data != NULL) {
         GstM3U8MediaFile *file;
-        file = gst_m3u8_media_file_new (data, title, duration, mediasequence++);
+        file = gst_m3u8_media_file_new (data, state->title, state->duration,
+            state->mediasequence++);
 
         /* set encryption params */
-        file->key = current_key ? g_strdup (current_key) : NULL;
+        file->key = state->current_key ? g_strdup (state->current_key) : NULL;
         if (file->key) {
-          if (have_iv) {
-            memcpy (file->iv, iv, sizeof (iv));
+          if (state->have_iv) {
+            memcpy (file->iv, state->iv, sizeof (state->iv));
           } else {
             guint8 *iv = file->iv + 12;
             GST_WRITE_UINT32_BE (iv, file->sequence);
           }
         }
 
-        if (size != -1) {
-          file->size = size;
-          if (offset != -1) {
-            file->offset = offset;
+        if (state->size != -1) {
+          file->size = state->size;
+          if (state->offset != -1) {
+            file->offset = state->offset;
           } else {
-            GstM3U8MediaFile *prev = self->files ? self->files->data : NULL;
+            GstM3U8MediaFile *prev = self->files->len > 0 ?
+                g_ptr_array_index (self->files, self->files->len - 1) : NULL;
 
             if (!prev) {
-              offset = 0;
+              state->offset = 0;
             } else {
-              offset = prev->offset + prev->size;
+              state->offset = prev->offset + prev->size;
             }
-            file->offset = offset;
+            file->offset = state->offset;
           }
         } else {
           file->size = -1;
           file->offset = 0;
         }
 
-        file->discont = discontinuity;
-        if (last_init_file)
-          file->init_file = gst_m3u8_init_file_ref (last_init_file);
+        file->discont = state->discontinuity;
+        if (state->last_init_file)
+          file->init_file = gst_m3u8_init_file_ref (state->last_init_file);
+
+        file->partial_segments = state->parts;
+        state->parts = NULL;
 
-        duration = 0;
-        title = NULL;
-        discontinuity = FALSE;
-        size = offset = -1;
-        self->files = g_list_prepend (self->files, file);
+        state->duration = 0;
+        state->title = NULL;
+        state->discontinuity = FALSE;
+        state->size = state->offset = -1;
+        g_ptr_array_add (self->files, file);
       }
 
     } else if (g_str_has_prefix (data, "#EXTINF:")) {
@@ -607,18 +755,19 @@ gst_m3u8_update (GstM3U8 * self, gchar * data)
         GST_WARNING ("Can't read EXTINF duration");
         goto next_line;
       }
-      duration = fval * (gdouble) GST_SECOND;
-      if (self->targetduration > 0 && duration > self->targetduration) {
+      state->duration = fval * (gdouble) GST_SECOND;
+      if (self->targetduration > 0 && state->duration > self->targetduration) {
         GST_WARNING ("EXTINF duration (%" GST_TIME_FORMAT
             ") > TARGETDURATION (%" GST_TIME_FORMAT ")",
-            GST_TIME_ARGS (duration), GST_TIME_ARGS (self->targetduration));
+            GST_TIME_ARGS (state->duration),
+            GST_TIME_ARGS (self->targetduration));
       }
       if (!data || *data != ',')
         goto next_line;
       data = g_utf8_next_char (data);
       if (data != end) {
-        g_free (title);
-        title = g_strdup (data);
+        g_free (state->title);
+        state->title = g_strdup (data);
       }
     } else if (g_str_has_prefix (data, "#EXT-X-")) {
       gchar *data_ext_x = data + 7;
@@ -634,18 +783,47 @@ gst_m3u8_update (GstM3U8 * self, gchar * data)
           self->targetduration = val * GST_SECOND;
       } else if (g_str_has_prefix (data_ext_x, "MEDIA-SEQUENCE:")) {
         if (int_from_string (data + 22, &data, &val)) {
-          mediasequence = val;
-          have_mediasequence = TRUE;
+          state->mediasequence = val;
+          state->have_mediasequence = TRUE;
         }
       } else if (g_str_has_prefix (data_ext_x, "DISCONTINUITY-SEQUENCE:")) {
         if (int_from_string (data + 30, &data, &val)
             && val != self->discont_sequence) {
           self->discont_sequence = val;
-          discontinuity = TRUE;
+          state->discontinuity = TRUE;
         }
       } else if (g_str_has_prefix (data_ext_x, "DISCONTINUITY")) {
         self->discont_sequence++;
-        discontinuity = TRUE;
+        state->discontinuity = TRUE;
+      } else if (g_str_has_prefix (data_ext_x, "SERVER-CONTROL:")) {
+        gchar *v, *a;
+
+        data = data + 22;
+        while (data && parse_attributes (&data, &a, &v)) {
+          gdouble fval;
+
+          if (g_str_equal (a, "CAN-BLOCK-RELOAD")) {
+            self->can_block_reload = g_ascii_strcasecmp (v, "YES") == 0;
+          } else if (g_str_equal (a, "PART-HOLD-BACK")) {
+            if (double_from_string (v, NULL, &fval))
+              self->part_hold_back = fval * (gdouble) GST_SECOND;
+          }
+        }
+      } else if (g_str_has_prefix (data_ext_x, "PART-INF:")) {
+        gchar *v, *a;
+
+        data = data + 16;
+        while (data && parse_attributes (&data, &a, &v)) {
+          gdouble fval;
+
+          if (g_str_equal (a, "PART-TARGET")
+              && double_from_string (v, NULL, &fval))
+            self->part_target = fval * (gdouble) GST_SECOND;
+        }
+      } else if (g_str_has_prefix (data_ext_x, "PART:")) {
+        gst_m3u8_parse_partial_segment (self, data + 12, state);
+      } else if (g_str_has_prefix (data_ext_x, "PRELOAD-HINT:")) {
+        gst_m3u8_parse_preload_hint (self, data + 20, state);
       } else if (g_str_has_prefix (data_ext_x, "PROGRAM-DATE-TIME:")) {
         /* <YYYY-MM-DDThh:mm:ssZ> */
         GST_DEBUG ("FIXME parse date");
@@ -657,12 +835,12 @@ gst_m3u8_update (GstM3U8 * self, gchar * data)
         data = data + 11;
 
         /* IV and KEY are only valid until the next #EXT-X-KEY */
-        have_iv = FALSE;
-        g_free (current_key);
-        current_key = NULL;
+        state->have_iv = FALSE;
+        g_free (state->current_key);
+        state->current_key = NULL;
         while (data && parse_attributes (&data, &a, &v)) {
           if (g_str_equal (a, "URI")) {
-            current_key =
+            state->current_key =
                 uri_join (self->base_uri ? self->base_uri : self->uri, v);
           } else if (g_str_equal (a, "IV")) {
             gchar *ivp = v;
@@ -686,14 +864,14 @@ gst_m3u8_update (GstM3U8 * self, gchar * data)
                 i = -1;
                 break;
               }
-              iv[i] = (h << 4) | l;
+              state->iv[i] = (h << 4) | l;
             }
 
             if (i == -1) {
               GST_WARNING ("Can't read IV");
               continue;
             }
-            have_iv = TRUE;
+            state->have_iv = TRUE;
           } else if (g_str_equal (a, "METHOD")) {
             if (!g_str_equal (v, "AES-128")) {
               GST_WARNING ("Encryption method %s not supported", v);
@@ -704,8 +882,8 @@ gst_m3u8_update (GstM3U8 * self, gchar * data)
       } else if (g_str_has_prefix (data_ext_x, "BYTERANGE:")) {
         gchar *v = data + 17;
 
-        if (int64_from_string (v, &v, &size)) {
-          if (*v == '@' && !int64_from_string (v + 1, &v, &offset))
+        if (int64_from_string (v, &v, &state->size)) {
+          if (*v == '@' && !int64_from_string (v + 1, &v, &state->offset))
             goto next_line;
         } else {
           goto next_line;
@@ -720,8 +898,9 @@ gst_m3u8_update (GstM3U8 * self, gchar * data)
             header_uri =
                 uri_join (self->base_uri ? self->base_uri : self->uri, v);
           } else if (strcmp (a, "BYTERANGE") == 0) {
-            if (int64_from_string (v, &v, &size)) {
-              if (*v == '@' && !int64_from_string (v + 1, &v, &offset)) {
+            if (int64_from_string (v, &v, &state->size)) {
+              if (*v == '@'
+                  && !int64_from_string (v + 1, &v, &state->offset)) {
                 g_free (header_uri);
                 goto next_line;
               }
@@ -736,20 +915,20 @@ gst_m3u8_update (GstM3U8 * self, gchar * data)
           GstM3U8InitFile *init_file;
           init_file = gst_m3u8_init_file_new (header_uri);
 
-          if (size != -1) {
-            init_file->size = size;
-            if (offset != -1)
-              init_file->offset = offset;
+          if (state->size != -1) {
+            init_file->size = state->size;
+            if (state->offset != -1)
+              init_file->offset = state->offset;
             else
               init_file->offset = 0;
           } else {
             init_file->size = -1;
             init_file->offset = 0;
           }
-          if (last_init_file)
-            gst_m3u8_init_file_unref (last_init_file);
+          if (state->last_init_file)
+            gst_m3u8_init_file_unref (state->last_init_file);
 
-          last_init_file = init_file;
+          state->last_init_file = init_file;
         }
       } else {
         GST_LOG ("Ignored line: %s", data);
@@ -763,158 +942,494 @@ gst_m3u8_update (GstM3U8 * self, gchar * data)
       break;
     data = g_utf8_next_char (end);      /* skip \n */
   }
+}
 
-  g_free (current_key);
-  current_key = NULL;
-
-  self->files = g_list_reverse (self->files);
-
-  if (last_init_file)
-    gst_m3u8_init_file_unref (last_init_file);
+/* Fills the timestamp index and updates the start and end times of the
+ * playlist for the files from @first on.
+ * call with M3U8_LOCK held */
+static gboolean
+gst_m3u8_index_files (GstM3U8 * self, guint first)
+{
+  GstM3U8MediaFile *file;
+  GstClockTime duration = 0;
+  gint64 mediasequence = -1;
+  guint i;
+
+  g_array_set_size (self->file_starts, first);
+  if (first > 0) {
+    file = g_ptr_array_index (self->files, first - 1);
+    duration = g_array_index (self->file_starts, GstClockTime, first - 1) +
+        file->duration;
+    mediasequence = file->sequence;
+  }
 
-  if (previous_files) {
-    gboolean consistent = TRUE;
+  for (i = first; i < self->files->len; i++) {
+    file = g_ptr_array_index (self->files, i);
 
-    if (have_mediasequence) {
-      consistent = check_media_seqnums (self, previous_files);
+    if (mediasequence == -1) {
+      mediasequence = file->sequence;
+    } else if (mediasequence >= file->sequence) {
+      GST_ERROR ("Non-increasing media sequence");
+      return FALSE;
     } else {
-      generate_media_seqnums (self, previous_files);
+      mediasequence = file->sequence;
     }
 
-    g_list_foreach (previous_files, (GFunc) gst_m3u8_media_file_unref, NULL);
-    g_list_free (previous_files);
-    previous_files = NULL;
-
-    /* error was reported above already */
-    if (!consistent) {
-      GST_M3U8_UNLOCK (self);
-      return FALSE;
+    g_array_append_val (self->file_starts, duration);
+    duration += file->duration;
+    if (file->sequence > self->highest_sequence_number) {
+      if (self->highest_sequence_number >= 0) {
+        /* if an update of the media playlist has been missed, there
+           will be a gap between self->highest_sequence_number and the
+           first sequence number in this media playlist. In this situation
+           assume that the missing fragments had a duration of
+           targetduration each */
+        self->last_file_end +=
+            (file->sequence - self->highest_sequence_number -
+            1) * self->targetduration;
+      }
+      self->last_file_end += file->duration;
+      self->highest_sequence_number = file->sequence;
     }
   }
+  if (GST_M3U8_IS_LIVE (self)) {
+    self->first_file_start = self->last_file_end - duration;
+    GST_DEBUG ("Live playlist range %" GST_TIME_FORMAT " -> %"
+        GST_TIME_FORMAT, GST_TIME_ARGS (self->first_file_start),
+        GST_TIME_ARGS (self->last_file_end));
+  }
+  self->duration = duration;
 
-  if (self->files == NULL) {
-    GST_ERROR ("Invalid media playlist, it does not contain any media files");
+  return TRUE;
+}
+
+/* Takes the partial segments following the last segment and makes the
+ * sequence numbers of all partial segments match the ones of their
+ * segments, which might have been regenerated.
+ * call with M3U8_LOCK held */
+static void
+gst_m3u8_update_partial_segments (GstM3U8 * self, GstM3U8ParseState * state)
+{
+  guint i, j;
+
+  if (self->partial_segments)
+    g_ptr_array_unref (self->partial_segments);
+  self->partial_segments = state->parts;
+  state->parts = NULL;
+
+  if (self->partial_segments) {
+    for (j = 0; j < self->partial_segments->len; j++)
+      GST_M3U8_MEDIA_FILE (g_ptr_array_index (self->partial_segments,
+              j))->sequence = state->mediasequence;
+  }
+  if (self->preload_hint)
+    self->preload_hint->sequence = state->mediasequence;
+
+  if (state->have_mediasequence)
+    return;
+
+  for (i = 0; i < self->files->len; i++) {
+    GstM3U8MediaFile *file = g_ptr_array_index (self->files, i);
+
+    if (file->partial_segments == NULL)
+      continue;
+    for (j = 0; j < file->partial_segments->len; j++)
+      GST_M3U8_MEDIA_FILE (g_ptr_array_index (file->partial_segments,
+              j))->sequence = file->sequence;
+  }
+}
+
+/* Whether @data is the previous playlist with lines appended to it, in
+ * which case only the new lines need to be parsed.
+ * call with M3U8_LOCK held */
+static gboolean
+gst_m3u8_is_appended (GstM3U8 * self, const gchar * data, gsize len)
+{
+  if (self->last_data == NULL || self->parse_state == NULL
+      || self->files->len == 0 || self->endlist)
+    return FALSE;
+
+  /* Partial segments and preload hints are removed from the end of
+   * low-latency playlists */
+  if (GST_CLOCK_TIME_IS_VALID (self->part_target))
+    return FALSE;
+
+  /* The previous playlist must end with a complete line */
+  if (len <= self->last_data_len
+      || self->last_data[self->last_data_len - 1] != '\n')
+    return FALSE;
+
+  return memcmp (data, self->last_data, self->last_data_len) == 0;
+}
+
+/*
+ * @data: a m3u8 playlist text data, taking ownership
+ */
+gboolean
+gst_m3u8_update (GstM3U8 * self, gchar * data)
+{
+  GstM3U8ParseState *state;
+  GPtrArray *previous_files = NULL;
+  gchar *lines;
+  gsize len;
+  guint first_new = 0;
+  gboolean appended;
+
+  g_return_val_if_fail (self != NULL, FALSE);
+  g_return_val_if_fail (data != NULL, FALSE);
+
+  GST_M3U8_LOCK (self);
+
+  len = strlen (data);
+
+  /* check if the data changed since last update */
+  if (self->last_data && len == self->last_data_len
+      && memcmp (self->last_data, data, len) == 0) {
+    GST_DEBUG ("Playlist is the same as previous one");
+    g_free (data);
+    GST_M3U8_UNLOCK (self);
+    return TRUE;
+  }
+
+  if (!g_str_has_prefix (data, "#EXTM3U")) {
+    GST_WARNING ("Data doesn't start with #EXTM3U");
+    g_free (data);
     GST_M3U8_UNLOCK (self);
     return FALSE;
   }
 
-  /* calculate the start and end times of this media playlist. */
-  {
-    GList *walk;
-    GstM3U8MediaFile *file;
-    GstClockTime duration = 0;
+  if (g_strrstr (data, "\n#EXT-X-STREAM-INF:") != NULL) {
+    GST_WARNING ("Not a media playlist, but a master playlist!");
+    GST_M3U8_UNLOCK (self);
+    return FALSE;
+  }
 
-    mediasequence = -1;
+  GST_TRACE ("data:\n%s", data);
 
-    for (walk = self->files; walk; walk = walk->next) {
-      file = walk->data;
+  appended = gst_m3u8_is_appended (self, data, len);
 
-      if (mediasequence == -1) {
-        mediasequence = file->sequence;
-      } else if (mediasequence >= file->sequence) {
-        GST_ERROR ("Non-increasing media sequence");
-        GST_M3U8_UNLOCK (self);
-        return FALSE;
-      } else {
-        mediasequence = file->sequence;
-      }
+  /* Keep the data unmodified to compare it with the next update, the
+   * parser works on a copy */
+  if (appended) {
+    lines = g_strdup (data + self->last_data_len);
+  } else {
+    lines = g_strdup (data + 7);
+  }
 
-      duration += file->duration;
-      if (file->sequence > self->highest_sequence_number) {
-        if (self->highest_sequence_number >= 0) {
-          /* if an update of the media playlist has been missed, there
-             will be a gap between self->highest_sequence_number and the
-             first sequence number in this media playlist. In this situation
-             assume that the missing fragments had a duration of
-             targetduration each */
-          self->last_file_end +=
-              (file->sequence - self->highest_sequence_number -
-              1) * self->targetduration;
-        }
-        self->last_file_end += file->duration;
-        self->highest_sequence_number = file->sequence;
-      }
+  g_free (self->last_data);
+  self->last_data = data;
+  self->last_data_len = len;
+
+  if (appended) {
+    /* The files and the position in them stay valid */
+    first_new = self->files->len;
+    GST_DEBUG ("Playlist was appended to, parsing %" G_GSIZE_FORMAT
+        " new bytes", strlen (lines));
+  } else {
+    self->current_file_idx = -1;
+    previous_files = self->files;
+    self->files = g_ptr_array_new_with_free_func ((GDestroyNotify)
+        gst_m3u8_media_file_unref);
+    self->duration = GST_CLOCK_TIME_NONE;
+
+    if (self->parse_state)
+      gst_m3u8_parse_state_free (self->parse_state);
+    self->parse_state = gst_m3u8_parse_state_new ();
+
+    /* By default, allow caching */
+    self->allowcache = TRUE;
+
+    self->part_target = GST_CLOCK_TIME_NONE;
+    self->part_hold_back = GST_CLOCK_TIME_NONE;
+    self->can_block_reload = FALSE;
+    if (self->preload_hint) {
+      gst_m3u8_media_file_unref (self->preload_hint);
+      self->preload_hint = NULL;
     }
-    if (GST_M3U8_IS_LIVE (self)) {
-      self->first_file_start = self->last_file_end - duration;
-      GST_DEBUG ("Live playlist range %" GST_TIME_FORMAT " -> %"
-          GST_TIME_FORMAT, GST_TIME_ARGS (self->first_file_start),
-          GST_TIME_ARGS (self->last_file_end));
+  }
+  state = self->parse_state;
+
+  gst_m3u8_parse_lines (self, lines, state);
+  g_free (lines);
+
+  if (previous_files) {
+    gboolean consistent = TRUE;
+
+    if (previous_files->len > 0) {
+      if (state->have_mediasequence) {
+        consistent = check_media_seqnums (self, previous_files);
+      } else {
+        generate_media_seqnums (self, previous_files);
+      }
     }
-    self->duration = duration;
+
+    g_ptr_array_unref (previous_files);
+    previous_files = NULL;
+
+    /* error was reported above already */
+    if (!consistent)
+      goto invalid;
   }
 
+  if (self->files->len == 0) {
+    GST_ERROR ("Invalid media playlist, it does not contain any media files");
+    goto invalid;
+  }
+
+  /* The sequence numbers might have been regenerated above, continue
+   * after the last one when parsing appended lines */
+  state->mediasequence = GST_M3U8_MEDIA_FILE (g_ptr_array_index (self->files,
+          self->files->len - 1))->sequence + 1;
+
+  if (!appended)
+    gst_m3u8_update_partial_segments (self, state);
+
+  /* calculate the start and end times of this media playlist. */
+  if (!gst_m3u8_index_files (self, first_new))
+    goto invalid;
+
   /* first-time setup */
-  if (self->files && self->sequence == -1) {
-    GList *file;
+  if (self->sequence == -1) {
+    gint idx;
 
     if (GST_M3U8_IS_LIVE (self)) {
       gint i;
       GstClockTime sequence_pos = 0;
+      GstM3U8MediaFile *file;
 
-      file = g_list_last (self->files);
+      idx = self->files->len - 1;
+      file = g_ptr_array_index (self->files, idx);
 
-      if (self->last_file_end >= GST_M3U8_MEDIA_FILE (file->data)->duration) {
-        sequence_pos =
-            self->last_file_end - GST_M3U8_MEDIA_FILE (file->data)->duration;
+      if (self->last_file_end >= file->duration) {
+        sequence_pos = self->last_file_end - file->duration;
       }
 
       /* for live streams, start GST_M3U8_LIVE_MIN_FRAGMENT_DISTANCE from
        * the end of the playlist. See section 6.3.3 of HLS draft */
-      for (i = 0; i < GST_M3U8_LIVE_MIN_FRAGMENT_DISTANCE && file->prev &&
-          GST_M3U8_MEDIA_FILE (file->prev->data)->duration <= sequence_pos;
-          ++i) {
-        file = file->prev;
-        sequence_pos -= GST_M3U8_MEDIA_FILE (file->data)->duration;
+      for (i = 0; i < GST_M3U8_LIVE_MIN_FRAGMENT_DISTANCE && idx > 0 &&
+          GST_M3U8_MEDIA_FILE (g_ptr_array_index (self->files,
+                  idx - 1))->duration <= sequence_pos; ++i) {
+        idx--;
+        file = g_ptr_array_index (self->files, idx);
+        sequence_pos -= file->duration;
       }
       self->sequence_position = sequence_pos;
     } else {
-      file = g_list_first (self->files);
+      idx = 0;
       self->sequence_position = 0;
     }
-    self->current_file = file;
-    self->sequence = GST_M3U8_MEDIA_FILE (file->data)->sequence;
+    self->current_file_idx = idx;
+    self->sequence =
+        GST_M3U8_MEDIA_FILE (g_ptr_array_index (self->files, idx))->sequence;
     GST_DEBUG ("first sequence: %u", (guint) self->sequence);
   }
 
-  GST_LOG ("processed media playlist %s, %u fragments", self->name,
-      g_list_length (self->files));
+  GST_LOG ("processed media playlist %s, %u fragments (%u new)", self->name,
+      self->files->len, self->files->len - first_new);
 
   GST_M3U8_UNLOCK (self);
 
   return TRUE;
+
+invalid:
+  {
+    /* Don't resume parsing on top of an invalid playlist */
+    gst_m3u8_parse_state_free (self->parse_state);
+    self->parse_state = NULL;
+    GST_M3U8_UNLOCK (self);
+    return FALSE;
+  }
+}
+
+/* Index of the first file with a sequence number greater or equal to
+ * @sequence when going @forward, of the last one with a sequence number
+ * lower or equal to @sequence otherwise, or -1 if there is none.
+ * call with M3U8_LOCK held */
+static gint
+m3u8_find_file_by_sequence (GstM3U8 * m3u8, gint64 sequence,
+    gboolean forward)
+{
+  GstM3U8MediaFile *file;
+  guint lo = 0, hi = m3u8->files->len;
+
+  if (hi == 0)
+    return -1;
+
+  /* Sequence numbers are contiguous in most playlists */
+  file = g_ptr_array_index (m3u8->files, 0);
+  if (sequence >= file->sequence && sequence - file->sequence < hi) {
+    guint idx = sequence - file->sequence;
+
+    file = g_ptr_array_index (m3u8->files, idx);
+    if (file->sequence == sequence)
+      return idx;
+  }
+
+  /* lo ends up as the first index with a sequence >= @sequence */
+  while (lo < hi) {
+    guint mid = lo + (hi - lo) / 2;
+
+    file = g_ptr_array_index (m3u8->files, mid);
+    if (file->sequence < sequence)
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+
+  if (forward)
+    return lo < m3u8->files->len ? (gint) lo : -1;
+
+  if (lo < m3u8->files->len
+      && GST_M3U8_MEDIA_FILE (g_ptr_array_index (m3u8->files,
+              lo))->sequence == sequence)
+    return lo;
+
+  return (gint) lo - 1;
+}
+
+/* Index of the file with sequence number @sequence, or -1.
+ * call with M3U8_LOCK held */
+static gint
+m3u8_find_file_with_sequence (GstM3U8 * m3u8, gint64 sequence)
+{
+  gint idx = m3u8_find_file_by_sequence (m3u8, sequence, TRUE);
+
+  if (idx >= 0 && GST_M3U8_MEDIA_FILE (g_ptr_array_index (m3u8->files,
+              idx))->sequence != sequence)
+    idx = -1;
+
+  return idx;
 }
 
 /* call with M3U8_LOCK held */
-static GList *
+static gint
 m3u8_find_next_fragment (GstM3U8 * m3u8, gboolean forward)
 {
-  GstM3U8MediaFile *file;
-  GList *l = m3u8->files;
+  return m3u8_find_file_by_sequence (m3u8, m3u8->sequence, forward);
+}
 
-  if (forward) {
-    while (l) {
-      file = l->data;
+/* Returns the index of the file playing at @offset, relative to the start
+ * of the first file, or -1 if @offset is after the end of the playlist */
+gint
+gst_m3u8_find_file_by_offset (GstM3U8 * m3u8, GstClockTime offset)
+{
+  guint lo = 0, hi;
+  gint idx = -1;
 
-      if (file->sequence >= m3u8->sequence)
-        break;
+  g_return_val_if_fail (m3u8 != NULL, -1);
 
-      l = l->next;
-    }
-  } else {
-    l = g_list_last (l);
+  GST_M3U8_LOCK (m3u8);
+
+  hi = m3u8->file_starts->len;
+  if (hi == 0 || offset >= m3u8->duration)
+    goto out;
+
+  /* lo ends up as the first file starting after @offset */
+  while (lo < hi) {
+    guint mid = lo + (hi - lo) / 2;
+
+    if (g_array_index (m3u8->file_starts, GstClockTime, mid) <= offset)
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+  idx = (gint) lo - 1;
+
+out:
+  GST_M3U8_UNLOCK (m3u8);
+
+  return idx;
+}
+
+/* Fragment to download at @part_idx of @sequence when downloading partial
+ * segments: the partial segment, the full segment if it has no partial
+ * segments and @part_idx is 0, or the preload hint. @sequence and @part_idx
+ * are moved to the next segment if the partial segments of @sequence were
+ * all downloaded already, and @discont is set if part of the media had to
+ * be skipped.
+ * call with M3U8_LOCK held */
+static GstM3U8MediaFile *
+m3u8_resolve_partial_segment (GstM3U8 * m3u8, gint64 * sequence,
+    gint * part_idx, gboolean * discont)
+{
+  GstM3U8MediaFile *file;
+  GPtrArray *parts;
+  gint idx;
+
+  while (m3u8->files->len > 0) {
+    idx = m3u8_find_file_with_sequence (m3u8, *sequence);
+
+    if (idx < 0) {
+      GstM3U8MediaFile *first = g_ptr_array_index (m3u8->files, 0);
+      GstM3U8MediaFile *last =
+          g_ptr_array_index (m3u8->files, m3u8->files->len - 1);
+
+      if (*sequence < first->sequence) {
+        GST_WARNING ("Partial segment %" G_GINT64_FORMAT "/%d left the "
+            "playlist, resuming at %" G_GINT64_FORMAT, *sequence, *part_idx,
+            first->sequence);
+        *sequence = first->sequence;
+        *part_idx = 0;
+        if (discont)
+          *discont = TRUE;
+        continue;
+      }
 
-    while (l) {
-      file = l->data;
+      if (*sequence != last->sequence + 1)
+        return NULL;
 
-      if (file->sequence <= m3u8->sequence)
-        break;
+      /* The segment being produced */
+      parts = m3u8->partial_segments;
+      if (parts && (guint) * part_idx < parts->len) {
+        file = g_ptr_array_index (parts, *part_idx);
+        return file->key ? NULL : file;
+      }
+      file = m3u8->preload_hint;
+      if (file && file->sequence == *sequence && file->part_index == *part_idx)
+        return file->key ? NULL : file;
+      return NULL;
+    }
 
-      l = l->prev;
+    file = g_ptr_array_index (m3u8->files, idx);
+    parts = file->partial_segments;
+
+    /* Encrypted partial segments can't be decrypted independently of the
+     * rest of the segment */
+    if (parts == NULL || file->key) {
+      if (*part_idx == 0)
+        return file;
+      GST_WARNING ("Can't resume segment %" G_GINT64_FORMAT " at partial "
+          "segment %d", *sequence, *part_idx);
+      if (discont)
+        *discont = TRUE;
+    } else if ((guint) * part_idx < parts->len) {
+      return g_ptr_array_index (parts, *part_idx);
     }
+
+    (*sequence)++;
+    *part_idx = 0;
   }
 
-  return l;
+  return NULL;
+}
+
+/* Moves @sequence and @part_idx past the fragment returned for them by
+ * m3u8_resolve_partial_segment().
+ * call with M3U8_LOCK held */
+static void
+m3u8_advance_partial_segment (GstM3U8 * m3u8, gint64 * sequence,
+    gint * part_idx)
+{
+  GstM3U8MediaFile *file;
+
+  file = m3u8_resolve_partial_segment (m3u8, sequence, part_idx, NULL);
+  if (file && file->part_index < 0) {
+    /* A full segment */
+    (*sequence)++;
+    *part_idx = 0;
+  } else {
+    (*part_idx)++;
+  }
 }
 
 GstM3U8MediaFile *
@@ -932,13 +1447,37 @@ gst_m3u8_get_next_fragment (GstM3U8 * m3u8, gboolean forward,
   if (m3u8->sequence < 0)       /* can't happen really */
     goto out;
 
-  if (m3u8->current_file == NULL)
-    m3u8->current_file = m3u8_find_next_fragment (m3u8, forward);
+  if (forward && m3u8->current_part_idx >= 0) {
+    gboolean skipped = FALSE;
+
+    file = m3u8_resolve_partial_segment (m3u8, &m3u8->sequence,
+        &m3u8->current_part_idx, &skipped);
+    if (file == NULL)
+      goto out;
+
+    file = gst_m3u8_media_file_ref (file);
+    m3u8->current_file_idx = -1;
 
-  if (m3u8->current_file == NULL)
+    GST_DEBUG ("Got partial segment %d of sequence %" G_GINT64_FORMAT,
+        file->part_index, file->sequence);
+
+    if (sequence_position)
+      *sequence_position = m3u8->sequence_position;
+    if (discont)
+      *discont = file->discont || skipped;
+
+    m3u8->current_file_duration = file->duration;
     goto out;
+  }
 
-  file = gst_m3u8_media_file_ref (m3u8->current_file->data);
+  if (m3u8->current_file_idx < 0)
+    m3u8->current_file_idx = m3u8_find_next_fragment (m3u8, forward);
+
+  if (m3u8->current_file_idx < 0)
+    goto out;
+
+  file = gst_m3u8_media_file_ref (g_ptr_array_index (m3u8->files,
+          m3u8->current_file_idx));
 
   GST_DEBUG ("Got fragment with sequence %u (current sequence %u)",
       (guint) file->sequence, (guint) m3u8->sequence);
@@ -962,7 +1501,7 @@ gboolean
 gst_m3u8_has_next_fragment (GstM3U8 * m3u8, gboolean forward)
 {
   gboolean have_next;
-  GList *cur;
+  gint cur;
 
   g_return_val_if_fail (m3u8 != NULL, FALSE);
 
@@ -971,26 +1510,81 @@ gst_m3u8_has_next_fragment (GstM3U8 * m3u8, gboolean forward)
   GST_DEBUG ("Checking next fragment %" G_GINT64_FORMAT,
       m3u8->sequence + (forward ? 1 : -1));
 
-  if (m3u8->current_file) {
-    cur = m3u8->current_file;
+  if (forward && m3u8->current_part_idx >= 0) {
+    gint64 sequence = m3u8->sequence;
+    gint part_idx = m3u8->current_part_idx;
+
+    m3u8_advance_partial_segment (m3u8, &sequence, &part_idx);
+    have_next = m3u8_resolve_partial_segment (m3u8, &sequence, &part_idx,
+        NULL) != NULL;
+
+    GST_M3U8_UNLOCK (m3u8);
+    return have_next;
+  }
+
+  if (m3u8->current_file_idx >= 0) {
+    cur = m3u8->current_file_idx;
   } else {
     cur = m3u8_find_next_fragment (m3u8, forward);
   }
 
-  have_next = cur && ((forward && cur->next) || (!forward && cur->prev));
+  have_next = cur >= 0 && ((forward && cur + 1 < m3u8->files->len)
+      || (!forward && cur > 0));
 
   GST_M3U8_UNLOCK (m3u8);
 
   return have_next;
 }
 
+GstM3U8MediaFile *
+gst_m3u8_peek_fragment (GstM3U8 * m3u8, gboolean forward, guint index)
+{
+  GstM3U8MediaFile *file = NULL;
+  gint cur;
+
+  g_return_val_if_fail (m3u8 != NULL, NULL);
+
+  GST_M3U8_LOCK (m3u8);
+
+  /* Partial segments are too short to be worth prefetching */
+  if (forward && m3u8->current_part_idx >= 0) {
+    if (index == 0) {
+      gint64 sequence = m3u8->sequence;
+      gint part_idx = m3u8->current_part_idx;
+
+      file = m3u8_resolve_partial_segment (m3u8, &sequence, &part_idx, NULL);
+      if (file)
+        gst_m3u8_media_file_ref (file);
+    }
+
+    GST_M3U8_UNLOCK (m3u8);
+    return file;
+  }
+
+  if (m3u8->current_file_idx >= 0) {
+    cur = m3u8->current_file_idx;
+  } else {
+    cur = m3u8_find_next_fragment (m3u8, forward);
+  }
+
+  if (cur >= 0) {
+    gint64 idx = forward ? (gint64) cur + index : (gint64) cur - index;
+
+    if (idx >= 0 && idx < m3u8->files->len)
+      file = gst_m3u8_media_file_ref (g_ptr_array_index (m3u8->files, idx));
+  }
+
+  GST_M3U8_UNLOCK (m3u8);
+
+  return file;
+}
+
 /* call with M3U8_LOCK held */
 static void
 m3u8_alternate_advance (GstM3U8 * m3u8, gboolean forward)
 {
   gint targetnum = m3u8->sequence;
-  GList *tmp;
-  GstM3U8MediaFile *mf;
+  gint idx;
 
   /* figure out the target seqnum */
   if (forward)
@@ -998,18 +1592,15 @@ m3u8_alternate_advance (GstM3U8 * m3u8, gboolean forward)
   else
     targetnum -= 1;
 
-  for (tmp = m3u8->files; tmp; tmp = tmp->next) {
-    mf = (GstM3U8MediaFile *) tmp->data;
-    if (mf->sequence == targetnum)
-      break;
-  }
-  if (tmp == NULL) {
+  idx = m3u8_find_file_with_sequence (m3u8, targetnum);
+  if (idx < 0) {
     GST_WARNING ("Can't find next fragment");
     return;
   }
-  m3u8->current_file = tmp;
+  m3u8->current_file_idx = idx;
   m3u8->sequence = targetnum;
-  m3u8->current_file_duration = GST_M3U8_MEDIA_FILE (tmp->data)->duration;
+  m3u8->current_file_duration =
+      GST_M3U8_MEDIA_FILE (g_ptr_array_index (m3u8->files, idx))->duration;
 }
 
 void
@@ -1035,30 +1626,35 @@ gst_m3u8_advance_fragment (GstM3U8 * m3u8, gboolean forward)
     GST_DEBUG ("Sequence position now %" GST_TIME_FORMAT,
         GST_TIME_ARGS (m3u8->sequence_position));
   }
-  if (!m3u8->current_file) {
-    GList *l;
 
+  if (forward && m3u8->current_part_idx >= 0) {
+    m3u8_advance_partial_segment (m3u8, &m3u8->sequence,
+        &m3u8->current_part_idx);
+    m3u8->current_file_idx = -1;
+    GST_DEBUG ("Next partial segment %d of sequence %" G_GINT64_FORMAT,
+        m3u8->current_part_idx, m3u8->sequence);
+    goto out;
+  }
+
+  if (m3u8->current_file_idx < 0) {
     GST_DEBUG ("Looking for fragment %" G_GINT64_FORMAT, m3u8->sequence);
-    for (l = m3u8->files; l != NULL; l = l->next) {
-      if (GST_M3U8_MEDIA_FILE (l->data)->sequence == m3u8->sequence) {
-        m3u8->current_file = l;
-        break;
-      }
-    }
-    if (m3u8->current_file == NULL) {
+    m3u8->current_file_idx =
+        m3u8_find_file_with_sequence (m3u8, m3u8->sequence);
+    if (m3u8->current_file_idx < 0) {
       GST_DEBUG
           ("Could not find current fragment, trying next fragment directly");
       m3u8_alternate_advance (m3u8, forward);
 
       /* Resync sequence number if the above has failed for live streams */
-      if (m3u8->current_file == NULL && GST_M3U8_IS_LIVE (m3u8)) {
+      if (m3u8->current_file_idx < 0 && GST_M3U8_IS_LIVE (m3u8)) {
         /* for live streams, start GST_M3U8_LIVE_MIN_FRAGMENT_DISTANCE from
            the end of the playlist. See section 6.3.3 of HLS draft */
         gint pos =
-            g_list_length (m3u8->files) - GST_M3U8_LIVE_MIN_FRAGMENT_DISTANCE;
-        m3u8->current_file = g_list_nth (m3u8->files, pos >= 0 ? pos : 0);
+            (gint) m3u8->files->len - GST_M3U8_LIVE_MIN_FRAGMENT_DISTANCE;
+        m3u8->current_file_idx = pos >= 0 ? pos : 0;
         m3u8->current_file_duration =
-            GST_M3U8_MEDIA_FILE (m3u8->current_file->data)->duration;
+            GST_M3U8_MEDIA_FILE (g_ptr_array_index (m3u8->files,
+                m3u8->current_file_idx))->duration;
 
         GST_WARNING ("Resyncing live playlist");
       }
@@ -1066,28 +1662,33 @@ gst_m3u8_advance_fragment (GstM3U8 * m3u8, gboolean forward)
     }
   }
 
-  file = GST_M3U8_MEDIA_FILE (m3u8->current_file->data);
+  file = g_ptr_array_index (m3u8->files, m3u8->current_file_idx);
   GST_DEBUG ("Advancing from sequence %u", (guint) file->sequence);
   if (forward) {
-    m3u8->current_file = m3u8->current_file->next;
-    if (m3u8->current_file) {
-      m3u8->sequence = GST_M3U8_MEDIA_FILE (m3u8->current_file->data)->sequence;
+    if (m3u8->current_file_idx + 1 < m3u8->files->len) {
+      m3u8->current_file_idx++;
+      m3u8->sequence = GST_M3U8_MEDIA_FILE (g_ptr_array_index (m3u8->files,
+              m3u8->current_file_idx))->sequence;
     } else {
+      m3u8->current_file_idx = -1;
       m3u8->sequence = file->sequence + 1;
     }
   } else {
-    m3u8->current_file = m3u8->current_file->prev;
-    if (m3u8->current_file) {
-      m3u8->sequence = GST_M3U8_MEDIA_FILE (m3u8->current_file->data)->sequence;
+    if (m3u8->current_file_idx > 0) {
+      m3u8->current_file_idx--;
+      m3u8->sequence = GST_M3U8_MEDIA_FILE (g_ptr_array_index (m3u8->files,
+              m3u8->current_file_idx))->sequence;
     } else {
+      m3u8->current_file_idx = -1;
       m3u8->sequence = file->sequence - 1;
     }
   }
-  if (m3u8->current_file) {
-    /* Store duration of the fragment we're using to update the position 
+  if (m3u8->current_file_idx >= 0) {
+    /* Store duration of the fragment we're using to update the position
      * the next time we advance */
     m3u8->current_file_duration =
-        GST_M3U8_MEDIA_FILE (m3u8->current_file->data)->duration;
+        GST_M3U8_MEDIA_FILE (g_ptr_array_index (m3u8->files,
+            m3u8->current_file_idx))->duration;
   }
 
 out:
@@ -1108,12 +1709,13 @@ gst_m3u8_get_duration (GstM3U8 * m3u8)
   if (!m3u8->endlist)
     goto out;
 
-  if (!GST_CLOCK_TIME_IS_VALID (m3u8->duration) && m3u8->files != NULL) {
-    GList *f;
+  if (!GST_CLOCK_TIME_IS_VALID (m3u8->duration) && m3u8->files->len > 0) {
+    guint i;
 
     m3u8->duration = 0;
-    for (f = m3u8->files; f != NULL; f = f->next)
-      m3u8->duration += GST_M3U8_MEDIA_FILE (f)->duration;
+    for (i = 0; i < m3u8->files->len; i++)
+      m3u8->duration +=
+          GST_M3U8_MEDIA_FILE (g_ptr_array_index (m3u8->files, i))->duration;
   }
   duration = m3u8->duration;
 
@@ -1224,7 +1826,6 @@ gboolean
 gst_m3u8_get_seek_range (GstM3U8 * m3u8, gint64 * start, gint64 * stop)
 {
   GstClockTime duration = 0;
-  GList *walk;
   GstM3U8MediaFile *file;
   guint count;
   guint min_distance = 0;
@@ -1233,7 +1834,7 @@ gst_m3u8_get_seek_range (GstM3U8 * m3u8, gint64 * start, gint64 * stop)
 
   GST_M3U8_LOCK (m3u8);
 
-  if (m3u8->files == NULL)
+  if (m3u8->files->len == 0)
     goto out;
 
   if (GST_M3U8_IS_LIVE (m3u8)) {
@@ -1242,12 +1843,14 @@ gst_m3u8_get_seek_range (GstM3U8 * m3u8, gint64 * start, gint64 * stop)
        playlist - see 6.3.3. "Playing the Playlist file" of the HLS draft */
     min_distance = GST_M3U8_LIVE_MIN_FRAGMENT_DISTANCE;
   }
-  count = g_list_length (m3u8->files);
-
-  for (walk = m3u8->files; walk && count > min_distance; walk = walk->next) {
-    file = walk->data;
-    --count;
-    duration += file->duration;
+  count = m3u8->files->len;
+
+  if (count > min_distance) {
+    /* the files before the last min_distance ones */
+    count -= min_distance;
+    file = g_ptr_array_index (m3u8->files, count - 1);
+    duration = g_array_index (m3u8->file_starts, GstClockTime, count - 1) +
+        file->duration;
   }
 
   if (duration <= 0)
@@ -1262,6 +1865,197 @@ out:
   return (duration > 0);
 }
 
+gboolean
+gst_m3u8_has_partial_segments (GstM3U8 * m3u8)
+{
+  gboolean ret;
+
+  g_return_val_if_fail (m3u8 != NULL, FALSE);
+
+  GST_M3U8_LOCK (m3u8);
+  ret = GST_M3U8_IS_LIVE (m3u8) && GST_CLOCK_TIME_IS_VALID (m3u8->part_target);
+  GST_M3U8_UNLOCK (m3u8);
+
+  return ret;
+}
+
+/* Candidate starting point when looking for the live edge */
+static void
+m3u8_consider_live_edge_part (GstM3U8MediaFile * file, GstClockTime hold_back,
+    GstClockTime * distance, GstM3U8MediaFile ** start,
+    GstClockTime * start_distance)
+{
+  *distance += file->duration;
+
+  if (*start != NULL && *start_distance >= hold_back)
+    return;
+
+  /* Playback can only start at an independent partial segment, or at the
+   * start of a segment */
+  if (file->independent || file->part_index <= 0) {
+    *start = file;
+    *start_distance = *distance;
+  }
+}
+
+/* Switches to downloading partial segments, starting PART-HOLD-BACK before
+ * the end of the playlist. Returns FALSE if it has no partial segments. */
+gboolean
+gst_m3u8_seek_live_edge_part (GstM3U8 * m3u8)
+{
+  GstM3U8MediaFile *start = NULL;
+  GstClockTime hold_back, distance = 0, start_distance = 0;
+  GstClockTime trailing = 0;
+  gint i, j;
+
+  g_return_val_if_fail (m3u8 != NULL, FALSE);
+
+  GST_M3U8_LOCK (m3u8);
+
+  if (!GST_M3U8_IS_LIVE (m3u8) || !GST_CLOCK_TIME_IS_VALID (m3u8->part_target)
+      || m3u8->files->len == 0) {
+    GST_M3U8_UNLOCK (m3u8);
+    return FALSE;
+  }
+
+  /* PART-HOLD-BACK is required, but at least three times PART-TARGET */
+  if (GST_CLOCK_TIME_IS_VALID (m3u8->part_hold_back))
+    hold_back = m3u8->part_hold_back;
+  else
+    hold_back = 3 * m3u8->part_target;
+
+  /* Walk back from the last partial segment until far enough from it */
+  if (m3u8->partial_segments) {
+    for (j = m3u8->partial_segments->len - 1; j >= 0; j--) {
+      GstM3U8MediaFile *part = g_ptr_array_index (m3u8->partial_segments, j);
+
+      m3u8_consider_live_edge_part (part, hold_back, &distance, &start,
+          &start_distance);
+    }
+    trailing = distance;
+  }
+
+  for (i = m3u8->files->len - 1; i >= 0; i--) {
+    GstM3U8MediaFile *file = g_ptr_array_index (m3u8->files, i);
+
+    if (start != NULL && start_distance >= hold_back)
+      break;
+
+    if (file->partial_segments && !file->key) {
+      for (j = file->partial_segments->len - 1; j >= 0; j--) {
+        GstM3U8MediaFile *part =
+            g_ptr_array_index (file->partial_segments, j);
+
+        m3u8_consider_live_edge_part (part, hold_back, &distance, &start,
+            &start_distance);
+      }
+    } else {
+      m3u8_consider_live_edge_part (file, hold_back, &distance, &start,
+          &start_distance);
+    }
+  }
+
+  m3u8->sequence = start->sequence;
+  m3u8->current_part_idx = MAX (start->part_index, 0);
+  m3u8->current_file_idx = -1;
+  m3u8->current_file_duration = GST_CLOCK_TIME_NONE;
+  if (m3u8->last_file_end + trailing >= start_distance)
+    m3u8->sequence_position = m3u8->last_file_end + trailing - start_distance;
+  else
+    m3u8->sequence_position = 0;
+
+  GST_DEBUG ("Starting at partial segment %d of sequence %" G_GINT64_FORMAT
+      ", %" GST_TIME_FORMAT " from the live edge", m3u8->current_part_idx,
+      m3u8->sequence, GST_TIME_ARGS (start_distance));
+
+  GST_M3U8_UNLOCK (m3u8);
+
+  return TRUE;
+}
+
+static gchar *
+make_blocking_reload_uri (GstM3U8 * m3u8, gint64 msn, gint part)
+{
+  gchar sep = strchr (m3u8->uri, '?') ? '&' : '?';
+
+  if (part >= 0 && GST_CLOCK_TIME_IS_VALID (m3u8->part_target))
+    return g_strdup_printf ("%s%c_HLS_msn=%" G_GINT64_FORMAT "&_HLS_part=%d",
+        m3u8->uri, sep, msn, part);
+
+  return g_strdup_printf ("%s%c_HLS_msn=%" G_GINT64_FORMAT, m3u8->uri, sep,
+      msn);
+}
+
+/* URI of the playlist asking the server to hold the response until it
+ * contains the partial segment following the last one of the current
+ * playlist, or NULL if the server doesn't support blocking reloads */
+gchar *
+gst_m3u8_get_blocking_reload_uri (GstM3U8 * m3u8)
+{
+  GstM3U8MediaFile *last;
+  gchar *uri = NULL;
+  guint part;
+
+  g_return_val_if_fail (m3u8 != NULL, NULL);
+
+  GST_M3U8_LOCK (m3u8);
+
+  if (!m3u8->can_block_reload || !GST_M3U8_IS_LIVE (m3u8)
+      || m3u8->files->len == 0 || m3u8->uri == NULL)
+    goto out;
+
+  last = g_ptr_array_index (m3u8->files, m3u8->files->len - 1);
+  part = m3u8->partial_segments ? m3u8->partial_segments->len : 0;
+  uri = make_blocking_reload_uri (m3u8, last->sequence + 1, part);
+
+out:
+  GST_M3U8_UNLOCK (m3u8);
+
+  return uri;
+}
+
+/* URI of the rendition playlist @m3u8 asking the server to hold the
+ * response until it contains the last partial segment (or segment) of
+ * @main_m3u8, so that both playlists end at the same point. NULL if the
+ * server doesn't support blocking reloads of @m3u8 */
+gchar *
+gst_m3u8_get_aligned_blocking_reload_uri (GstM3U8 * m3u8, GstM3U8 * main_m3u8)
+{
+  GstM3U8MediaFile *last;
+  gchar *uri = NULL;
+  gint64 msn;
+  gint part = -1;
+
+  g_return_val_if_fail (m3u8 != NULL, NULL);
+  g_return_val_if_fail (main_m3u8 != NULL, NULL);
+
+  GST_M3U8_LOCK (main_m3u8);
+  if (main_m3u8->files->len == 0) {
+    GST_M3U8_UNLOCK (main_m3u8);
+    return NULL;
+  }
+  last = g_ptr_array_index (main_m3u8->files, main_m3u8->files->len - 1);
+  msn = last->sequence;
+  if (main_m3u8->partial_segments && main_m3u8->partial_segments->len > 0) {
+    msn++;
+    part = main_m3u8->partial_segments->len - 1;
+  }
+  GST_M3U8_UNLOCK (main_m3u8);
+
+  GST_M3U8_LOCK (m3u8);
+  /* Renditions without partial segments can only wait for the last
+   * complete segment */
+  if (m3u8->can_block_reload && GST_M3U8_IS_LIVE (m3u8) && m3u8->uri != NULL) {
+    if (part >= 0 && !GST_CLOCK_TIME_IS_VALID (m3u8->part_target))
+      uri = make_blocking_reload_uri (m3u8, msn - 1, -1);
+    else
+      uri = make_blocking_reload_uri (m3u8, msn, part);
+  }
+  GST_M3U8_UNLOCK (m3u8);
+
+  return uri;
+}
+
 GstHLSMedia *
 gst_hls_media_ref (GstHLSMedia * media)
 {
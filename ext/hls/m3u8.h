@@ -35,6 +35,7 @@ typedef struct _GstHLSMedia GstHLSMedia;
 typedef struct _GstM3U8Client GstM3U8Client;
 typedef struct _GstHLSVariantStream GstHLSVariantStream;
 typedef struct _GstHLSMasterPlaylist GstHLSMasterPlaylist;
+typedef struct _GstM3U8ParseState GstM3U8ParseState;
 
 #define GST_M3U8(m) ((GstM3U8*)m)
 #define GST_M3U8_MEDIA_FILE(f) ((GstM3U8MediaFile*)f)
@@ -64,10 +65,12 @@ struct _GstM3U8
   GstClockTime targetduration;  /* last EXT-X-TARGETDURATION */
   gboolean allowcache;          /* last EXT-X-ALLOWCACHE */
 
-  GList *files;
+  GPtrArray *files;             /* GstM3U8MediaFile, by increasing sequence */
+  GArray *file_starts;          /* GstClockTime start of each file relative
+                                 * to the first one */
 
   /* state */
-  GList *current_file;
+  gint current_file_idx;              /* index in files, or -1 */
   GstClockTime current_file_duration; /* Duration of current fragment */
   gint64 sequence;                    /* the next sequence for this client */
   GstClockTime sequence_position;     /* position of this sequence */
@@ -77,8 +80,20 @@ struct _GstM3U8
   GstClockTime duration;              /* cached total duration */
   gint discont_sequence;              /* currently expected EXT-X-DISCONTINUITY-SEQUENCE */
 
+  /* Low-Latency HLS */
+  GstClockTime part_target;           /* EXT-X-PART-INF PART-TARGET, or NONE */
+  GstClockTime part_hold_back;        /* EXT-X-SERVER-CONTROL PART-HOLD-BACK, or NONE */
+  gboolean can_block_reload;          /* EXT-X-SERVER-CONTROL CAN-BLOCK-RELOAD */
+  GPtrArray *partial_segments;        /* GstM3U8MediaFile, partial segments of the
+                                       * segment following the last one of files */
+  GstM3U8MediaFile *preload_hint;     /* EXT-X-PRELOAD-HINT of the next partial segment */
+  gint current_part_idx;              /* next partial segment of sequence to download,
+                                       * or -1 to download full segments */
+
   /*< private > */
   gchar *last_data;
+  gsize last_data_len;
+  GstM3U8ParseState *parse_state;     /* to parse lines appended later on */
   GMutex lock;
 
   gint ref_count;               /* ATOMIC */
@@ -101,6 +116,11 @@ struct _GstM3U8MediaFile
   gint64 offset, size;
   gint ref_count;               /* ATOMIC */
   GstM3U8InitFile *init_file;   /* Media Initialization (hold ref) */
+
+  /* Low-Latency HLS */
+  GPtrArray *partial_segments;  /* GstM3U8MediaFile, EXT-X-PART of this segment */
+  gint part_index;              /* index in the segment for partial segments, else -1 */
+  gboolean independent;         /* partial segment starting with an independent frame */
 };
 
 struct _GstM3U8InitFile
@@ -132,6 +152,10 @@ GstM3U8MediaFile * gst_m3u8_get_next_fragment    (GstM3U8      * m3u8,
 gboolean           gst_m3u8_has_next_fragment    (GstM3U8 * m3u8,
                                                   gboolean  forward);
 
+GstM3U8MediaFile * gst_m3u8_peek_fragment        (GstM3U8 * m3u8,
+                                                  gboolean  forward,
+                                                  guint     index);
+
 void               gst_m3u8_advance_fragment     (GstM3U8 * m3u8,
                                                   gboolean  forward);
 
@@ -143,10 +167,22 @@ gchar *            gst_m3u8_get_uri              (GstM3U8 * m3u8);
 
 gboolean           gst_m3u8_is_live              (GstM3U8 * m3u8);
 
+gint               gst_m3u8_find_file_by_offset  (GstM3U8      * m3u8,
+                                                  GstClockTime   offset);
+
 gboolean           gst_m3u8_get_seek_range       (GstM3U8 * m3u8,
                                                   gint64  * start,
                                                   gint64  * stop);
 
+gboolean           gst_m3u8_has_partial_segments (GstM3U8 * m3u8);
+
+gboolean           gst_m3u8_seek_live_edge_part  (GstM3U8 * m3u8);
+
+gchar *            gst_m3u8_get_blocking_reload_uri (GstM3U8 * m3u8);
+
+gchar *            gst_m3u8_get_aligned_blocking_reload_uri (GstM3U8 * m3u8,
+                                                             GstM3U8 * main_m3u8);
+
 typedef enum
 {
   GST_HLS_MEDIA_TYPE_INVALID = -1,
@@ -29,6 +29,7 @@
 #include "gstsrtobject.h"
 
 #include <gst/base/gstbasesink.h>
+#include <gst/base/gstqueuearray.h>
 #include <gio/gnetworking.h>
 #include <stdlib.h>
 #include <stdbool.h>
@@ -56,35 +57,49 @@ GST_DEBUG_CATEGORY_EXTERN (gst_debug_srtobject);
   GST_ELEMENT_WARNING (srtobject->element, RESOURCE, code, \
   ("Error on SRT socket. Trying to reconnect."), SRTSOCK_ERROR_DEBUG)
 
-enum
+/* Upper bound of the time the sender thread sleeps in srt_epoll_wait() */
+#define SENDER_POLL_TIMEOUT 100
+
+typedef struct
 {
-  PROP_URI = 1,
-  PROP_MODE,
-  PROP_LOCALADDRESS,
-  PROP_LOCALPORT,
-  PROP_PASSPHRASE,
-  PROP_PBKEYLEN,
-  PROP_POLL_TIMEOUT,
-  PROP_LATENCY,
-  PROP_MSG_SIZE,
-  PROP_STATS,
-  PROP_WAIT_FOR_CONNECTION,
-  PROP_STREAMID,
-  PROP_AUTHENTICATION,
-  PROP_LAST
-};
+  GstBuffer *buffer;
+  gsize size;
+  /* bytes of the buffer already handed to SRT */
+  gsize offset;
+  gint64 queued_time;
+  gboolean header;
+} SRTCallerPacket;
 
 typedef struct
 {
   SRTSOCKET sock;
   gint poll_id;
   GSocketAddress *sockaddr;
+  /* TRUE once the stream headers are queued for the caller */
   gboolean sent_headers;
+
+  /* Buffers waiting for the sender thread, of SRTCallerPacket */
+  GstQueueArray *queue;
+  guint64 queued_bytes;
+  /* TRUE while the socket is in the sender epoll */
+  gboolean pending;
+  gint payload_size;
+  GstSRTCallerDropPolicy drop_policy;
+
+  guint64 dropped;
+  gint64 queue_latency;
+  gint64 max_queue_latency;
 } SRTCaller;
 
 static GstStructure *gst_srt_object_accumulate_stats (GstSRTObject * srtobject,
     SRTSOCKET srtsock);
 
+static void
+srt_caller_packet_clear (SRTCallerPacket * packet)
+{
+  gst_buffer_unref (packet->buffer);
+}
+
 static SRTCaller *
 srt_caller_new (void)
 {
@@ -92,6 +107,10 @@ srt_caller_new (void)
   caller->sock = SRT_INVALID_SOCK;
   caller->poll_id = SRT_ERROR;
   caller->sent_headers = FALSE;
+  caller->queue = gst_queue_array_new_for_struct (sizeof (SRTCallerPacket),
+      16);
+  gst_queue_array_set_clear_func (caller->queue,
+      (GDestroyNotify) srt_caller_packet_clear);
 
   return caller;
 }
@@ -102,6 +121,7 @@ srt_caller_free (SRTCaller * caller)
   g_return_if_fail (caller != NULL);
 
   g_clear_object (&caller->sockaddr);
+  gst_queue_array_free (caller->queue);
 
   if (caller->sock != SRT_INVALID_SOCK) {
     srt_close (caller->sock);
@@ -130,6 +150,117 @@ srt_caller_signal_removed (SRTCaller * caller, GstSRTObject * srtobject)
       caller->sockaddr);
 }
 
+/* called with sock_lock */
+static void
+srt_caller_set_pending (GstSRTObject * srtobject, SRTCaller * caller,
+    gboolean pending)
+{
+  if (caller->pending == pending)
+    return;
+
+  if (pending) {
+    gint flags = SRT_EPOLL_OUT | SRT_EPOLL_ERR;
+
+    /* Adding a writable socket also wakes up the sender thread if it is
+     * waiting for other callers */
+    if (srt_epoll_add_usock (srtobject->sender_poll_id, caller->sock, &flags)) {
+      GST_WARNING_OBJECT (srtobject->element,
+          "Failed to poll caller %d: %s", caller->sock,
+          srt_getlasterror_str ());
+    }
+    srtobject->n_pending_callers++;
+    g_cond_signal (&srtobject->sender_cond);
+  } else {
+    srt_epoll_remove_usock (srtobject->sender_poll_id, caller->sock);
+    srtobject->n_pending_callers--;
+  }
+
+  caller->pending = pending;
+}
+
+static void
+srt_caller_push (SRTCaller * caller, GstBuffer * buffer, gboolean header)
+{
+  SRTCallerPacket packet;
+
+  packet.buffer = gst_buffer_ref (buffer);
+  packet.size = gst_buffer_get_size (buffer);
+  packet.offset = 0;
+  packet.queued_time = g_get_monotonic_time ();
+  packet.header = header;
+
+  caller->queued_bytes += packet.size;
+  gst_queue_array_push_tail_struct (caller->queue, &packet);
+}
+
+/* Makes room for one more buffer in the queue of the caller. Returns FALSE
+ * if the caller has to be disconnected instead.
+ *
+ * Stream headers and the buffer being sent must go out whole, so they are
+ * never dropped and are not counted against @queue_size: the queue holds at
+ * most @queue_size buffers besides the stream headers and one partially
+ * sent buffer. */
+static gboolean
+srt_caller_make_room (GstSRTObject * srtobject, SRTCaller * caller,
+    guint queue_size)
+{
+  guint i, len, n_droppable = 0, first_droppable = 0;
+
+  len = gst_queue_array_get_length (caller->queue);
+  for (i = 0; i < len; i++) {
+    SRTCallerPacket *packet =
+        gst_queue_array_peek_nth_struct (caller->queue, i);
+
+    if (packet->header || packet->offset > 0)
+      continue;
+
+    if (n_droppable == 0)
+      first_droppable = i;
+    n_droppable++;
+  }
+
+  if (n_droppable < queue_size)
+    return TRUE;
+
+  if (caller->drop_policy == GST_SRT_CALLER_DROP_POLICY_DISCONNECT) {
+    GST_WARNING_OBJECT (srtobject->element,
+        "Dropping caller %d: %u buffers queued", caller->sock, n_droppable);
+    return FALSE;
+  }
+
+  /* drop the oldest buffers until there is room for one more */
+  while (n_droppable >= queue_size) {
+    SRTCallerPacket *packet =
+        gst_queue_array_peek_nth_struct (caller->queue, first_droppable);
+
+    if (packet->header || packet->offset > 0) {
+      first_droppable++;
+      continue;
+    }
+
+    GST_LOG_OBJECT (srtobject->element, "Caller %d is too slow, dropping %"
+        GST_PTR_FORMAT, caller->sock, packet->buffer);
+
+    caller->queued_bytes -= packet->size;
+    gst_buffer_unref (packet->buffer);
+    gst_queue_array_drop_struct (caller->queue, first_droppable, NULL);
+    caller->dropped++;
+    n_droppable--;
+  }
+
+  return TRUE;
+}
+
+/* called with sock_lock */
+static void
+gst_srt_object_remove_caller (GstSRTObject * srtobject, SRTCaller * caller)
+{
+  srtobject->callers = g_list_remove (srtobject->callers, caller);
+  srt_caller_set_pending (srtobject, caller, FALSE);
+  srt_caller_signal_removed (caller, srtobject);
+  srt_caller_free (caller);
+}
+
 struct srt_constant_params
 {
   const gchar *name;
@@ -366,8 +497,14 @@ gst_srt_object_new (GstElement * element)
   srtobject->listener_poll_id = SRT_ERROR;
   srtobject->sent_headers = FALSE;
   srtobject->wait_for_connection = GST_SRT_DEFAULT_WAIT_FOR_CONNECTION;
+  srtobject->sender_poll_id = SRT_ERROR;
+  srtobject->caller_queue_size = GST_SRT_DEFAULT_CALLER_QUEUE_SIZE;
+  srtobject->caller_drop_policy = GST_SRT_DEFAULT_CALLER_DROP_POLICY;
+  srtobject->batch_size = GST_SRT_DEFAULT_BATCH_SIZE;
+  srtobject->aggregate_size = GST_SRT_DEFAULT_AGGREGATE_SIZE;
 
   g_cond_init (&srtobject->sock_cond);
+  g_cond_init (&srtobject->sender_cond);
   return srtobject;
 }
 
@@ -382,6 +519,7 @@ gst_srt_object_destroy (GstSRTObject * srtobject)
   }
 
   g_cond_clear (&srtobject->sock_cond);
+  g_cond_clear (&srtobject->sender_cond);
 
   GST_DEBUG_OBJECT (srtobject->element, "Destroying srtobject");
   gst_structure_free (srtobject->parameters);
@@ -437,6 +575,18 @@ gst_srt_object_set_property_helper (GstSRTObject * srtobject,
     case PROP_AUTHENTICATION:
       srtobject->authentication = g_value_get_boolean (value);
       break;
+    case PROP_CALLER_QUEUE_SIZE:
+      srtobject->caller_queue_size = g_value_get_uint (value);
+      break;
+    case PROP_CALLER_DROP_POLICY:
+      srtobject->caller_drop_policy = g_value_get_enum (value);
+      break;
+    case PROP_BATCH_SIZE:
+      srtobject->batch_size = g_value_get_uint (value);
+      break;
+    case PROP_AGGREGATE_SIZE:
+      srtobject->aggregate_size = g_value_get_uint (value);
+      break;
     default:
       goto err;
   }
@@ -544,6 +694,26 @@ gst_srt_object_get_property_helper (GstSRTObject * srtobject,
     case PROP_AUTHENTICATION:
       g_value_set_boolean (value, srtobject->authentication);
       break;
+    case PROP_CALLER_QUEUE_SIZE:
+      GST_OBJECT_LOCK (srtobject->element);
+      g_value_set_uint (value, srtobject->caller_queue_size);
+      GST_OBJECT_UNLOCK (srtobject->element);
+      break;
+    case PROP_CALLER_DROP_POLICY:
+      GST_OBJECT_LOCK (srtobject->element);
+      g_value_set_enum (value, srtobject->caller_drop_policy);
+      GST_OBJECT_UNLOCK (srtobject->element);
+      break;
+    case PROP_BATCH_SIZE:
+      GST_OBJECT_LOCK (srtobject->element);
+      g_value_set_uint (value, srtobject->batch_size);
+      GST_OBJECT_UNLOCK (srtobject->element);
+      break;
+    case PROP_AGGREGATE_SIZE:
+      GST_OBJECT_LOCK (srtobject->element);
+      g_value_set_uint (value, srtobject->aggregate_size);
+      GST_OBJECT_UNLOCK (srtobject->element);
+      break;
     default:
       return FALSE;
   }
@@ -926,11 +1096,14 @@ thread_func (gpointer data)
   gint rsocklen = 1;
 
   for (;;) {
+    GstSRTCallerDropPolicy drop_policy;
+
     GST_OBJECT_LOCK (srtobject->element);
     if (!gst_structure_get_int (srtobject->parameters, "poll-timeout",
             &poll_timeout)) {
       poll_timeout = GST_SRT_DEFAULT_POLL_TIMEOUT;
     }
+    drop_policy = srtobject->caller_drop_policy;
     GST_OBJECT_UNLOCK (srtobject->element);
 
     GST_DEBUG_OBJECT (srtobject->element, "Waiting a request from caller");
@@ -962,6 +1135,7 @@ thread_func (gpointer data)
           g_socket_address_new_from_native (&caller_sa.sa, caller_sa_len);
       caller->poll_id = srt_epoll_create ();
       caller->sock = caller_sock;
+      caller->drop_policy = drop_policy;
 
       if (gst_uri_handler_get_uri_type (GST_URI_HANDLER
               (srtobject->element)) == GST_URI_SRC) {
@@ -1000,6 +1174,141 @@ thread_func (gpointer data)
   }
 }
 
+/* Sends as much of the queue of the caller as SRT takes without blocking.
+ * Returns FALSE if the caller has to be dropped.
+ *
+ * called with sock_lock */
+static gboolean
+gst_srt_object_flush_caller (GstSRTObject * srtobject, SRTCaller * caller)
+{
+  SRTCallerPacket *packet;
+
+  if (caller->payload_size == 0) {
+    gint optlen = sizeof (caller->payload_size);
+
+    if (srt_getsockflag (caller->sock, SRTO_PAYLOADSIZE,
+            &caller->payload_size, &optlen)) {
+      GST_WARNING_OBJECT (srtobject->element, "%s", srt_getlasterror_str ());
+      return FALSE;
+    }
+  }
+
+  while ((packet = gst_queue_array_peek_head_struct (caller->queue))) {
+    GstMapInfo mapinfo;
+    gint64 latency;
+
+    if (!gst_buffer_map (packet->buffer, &mapinfo, GST_MAP_READ)) {
+      GST_WARNING_OBJECT (srtobject->element, "Could not map %"
+          GST_PTR_FORMAT, packet->buffer);
+      packet->offset = packet->size;
+    } else {
+      while (packet->offset < mapinfo.size) {
+        gint rest = MIN (mapinfo.size - packet->offset, caller->payload_size);
+        gint sent;
+
+        sent = srt_sendmsg2 (caller->sock,
+            (char *) (mapinfo.data + packet->offset), rest, 0);
+        if (sent < 0) {
+          gst_buffer_unmap (packet->buffer, &mapinfo);
+
+          /* Send buffer full, wait for the socket to become writable */
+          if (srt_getlasterror (NULL) == SRT_EASYNCSND)
+            return TRUE;
+
+          GST_WARNING_OBJECT (srtobject->element, "Dropping caller %d: %s",
+              caller->sock, srt_getlasterror_str ());
+          return FALSE;
+        }
+        packet->offset += sent;
+      }
+      gst_buffer_unmap (packet->buffer, &mapinfo);
+    }
+
+    latency = g_get_monotonic_time () - packet->queued_time;
+    caller->queue_latency = latency;
+    caller->max_queue_latency = MAX (caller->max_queue_latency, latency);
+    caller->queued_bytes -= packet->size;
+
+    gst_buffer_unref (packet->buffer);
+    gst_queue_array_pop_head_struct (caller->queue);
+  }
+
+  srt_caller_set_pending (srtobject, caller, FALSE);
+
+  return TRUE;
+}
+
+static gpointer
+sender_thread_func (gpointer data)
+{
+  GstSRTObject *srtobject = data;
+  SRTSOCKET rsocks[16], wsocks[16];
+
+  g_mutex_lock (&srtobject->sock_lock);
+
+  while (srtobject->sender_running) {
+    gint rsocklen = G_N_ELEMENTS (rsocks);
+    gint wsocklen = G_N_ELEMENTS (wsocks);
+    GList *item;
+
+    if (srtobject->n_pending_callers == 0) {
+      g_cond_wait (&srtobject->sender_cond, &srtobject->sock_lock);
+      continue;
+    }
+
+    /* Sending fails right away on the callers that are still congested,
+     * there is no need to only look at the sockets that were reported */
+    item = srtobject->callers;
+    while (item != NULL) {
+      SRTCaller *caller = item->data;
+      item = item->next;
+
+      if (caller->pending && !gst_srt_object_flush_caller (srtobject, caller))
+        gst_srt_object_remove_caller (srtobject, caller);
+    }
+
+    if (srtobject->n_pending_callers == 0)
+      continue;
+
+    /* Sockets are added to the epoll as soon as data is queued for them,
+     * which also ends the wait */
+    g_mutex_unlock (&srtobject->sock_lock);
+    if (srt_epoll_wait (srtobject->sender_poll_id, rsocks, &rsocklen, wsocks,
+            &wsocklen, SENDER_POLL_TIMEOUT, NULL, 0, NULL, 0) < 0 &&
+        srt_getlasterror (NULL) != SRT_ETIMEOUT) {
+      GST_LOG_OBJECT (srtobject->element, "epoll wait failed: %s",
+          srt_getlasterror_str ());
+    }
+    g_mutex_lock (&srtobject->sock_lock);
+  }
+
+  g_mutex_unlock (&srtobject->sock_lock);
+
+  return NULL;
+}
+
+/* called with sock_lock */
+static void
+gst_srt_object_stop_sender (GstSRTObject * srtobject)
+{
+  if (srtobject->sender_thread) {
+    GThread *thread = g_steal_pointer (&srtobject->sender_thread);
+
+    srtobject->sender_running = FALSE;
+    g_cond_signal (&srtobject->sender_cond);
+    g_mutex_unlock (&srtobject->sock_lock);
+    g_thread_join (thread);
+    g_mutex_lock (&srtobject->sock_lock);
+  }
+
+  if (srtobject->sender_poll_id != SRT_ERROR) {
+    srt_epoll_release (srtobject->sender_poll_id);
+    srtobject->sender_poll_id = SRT_ERROR;
+  }
+
+  srtobject->n_pending_callers = 0;
+}
+
 static GSocketAddress *
 peeraddr_to_g_socket_address (const struct sockaddr *peeraddr)
 {
@@ -1140,6 +1449,19 @@ gst_srt_object_wait_connect (GstSRTObject * srtobject,
     goto failed;
   }
 
+  if (gst_uri_handler_get_uri_type (GST_URI_HANDLER (srtobject->element)) ==
+      GST_URI_SINK) {
+    srtobject->sender_poll_id = srt_epoll_create ();
+    srtobject->sender_running = TRUE;
+    srtobject->sender_thread =
+        g_thread_try_new ("GstSRTObjectSender", sender_thread_func, srtobject,
+        error);
+    if (srtobject->sender_thread == NULL) {
+      GST_ERROR_OBJECT (srtobject->element, "Failed to start sender thread");
+      goto failed;
+    }
+  }
+
   srtobject->thread =
       g_thread_try_new ("GstSRTObjectListener", thread_func, srtobject, error);
   if (srtobject->thread == NULL) {
@@ -1151,6 +1473,10 @@ gst_srt_object_wait_connect (GstSRTObject * srtobject,
 
 failed:
 
+  g_mutex_lock (&srtobject->sock_lock);
+  gst_srt_object_stop_sender (srtobject);
+  g_mutex_unlock (&srtobject->sock_lock);
+
   if (srtobject->listener_poll_id != SRT_ERROR) {
     srt_epoll_release (srtobject->listener_poll_id);
   }
@@ -1429,6 +1755,8 @@ gst_srt_object_close (GstSRTObject * srtobject)
     g_mutex_lock (&srtobject->sock_lock);
   }
 
+  gst_srt_object_stop_sender (srtobject);
+
   if (srtobject->listener_sock != SRT_INVALID_SOCK) {
     GST_DEBUG_OBJECT (srtobject->element, "Closing SRT listener socket (0x%x)",
         srtobject->listener_sock);
@@ -1590,6 +1918,40 @@ gst_srt_object_read (GstSRTObject * srtobject,
   return len;
 }
 
+/* Reads the next message if one is available already, without waiting.
+ * Returns 0 otherwise, errors are left for gst_srt_object_read() to handle. */
+gssize
+gst_srt_object_read_available (GstSRTObject * srtobject,
+    guint8 * data, gsize size, SRT_MSGCTRL * mctrl)
+{
+  SRTSOCKET sock;
+  gint len;
+
+  g_mutex_lock (&srtobject->sock_lock);
+  sock = srtobject->sock;
+  if (sock == SRT_INVALID_SOCK && srtobject->callers) {
+    SRTCaller *caller = srtobject->callers->data;
+    sock = caller->sock;
+  }
+  g_mutex_unlock (&srtobject->sock_lock);
+
+  if (sock == SRT_INVALID_SOCK)
+    return 0;
+
+  srt_msgctrl_init (mctrl);
+  len = srt_recvmsg2 (sock, (char *) (data), size, mctrl);
+
+  if (len == SRT_ERROR) {
+    if (srt_getlasterror (NULL) != SRT_EASYNCRCV) {
+      GST_DEBUG_OBJECT (srtobject->element, "Failed to receive: %s",
+          srt_getlasterror_str ());
+    }
+    return 0;
+  }
+
+  return len;
+}
+
 void
 gst_srt_object_wakeup (GstSRTObject * srtobject, GCancellable * cancellable)
 {
@@ -1665,21 +2027,23 @@ gst_srt_object_send_headers (GstSRTObject * srtobject, SRTSOCKET sock,
   return TRUE;
 }
 
+/* Only queues the buffer for the callers, the sender thread sends it out so
+ * that a congested caller does not hold back the others */
 static gssize
 gst_srt_object_write_to_callers (GstSRTObject * srtobject,
     GstBufferList * headers,
-    const GstMapInfo * mapinfo, GCancellable * cancellable, GError ** error)
+    GstBuffer * buffer, GCancellable * cancellable, GError ** error)
 {
   GList *callers;
+  guint queue_size;
+
+  GST_OBJECT_LOCK (srtobject->element);
+  queue_size = srtobject->caller_queue_size;
+  GST_OBJECT_UNLOCK (srtobject->element);
 
   g_mutex_lock (&srtobject->sock_lock);
   callers = srtobject->callers;
   while (callers != NULL) {
-    gssize len = 0;
-    const guint8 *msg = mapinfo->data;
-    gint sent;
-    gint payload_size, optlen = sizeof (payload_size);
-
     SRTCaller *caller = callers->data;
     callers = callers->next;
 
@@ -1688,40 +2052,27 @@ gst_srt_object_write_to_callers (GstSRTObject * srtobject,
     }
 
     if (!caller->sent_headers) {
-      if (!gst_srt_object_send_headers (srtobject, caller->sock, -1,
-              -1, headers, cancellable)) {
-        goto err;
-      }
-      caller->sent_headers = TRUE;
-    }
+      guint i, size = headers ? gst_buffer_list_length (headers) : 0;
 
-    if (srt_getsockflag (caller->sock, SRTO_PAYLOADSIZE, &payload_size,
-            &optlen)) {
-      GST_WARNING_OBJECT (srtobject->element, "%s", srt_getlasterror_str ());
-      goto err;
-    }
+      GST_DEBUG_OBJECT (srtobject->element,
+          "Queueing %u stream headers for caller %d", size, caller->sock);
 
-    while (len < mapinfo->size) {
-      gint rest = MIN (mapinfo->size - len, payload_size);
-      sent = srt_sendmsg2 (caller->sock, (char *) (msg + len), rest, 0);
-      if (sent < 0) {
-        GST_WARNING_OBJECT (srtobject->element, "Dropping caller %d: %s",
-            caller->sock, srt_getlasterror_str ());
-        goto err;
-      }
-      len += sent;
+      for (i = 0; i < size; i++)
+        srt_caller_push (caller, gst_buffer_list_get (headers, i), TRUE);
+      caller->sent_headers = TRUE;
     }
 
-    continue;
+    if (!srt_caller_make_room (srtobject, caller, queue_size)) {
+      gst_srt_object_remove_caller (srtobject, caller);
+      continue;
+    }
 
-  err:
-    srtobject->callers = g_list_remove (srtobject->callers, caller);
-    srt_caller_signal_removed (caller, srtobject);
-    srt_caller_free (caller);
+    srt_caller_push (caller, buffer, FALSE);
+    srt_caller_set_pending (srtobject, caller, TRUE);
   }
 
   g_mutex_unlock (&srtobject->sock_lock);
-  return mapinfo->size;
+  return gst_buffer_get_size (buffer);
 
 cancelled:
   g_mutex_unlock (&srtobject->sock_lock);
@@ -1820,7 +2171,7 @@ gst_srt_object_write_one (GstSRTObject * srtobject,
 gssize
 gst_srt_object_write (GstSRTObject * srtobject,
     GstBufferList * headers,
-    const GstMapInfo * mapinfo, GCancellable * cancellable, GError ** error)
+    GstBuffer * buffer, GCancellable * cancellable, GError ** error)
 {
   gssize len = 0;
   GstSRTConnectionMode connection_mode = GST_SRT_CONNECTION_MODE_NONE;
@@ -1842,12 +2193,22 @@ gst_srt_object_write (GstSRTObject * srtobject,
         return -1;
     }
     len =
-        gst_srt_object_write_to_callers (srtobject, headers, mapinfo,
+        gst_srt_object_write_to_callers (srtobject, headers, buffer,
         cancellable, error);
   } else {
+    GstMapInfo mapinfo;
+
+    if (!gst_buffer_map (buffer, &mapinfo, GST_MAP_READ)) {
+      g_set_error (error, GST_RESOURCE_ERROR, GST_RESOURCE_ERROR_READ,
+          "Could not map the input stream");
+      return -1;
+    }
+
     len =
-        gst_srt_object_write_one (srtobject, headers, mapinfo, cancellable,
+        gst_srt_object_write_one (srtobject, headers, &mapinfo, cancellable,
         error);
+
+    gst_buffer_unmap (buffer, &mapinfo);
   }
 
   return len;
@@ -1949,6 +2310,21 @@ gst_srt_object_get_stats (GstSRTObject * srtobject)
       gst_structure_set (tmp, "caller-address", G_TYPE_SOCKET_ADDRESS,
           caller->sockaddr, NULL);
 
+      if (is_sender) {
+        gst_structure_set (tmp,
+            /* buffers and bytes waiting for the sender thread */
+            "queue-depth", G_TYPE_UINT,
+            gst_queue_array_get_length (caller->queue),
+            "queue-bytes", G_TYPE_UINT64, caller->queued_bytes,
+            /* time the last sent buffer spent in the queue */
+            "queue-latency-us", G_TYPE_INT64, caller->queue_latency,
+            "max-queue-latency-us", G_TYPE_INT64, caller->max_queue_latency,
+            /* buffers dropped because the queue was full */
+            "buffers-dropped", G_TYPE_UINT64, caller->dropped,
+            "drop-policy", GST_TYPE_SRT_CALLER_DROP_POLICY,
+            caller->drop_policy, NULL);
+      }
+
       g_value_array_append (callers_stats, NULL);
       v = g_value_array_get_nth (callers_stats, callers_stats->n_values - 1);
       g_value_init (v, GST_TYPE_STRUCTURE);
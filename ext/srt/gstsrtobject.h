@@ -42,6 +42,35 @@ G_BEGIN_DECLS
 #define GST_SRT_DEFAULT_LATENCY 125
 #define GST_SRT_DEFAULT_MSG_SIZE 1316
 #define GST_SRT_DEFAULT_WAIT_FOR_CONNECTION (TRUE)
+#define GST_SRT_DEFAULT_CALLER_QUEUE_SIZE 256
+#define GST_SRT_DEFAULT_CALLER_DROP_POLICY GST_SRT_CALLER_DROP_POLICY_DROP_OLDEST
+#define GST_SRT_DEFAULT_BATCH_SIZE 1
+#define GST_SRT_DEFAULT_AGGREGATE_SIZE 0
+
+/* Property ids of srtsrc and srtsink. The common properties are installed
+ * by gst_srt_object_install_properties_helper(), the element specific ones
+ * by the elements themselves, and all are handled by the property helpers */
+enum
+{
+  PROP_URI = 1,
+  PROP_MODE,
+  PROP_LOCALADDRESS,
+  PROP_LOCALPORT,
+  PROP_PASSPHRASE,
+  PROP_PBKEYLEN,
+  PROP_POLL_TIMEOUT,
+  PROP_LATENCY,
+  PROP_MSG_SIZE,
+  PROP_STATS,
+  PROP_WAIT_FOR_CONNECTION,
+  PROP_STREAMID,
+  PROP_AUTHENTICATION,
+  PROP_CALLER_QUEUE_SIZE,
+  PROP_CALLER_DROP_POLICY,
+  PROP_BATCH_SIZE,
+  PROP_AGGREGATE_SIZE,
+  PROP_LAST
+};
 
 typedef struct _GstSRTObject GstSRTObject;
 
@@ -68,6 +97,19 @@ struct _GstSRTObject
 
   GList                        *callers;
 
+  /* Services the send queues of the callers in listener mode */
+  GThread                      *sender_thread;
+  GCond                         sender_cond;
+  gint                          sender_poll_id;
+  gboolean                      sender_running;
+  guint                         n_pending_callers;
+
+  guint                         caller_queue_size;
+  GstSRTCallerDropPolicy        caller_drop_policy;
+
+  guint                         batch_size;
+  guint                         aggregate_size;
+
   gboolean                     wait_for_connection;
 
   gboolean                     authentication;
@@ -103,9 +145,13 @@ gssize          gst_srt_object_read     (GstSRTObject * srtobject,
                                          GError **err,
 					 SRT_MSGCTRL *mctrl);
 
+gssize          gst_srt_object_read_available (GstSRTObject * srtobject,
+                                         guint8 *data, gsize size,
+                                         SRT_MSGCTRL *mctrl);
+
 gssize          gst_srt_object_write    (GstSRTObject * srtobject,
                                          GstBufferList * headers,
-                                         const GstMapInfo * mapinfo,
+                                         GstBuffer * buffer,
                                          GCancellable *cancellable,
                                          GError **err);
 
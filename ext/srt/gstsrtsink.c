@@ -180,7 +180,6 @@ gst_srt_sink_render (GstBaseSink * sink, GstBuffer * buffer)
 {
   GstSRTSink *self = GST_SRT_SINK (sink);
   GstFlowReturn ret = GST_FLOW_OK;
-  GstMapInfo info;
   GError *error = NULL;
 
   if (g_cancellable_is_cancelled (self->cancellable)) {
@@ -193,13 +192,7 @@ gst_srt_sink_render (GstBaseSink * sink, GstBuffer * buffer)
     return GST_FLOW_OK;
   }
 
-  if (!gst_buffer_map (buffer, &info, GST_MAP_READ)) {
-    GST_ELEMENT_ERROR (self, RESOURCE, READ,
-        ("Could not map the input stream"), (NULL));
-    return GST_FLOW_ERROR;
-  }
-
-  if (gst_srt_object_write (self->srtobject, self->headers, &info,
+  if (gst_srt_object_write (self->srtobject, self->headers, buffer,
           self->cancellable, &error) < 0) {
     GST_ELEMENT_ERROR (self, RESOURCE, WRITE,
         ("Failed to write to SRT socket: %s",
@@ -208,8 +201,6 @@ gst_srt_sink_render (GstBaseSink * sink, GstBuffer * buffer)
     ret = GST_FLOW_ERROR;
   }
 
-  gst_buffer_unmap (buffer, &info);
-
   GST_TRACE_OBJECT (self, "sending buffer %p, offset %"
       G_GINT64_FORMAT ", offset_end %" G_GINT64_FORMAT
       ", timestamp %" GST_TIME_FORMAT ", duration %" GST_TIME_FORMAT
@@ -369,6 +360,39 @@ gst_srt_sink_class_init (GstSRTSinkClass * klass)
 
   gst_srt_object_install_properties_helper (gobject_class);
 
+  /**
+   * GstSRTSink:caller-queue-size:
+   *
+   * The number of buffers queued for each caller in listener mode. Callers
+   * are served by a separate thread, so that a slow caller does not hold
+   * back the stream or the other callers. What happens when the queue of a
+   * caller is full is decided by #GstSRTSink:caller-drop-policy. The stream
+   * headers and the buffer being sent are not counted, as they are never
+   * dropped.
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (gobject_class, PROP_CALLER_QUEUE_SIZE,
+      g_param_spec_uint ("caller-queue-size", "Caller queue size",
+          "Maximum number of buffers queued for each caller", 1, G_MAXINT,
+          GST_SRT_DEFAULT_CALLER_QUEUE_SIZE,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstSRTSink:caller-drop-policy:
+   *
+   * What to do when the queue of a caller is full in listener mode. The
+   * policy is applied to the callers connecting after it is set.
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (gobject_class, PROP_CALLER_DROP_POLICY,
+      g_param_spec_enum ("caller-drop-policy", "Caller drop policy",
+          "What to do when the queue of a caller is full",
+          GST_TYPE_SRT_CALLER_DROP_POLICY, GST_SRT_DEFAULT_CALLER_DROP_POLICY,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+  gst_type_mark_as_plugin_api (GST_TYPE_SRT_CALLER_DROP_POLICY, 0);
+
   gst_element_class_add_static_pad_template (gstelement_class, &sink_template);
   gst_element_class_set_metadata (gstelement_class,
       "SRT sink", "Sink/Network",
@@ -39,6 +39,13 @@
  * gst-launch-1.0 -v srtclientsrc uri="srt://192.168.1.10:7001?mode=rendez-vous" ! fakesink
  * ]| This pipeline shows how to connect SRT server by setting #GstSRTSrc:uri property and using the rendez-vous mode.
  *
+ * |[
+ * gst-launch-1.0 -v srtsrc uri="srt://127.0.0.1:7001" batch-size=64 aggregate-size=13300 ! tsdemux ! fakesink
+ * ]| This pipeline reads all the pending SRT messages at once and packs them
+ * into buffers of ten 1316 bytes messages. The aggregate size leaves room for
+ * a message of the largest SRT live payload size, see
+ * #GstSRTSrc:aggregate-size.
+ *
  */
 
 #ifdef HAVE_CONFIG_H
@@ -140,6 +147,73 @@ gst_srt_src_stop (GstBaseSrc * bsrc)
   return TRUE;
 }
 
+/* Returns TRUE if messages were lost before the one described by @mctrl */
+static gboolean
+gst_srt_src_check_discont (GstSRTSrc * self, const SRT_MSGCTRL * mctrl)
+{
+  gboolean discont = FALSE;
+
+  /* Detect discontinuities */
+  if (mctrl->pktseq != self->next_pktseq) {
+    GST_WARNING_OBJECT (self, "discont detected %d (expected: %d)",
+        mctrl->pktseq, self->next_pktseq);
+    discont = TRUE;
+  }
+  /* pktseq is a 31bit field */
+  self->next_pktseq = (mctrl->pktseq + 1) % G_MAXINT32;
+
+  return discont;
+}
+
+/* Returns the running time at which the message described by @mctrl was
+ * captured on the sender side */
+static GstClockTime
+gst_srt_src_get_message_time (GstSRTSrc * self, GstClockTime capture_time,
+    GstClockTime base_time, int64_t srt_time, const SRT_MSGCTRL * mctrl)
+{
+  GstClockTimeDiff delay;
+
+  /* 0 means we do not have a srctime */
+  if (mctrl->srctime != 0)
+    delay = (srt_time - mctrl->srctime) * GST_USECOND;
+  else
+    delay = 0;
+
+  GST_LOG_OBJECT (self, "delay: %" GST_STIME_FORMAT, GST_STIME_ARGS (delay));
+
+  if (delay < 0) {
+    GST_WARNING_OBJECT (self,
+        "Calculated SRT delay %" GST_STIME_FORMAT " is negative, clamping to 0",
+        GST_STIME_ARGS (delay));
+    delay = 0;
+  }
+
+  /* Subtract the base_time (since the pipeline started) ... */
+  if (capture_time > base_time)
+    capture_time -= base_time;
+  else
+    capture_time = 0;
+  /* And adjust by the delay */
+  if (capture_time > delay)
+    capture_time -= delay;
+  else
+    capture_time = 0;
+
+  return capture_time;
+}
+
+static int64_t
+gst_srt_src_get_srt_time (void)
+{
+#if SRT_VERSION_VALUE >= 0x10402
+  /* Use SRT clock value if available (SRT > 1.4.2) */
+  return srt_time_now ();
+#else
+  /* Else use the unix epoch monotonic clock */
+  return g_get_real_time ();
+#endif
+}
+
 static GstFlowReturn
 gst_srt_src_fill (GstPushSrc * src, GstBuffer * outbuf)
 {
@@ -151,7 +225,6 @@ gst_srt_src_fill (GstPushSrc * src, GstBuffer * outbuf)
   GstClock *clock;
   GstClockTime base_time;
   GstClockTime capture_time;
-  GstClockTimeDiff delay;
   int64_t srt_time;
   SRT_MSGCTRL mctrl;
 
@@ -180,13 +253,7 @@ gst_srt_src_fill (GstPushSrc * src, GstBuffer * outbuf)
 
   /* Capture clock values ASAP */
   capture_time = gst_clock_get_time (clock);
-#if SRT_VERSION_VALUE >= 0x10402
-  /* Use SRT clock value if available (SRT > 1.4.2) */
-  srt_time = srt_time_now ();
-#else
-  /* Else use the unix epoch monotonic clock */
-  srt_time = g_get_real_time ();
-#endif
+  srt_time = gst_srt_src_get_srt_time ();
   gst_object_unref (clock);
 
   gst_buffer_unmap (outbuf, &info);
@@ -210,41 +277,11 @@ gst_srt_src_fill (GstPushSrc * src, GstBuffer * outbuf)
     goto out;
   }
 
-  /* Detect discontinuities */
-  if (mctrl.pktseq != self->next_pktseq) {
-    GST_WARNING_OBJECT (src, "discont detected %d (expected: %d)",
-        mctrl.pktseq, self->next_pktseq);
+  if (gst_srt_src_check_discont (self, &mctrl))
     GST_BUFFER_FLAG_SET (outbuf, GST_BUFFER_FLAG_DISCONT);
-  }
-  /* pktseq is a 31bit field */
-  self->next_pktseq = (mctrl.pktseq + 1) % G_MAXINT32;
 
-  /* 0 means we do not have a srctime */
-  if (mctrl.srctime != 0)
-    delay = (srt_time - mctrl.srctime) * GST_USECOND;
-  else
-    delay = 0;
-
-  GST_LOG_OBJECT (src, "delay: %" GST_STIME_FORMAT, GST_STIME_ARGS (delay));
-
-  if (delay < 0) {
-    GST_WARNING_OBJECT (src,
-        "Calculated SRT delay %" GST_STIME_FORMAT " is negative, clamping to 0",
-        GST_STIME_ARGS (delay));
-    delay = 0;
-  }
-
-  /* Subtract the base_time (since the pipeline started) ... */
-  if (capture_time > base_time)
-    capture_time -= base_time;
-  else
-    capture_time = 0;
-  /* And adjust by the delay */
-  if (capture_time > delay)
-    capture_time -= delay;
-  else
-    capture_time = 0;
-  GST_BUFFER_TIMESTAMP (outbuf) = capture_time;
+  GST_BUFFER_TIMESTAMP (outbuf) = gst_srt_src_get_message_time (self,
+      capture_time, base_time, srt_time, &mctrl);
 
   gst_buffer_resize (outbuf, 0, recv_len);
 
@@ -261,6 +298,215 @@ out:
   return ret;
 }
 
+/* Reads up to @batch_size messages, waiting only for the first one. With
+ * @aggregate_size the messages are packed into buffers of that size. */
+static GstFlowReturn
+gst_srt_src_create_batch (GstSRTSrc * self, guint batch_size,
+    guint aggregate_size, guint blocksize, GstBuffer ** outbuf)
+{
+  GstBaseSrc *bsrc = GST_BASE_SRC (self);
+  GstBaseSrcClass *bclass = GST_BASE_SRC_GET_CLASS (self);
+  GstFlowReturn ret = GST_FLOW_OK;
+  GstBufferList *list;
+  GstBuffer *buffer = NULL;
+  GstMapInfo info;
+  GError *err = NULL;
+  GstClock *clock;
+  GstClockTime base_time;
+  GstClockTime capture_time = 0;
+  int64_t srt_time = 0;
+  gsize offset = 0;
+  guint size, n;
+
+  /* Get clock and values */
+  clock = gst_element_get_clock (GST_ELEMENT (self));
+  if (!clock) {
+    GST_DEBUG_OBJECT (self, "Clock missing, flushing");
+    return GST_FLOW_FLUSHING;
+  }
+
+  base_time = gst_element_get_base_time (GST_ELEMENT (self));
+
+  size = aggregate_size ? MAX (aggregate_size, SRT_LIVE_MAX_PLSIZE) : blocksize;
+  list = gst_buffer_list_new_sized (aggregate_size ? 1 : batch_size);
+
+  for (n = 0; n < batch_size; n++) {
+    SRT_MSGCTRL mctrl;
+    gssize recv_len;
+
+    if (buffer == NULL) {
+      ret = bclass->alloc (bsrc, -1, size, &buffer);
+      if (ret != GST_FLOW_OK)
+        break;
+
+      if (!gst_buffer_map (buffer, &info, GST_MAP_WRITE)) {
+        GST_ELEMENT_ERROR (self, RESOURCE, READ,
+            ("Could not map the buffer for writing "), (NULL));
+        gst_clear_buffer (&buffer);
+        ret = GST_FLOW_ERROR;
+        break;
+      }
+      offset = 0;
+    }
+
+    if (n == 0) {
+      recv_len = gst_srt_object_read (self->srtobject, info.data,
+          info.size, self->cancellable, &err, &mctrl);
+
+      /* Capture clock values ASAP, the other messages of the batch were
+       * already waiting by then */
+      capture_time = gst_clock_get_time (clock);
+      srt_time = gst_srt_src_get_srt_time ();
+    } else {
+      recv_len = gst_srt_object_read_available (self->srtobject,
+          info.data + offset, info.size - offset, &mctrl);
+    }
+
+    if (g_cancellable_is_cancelled (self->cancellable)) {
+      ret = GST_FLOW_FLUSHING;
+      break;
+    }
+
+    if (recv_len < 0) {
+      GST_ELEMENT_ERROR (self, RESOURCE, READ, (NULL), ("%s", err->message));
+      g_clear_error (&err);
+      ret = GST_FLOW_ERROR;
+      break;
+    } else if (recv_len == 0) {
+      /* Nothing more to read for now */
+      if (n == 0)
+        ret = GST_FLOW_EOS;
+      break;
+    }
+
+    GST_LOG_OBJECT (self,
+        "recv_len:%" G_GSIZE_FORMAT " pktseq:%d msgno:%d srctime:%"
+        G_GINT64_FORMAT, recv_len, mctrl.pktseq, mctrl.msgno, mctrl.srctime);
+
+    if (gst_srt_src_check_discont (self, &mctrl))
+      GST_BUFFER_FLAG_SET (buffer, GST_BUFFER_FLAG_DISCONT);
+
+    if (offset == 0) {
+      GST_BUFFER_TIMESTAMP (buffer) = gst_srt_src_get_message_time (self,
+          capture_time, base_time, srt_time, &mctrl);
+    }
+    offset += recv_len;
+
+    /* Keep packing while the largest possible message still fits */
+    if (aggregate_size == 0 || info.size - offset < SRT_LIVE_MAX_PLSIZE) {
+      gst_buffer_unmap (buffer, &info);
+      gst_buffer_resize (buffer, 0, offset);
+      gst_buffer_list_add (list, g_steal_pointer (&buffer));
+    }
+  }
+
+  gst_object_unref (clock);
+
+  if (buffer) {
+    gst_buffer_unmap (buffer, &info);
+    if (offset > 0 && ret == GST_FLOW_OK) {
+      gst_buffer_resize (buffer, 0, offset);
+      gst_buffer_list_add (list, g_steal_pointer (&buffer));
+    } else {
+      gst_buffer_unref (buffer);
+    }
+  }
+
+  if (ret != GST_FLOW_OK) {
+    gst_buffer_list_unref (list);
+    return ret;
+  }
+
+  GST_LOG_OBJECT (self, "read %u messages into %u buffers", n,
+      gst_buffer_list_length (list));
+
+  if (gst_buffer_list_length (list) == 1) {
+    *outbuf = gst_buffer_ref (gst_buffer_list_get (list, 0));
+    gst_buffer_list_unref (list);
+  } else {
+    gst_base_src_submit_buffer_list (bsrc, list);
+    *outbuf = NULL;
+  }
+
+  return GST_FLOW_OK;
+}
+
+static GstFlowReturn
+gst_srt_src_create (GstBaseSrc * bsrc, guint64 offset, guint length,
+    GstBuffer ** outbuf)
+{
+  GstSRTSrc *self = GST_SRT_SRC (bsrc);
+  guint batch_size, aggregate_size;
+
+  if (g_cancellable_is_cancelled (self->cancellable))
+    return GST_FLOW_FLUSHING;
+
+  GST_OBJECT_LOCK (self);
+  batch_size = self->srtobject->batch_size;
+  aggregate_size = self->srtobject->aggregate_size;
+  GST_OBJECT_UNLOCK (self);
+
+  if (batch_size <= 1)
+    return GST_BASE_SRC_CLASS (parent_class)->create (bsrc, offset, length,
+        outbuf);
+
+  return gst_srt_src_create_batch (self, batch_size, aggregate_size, length,
+      outbuf);
+}
+
+static gboolean
+gst_srt_src_decide_allocation (GstBaseSrc * bsrc, GstQuery * query)
+{
+  GstSRTSrc *self = GST_SRT_SRC (bsrc);
+  GstBufferPool *pool = NULL;
+  GstStructure *config;
+  GstCaps *caps;
+  guint size = 0, min = 0, max = 0;
+  guint buffer_size;
+
+  if (!GST_BASE_SRC_CLASS (parent_class)->decide_allocation (bsrc, query))
+    return FALSE;
+
+  buffer_size = gst_base_src_get_blocksize (bsrc);
+  GST_OBJECT_LOCK (self);
+  if (self->srtobject->batch_size > 1 && self->srtobject->aggregate_size > 0)
+    buffer_size = MAX (self->srtobject->aggregate_size, SRT_LIVE_MAX_PLSIZE);
+  GST_OBJECT_UNLOCK (self);
+
+  if (gst_query_get_n_allocation_pools (query) > 0)
+    gst_query_parse_nth_allocation_pool (query, 0, &pool, &size, &min, &max);
+
+  if (pool && size >= buffer_size) {
+    gst_object_unref (pool);
+    return TRUE;
+  }
+
+  /* Receive into recycled buffers rather than allocating one per message */
+  gst_clear_object (&pool);
+  pool = gst_buffer_pool_new ();
+  gst_query_parse_allocation (query, &caps, NULL);
+
+  config = gst_buffer_pool_get_config (pool);
+  gst_buffer_pool_config_set_params (config, caps, buffer_size, min, max);
+  if (!gst_buffer_pool_set_config (pool, config)) {
+    GST_WARNING_OBJECT (self, "Failed to configure the buffer pool");
+    gst_object_unref (pool);
+    return FALSE;
+  }
+
+  GST_DEBUG_OBJECT (self, "Using our own pool of %u bytes buffers",
+      buffer_size);
+
+  if (gst_query_get_n_allocation_pools (query) > 0)
+    gst_query_set_nth_allocation_pool (query, 0, pool, buffer_size, min, max);
+  else
+    gst_query_add_allocation_pool (query, pool, buffer_size, min, max);
+
+  gst_object_unref (pool);
+
+  return TRUE;
+}
+
 static void
 gst_srt_src_init (GstSRTSrc * self)
 {
@@ -426,6 +672,41 @@ gst_srt_src_class_init (GstSRTSrcClass * klass)
 
   gst_srt_object_install_properties_helper (gobject_class);
 
+  /**
+   * GstSRTSrc:batch-size:
+   *
+   * The maximum number of SRT messages read each time the socket wakes up.
+   * When more than one message is available, they are pushed downstream
+   * together in a #GstBufferList.
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (gobject_class, PROP_BATCH_SIZE,
+      g_param_spec_uint ("batch-size", "Batch size",
+          "Maximum number of messages read per wakeup", 1, 1024,
+          GST_SRT_DEFAULT_BATCH_SIZE,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstSRTSrc:aggregate-size:
+   *
+   * When not 0, the messages read in one batch are packed into buffers of up
+   * to this many bytes instead of one buffer per message. Buffers only ever
+   * contain whole messages, so MPEG-TS packets stay aligned.
+   *
+   * A message is only added to a buffer while a message of the largest SRT
+   * live payload size, 1456 bytes, would still fit in it. To pack N messages
+   * of S bytes per buffer, use N * S + 1456 - S.
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (gobject_class, PROP_AGGREGATE_SIZE,
+      g_param_spec_uint ("aggregate-size", "Aggregate size",
+          "Pack the messages of a batch into buffers of this size in bytes "
+          "(0 = one buffer per message)", 0, G_MAXINT,
+          GST_SRT_DEFAULT_AGGREGATE_SIZE,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
   gst_element_class_add_static_pad_template (gstelement_class, &src_template);
   gst_element_class_set_metadata (gstelement_class,
       "SRT source", "Source/Network",
@@ -437,6 +718,9 @@ gst_srt_src_class_init (GstSRTSrcClass * klass)
   gstbasesrc_class->unlock = GST_DEBUG_FUNCPTR (gst_srt_src_unlock);
   gstbasesrc_class->unlock_stop = GST_DEBUG_FUNCPTR (gst_srt_src_unlock_stop);
   gstbasesrc_class->query = GST_DEBUG_FUNCPTR (gst_srt_src_query);
+  gstbasesrc_class->create = GST_DEBUG_FUNCPTR (gst_srt_src_create);
+  gstbasesrc_class->decide_allocation =
+      GST_DEBUG_FUNCPTR (gst_srt_src_decide_allocation);
 
   gstpushsrc_class->fill = GST_DEBUG_FUNCPTR (gst_srt_src_fill);
 }
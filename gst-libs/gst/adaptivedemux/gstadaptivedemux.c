@@ -131,6 +131,10 @@ GST_DEBUG_CATEGORY (adaptivedemux_debug);
 #define DEFAULT_BITRATE_LIMIT 0.8f
 #define SRC_QUEUE_MAX_BYTES 20 * 1024 * 1024    /* For safety. Large enough to hold a segment. */
 #define NUM_LOOKBACK_FRAGMENTS 3
+#define DEFAULT_PREFETCH_FRAGMENTS 0
+#define DEFAULT_MAX_CONCURRENT_DOWNLOADS 4
+#define DEFAULT_PREFETCH_MAX_BYTES (32 * 1024 * 1024)
+#define DEFAULT_ABR_POLICY GST_ADAPTIVE_DEMUX_ABR_POLICY_MOVING_AVERAGE
 
 #define GST_MANIFEST_GET_LOCK(d) (&(GST_ADAPTIVE_DEMUX_CAST(d)->priv->manifest_lock))
 #define GST_MANIFEST_LOCK(d) G_STMT_START { \
@@ -157,6 +161,10 @@ enum
   PROP_0,
   PROP_CONNECTION_SPEED,
   PROP_BITRATE_LIMIT,
+  PROP_PREFETCH_FRAGMENTS,
+  PROP_MAX_CONCURRENT_DOWNLOADS,
+  PROP_PREFETCH_MAX_BYTES,
+  PROP_ABR_POLICY,
   PROP_LAST
 };
 
@@ -175,6 +183,7 @@ struct _GstAdaptiveDemuxPrivate
   GMutex updates_timed_lock;
   GCond updates_timed_cond;     /* protected by updates_timed_lock */
   gboolean stop_updates_task;   /* protected by updates_timed_lock */
+  GThread *updates_thread;      /* protected by manifest_lock */
 
   /* used only from updates_task, no need to protect it */
   gint update_failed_count;
@@ -207,8 +216,55 @@ struct _GstAdaptiveDemuxPrivate
   GMutex segment_lock;
 
   GstClockTime qos_earliest_time;
+
+  /* Fragment prefetching. The pool is shared by all streams so that
+   * max_concurrent_downloads is a global limit */
+  guint prefetch_fragments;     /* protected by manifest_lock */
+  guint max_concurrent_downloads;       /* protected by manifest_lock */
+  guint64 prefetch_max_bytes;   /* protected by manifest_lock */
+  GThreadPool *prefetch_pool;   /* protected by manifest_lock */
+  GMutex prefetch_lock;
+  GCond prefetch_cond;
+  GList *prefetch_entries;      /* protected by prefetch_lock */
+  guint64 prefetch_bytes;       /* protected by prefetch_lock */
+
+  GstAdaptiveDemuxAbrPolicy abr_policy; /* protected by manifest_lock */
 };
 
+/* Data received by a prefetch download */
+typedef struct _GstAdaptiveDemuxPrefetchChunk
+{
+  GstBuffer *buffer;
+  guint64 arrival_time;         /* gst_util_get_timestamp() */
+} GstAdaptiveDemuxPrefetchChunk;
+
+/* An upcoming fragment downloaded ahead of time by the prefetch pool. The
+ * received data is queued as it arrives so that the stream can start
+ * pushing it before the download is complete */
+typedef struct _GstAdaptiveDemuxPrefetch
+{
+  gint ref_count;               /* protected by prefetch_lock */
+
+  GstAdaptiveDemux *demux;
+  /* only used for lookups, the stream cancels its entries before being freed */
+  GstAdaptiveDemuxStream *stream;
+
+  gchar *uri;
+  gint64 range_start;
+  gint64 range_end;
+  guint64 max_bytes;
+
+  GstUriDownloader *downloader; /* protected by prefetch_lock */
+  GQueue chunks;                /* protected by prefetch_lock */
+  guint64 queued_bytes;         /* protected by prefetch_lock */
+  guint64 download_start_time;  /* protected by prefetch_lock */
+  guint64 download_stop_time;   /* protected by prefetch_lock */
+  GError *error;                /* protected by prefetch_lock */
+  gboolean done;                /* protected by prefetch_lock */
+  gboolean cancelled;           /* protected by prefetch_lock */
+  gboolean taken;               /* protected by prefetch_lock */
+} GstAdaptiveDemuxPrefetch;
+
 typedef struct _GstAdaptiveDemuxTimer
 {
   gint ref_count;
@@ -303,6 +359,9 @@ gst_adaptive_demux_wait_until (GstClock * clock, GCond * cond, GMutex * mutex,
     GstClockTime end_time);
 static gboolean gst_adaptive_demux_clock_callback (GstClock * clock,
     GstClockTime time, GstClockID id, gpointer user_data);
+static void gst_adaptive_demux_cancel_prefetch (GstAdaptiveDemux * demux,
+    GstAdaptiveDemuxStream * stream);
+static void gst_adaptive_demux_free_prefetch_pool (GstAdaptiveDemux * demux);
 static gboolean
 gst_adaptive_demux_requires_periodical_playlist_update_default (GstAdaptiveDemux
     * demux);
@@ -363,6 +422,34 @@ gst_adaptive_demux_set_property (GObject * object, guint prop_id,
     case PROP_BITRATE_LIMIT:
       demux->bitrate_limit = g_value_get_float (value);
       break;
+    case PROP_PREFETCH_FRAGMENTS:
+      demux->priv->prefetch_fragments = g_value_get_uint (value);
+      break;
+    case PROP_MAX_CONCURRENT_DOWNLOADS:
+      demux->priv->max_concurrent_downloads = g_value_get_uint (value);
+      if (demux->priv->prefetch_pool)
+        g_thread_pool_set_max_threads (demux->priv->prefetch_pool,
+            demux->priv->max_concurrent_downloads, NULL);
+      break;
+    case PROP_PREFETCH_MAX_BYTES:
+      demux->priv->prefetch_max_bytes = g_value_get_uint64 (value);
+      break;
+    case PROP_ABR_POLICY:{
+      GList *lists[] =
+          { demux->streams, demux->prepared_streams, demux->next_streams };
+      GList *iter;
+      guint i;
+
+      demux->priv->abr_policy = g_value_get_enum (value);
+      for (i = 0; i < G_N_ELEMENTS (lists); i++) {
+        for (iter = lists[i]; iter; iter = g_list_next (iter)) {
+          GstAdaptiveDemuxStream *stream = iter->data;
+          gst_adaptive_demux_abr_set_policy (stream->abr,
+              demux->priv->abr_policy);
+        }
+      }
+      break;
+    }
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -387,6 +474,18 @@ gst_adaptive_demux_get_property (GObject * object, guint prop_id,
     case PROP_BITRATE_LIMIT:
       g_value_set_float (value, demux->bitrate_limit);
       break;
+    case PROP_PREFETCH_FRAGMENTS:
+      g_value_set_uint (value, demux->priv->prefetch_fragments);
+      break;
+    case PROP_MAX_CONCURRENT_DOWNLOADS:
+      g_value_set_uint (value, demux->priv->max_concurrent_downloads);
+      break;
+    case PROP_PREFETCH_MAX_BYTES:
+      g_value_set_uint64 (value, demux->priv->prefetch_max_bytes);
+      break;
+    case PROP_ABR_POLICY:
+      g_value_set_enum (value, demux->priv->abr_policy);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -432,6 +531,70 @@ gst_adaptive_demux_class_init (GstAdaptiveDemuxClass * klass)
           0, 1, DEFAULT_BITRATE_LIMIT,
           G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
+  /**
+   * GstAdaptiveDemux:prefetch-fragments:
+   *
+   * Number of upcoming fragments of each stream to download ahead of time,
+   * concurrently with the current one. Only used if the subclass
+   * implements #GstAdaptiveDemuxClass.stream_peek_fragment().
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (gobject_class, PROP_PREFETCH_FRAGMENTS,
+      g_param_spec_uint ("prefetch-fragments", "Prefetch fragments",
+          "Number of upcoming fragments to download ahead per stream"
+          " (0 = disabled)", 0, 16, DEFAULT_PREFETCH_FRAGMENTS,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstAdaptiveDemux:max-concurrent-downloads:
+   *
+   * Maximum number of fragment prefetch downloads running at the same time,
+   * shared by all streams.
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (gobject_class,
+      PROP_MAX_CONCURRENT_DOWNLOADS,
+      g_param_spec_uint ("max-concurrent-downloads",
+          "Max concurrent downloads",
+          "Maximum number of concurrent prefetch downloads for all streams",
+          1, 32, DEFAULT_MAX_CONCURRENT_DOWNLOADS,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstAdaptiveDemux:prefetch-max-bytes:
+   *
+   * Maximum amount of prefetched data kept in memory for all streams.
+   * No new prefetch downloads are started while this is exceeded, and the
+   * running ones are paused until the data is consumed. The fragment a
+   * stream is currently pushing is not limited.
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (gobject_class, PROP_PREFETCH_MAX_BYTES,
+      g_param_spec_uint64 ("prefetch-max-bytes", "Prefetch max bytes",
+          "Maximum amount of prefetched data in bytes", 0, G_MAXUINT64,
+          DEFAULT_PREFETCH_MAX_BYTES,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstAdaptiveDemux:abr-policy:
+   *
+   * Algorithm used to choose the bitrate of the next fragments. The buffer
+   * based policies need the subclass to implement
+   * #GstAdaptiveDemuxClass.stream_get_bitrates() and fall back to the
+   * throughput otherwise. #GstAdaptiveDemux:connection-speed overrides all
+   * of them.
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (gobject_class, PROP_ABR_POLICY,
+      g_param_spec_enum ("abr-policy", "ABR policy",
+          "Algorithm used to choose the bitrate of the next fragments",
+          GST_TYPE_ADAPTIVE_DEMUX_ABR_POLICY, DEFAULT_ABR_POLICY,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
   gstelement_class->change_state = gst_adaptive_demux_change_state;
 
   gstbin_class->handle_message = gst_adaptive_demux_handle_message;
@@ -509,6 +672,9 @@ gst_adaptive_demux_init (GstAdaptiveDemux * demux,
   g_cond_init (&demux->priv->preroll_cond);
   g_mutex_init (&demux->priv->preroll_lock);
 
+  g_cond_init (&demux->priv->prefetch_cond);
+  g_mutex_init (&demux->priv->prefetch_lock);
+
   pad_template =
       gst_element_class_get_pad_template (GST_ELEMENT_CLASS (klass), "sink");
   g_return_if_fail (pad_template != NULL);
@@ -522,6 +688,10 @@ gst_adaptive_demux_init (GstAdaptiveDemux * demux,
   /* Properties */
   demux->bitrate_limit = DEFAULT_BITRATE_LIMIT;
   demux->connection_speed = DEFAULT_CONNECTION_SPEED;
+  demux->priv->prefetch_fragments = DEFAULT_PREFETCH_FRAGMENTS;
+  demux->priv->max_concurrent_downloads = DEFAULT_MAX_CONCURRENT_DOWNLOADS;
+  demux->priv->prefetch_max_bytes = DEFAULT_PREFETCH_MAX_BYTES;
+  demux->priv->abr_policy = DEFAULT_ABR_POLICY;
 
   gst_element_add_pad (GST_ELEMENT (demux), demux->sinkpad);
 }
@@ -554,6 +724,12 @@ gst_adaptive_demux_finalize (GObject * object)
   g_cond_clear (&demux->priv->preroll_cond);
   g_mutex_clear (&demux->priv->preroll_lock);
 
+  gst_adaptive_demux_cancel_prefetch (demux, NULL);
+  if (priv->prefetch_pool)
+    g_thread_pool_free (priv->prefetch_pool, FALSE, TRUE);
+  g_cond_clear (&demux->priv->prefetch_cond);
+  g_mutex_clear (&demux->priv->prefetch_lock);
+
   G_OBJECT_CLASS (parent_class)->finalize (object);
 }
 
@@ -788,6 +964,7 @@ gst_adaptive_demux_reset (GstAdaptiveDemux * demux)
   demux->priv->old_streams = NULL;
 
   gst_adaptive_demux_stop_tasks (demux, TRUE);
+  gst_adaptive_demux_free_prefetch_pool (demux);
 
   if (klass->reset)
     klass->reset (demux);
@@ -1284,6 +1461,9 @@ gst_adaptive_demux_expose_streams (GstAdaptiveDemux * demux)
       stream->replaced = TRUE;
       g_cond_signal (&stream->fragment_download_cond);
       g_mutex_unlock (&stream->fragment_download_lock);
+
+      /* wakes up the download task if it waits for a prefetch */
+      gst_adaptive_demux_cancel_prefetch (demux, stream);
     }
     gst_event_unref (eos);
 
@@ -1323,6 +1503,7 @@ gst_adaptive_demux_stream_new (GstAdaptiveDemux * demux, GstPad * pad)
   stream->demux = demux;
   stream->fragment_bitrates =
       g_malloc0 (sizeof (guint64) * NUM_LOOKBACK_FRAGMENTS);
+  stream->abr = gst_adaptive_demux_abr_new (demux->priv->abr_policy);
   gst_pad_set_element_private (pad, stream);
   stream->qos_earliest_time = GST_CLOCK_TIME_NONE;
 
@@ -1375,6 +1556,8 @@ gst_adaptive_demux_stream_free (GstAdaptiveDemuxStream * stream)
   if (klass->stream_free)
     klass->stream_free (stream);
 
+  gst_adaptive_demux_cancel_prefetch (demux, stream);
+
   g_clear_error (&stream->last_error);
   if (stream->download_task) {
     if (GST_TASK_STATE (stream->download_task) != GST_TASK_STOPPED) {
@@ -1439,6 +1622,7 @@ gst_adaptive_demux_stream_free (GstAdaptiveDemuxStream * stream)
   g_cond_clear (&stream->fragment_download_cond);
   g_mutex_clear (&stream->fragment_download_lock);
   g_free (stream->fragment_bitrates);
+  gst_adaptive_demux_abr_free (stream->abr);
 
   if (stream->pad) {
     gst_object_unref (stream->pad);
@@ -2149,6 +2333,9 @@ gst_adaptive_demux_stop_tasks (GstAdaptiveDemux * demux, gboolean stop_updates)
     list_to_process = demux->prepared_streams;
   }
 
+  /* Seeks and flushes invalidate all prefetched fragments */
+  gst_adaptive_demux_cancel_prefetch (demux, NULL);
+
   GST_MANIFEST_UNLOCK (demux);
   g_mutex_lock (&demux->priv->preroll_lock);
   g_cond_broadcast (&demux->priv->preroll_cond);
@@ -2272,6 +2459,66 @@ _update_average_bitrate (GstAdaptiveDemux * demux,
   return stream->moving_bitrate / stream->moving_index;
 }
 
+/* Duration of the data pushed downstream but not played yet, or
+ * GST_CLOCK_TIME_NONE if unknown.
+ * must be called with manifest_lock taken */
+static GstClockTime
+gst_adaptive_demux_stream_get_buffer_level (GstAdaptiveDemux * demux,
+    GstAdaptiveDemuxStream * stream)
+{
+  gint64 position = -1;
+  guint64 end;
+
+  if (demux->segment.rate < 0)
+    return GST_CLOCK_TIME_NONE;
+
+  if (!gst_pad_peer_query_position (stream->pad, GST_FORMAT_TIME, &position)
+      || position < 0)
+    return GST_CLOCK_TIME_NONE;
+
+  GST_ADAPTIVE_DEMUX_SEGMENT_LOCK (demux);
+  end = gst_segment_to_stream_time (&stream->segment, GST_FORMAT_TIME,
+      stream->segment.position);
+  GST_ADAPTIVE_DEMUX_SEGMENT_UNLOCK (demux);
+
+  if (!GST_CLOCK_TIME_IS_VALID (end))
+    return GST_CLOCK_TIME_NONE;
+
+  return end > position ? end - position : 0;
+}
+
+/* must be called with manifest_lock taken */
+static guint64
+gst_adaptive_demux_stream_select_abr_bitrate (GstAdaptiveDemux * demux,
+    GstAdaptiveDemuxStream * stream)
+{
+  GstAdaptiveDemuxClass *klass = GST_ADAPTIVE_DEMUX_GET_CLASS (demux);
+  GstClockTime buffer_level = GST_CLOCK_TIME_NONE;
+  guint64 *bitrates = NULL;
+  guint n_bitrates = 0;
+
+  if (demux->priv->abr_policy == GST_ADAPTIVE_DEMUX_ABR_POLICY_BOLA ||
+      demux->priv->abr_policy == GST_ADAPTIVE_DEMUX_ABR_POLICY_HYBRID) {
+    if (klass->stream_get_bitrates)
+      bitrates = klass->stream_get_bitrates (stream, &n_bitrates);
+    if (bitrates)
+      buffer_level = gst_adaptive_demux_stream_get_buffer_level (demux, stream);
+  }
+
+  stream->current_download_rate =
+      gst_adaptive_demux_abr_select_bitrate (stream->abr, bitrates,
+      n_bitrates, buffer_level, demux->bitrate_limit);
+  g_free (bitrates);
+
+  GST_INFO_OBJECT (GST_ADAPTIVE_DEMUX_STREAM_PAD (stream),
+      "Throughput %" G_GUINT64_FORMAT " bps, buffer level %" GST_TIME_FORMAT
+      ", selected bitrate %" G_GUINT64_FORMAT,
+      gst_adaptive_demux_abr_get_throughput (stream->abr),
+      GST_TIME_ARGS (buffer_level), stream->current_download_rate);
+
+  return stream->current_download_rate;
+}
+
 /* must be called with manifest_lock taken */
 static guint64
 gst_adaptive_demux_stream_update_current_bitrate (GstAdaptiveDemux * demux,
@@ -2287,6 +2534,9 @@ gst_adaptive_demux_stream_update_current_bitrate (GstAdaptiveDemux * demux,
     return demux->connection_speed;
   }
 
+  if (demux->priv->abr_policy != GST_ADAPTIVE_DEMUX_ABR_POLICY_MOVING_AVERAGE)
+    return gst_adaptive_demux_stream_select_abr_bitrate (demux, stream);
+
   fragment_bitrate = stream->last_bitrate;
   GST_DEBUG_OBJECT (demux, "Download bitrate is : %" G_GUINT64_FORMAT " bps",
       fragment_bitrate);
@@ -2863,6 +3113,9 @@ _uri_handler_probe (GstPad * pad, GstPadProbeInfo * info,
           GST_TIME_ARGS (stream->last_latency));
     }
     stream->fragment_bytes_downloaded += gst_buffer_get_size (buf);
+    gst_adaptive_demux_abr_data_received (stream->abr,
+        gst_buffer_get_size (buf),
+        gst_adaptive_demux_get_monotonic_time (stream->demux));
     GST_LOG_OBJECT (pad,
         "Received buffer, size %" G_GSIZE_FORMAT " total %" G_GUINT64_FORMAT,
         gst_buffer_get_size (buf), stream->fragment_bytes_downloaded);
@@ -2874,9 +3127,13 @@ _uri_handler_probe (GstPad * pad, GstPadProbeInfo * info,
     switch (GST_EVENT_TYPE (ev)) {
       case GST_EVENT_SEGMENT:
         stream->fragment_bytes_downloaded = 0;
+        gst_adaptive_demux_abr_download_started (stream->abr,
+            gst_adaptive_demux_get_monotonic_time (stream->demux));
         break;
       case GST_EVENT_EOS:
       {
+        gst_adaptive_demux_abr_download_finished (stream->abr,
+            gst_adaptive_demux_get_monotonic_time (stream->demux));
         stream->last_download_time =
             gst_adaptive_demux_get_monotonic_time (stream->demux) -
             (stream->download_start_time * GST_USECOND);
@@ -3385,6 +3642,478 @@ gst_adaptive_demux_stream_download_header_fragment (GstAdaptiveDemuxStream *
   return ret;
 }
 
+/* must be called with prefetch_lock taken */
+static void
+gst_adaptive_demux_prefetch_unref_unlocked (GstAdaptiveDemuxPrefetch * prefetch)
+{
+  if (--prefetch->ref_count > 0)
+    return;
+
+  while (!g_queue_is_empty (&prefetch->chunks)) {
+    GstAdaptiveDemuxPrefetchChunk *chunk = g_queue_pop_head (&prefetch->chunks);
+
+    gst_buffer_unref (chunk->buffer);
+    g_slice_free (GstAdaptiveDemuxPrefetchChunk, chunk);
+  }
+  g_clear_error (&prefetch->error);
+  g_free (prefetch->uri);
+  g_slice_free (GstAdaptiveDemuxPrefetch, prefetch);
+}
+
+/* must be called with prefetch_lock taken */
+static void
+gst_adaptive_demux_prefetch_remove_unlocked (GstAdaptiveDemux * demux,
+    GstAdaptiveDemuxPrefetch * prefetch)
+{
+  GstAdaptiveDemuxPrivate *priv = demux->priv;
+
+  priv->prefetch_entries = g_list_remove (priv->prefetch_entries, prefetch);
+
+  priv->prefetch_bytes -= prefetch->queued_bytes;
+  prefetch->queued_bytes = 0;
+
+  /* Also stops a stream that is pushing the data, and downloads waiting
+   * for room in the prefetch queue */
+  prefetch->cancelled = TRUE;
+  if (!prefetch->done && prefetch->downloader)
+    gst_uri_downloader_cancel (prefetch->downloader);
+  g_cond_broadcast (&priv->prefetch_cond);
+
+  gst_adaptive_demux_prefetch_unref_unlocked (prefetch);
+}
+
+/* Cancels and drops all prefetched fragments of @stream, or of all streams
+ * if @stream is %NULL */
+static void
+gst_adaptive_demux_cancel_prefetch (GstAdaptiveDemux * demux,
+    GstAdaptiveDemuxStream * stream)
+{
+  GstAdaptiveDemuxPrivate *priv = demux->priv;
+  GList *iter, *next;
+
+  g_mutex_lock (&priv->prefetch_lock);
+  for (iter = priv->prefetch_entries; iter; iter = next) {
+    GstAdaptiveDemuxPrefetch *prefetch = iter->data;
+
+    next = g_list_next (iter);
+    if (stream == NULL || prefetch->stream == stream)
+      gst_adaptive_demux_prefetch_remove_unlocked (demux, prefetch);
+  }
+  g_cond_broadcast (&priv->prefetch_cond);
+  g_mutex_unlock (&priv->prefetch_lock);
+}
+
+/* must be called with manifest_lock taken.
+ * Can temporarily release manifest_lock
+ */
+static void
+gst_adaptive_demux_free_prefetch_pool (GstAdaptiveDemux * demux)
+{
+  GThreadPool *pool = demux->priv->prefetch_pool;
+
+  gst_adaptive_demux_cancel_prefetch (demux, NULL);
+
+  if (pool == NULL)
+    return;
+
+  demux->priv->prefetch_pool = NULL;
+
+  GST_MANIFEST_UNLOCK (demux);
+  g_thread_pool_free (pool, FALSE, TRUE);
+  GST_MANIFEST_LOCK (demux);
+}
+
+/* Called from the streaming thread of the prefetch downloader */
+static gboolean
+gst_adaptive_demux_prefetch_chunk (GstUriDownloader * downloader,
+    GstFragment * fragment, GstBuffer * buffer, guint64 arrival_time,
+    GstAdaptiveDemuxPrefetch * prefetch)
+{
+  GstAdaptiveDemuxPrivate *priv = prefetch->demux->priv;
+  GstAdaptiveDemuxPrefetchChunk *chunk;
+  gsize size = gst_buffer_get_size (buffer);
+
+  g_mutex_lock (&priv->prefetch_lock);
+
+  /* Data in flight counts against prefetch-max-bytes too: stall the
+   * download until the queued data is consumed. The fragment the stream is
+   * currently pushing is drained right away and is never held back, which
+   * also guarantees progress */
+  while (!prefetch->cancelled && !prefetch->taken && priv->prefetch_bytes > 0
+      && priv->prefetch_bytes + size > prefetch->max_bytes)
+    g_cond_wait (&priv->prefetch_cond, &priv->prefetch_lock);
+
+  if (prefetch->cancelled) {
+    g_mutex_unlock (&priv->prefetch_lock);
+    gst_buffer_unref (buffer);
+    return FALSE;
+  }
+
+  chunk = g_slice_new (GstAdaptiveDemuxPrefetchChunk);
+  chunk->buffer = buffer;
+  chunk->arrival_time = arrival_time;
+  g_queue_push_tail (&prefetch->chunks, chunk);
+  prefetch->download_start_time = fragment->download_start_time;
+  prefetch->queued_bytes += size;
+  priv->prefetch_bytes += size;
+  g_cond_broadcast (&priv->prefetch_cond);
+  g_mutex_unlock (&priv->prefetch_lock);
+
+  return TRUE;
+}
+
+static void
+gst_adaptive_demux_prefetch_func (GstAdaptiveDemuxPrefetch * prefetch,
+    GstAdaptiveDemux * demux)
+{
+  GstAdaptiveDemuxPrivate *priv = demux->priv;
+  GstUriDownloader *downloader;
+  GstFragment *download;
+  GError *err = NULL;
+
+  g_mutex_lock (&priv->prefetch_lock);
+  if (prefetch->cancelled) {
+    downloader = NULL;
+    goto done;
+  }
+  downloader = prefetch->downloader = gst_uri_downloader_new ();
+  gst_uri_downloader_set_parent (downloader, GST_ELEMENT_CAST (demux));
+  g_mutex_unlock (&priv->prefetch_lock);
+
+  GST_DEBUG_OBJECT (demux, "Prefetching %s, range %" G_GINT64_FORMAT " - %"
+      G_GINT64_FORMAT, prefetch->uri, prefetch->range_start,
+      prefetch->range_end);
+
+  download = gst_uri_downloader_fetch_uri_streaming (downloader,
+      prefetch->uri, demux->manifest_uri, FALSE, FALSE, TRUE,
+      prefetch->range_start, prefetch->range_end,
+      (GstUriDownloaderChunkFunc) gst_adaptive_demux_prefetch_chunk, prefetch,
+      &err);
+
+  g_mutex_lock (&priv->prefetch_lock);
+  prefetch->downloader = NULL;
+  if (download) {
+    prefetch->download_start_time = download->download_start_time;
+    prefetch->download_stop_time = download->download_stop_time;
+    g_object_unref (download);
+  } else {
+    GST_DEBUG_OBJECT (demux, "Failed to prefetch %s: %s", prefetch->uri,
+        err ? err->message : "cancelled");
+    if (err == NULL)
+      err = g_error_new (GST_RESOURCE_ERROR, GST_RESOURCE_ERROR_READ,
+          "Failed to download '%s'", prefetch->uri);
+    prefetch->error = err;
+  }
+
+done:
+  prefetch->done = TRUE;
+  g_cond_broadcast (&priv->prefetch_cond);
+  gst_adaptive_demux_prefetch_unref_unlocked (prefetch);
+  g_mutex_unlock (&priv->prefetch_lock);
+
+  if (downloader)
+    g_object_unref (downloader);
+}
+
+/* must be called with prefetch_lock taken */
+static GstAdaptiveDemuxPrefetch *
+gst_adaptive_demux_find_prefetch_unlocked (GstAdaptiveDemux * demux,
+    GstAdaptiveDemuxStream * stream, const gchar * uri, gint64 range_start,
+    gint64 range_end)
+{
+  GList *iter;
+
+  for (iter = demux->priv->prefetch_entries; iter; iter = g_list_next (iter)) {
+    GstAdaptiveDemuxPrefetch *prefetch = iter->data;
+
+    if (prefetch->stream == stream && prefetch->range_start == range_start
+        && prefetch->range_end == range_end && g_str_equal (prefetch->uri, uri))
+      return prefetch;
+  }
+
+  return NULL;
+}
+
+/* Queues downloads for the fragments following the current one.
+ * must be called with manifest_lock taken */
+static void
+gst_adaptive_demux_stream_schedule_prefetch (GstAdaptiveDemuxStream * stream)
+{
+  GstAdaptiveDemux *demux = stream->demux;
+  GstAdaptiveDemuxClass *klass = GST_ADAPTIVE_DEMUX_GET_CLASS (demux);
+  GstAdaptiveDemuxPrivate *priv = demux->priv;
+  guint i;
+
+  if (priv->prefetch_fragments == 0 || !klass->stream_peek_fragment)
+    return;
+
+  /* Chunked and key unit trick mode downloads only fetch parts of the
+   * fragments, depending on the data received so far */
+  if (stream->fragment.chunk_size != 0
+      || GST_ADAPTIVE_DEMUX_IN_TRICKMODE_KEY_UNITS (demux))
+    return;
+
+  if (!priv->prefetch_pool) {
+    priv->prefetch_pool =
+        g_thread_pool_new ((GFunc) gst_adaptive_demux_prefetch_func, demux,
+        priv->max_concurrent_downloads, FALSE, NULL);
+    if (!priv->prefetch_pool)
+      return;
+  }
+
+  for (i = 1; i <= priv->prefetch_fragments; i++) {
+    GstAdaptiveDemuxPrefetch *prefetch;
+    gchar *uri = NULL;
+    gint64 range_start = 0, range_end = -1;
+
+    if (!klass->stream_peek_fragment (stream, i, &uri, &range_start,
+            &range_end))
+      break;
+
+    g_mutex_lock (&priv->prefetch_lock);
+    if (priv->prefetch_bytes >= priv->prefetch_max_bytes) {
+      GST_LOG_OBJECT (stream->pad, "Prefetch queue full (%" G_GUINT64_FORMAT
+          " bytes)", priv->prefetch_bytes);
+      g_mutex_unlock (&priv->prefetch_lock);
+      g_free (uri);
+      break;
+    }
+
+    if (gst_adaptive_demux_find_prefetch_unlocked (demux, stream, uri,
+            range_start, range_end)) {
+      g_mutex_unlock (&priv->prefetch_lock);
+      g_free (uri);
+      continue;
+    }
+
+    prefetch = g_slice_new0 (GstAdaptiveDemuxPrefetch);
+    /* one for the entries list, one for the pool */
+    prefetch->ref_count = 2;
+    prefetch->demux = demux;
+    prefetch->stream = stream;
+    prefetch->uri = uri;
+    prefetch->range_start = range_start;
+    prefetch->range_end = range_end;
+    prefetch->max_bytes = priv->prefetch_max_bytes;
+    priv->prefetch_entries = g_list_append (priv->prefetch_entries, prefetch);
+    g_mutex_unlock (&priv->prefetch_lock);
+
+    GST_DEBUG_OBJECT (stream->pad, "Scheduling prefetch of %s", uri);
+    g_thread_pool_push (priv->prefetch_pool, prefetch, NULL);
+  }
+}
+
+/* Returns a reference to the prefetch of the current fragment, or %NULL if
+ * it was not prefetched.
+ * must be called with manifest_lock taken.
+ */
+static GstAdaptiveDemuxPrefetch *
+gst_adaptive_demux_stream_take_prefetch (GstAdaptiveDemuxStream * stream)
+{
+  GstAdaptiveDemux *demux = stream->demux;
+  GstAdaptiveDemuxPrivate *priv = demux->priv;
+  GstAdaptiveDemuxPrefetch *prefetch;
+  GList *iter, *next;
+
+  g_mutex_lock (&priv->prefetch_lock);
+  prefetch = gst_adaptive_demux_find_prefetch_unlocked (demux, stream,
+      stream->fragment.uri, stream->fragment.range_start,
+      stream->fragment.range_end);
+
+  /* Entries queued before the current fragment were skipped, if there is no
+   * match at all the position or representation changed */
+  for (iter = priv->prefetch_entries; iter && iter->data != prefetch;
+      iter = next) {
+    GstAdaptiveDemuxPrefetch *other = iter->data;
+
+    next = g_list_next (iter);
+    if (other->stream == stream)
+      gst_adaptive_demux_prefetch_remove_unlocked (demux, other);
+  }
+
+  /* All the pool threads can be stalled by downloads waiting for room in
+   * the prefetch queue, don't wait for a prefetch that did not start yet */
+  if (prefetch && !prefetch->done && !prefetch->downloader) {
+    GST_DEBUG_OBJECT (stream->pad, "Prefetch of %s not started yet",
+        prefetch->uri);
+    gst_adaptive_demux_prefetch_remove_unlocked (demux, prefetch);
+    prefetch = NULL;
+  }
+
+  if (prefetch) {
+    prefetch->ref_count++;
+    prefetch->taken = TRUE;
+    g_cond_broadcast (&priv->prefetch_cond);
+  }
+  g_mutex_unlock (&priv->prefetch_lock);
+
+  return prefetch;
+}
+
+/* Feeds a prefetched fragment to the stream the same way the source element
+ * would have done it, pushing the data as soon as the prefetch download
+ * received it. Returns %FALSE if the prefetch failed before any data was
+ * pushed, the fragment then has to be downloaded again.
+ * must be called with manifest_lock taken.
+ * Can temporarily release manifest_lock
+ */
+static gboolean
+gst_adaptive_demux_stream_push_prefetch (GstAdaptiveDemuxStream * stream,
+    GstAdaptiveDemuxPrefetch * prefetch, GstFlowReturn * ret)
+{
+  GstAdaptiveDemux *demux = stream->demux;
+  GstAdaptiveDemuxPrivate *priv = demux->priv;
+  guint64 download_start_time = 0, download_stop_time = 0;
+  guint64 size = 0;
+  gboolean pushed = FALSE, finished = FALSE, cancelled;
+  gboolean stream_cancelled = FALSE;
+  GError *err = NULL;
+
+  GST_DEBUG_OBJECT (stream->pad, "Using prefetch of fragment %s",
+      stream->fragment.uri);
+
+  g_mutex_lock (&priv->prefetch_lock);
+  while (TRUE) {
+    GstAdaptiveDemuxPrefetchChunk *chunk;
+    GstBuffer *buffer;
+    gsize chunk_size;
+
+    if (g_queue_is_empty (&prefetch->chunks) && !prefetch->done
+        && !prefetch->cancelled) {
+      GST_LOG_OBJECT (stream->pad, "Waiting for prefetch of %s",
+          prefetch->uri);
+
+      GST_MANIFEST_UNLOCK (demux);
+      while (g_queue_is_empty (&prefetch->chunks) && !prefetch->done
+          && !prefetch->cancelled)
+        g_cond_wait (&priv->prefetch_cond, &priv->prefetch_lock);
+      g_mutex_unlock (&priv->prefetch_lock);
+      GST_MANIFEST_LOCK (demux);
+
+      g_mutex_lock (&stream->fragment_download_lock);
+      stream_cancelled = stream->cancelled;
+      g_mutex_unlock (&stream->fragment_download_lock);
+
+      g_mutex_lock (&priv->prefetch_lock);
+      if (stream_cancelled)
+        break;
+    }
+
+    if (prefetch->cancelled || g_queue_is_empty (&prefetch->chunks))
+      break;
+
+    chunk = g_queue_pop_head (&prefetch->chunks);
+    buffer = chunk->buffer;
+    chunk_size = gst_buffer_get_size (buffer);
+    prefetch->queued_bytes -= chunk_size;
+    priv->prefetch_bytes -= chunk_size;
+    /* makes room for stalled prefetch downloads */
+    g_cond_broadcast (&priv->prefetch_cond);
+    g_mutex_unlock (&priv->prefetch_lock);
+
+    if (!pushed) {
+      /* What _uri_handler_probe() would have measured. The request
+       * latency was already paid by the prefetch */
+      stream->download_start_time =
+          GST_TIME_AS_USECONDS (gst_adaptive_demux_get_monotonic_time (demux));
+      stream->fragment_bytes_downloaded = 0;
+      stream->last_latency = 0;
+      gst_adaptive_demux_abr_download_started (stream->abr,
+          prefetch->download_start_time);
+
+      g_mutex_lock (&stream->fragment_download_lock);
+      stream->download_finished = FALSE;
+      stream->downloading_first_buffer = TRUE;
+      g_mutex_unlock (&stream->fragment_download_lock);
+      pushed = TRUE;
+    }
+
+    /* Throughput is measured on the arrival times of the prefetch */
+    stream->fragment_bytes_downloaded += chunk_size;
+    gst_adaptive_demux_abr_data_received (stream->abr, chunk_size,
+        chunk->arrival_time);
+    g_slice_free (GstAdaptiveDemuxPrefetchChunk, chunk);
+    size += chunk_size;
+
+    /* _src_chain() takes the manifest lock itself and drops it while
+     * pushing downstream, like it does for the source element's streaming
+     * thread. It must not be held recursively here, or it would stay
+     * locked during the push */
+    GST_MANIFEST_UNLOCK (demux);
+    _src_chain (stream->internal_pad, GST_OBJECT_CAST (demux), buffer);
+    GST_MANIFEST_LOCK (demux);
+
+    g_mutex_lock (&stream->fragment_download_lock);
+    finished = stream->download_finished;
+    stream_cancelled = stream->cancelled;
+    g_mutex_unlock (&stream->fragment_download_lock);
+
+    g_mutex_lock (&priv->prefetch_lock);
+    if (finished || stream_cancelled || stream->last_ret != GST_FLOW_OK)
+      break;
+  }
+
+  if (prefetch->error)
+    err = g_error_copy (prefetch->error);
+  cancelled = prefetch->cancelled;
+  download_start_time = prefetch->download_start_time;
+  download_stop_time = prefetch->download_stop_time;
+
+  /* Stops the download if it's still running */
+  if (g_list_find (priv->prefetch_entries, prefetch))
+    gst_adaptive_demux_prefetch_remove_unlocked (demux, prefetch);
+  gst_adaptive_demux_prefetch_unref_unlocked (prefetch);
+  g_mutex_unlock (&priv->prefetch_lock);
+
+  if (stream_cancelled) {
+    /* Seek, flush or stream removal while the manifest lock was released */
+    g_clear_error (&err);
+    *ret = stream->last_ret = GST_FLOW_FLUSHING;
+    return TRUE;
+  }
+
+  if (!pushed) {
+    GST_DEBUG_OBJECT (stream->pad, "Prefetch failed: %s",
+        err ? err->message : "cancelled");
+    g_clear_error (&err);
+    return FALSE;
+  }
+
+  if (finished || stream->last_ret != GST_FLOW_OK) {
+    /* Stopped by the stream */
+  } else if (cancelled) {
+    /* Seek or flush */
+    stream->last_ret = GST_FLOW_FLUSHING;
+  } else if (err) {
+    /* Behave like an error posted by the source element */
+    GST_WARNING_OBJECT (stream->pad, "Prefetch failed after %" G_GUINT64_FORMAT
+        " bytes: %s", size, err->message);
+    gst_adaptive_demux_stream_fragment_download_finish (stream,
+        GST_FLOW_CUSTOM_ERROR, err);
+  } else {
+    if (download_stop_time > download_start_time) {
+      gst_adaptive_demux_abr_download_finished (stream->abr,
+          download_stop_time);
+      stream->last_download_time = download_stop_time - download_start_time;
+      stream->last_bitrate =
+          gst_util_uint64_scale (size, 8 * GST_SECOND,
+          stream->last_download_time);
+    }
+
+    /* There is no uri handler to query the size from */
+    if (stream->fragment.bitrate == 0 && stream->fragment.duration != 0)
+      stream->fragment.bitrate = MIN (G_MAXUINT, gst_util_uint64_scale (size,
+              8 * GST_SECOND, stream->fragment.duration));
+
+    /* Behave like the EOS from the source element */
+    gst_adaptive_demux_eos_handling (stream);
+  }
+  g_clear_error (&err);
+
+  *ret = stream->last_ret;
+  return TRUE;
+}
+
 /* must be called with manifest_lock taken.
  * Can temporarily release manifest_lock
  */
@@ -3503,9 +4232,33 @@ again:
         chunk_end = MIN (chunk_end, range_end);
     }
   } else {
-    ret =
-        gst_adaptive_demux_stream_download_uri (demux, stream, url,
-        stream->fragment.range_start, stream->fragment.range_end, &http_status);
+    GstAdaptiveDemuxPrefetch *prefetch = NULL;
+
+    /* Retries always go through the source element */
+    if (stream->internal_pad && !retried_once)
+      prefetch = gst_adaptive_demux_stream_take_prefetch (stream);
+
+    g_mutex_lock (&stream->fragment_download_lock);
+    if (G_UNLIKELY (stream->cancelled)) {
+      g_mutex_unlock (&stream->fragment_download_lock);
+      if (prefetch) {
+        g_mutex_lock (&demux->priv->prefetch_lock);
+        gst_adaptive_demux_prefetch_unref_unlocked (prefetch);
+        g_mutex_unlock (&demux->priv->prefetch_lock);
+      }
+      return stream->last_ret = GST_FLOW_FLUSHING;
+    }
+    g_mutex_unlock (&stream->fragment_download_lock);
+
+    if (prefetch && gst_adaptive_demux_stream_push_prefetch (stream, prefetch,
+            &ret)) {
+      /* pushed */
+    } else {
+      ret =
+          gst_adaptive_demux_stream_download_uri (demux, stream, url,
+          stream->fragment.range_start, stream->fragment.range_end,
+          &http_status);
+    }
     GST_DEBUG_OBJECT (stream->pad, "Fragment download result: %d (%d) %s",
         stream->last_ret, http_status, gst_flow_get_name (stream->last_ret));
   }
@@ -3821,6 +4574,8 @@ gst_adaptive_demux_stream_download_loop (GstAdaptiveDemuxStream * stream)
 
     stream->last_ret = GST_FLOW_OK;
 
+    gst_adaptive_demux_stream_schedule_prefetch (stream);
+
     next_download = gst_adaptive_demux_get_monotonic_time (demux);
     ret = gst_adaptive_demux_stream_download_fragment (stream);
 
@@ -4052,6 +4807,8 @@ gst_adaptive_demux_updates_loop (GstAdaptiveDemux * demux)
 
   GST_MANIFEST_LOCK (demux);
 
+  demux->priv->updates_thread = g_thread_self ();
+
   next_update =
       gst_adaptive_demux_get_monotonic_time (demux) +
       klass->get_manifest_update_interval (demux) * GST_USECOND;
@@ -4089,6 +4846,12 @@ gst_adaptive_demux_updates_loop (GstAdaptiveDemux * demux)
     ret = gst_adaptive_demux_update_manifest (demux);
 
     if (ret == GST_FLOW_EOS) {
+    } else if (ret == GST_FLOW_FLUSHING) {
+      /* The manifest lock was released during the update and the task was
+       * stopped meanwhile, this is not an update failure */
+      GST_DEBUG_OBJECT (demux, "Playlist update interrupted");
+      next_update = gst_adaptive_demux_get_monotonic_time (demux)
+          + klass->get_manifest_update_interval (demux) * GST_USECOND;
     } else if (ret != GST_FLOW_OK) {
       /* update_failed_count is used only here, no need to protect it */
       demux->priv->update_failed_count++;
@@ -4102,6 +4865,7 @@ gst_adaptive_demux_updates_loop (GstAdaptiveDemux * demux)
             (_("Internal data stream error.")), ("Could not update playlist"));
         GST_DEBUG_OBJECT (demux, "Stopped updates task because of error");
         gst_task_stop (demux->priv->updates_task);
+        demux->priv->updates_thread = NULL;
         GST_MANIFEST_UNLOCK (demux);
         goto end;
       }
@@ -4124,6 +4888,9 @@ gst_adaptive_demux_updates_loop (GstAdaptiveDemux * demux)
 quit:
   {
     GST_DEBUG_OBJECT (demux, "Stop updates task request detected.");
+    GST_MANIFEST_LOCK (demux);
+    demux->priv->updates_thread = NULL;
+    GST_MANIFEST_UNLOCK (demux);
   }
 
 end:
@@ -4293,6 +5060,8 @@ gst_adaptive_demux_stream_advance_fragment_unlocked (GstAdaptiveDemux * demux,
   if (ret == GST_FLOW_OK) {
     if (gst_adaptive_demux_stream_select_bitrate (demux, stream,
             gst_adaptive_demux_stream_update_current_bitrate (demux, stream))) {
+      /* Prefetched fragments are for the previous representation */
+      gst_adaptive_demux_cancel_prefetch (demux, stream);
       stream->need_header = TRUE;
       ret = (GstFlowReturn) GST_ADAPTIVE_DEMUX_FLOW_SWITCH;
     }
@@ -4568,6 +5337,73 @@ gst_adaptive_demux_is_running (GstAdaptiveDemux * demux)
   return g_atomic_int_get (&demux->running);
 }
 
+/**
+ * gst_adaptive_demux_fetch_manifest_unlocked:
+ * @demux: #GstAdaptiveDemux
+ * @uri: URI of the manifest to download
+ * @referer: (nullable): URI of the referer
+ * @download: (out) (transfer full): the downloaded manifest
+ * @err: (out) (optional): return location for a #GError
+ *
+ * Downloads @uri like #GstAdaptiveDemuxClass.update_manifest()
+ * implementations do, but releases the manifest lock during the download
+ * when called from the manifest update task. This is meant for downloads
+ * that the server can hold for a long time, such as blocking playlist
+ * reloads, which would otherwise block seeks and the streaming threads.
+ *
+ * The demuxer state may have changed by the time this returns, callers have
+ * to validate it again before using @download.
+ *
+ * Returns: %GST_FLOW_OK if @download was set, %GST_FLOW_FLUSHING if the
+ * manifest update task was stopped during the download, %GST_FLOW_ERROR if
+ * the download failed.
+ *
+ * Since: 1.20
+ */
+GstFlowReturn
+gst_adaptive_demux_fetch_manifest_unlocked (GstAdaptiveDemux * demux,
+    const gchar * uri, const gchar * referer, GstFragment ** download,
+    GError ** err)
+{
+  gboolean unlock = demux->priv->updates_thread == g_thread_self ();
+  gboolean stopped = FALSE;
+  GstFragment *fragment;
+
+  g_return_val_if_fail (download != NULL, GST_FLOW_ERROR);
+
+  *download = NULL;
+
+  /* The update task takes the manifest lock only once, anywhere else it
+   * can't be released safely */
+  if (unlock)
+    GST_MANIFEST_UNLOCK (demux);
+
+  fragment = gst_uri_downloader_fetch_uri (demux->downloader, uri, referer,
+      TRUE, TRUE, TRUE, err);
+
+  if (unlock) {
+    GST_MANIFEST_LOCK (demux);
+
+    g_mutex_lock (&demux->priv->updates_timed_lock);
+    stopped = demux->priv->stop_updates_task;
+    g_mutex_unlock (&demux->priv->updates_timed_lock);
+  }
+
+  if (stopped) {
+    GST_DEBUG_OBJECT (demux, "Update task stopped while downloading %s", uri);
+    g_clear_object (&fragment);
+    g_clear_error (err);
+    return GST_FLOW_FLUSHING;
+  }
+
+  if (fragment == NULL)
+    return GST_FLOW_ERROR;
+
+  *download = fragment;
+
+  return GST_FLOW_OK;
+}
+
 static GstAdaptiveDemuxTimer *
 gst_adaptive_demux_timer_new (GCond * cond, GMutex * mutex)
 {
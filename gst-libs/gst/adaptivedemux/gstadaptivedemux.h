@@ -26,6 +26,7 @@
 #include <gst/base/gstadapter.h>
 #include <gst/uridownloader/gsturidownloader.h>
 #include <gst/adaptivedemux/adaptive-demux-prelude.h>
+#include <gst/adaptivedemux/gstadaptivedemuxabr.h>
 
 G_BEGIN_DECLS
 
@@ -184,6 +185,10 @@ struct _GstAdaptiveDemuxStream
   guint moving_index;
   guint64 *fragment_bitrates;
 
+  /* Bitrate adaptation for the policies other than the moving average.
+   * Since: 1.20 */
+  GstAdaptiveDemuxAbr *abr;
+
   /* QoS data : UNUSED !!! */
   GstClockTime qos_earliest_time;
 
@@ -482,6 +487,42 @@ struct _GstAdaptiveDemuxClass
    * Return: %TRUE if the playlist needs to be refreshed periodically by the demuxer.
    */
   gboolean (*requires_periodical_playlist_update) (GstAdaptiveDemux * demux);
+
+  /**
+   * stream_peek_fragment:
+   * @stream: #GstAdaptiveDemuxStream
+   * @index: position of the fragment relative to the current one, starting
+   *   at 1 for the next fragment
+   * @uri: (out) (transfer full): location to store the fragment uri
+   * @range_start: (out): location to store the start of the byte range
+   * @range_end: (out): location to store the (inclusive) end of the byte
+   *   range, or -1
+   *
+   * Optional. Gets the location of an upcoming fragment without changing the
+   * current position of @stream. Used to download fragments ahead of time
+   * when #GstAdaptiveDemux:prefetch-fragments is set.
+   *
+   * Returns: %TRUE if the fragment is known
+   *
+   * Since: 1.20
+   */
+  gboolean (*stream_peek_fragment) (GstAdaptiveDemuxStream * stream, guint index,
+                                    gchar ** uri, gint64 * range_start, gint64 * range_end);
+
+  /**
+   * stream_get_bitrates:
+   * @stream: #GstAdaptiveDemuxStream
+   * @n_bitrates: (out): location to store the number of bitrates
+   *
+   * Optional. Gets the bitrates @stream can currently switch between. Needed
+   * by the buffer based #GstAdaptiveDemux:abr-policy values.
+   *
+   * Returns: (transfer full) (array length=n_bitrates) (nullable): the
+   *   bitrates in bits per second and in ascending order, or %NULL
+   *
+   * Since: 1.20
+   */
+  guint64 * (*stream_get_bitrates) (GstAdaptiveDemuxStream * stream, guint * n_bitrates);
 };
 
 GST_ADAPTIVE_DEMUX_API
@@ -532,6 +573,13 @@ GDateTime *gst_adaptive_demux_get_client_now_utc (GstAdaptiveDemux * demux);
 GST_ADAPTIVE_DEMUX_API
 gboolean gst_adaptive_demux_is_running (GstAdaptiveDemux * demux);
 
+GST_ADAPTIVE_DEMUX_API
+GstFlowReturn gst_adaptive_demux_fetch_manifest_unlocked (GstAdaptiveDemux * demux,
+                                                          const gchar * uri,
+                                                          const gchar * referer,
+                                                          GstFragment ** download,
+                                                          GError ** err);
+
 GST_ADAPTIVE_DEMUX_API
 GstClockTime gst_adaptive_demux_get_qos_earliest_time (GstAdaptiveDemux *demux);
 
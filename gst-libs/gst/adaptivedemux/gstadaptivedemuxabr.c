@@ -0,0 +1,599 @@
+/* GStreamer
+ *
+ * Copyright (C) 2026 agent <agent@local>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/**
+ * SECTION:gstadaptivedemuxabr
+ * @short_description: Bitrate adaptation for adaptive streaming demuxers
+ *
+ * #GstAdaptiveDemuxAbr estimates the available bandwidth from download
+ * rate samples and chooses the bitrate of the next fragment of a stream.
+ *
+ * Samples are taken per chunk of received data instead of per fragment so
+ * that the estimate is not skewed by the request latency and reacts within
+ * a fragment. They are combined by two exponentially weighted moving
+ * averages with a short and a long half-life, the lowest of both being used
+ * as the throughput estimate.
+ *
+ * Several policies are available:
+ *
+ *  * %GST_ADAPTIVE_DEMUX_ABR_POLICY_THROUGHPUT selects the highest bitrate
+ *    below the estimated throughput scaled by the bandwidth usage.
+ *  * %GST_ADAPTIVE_DEMUX_ABR_POLICY_BOLA only uses the buffer level, as
+ *    described in "BOLA: Near-Optimal Bitrate Adaptation for Online Videos"
+ *    (Spiteri, Urgaonkar, Sitaraman).
+ *  * %GST_ADAPTIVE_DEMUX_ABR_POLICY_HYBRID uses the throughput until enough
+ *    data is buffered and then lets BOLA pick higher bitrates than the
+ *    throughput alone would, until the buffer runs low again.
+ *
+ * %GST_ADAPTIVE_DEMUX_ABR_POLICY_MOVING_AVERAGE is the historical behaviour
+ * of #GstAdaptiveDemux and is implemented there, it is handled like
+ * %GST_ADAPTIVE_DEMUX_ABR_POLICY_THROUGHPUT here.
+ *
+ * Since: 1.20
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <math.h>
+
+#include "gstadaptivedemuxabr.h"
+
+GST_DEBUG_CATEGORY_STATIC (adaptivedemuxabr_debug);
+#define GST_CAT_DEFAULT adaptivedemuxabr_debug
+
+/* Minimum duration of a download rate sample */
+#define SAMPLE_MIN_DURATION (50 * GST_MSECOND)
+
+/* Half-life of the throughput estimators, in seconds of download */
+#define FAST_HALF_LIFE 3.0
+#define SLOW_HALF_LIFE 8.0
+
+/* BOLA parameters, in seconds of buffered media */
+#define BOLA_MIN_BUFFER 10.0
+#define BOLA_BUFFER_PER_LEVEL 2.0
+#define BOLA_STABLE_BUFFER 12.0
+
+/* The hybrid policy switches to BOLA when the buffer reaches
+ * BOLA_STABLE_BUFFER and back to throughput below half of it */
+#define HYBRID_LEAVE_BOLA_BUFFER (BOLA_STABLE_BUFFER / 2)
+
+typedef struct
+{
+  gdouble half_life;
+  gdouble estimate;             /* biased towards 0, see ewma_get() */
+  gdouble total_time;
+} GstAdaptiveDemuxAbrEwma;
+
+struct _GstAdaptiveDemuxAbr
+{
+  GMutex lock;
+
+  GstAdaptiveDemuxAbrPolicy policy;
+
+  GstAdaptiveDemuxAbrEwma fast;
+  GstAdaptiveDemuxAbrEwma slow;
+
+  /* current download */
+  GstClockTime download_start;
+  GstClockTime chunk_start;
+  guint64 chunk_bytes;
+  guint64 download_bytes;
+  guint download_samples;
+
+  /* hybrid policy state */
+  gboolean buffer_based;
+  guint64 last_bitrate;
+};
+
+GType
+gst_adaptive_demux_abr_policy_get_type (void)
+{
+  static gsize policy_type = 0;
+
+  if (g_once_init_enter (&policy_type)) {
+    static const GEnumValue policy_values[] = {
+      {GST_ADAPTIVE_DEMUX_ABR_POLICY_MOVING_AVERAGE,
+          "Average of the last fragments download rate", "moving-average"},
+      {GST_ADAPTIVE_DEMUX_ABR_POLICY_THROUGHPUT,
+          "EWMA of the chunks download rate", "throughput"},
+      {GST_ADAPTIVE_DEMUX_ABR_POLICY_BOLA, "Buffer based (BOLA)", "bola"},
+      {GST_ADAPTIVE_DEMUX_ABR_POLICY_HYBRID,
+          "Throughput, then buffer based once filled", "hybrid"},
+      {0, NULL, NULL},
+    };
+    GType tmp = g_enum_register_static ("GstAdaptiveDemuxAbrPolicy",
+        policy_values);
+    g_once_init_leave (&policy_type, tmp);
+  }
+
+  return (GType) policy_type;
+}
+
+static void
+ewma_init (GstAdaptiveDemuxAbrEwma * ewma, gdouble half_life)
+{
+  ewma->half_life = half_life;
+  ewma->estimate = 0;
+  ewma->total_time = 0;
+}
+
+static void
+ewma_add (GstAdaptiveDemuxAbrEwma * ewma, gdouble value, gdouble weight)
+{
+  gdouble alpha = pow (0.5, weight / ewma->half_life);
+
+  ewma->estimate = alpha * ewma->estimate + (1 - alpha) * value;
+  ewma->total_time += weight;
+}
+
+static gdouble
+ewma_get (GstAdaptiveDemuxAbrEwma * ewma)
+{
+  gdouble zero_factor;
+
+  if (ewma->total_time <= 0)
+    return 0;
+
+  /* The estimate starts at 0, correct for it */
+  zero_factor = 1 - pow (0.5, ewma->total_time / ewma->half_life);
+  return ewma->estimate / zero_factor;
+}
+
+static void
+gst_adaptive_demux_abr_reset_unlocked (GstAdaptiveDemuxAbr * abr)
+{
+  ewma_init (&abr->fast, FAST_HALF_LIFE);
+  ewma_init (&abr->slow, SLOW_HALF_LIFE);
+
+  abr->download_start = GST_CLOCK_TIME_NONE;
+  abr->chunk_start = GST_CLOCK_TIME_NONE;
+  abr->chunk_bytes = 0;
+  abr->download_bytes = 0;
+  abr->download_samples = 0;
+  abr->buffer_based = FALSE;
+  abr->last_bitrate = 0;
+}
+
+/**
+ * gst_adaptive_demux_abr_new:
+ * @policy: the #GstAdaptiveDemuxAbrPolicy to use
+ *
+ * Returns: (transfer full): a new #GstAdaptiveDemuxAbr, free with
+ *   gst_adaptive_demux_abr_free()
+ *
+ * Since: 1.20
+ */
+GstAdaptiveDemuxAbr *
+gst_adaptive_demux_abr_new (GstAdaptiveDemuxAbrPolicy policy)
+{
+  GstAdaptiveDemuxAbr *abr;
+  static gsize debug_init = 0;
+
+  if (g_once_init_enter (&debug_init)) {
+    GST_DEBUG_CATEGORY_INIT (adaptivedemuxabr_debug, "adaptivedemuxabr", 0,
+        "Adaptive Demux bitrate adaptation");
+    g_once_init_leave (&debug_init, 1);
+  }
+
+  abr = g_new0 (GstAdaptiveDemuxAbr, 1);
+  g_mutex_init (&abr->lock);
+  abr->policy = policy;
+  gst_adaptive_demux_abr_reset_unlocked (abr);
+
+  return abr;
+}
+
+/**
+ * gst_adaptive_demux_abr_free:
+ * @abr: a #GstAdaptiveDemuxAbr
+ *
+ * Frees @abr.
+ *
+ * Since: 1.20
+ */
+void
+gst_adaptive_demux_abr_free (GstAdaptiveDemuxAbr * abr)
+{
+  g_return_if_fail (abr != NULL);
+
+  g_mutex_clear (&abr->lock);
+  g_free (abr);
+}
+
+/**
+ * gst_adaptive_demux_abr_get_policy:
+ * @abr: a #GstAdaptiveDemuxAbr
+ *
+ * Returns: the policy currently used by @abr
+ *
+ * Since: 1.20
+ */
+GstAdaptiveDemuxAbrPolicy
+gst_adaptive_demux_abr_get_policy (GstAdaptiveDemuxAbr * abr)
+{
+  GstAdaptiveDemuxAbrPolicy ret;
+
+  g_return_val_if_fail (abr != NULL,
+      GST_ADAPTIVE_DEMUX_ABR_POLICY_MOVING_AVERAGE);
+
+  g_mutex_lock (&abr->lock);
+  ret = abr->policy;
+  g_mutex_unlock (&abr->lock);
+
+  return ret;
+}
+
+/**
+ * gst_adaptive_demux_abr_set_policy:
+ * @abr: a #GstAdaptiveDemuxAbr
+ * @policy: the #GstAdaptiveDemuxAbrPolicy to use
+ *
+ * Changes the policy used by gst_adaptive_demux_abr_select_bitrate(). The
+ * throughput estimate is kept.
+ *
+ * Since: 1.20
+ */
+void
+gst_adaptive_demux_abr_set_policy (GstAdaptiveDemuxAbr * abr,
+    GstAdaptiveDemuxAbrPolicy policy)
+{
+  g_return_if_fail (abr != NULL);
+
+  g_mutex_lock (&abr->lock);
+  abr->policy = policy;
+  abr->buffer_based = FALSE;
+  g_mutex_unlock (&abr->lock);
+}
+
+/**
+ * gst_adaptive_demux_abr_reset:
+ * @abr: a #GstAdaptiveDemuxAbr
+ *
+ * Forgets all the samples and the state of the policy, for example after
+ * a seek or a change of network.
+ *
+ * Since: 1.20
+ */
+void
+gst_adaptive_demux_abr_reset (GstAdaptiveDemuxAbr * abr)
+{
+  g_return_if_fail (abr != NULL);
+
+  g_mutex_lock (&abr->lock);
+  gst_adaptive_demux_abr_reset_unlocked (abr);
+  g_mutex_unlock (&abr->lock);
+}
+
+static void
+gst_adaptive_demux_abr_add_sample_unlocked (GstAdaptiveDemuxAbr * abr,
+    guint64 bytes, GstClockTime duration)
+{
+  gdouble secs = (gdouble) duration / GST_SECOND;
+  gdouble rate = bytes * 8 / secs;
+
+  GST_LOG ("sample of %" G_GUINT64_FORMAT " bytes in %" GST_TIME_FORMAT
+      " = %.0f bps", bytes, GST_TIME_ARGS (duration), rate);
+
+  ewma_add (&abr->fast, rate, secs);
+  ewma_add (&abr->slow, rate, secs);
+}
+
+/**
+ * gst_adaptive_demux_abr_add_sample:
+ * @abr: a #GstAdaptiveDemuxAbr
+ * @bytes: amount of data received
+ * @duration: time it took to receive @bytes
+ *
+ * Adds a download rate sample. The sample is weighted by its @duration.
+ *
+ * Since: 1.20
+ */
+void
+gst_adaptive_demux_abr_add_sample (GstAdaptiveDemuxAbr * abr, guint64 bytes,
+    GstClockTime duration)
+{
+  g_return_if_fail (abr != NULL);
+
+  if (!GST_CLOCK_TIME_IS_VALID (duration) || duration == 0)
+    return;
+
+  g_mutex_lock (&abr->lock);
+  gst_adaptive_demux_abr_add_sample_unlocked (abr, bytes, duration);
+  g_mutex_unlock (&abr->lock);
+}
+
+/**
+ * gst_adaptive_demux_abr_download_started:
+ * @abr: a #GstAdaptiveDemuxAbr
+ * @now: monotonic time at which the download was requested
+ *
+ * Notifies @abr that a new download starts. The data received by an
+ * unfinished previous download is discarded.
+ *
+ * Since: 1.20
+ */
+void
+gst_adaptive_demux_abr_download_started (GstAdaptiveDemuxAbr * abr,
+    GstClockTime now)
+{
+  g_return_if_fail (abr != NULL);
+
+  g_mutex_lock (&abr->lock);
+  abr->download_start = now;
+  abr->chunk_start = GST_CLOCK_TIME_NONE;
+  abr->chunk_bytes = 0;
+  abr->download_bytes = 0;
+  abr->download_samples = 0;
+  g_mutex_unlock (&abr->lock);
+}
+
+/**
+ * gst_adaptive_demux_abr_data_received:
+ * @abr: a #GstAdaptiveDemuxAbr
+ * @bytes: size of the received data
+ * @now: monotonic time at which the data was received
+ *
+ * Accounts for data received by the current download.
+ *
+ * The data received up to the first call only gives the start time of the
+ * transfer since it also contains the request latency. Afterwards a sample
+ * is added whenever enough time passed since the previous one.
+ *
+ * Since: 1.20
+ */
+void
+gst_adaptive_demux_abr_data_received (GstAdaptiveDemuxAbr * abr,
+    guint64 bytes, GstClockTime now)
+{
+  g_return_if_fail (abr != NULL);
+  g_return_if_fail (GST_CLOCK_TIME_IS_VALID (now));
+
+  g_mutex_lock (&abr->lock);
+  abr->download_bytes += bytes;
+
+  if (!GST_CLOCK_TIME_IS_VALID (abr->chunk_start)) {
+    abr->chunk_start = now;
+    abr->chunk_bytes = 0;
+    goto done;
+  }
+
+  abr->chunk_bytes += bytes;
+  if (now >= abr->chunk_start + SAMPLE_MIN_DURATION) {
+    gst_adaptive_demux_abr_add_sample_unlocked (abr, abr->chunk_bytes,
+        now - abr->chunk_start);
+    abr->chunk_start = now;
+    abr->chunk_bytes = 0;
+    abr->download_samples++;
+  }
+
+done:
+  g_mutex_unlock (&abr->lock);
+}
+
+/**
+ * gst_adaptive_demux_abr_download_finished:
+ * @abr: a #GstAdaptiveDemuxAbr
+ * @now: monotonic time at which the download finished
+ *
+ * Adds the data received since the last sample. If the download was too
+ * short for any sample to be taken during it, one sample covering the
+ * whole download, including the request latency, is added instead.
+ *
+ * Since: 1.20
+ */
+void
+gst_adaptive_demux_abr_download_finished (GstAdaptiveDemuxAbr * abr,
+    GstClockTime now)
+{
+  g_return_if_fail (abr != NULL);
+  g_return_if_fail (GST_CLOCK_TIME_IS_VALID (now));
+
+  g_mutex_lock (&abr->lock);
+  if (!GST_CLOCK_TIME_IS_VALID (abr->chunk_start))
+    goto done;
+
+  if (abr->download_samples == 0) {
+    GstClockTime start = abr->download_start;
+
+    if (!GST_CLOCK_TIME_IS_VALID (start))
+      start = abr->chunk_start;
+    if (now > start && abr->download_bytes > 0)
+      gst_adaptive_demux_abr_add_sample_unlocked (abr, abr->download_bytes,
+          now - start);
+  } else if (now > abr->chunk_start && abr->chunk_bytes > 0) {
+    gst_adaptive_demux_abr_add_sample_unlocked (abr, abr->chunk_bytes,
+        now - abr->chunk_start);
+  }
+
+done:
+  abr->download_start = GST_CLOCK_TIME_NONE;
+  abr->chunk_start = GST_CLOCK_TIME_NONE;
+  abr->chunk_bytes = 0;
+  abr->download_bytes = 0;
+  abr->download_samples = 0;
+
+  g_mutex_unlock (&abr->lock);
+}
+
+static guint64
+gst_adaptive_demux_abr_get_throughput_unlocked (GstAdaptiveDemuxAbr * abr)
+{
+  return (guint64) MIN (ewma_get (&abr->fast), ewma_get (&abr->slow));
+}
+
+/**
+ * gst_adaptive_demux_abr_get_throughput:
+ * @abr: a #GstAdaptiveDemuxAbr
+ *
+ * Returns: the estimated throughput in bits per second, or 0 if no sample
+ *   was added yet
+ *
+ * Since: 1.20
+ */
+guint64
+gst_adaptive_demux_abr_get_throughput (GstAdaptiveDemuxAbr * abr)
+{
+  guint64 ret;
+
+  g_return_val_if_fail (abr != NULL, 0);
+
+  g_mutex_lock (&abr->lock);
+  ret = gst_adaptive_demux_abr_get_throughput_unlocked (abr);
+  g_mutex_unlock (&abr->lock);
+
+  return ret;
+}
+
+/* Index of the highest bitrate that fits in the available bandwidth,
+ * or the lowest one if none does */
+static guint
+select_throughput (const guint64 * bitrates, guint n_bitrates,
+    guint64 available)
+{
+  guint i, ret = 0;
+
+  for (i = 0; i < n_bitrates; i++) {
+    if (bitrates[i] <= available)
+      ret = i;
+  }
+
+  return ret;
+}
+
+/* Index of the bitrate maximizing the BOLA objective for the buffer level.
+ * Utilities are ln (bitrate) shifted to be 1 for the lowest bitrate and
+ * the control parameters are chosen so that the lowest bitrate is used
+ * below BOLA_MIN_BUFFER and the highest one once the buffer target is
+ * reached. */
+static guint
+select_bola (const guint64 * bitrates, guint n_bitrates,
+    GstClockTime buffer_level)
+{
+  gdouble buffer = (gdouble) buffer_level / GST_SECOND;
+  gdouble buffer_target, max_utility, gp, vp, best_score = -G_MAXDOUBLE;
+  guint i, ret = 0;
+
+  if (n_bitrates < 2 || bitrates[0] == 0)
+    return 0;
+
+  buffer_target = MAX (BOLA_STABLE_BUFFER,
+      BOLA_MIN_BUFFER + BOLA_BUFFER_PER_LEVEL * n_bitrates);
+  max_utility = log ((gdouble) bitrates[n_bitrates - 1] / bitrates[0]) + 1;
+  gp = (max_utility - 1) / (buffer_target / BOLA_MIN_BUFFER - 1);
+  vp = BOLA_MIN_BUFFER / gp;
+
+  for (i = 0; i < n_bitrates; i++) {
+    gdouble utility = log ((gdouble) bitrates[i] / bitrates[0]) + 1;
+    gdouble score = (vp * (utility + gp) - buffer) / bitrates[i];
+
+    if (score >= best_score) {
+      best_score = score;
+      ret = i;
+    }
+  }
+
+  return ret;
+}
+
+/**
+ * gst_adaptive_demux_abr_select_bitrate:
+ * @abr: a #GstAdaptiveDemuxAbr
+ * @bitrates: (array length=n_bitrates) (allow-none): the bitrates of the
+ *   available representations, in ascending order
+ * @n_bitrates: the number of elements in @bitrates
+ * @buffer_level: duration of the media downloaded but not played yet, or
+ *   %GST_CLOCK_TIME_NONE if unknown
+ * @bandwidth_usage: fraction of the estimated throughput that can be used
+ *
+ * Chooses the bitrate of the next fragment. Buffer based policies need both
+ * @bitrates and @buffer_level and fall back to the throughput otherwise.
+ *
+ * Returns: one of @bitrates, or the usable bandwidth in bits per second
+ *   if @bitrates is empty
+ *
+ * Since: 1.20
+ */
+guint64
+gst_adaptive_demux_abr_select_bitrate (GstAdaptiveDemuxAbr * abr,
+    const guint64 * bitrates, guint n_bitrates, GstClockTime buffer_level,
+    gdouble bandwidth_usage)
+{
+  guint64 throughput, available;
+  guint index, bola_index, last_index;
+
+  g_return_val_if_fail (abr != NULL, 0);
+  g_return_val_if_fail (bitrates != NULL || n_bitrates == 0, 0);
+
+  g_mutex_lock (&abr->lock);
+
+  throughput = gst_adaptive_demux_abr_get_throughput_unlocked (abr);
+  available = throughput * bandwidth_usage;
+
+  if (n_bitrates == 0) {
+    g_mutex_unlock (&abr->lock);
+    return available;
+  }
+
+  index = select_throughput (bitrates, n_bitrates, available);
+
+  if (GST_CLOCK_TIME_IS_VALID (buffer_level)) {
+    gdouble buffer = (gdouble) buffer_level / GST_SECOND;
+
+    switch (abr->policy) {
+      case GST_ADAPTIVE_DEMUX_ABR_POLICY_BOLA:
+        index = select_bola (bitrates, n_bitrates, buffer_level);
+        break;
+      case GST_ADAPTIVE_DEMUX_ABR_POLICY_HYBRID:
+        if (abr->buffer_based && buffer < HYBRID_LEAVE_BOLA_BUFFER)
+          abr->buffer_based = FALSE;
+        else if (!abr->buffer_based && buffer >= BOLA_STABLE_BUFFER)
+          abr->buffer_based = TRUE;
+
+        if (!abr->buffer_based)
+          break;
+
+        /* The buffer can only make us pick a higher bitrate than the
+         * throughput allows, a low buffer is handled by going back to
+         * throughput based selection. To avoid oscillating, BOLA does not
+         * switch up to a bitrate the link can't sustain (BOLA-O) */
+        bola_index = select_bola (bitrates, n_bitrates, buffer_level);
+        last_index = select_throughput (bitrates, n_bitrates,
+            abr->last_bitrate);
+        if (bola_index > last_index)
+          bola_index = MIN (bola_index, MAX (last_index,
+                  select_throughput (bitrates, n_bitrates, throughput)));
+        index = MAX (index, bola_index);
+        break;
+      default:
+        break;
+    }
+  }
+
+  GST_DEBUG ("policy %d throughput %" G_GUINT64_FORMAT " bps buffer %"
+      GST_TIME_FORMAT ": selected %" G_GUINT64_FORMAT " bps", abr->policy,
+      throughput, GST_TIME_ARGS (buffer_level), bitrates[index]);
+
+  abr->last_bitrate = bitrates[index];
+  g_mutex_unlock (&abr->lock);
+
+  return bitrates[index];
+}
@@ -0,0 +1,114 @@
+/* GStreamer
+ *
+ * Copyright (C) 2026 agent <agent@local>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef _GST_ADAPTIVE_DEMUX_ABR_H_
+#define _GST_ADAPTIVE_DEMUX_ABR_H_
+
+#include <gst/gst.h>
+#include <gst/adaptivedemux/adaptive-demux-prelude.h>
+
+G_BEGIN_DECLS
+
+/**
+ * GstAdaptiveDemuxAbrPolicy:
+ * @GST_ADAPTIVE_DEMUX_ABR_POLICY_MOVING_AVERAGE: average of the download
+ *   rate of the last fragments, scaled by #GstAdaptiveDemux:bitrate-limit
+ * @GST_ADAPTIVE_DEMUX_ABR_POLICY_THROUGHPUT: EWMA of the download rate of
+ *   the received chunks, scaled by #GstAdaptiveDemux:bitrate-limit
+ * @GST_ADAPTIVE_DEMUX_ABR_POLICY_BOLA: buffer based selection (BOLA)
+ * @GST_ADAPTIVE_DEMUX_ABR_POLICY_HYBRID: throughput based selection while
+ *   the buffer is low, BOLA once it is filled
+ *
+ * The algorithm used to choose the bitrate of the next fragments.
+ *
+ * Since: 1.20
+ */
+typedef enum
+{
+  GST_ADAPTIVE_DEMUX_ABR_POLICY_MOVING_AVERAGE,
+  GST_ADAPTIVE_DEMUX_ABR_POLICY_THROUGHPUT,
+  GST_ADAPTIVE_DEMUX_ABR_POLICY_BOLA,
+  GST_ADAPTIVE_DEMUX_ABR_POLICY_HYBRID,
+} GstAdaptiveDemuxAbrPolicy;
+
+#define GST_TYPE_ADAPTIVE_DEMUX_ABR_POLICY \
+  (gst_adaptive_demux_abr_policy_get_type())
+
+/**
+ * GstAdaptiveDemuxAbr:
+ *
+ * Opaque bitrate adaptation state of a stream. It gathers download rate
+ * samples and chooses the bitrate of the next fragment according to its
+ * #GstAdaptiveDemuxAbrPolicy.
+ *
+ * Since: 1.20
+ */
+typedef struct _GstAdaptiveDemuxAbr GstAdaptiveDemuxAbr;
+
+GST_ADAPTIVE_DEMUX_API
+GType                gst_adaptive_demux_abr_policy_get_type (void);
+
+GST_ADAPTIVE_DEMUX_API
+GstAdaptiveDemuxAbr *gst_adaptive_demux_abr_new (GstAdaptiveDemuxAbrPolicy policy);
+
+GST_ADAPTIVE_DEMUX_API
+void                 gst_adaptive_demux_abr_free (GstAdaptiveDemuxAbr * abr);
+
+GST_ADAPTIVE_DEMUX_API
+GstAdaptiveDemuxAbrPolicy gst_adaptive_demux_abr_get_policy (GstAdaptiveDemuxAbr * abr);
+
+GST_ADAPTIVE_DEMUX_API
+void                 gst_adaptive_demux_abr_set_policy (GstAdaptiveDemuxAbr * abr,
+                                                        GstAdaptiveDemuxAbrPolicy policy);
+
+GST_ADAPTIVE_DEMUX_API
+void                 gst_adaptive_demux_abr_download_started (GstAdaptiveDemuxAbr * abr,
+                                                              GstClockTime now);
+
+GST_ADAPTIVE_DEMUX_API
+void                 gst_adaptive_demux_abr_reset (GstAdaptiveDemuxAbr * abr);
+
+GST_ADAPTIVE_DEMUX_API
+void                 gst_adaptive_demux_abr_add_sample (GstAdaptiveDemuxAbr * abr,
+                                                        guint64 bytes,
+                                                        GstClockTime duration);
+
+GST_ADAPTIVE_DEMUX_API
+void                 gst_adaptive_demux_abr_data_received (GstAdaptiveDemuxAbr * abr,
+                                                           guint64 bytes,
+                                                           GstClockTime now);
+
+GST_ADAPTIVE_DEMUX_API
+void                 gst_adaptive_demux_abr_download_finished (GstAdaptiveDemuxAbr * abr,
+                                                               GstClockTime now);
+
+GST_ADAPTIVE_DEMUX_API
+guint64              gst_adaptive_demux_abr_get_throughput (GstAdaptiveDemuxAbr * abr);
+
+GST_ADAPTIVE_DEMUX_API
+guint64              gst_adaptive_demux_abr_select_bitrate (GstAdaptiveDemuxAbr * abr,
+                                                            const guint64 * bitrates,
+                                                            guint n_bitrates,
+                                                            GstClockTime buffer_level,
+                                                            gdouble bandwidth_usage);
+
+G_END_DECLS
+
+#endif /* _GST_ADAPTIVE_DEMUX_ABR_H_ */
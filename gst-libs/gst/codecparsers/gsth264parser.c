@@ -1411,6 +1411,39 @@ gst_h264_nal_parser_free (GstH264NalParser * nalparser)
   nalparser = NULL;
 }
 
+/* Fills @nalu from the start code prefix found at @off1 from @offset */
+static GstH264ParserResult
+gst_h264_parser_identify_nalu_at (const guint8 * data, guint offset,
+    gsize size, guint off1, GstH264NalUnit * nalu)
+{
+  nalu->sc_offset = offset + off1;
+
+  /* sc might have 2 or 3 0-bytes */
+  if (nalu->sc_offset > 0 && data[nalu->sc_offset - 1] == 00)
+    nalu->sc_offset--;
+
+  nalu->offset = offset + off1 + 3;
+  nalu->data = (guint8 *) data;
+  nalu->size = size - nalu->offset;
+
+  if (!gst_h264_parse_nalu_header (nalu)) {
+    GST_WARNING ("error parsing \"NAL unit header\"");
+    nalu->size = 0;
+    return GST_H264_PARSER_BROKEN_DATA;
+  }
+
+  nalu->valid = TRUE;
+
+  if (nalu->type == GST_H264_NAL_SEQ_END ||
+      nalu->type == GST_H264_NAL_STREAM_END) {
+    GST_DEBUG ("end-of-seq or end-of-stream nal found");
+    nalu->size = 1;
+    return GST_H264_PARSER_OK;
+  }
+
+  return GST_H264_PARSER_OK;
+}
+
 /**
  * gst_h264_parser_identify_nalu_unchecked:
  * @nalparser: a #GstH264NalParser
@@ -1450,32 +1483,7 @@ gst_h264_parser_identify_nalu_unchecked (GstH264NalParser * nalparser,
     return GST_H264_PARSER_NO_NAL;
   }
 
-  nalu->sc_offset = offset + off1;
-
-  /* sc might have 2 or 3 0-bytes */
-  if (nalu->sc_offset > 0 && data[nalu->sc_offset - 1] == 00)
-    nalu->sc_offset--;
-
-  nalu->offset = offset + off1 + 3;
-  nalu->data = (guint8 *) data;
-  nalu->size = size - nalu->offset;
-
-  if (!gst_h264_parse_nalu_header (nalu)) {
-    GST_WARNING ("error parsing \"NAL unit header\"");
-    nalu->size = 0;
-    return GST_H264_PARSER_BROKEN_DATA;
-  }
-
-  nalu->valid = TRUE;
-
-  if (nalu->type == GST_H264_NAL_SEQ_END ||
-      nalu->type == GST_H264_NAL_STREAM_END) {
-    GST_DEBUG ("end-of-seq or end-of-stream nal found");
-    nalu->size = 1;
-    return GST_H264_PARSER_OK;
-  }
-
-  return GST_H264_PARSER_OK;
+  return gst_h264_parser_identify_nalu_at (data, offset, size, off1, nalu);
 }
 
 /**
@@ -1496,11 +1504,26 @@ gst_h264_parser_identify_nalu (GstH264NalParser * nalparser,
     const guint8 * data, guint offset, gsize size, GstH264NalUnit * nalu)
 {
   GstH264ParserResult res;
+  guint sc[2], n_sc;
   gint off2;
 
-  res =
-      gst_h264_parser_identify_nalu_unchecked (nalparser, data, offset, size,
-      nalu);
+  memset (nalu, 0, sizeof (*nalu));
+
+  if (size < offset + 4) {
+    GST_DEBUG ("Can't parse, buffer has too small size %" G_GSIZE_FORMAT
+        ", offset %u", size, offset);
+    return GST_H264_PARSER_ERROR;
+  }
+
+  /* Find the start code of this NAL and the one of the next NAL, which
+   * ends it, in a single pass */
+  n_sc = scan_for_all_start_codes (data + offset, size - offset, sc, 2);
+  if (n_sc == 0) {
+    GST_DEBUG ("No start code prefix in this buffer");
+    return GST_H264_PARSER_NO_NAL;
+  }
+
+  res = gst_h264_parser_identify_nalu_at (data, offset, size, sc[0], nalu);
 
   if (res != GST_H264_PARSER_OK)
     goto beach;
@@ -1511,12 +1534,12 @@ gst_h264_parser_identify_nalu (GstH264NalParser * nalparser,
       nalu->type == GST_H264_NAL_STREAM_END)
     goto beach;
 
-  off2 = scan_for_start_codes (data + nalu->offset, size - nalu->offset);
-  if (off2 < 0) {
+  if (n_sc < 2) {
     GST_DEBUG ("Nal start %d, No end found", nalu->offset);
 
     return GST_H264_PARSER_NO_NAL_END;
   }
+  off2 = offset + sc[1] - nalu->offset;
 
   /* Mini performance improvement:
    * We could have a way to store how many 0s were skipped to avoid
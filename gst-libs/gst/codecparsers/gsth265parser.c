@@ -1373,6 +1373,45 @@ gst_h265_parser_free (GstH265Parser * parser)
   parser = NULL;
 }
 
+/* Fills @nalu from the start code prefix found at @off1 from @offset */
+static GstH265ParserResult
+gst_h265_parser_identify_nalu_at (const guint8 * data, guint offset,
+    gsize size, guint off1, GstH265NalUnit * nalu)
+{
+  nalu->sc_offset = offset + off1;
+
+  /* The scanner ensures one byte passed the start code but to
+   * identify an HEVC NAL, we need 2. */
+  if (size - nalu->sc_offset - 3 < 2) {
+    GST_DEBUG ("Not enough bytes after start code to identify");
+    return GST_H265_PARSER_NO_NAL;
+  }
+
+  /* sc might have 2 or 3 0-bytes */
+  if (nalu->sc_offset > 0 && data[nalu->sc_offset - 1] == 00)
+    nalu->sc_offset--;
+
+  nalu->offset = offset + off1 + 3;
+  nalu->data = (guint8 *) data;
+  nalu->size = size - nalu->offset;
+
+  if (!gst_h265_parse_nalu_header (nalu)) {
+    GST_WARNING ("error parsing \"NAL unit header\"");
+    nalu->size = 0;
+    return GST_H265_PARSER_BROKEN_DATA;
+  }
+
+  nalu->valid = TRUE;
+
+  if (nalu->type == GST_H265_NAL_EOS || nalu->type == GST_H265_NAL_EOB) {
+    GST_DEBUG ("end-of-seq or end-of-stream nal found");
+    nalu->size = 2;
+    return GST_H265_PARSER_OK;
+  }
+
+  return GST_H265_PARSER_OK;
+}
+
 /**
  * gst_h265_parser_identify_nalu_unchecked:
  * @parser: a #GstH265Parser
@@ -1412,38 +1451,7 @@ gst_h265_parser_identify_nalu_unchecked (GstH265Parser * parser,
     return GST_H265_PARSER_NO_NAL;
   }
 
-  nalu->sc_offset = offset + off1;
-
-  /* The scanner ensures one byte passed the start code but to
-   * identify an HEVC NAL, we need 2. */
-  if (size - nalu->sc_offset - 3 < 2) {
-    GST_DEBUG ("Not enough bytes after start code to identify");
-    return GST_H265_PARSER_NO_NAL;
-  }
-
-  /* sc might have 2 or 3 0-bytes */
-  if (nalu->sc_offset > 0 && data[nalu->sc_offset - 1] == 00)
-    nalu->sc_offset--;
-
-  nalu->offset = offset + off1 + 3;
-  nalu->data = (guint8 *) data;
-  nalu->size = size - nalu->offset;
-
-  if (!gst_h265_parse_nalu_header (nalu)) {
-    GST_WARNING ("error parsing \"NAL unit header\"");
-    nalu->size = 0;
-    return GST_H265_PARSER_BROKEN_DATA;
-  }
-
-  nalu->valid = TRUE;
-
-  if (nalu->type == GST_H265_NAL_EOS || nalu->type == GST_H265_NAL_EOB) {
-    GST_DEBUG ("end-of-seq or end-of-stream nal found");
-    nalu->size = 2;
-    return GST_H265_PARSER_OK;
-  }
-
-  return GST_H265_PARSER_OK;
+  return gst_h265_parser_identify_nalu_at (data, offset, size, off1, nalu);
 }
 
 /**
@@ -1463,11 +1471,26 @@ gst_h265_parser_identify_nalu (GstH265Parser * parser,
     const guint8 * data, guint offset, gsize size, GstH265NalUnit * nalu)
 {
   GstH265ParserResult res;
+  guint sc[2], n_sc;
   gint off2;
 
-  res =
-      gst_h265_parser_identify_nalu_unchecked (parser, data, offset, size,
-      nalu);
+  memset (nalu, 0, sizeof (*nalu));
+
+  if (size < offset + 4) {
+    GST_DEBUG ("Can't parse, buffer has too small size %" G_GSIZE_FORMAT
+        ", offset %u", size, offset);
+    return GST_H265_PARSER_ERROR;
+  }
+
+  /* Find the start code of this NAL and the one of the next NAL, which
+   * ends it, in a single pass */
+  n_sc = scan_for_all_start_codes (data + offset, size - offset, sc, 2);
+  if (n_sc == 0) {
+    GST_DEBUG ("No start code prefix in this buffer");
+    return GST_H265_PARSER_NO_NAL;
+  }
+
+  res = gst_h265_parser_identify_nalu_at (data, offset, size, sc[0], nalu);
 
   if (res != GST_H265_PARSER_OK)
     goto beach;
@@ -1477,12 +1500,12 @@ gst_h265_parser_identify_nalu (GstH265Parser * parser,
   if (nalu->type == GST_H265_NAL_EOS || nalu->type == GST_H265_NAL_EOB)
     goto beach;
 
-  off2 = scan_for_start_codes (data + nalu->offset, size - nalu->offset);
-  if (off2 < 0) {
+  if (n_sc < 2) {
     GST_DEBUG ("Nal start %d, No end found", nalu->offset);
 
     return GST_H265_PARSER_NO_NAL_END;
   }
+  off2 = offset + sc[1] - nalu->offset;
 
   /* Callers assumes that enough data will available to identify the next NAL,
    * but scan_for_start_codes() only ensure 1 extra byte is available. Ensure
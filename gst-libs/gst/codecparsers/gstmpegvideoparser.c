@@ -39,6 +39,7 @@
 
 #include "gstmpegvideoparser.h"
 #include "parserutils.h"
+#include "nalutils.h"
 
 #include <string.h>
 #include <gst/base/gstbitreader.h>
@@ -188,40 +189,6 @@ set_fps_from_code (GstMpegVideoSequenceHdr * seqhdr, guint8 fps_code)
   }
 }
 
-/* @size and @offset are wrt current reader position */
-static inline gint
-scan_for_start_codes (const GstByteReader * reader, guint offset, guint size)
-{
-  const guint8 *data;
-  guint i = 0;
-
-  g_assert ((guint64) offset + size <= reader->size - reader->byte);
-
-  /* we can't find the pattern with less than 4 bytes */
-  if (G_UNLIKELY (size < 4))
-    return -1;
-
-  data = reader->data + reader->byte + offset;
-
-  while (i <= (size - 4)) {
-    if (data[i + 2] > 1) {
-      i += 3;
-    } else if (data[i + 1]) {
-      i += 2;
-    } else if (data[i] || data[i + 2] != 1) {
-      i++;
-    } else {
-      break;
-    }
-  }
-
-  if (i <= (size - 4))
-    return offset + i;
-
-  /* nothing found */
-  return -1;
-}
-
 /****** API *******/
 
 /**
@@ -242,48 +209,38 @@ gboolean
 gst_mpeg_video_parse (GstMpegVideoPacket * packet,
     const guint8 * data, gsize size, guint offset)
 {
-  gint off;
-  GstByteReader br;
+  guint sc[3], n_sc, i;
 
   if (size <= offset) {
     GST_DEBUG ("Can't parse from offset %d, buffer is to small", offset);
     return FALSE;
   }
 
-  size -= offset;
-  gst_byte_reader_init (&br, &data[offset], size);
-
-  off = scan_for_start_codes (&br, 0, size);
+  /* Find the start code of this packet and the one ending it in a single
+   * pass. The scanner guarantees a byte after each start code prefix, which
+   * is the packet type */
+  n_sc = scan_for_all_start_codes (data + offset, size - offset, sc, 3);
 
-  if (off < 0) {
+  if (n_sc == 0) {
     GST_DEBUG ("No start code prefix in this buffer");
     return FALSE;
   }
 
-  if (gst_byte_reader_skip (&br, off + 3) == FALSE)
-    goto failed;
-
-  if (gst_byte_reader_get_uint8 (&br, &packet->type) == FALSE)
-    goto failed;
-
+  packet->type = data[offset + sc[0] + 3];
   packet->data = data;
-  packet->offset = offset + off + 4;
+  packet->offset = offset + sc[0] + 4;
   packet->size = -1;
 
-  /* try to find end of packet */
-  size -= off + 4;
-  off = scan_for_start_codes (&br, 0, size);
-
-  if (off >= 0)
-    packet->size = off;
+  /* The end of the packet is the next start code after the type byte, a
+   * prefix starting at the type byte doesn't count */
+  for (i = 1; i < n_sc; i++) {
+    if (sc[i] >= sc[0] + 4) {
+      packet->size = sc[i] - sc[0] - 4;
+      break;
+    }
+  }
 
   return TRUE;
-
-failed:
-  {
-    GST_WARNING ("Failed to parse");
-    return FALSE;
-  }
 }
 
 /**
@@ -38,6 +38,14 @@
 #include "nalutils.h"
 #include <string.h>
 
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
 /* Compute Ceil(Log2(v)) */
 /* Derived from branchless code for integer log2(v) from:
    <http://graphics.stanford.edu/~seander/bithacks.html#IntegerLog> */
@@ -64,6 +72,34 @@ ceil_log2 (guint32 v)
 
 /****** Nal parser ******/
 
+/* Non-zero if any of the 4 bytes of @v is zero */
+#define HAS_ZERO_BYTE32(v) \
+  (((v) - 0x01010101U) & ~(v) & 0x80808080U)
+
+/* Caches the next 4 bytes at once if none of them is 0x03, as none of them
+ * can be an emulation prevention byte then */
+static inline gboolean
+nal_reader_read_word (NalReader * nr)
+{
+  guint32 word;
+
+  if (nr->bits_in_cache > 32 || nr->byte + 4 > nr->size)
+    return FALSE;
+
+  word = GST_READ_UINT32_BE (nr->data + nr->byte);
+  if (HAS_ZERO_BYTE32 (word ^ 0x03030303U))
+    return FALSE;
+
+  nr->cache = (nr->cache << 32) | ((guint64) nr->first_byte << 24) |
+      (word >> 8);
+  nr->first_byte = word & 0xff;
+  nr->epb_cache = word;
+  nr->byte += 4;
+  nr->bits_in_cache += 32;
+
+  return TRUE;
+}
+
 void
 nal_reader_init (NalReader * nr, const guint8 * data, guint size)
 {
@@ -91,6 +127,9 @@ nal_reader_read (NalReader * nr, guint nbits)
   while (nr->bits_in_cache < nbits) {
     guint8 byte;
 
+    if (nal_reader_read_word (nr))
+      continue;
+
   next_byte:
     if (G_UNLIKELY (nr->byte >= nr->size))
       return FALSE;
@@ -162,20 +201,28 @@ nal_reader_get_epb_count (const NalReader * nr)
   return nr->n_epb;
 }
 
+/* The cache can hold up to 64 bits ahead of the current position, the last
+ * byte of which is stored in first_byte */
+#define NAL_READER_CACHED_BITS(nr) \
+  (((nr)->cache << 8) | (nr)->first_byte)
+
 #define NAL_READER_READ_BITS(bits) \
 gboolean \
 nal_reader_get_bits_uint##bits (NalReader *nr, guint##bits *val, guint nbits) \
 { \
   guint shift; \
   \
-  if (!nal_reader_read (nr, nbits)) \
+  if (G_UNLIKELY (nbits == 0)) { \
+    *val = 0; \
+    return TRUE; \
+  } \
+  \
+  if (nr->bits_in_cache < nbits && !nal_reader_read (nr, nbits)) \
     return FALSE; \
   \
   /* bring the required bits down and truncate */ \
   shift = nr->bits_in_cache - nbits; \
-  *val = nr->first_byte >> shift; \
-  \
-  *val |= nr->cache << (8 - shift); \
+  *val = NAL_READER_CACHED_BITS (nr) >> shift; \
   /* mask out required bits */ \
   if (nbits < bits) \
     *val &= ((guint##bits)1 << nbits) - 1; \
@@ -208,6 +255,23 @@ nal_reader_get_ue (NalReader * nr, guint32 * val)
   guint8 bit;
   guint32 value;
 
+  /* Fast path: codes of up to 31 bits (values below 65535) are decoded in
+   * one go from the next 32 bits. Those are only cached ahead if that
+   * doesn't involve skipping an emulation prevention byte, so that the
+   * position and epb count stay the same as when reading bit by bit */
+  if (G_LIKELY (nr->bits_in_cache >= 32 || nal_reader_read_word (nr))) {
+    value = NAL_READER_CACHED_BITS (nr) >> (nr->bits_in_cache - 32);
+
+    if (G_LIKELY (value & 0xffff0000)) {
+      guint len = 2 * (32 - g_bit_storage (value)) + 1;
+
+      *val = (value >> (32 - len)) - 1;
+      nr->bits_in_cache -= len;
+
+      return TRUE;
+    }
+  }
+
   if (G_UNLIKELY (!nal_reader_get_bits_uint8 (nr, &bit, 1)))
     return FALSE;
 
@@ -247,7 +311,7 @@ nal_reader_get_se (NalReader * nr, gint32 * val)
 gboolean
 nal_reader_is_byte_aligned (NalReader * nr)
 {
-  if (nr->bits_in_cache != 0)
+  if (nr->bits_in_cache % 8 != 0)
     return FALSE;
   return TRUE;
 }
@@ -295,15 +359,143 @@ nal_reader_has_more_data (NalReader * nr)
 
 /***********  end of nal parser ***************/
 
+/* Non-zero if any of the 8 bytes of @v is zero */
+#define HAS_ZERO_BYTE(v) \
+  (((v) - G_GUINT64_CONSTANT (0x0101010101010101)) & ~(v) & \
+      G_GUINT64_CONSTANT (0x8080808080808080))
+
+/* Returns the offset of the first 0x000001 start code prefix in @data at or
+ * after @i, or -1 if there is none. Like gst_byte_reader_masked_scan_uint32()
+ * with the 0xffffff00/0x00000100 mask/pattern, at least one byte must follow
+ * the prefix for it to be returned.
+ *
+ * With SSE2, AVX2 or NEON, the three bytes of the prefix are compared at
+ * every position of a 16 or 32 byte block at once. Otherwise, coded slice
+ * data rarely containing zero bytes, words of 8 bytes that don't contain
+ * any are skipped at once. Either is much faster than looking at the data
+ * byte by byte on high bitrate streams. */
+static gint
+scan_for_start_codes_from (const guint8 * data, guint i, guint size)
+{
+  /* NALU not empty, so we can at least expect 1 (even 2) bytes following sc */
+  if (G_UNLIKELY (size < 4))
+    return -1;
+
+#if defined(__AVX2__)
+  {
+    const __m256i zero = _mm256_setzero_si256 ();
+    const __m256i one = _mm256_set1_epi8 (1);
+
+    for (; i + 34 <= size; i += 32) {
+      __m256i b0 = _mm256_loadu_si256 ((const __m256i *) (data + i));
+      __m256i b1 = _mm256_loadu_si256 ((const __m256i *) (data + i + 1));
+      __m256i b2 = _mm256_loadu_si256 ((const __m256i *) (data + i + 2));
+      guint32 mask;
+
+      mask = _mm256_movemask_epi8 (_mm256_and_si256 (_mm256_and_si256
+              (_mm256_cmpeq_epi8 (b0, zero), _mm256_cmpeq_epi8 (b1, zero)),
+              _mm256_cmpeq_epi8 (b2, one)));
+      if (mask) {
+        i += g_bit_nth_lsf (mask, -1);
+        return i <= size - 4 ? (gint) i : -1;
+      }
+    }
+  }
+#elif defined(__SSE2__)
+  {
+    const __m128i zero = _mm_setzero_si128 ();
+    const __m128i one = _mm_set1_epi8 (1);
+
+    for (; i + 18 <= size; i += 16) {
+      __m128i b0 = _mm_loadu_si128 ((const __m128i *) (data + i));
+      __m128i b1 = _mm_loadu_si128 ((const __m128i *) (data + i + 1));
+      __m128i b2 = _mm_loadu_si128 ((const __m128i *) (data + i + 2));
+      guint mask;
+
+      mask = _mm_movemask_epi8 (_mm_and_si128 (_mm_and_si128
+              (_mm_cmpeq_epi8 (b0, zero), _mm_cmpeq_epi8 (b1, zero)),
+              _mm_cmpeq_epi8 (b2, one)));
+      if (mask) {
+        i += g_bit_nth_lsf (mask, -1);
+        return i <= size - 4 ? (gint) i : -1;
+      }
+    }
+  }
+#elif defined(__ARM_NEON)
+  {
+    const uint8x16_t zero = vdupq_n_u8 (0);
+    const uint8x16_t one = vdupq_n_u8 (1);
+
+    for (; i + 18 <= size; i += 16) {
+      uint8x16_t m;
+      uint8x8_t r;
+
+      m = vandq_u8 (vandq_u8 (vceqq_u8 (vld1q_u8 (data + i), zero),
+              vceqq_u8 (vld1q_u8 (data + i + 1), zero)),
+          vceqq_u8 (vld1q_u8 (data + i + 2), one));
+      r = vorr_u8 (vget_low_u8 (m), vget_high_u8 (m));
+      /* the scalar code below finds the exact position */
+      if (vget_lane_u64 (vreinterpret_u64_u8 (r), 0))
+        break;
+    }
+  }
+#endif
+
+  while (i <= size - 4) {
+    if (i + 8 <= size) {
+      guint64 v;
+
+      memcpy (&v, data + i, sizeof (v));
+      if (!HAS_ZERO_BYTE (v)) {
+        i += 8;
+        continue;
+      }
+    }
+
+    if (data[i + 2] > 1) {
+      i += 3;
+    } else if (data[i + 1]) {
+      i += 2;
+    } else if (data[i] || data[i + 2] != 1) {
+      i++;
+    } else {
+      return i;
+    }
+  }
+
+  return -1;
+}
+
+/* Returns the offset of the first 0x000001 start code prefix in @data, or -1
+ * if there is none */
 gint
 scan_for_start_codes (const guint8 * data, guint size)
 {
-  GstByteReader br;
-  gst_byte_reader_init (&br, data, size);
+  return scan_for_start_codes_from (data, 0, size);
+}
 
-  /* NALU not empty, so we can at least expect 1 (even 2) bytes following sc */
-  return gst_byte_reader_masked_scan_uint32 (&br, 0xffffff00, 0x00000100,
-      0, size);
+/* Stores the offsets of up to @n_offsets start code prefixes of @data in
+ * @offsets, in a single pass over the data, and returns how many were found.
+ * The offsets are the ones scan_for_start_codes() would return when called
+ * again right after each prefix. */
+guint
+scan_for_all_start_codes (const guint8 * data, guint size, guint * offsets,
+    guint n_offsets)
+{
+  guint n = 0, i = 0;
+
+  while (n < n_offsets) {
+    gint off = scan_for_start_codes_from (data, i, size);
+
+    if (off < 0)
+      break;
+
+    offsets[n++] = off;
+    /* start code prefixes can't overlap */
+    i = off + 3;
+  }
+
+  return n;
 }
 
 void
@@ -196,6 +196,10 @@ gboolean nal_reader_get_se (NalReader * nr, gint32 * val);
 G_GNUC_INTERNAL
 gint scan_for_start_codes (const guint8 * data, guint size);
 
+G_GNUC_INTERNAL
+guint scan_for_all_start_codes (const guint8 * data, guint size,
+    guint * offsets, guint n_offsets);
+
 G_GNUC_INTERNAL
 void nal_writer_init (NalWriter * nw, guint nal_prefix_size, gboolean packetized);
 
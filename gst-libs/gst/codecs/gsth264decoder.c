@@ -1752,9 +1752,31 @@ gst_h264_decoder_drain_output_queue (GstH264Decoder * self, guint num)
   while (gst_queue_array_get_length (priv->output_queue) > num) {
     GstH264DecoderOutputFrame *output_frame = (GstH264DecoderOutputFrame *)
         gst_queue_array_pop_head_struct (priv->output_queue);
-    priv->last_ret =
-        klass->output_picture (self, output_frame->frame,
+    GstFlowReturn ret;
+
+    /* Pictures might have been submitted asynchronously by end_picture(),
+     * only block on their completion once they are really needed */
+    if (klass->wait_picture) {
+      ret = klass->wait_picture (self, output_frame->picture);
+
+      if (ret != GST_FLOW_OK) {
+        GST_WARNING_OBJECT (self, "Failed to wait for picture %p (poc %d), %s",
+            output_frame->picture, output_frame->picture->pic_order_cnt,
+            gst_flow_get_name (ret));
+        gst_video_decoder_drop_frame (GST_VIDEO_DECODER (self),
+            output_frame->frame);
+        gst_h264_picture_unref (output_frame->picture);
+        priv->last_ret = ret;
+        continue;
+      }
+    }
+
+    ret = klass->output_picture (self, output_frame->frame,
         output_frame->picture);
+
+    /* Don't let the following pictures hide the error of a dropped one */
+    if (priv->last_ret == GST_FLOW_OK)
+      priv->last_ret = ret;
   }
 }
 
@@ -2429,6 +2451,10 @@ gst_h264_decoder_process_sps (GstH264Decoder * self, GstH264SPS * sps)
     if (klass->get_preferred_output_delay) {
       priv->preferred_output_delay =
           klass->get_preferred_output_delay (self, priv->is_live);
+    } else if (klass->wait_picture && !priv->is_live) {
+      /* Keep one picture in flight so that parsing and submission of the
+       * next picture overlaps with decoding of the current one */
+      priv->preferred_output_delay = 1;
     } else {
       priv->preferred_output_delay = 0;
     }
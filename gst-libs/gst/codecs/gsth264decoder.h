@@ -234,6 +234,27 @@ struct _GstH264DecoderClass
   guint (*get_preferred_output_delay)   (GstH264Decoder * decoder,
                                          gboolean live);
 
+  /**
+   * GstH264DecoderClass::wait_picture:
+   * @decoder: a #GstH264Decoder
+   * @picture: (transfer none): a #GstH264Picture
+   *
+   * Optional. Called right before @picture is passed to output_picture().
+   * Subclass implementing this method can submit pictures asynchronously
+   * from end_picture() and block on their completion here instead, which
+   * allows baseclass to parse and prepare the following pictures while
+   * the hardware is still decoding.
+   *
+   * If get_preferred_output_delay() is not implemented, baseclass
+   * will delay output by one picture for non-live streams.
+   *
+   * Returns: %GST_FLOW_OK if @picture was successfully decoded
+   *
+   * Since: 1.20
+   */
+  GstFlowReturn (*wait_picture)         (GstH264Decoder * decoder,
+                                         GstH264Picture * picture);
+
   /*< private >*/
   gpointer padding[GST_PADDING_LARGE];
 };
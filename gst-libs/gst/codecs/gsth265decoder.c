@@ -124,8 +124,26 @@ struct _GstH265DecoderPrivate
   GArray *ref_pic_list_tmp;
   GArray *ref_pic_list0;
   GArray *ref_pic_list1;
+
+  /* Optional slice header parsing worker pool. Only the parsing of the
+   * headers of consecutive slice NAL units is done in parallel, everything
+   * touching the per-picture state (dependent slice header inheritance,
+   * picture/DPB management and the decode_slice() vfunc) stays serialized
+   * in the streaming thread, in bitstream order */
+  guint slice_parse_threads;
+  GThreadPool *slice_parse_pool;
+  GArray *slice_batch;
+  GMutex slice_parse_lock;
+  GCond slice_parse_cond;
+  guint slice_parse_pending;
 };
 
+typedef struct
+{
+  GstH265Slice slice;
+  GstH265ParserResult pres;
+} GstH265SliceParseJob;
+
 #define parent_class gst_h265_decoder_parent_class
 G_DEFINE_ABSTRACT_TYPE_WITH_CODE (GstH265Decoder, gst_h265_decoder,
     GST_TYPE_VIDEO_DECODER,
@@ -186,6 +204,11 @@ gst_h265_decoder_init (GstH265Decoder * self)
       sizeof (GstH265Picture *), 32);
   priv->ref_pic_list1 = g_array_sized_new (FALSE, TRUE,
       sizeof (GstH265Picture *), 32);
+
+  priv->slice_batch = g_array_sized_new (FALSE, TRUE,
+      sizeof (GstH265SliceParseJob), 8);
+  g_mutex_init (&priv->slice_parse_lock);
+  g_cond_init (&priv->slice_parse_cond);
 }
 
 static void
@@ -197,10 +220,31 @@ gst_h265_decoder_finalize (GObject * object)
   g_array_unref (priv->ref_pic_list_tmp);
   g_array_unref (priv->ref_pic_list0);
   g_array_unref (priv->ref_pic_list1);
+  g_array_unref (priv->slice_batch);
+  g_mutex_clear (&priv->slice_parse_lock);
+  g_cond_clear (&priv->slice_parse_cond);
 
   G_OBJECT_CLASS (parent_class)->finalize (object);
 }
 
+static void
+gst_h265_decoder_slice_parse_func (GstH265SliceParseJob * job,
+    GstH265Decoder * self)
+{
+  GstH265DecoderPrivate *priv = self->priv;
+
+  /* Slice header parsing only reads the parameter sets stored in the parser,
+   * which are not updated while a batch of slices is in flight */
+  job->pres = gst_h265_parser_parse_slice_hdr (priv->parser,
+      &job->slice.nalu, &job->slice.header);
+
+  g_mutex_lock (&priv->slice_parse_lock);
+  priv->slice_parse_pending--;
+  if (priv->slice_parse_pending == 0)
+    g_cond_signal (&priv->slice_parse_cond);
+  g_mutex_unlock (&priv->slice_parse_lock);
+}
+
 static gboolean
 gst_h265_decoder_start (GstVideoDecoder * decoder)
 {
@@ -212,6 +256,24 @@ gst_h265_decoder_start (GstVideoDecoder * decoder)
   priv->new_bitstream = TRUE;
   priv->prev_nal_is_eos = FALSE;
 
+  if (priv->slice_parse_threads > 1) {
+    GError *err = NULL;
+
+    /* The streaming thread parses one slice of each batch by itself */
+    priv->slice_parse_pool =
+        g_thread_pool_new ((GFunc) gst_h265_decoder_slice_parse_func, self,
+        priv->slice_parse_threads - 1, FALSE, &err);
+
+    if (!priv->slice_parse_pool) {
+      GST_WARNING_OBJECT (self, "Failed to create slice parsing threads: %s",
+          err ? err->message : "unknown error");
+      g_clear_error (&err);
+    } else {
+      GST_DEBUG_OBJECT (self, "Parsing slice headers with %u threads",
+          priv->slice_parse_threads);
+    }
+  }
+
   return TRUE;
 }
 
@@ -228,6 +290,12 @@ gst_h265_decoder_stop (GstVideoDecoder * decoder)
 
   gst_clear_buffer (&priv->codec_data);
 
+  if (priv->slice_parse_pool) {
+    g_thread_pool_free (priv->slice_parse_pool, FALSE, TRUE);
+    priv->slice_parse_pool = NULL;
+  }
+  g_array_set_size (priv->slice_batch, 0);
+
   if (priv->parser) {
     gst_h265_parser_free (priv->parser);
     priv->parser = NULL;
@@ -623,26 +691,12 @@ gst_h265_decoder_preprocess_slice (GstH265Decoder * self, GstH265Slice * slice)
   return TRUE;
 }
 
+/* Serialized part of the slice handling. Expects priv->current_slice to hold
+ * the parsed slice header and its nal unit */
 static gboolean
-gst_h265_decoder_parse_slice (GstH265Decoder * self, GstH265NalUnit * nalu,
-    GstClockTime pts)
+gst_h265_decoder_process_slice (GstH265Decoder * self, GstClockTime pts)
 {
   GstH265DecoderPrivate *priv = self->priv;
-  GstH265ParserResult pres = GST_H265_PARSER_OK;
-
-  memset (&priv->current_slice, 0, sizeof (GstH265Slice));
-
-  pres = gst_h265_parser_parse_slice_hdr (priv->parser, nalu,
-      &priv->current_slice.header);
-
-  if (pres != GST_H265_PARSER_OK) {
-    GST_ERROR_OBJECT (self, "Failed to parse slice header, ret %d", pres);
-    memset (&priv->current_slice, 0, sizeof (GstH265Slice));
-
-    return FALSE;
-  }
-
-  priv->current_slice.nalu = *nalu;
 
   if (priv->current_slice.header.dependent_slice_segment_flag) {
     GstH265SliceHdr *slice_hdr = &priv->current_slice.header;
@@ -698,6 +752,90 @@ gst_h265_decoder_parse_slice (GstH265Decoder * self, GstH265NalUnit * nalu,
   return gst_h265_decoder_decode_slice (self);
 }
 
+static gboolean
+gst_h265_decoder_parse_slice (GstH265Decoder * self, GstH265NalUnit * nalu,
+    GstClockTime pts)
+{
+  GstH265DecoderPrivate *priv = self->priv;
+  GstH265ParserResult pres = GST_H265_PARSER_OK;
+
+  memset (&priv->current_slice, 0, sizeof (GstH265Slice));
+
+  pres = gst_h265_parser_parse_slice_hdr (priv->parser, nalu,
+      &priv->current_slice.header);
+
+  if (pres != GST_H265_PARSER_OK) {
+    GST_ERROR_OBJECT (self, "Failed to parse slice header, ret %d", pres);
+    memset (&priv->current_slice, 0, sizeof (GstH265Slice));
+
+    return FALSE;
+  }
+
+  priv->current_slice.nalu = *nalu;
+
+  return gst_h265_decoder_process_slice (self, pts);
+}
+
+static gboolean
+gst_h265_decoder_is_slice_nal (GstH265NalUnitType type)
+{
+  return type <= GST_H265_NAL_SLICE_RASL_R ||
+      (type >= GST_H265_NAL_SLICE_BLA_W_LP &&
+      type <= GST_H265_NAL_SLICE_CRA_NUT);
+}
+
+/* Parses the headers of all queued slices, spreading them over the slice
+ * parsing threads, then hands them to the serialized slice processing in
+ * bitstream order */
+static gboolean
+gst_h265_decoder_flush_slice_batch (GstH265Decoder * self, GstClockTime pts)
+{
+  GstH265DecoderPrivate *priv = self->priv;
+  GArray *batch = priv->slice_batch;
+  GstH265SliceParseJob *job;
+  gboolean ret = TRUE;
+  guint i;
+
+  if (batch->len == 0)
+    return TRUE;
+
+  GST_LOG_OBJECT (self, "Parsing %u slice headers", batch->len);
+
+  priv->slice_parse_pending = batch->len;
+  for (i = 1; i < batch->len; i++)
+    g_thread_pool_push (priv->slice_parse_pool,
+        &g_array_index (batch, GstH265SliceParseJob, i), NULL);
+
+  gst_h265_decoder_slice_parse_func (&g_array_index (batch,
+          GstH265SliceParseJob, 0), self);
+
+  g_mutex_lock (&priv->slice_parse_lock);
+  while (priv->slice_parse_pending > 0)
+    g_cond_wait (&priv->slice_parse_cond, &priv->slice_parse_lock);
+  g_mutex_unlock (&priv->slice_parse_lock);
+
+  for (i = 0; i < batch->len && ret; i++) {
+    job = &g_array_index (batch, GstH265SliceParseJob, i);
+
+    if (job->pres != GST_H265_PARSER_OK) {
+      GST_ERROR_OBJECT (self, "Failed to parse slice header, ret %d",
+          job->pres);
+      memset (&priv->current_slice, 0, sizeof (GstH265Slice));
+      ret = FALSE;
+      break;
+    }
+
+    priv->current_slice = job->slice;
+    ret = gst_h265_decoder_process_slice (self, pts);
+    priv->new_bitstream = FALSE;
+    priv->prev_nal_is_eos = FALSE;
+  }
+
+  g_array_set_size (batch, 0);
+
+  return ret;
+}
+
 static GstFlowReturn
 gst_h265_decoder_decode_nal (GstH265Decoder * self, GstH265NalUnit * nalu,
     GstClockTime pts)
@@ -708,6 +846,22 @@ gst_h265_decoder_decode_nal (GstH265Decoder * self, GstH265NalUnit * nalu,
   GST_LOG_OBJECT (self, "Parsed nal type: %d, offset %d, size %d",
       nalu->type, nalu->offset, nalu->size);
 
+  if (priv->slice_parse_pool) {
+    /* Queue up consecutive slices, any other nal unit may update the parser
+     * or decoder state, so the queued slices need to be handled first */
+    if (gst_h265_decoder_is_slice_nal (nalu->type)) {
+      GstH265SliceParseJob job = { 0, };
+
+      job.slice.nalu = *nalu;
+      g_array_append_val (priv->slice_batch, job);
+
+      return TRUE;
+    }
+
+    if (!gst_h265_decoder_flush_slice_batch (self, pts))
+      return FALSE;
+  }
+
   switch (nalu->type) {
     case GST_H265_NAL_VPS:
       ret = gst_h265_decoder_parse_vps (self, nalu);
@@ -1771,6 +1925,11 @@ gst_h265_decoder_handle_frame (GstVideoDecoder * decoder,
     }
   }
 
+  if (decode_ret && priv->slice_parse_pool)
+    decode_ret = gst_h265_decoder_flush_slice_batch (self,
+        GST_BUFFER_PTS (in_buf));
+  g_array_set_size (priv->slice_batch, 0);
+
   gst_buffer_unmap (in_buf, &map);
   priv->current_frame = NULL;
 
@@ -1811,6 +1970,29 @@ gst_h265_decoder_set_process_ref_pic_lists (GstH265Decoder * decoder,
   decoder->priv->process_ref_pic_lists = process;
 }
 
+/**
+ * gst_h265_decoder_set_slice_parse_threads:
+ * @decoder: a #GstH265Decoder
+ * @n_threads: the number of threads used for slice header parsing
+ *
+ * Called to en/disable parallel parsing of the slice headers within an
+ * access unit. When @n_threads is larger than one, consecutive slice nal
+ * units are parsed by up to @n_threads threads (including the streaming
+ * thread), while #GstH265DecoderClass.decode_slice() is still called from
+ * the streaming thread in bitstream order. This is mostly useful for
+ * streams with many slices per picture.
+ *
+ * This takes effect the next time @decoder is started.
+ *
+ * Since: 1.20
+ */
+void
+gst_h265_decoder_set_slice_parse_threads (GstH265Decoder * decoder,
+    guint n_threads)
+{
+  decoder->priv->slice_parse_threads = n_threads;
+}
+
 /**
  * gst_h265_decoder_get_picture:
  * @decoder: a #GstH265Decoder
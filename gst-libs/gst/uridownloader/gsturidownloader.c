@@ -46,6 +46,10 @@ struct _GstUriDownloaderPrivate
 
   GCond cond;
   gboolean cancelled;
+
+  /* Streaming downloads */
+  GstUriDownloaderChunkFunc chunk_func;
+  gpointer chunk_data;
 };
 
 static void gst_uri_downloader_finalize (GObject * object);
@@ -61,6 +65,11 @@ static GstBusSyncReply gst_uri_downloader_bus_handler (GstBus * bus,
 static gboolean gst_uri_downloader_ensure_src (GstUriDownloader * downloader,
     const gchar * uri);
 static void gst_uri_downloader_destroy_src (GstUriDownloader * downloader);
+static GstFragment *gst_uri_downloader_fetch (GstUriDownloader * downloader,
+    const gchar * uri, const gchar * referer, gboolean compress,
+    gboolean refresh, gboolean allow_cache, gint64 range_start,
+    gint64 range_end, GstUriDownloaderChunkFunc chunk_func,
+    gpointer user_data, GError ** err);
 
 static GstStaticPadTemplate sinkpadtemplate = GST_STATIC_PAD_TEMPLATE ("sink",
     GST_PAD_SINK,
@@ -334,7 +343,30 @@ gst_uri_downloader_chain (GstPad * pad, GstObject * parent, GstBuffer * buf)
   GST_LOG_OBJECT (downloader, "The uri fetcher received a new buffer "
       "of size %" G_GSIZE_FORMAT, gst_buffer_get_size (buf));
   downloader->priv->got_buffer = TRUE;
-  if (!gst_fragment_add_buffer (downloader->priv->download, buf)) {
+
+  if (downloader->priv->chunk_func) {
+    GstFragment *download = g_object_ref (downloader->priv->download);
+    guint64 arrival_time = gst_util_get_timestamp ();
+    gboolean ok;
+
+    /* Hand the data over right away instead of collecting it */
+    GST_OBJECT_UNLOCK (downloader);
+    ok = downloader->priv->chunk_func (downloader, download, buf, arrival_time,
+        downloader->priv->chunk_data);
+    GST_OBJECT_LOCK (downloader);
+
+    if (!ok && downloader->priv->download == download) {
+      GST_DEBUG_OBJECT (downloader, "Download aborted by the chunk callback");
+      if (!downloader->priv->err)
+        downloader->priv->err = g_error_new (GST_RESOURCE_ERROR,
+            GST_RESOURCE_ERROR_READ, "Download aborted");
+      g_object_unref (downloader->priv->download);
+      downloader->priv->download = NULL;
+      downloader->priv->cancelled = TRUE;
+      g_cond_signal (&downloader->priv->cond);
+    }
+    g_object_unref (download);
+  } else if (!gst_fragment_add_buffer (downloader->priv->download, buf)) {
     GST_WARNING_OBJECT (downloader, "Could not add buffer to fragment");
     gst_buffer_unref (buf);
   }
@@ -554,6 +586,53 @@ gst_uri_downloader_fetch_uri_with_range (GstUriDownloader *
     downloader, const gchar * uri, const gchar * referer, gboolean compress,
     gboolean refresh, gboolean allow_cache,
     gint64 range_start, gint64 range_end, GError ** err)
+{
+  return gst_uri_downloader_fetch (downloader, uri, referer, compress,
+      refresh, allow_cache, range_start, range_end, NULL, NULL, err);
+}
+
+/**
+ * gst_uri_downloader_fetch_uri_streaming:
+ * @downloader: the #GstUriDownloader
+ * @uri: the uri
+ * @referer: (nullable): the referer of the request
+ * @compress: whether to accept compressed content
+ * @refresh: whether to ask caches to revalidate the content
+ * @allow_cache: whether cached content may be used
+ * @range_start: the starting byte index
+ * @range_end: the final byte index, use -1 for unspecified
+ * @chunk_func: function called for each chunk of data as it arrives
+ * @user_data: user data for @chunk_func
+ * @err: return location for a #GError
+ *
+ * Like gst_uri_downloader_fetch_uri_with_range(), but passes the data to
+ * @chunk_func as soon as it is received instead of collecting it. This
+ * allows processing a fragment while it is still being downloaded.
+ *
+ * Returns: (transfer full) (nullable): the completed #GstFragment, without
+ *     any data, or %NULL if the download failed or was aborted
+ *
+ * Since: 1.20
+ */
+GstFragment *
+gst_uri_downloader_fetch_uri_streaming (GstUriDownloader * downloader,
+    const gchar * uri, const gchar * referer, gboolean compress,
+    gboolean refresh, gboolean allow_cache, gint64 range_start,
+    gint64 range_end, GstUriDownloaderChunkFunc chunk_func,
+    gpointer user_data, GError ** err)
+{
+  g_return_val_if_fail (chunk_func != NULL, NULL);
+
+  return gst_uri_downloader_fetch (downloader, uri, referer, compress,
+      refresh, allow_cache, range_start, range_end, chunk_func, user_data,
+      err);
+}
+
+static GstFragment *
+gst_uri_downloader_fetch (GstUriDownloader * downloader, const gchar * uri,
+    const gchar * referer, gboolean compress, gboolean refresh,
+    gboolean allow_cache, gint64 range_start, gint64 range_end,
+    GstUriDownloaderChunkFunc chunk_func, gpointer user_data, GError ** err)
 {
   GstStateChangeReturn ret;
   GstFragment *download = NULL;
@@ -565,6 +644,8 @@ gst_uri_downloader_fetch_uri_with_range (GstUriDownloader *
   downloader->priv->got_buffer = FALSE;
 
   GST_OBJECT_LOCK (downloader);
+  downloader->priv->chunk_func = chunk_func;
+  downloader->priv->chunk_data = user_data;
   if (downloader->priv->cancelled) {
     GST_DEBUG_OBJECT (downloader, "Cancelled, aborting fetch");
     goto quit;
@@ -713,6 +794,8 @@ quit:
     }
 
     downloader->priv->cancelled = FALSE;
+    downloader->priv->chunk_func = NULL;
+    downloader->priv->chunk_data = NULL;
 
     g_mutex_unlock (&downloader->priv->download_lock);
     return download;
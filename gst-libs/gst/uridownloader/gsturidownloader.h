@@ -43,6 +43,26 @@ typedef struct _GstUriDownloader GstUriDownloader;
 typedef struct _GstUriDownloaderPrivate GstUriDownloaderPrivate;
 typedef struct _GstUriDownloaderClass GstUriDownloaderClass;
 
+/**
+ * GstUriDownloaderChunkFunc:
+ * @downloader: the #GstUriDownloader
+ * @fragment: the #GstFragment being downloaded
+ * @chunk: (transfer full): the data that was just received
+ * @arrival_time: the time at which @chunk was received, in the same time base
+ *     as #GstFragment.download_start_time
+ * @user_data: user data passed to gst_uri_downloader_fetch_uri_streaming()
+ *
+ * Called from the streaming thread of the source element for each chunk of
+ * data as soon as it is received.
+ *
+ * Returns: %TRUE to continue the download, %FALSE to abort it
+ *
+ * Since: 1.20
+ */
+typedef gboolean (*GstUriDownloaderChunkFunc) (GstUriDownloader * downloader,
+    GstFragment * fragment, GstBuffer * chunk, guint64 arrival_time,
+    gpointer user_data);
+
 struct _GstUriDownloader
 {
   GstObject parent;
@@ -73,6 +93,9 @@ GstFragment * gst_uri_downloader_fetch_uri (GstUriDownloader * downloader, const
 GST_URI_DOWNLOADER_API
 GstFragment * gst_uri_downloader_fetch_uri_with_range (GstUriDownloader * downloader, const gchar * uri, const gchar * referer, gboolean compress, gboolean refresh, gboolean allow_cache, gint64 range_start, gint64 range_end, GError ** err);
 
+GST_URI_DOWNLOADER_API
+GstFragment * gst_uri_downloader_fetch_uri_streaming (GstUriDownloader * downloader, const gchar * uri, const gchar * referer, gboolean compress, gboolean refresh, gboolean allow_cache, gint64 range_start, gint64 range_end, GstUriDownloaderChunkFunc chunk_func, gpointer user_data, GError ** err);
+
 GST_URI_DOWNLOADER_API
 void gst_uri_downloader_reset (GstUriDownloader *downloader);
 
@@ -78,7 +78,8 @@ gst_inter_surface_unref (GstInterSurface * surface)
     }
 
     g_mutex_clear (&surface->mutex);
-    gst_buffer_replace (&surface->video_buffer, NULL);
+    if (surface->video_ring)
+      gst_inter_video_ring_unref (surface->video_ring);
     gst_buffer_replace (&surface->sub_buffer, NULL);
     gst_object_unref (surface->audio_adapter);
     g_free (surface->name);
@@ -86,3 +87,102 @@ gst_inter_surface_unref (GstInterSurface * surface)
   }
   g_mutex_unlock (&mutex);
 }
+
+GstInterVideoRing *
+gst_inter_video_ring_new (guint n_slots)
+{
+  GstInterVideoRing *ring;
+  guint i;
+
+  g_return_val_if_fail (n_slots > 0, NULL);
+
+  ring = g_malloc0 (sizeof (GstInterVideoRing) +
+      (n_slots - 1) * sizeof (GstInterVideoSlot));
+  ring->ref_count = 1;
+  ring->n_slots = n_slots;
+  ring->write_seqnum = 1;
+  for (i = 0; i < n_slots; i++)
+    ring->slots[i].clock_time = GST_CLOCK_TIME_NONE;
+
+  return ring;
+}
+
+GstInterVideoRing *
+gst_inter_video_ring_ref (GstInterVideoRing * ring)
+{
+  g_atomic_int_inc (&ring->ref_count);
+
+  return ring;
+}
+
+void
+gst_inter_video_ring_unref (GstInterVideoRing * ring)
+{
+  guint i;
+
+  if (!g_atomic_int_dec_and_test (&ring->ref_count))
+    return;
+
+  for (i = 0; i < ring->n_slots; i++)
+    gst_buffer_replace (&ring->slots[i].buffer, NULL);
+  g_free (ring);
+}
+
+/* Only ever called from the streaming thread of the one intervideosink
+ * owning the ring. The writer only waits for readers that are in the
+ * middle of taking a reference to the buffer it is about to replace. */
+void
+gst_inter_video_ring_push (GstInterVideoRing * ring, GstBuffer * buffer,
+    GstClockTime clock_time)
+{
+  guint seqnum = ring->write_seqnum;
+  GstInterVideoSlot *slot = &ring->slots[seqnum % ring->n_slots];
+  GstBuffer *old;
+
+  g_atomic_int_set (&slot->seqnum, 0);
+  while (g_atomic_int_get (&slot->readers) > 0)
+    g_thread_yield ();
+
+  old = slot->buffer;
+  slot->buffer = gst_buffer_ref (buffer);
+  slot->clock_time = clock_time;
+  g_atomic_int_set (&slot->seqnum, seqnum);
+
+  /* 0 marks slots that are being written */
+  if (G_UNLIKELY (++seqnum == 0))
+    seqnum = 1;
+  g_atomic_int_set (&ring->write_seqnum, seqnum);
+
+  if (old)
+    gst_buffer_unref (old);
+}
+
+/* Returns the seqnum of the most recent frame, 0 if there is none yet */
+guint
+gst_inter_video_ring_get_latest (GstInterVideoRing * ring)
+{
+  return (guint) g_atomic_int_get (&ring->write_seqnum) - 1;
+}
+
+/* Returns a reference to frame @seqnum, or NULL if it was overwritten
+ * already */
+GstBuffer *
+gst_inter_video_ring_get (GstInterVideoRing * ring, guint seqnum,
+    GstClockTime * clock_time)
+{
+  GstInterVideoSlot *slot = &ring->slots[seqnum % ring->n_slots];
+  GstBuffer *buffer = NULL;
+
+  if (seqnum == 0)
+    return NULL;
+
+  g_atomic_int_inc (&slot->readers);
+  if ((guint) g_atomic_int_get (&slot->seqnum) == seqnum) {
+    buffer = gst_buffer_ref (slot->buffer);
+    if (clock_time)
+      *clock_time = slot->clock_time;
+  }
+  g_atomic_int_add (&slot->readers, -1);
+
+  return buffer;
+}
@@ -27,6 +27,33 @@
 G_BEGIN_DECLS
 
 typedef struct _GstInterSurface GstInterSurface;
+typedef struct _GstInterVideoSlot GstInterVideoSlot;
+typedef struct _GstInterVideoRing GstInterVideoRing;
+
+/* One frame of the video ring. @seqnum is 0 while the writer replaces the
+ * buffer, readers only take a reference while @readers is raised and the
+ * seqnum is still the one they asked for. */
+struct _GstInterVideoSlot
+{
+  gint readers;
+  guint seqnum;
+
+  GstBuffer *buffer;
+  GstClockTime clock_time;
+};
+
+/* Frames written by one intervideosink and read by any number of
+ * intervideosrc, each with its own cursor. Frames are numbered from 1,
+ * frame n lives in slot n % n_slots */
+struct _GstInterVideoRing
+{
+  gint ref_count;
+
+  guint n_slots;
+  guint write_seqnum;
+
+  GstInterVideoSlot slots[1];
+};
 
 struct _GstInterSurface
 {
@@ -37,7 +64,10 @@ struct _GstInterSurface
 
   /* video */
   GstVideoInfo video_info;
-  int video_buffer_count;
+  GstInterVideoRing *video_ring;
+  /* changed whenever video_info or video_ring are, so readers only need
+   * to take the mutex when something changed */
+  gint video_cookie;
 
   /* audio */
   GstAudioInfo audio_info;
@@ -45,7 +75,6 @@ struct _GstInterSurface
   guint64 audio_latency_time;
   guint64 audio_period_time;
 
-  GstBuffer *video_buffer;
   GstBuffer *sub_buffer;
   GstAdapter *audio_adapter;
 };
@@ -54,10 +83,21 @@ struct _GstInterSurface
 #define DEFAULT_AUDIO_LATENCY_TIME (100 * GST_MSECOND)
 #define DEFAULT_AUDIO_PERIOD_TIME  (25 * GST_MSECOND)
 
+#define DEFAULT_VIDEO_QUEUE_SIZE   1
+
 
 GstInterSurface * gst_inter_surface_get (const char *name);
 void gst_inter_surface_unref (GstInterSurface *surface);
 
+GstInterVideoRing * gst_inter_video_ring_new (guint n_slots);
+GstInterVideoRing * gst_inter_video_ring_ref (GstInterVideoRing *ring);
+void gst_inter_video_ring_unref (GstInterVideoRing *ring);
+void gst_inter_video_ring_push (GstInterVideoRing *ring, GstBuffer *buffer,
+    GstClockTime clock_time);
+guint gst_inter_video_ring_get_latest (GstInterVideoRing *ring);
+GstBuffer * gst_inter_video_ring_get (GstInterVideoRing *ring, guint seqnum,
+    GstClockTime *clock_time);
+
 
 G_END_DECLS
 
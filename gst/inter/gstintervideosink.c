@@ -66,10 +66,12 @@ static GstFlowReturn gst_inter_video_sink_show_frame (GstVideoSink * sink,
 enum
 {
   PROP_0,
-  PROP_CHANNEL
+  PROP_CHANNEL,
+  PROP_QUEUE_SIZE
 };
 
 #define DEFAULT_CHANNEL ("default")
+#define DEFAULT_QUEUE_SIZE (DEFAULT_VIDEO_QUEUE_SIZE)
 
 /* pad templates */
 static GstStaticPadTemplate gst_inter_video_sink_sink_template =
@@ -120,12 +122,28 @@ gst_inter_video_sink_class_init (GstInterVideoSinkClass * klass)
       g_param_spec_string ("channel", "Channel",
           "Channel name to match inter src and sink elements",
           DEFAULT_CHANNEL, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstInterVideoSink:queue-size:
+   *
+   * Number of frames kept for the intervideosrc elements of the channel.
+   * Every intervideosrc reads the frames at its own pace, a slower one
+   * only drops frames once it is more than this many frames behind.
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (gobject_class, PROP_QUEUE_SIZE,
+      g_param_spec_uint ("queue-size", "Queue size",
+          "Number of frames kept for the intervideosrc elements", 1, 1024,
+          DEFAULT_QUEUE_SIZE, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS |
+          GST_PARAM_MUTABLE_READY));
 }
 
 static void
 gst_inter_video_sink_init (GstInterVideoSink * intervideosink)
 {
   intervideosink->channel = g_strdup (DEFAULT_CHANNEL);
+  intervideosink->queue_size = DEFAULT_QUEUE_SIZE;
 }
 
 void
@@ -139,6 +157,9 @@ gst_inter_video_sink_set_property (GObject * object, guint property_id,
       g_free (intervideosink->channel);
       intervideosink->channel = g_value_dup_string (value);
       break;
+    case PROP_QUEUE_SIZE:
+      intervideosink->queue_size = g_value_get_uint (value);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
       break;
@@ -155,6 +176,9 @@ gst_inter_video_sink_get_property (GObject * object, guint property_id,
     case PROP_CHANNEL:
       g_value_set_string (value, intervideosink->channel);
       break;
+    case PROP_QUEUE_SIZE:
+      g_value_set_uint (value, intervideosink->queue_size);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
       break;
@@ -199,8 +223,16 @@ gst_inter_video_sink_start (GstBaseSink * sink)
   GstInterVideoSink *intervideosink = GST_INTER_VIDEO_SINK (sink);
 
   intervideosink->surface = gst_inter_surface_get (intervideosink->channel);
+  intervideosink->ring =
+      gst_inter_video_ring_new (intervideosink->queue_size);
+
   g_mutex_lock (&intervideosink->surface->mutex);
   memset (&intervideosink->surface->video_info, 0, sizeof (GstVideoInfo));
+  if (intervideosink->surface->video_ring)
+    gst_inter_video_ring_unref (intervideosink->surface->video_ring);
+  intervideosink->surface->video_ring =
+      gst_inter_video_ring_ref (intervideosink->ring);
+  g_atomic_int_inc (&intervideosink->surface->video_cookie);
   g_mutex_unlock (&intervideosink->surface->mutex);
 
   return TRUE;
@@ -212,13 +244,18 @@ gst_inter_video_sink_stop (GstBaseSink * sink)
   GstInterVideoSink *intervideosink = GST_INTER_VIDEO_SINK (sink);
 
   g_mutex_lock (&intervideosink->surface->mutex);
-  if (intervideosink->surface->video_buffer) {
-    gst_buffer_unref (intervideosink->surface->video_buffer);
+  /* Another sink might have taken over the channel meanwhile */
+  if (intervideosink->surface->video_ring == intervideosink->ring) {
+    gst_inter_video_ring_unref (intervideosink->surface->video_ring);
+    intervideosink->surface->video_ring = NULL;
   }
-  intervideosink->surface->video_buffer = NULL;
   memset (&intervideosink->surface->video_info, 0, sizeof (GstVideoInfo));
+  g_atomic_int_inc (&intervideosink->surface->video_cookie);
   g_mutex_unlock (&intervideosink->surface->mutex);
 
+  gst_inter_video_ring_unref (intervideosink->ring);
+  intervideosink->ring = NULL;
+
   gst_inter_surface_unref (intervideosink->surface);
   intervideosink->surface = NULL;
 
@@ -237,8 +274,24 @@ gst_inter_video_sink_set_caps (GstBaseSink * sink, GstCaps * caps)
   }
 
   g_mutex_lock (&intervideosink->surface->mutex);
+  /* Queued frames of the previous format must not be output with the new
+   * caps. Readers drop their cursor and last frame when the ring changes,
+   * so start a new one rather than letting them find those */
+  if (!gst_video_info_is_equal (&info, &intervideosink->info) &&
+      gst_inter_video_ring_get_latest (intervideosink->ring) != 0) {
+    GstInterVideoRing *ring =
+        gst_inter_video_ring_new (intervideosink->ring->n_slots);
+
+    if (intervideosink->surface->video_ring == intervideosink->ring) {
+      gst_inter_video_ring_unref (intervideosink->surface->video_ring);
+      intervideosink->surface->video_ring = gst_inter_video_ring_ref (ring);
+    }
+    gst_inter_video_ring_unref (intervideosink->ring);
+    intervideosink->ring = ring;
+  }
   intervideosink->surface->video_info = info;
   intervideosink->info = info;
+  g_atomic_int_inc (&intervideosink->surface->video_cookie);
   g_mutex_unlock (&intervideosink->surface->mutex);
 
   return TRUE;
@@ -248,17 +301,19 @@ static GstFlowReturn
 gst_inter_video_sink_show_frame (GstVideoSink * sink, GstBuffer * buffer)
 {
   GstInterVideoSink *intervideosink = GST_INTER_VIDEO_SINK (sink);
+  GstClockTime running_time, clock_time = GST_CLOCK_TIME_NONE;
 
   GST_DEBUG_OBJECT (intervideosink, "render ts %" GST_TIME_FORMAT,
       GST_TIME_ARGS (GST_BUFFER_PTS (buffer)));
 
-  g_mutex_lock (&intervideosink->surface->mutex);
-  if (intervideosink->surface->video_buffer) {
-    gst_buffer_unref (intervideosink->surface->video_buffer);
-  }
-  intervideosink->surface->video_buffer = gst_buffer_ref (buffer);
-  intervideosink->surface->video_buffer_count = 0;
-  g_mutex_unlock (&intervideosink->surface->mutex);
+  /* Readers that select frames by timestamp compare this with the clock
+   * time at which they output their own frames */
+  running_time = gst_segment_to_running_time (&GST_BASE_SINK (sink)->segment,
+      GST_FORMAT_TIME, GST_BUFFER_PTS (buffer));
+  if (GST_CLOCK_TIME_IS_VALID (running_time))
+    clock_time = running_time + gst_element_get_base_time (GST_ELEMENT (sink));
+
+  gst_inter_video_ring_push (intervideosink->ring, buffer, clock_time);
 
   return GST_FLOW_OK;
 }
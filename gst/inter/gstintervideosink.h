@@ -39,7 +39,9 @@ struct _GstInterVideoSink
   GstVideoSink videosink;
 
   GstInterSurface *surface;
+  GstInterVideoRing *ring;
   char *channel;
+  guint queue_size;
 
   GstVideoInfo info;
 };
@@ -71,11 +71,40 @@ enum
 {
   PROP_0,
   PROP_CHANNEL,
-  PROP_TIMEOUT
+  PROP_TIMEOUT,
+  PROP_FRAME_SELECTION,
+  PROP_DROP,
+  PROP_DUPLICATE
 };
 
 #define DEFAULT_CHANNEL ("default")
 #define DEFAULT_TIMEOUT (GST_SECOND)
+#define DEFAULT_FRAME_SELECTION (GST_INTER_VIDEO_SRC_FRAME_SELECTION_LATEST)
+
+#define GST_TYPE_INTER_VIDEO_SRC_FRAME_SELECTION \
+    (gst_inter_video_src_frame_selection_get_type ())
+static GType
+gst_inter_video_src_frame_selection_get_type (void)
+{
+  static GType frame_selection_type = 0;
+  static const GEnumValue frame_selection[] = {
+    {GST_INTER_VIDEO_SRC_FRAME_SELECTION_LATEST,
+        "Output the most recent frame", "latest"},
+    {GST_INTER_VIDEO_SRC_FRAME_SELECTION_SEQUENTIAL,
+        "Output every queued frame in order", "sequential"},
+    {GST_INTER_VIDEO_SRC_FRAME_SELECTION_TIMESTAMP,
+        "Output the most recent frame that is due at the output time",
+        "timestamp"},
+    {0, NULL, NULL},
+  };
+
+  if (!frame_selection_type) {
+    frame_selection_type =
+        g_enum_register_static ("GstInterVideoSrcFrameSelection",
+        frame_selection);
+  }
+  return frame_selection_type;
+}
 
 /* pad templates */
 static GstStaticPadTemplate gst_inter_video_src_src_template =
@@ -132,6 +161,47 @@ gst_inter_video_src_class_init (GstInterVideoSrcClass * klass)
           "Timeout after which to start outputting black frames",
           0, G_MAXUINT64, DEFAULT_TIMEOUT,
           G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstInterVideoSrc:frame-selection:
+   *
+   * Which of the frames queued by the intervideosink (see
+   * #GstInterVideoSink:queue-size) to output next. "timestamp" compares
+   * clock times and requires both pipelines to use the same clock.
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (gobject_class, PROP_FRAME_SELECTION,
+      g_param_spec_enum ("frame-selection", "Frame selection",
+          "Which of the queued frames to output next",
+          GST_TYPE_INTER_VIDEO_SRC_FRAME_SELECTION, DEFAULT_FRAME_SELECTION,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstInterVideoSrc:drop:
+   *
+   * Number of frames of the intervideosink this element skipped.
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (gobject_class, PROP_DROP,
+      g_param_spec_uint64 ("drop", "Drop", "Number of dropped frames",
+          0, G_MAXUINT64, 0, G_PARAM_READABLE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstInterVideoSrc:duplicate:
+   *
+   * Number of times this element repeated a frame because the
+   * intervideosink had no new one.
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (gobject_class, PROP_DUPLICATE,
+      g_param_spec_uint64 ("duplicate", "Duplicate",
+          "Number of duplicated frames", 0, G_MAXUINT64, 0,
+          G_PARAM_READABLE | G_PARAM_STATIC_STRINGS));
+
+  gst_type_mark_as_plugin_api (GST_TYPE_INTER_VIDEO_SRC_FRAME_SELECTION, 0);
 }
 
 static void
@@ -142,6 +212,7 @@ gst_inter_video_src_init (GstInterVideoSrc * intervideosrc)
 
   intervideosrc->channel = g_strdup (DEFAULT_CHANNEL);
   intervideosrc->timeout = DEFAULT_TIMEOUT;
+  intervideosrc->frame_selection = DEFAULT_FRAME_SELECTION;
 }
 
 void
@@ -158,6 +229,9 @@ gst_inter_video_src_set_property (GObject * object, guint property_id,
     case PROP_TIMEOUT:
       intervideosrc->timeout = g_value_get_uint64 (value);
       break;
+    case PROP_FRAME_SELECTION:
+      intervideosrc->frame_selection = g_value_get_enum (value);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
       break;
@@ -177,6 +251,19 @@ gst_inter_video_src_get_property (GObject * object, guint property_id,
     case PROP_TIMEOUT:
       g_value_set_uint64 (value, intervideosrc->timeout);
       break;
+    case PROP_FRAME_SELECTION:
+      g_value_set_enum (value, intervideosrc->frame_selection);
+      break;
+    case PROP_DROP:
+      GST_OBJECT_LOCK (intervideosrc);
+      g_value_set_uint64 (value, intervideosrc->dropped);
+      GST_OBJECT_UNLOCK (intervideosrc);
+      break;
+    case PROP_DUPLICATE:
+      GST_OBJECT_LOCK (intervideosrc);
+      g_value_set_uint64 (value, intervideosrc->duplicated);
+      GST_OBJECT_UNLOCK (intervideosrc);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
       break;
@@ -265,6 +352,9 @@ gst_inter_video_src_set_caps (GstBaseSrc * base, GstCaps * caps)
   gst_buffer_unref (src);
   intervideosrc->black_frame = dest;
 
+  /* Compare with what the sink produces again */
+  intervideosrc->check_info = TRUE;
+
   return TRUE;
 }
 
@@ -278,6 +368,14 @@ gst_inter_video_src_start (GstBaseSrc * src)
   intervideosrc->surface = gst_inter_surface_get (intervideosrc->channel);
   intervideosrc->timestamp_offset = 0;
   intervideosrc->n_frames = 0;
+  intervideosrc->check_info = TRUE;
+  intervideosrc->last_seqnum = 0;
+  intervideosrc->repeat_count = 0;
+
+  GST_OBJECT_LOCK (intervideosrc);
+  intervideosrc->dropped = 0;
+  intervideosrc->duplicated = 0;
+  GST_OBJECT_UNLOCK (intervideosrc);
 
   return TRUE;
 }
@@ -291,6 +389,11 @@ gst_inter_video_src_stop (GstBaseSrc * src)
 
   gst_inter_surface_unref (intervideosrc->surface);
   intervideosrc->surface = NULL;
+  if (intervideosrc->ring) {
+    gst_inter_video_ring_unref (intervideosrc->ring);
+    intervideosrc->ring = NULL;
+  }
+  gst_buffer_replace (&intervideosrc->last_buffer, NULL);
   gst_buffer_replace (&intervideosrc->black_frame, NULL);
 
   return TRUE;
@@ -321,13 +424,129 @@ gst_inter_video_src_get_times (GstBaseSrc * src, GstBuffer * buffer,
   }
 }
 
+/* Called with the surface mutex, returns the caps to negotiate if the
+ * sink produces something else than what we output */
+static GstCaps *
+gst_inter_video_src_check_info (GstInterVideoSrc * intervideosrc)
+{
+  GstVideoInfo tmp_info;
+  GstCaps *caps = NULL;
+
+  if (!intervideosrc->surface->video_info.finfo)
+    return NULL;
+
+  tmp_info = intervideosrc->surface->video_info;
+
+  /* We negotiate the framerate ourselves */
+  tmp_info.fps_n = intervideosrc->info.fps_n;
+  tmp_info.fps_d = intervideosrc->info.fps_d;
+  if (intervideosrc->info.flags & GST_VIDEO_FLAG_VARIABLE_FPS)
+    tmp_info.flags |= GST_VIDEO_FLAG_VARIABLE_FPS;
+  else
+    tmp_info.flags &= ~GST_VIDEO_FLAG_VARIABLE_FPS;
+
+  if (!gst_video_info_is_equal (&tmp_info, &intervideosrc->info)) {
+    caps = gst_video_info_to_caps (&tmp_info);
+    intervideosrc->timestamp_offset +=
+        gst_util_uint64_scale (GST_SECOND * intervideosrc->n_frames,
+        GST_VIDEO_INFO_FPS_D (&intervideosrc->info),
+        GST_VIDEO_INFO_FPS_N (&intervideosrc->info));
+    intervideosrc->n_frames = 0;
+  }
+
+  return caps;
+}
+
+/* Returns the frame to output next if the sink produced a new one since
+ * the last call, @clock_time is when the frame will be output */
+static GstBuffer *
+gst_inter_video_src_select_frame (GstInterVideoSrc * intervideosrc,
+    GstClockTime clock_time)
+{
+  GstInterVideoRing *ring = intervideosrc->ring;
+  GstBuffer *buffer = NULL;
+  guint latest, first, seqnum;
+
+  if (!ring)
+    return NULL;
+
+  latest = gst_inter_video_ring_get_latest (ring);
+  if (latest == 0 || latest == intervideosrc->last_seqnum)
+    return NULL;
+
+  /* Oldest frame we did not output yet that can still be in the ring */
+  if (intervideosrc->last_seqnum == 0 ||
+      latest - intervideosrc->last_seqnum > ring->n_slots)
+    first = latest > ring->n_slots ? latest - ring->n_slots + 1 : 1;
+  else
+    first = intervideosrc->last_seqnum + 1;
+
+  /* Unless selecting by timestamp, start with the most recent frame */
+  if (intervideosrc->last_seqnum == 0 &&
+      intervideosrc->frame_selection !=
+      GST_INTER_VIDEO_SRC_FRAME_SELECTION_TIMESTAMP)
+    first = latest;
+
+  switch (intervideosrc->frame_selection) {
+    case GST_INTER_VIDEO_SRC_FRAME_SELECTION_SEQUENTIAL:
+      for (seqnum = first; !buffer && seqnum <= latest; seqnum++)
+        buffer = gst_inter_video_ring_get (ring, seqnum, NULL);
+      seqnum--;
+      break;
+    case GST_INTER_VIDEO_SRC_FRAME_SELECTION_TIMESTAMP:
+      for (seqnum = latest; seqnum >= first; seqnum--) {
+        GstClockTime frame_time = GST_CLOCK_TIME_NONE;
+
+        buffer = gst_inter_video_ring_get (ring, seqnum, &frame_time);
+        if (!buffer)
+          break;
+
+        if (!GST_CLOCK_TIME_IS_VALID (frame_time) ||
+            !GST_CLOCK_TIME_IS_VALID (clock_time) || frame_time <= clock_time)
+          break;
+
+        gst_buffer_unref (buffer);
+        buffer = NULL;
+      }
+
+      /* Nothing is due yet, keep repeating the previous frame */
+      if (!buffer)
+        return NULL;
+      break;
+    case GST_INTER_VIDEO_SRC_FRAME_SELECTION_LATEST:
+    default:
+      seqnum = latest;
+      buffer = gst_inter_video_ring_get (ring, seqnum, NULL);
+      break;
+  }
+
+  /* The sink lapped us while we were looking, take whatever is newest */
+  if (!buffer) {
+    seqnum = gst_inter_video_ring_get_latest (ring);
+    buffer = gst_inter_video_ring_get (ring, seqnum, NULL);
+    if (!buffer)
+      return NULL;
+  }
+
+  if (seqnum > first && intervideosrc->last_seqnum != 0) {
+    GST_LOG_OBJECT (intervideosrc, "Skipping %u frames", seqnum - first);
+    GST_OBJECT_LOCK (intervideosrc);
+    intervideosrc->dropped += seqnum - first;
+    GST_OBJECT_UNLOCK (intervideosrc);
+  }
+  intervideosrc->last_seqnum = seqnum;
+
+  return buffer;
+}
+
 static GstFlowReturn
 gst_inter_video_src_create (GstBaseSrc * src, guint64 offset, guint size,
     GstBuffer ** buf)
 {
   GstInterVideoSrc *intervideosrc = GST_INTER_VIDEO_SRC (src);
   GstCaps *caps;
-  GstBuffer *buffer;
+  GstBuffer *buffer, *new_buffer;
+  GstClockTime clock_time = GST_CLOCK_TIME_NONE;
   guint64 frames;
   gboolean is_gap = FALSE;
 
@@ -340,47 +559,63 @@ gst_inter_video_src_create (GstBaseSrc * src, guint64 offset, guint size,
       GST_VIDEO_INFO_FPS_N (&intervideosrc->info),
       GST_VIDEO_INFO_FPS_D (&intervideosrc->info) * GST_SECOND);
 
-  g_mutex_lock (&intervideosrc->surface->mutex);
-  if (intervideosrc->surface->video_info.finfo) {
-    GstVideoInfo tmp_info = intervideosrc->surface->video_info;
-
-    /* We negotiate the framerate ourselves */
-    tmp_info.fps_n = intervideosrc->info.fps_n;
-    tmp_info.fps_d = intervideosrc->info.fps_d;
-    if (intervideosrc->info.flags & GST_VIDEO_FLAG_VARIABLE_FPS)
-      tmp_info.flags |= GST_VIDEO_FLAG_VARIABLE_FPS;
-    else
-      tmp_info.flags &= ~GST_VIDEO_FLAG_VARIABLE_FPS;
-
-    if (!gst_video_info_is_equal (&tmp_info, &intervideosrc->info)) {
-      caps = gst_video_info_to_caps (&tmp_info);
-      intervideosrc->timestamp_offset +=
-          gst_util_uint64_scale (GST_SECOND * intervideosrc->n_frames,
-          GST_VIDEO_INFO_FPS_D (&intervideosrc->info),
-          GST_VIDEO_INFO_FPS_N (&intervideosrc->info));
-      intervideosrc->n_frames = 0;
+  /* Only take the mutex if the sink changed anything */
+  if (intervideosrc->check_info ||
+      g_atomic_int_get (&intervideosrc->surface->video_cookie) !=
+      intervideosrc->video_cookie) {
+    g_mutex_lock (&intervideosrc->surface->mutex);
+    intervideosrc->check_info = FALSE;
+    intervideosrc->video_cookie = intervideosrc->surface->video_cookie;
+
+    if (intervideosrc->surface->video_ring != intervideosrc->ring) {
+      if (intervideosrc->ring)
+        gst_inter_video_ring_unref (intervideosrc->ring);
+      intervideosrc->ring = intervideosrc->surface->video_ring;
+      if (intervideosrc->ring)
+        gst_inter_video_ring_ref (intervideosrc->ring);
+      intervideosrc->last_seqnum = 0;
+      gst_buffer_replace (&intervideosrc->last_buffer, NULL);
     }
+
+    caps = gst_inter_video_src_check_info (intervideosrc);
+    g_mutex_unlock (&intervideosrc->surface->mutex);
+  }
+
+  if (GST_VIDEO_INFO_FPS_N (&intervideosrc->info) > 0) {
+    clock_time = intervideosrc->timestamp_offset +
+        gst_util_uint64_scale (GST_SECOND * intervideosrc->n_frames,
+        GST_VIDEO_INFO_FPS_D (&intervideosrc->info),
+        GST_VIDEO_INFO_FPS_N (&intervideosrc->info)) +
+        gst_element_get_base_time (GST_ELEMENT (src));
   }
 
-  if (intervideosrc->surface->video_buffer) {
+  new_buffer = gst_inter_video_src_select_frame (intervideosrc, clock_time);
+  if (new_buffer) {
+    gst_buffer_replace (&intervideosrc->last_buffer, NULL);
+    intervideosrc->last_buffer = new_buffer;
+    intervideosrc->repeat_count = 0;
+  } else if (intervideosrc->last_buffer) {
+    GST_OBJECT_LOCK (intervideosrc);
+    intervideosrc->duplicated++;
+    GST_OBJECT_UNLOCK (intervideosrc);
+  }
+
+  if (intervideosrc->last_buffer) {
     /* We have a buffer to push */
-    buffer = gst_buffer_ref (intervideosrc->surface->video_buffer);
+    buffer = gst_buffer_ref (intervideosrc->last_buffer);
 
     /* Can only be true if timeout > 0 */
-    if (intervideosrc->surface->video_buffer_count == frames) {
-      gst_buffer_unref (intervideosrc->surface->video_buffer);
-      intervideosrc->surface->video_buffer = NULL;
-    }
+    if (intervideosrc->repeat_count == frames)
+      gst_buffer_replace (&intervideosrc->last_buffer, NULL);
   }
 
-  if (intervideosrc->surface->video_buffer_count != 0 &&
-      intervideosrc->surface->video_buffer_count != (frames + 1)) {
+  if (intervideosrc->repeat_count != 0 &&
+      intervideosrc->repeat_count != (frames + 1)) {
     /* This is a repeat of the stored buffer or of a black frame */
     is_gap = TRUE;
   }
 
-  intervideosrc->surface->video_buffer_count++;
-  g_mutex_unlock (&intervideosrc->surface->mutex);
+  intervideosrc->repeat_count++;
 
   if (caps) {
     gboolean ret;
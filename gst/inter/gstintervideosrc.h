@@ -32,6 +32,13 @@ G_BEGIN_DECLS
 #define GST_IS_INTER_VIDEO_SRC(obj)   (G_TYPE_CHECK_INSTANCE_TYPE((obj),GST_TYPE_INTER_VIDEO_SRC))
 #define GST_IS_INTER_VIDEO_SRC_CLASS(obj)   (G_TYPE_CHECK_CLASS_TYPE((klass),GST_TYPE_INTER_VIDEO_SRC))
 
+typedef enum
+{
+  GST_INTER_VIDEO_SRC_FRAME_SELECTION_LATEST,
+  GST_INTER_VIDEO_SRC_FRAME_SELECTION_SEQUENTIAL,
+  GST_INTER_VIDEO_SRC_FRAME_SELECTION_TIMESTAMP,
+} GstInterVideoSrcFrameSelection;
+
 typedef struct _GstInterVideoSrc GstInterVideoSrc;
 typedef struct _GstInterVideoSrcClass GstInterVideoSrcClass;
 
@@ -43,6 +50,19 @@ struct _GstInterVideoSrc
 
   char *channel;
   guint64 timeout;
+  GstInterVideoSrcFrameSelection frame_selection;
+
+  /* our cursor in the ring of the channel */
+  GstInterVideoRing *ring;
+  gint video_cookie;
+  gboolean check_info;
+  guint last_seqnum;
+  GstBuffer *last_buffer;
+  guint64 repeat_count;
+
+  /* protected by the object lock */
+  guint64 dropped;
+  guint64 duplicated;
 
   GstVideoInfo info;
   GstBuffer *black_frame;
@@ -66,6 +66,8 @@ enum
   PROP_0,
   PROP_PARSE_PRIVATE_SECTIONS,
   PROP_IGNORE_PCR,
+  PROP_STATS,
+  PROP_EXTRA_PIDS,
   /* FILL ME */
 };
 
@@ -79,6 +81,7 @@ static void mpegts_base_get_property (GObject * object, guint prop_id,
 static void mpegts_base_free_program (MpegTSBaseProgram * program);
 static void mpegts_base_deactivate_program (MpegTSBase * base,
     MpegTSBaseProgram * program);
+static void mpegts_base_update_pid_interest (MpegTSBase * base);
 static gboolean mpegts_base_sink_activate (GstPad * pad, GstObject * parent);
 static gboolean mpegts_base_sink_activate_mode (GstPad * pad,
     GstObject * parent, GstPadMode mode, gboolean active);
@@ -161,6 +164,43 @@ mpegts_base_class_init (MpegTSBaseClass * klass)
           "Ignore PCR stream for timing", DEFAULT_IGNORE_PCR,
           G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
+  /**
+   * GstMpegtsBase:stats:
+   *
+   * Packet statistics. Contains the number of packets which were handled
+   * ("packets-processed") and the number of packets on PIDs which are
+   * neither used by a selected program nor carry PSI nor are part of the
+   * "extra-pids", and which were therefore dropped without further parsing
+   * ("packets-discarded"). tsdemux only selects the program it outputs.
+   *
+   * tsdemux also reports the PES payload bytes it pushed ("pes-bytes") and
+   * the bytes it copied to collect them ("pes-bytes-copied"), which includes
+   * the copies made when a packet outgrew the memory it was collected in.
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (gobject_class, PROP_STATS,
+      g_param_spec_boxed ("stats", "Statistics",
+          "Packet statistics", GST_TYPE_STRUCTURE,
+          G_PARAM_READABLE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstMpegtsBase:extra-pids:
+   *
+   * PIDs to keep in addition to the PSI and the streams of the selected
+   * programs. Packets on these PIDs are only output by elements which
+   * forward packets of unknown PIDs, like tsparse. When set, tsparse drops
+   * the packets on all the other PIDs instead.
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (gobject_class, PROP_EXTRA_PIDS,
+      gst_param_spec_array ("extra-pids", "Extra PIDs",
+          "PIDs to keep besides the PSI and the selected programs",
+          g_param_spec_int ("pid", "PID", "PID", 0, 0x1fff, 0,
+              G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS),
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
   klass->sink_query = GST_DEBUG_FUNCPTR (mpegts_base_default_sink_query);
 
   gst_type_mark_as_plugin_api (GST_TYPE_MPEGTS_BASE, 0);
@@ -179,11 +219,43 @@ mpegts_base_set_property (GObject * object, guint prop_id,
     case PROP_IGNORE_PCR:
       base->ignore_pcr = g_value_get_boolean (value);
       break;
+    case PROP_EXTRA_PIDS:{
+      guint i, n = gst_value_array_get_size (value);
+
+      GST_OBJECT_LOCK (base);
+      g_array_set_size (base->extra_pids, 0);
+      for (i = 0; i < n; i++) {
+        guint16 pid = g_value_get_int (gst_value_array_get_value (value, i));
+
+        g_array_append_val (base->extra_pids, pid);
+      }
+      /* Applied by the streaming thread */
+      g_atomic_int_set (&base->extra_pids_changed, TRUE);
+      GST_OBJECT_UNLOCK (base);
+      break;
+    }
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
   }
 }
 
+static GstStructure *
+mpegts_base_create_stats (MpegTSBase * base)
+{
+  MpegTSBaseClass *klass = GST_MPEGTS_BASE_GET_CLASS (base);
+  GstStructure *stats;
+
+  GST_OBJECT_LOCK (base);
+  stats = gst_structure_new ("application/x-mpegts-stats",
+      "packets-processed", G_TYPE_UINT64, base->nb_processed_packets,
+      "packets-discarded", G_TYPE_UINT64, base->nb_discarded_packets, NULL);
+  if (klass->fill_stats)
+    klass->fill_stats (base, stats);
+  GST_OBJECT_UNLOCK (base);
+
+  return stats;
+}
+
 static void
 mpegts_base_get_property (GObject * object, guint prop_id,
     GValue * value, GParamSpec * pspec)
@@ -197,6 +269,23 @@ mpegts_base_get_property (GObject * object, guint prop_id,
     case PROP_IGNORE_PCR:
       g_value_set_boolean (value, base->ignore_pcr);
       break;
+    case PROP_STATS:
+      g_value_take_boxed (value, mpegts_base_create_stats (base));
+      break;
+    case PROP_EXTRA_PIDS:{
+      GValue val = G_VALUE_INIT;
+      guint i;
+
+      g_value_init (&val, G_TYPE_INT);
+      GST_OBJECT_LOCK (base);
+      for (i = 0; i < base->extra_pids->len; i++) {
+        g_value_set_int (&val, g_array_index (base->extra_pids, guint16, i));
+        gst_value_array_append_value (value, &val);
+      }
+      GST_OBJECT_UNLOCK (base);
+      g_value_unset (&val);
+      break;
+    }
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
   }
@@ -209,6 +298,12 @@ mpegts_base_reset (MpegTSBase * base)
   MpegTSBaseClass *klass = GST_MPEGTS_BASE_GET_CLASS (base);
 
   mpegts_packetizer_clear (base->packetizer);
+  base->packetizer->nb_processed_packets = 0;
+  base->packetizer->nb_discarded_packets = 0;
+  GST_OBJECT_LOCK (base);
+  base->nb_processed_packets = 0;
+  base->nb_discarded_packets = 0;
+  GST_OBJECT_UNLOCK (base);
   memset (base->is_pes, 0, 1024);
   memset (base->known_psi, 0, 1024);
 
@@ -242,6 +337,7 @@ mpegts_base_reset (MpegTSBase * base)
 
   g_hash_table_foreach_remove (base->programs, (GHRFunc) remove_each_program,
       base);
+  mpegts_base_update_pid_interest (base);
 
   base->streams_aware = GST_OBJECT_PARENT (base)
       && GST_OBJECT_FLAG_IS_SET (GST_OBJECT_PARENT (base),
@@ -272,6 +368,8 @@ mpegts_base_init (MpegTSBase * base)
   base->parse_private_sections = FALSE;
   base->is_pes = g_new0 (guint8, 1024);
   base->known_psi = g_new0 (guint8, 1024);
+  base->pid_interest = g_new0 (guint8, 1024);
+  base->extra_pids = g_array_new (FALSE, FALSE, sizeof (guint16));
   base->program_size = sizeof (MpegTSBaseProgram);
   base->stream_size = sizeof (MpegTSBaseStream);
 
@@ -292,6 +390,7 @@ mpegts_base_dispose (GObject * object)
     base->disposed = TRUE;
     g_free (base->known_psi);
     g_free (base->is_pes);
+    g_free (base->pid_interest);
   }
 
   if (G_OBJECT_CLASS (parent_class)->dispose)
@@ -308,6 +407,7 @@ mpegts_base_finalize (GObject * object)
     base->pat = NULL;
   }
   g_hash_table_destroy (base->programs);
+  g_array_free (base->extra_pids, TRUE);
 
   if (G_OBJECT_CLASS (parent_class)->finalize)
     G_OBJECT_CLASS (parent_class)->finalize (object);
@@ -371,6 +471,52 @@ mpegts_pid_in_active_programs (MpegTSBase * base, guint16 pid)
   return lookup.res;
 }
 
+static void
+foreach_selected_program (gpointer key, MpegTSBaseProgram * program,
+    MpegTSBase * base)
+{
+  MpegTSBaseClass *klass = GST_MPEGTS_BASE_GET_CLASS (base);
+  GList *tmp;
+
+  if (!program->active)
+    return;
+  if (klass->program_is_selected && !klass->program_is_selected (base,
+          program))
+    return;
+
+  /* The PES streams and the PCR, the private sections are known PSI */
+  for (tmp = program->stream_list; tmp; tmp = tmp->next) {
+    MpegTSBaseStream *stream = (MpegTSBaseStream *) tmp->data;
+
+    if (stream->pid != 0x1fff && MPEGTS_BIT_IS_SET (base->is_pes, stream->pid))
+      MPEGTS_BIT_SET (base->pid_interest, stream->pid);
+  }
+  if (program->pcr_pid > 0 && program->pcr_pid < 0x1fff)
+    MPEGTS_BIT_SET (base->pid_interest, program->pcr_pid);
+}
+
+/* Rebuilds the bitmap of the PIDs the packetizer filter lets through
+ * besides the known PSI ones. Called from the streaming thread whenever
+ * programs are (de)activated and when the extra PIDs changed */
+static void
+mpegts_base_update_pid_interest (MpegTSBase * base)
+{
+  guint i;
+
+  memset (base->pid_interest, 0, 1024);
+
+  g_hash_table_foreach (base->programs, (GHFunc) foreach_selected_program,
+      base);
+
+  GST_OBJECT_LOCK (base);
+  for (i = 0; i < base->extra_pids->len; i++)
+    MPEGTS_BIT_SET (base->pid_interest,
+        g_array_index (base->extra_pids, guint16, i) & 0x1fff);
+  base->filter_extra_pids = base->extra_pids->len > 0;
+  g_atomic_int_set (&base->extra_pids_changed, FALSE);
+  GST_OBJECT_UNLOCK (base);
+}
+
 /* returns NULL if no matching descriptor found *
  * otherwise returns a descriptor that needs to *
  * be freed */
@@ -930,6 +1076,8 @@ mpegts_base_deactivate_program (MpegTSBase * base, MpegTSBaseProgram * program)
   /* Inform subclasses we're deactivating this program */
   if (klass->program_stopped)
     klass->program_stopped (base, program);
+
+  mpegts_base_update_pid_interest (base);
 }
 
 static void
@@ -996,6 +1144,8 @@ mpegts_base_activate_program (MpegTSBase * base, MpegTSBaseProgram * program,
   if (klass->program_started != NULL)
     klass->program_started (base, program);
 
+  mpegts_base_update_pid_interest (base);
+
   GST_DEBUG_OBJECT (base, "new pmt activated");
 }
 
@@ -1149,6 +1299,7 @@ mpegts_base_apply_pmt (MpegTSBase * base, GstMpegtsSection * section)
     GST_FIXME ("We are streams_aware and new program is an update");
     /* The program is an update, and we can add/remove pads dynamically */
     mpegts_base_update_program (base, old_program, section, pmt);
+    mpegts_base_update_pid_interest (base);
     goto beach;
   }
 
@@ -1472,6 +1623,19 @@ mpegts_base_chain (GstPad * pad, GstObject * parent, GstBuffer * buf)
 
   mpegts_packetizer_push (base->packetizer, buf);
 
+  if (G_UNLIKELY (g_atomic_int_get (&base->extra_pids_changed)))
+    mpegts_base_update_pid_interest (base);
+
+  /* Unless the subclass wants to see every packet and no PIDs were picked,
+   * let the packetizer drop packets of PIDs we don't handle as early as
+   * possible */
+  if ((base->push_unknown || klass->inspect_packet)
+      && !base->filter_extra_pids)
+    mpegts_packetizer_set_pid_filter (packetizer, NULL, NULL);
+  else
+    mpegts_packetizer_set_pid_filter (packetizer, base->known_psi,
+        base->pid_interest);
+
   while (res == GST_FLOW_OK) {
     pret = mpegts_packetizer_next_packet (base->packetizer, &packet);
 
@@ -1521,6 +1685,11 @@ mpegts_base_chain (GstPad * pad, GstObject * parent, GstBuffer * buf)
     mpegts_packetizer_clear_packet (base->packetizer, &packet);
   }
 
+  GST_OBJECT_LOCK (base);
+  base->nb_processed_packets = packetizer->nb_processed_packets;
+  base->nb_discarded_packets = packetizer->nb_discarded_packets;
+  GST_OBJECT_UNLOCK (base);
+
   if (res == GST_FLOW_OK && klass->input_done)
     res = klass->input_done (base);
 
@@ -1542,6 +1711,9 @@ mpegts_base_scan (MpegTSBase * base)
 
   GST_DEBUG ("Scanning for initial sync point");
 
+  /* PCR of all PIDs are needed while scanning */
+  mpegts_packetizer_set_pid_filter (base->packetizer, NULL, NULL);
+
   /* Find initial sync point and at least 5 PCR values */
   for (i = 0; i < 20 && !done; i++) {
     GST_DEBUG ("Grabbing %d => %d", i * 65536, (i + 1) * 65536);
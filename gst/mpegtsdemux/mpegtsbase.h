@@ -133,6 +133,22 @@ struct _MpegTSBase {
   guint8 *known_psi;
   guint8 *is_pes;
 
+  /* PIDs the packetizer lets through besides the known PSI ones: the
+   * streams and PCR of the selected programs, and the extra PIDs.
+   * Rebuilt by mpegts_base_update_pid_interest() */
+  guint8 *pid_interest;
+
+  /* PIDs set with the "extra-pids" property, protected by the OBJECT_LOCK */
+  GArray *extra_pids;
+  gboolean extra_pids_changed;
+  /* Whether there are extra PIDs, for the streaming thread */
+  gboolean filter_extra_pids;
+
+  /* Packetizer counters, copied after each input buffer with the
+   * OBJECT_LOCK taken, for the "stats" property */
+  guint64 nb_processed_packets;
+  guint64 nb_discarded_packets;
+
   gboolean disposed;
 
   /* size of the MpegTSBaseProgram structure, can be overridden
@@ -191,6 +207,11 @@ struct _MpegTSBaseClass {
    * If the subclass responds TRUE, it should call mpegts_base_deactivate_and_free_program()
    * when it wants to remove it */
   gboolean (*can_remove_program) (MpegTSBase *base, MpegTSBaseProgram *program);
+  /* Whether the packets of an active program are wanted, all of them are if
+   * not implemented. Programs that aren't selected are dropped by the PID
+   * filter, the subclass must be ready for this to be called from
+   * program_started and program_stopped */
+  gboolean (*program_is_selected) (MpegTSBase *base, MpegTSBaseProgram *program);
 
   /* stream_added is called whenever a new stream has been identified */
   gboolean (*stream_added) (MpegTSBase *base, MpegTSBaseStream *stream, MpegTSBaseProgram *program);
@@ -214,6 +235,10 @@ struct _MpegTSBaseClass {
   /* Notifies subclasses input buffer has been handled */
   GstFlowReturn (*input_done) (MpegTSBase *base);
 
+  /* Adds the subclass counters to the "stats" structure.
+   * Called with the object lock */
+  void (*fill_stats) (MpegTSBase *base, GstStructure *stats);
+
   /* signals */
   void (*pat_info) (GstStructure *pat);
   void (*pmt_info) (GstStructure *pmt);
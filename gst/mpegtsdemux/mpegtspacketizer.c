@@ -28,6 +28,12 @@
 #include <string.h>
 #include <stdlib.h>
 
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
 /* Skew calculation pameters */
 #define MAX_TIME	(2 * GST_SECOND)
 
@@ -472,33 +478,27 @@ mpegts_packetizer_parse_adaptation_field_control (MpegTSPacketizer2 *
 
 static MpegTSPacketizerPacketReturn
 mpegts_packetizer_parse_packet (MpegTSPacketizer2 * packetizer,
-    MpegTSPacketizerPacket * packet)
+    MpegTSPacketizerPacket * packet, const MpegTSPacketizerHeader * header)
 {
-  guint8 *data;
   guint8 tmp;
 
-  data = packet->data_start;
-  data += 1;
-  tmp = *data;
-
   /* transport_error_indicator 1 */
-  if (G_UNLIKELY (tmp & 0x80))
+  if (G_UNLIKELY (header->flags & 0x80))
     return PACKET_BAD;
 
   /* payload_unit_start_indicator 1 */
-  packet->payload_unit_start_indicator = tmp & 0x40;
+  packet->payload_unit_start_indicator = header->flags & 0x40;
 
   /* transport_priority 1 */
   /* PID 13 */
-  packet->pid = GST_READ_UINT16_BE (data) & 0x1FFF;
-  data += 2;
+  packet->pid = header->pid;
 
-  packet->scram_afc_cc = tmp = *data++;
+  packet->scram_afc_cc = tmp = header->scram_afc_cc;
   /* transport_scrambling_control 2 */
   if (G_UNLIKELY (tmp & 0xc0))
     return PACKET_BAD;
 
-  packet->data = data;
+  packet->data = packet->data_start + 4;
 
   packet->afc_flags = 0;
   packet->pcr = G_MAXUINT64;
@@ -604,6 +604,7 @@ mpegts_packetizer_clear (MpegTSPacketizer2 * packetizer)
   packetizer->map_data = NULL;
   packetizer->map_size = 0;
   packetizer->map_offset = 0;
+  packetizer->batch_len = packetizer->batch_pos = 0;
   packetizer->last_in_time = GST_CLOCK_TIME_NONE;
   packetizer->last_pts = GST_CLOCK_TIME_NONE;
   packetizer->last_dts = GST_CLOCK_TIME_NONE;
@@ -646,6 +647,7 @@ mpegts_packetizer_flush (MpegTSPacketizer2 * packetizer, gboolean hard)
   packetizer->map_data = NULL;
   packetizer->map_size = 0;
   packetizer->map_offset = 0;
+  packetizer->batch_len = packetizer->batch_pos = 0;
   packetizer->last_in_time = GST_CLOCK_TIME_NONE;
   packetizer->last_pts = GST_CLOCK_TIME_NONE;
   packetizer->last_dts = GST_CLOCK_TIME_NONE;
@@ -725,6 +727,7 @@ mpegts_packetizer_flush_bytes (MpegTSPacketizer2 * packetizer, gsize size)
   packetizer->map_data = NULL;
   packetizer->map_size = 0;
   packetizer->map_offset = 0;
+  packetizer->batch_len = packetizer->batch_pos = 0;
 }
 
 static gboolean
@@ -754,6 +757,25 @@ mpegts_packetizer_map (MpegTSPacketizer2 * packetizer, gsize size)
   return TRUE;
 }
 
+/* Returns the position of the first sync byte in data[offset..end[, or end
+ * if there is none. memchr() is vectorized by the C library, which makes
+ * skipping over garbage when (re)synchronizing much cheaper than checking
+ * every byte in turn */
+static inline gsize
+mpegts_packetizer_find_sync_byte (const guint8 * data, gsize offset, gsize end)
+{
+  const guint8 *sync;
+
+  if (offset >= end)
+    return end;
+
+  sync = memchr (data + offset, PACKET_SYNC_BYTE, end - offset);
+  if (sync == NULL)
+    return end;
+
+  return sync - data;
+}
+
 static gboolean
 mpegts_try_discover_packet_size (MpegTSPacketizer2 * packetizer)
 {
@@ -775,8 +797,10 @@ mpegts_try_discover_packet_size (MpegTSPacketizer2 * packetizer)
 
   for (i = 0; i + 3 * MPEGTS_MAX_PACKETSIZE < size; i++) {
     /* find a sync byte */
-    if (data[i] != PACKET_SYNC_BYTE)
-      continue;
+    i = mpegts_packetizer_find_sync_byte (data, i,
+        size - 3 * MPEGTS_MAX_PACKETSIZE);
+    if (i + 3 * MPEGTS_MAX_PACKETSIZE >= size)
+      break;
 
     /* check for 4 consecutive sync bytes with each possible packet size */
     for (j = 0; j < G_N_ELEMENTS (psizes); j++) {
@@ -793,6 +817,7 @@ mpegts_try_discover_packet_size (MpegTSPacketizer2 * packetizer)
 
 out:
   packetizer->map_offset += i;
+  packetizer->batch_len = packetizer->batch_pos = 0;
 
   if (packetizer->packet_size == 0) {
     GST_DEBUG ("Could not determine packet size in %" G_GSIZE_FORMAT
@@ -832,8 +857,11 @@ mpegts_packetizer_sync (MpegTSPacketizer2 * packetizer)
     sync_offset = 0;
 
   for (i = sync_offset; i + 2 * packet_size < size; i++) {
-    if (data[i] == PACKET_SYNC_BYTE &&
-        data[i + packet_size] == PACKET_SYNC_BYTE &&
+    i = mpegts_packetizer_find_sync_byte (data, i, size - 2 * packet_size);
+    if (i + 2 * packet_size >= size)
+      break;
+
+    if (data[i + packet_size] == PACKET_SYNC_BYTE &&
         data[i + 2 * packet_size] == PACKET_SYNC_BYTE) {
       found = TRUE;
       break;
@@ -841,6 +869,7 @@ mpegts_packetizer_sync (MpegTSPacketizer2 * packetizer)
   }
 
   packetizer->map_offset += i - sync_offset;
+  packetizer->batch_len = packetizer->batch_pos = 0;
 
   if (!found)
     mpegts_packetizer_flush_bytes (packetizer, packetizer->map_offset);
@@ -848,6 +877,84 @@ mpegts_packetizer_sync (MpegTSPacketizer2 * packetizer)
   return found;
 }
 
+/* Returns the number of leading @words whose top byte is the sync byte */
+static guint
+mpegts_packetizer_count_synced (const guint32 * words, guint n)
+{
+  guint i = 0;
+
+#if defined(__SSE2__)
+  const __m128i mask = _mm_set1_epi32 ((gint32) 0xff000000);
+  const __m128i sync = _mm_set1_epi32 ((gint32) (PACKET_SYNC_BYTE << 24));
+
+  for (; i + 4 <= n; i += 4) {
+    __m128i v = _mm_loadu_si128 ((const __m128i *) (words + i));
+    v = _mm_cmpeq_epi32 (_mm_and_si128 (v, mask), sync);
+    if (_mm_movemask_epi8 (v) != 0xffff)
+      break;
+  }
+#elif defined(__ARM_NEON)
+  const uint32x4_t mask = vdupq_n_u32 (0xff000000);
+  const uint32x4_t sync = vdupq_n_u32 (PACKET_SYNC_BYTE << 24);
+
+  for (; i + 4 <= n; i += 4) {
+    uint32x4_t v = vceqq_u32 (vandq_u32 (vld1q_u32 (words + i), mask), sync);
+    uint32x2_t r = vand_u32 (vget_low_u32 (v), vget_high_u32 (v));
+    if ((vget_lane_u32 (r, 0) & vget_lane_u32 (r, 1)) != 0xffffffff)
+      break;
+  }
+#endif
+
+  /* The remainder, and the group of four with the first bad word */
+  for (; i < n; i++) {
+    if ((words[i] >> 24) != PACKET_SYNC_BYTE)
+      break;
+  }
+
+  return i;
+}
+
+/* Validates the sync bytes of up to MPEGTS_PACKETIZER_BATCH_SIZE packets
+ * of the mapped data at once, and parses their headers. The batch stops
+ * right before the first packet without a sync byte, so that losing sync
+ * is handled exactly as when checking one packet at a time. */
+static void
+mpegts_packetizer_fill_batch (MpegTSPacketizer2 * packetizer,
+    guint packet_size, gsize sync_offset)
+{
+  guint32 words[MPEGTS_PACKETIZER_BATCH_SIZE];
+  const guint8 *data;
+  guint i, n;
+
+  n = MIN ((packetizer->map_size - packetizer->map_offset) / packet_size,
+      MPEGTS_PACKETIZER_BATCH_SIZE);
+  data = packetizer->map_data + packetizer->map_offset + sync_offset;
+
+  /* Gather the headers, which are packet_size apart, into one array */
+  for (i = 0; i < n; i++)
+    words[i] = GST_READ_UINT32_BE (data + i * packet_size);
+
+  n = mpegts_packetizer_count_synced (words, n);
+
+  for (i = 0; i < n; i++) {
+    MpegTSPacketizerHeader *header = &packetizer->batch[i];
+
+    header->flags = (words[i] >> 16) & 0xc0;
+    header->pid = (words[i] >> 8) & 0x1FFF;
+    header->scram_afc_cc = words[i] & 0xff;
+  }
+
+  packetizer->batch_len = n;
+  packetizer->batch_pos = 0;
+}
+
+static inline gboolean
+mpegts_packetizer_pid_is_wanted (MpegTSPacketizer2 * packetizer, guint16 pid)
+{
+  return MPEGTS_BIT_IS_SET (packetizer->filter_interest, pid)
+      || MPEGTS_BIT_IS_SET (packetizer->filter_known_psi, pid);
+}
+
 MpegTSPacketizerPacketReturn
 mpegts_packetizer_next_packet (MpegTSPacketizer2 * packetizer,
     MpegTSPacketizerPacket * packet)
@@ -870,6 +977,8 @@ mpegts_packetizer_next_packet (MpegTSPacketizer2 * packetizer,
     sync_offset = 0;
 
   while (1) {
+    const MpegTSPacketizerHeader *header;
+
     if (packetizer->need_sync) {
       if (!mpegts_packetizer_sync (packetizer))
         return PACKET_NEED_MORE;
@@ -879,12 +988,27 @@ mpegts_packetizer_next_packet (MpegTSPacketizer2 * packetizer,
     if (!mpegts_packetizer_map (packetizer, packet_size))
       return PACKET_NEED_MORE;
 
+    if (packetizer->batch_pos == packetizer->batch_len)
+      mpegts_packetizer_fill_batch (packetizer, packet_size, sync_offset);
+
     packet_data = &packetizer->map_data[packetizer->map_offset + sync_offset];
 
-    /* Check sync byte */
-    if (G_UNLIKELY (*packet_data != PACKET_SYNC_BYTE)) {
+    /* An empty batch means the sync byte of this packet is wrong */
+    if (G_UNLIKELY (packetizer->batch_len == 0)) {
       GST_DEBUG ("lost sync");
       packetizer->need_sync = TRUE;
+      continue;
+    }
+
+    header = &packetizer->batch[packetizer->batch_pos++];
+
+    if (packetizer->filter_interest
+        && !mpegts_packetizer_pid_is_wanted (packetizer, header->pid)) {
+      /* Skip packets nobody is interested in, without going through
+       * adaptation field parsing and PCR handling */
+      packetizer->offset += packet_size;
+      packetizer->map_offset += packet_size;
+      packetizer->nb_discarded_packets++;
     } else {
       /* ALL mpeg-ts variants contain 188 bytes of data. Those with bigger
        * packet sizes contain either extra data (timesync, FEC, ..) either
@@ -894,9 +1018,10 @@ mpegts_packetizer_next_packet (MpegTSPacketizer2 * packetizer,
       packet->offset = packetizer->offset;
       GST_LOG ("offset %" G_GUINT64_FORMAT, packet->offset);
       packetizer->offset += packet_size;
+      packetizer->nb_processed_packets++;
       GST_MEMDUMP ("data_start", packet->data_start, 16);
 
-      return mpegts_packetizer_parse_packet (packetizer, packet);
+      return mpegts_packetizer_parse_packet (packetizer, packet, header);
     }
   }
 }
@@ -2513,6 +2638,20 @@ mpegts_packetizer_set_reference_offset (MpegTSPacketizer2 * packetizer,
   PACKETIZER_GROUP_UNLOCK (packetizer);
 }
 
+/* Only return packets for PIDs set in either @known_psi or @interest from
+ * mpegts_packetizer_next_packet(). The tables are not copied and can be
+ * updated by the caller at any time. Passing NULL disables filtering. */
+void
+mpegts_packetizer_set_pid_filter (MpegTSPacketizer2 * packetizer,
+    const guint8 * known_psi, const guint8 * interest)
+{
+  if (known_psi == NULL || interest == NULL)
+    known_psi = interest = NULL;
+
+  packetizer->filter_known_psi = known_psi;
+  packetizer->filter_interest = interest;
+}
+
 void
 mpegts_packetizer_set_pcr_discont_threshold (MpegTSPacketizer2 * packetizer,
     GstClockTime threshold)
@@ -241,6 +241,18 @@ typedef struct _MpegTSPCR
   PCROffsetCurrent *current;
 } MpegTSPCR;
 
+/* Number of packet headers validated at once */
+#define MPEGTS_PACKETIZER_BATCH_SIZE 64
+
+/* The first four bytes of a packet, once its sync byte has been checked */
+typedef struct
+{
+  guint16 pid;
+  /* transport_error_indicator and payload_unit_start_indicator */
+  guint8  flags;
+  guint8  scram_afc_cc;
+} MpegTSPacketizerHeader;
+
 struct _MpegTSPacketizer2 {
   GObject     parent;
 
@@ -269,6 +281,12 @@ struct _MpegTSPacketizer2 {
   gsize map_size;
   gboolean need_sync;
 
+  /* Headers of the next packets of the mapped data, starting at map_offset.
+   * Only packets with a valid sync byte are in the batch. */
+  MpegTSPacketizerHeader batch[MPEGTS_PACKETIZER_BATCH_SIZE];
+  guint batch_len;
+  guint batch_pos;
+
   /* Reference offset */
   guint64 refoffset;
 
@@ -287,6 +305,16 @@ struct _MpegTSPacketizer2 {
   /* PTS/DTS of last buffer */
   GstClockTime last_pts;
   GstClockTime last_dts;
+
+  /* PID filter bitmaps (not owned, see mpegts_packetizer_set_pid_filter()).
+   * Packets on PIDs set in neither are dropped right after the header
+   * has been checked */
+  const guint8 *filter_known_psi;
+  const guint8 *filter_interest;
+
+  /* Number of packets returned and dropped by the PID filter */
+  guint64 nb_processed_packets;
+  guint64 nb_discarded_packets;
 };
 
 struct _MpegTSPacketizer2Class {
@@ -378,6 +406,9 @@ G_GNUC_INTERNAL void
 mpegts_packetizer_set_reference_offset (MpegTSPacketizer2 * packetizer,
 					guint64 refoffset);
 G_GNUC_INTERNAL void
+mpegts_packetizer_set_pid_filter (MpegTSPacketizer2 * packetizer,
+				  const guint8 * known_psi, const guint8 * interest);
+G_GNUC_INTERNAL void
 mpegts_packetizer_set_pcr_discont_threshold (MpegTSPacketizer2 * packetizer,
 					GstClockTime threshold);
 G_END_DECLS
@@ -75,6 +75,8 @@
 /* latency in msecs */
 #define DEFAULT_LATENCY (700)
 
+#define DEFAULT_PES_ARENA FALSE
+
 /* Limit PES packet collection to a maximum of 32MB
  * which is more than large enough to support an H264 frame at
  * maximum profile/level/bitrate at 30fps or above.
@@ -82,6 +84,14 @@
  * up to this size */
 #define MAX_PES_PAYLOAD (32 * 1024 * 1024)
 
+/* Minimum allocation for PES packets of unknown size */
+#define MIN_PES_ALLOCATION 8192
+
+/* Minimum size of the arenas PES packets are collected into with
+ * "pes-arena", and number of released arenas each stream keeps for reuse */
+#define MIN_PES_ARENA_SIZE (512 * 1024)
+#define MAX_FREE_PES_ARENAS 4
+
 GST_DEBUG_CATEGORY_STATIC (ts_demux_debug);
 #define GST_CAT_DEFAULT ts_demux_debug
 
@@ -117,6 +127,33 @@ typedef struct
   guint64 pts, dts;
 } PendingBuffer;
 
+/* Memory consecutive PES packets of a stream are collected into with
+ * "pes-arena". Output buffers wrap the exact range of their packet and hold
+ * a reference on the arena, so that a small packet doesn't pin memory sized
+ * for the largest ones, and released arenas go back to the pool of their
+ * stream */
+typedef struct _TSDemuxPesPool TSDemuxPesPool;
+
+typedef struct
+{
+  gint refcount;
+  /* Pool to return the arena to */
+  TSDemuxPesPool *pool;
+  gsize size;
+  /* Start of the free space, only used from the streaming thread */
+  gsize offset;
+} TSDemuxPesArena;
+
+#define PES_ARENA_DATA(arena) ((guint8 *) (arena) + sizeof (TSDemuxPesArena))
+
+struct _TSDemuxPesPool
+{
+  gint refcount;
+  GMutex lock;
+  GSList *free_arenas;
+  guint n_free;
+};
+
 typedef struct _TSDemuxStream TSDemuxStream;
 
 typedef struct _TSDemuxH264ParsingInfos TSDemuxH264ParsingInfos;
@@ -182,6 +219,20 @@ struct _TSDemuxStream
   guint current_size;
   /* Size of ->data */
   guint allocated_size;
+  /* Estimated size of the next unbounded PES packet, based on the
+   * previous ones. Used to pre-size ->data and avoid reallocations */
+  guint size_hint;
+  /* Largest unbounded PES packet since the hint was last updated */
+  guint size_peak;
+  guint nb_sized_packets;
+
+  /* Arenas used with "pes-arena", and whether ->data points into the
+   * current one instead of being allocated on its own */
+  TSDemuxPesPool *pes_pool;
+  TSDemuxPesArena *arena;
+  gboolean data_in_arena;
+  /* Bytes copied while growing ->data for the current PES packet */
+  guint64 bytes_moved;
 
   /* Current PTS/DTS for this stream (in running time) */
   GstClockTime pts;
@@ -297,6 +348,7 @@ enum
   PROP_PROGRAM_NUMBER,
   PROP_EMIT_STATS,
   PROP_LATENCY,
+  PROP_PES_ARENA,
   /* FILL ME */
 };
 
@@ -313,6 +365,9 @@ gst_ts_demux_program_stopped (MpegTSBase * base, MpegTSBaseProgram * program);
 static gboolean
 gst_ts_demux_can_remove_program (MpegTSBase * base,
     MpegTSBaseProgram * program);
+static gboolean
+gst_ts_demux_program_is_selected (MpegTSBase * base,
+    MpegTSBaseProgram * program);
 static void gst_ts_demux_reset (MpegTSBase * base);
 static GstFlowReturn
 gst_ts_demux_push (MpegTSBase * base, MpegTSPacketizerPacket * packet,
@@ -340,6 +395,198 @@ static gboolean push_event (MpegTSBase * base, GstEvent * event);
 static gboolean sink_query (MpegTSBase * base, GstQuery * query);
 static void gst_ts_demux_check_and_sync_streams (GstTSDemux * demux,
     GstClockTime time);
+static void gst_ts_demux_fill_stats (MpegTSBase * base, GstStructure * stats);
+
+static TSDemuxPesPool *
+pes_pool_new (void)
+{
+  TSDemuxPesPool *pool = g_new0 (TSDemuxPesPool, 1);
+
+  pool->refcount = 1;
+  g_mutex_init (&pool->lock);
+
+  return pool;
+}
+
+static void
+pes_pool_unref (TSDemuxPesPool * pool)
+{
+  if (!g_atomic_int_dec_and_test (&pool->refcount))
+    return;
+
+  g_slist_free_full (pool->free_arenas, g_free);
+  g_mutex_clear (&pool->lock);
+  g_free (pool);
+}
+
+/* Returns an empty arena of at least @size bytes */
+static TSDemuxPesArena *
+pes_pool_acquire (TSDemuxPesPool * pool, gsize size)
+{
+  TSDemuxPesArena *arena = NULL;
+
+  g_mutex_lock (&pool->lock);
+  while (pool->free_arenas) {
+    arena = pool->free_arenas->data;
+    pool->free_arenas = g_slist_delete_link (pool->free_arenas,
+        pool->free_arenas);
+    pool->n_free--;
+    if (arena->size >= size)
+      break;
+    /* Too small for the packets of the stream now */
+    g_free (arena);
+    arena = NULL;
+  }
+  g_mutex_unlock (&pool->lock);
+
+  if (arena == NULL) {
+    arena = g_malloc (sizeof (TSDemuxPesArena) + size);
+    arena->size = size;
+  }
+
+  arena->refcount = 1;
+  arena->offset = 0;
+  arena->pool = pool;
+  g_atomic_int_inc (&pool->refcount);
+
+  return arena;
+}
+
+/* Called from any thread, when the stream moves to another arena or when
+ * the buffers wrapping parts of it are freed */
+static void
+pes_arena_unref (TSDemuxPesArena * arena)
+{
+  TSDemuxPesPool *pool = arena->pool;
+
+  if (!g_atomic_int_dec_and_test (&arena->refcount))
+    return;
+
+  g_mutex_lock (&pool->lock);
+  if (pool->n_free < MAX_FREE_PES_ARENAS) {
+    pool->free_arenas = g_slist_prepend (pool->free_arenas, arena);
+    pool->n_free++;
+    arena = NULL;
+  }
+  g_mutex_unlock (&pool->lock);
+
+  g_free (arena);
+  pes_pool_unref (pool);
+}
+
+/* Sets up ->data for a new PES packet of at least @size bytes */
+static void
+gst_ts_demux_stream_alloc_data (GstTSDemux * demux, TSDemuxStream * stream,
+    guint size)
+{
+  TSDemuxPesArena *arena = stream->arena;
+
+  g_assert (stream->data == NULL);
+
+  stream->bytes_moved = 0;
+
+  if (!demux->pes_arena) {
+    stream->data = g_malloc (size);
+    stream->allocated_size = size;
+    stream->data_in_arena = FALSE;
+    return;
+  }
+
+  if (arena == NULL || arena->size - arena->offset < size) {
+    if (arena)
+      pes_arena_unref (arena);
+    if (stream->pes_pool == NULL)
+      stream->pes_pool = pes_pool_new ();
+    arena = stream->arena = pes_pool_acquire (stream->pes_pool,
+        MAX (MIN_PES_ARENA_SIZE, 4 * (gsize) size));
+  }
+
+  stream->data = PES_ARENA_DATA (arena) + arena->offset;
+  stream->allocated_size = arena->size - arena->offset;
+  stream->data_in_arena = TRUE;
+}
+
+/* Makes room for @size more bytes in ->data */
+static void
+gst_ts_demux_stream_grow_data (TSDemuxStream * stream, guint size)
+{
+  guint needed = stream->current_size + size;
+
+  GST_LOG ("resizing buffer");
+
+  /* Counted as if realloc() always moved the data */
+  stream->bytes_moved += stream->current_size;
+
+  if (stream->data_in_arena) {
+    TSDemuxPesArena *arena = pes_pool_acquire (stream->pes_pool,
+        MAX (MIN_PES_ARENA_SIZE, 4 * (gsize) needed));
+
+    /* The space the packet used in the previous arena is lost */
+    memcpy (PES_ARENA_DATA (arena), stream->data, stream->current_size);
+    pes_arena_unref (stream->arena);
+    stream->arena = arena;
+    stream->data = PES_ARENA_DATA (arena);
+    stream->allocated_size = arena->size;
+    return;
+  }
+
+  do {
+    stream->allocated_size =
+        MAX (MIN_PES_ALLOCATION, 2 * stream->allocated_size);
+  } while (needed > stream->allocated_size);
+  stream->data = g_realloc (stream->data, stream->allocated_size);
+}
+
+/* Drops the PES packet being collected */
+static void
+gst_ts_demux_stream_free_data (TSDemuxStream * stream)
+{
+  /* Its space in the arena is reused by the next packet */
+  if (!stream->data_in_arena)
+    g_free (stream->data);
+  stream->data = NULL;
+  stream->data_in_arena = FALSE;
+  stream->allocated_size = 0;
+  stream->bytes_moved = 0;
+}
+
+/* Wraps @size bytes at @offset of the collected PES packet into a buffer,
+ * which takes over ->data */
+static GstBuffer *
+gst_ts_demux_stream_take_buffer (TSDemuxStream * stream, gsize offset,
+    gsize size)
+{
+  guint8 *data = stream->data;
+  GstBuffer *buffer;
+
+  if (stream->data_in_arena) {
+    TSDemuxPesArena *arena = stream->arena;
+
+    /* Keep the next packet aligned */
+    arena->offset = MIN (arena->size,
+        arena->offset + GST_ROUND_UP_8 (stream->current_size));
+    g_atomic_int_inc (&arena->refcount);
+
+    buffer = gst_buffer_new ();
+    gst_buffer_append_memory (buffer, gst_memory_new_wrapped (0,
+            data + offset, size, 0, size, arena,
+            (GDestroyNotify) pes_arena_unref));
+  } else {
+    /* Don't let the buffer pin the unused end of the allocation, which is
+     * sized for the largest packets of the stream */
+    if (stream->allocated_size > stream->current_size)
+      data = g_realloc (data, MAX (stream->current_size, 1));
+
+    buffer = gst_buffer_new_wrapped_full (0, data, stream->current_size,
+        offset, size, data, g_free);
+  }
+
+  stream->data = NULL;
+  stream->data_in_arena = FALSE;
+  stream->allocated_size = 0;
+
+  return buffer;
+}
 
 static void
 _extra_init (void)
@@ -401,6 +648,24 @@ gst_ts_demux_class_init (GstTSDemuxClass * klass)
           G_MAXINT, DEFAULT_LATENCY,
           G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
+  /**
+   * GstTSDemux:pes-arena:
+   *
+   * Collect the PES packets of each stream one after the other into large
+   * recycled memory arenas, instead of allocating memory for each of them.
+   * This avoids most allocations and copies when the packet sizes vary a lot,
+   * like keyframes and other frames of a video stream, but an output buffer
+   * that is kept around keeps the whole arena it is part of allocated.
+   *
+   * The "stats" property reports the collected and copied PES payload bytes.
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (gobject_class, PROP_PES_ARENA,
+      g_param_spec_boolean ("pes-arena", "PES arena",
+          "Collect PES packets into recycled memory arenas",
+          DEFAULT_PES_ARENA, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
   element_class = GST_ELEMENT_CLASS (klass);
   gst_element_class_add_pad_template (element_class,
       gst_static_pad_template_get (&video_template));
@@ -427,11 +692,13 @@ gst_ts_demux_class_init (GstTSDemuxClass * klass)
   ts_class->program_stopped = GST_DEBUG_FUNCPTR (gst_ts_demux_program_stopped);
   ts_class->update_program = GST_DEBUG_FUNCPTR (gst_ts_demux_update_program);
   ts_class->can_remove_program = gst_ts_demux_can_remove_program;
+  ts_class->program_is_selected = gst_ts_demux_program_is_selected;
   ts_class->stream_added = gst_ts_demux_stream_added;
   ts_class->stream_removed = gst_ts_demux_stream_removed;
   ts_class->seek = GST_DEBUG_FUNCPTR (gst_ts_demux_do_seek);
   ts_class->flush = GST_DEBUG_FUNCPTR (gst_ts_demux_flush);
   ts_class->drain = GST_DEBUG_FUNCPTR (gst_ts_demux_drain);
+  ts_class->fill_stats = GST_DEBUG_FUNCPTR (gst_ts_demux_fill_stats);
 }
 
 static void
@@ -460,6 +727,22 @@ gst_ts_demux_reset (MpegTSBase * base)
 
   demux->last_seek_offset = -1;
   demux->program_generation = 0;
+
+  GST_OBJECT_LOCK (demux);
+  demux->pes_bytes = 0;
+  demux->pes_bytes_copied = 0;
+  GST_OBJECT_UNLOCK (demux);
+}
+
+/* Called with the object lock */
+static void
+gst_ts_demux_fill_stats (MpegTSBase * base, GstStructure * stats)
+{
+  GstTSDemux *demux = (GstTSDemux *) base;
+
+  gst_structure_set (stats,
+      "pes-bytes", G_TYPE_UINT64, demux->pes_bytes,
+      "pes-bytes-copied", G_TYPE_UINT64, demux->pes_bytes_copied, NULL);
 }
 
 static void
@@ -476,6 +759,7 @@ gst_ts_demux_init (GstTSDemux * demux)
   demux->requested_program_number = -1;
   demux->program_number = -1;
   demux->latency = DEFAULT_LATENCY;
+  demux->pes_arena = DEFAULT_PES_ARENA;
   gst_ts_demux_reset (base);
 }
 
@@ -498,6 +782,9 @@ gst_ts_demux_set_property (GObject * object, guint prop_id,
     case PROP_LATENCY:
       demux->latency = g_value_get_int (value);
       break;
+    case PROP_PES_ARENA:
+      demux->pes_arena = g_value_get_boolean (value);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
   }
@@ -519,6 +806,9 @@ gst_ts_demux_get_property (GObject * object, guint prop_id,
     case PROP_LATENCY:
       g_value_set_int (value, demux->latency);
       break;
+    case PROP_PES_ARENA:
+      g_value_set_boolean (value, demux->pes_arena);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
   }
@@ -810,8 +1100,9 @@ scan_keyframe_h264 (TSDemuxStream * stream, const guint8 * data,
       clear_simple_buffer (&h264infos->framedata);
     }
 
-    g_free (stream->data);
+    gst_ts_demux_stream_free_data (stream);
     stream->current_size = gst_byte_writer_get_size (h264infos->sps);
+    stream->allocated_size = stream->current_size;
     stream->data = gst_byte_writer_reset_and_get_data (h264infos->sps);
     gst_byte_writer_init (h264infos->sps);
     gst_byte_writer_init (h264infos->pps);
@@ -1873,6 +2164,12 @@ gst_ts_demux_stream_added (MpegTSBase * base, MpegTSBaseStream * bstream,
   GstTSDemux *demux = (GstTSDemux *) base;
   TSDemuxStream *stream = (TSDemuxStream *) bstream;
 
+  if (stream->size_hint == 0) {
+    stream->size_hint = MIN_PES_ALLOCATION;
+    stream->size_peak = 0;
+    stream->nb_sized_packets = 0;
+  }
+
   if (!stream->pad) {
     /* Create the pad */
     if (bstream->stream_type != 0xff) {
@@ -1958,6 +2255,15 @@ gst_ts_demux_stream_removed (MpegTSBase * base, MpegTSBaseStream * bstream)
 
   gst_ts_demux_stream_flush (stream, GST_TS_DEMUX_CAST (base), TRUE);
 
+  if (stream->arena) {
+    pes_arena_unref (stream->arena);
+    stream->arena = NULL;
+  }
+  if (stream->pes_pool) {
+    pes_pool_unref (stream->pes_pool);
+    stream->pes_pool = NULL;
+  }
+
   if (stream->taglist != NULL) {
     gst_tag_list_unref (stream->taglist);
     stream->taglist = NULL;
@@ -1989,11 +2295,9 @@ gst_ts_demux_stream_flush (TSDemuxStream * stream, GstTSDemux * tsdemux,
 {
   GST_DEBUG ("flushing stream %p", stream);
 
-  g_free (stream->data);
-  stream->data = NULL;
+  gst_ts_demux_stream_free_data (stream);
   stream->state = PENDING_PACKET_EMPTY;
   stream->expected_size = 0;
-  stream->allocated_size = 0;
   stream->current_size = 0;
   stream->discont = TRUE;
   stream->pts = GST_CLOCK_TIME_NONE;
@@ -2005,6 +2309,11 @@ gst_ts_demux_stream_flush (TSDemuxStream * stream, GstTSDemux * tsdemux,
   stream->gap_ref_buffers = 0;
   stream->gap_ref_pts = GST_CLOCK_TIME_NONE;
   stream->continuity_counter = CONTINUITY_UNSET;
+  if (hard) {
+    stream->size_hint = MIN_PES_ALLOCATION;
+    stream->size_peak = 0;
+    stream->nb_sized_packets = 0;
+  }
 
   if (G_UNLIKELY (stream->pending)) {
     GList *tmp;
@@ -2172,6 +2481,17 @@ gst_ts_demux_program_started (MpegTSBase * base, MpegTSBaseProgram * program)
   }
 }
 
+/* Only the program being output is demuxed, the other ones are activated
+ * when their PMT arrives but their packets are dropped by the PID filter */
+static gboolean
+gst_ts_demux_program_is_selected (MpegTSBase * base,
+    MpegTSBaseProgram * program)
+{
+  GstTSDemux *demux = GST_TS_DEMUX (base);
+
+  return program == demux->program || program == demux->previous_program;
+}
+
 static void
 gst_ts_demux_program_stopped (MpegTSBase * base, MpegTSBaseProgram * program)
 {
@@ -2478,12 +2798,12 @@ gst_ts_demux_parse_pes_header (GstTSDemux * demux, TSDemuxStream * stream,
 
   /* Create the output buffer */
   if (stream->expected_size)
-    stream->allocated_size = MAX (stream->expected_size, length);
+    gst_ts_demux_stream_alloc_data (demux, stream,
+        MAX (stream->expected_size, length));
   else
-    stream->allocated_size = MAX (8192, length);
+    gst_ts_demux_stream_alloc_data (demux, stream,
+        MAX (stream->size_hint, length));
 
-  g_assert (stream->data == NULL);
-  stream->data = g_malloc (stream->allocated_size);
   memcpy (stream->data, data, length);
   stream->current_size = length;
 
@@ -2523,10 +2843,8 @@ gst_ts_demux_queue_data (GstTSDemux * demux, TSDemuxStream * stream,
       if (packet->payload_unit_start_indicator) {
         /* A mismatch is fatal, except if this is the beginning of a new
          * frame (from which we can recover) */
-        if (G_UNLIKELY (stream->data)) {
-          g_free (stream->data);
-          stream->data = NULL;
-        }
+        if (G_UNLIKELY (stream->data))
+          gst_ts_demux_stream_free_data (stream);
         stream->state = PENDING_PACKET_HEADER;
       } else {
         GST_WARNING ("CONTINUITY: Mismatch packet %d, stream %d",
@@ -2559,13 +2877,13 @@ gst_ts_demux_queue_data (GstTSDemux * demux, TSDemuxStream * stream,
     case PENDING_PACKET_BUFFER:
     {
       GST_LOG ("BUFFER: appending data");
-      if (G_UNLIKELY (stream->current_size + size > stream->allocated_size)) {
-        GST_LOG ("resizing buffer");
-        do {
-          stream->allocated_size = MAX (8192, 2 * stream->allocated_size);
-        } while (stream->current_size + size > stream->allocated_size);
-        stream->data = g_realloc (stream->data, stream->allocated_size);
-      }
+      /* The previous part of an oversized PES packet was pushed */
+      if (G_UNLIKELY (stream->data == NULL))
+        gst_ts_demux_stream_alloc_data (demux, stream,
+            MAX (stream->size_hint, size));
+      else if (G_UNLIKELY (stream->current_size + size >
+              stream->allocated_size))
+        gst_ts_demux_stream_grow_data (stream, size);
       memcpy (stream->data + stream->current_size, data, size);
       stream->current_size += size;
       break;
@@ -2573,10 +2891,8 @@ gst_ts_demux_queue_data (GstTSDemux * demux, TSDemuxStream * stream,
     case PENDING_PACKET_DISCONT:
     {
       GST_LOG ("DISCONT: not storing/pushing");
-      if (G_UNLIKELY (stream->data)) {
-        g_free (stream->data);
-        stream->data = NULL;
-      }
+      if (G_UNLIKELY (stream->data))
+        gst_ts_demux_stream_free_data (stream);
       stream->continuity_counter = CONTINUITY_UNSET;
       break;
     }
@@ -2828,8 +3144,7 @@ parse_opus_access_unit (TSDemuxStream * stream)
     gst_buffer_list_add (buffer_list, buffer);
   } while (gst_byte_reader_get_remaining (&reader) > 0);
 
-  g_free (stream->data);
-  stream->data = NULL;
+  gst_ts_demux_stream_free_data (stream);
   stream->current_size = 0;
 
   return buffer_list;
@@ -2837,8 +3152,7 @@ parse_opus_access_unit (TSDemuxStream * stream)
 error:
   {
     GST_ERROR ("Failed to parse Opus access unit");
-    g_free (stream->data);
-    stream->data = NULL;
+    gst_ts_demux_stream_free_data (stream);
     stream->current_size = 0;
     if (buffer_list)
       gst_buffer_list_unref (buffer_list);
@@ -2990,17 +3304,14 @@ parse_jp2k_access_unit (TSDemuxStream * stream)
     }
   }
 
-  retbuf = gst_buffer_new_wrapped_full (0, stream->data, stream->current_size,
-      data_location, stream->current_size - data_location,
-      stream->data, g_free);
-  stream->data = NULL;
+  retbuf = gst_ts_demux_stream_take_buffer (stream, data_location,
+      stream->current_size - data_location);
   stream->current_size = 0;
   return retbuf;
 
 error:
   GST_ERROR ("Failed to parse JP2K access unit");
-  g_free (stream->data);
-  stream->data = NULL;
+  gst_ts_demux_stream_free_data (stream);
   stream->current_size = 0;
   return NULL;
 }
@@ -3074,10 +3385,40 @@ out:
     gst_caps_unref (caps);
   }
 
-  return gst_buffer_new_wrapped (stream->data, stream->current_size);
+  return gst_ts_demux_stream_take_buffer (stream, 0, stream->current_size);
 }
 
 
+/* Track the size of unbounded PES packets so that the next one can be
+ * allocated in one go instead of being grown (and copied) by doubling.
+ * The hint follows increases immediately, and is otherwise the largest
+ * packet of the last SIZE_HINT_WINDOW packets or so, which covers the
+ * keyframes of the usual GOP lengths. Output buffers don't keep the unused
+ * part of the allocation around, see gst_ts_demux_stream_take_buffer() */
+#define SIZE_HINT_WINDOW 64
+
+static inline void
+gst_ts_demux_stream_update_size_hint (TSDemuxStream * stream)
+{
+  guint size = stream->current_size;
+
+  if (stream->expected_size)
+    return;
+
+  stream->size_peak = MAX (stream->size_peak, size);
+  if (size > stream->size_hint)
+    stream->size_hint = size;
+
+  if (++stream->nb_sized_packets == SIZE_HINT_WINDOW) {
+    stream->size_hint = stream->size_peak;
+    stream->size_peak = 0;
+    stream->nb_sized_packets = 0;
+  }
+
+  stream->size_hint = CLAMP (stream->size_hint, MIN_PES_ALLOCATION,
+      MAX_PES_PAYLOAD);
+}
+
 static GstFlowReturn
 gst_ts_demux_push_pending_data (GstTSDemux * demux, TSDemuxStream * stream,
     MpegTSBaseProgram * target_program)
@@ -3108,9 +3449,16 @@ gst_ts_demux_push_pending_data (GstTSDemux * demux, TSDemuxStream * stream,
     goto beach;
   }
 
+  gst_ts_demux_stream_update_size_hint (stream);
+
+  GST_OBJECT_LOCK (demux);
+  demux->pes_bytes += stream->current_size;
+  demux->pes_bytes_copied += stream->current_size + stream->bytes_moved;
+  GST_OBJECT_UNLOCK (demux);
+
   if (G_UNLIKELY (demux->program == NULL)) {
     GST_LOG_OBJECT (demux, "No program");
-    g_free (stream->data);
+    gst_ts_demux_stream_free_data (stream);
     goto beach;
   }
 
@@ -3143,7 +3491,8 @@ gst_ts_demux_push_pending_data (GstTSDemux * demux, TSDemuxStream * stream,
           goto beach;
         }
       } else {
-        buffer = gst_buffer_new_wrapped (stream->data, stream->current_size);
+        buffer = gst_ts_demux_stream_take_buffer (stream, 0,
+            stream->current_size);
       }
 
       stream->seeked_pts = stream->pts;
@@ -3165,10 +3514,7 @@ gst_ts_demux_push_pending_data (GstTSDemux * demux, TSDemuxStream * stream,
         GST_DEBUG_OBJECT (cand->pad, "Clearing stream");
         cand->continuity_counter = CONTINUITY_UNSET;
         cand->state = PENDING_PACKET_EMPTY;
-        if (cand->data)
-          g_free (cand->data);
-        cand->data = NULL;
-        cand->allocated_size = 0;
+        gst_ts_demux_stream_free_data (cand);
         cand->current_size = 0;
       }
       base->mode = BASE_MODE_SEEKING;
@@ -3203,7 +3549,8 @@ gst_ts_demux_push_pending_data (GstTSDemux * demux, TSDemuxStream * stream,
         goto beach;
       }
     } else {
-      buffer = gst_buffer_new_wrapped (stream->data, stream->current_size);
+      buffer = gst_ts_demux_stream_take_buffer (stream, 0,
+          stream->current_size);
     }
 
     if (G_UNLIKELY (stream->pending_ts && !check_pending_buffers (demux))) {
@@ -3358,8 +3705,7 @@ beach:
     else
       stream->expected_size -= stream->current_size;
   }
-  stream->data = NULL;
-  stream->allocated_size = 0;
+  gst_ts_demux_stream_free_data (stream);
   stream->current_size = 0;
 
   return res;
@@ -77,6 +77,11 @@ struct _GstTSDemux
   guint program_number;
   gboolean emit_statistics;
   gint latency; /* latency in ms */
+  gboolean pes_arena;
+
+  /* PES payload bytes pushed, and bytes copied to collect them */
+  guint64 pes_bytes;
+  guint64 pes_bytes_copied;
 
   /*< private >*/
   gint program_generation; /* Incremented each time we switch program 0..15 */
@@ -191,6 +191,10 @@ enum
 
 #define BASETSMUX_DEFAULT_ALIGNMENT    -1
 
+/* Number of packets in an allocation block (~64kB for 188 bytes packets),
+ * rounded down to a multiple of the alignment */
+#define BASETSMUX_BLOCK_PACKETS 348
+
 #define CLOCK_BASE 9LL
 #define CLOCK_FREQ (CLOCK_BASE * 10000) /* 90 kHz PTS clock */
 #define CLOCK_FREQ_SCR (CLOCK_FREQ * 300)       /* 27 MHz SCR clock */
@@ -220,6 +224,16 @@ typedef struct
   GstBuffer *buffer;
 } StreamData;
 
+/* Refcounted chunk of memory TS packets are written into. Output buffers
+ * wrap slices of it, so that aligned groups of packets can be pushed
+ * without being copied together */
+struct GstBaseTsMuxBlock
+{
+  gint refcount;
+  gsize size;
+  guint8 *data;
+};
+
 G_DEFINE_TYPE_WITH_CODE (GstBaseTsMux, gst_base_ts_mux, GST_TYPE_AGGREGATOR,
     gst_mpegts_initialize ());
 
@@ -246,6 +260,54 @@ stream_data_free (StreamData * data)
   }
 }
 
+static GstBaseTsMuxBlock *
+gst_base_ts_mux_block_new (gsize size)
+{
+  GstBaseTsMuxBlock *block;
+
+  block = g_malloc (sizeof (GstBaseTsMuxBlock) + size);
+  block->refcount = 1;
+  block->size = size;
+  block->data = (guint8 *) (block + 1);
+
+  return block;
+}
+
+static GstBaseTsMuxBlock *
+gst_base_ts_mux_block_ref (GstBaseTsMuxBlock * block)
+{
+  g_atomic_int_inc (&block->refcount);
+
+  return block;
+}
+
+static void
+gst_base_ts_mux_block_unref (gpointer data)
+{
+  GstBaseTsMuxBlock *block = data;
+
+  if (g_atomic_int_dec_and_test (&block->refcount))
+    g_free (block);
+}
+
+static gboolean
+gst_base_ts_mux_block_contains (GstBaseTsMuxBlock * block, guint8 * data,
+    gsize size)
+{
+  return block && data >= block->data
+      && data + size <= block->data + block->size;
+}
+
+/* Wraps @size bytes of @block at @offset, taking the caller's ref on the
+ * block. The memory can't be resized into the neighbouring packets */
+static GstMemory *
+gst_base_ts_mux_block_wrap (GstBaseTsMuxBlock * block, gsize offset,
+    gsize size, GstMemoryFlags flags)
+{
+  return gst_memory_new_wrapped (flags, block->data + offset, size, 0, size,
+      block, gst_base_ts_mux_block_unref);
+}
+
 #define parent_class gst_base_ts_mux_parent_class
 
 static void
@@ -315,6 +377,18 @@ gst_base_ts_mux_reset (GstBaseTsMux * mux, gboolean alloc)
     gst_adapter_clear (mux->out_adapter);
   mux->output_ts_offset = GST_CLOCK_TIME_NONE;
 
+  if (mux->out_span_block) {
+    gst_base_ts_mux_block_unref (mux->out_span_block);
+    mux->out_span_block = NULL;
+  }
+  mux->out_span_size = 0;
+  gst_buffer_replace (&mux->spare_packet, NULL);
+  if (mux->out_block) {
+    gst_base_ts_mux_block_unref (mux->out_block);
+    mux->out_block = NULL;
+  }
+  mux->out_block_offset = 0;
+
   if (mux->tsmux) {
     if (mux->tsmux->si_sections)
       si_sections = g_hash_table_ref (mux->tsmux->si_sections);
@@ -871,7 +945,8 @@ new_packet_common_init (GstBaseTsMux * mux, GstBuffer * buf, guint8 * data,
         hbuf = gst_buffer_new_and_alloc (len);
         gst_buffer_fill (hbuf, 0, data, len);
       } else {
-        hbuf = gst_buffer_copy (buf);
+        /* Don't keep the whole allocation block alive from the caps */
+        hbuf = gst_buffer_copy_deep (buf);
       }
       GST_LOG_OBJECT (mux,
           "Collecting packet with pid 0x%04x into streamheaders", pid);
@@ -898,17 +973,59 @@ new_packet_common_init (GstBaseTsMux * mux, GstBuffer * buf, guint8 * data,
   }
 }
 
+static gint
+gst_base_ts_mux_get_alignment (GstBaseTsMux * mux)
+{
+  if (mux->alignment < 0)
+    return mux->automatic_alignment;
+
+  return mux->alignment;
+}
+
+/* Push the pending run of contiguous packets to the output adapter as a
+ * single buffer wrapping the block memory */
+static void
+gst_base_ts_mux_flush_span (GstBaseTsMux * mux)
+{
+  GstBuffer *buf;
+
+  if (!mux->out_span_block)
+    return;
+
+  if (mux->out_span_size == 0) {
+    gst_base_ts_mux_block_unref (mux->out_span_block);
+    mux->out_span_block = NULL;
+    return;
+  }
+
+  /* takes the span's ref on the block. The packets are final, writing to
+   * them downstream has to go through a copy */
+  buf = gst_buffer_new ();
+  gst_buffer_append_memory (buf,
+      gst_base_ts_mux_block_wrap (mux->out_span_block, mux->out_span_offset,
+          mux->out_span_size, GST_MEMORY_FLAG_READONLY));
+  GST_BUFFER_PTS (buf) = mux->out_span_pts;
+  GST_BUFFER_FLAG_SET (buf, mux->out_span_flags);
+
+  GST_LOG_OBJECT (mux, "collecting %" G_GSIZE_FORMAT " bytes of packets",
+      mux->out_span_size);
+  gst_adapter_push (mux->out_adapter, buf);
+
+  mux->out_span_block = NULL;
+  mux->out_span_size = 0;
+}
+
 static GstFlowReturn
 gst_base_ts_mux_push_packets (GstBaseTsMux * mux, gboolean force)
 {
   GstBufferList *buffer_list;
-  gint align = mux->alignment;
+  gint align = gst_base_ts_mux_get_alignment (mux);
   gint av, packet_size;
 
   packet_size = mux->packet_size;
 
-  if (align < 0)
-    align = mux->automatic_alignment;
+  if (force || align == 0)
+    gst_base_ts_mux_flush_span (mux);
 
   av = gst_adapter_available (mux->out_adapter);
   GST_LOG_OBJECT (mux, "align %d, av %d", align, av);
@@ -999,11 +1116,75 @@ gst_base_ts_mux_push_packets (GstBaseTsMux * mux, gboolean force)
   return gst_aggregator_finish_buffer_list (GST_AGGREGATOR (mux), buffer_list);
 }
 
+/* When aligning, packets allocated from the blocks are not pushed to the
+ * output adapter one by one. Runs of contiguous packets are accumulated
+ * instead and output as a single buffer per alignment group, which
+ * avoids merging them by copy when taking them out of the adapter */
+static gboolean
+gst_base_ts_mux_collect_block_packet (GstBaseTsMux * mux, GstBuffer * buf,
+    gint align)
+{
+  GstMapInfo map;
+  gboolean ret = TRUE, recycle;
+
+  if (gst_buffer_n_memory (buf) != 1)
+    return FALSE;
+
+  if (!gst_buffer_map (buf, &map, GST_MAP_READ))
+    return FALSE;
+
+  if (mux->out_span_block && map.data == mux->out_span_block->data +
+      mux->out_span_offset + mux->out_span_size &&
+      gst_base_ts_mux_block_contains (mux->out_span_block, map.data,
+          map.size)) {
+    mux->out_span_size += map.size;
+  } else if (gst_base_ts_mux_block_contains (mux->out_block, map.data,
+          map.size)) {
+    gst_base_ts_mux_flush_span (mux);
+
+    mux->out_span_block = gst_base_ts_mux_block_ref (mux->out_block);
+    mux->out_span_offset = map.data - mux->out_block->data;
+    mux->out_span_size = map.size;
+    mux->out_span_pts = GST_BUFFER_PTS (buf);
+    mux->out_span_flags = GST_BUFFER_FLAGS (buf) &
+        (GST_BUFFER_FLAG_HEADER | GST_BUFFER_FLAG_DELTA_UNIT);
+  } else {
+    ret = FALSE;
+  }
+
+  recycle = gst_base_ts_mux_block_contains (mux->out_block, map.data,
+      map.size);
+
+  gst_buffer_unmap (buf, &map);
+
+  if (!ret)
+    return FALSE;
+
+  if (mux->out_span_size >= align * mux->packet_size)
+    gst_base_ts_mux_flush_span (mux);
+
+  /* The data is now referenced by the span, the buffer itself can be
+   * reused for the next packet */
+  if (recycle && !mux->spare_packet && gst_buffer_is_writable (buf))
+    mux->spare_packet = buf;
+  else
+    gst_buffer_unref (buf);
+
+  return TRUE;
+}
+
 static GstFlowReturn
 gst_base_ts_mux_collect_packet (GstBaseTsMux * mux, GstBuffer * buf)
 {
+  gint align = gst_base_ts_mux_get_alignment (mux);
+
   GST_LOG_OBJECT (mux, "collecting packet size %" G_GSIZE_FORMAT,
       gst_buffer_get_size (buf));
+
+  if (align > 0 && gst_base_ts_mux_collect_block_packet (mux, buf, align))
+    return GST_FLOW_OK;
+
+  gst_base_ts_mux_flush_span (mux);
   gst_adapter_push (mux->out_adapter, buf);
 
   return GST_FLOW_OK;
@@ -1974,6 +2155,7 @@ gst_base_ts_mux_default_create_ts_mux (GstBaseTsMux * mux)
   TsMux *tsmux = tsmux_new ();
   tsmux_set_write_func (tsmux, new_packet_cb, mux);
   tsmux_set_alloc_func (tsmux, alloc_packet_cb, mux);
+  tsmux_set_log_object (tsmux, GST_OBJECT (mux));
   tsmux_set_pat_interval (tsmux, mux->pat_interval);
   tsmux_set_si_interval (tsmux, mux->si_interval);
   tsmux_set_bitrate (tsmux, mux->bitrate);
@@ -1982,13 +2164,53 @@ gst_base_ts_mux_default_create_ts_mux (GstBaseTsMux * mux)
   return tsmux;
 }
 
+/* Packets are written into large blocks instead of being allocated one
+ * by one. When aligning, the buffer of an already collected packet is
+ * recycled by pointing it at the next free slot of the block */
 static void
 gst_base_ts_mux_default_allocate_packet (GstBaseTsMux * mux,
     GstBuffer ** buffer)
 {
   GstBuffer *buf;
+  GstMemory *mem;
+  gsize packet_size = mux->packet_size;
+
+  if (!mux->out_block
+      || mux->out_block_offset + packet_size > mux->out_block->size) {
+    gint align = gst_base_ts_mux_get_alignment (mux);
+    gsize n_packets = BASETSMUX_BLOCK_PACKETS;
+
+    if (align > 0)
+      n_packets = MAX (1, n_packets / align) * align;
+
+    if (mux->out_block)
+      gst_base_ts_mux_block_unref (mux->out_block);
+    mux->out_block = gst_base_ts_mux_block_new (n_packets * packet_size);
+    mux->out_block_offset = 0;
+  }
+
+  mem = gst_base_ts_mux_block_wrap (gst_base_ts_mux_block_ref (mux->out_block),
+      mux->out_block_offset, packet_size, 0);
+
+  if (mux->spare_packet) {
+    buf = mux->spare_packet;
+    mux->spare_packet = NULL;
+
+    gst_buffer_replace_all_memory (buf, mem);
+
+    GST_BUFFER_PTS (buf) = GST_CLOCK_TIME_NONE;
+    GST_BUFFER_DTS (buf) = GST_CLOCK_TIME_NONE;
+    GST_BUFFER_DURATION (buf) = GST_CLOCK_TIME_NONE;
+    GST_BUFFER_OFFSET (buf) = GST_BUFFER_OFFSET_NONE;
+    GST_BUFFER_OFFSET_END (buf) = GST_BUFFER_OFFSET_NONE;
+    GST_BUFFER_FLAG_UNSET (buf, GST_BUFFER_FLAG_HEADER |
+        GST_BUFFER_FLAG_DELTA_UNIT | GST_BUFFER_FLAG_DISCONT);
+  } else {
+    buf = gst_buffer_new ();
+    gst_buffer_append_memory (buf, mem);
+  }
 
-  buf = gst_buffer_new_and_alloc (mux->packet_size);
+  mux->out_block_offset += packet_size;
 
   *buffer = buf;
 }
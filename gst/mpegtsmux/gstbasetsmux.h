@@ -95,6 +95,7 @@ typedef struct _GstBaseTsMuxPadPrivate GstBaseTsMuxPadPrivate;
 typedef struct GstBaseTsMux GstBaseTsMux;
 typedef struct GstBaseTsMuxClass GstBaseTsMuxClass;
 typedef struct GstBaseTsPadData GstBaseTsPadData;
+typedef struct GstBaseTsMuxBlock GstBaseTsMuxBlock;
 
 typedef GstBuffer * (*GstBaseTsMuxPadPrepareFunction) (GstBuffer * buf,
     GstBaseTsMuxPad * data, GstBaseTsMux * mux);
@@ -182,6 +183,20 @@ struct GstBaseTsMux {
   GstAdapter *out_adapter;
   GstBuffer *out_buffer;
   GstClockTimeDiff output_ts_offset;
+
+  /* memory block packets are allocated from, and the offset of the next
+   * packet in it */
+  GstBaseTsMuxBlock *out_block;
+  gsize out_block_offset;
+  /* packet buffer that can be pointed at the next packet of out_block */
+  GstBuffer *spare_packet;
+
+  /* contiguous packets of a block not yet pushed to out_adapter */
+  GstBaseTsMuxBlock *out_span_block;
+  gsize out_span_offset;
+  gsize out_span_size;
+  GstClockTime out_span_pts;
+  GstBufferFlags out_span_flags;
 };
 
 /**
@@ -89,6 +89,11 @@
  * at which PCR should be calculated */
 #define PCR_BYTE_OFFSET 11
 
+/* T-STD transport buffer size, and its leak rate for audio streams in
+ * bits per second (ISO/IEC 13818-1, 2.4.2.3) */
+#define TSMUX_TSTD_TB_SIZE 512
+#define TSMUX_TSTD_AUDIO_RX 2000000
+
 /* HACK: We use a fixed buffering offset for the PCR at the moment -
  * this is the amount 'in advance' of the stream that the PCR sits.
  * 1/8 second atm */
@@ -215,6 +220,22 @@ tsmux_set_new_stream_func (TsMux * mux, TsMuxNewStreamFunc func,
   mux->new_stream_data = user_data;
 }
 
+/**
+ * tsmux_set_log_object:
+ * @mux: a #TsMux
+ * @object: (transfer none): a #GstObject
+ *
+ * Set the object warnings about the multiplex are logged against. @object
+ * is not referenced and has to outlive @mux.
+ */
+void
+tsmux_set_log_object (TsMux * mux, GstObject * object)
+{
+  g_return_if_fail (mux != NULL);
+
+  mux->log_object = object;
+}
+
 /**
  * tsmux_set_pat_interval:
  * @mux: a #TsMux
@@ -1308,6 +1329,16 @@ ts_to_pcr (gint64 ts)
   return (ts - TSMUX_PCR_OFFSET) * (TSMUX_SYS_CLOCK_FREQ / TSMUX_CLOCK_FREQ);
 }
 
+/* System clock time at which the first byte of the next packet is output,
+ * in CBR mode once the PCR reference is known */
+static gint64
+get_packet_time (TsMux * mux)
+{
+  return ts_to_pcr (mux->first_pcr_ts) +
+      gst_util_uint64_scale (mux->n_bytes * 8, TSMUX_SYS_CLOCK_FREQ,
+      mux->bitrate);
+}
+
 /* Calculate the PCR to write into the current packet */
 static gint64
 get_current_pcr (TsMux * mux, gint64 cur_ts)
@@ -1354,7 +1385,8 @@ write_new_pcr (TsMux * mux, TsMuxStream * stream, gint64 cur_pcr,
     stream->pi.pcr = cur_pcr;
 
     if (mux->bitrate && stream->next_pcr != -1 && cur_pcr >= stream->next_pcr) {
-      GST_WARNING ("Writing PCR %" G_GUINT64_FORMAT " missed the target %"
+      GST_WARNING_OBJECT (mux->log_object, "Writing PCR %" G_GUINT64_FORMAT
+          " missed the target %"
           G_GUINT64_FORMAT " by %f ms", cur_pcr, stream->next_pcr,
           (double) (cur_pcr - stream->next_pcr) / 27000.0);
     }
@@ -1472,12 +1504,134 @@ rewrite_si (TsMux * mux, gint64 cur_ts)
   return TRUE;
 }
 
+/* In CBR mode, the system clock is derived from the output byte position.
+ * Check that a new PES packet starts being output before its decoding
+ * time, otherwise the decoder buffer will underflow */
+static void
+check_pes_deadline (TsMux * mux, TsMuxStream * stream)
+{
+  gint64 dts, start;
+
+  if (!mux->bitrate || mux->first_pcr_ts == G_MININT64)
+    return;
+
+  dts = stream->dts != G_MININT64 ? stream->dts : stream->pts;
+  if (dts == G_MININT64)
+    return;
+
+  dts *= TSMUX_SYS_CLOCK_FREQ / TSMUX_CLOCK_FREQ;
+  start = get_packet_time (mux);
+  if (start > dts) {
+    GST_WARNING_OBJECT (mux->log_object, "PES on PID 0x%04x starts %f ms "
+        "after its decoding time, the configured bitrate is too low",
+        stream->pi.pid, (double) (start - dts) / 27000.0);
+  }
+}
+
+/* Leak rate of the T-STD transport buffer of @stream in bits per second,
+ * or 0 if it isn't known */
+static guint64
+tstd_leak_rate (TsMuxStream * stream)
+{
+  if (stream->is_audio)
+    return TSMUX_TSTD_AUDIO_RX;
+
+  /* 1.2 * Rmax */
+  if (stream->is_video_stream && stream->max_bitrate)
+    return (guint64) stream->max_bitrate * 6 / 5;
+
+  return 0;
+}
+
 static gboolean
-pad_stream (TsMux * mux, TsMuxStream * stream, gint64 cur_ts)
+tstd_is_modelled (TsMux * mux, TsMuxStream * stream)
+{
+  return mux->bitrate && mux->first_pcr_ts != G_MININT64
+      && tstd_leak_rate (stream) != 0;
+}
+
+/* Drain the transport buffer of @stream up to the next packet */
+static void
+tstd_update (TsMux * mux, TsMuxStream * stream)
+{
+  gint64 now = get_packet_time (mux);
+
+  if (stream->tb_time != G_MININT64 && now > stream->tb_time) {
+    stream->tb_fullness -= gst_util_uint64_scale (now - stream->tb_time,
+        tstd_leak_rate (stream), TSMUX_SYS_CLOCK_FREQ);
+    if (stream->tb_fullness < 0)
+      stream->tb_fullness = 0;
+  }
+  stream->tb_time = now;
+}
+
+/* Write a stuffing packet: a PCR-only packet if @pcr_stream needs a PCR,
+ * a null packet otherwise */
+static gboolean
+write_padding_packet (TsMux * mux, TsMuxStream * pcr_stream, gint64 cur_ts)
 {
-  guint64 bitrate;
   GstBuffer *buf = NULL;
   GstMapInfo map;
+  gint64 new_pcr = -1;
+  guint payload_len, payload_offs;
+
+  if (!tsmux_get_buffer (mux, &buf))
+    return FALSE;
+
+  gst_buffer_map (buf, &map, GST_MAP_READ);
+
+  if (pcr_stream)
+    new_pcr = write_new_pcr (mux, pcr_stream, get_current_pcr (mux, cur_ts),
+        get_next_pcr (mux, cur_ts));
+
+  if (new_pcr != -1) {
+    GST_LOG ("Writing PCR-only packet on PID 0x%04x", pcr_stream->pi.pid);
+    tsmux_write_ts_header (mux, map.data, &pcr_stream->pi, &payload_len,
+        &payload_offs, 0);
+  } else {
+    GST_LOG ("Writing null stuffing packet");
+    if (!rewrite_si (mux, cur_ts)) {
+      gst_buffer_unmap (buf, &map);
+      gst_buffer_unref (buf);
+      return FALSE;
+    }
+    tsmux_write_null_ts_header (map.data);
+  }
+
+  gst_buffer_unmap (buf, &map);
+
+  if (pcr_stream)
+    pcr_stream->pi.flags &= TSMUX_PACKET_FLAG_PES_FULL_HEADER;
+
+  return tsmux_packet_out (mux, buf, new_pcr);
+}
+
+/* Hold back the next packet of @stream until its transport buffer has
+ * room for it, stuffing the multiplex meanwhile */
+static gboolean
+tstd_wait_transport_buffer (TsMux * mux, TsMuxStream * stream, gint64 cur_ts)
+{
+  tstd_update (mux, stream);
+
+  while (stream->tb_fullness + TSMUX_PACKET_LENGTH * 8 >
+      TSMUX_TSTD_TB_SIZE * 8) {
+    GST_LOG ("Transport buffer of PID 0x%04x full, delaying packet",
+        stream->pi.pid);
+
+    if (!write_padding_packet (mux, tsmux_stream_is_pcr (stream) ? stream :
+            NULL, cur_ts))
+      return FALSE;
+
+    tstd_update (mux, stream);
+  }
+
+  return TRUE;
+}
+
+static gboolean
+pad_stream (TsMux * mux, TsMuxStream * stream, gint64 cur_ts)
+{
+  guint64 bitrate;
   gboolean ret = TRUE;
   GstClockTimeDiff diff;
   guint64 start_n_bytes;
@@ -1491,8 +1645,13 @@ pad_stream (TsMux * mux, TsMuxStream * stream, gint64 cur_ts)
   if (!GST_CLOCK_STIME_IS_VALID (stream->first_ts))
     stream->first_ts = cur_ts;
 
-  diff = GST_CLOCK_DIFF (stream->first_ts, cur_ts);
-  if (diff == 0)
+  /* The byte count and the PCRs are shared by all programs, so pad
+   * against the same reference the PCRs are computed from */
+  if (mux->first_pcr_ts != G_MININT64)
+    diff = GST_CLOCK_DIFF (mux->first_pcr_ts, cur_ts);
+  else
+    diff = GST_CLOCK_DIFF (stream->first_ts, cur_ts);
+  if (diff <= 0)
     goto done;
 
   start_n_bytes = mux->n_bytes;
@@ -1508,36 +1667,7 @@ pad_stream (TsMux * mux, TsMuxStream * stream, gint64 cur_ts)
         TSMUX_CLOCK_FREQ, diff);
 
     if (bitrate <= mux->bitrate) {
-      gint64 new_pcr;
-      guint payload_len, payload_offs;
-
-      if (!tsmux_get_buffer (mux, &buf)) {
-        ret = FALSE;
-        goto done;
-      }
-
-      gst_buffer_map (buf, &map, GST_MAP_READ);
-
-      if ((new_pcr =
-              write_new_pcr (mux, stream, get_current_pcr (mux,
-                      cur_ts), get_next_pcr (mux, cur_ts)) != -1)) {
-        GST_LOG ("Writing PCR-only packet on PID 0x%04x", stream->pi.pid);
-        tsmux_write_ts_header (mux, map.data, &stream->pi, &payload_len,
-            &payload_offs, 0);
-      } else {
-        GST_LOG ("Writing null stuffing packet");
-        if (!rewrite_si (mux, cur_ts)) {
-          ret = FALSE;
-          goto done;
-        }
-        tsmux_write_null_ts_header (map.data);
-      }
-
-      gst_buffer_unmap (buf, &map);
-
-      stream->pi.flags &= TSMUX_PACKET_FLAG_PES_FULL_HEADER;
-
-      if (!(ret = tsmux_packet_out (mux, buf, new_pcr)))
+      if (!(ret = write_padding_packet (mux, stream, cur_ts)))
         goto done;
     }
   } while (bitrate < mux->bitrate);
@@ -1569,16 +1699,24 @@ tsmux_write_stream_packet (TsMux * mux, TsMuxStream * stream)
   GstBuffer *buf = NULL;
   GstMapInfo map;
 
+  gint64 cur_ts = G_MININT64;
+
   g_return_val_if_fail (mux != NULL, FALSE);
   g_return_val_if_fail (stream != NULL, FALSE);
 
   if (tsmux_stream_is_pcr (stream)) {
-    gint64 cur_ts = CLOCK_BASE;
+    cur_ts = CLOCK_BASE;
     if (tsmux_stream_get_dts (stream) != G_MININT64)
       cur_ts += tsmux_stream_get_dts (stream);
     else
       cur_ts += tsmux_stream_get_pts (stream);
+  }
 
+  if (tstd_is_modelled (mux, stream)
+      && !tstd_wait_transport_buffer (mux, stream, cur_ts))
+    return FALSE;
+
+  if (tsmux_stream_is_pcr (stream)) {
     if (!rewrite_si (mux, cur_ts))
       goto fail;
 
@@ -1597,6 +1735,8 @@ tsmux_write_stream_packet (TsMux * mux, TsMuxStream * stream)
       stream->dts += CLOCK_BASE;
     if (stream->pts != G_MININT64)
       stream->pts += CLOCK_BASE;
+
+    check_pes_deadline (mux, stream);
   }
   pi->stream_avail = tsmux_stream_bytes_avail (stream);
 
@@ -1616,6 +1756,11 @@ tsmux_write_stream_packet (TsMux * mux, TsMuxStream * stream)
 
   gst_buffer_unmap (buf, &map);
 
+  if (tstd_is_modelled (mux, stream)) {
+    tstd_update (mux, stream);
+    stream->tb_fullness += TSMUX_PACKET_LENGTH * 8;
+  }
+
   GST_DEBUG ("Writing PES of size %d", (int) gst_buffer_get_size (buf));
   res = tsmux_packet_out (mux, buf, new_pcr);
 
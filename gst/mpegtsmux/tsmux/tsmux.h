@@ -179,6 +179,9 @@ struct TsMux {
   TsMuxNewStreamFunc new_stream_func;
   void *new_stream_data;
 
+  /* object warnings are logged against */
+  GstObject *log_object;
+
   /* scratch space for writing ES_info descriptors */
   guint8 es_info_buf[TSMUX_MAX_ES_INFO_LENGTH];
 
@@ -199,6 +202,7 @@ void 		tsmux_free 			(TsMux *mux);
 void 		tsmux_set_write_func 		(TsMux *mux, TsMuxWriteFunc func, void *user_data);
 void 		tsmux_set_alloc_func 		(TsMux *mux, TsMuxAllocFunc func, void *user_data);
 void    tsmux_set_new_stream_func (TsMux * mux, TsMuxNewStreamFunc func, void *user_data);
+void    tsmux_set_log_object    (TsMux *mux, GstObject *object);
 void 		tsmux_set_pat_interval          (TsMux *mux, guint interval);
 guint 		tsmux_get_pat_interval          (TsMux *mux);
 void 		tsmux_resend_pat                (TsMux *mux);
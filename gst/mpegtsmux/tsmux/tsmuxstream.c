@@ -217,6 +217,9 @@ tsmux_stream_new (guint16 pid, guint stream_type)
   stream->pcr_ref = 0;
   stream->next_pcr = -1;
 
+  stream->tb_fullness = 0;
+  stream->tb_time = G_MININT64;
+
   stream->get_es_descrs =
       (TsMuxStreamGetESDescriptorsFunc) tsmux_stream_default_get_es_descrs;
   stream->get_es_descrs_data = NULL;
@@ -195,6 +195,11 @@ struct TsMuxStream {
   /* Next time PCR should be written */
   gint64 next_pcr;
 
+  /* T-STD transport buffer fullness in bits, and the system clock time
+   * at which it was last updated, 27 MHz. Only tracked in CBR mode */
+  gint64 tb_fullness;
+  gint64 tb_time;
+
   /* audio parameters for stream
    * (used in stream descriptor) */
   gint audio_sampling;
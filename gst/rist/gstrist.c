@@ -22,6 +22,8 @@
 #include "config.h"
 #endif
 
+#include <string.h>
+
 #include "gstrist.h"
 #include "gstroundrobin.h"
 
@@ -91,3 +93,116 @@ gst_rist_rtp_ext_seq (guint32 * extseqnum, guint16 seqnum)
 
   return result;
 }
+
+/*
+ * gst_rist_fec_xor:
+ * @dst: the destination
+ * @src: the source
+ * @len: the number of bytes
+ *
+ * XOR the @len bytes of @src into @dst. This works on 64 bits words, four
+ * at a time, a loop the compiler vectorizes. The buffers don't have to be
+ * aligned.
+ */
+void
+gst_rist_fec_xor (guint8 * dst, const guint8 * src, gsize len)
+{
+  while (len >= 32) {
+    guint64 d[4], s[4];
+
+    memcpy (d, dst, 32);
+    memcpy (s, src, 32);
+    d[0] ^= s[0];
+    d[1] ^= s[1];
+    d[2] ^= s[2];
+    d[3] ^= s[3];
+    memcpy (dst, d, 32);
+
+    dst += 32;
+    src += 32;
+    len -= 32;
+  }
+
+  while (len >= 8) {
+    guint64 d, s;
+
+    memcpy (&d, dst, 8);
+    memcpy (&s, src, 8);
+    d ^= s;
+    memcpy (dst, &d, 8);
+
+    dst += 8;
+    src += 8;
+    len -= 8;
+  }
+
+  while (len--)
+    *dst++ ^= *src++;
+}
+
+/*
+ * gst_rist_fec_block_reset:
+ * @block: a #RistFecBlock
+ * @base: the sequence number of the first protected packet
+ *
+ * Start a new block, keeping the memory of the previous one.
+ */
+void
+gst_rist_fec_block_reset (RistFecBlock * block, guint16 base)
+{
+  block->base = base;
+  block->count = 0;
+  block->bits = 0;
+  block->marker_pt = 0;
+  block->timestamp = 0;
+  block->length = 0;
+  block->size = 0;
+}
+
+/*
+ * gst_rist_fec_block_add:
+ * @block: a #RistFecBlock
+ * @packet: an RTP packet
+ * @size: the size of @packet, at least the size of the RTP header
+ *
+ * Add @packet to the XOR of @block. Everything after the fixed RTP header is
+ * protected, including the CSRC and header extension, and shorter packets
+ * are padded with zeroes, as in SMPTE 2022-1 and RFC 2733.
+ */
+void
+gst_rist_fec_block_add (RistFecBlock * block, const guint8 * packet,
+    gsize size)
+{
+  gsize len = size - RIST_FEC_RTP_HEADER_LEN;
+
+  block->bits ^= packet[0] & 0x3f;
+  block->marker_pt ^= packet[1];
+  block->timestamp ^= GST_READ_UINT32_BE (packet + 4);
+  block->length ^= len;
+
+  if (len > block->size) {
+    if (len > block->allocated) {
+      block->data = g_realloc (block->data, len);
+      block->allocated = len;
+    }
+    memset (block->data + block->size, 0, len - block->size);
+    block->size = len;
+  }
+
+  gst_rist_fec_xor (block->data, packet + RIST_FEC_RTP_HEADER_LEN, len);
+  block->count++;
+}
+
+/*
+ * gst_rist_fec_block_clear:
+ * @block: a #RistFecBlock
+ *
+ * Free the memory of @block.
+ */
+void
+gst_rist_fec_block_clear (RistFecBlock * block)
+{
+  g_clear_pointer (&block->data, g_free);
+  block->size = 0;
+  block->allocated = 0;
+}
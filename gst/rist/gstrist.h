@@ -77,8 +77,61 @@ typedef struct {
 GType gst_rist_rtp_deext_get_type (void);
 GST_ELEMENT_REGISTER_DECLARE (ristrtpdeext);
 
+#define GST_TYPE_RIST_FEC_ENC      (gst_rist_fec_enc_get_type())
+#define GST_RIST_FEC_ENC(obj)      (G_TYPE_CHECK_INSTANCE_CAST((obj),GST_TYPE_RIST_FEC_ENC,GstRistFecEnc))
+typedef struct _GstRistFecEnc GstRistFecEnc;
+typedef struct {
+  GstElementClass parent;
+} GstRistFecEncClass;
+GType gst_rist_fec_enc_get_type (void);
+GST_ELEMENT_REGISTER_DECLARE (ristfecenc);
+
+#define GST_TYPE_RIST_FEC_DEC      (gst_rist_fec_dec_get_type())
+#define GST_RIST_FEC_DEC(obj)      (G_TYPE_CHECK_INSTANCE_CAST((obj),GST_TYPE_RIST_FEC_DEC,GstRistFecDec))
+typedef struct _GstRistFecDec GstRistFecDec;
+typedef struct {
+  GstElementClass parent;
+} GstRistFecDecClass;
+GType gst_rist_fec_dec_get_type (void);
+GST_ELEMENT_REGISTER_DECLARE (ristfecdec);
+
 guint32 gst_rist_rtp_ext_seq (guint32 * extseqnum, guint16 seqnum);
 
+/* SMPTE 2022-1 FEC */
+#define RIST_FEC_RTP_HEADER_LEN 12
+#define RIST_FEC_HEADER_LEN 16
+#define RIST_FEC_PT 96
+#define RIST_FEC_MAX_COLUMNS 20
+#define RIST_FEC_MIN_ROWS 4
+#define RIST_FEC_MAX_ROWS 20
+
+/* The FEC stream of the columns is sent on the RTP port + 2, the one of the
+ * rows on the RTP port + 4 */
+#define RIST_FEC_COLUMN_PORT_OFFSET 2
+#define RIST_FEC_ROW_PORT_OFFSET 4
+
+/* XOR of the recoverable fields of a set of RTP packets */
+typedef struct
+{
+  guint16 base;
+  guint count;
+
+  guint8 bits;                  /* P, X and CC */
+  guint8 marker_pt;             /* M and PT */
+  guint32 timestamp;
+  guint16 length;
+
+  guint8 *data;
+  gsize size;
+  gsize allocated;
+} RistFecBlock;
+
+void gst_rist_fec_xor (guint8 * dst, const guint8 * src, gsize len);
+void gst_rist_fec_block_reset (RistFecBlock * block, guint16 base);
+void gst_rist_fec_block_add (RistFecBlock * block, const guint8 * packet,
+    gsize size);
+void gst_rist_fec_block_clear (RistFecBlock * block);
+
 void gst_rist_rtx_send_set_extseqnum (GstRistRtxSend *self, guint32 ssrc,
     guint16 seqnum_ext);
 void gst_rist_rtx_send_clear_extseqnum (GstRistRtxSend *self, guint32 ssrc);
@@ -0,0 +1,604 @@
+/* GStreamer RIST plugin
+ * Copyright (C) 2026 agent <agent@local>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/**
+ * SECTION:element-ristfecdec
+ * @title: ristfecdec
+ * @see_also: ristfecenc, ristsrc
+ *
+ * This element recovers lost RTP packets using the SMPTE 2022-1 forward
+ * error correction streams produced by ristfecenc. The RTP stream goes
+ * through the element without delay, and a lost packet is pushed as soon
+ * as it can be rebuilt from a FEC packet and the other packets it protects,
+ * out of order. A jitterbuffer downstream puts it back in place.
+ *
+ * The FEC streams are received on request pads, any number of them, as
+ * the row and column packets are told apart by their header. The same
+ * FEC packet received more than once, for example over several links, is
+ * only used once. A media packet that arrives after it was recovered, for
+ * example when it was reordered behind its FEC packet, is dropped so that
+ * every sequence number is only pushed once.
+ *
+ * Since: 1.20
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <string.h>
+
+#include <gst/rtp/rtp.h>
+
+#include "gstrist.h"
+
+GST_DEBUG_CATEGORY_STATIC (gst_rist_fec_dec_debug);
+#define GST_CAT_DEFAULT gst_rist_fec_dec_debug
+
+/* Number of media packets kept for recovery, this must cover two of the
+ * largest matrices */
+#define STORE_SIZE 1024
+
+enum
+{
+  PROP_RECOVERED = 1
+};
+
+static GstStaticPadTemplate src_templ = GST_STATIC_PAD_TEMPLATE ("src",
+    GST_PAD_SRC,
+    GST_PAD_ALWAYS,
+    GST_STATIC_CAPS ("application/x-rtp"));
+
+static GstStaticPadTemplate sink_templ = GST_STATIC_PAD_TEMPLATE ("sink",
+    GST_PAD_SINK,
+    GST_PAD_ALWAYS,
+    GST_STATIC_CAPS ("application/x-rtp"));
+
+static GstStaticPadTemplate fec_templ = GST_STATIC_PAD_TEMPLATE ("fec_%u",
+    GST_PAD_SINK,
+    GST_PAD_REQUEST,
+    GST_STATIC_CAPS_ANY);
+
+typedef struct
+{
+  RistFecBlock block;
+  guint8 offset;
+  guint8 na;
+  gboolean row;
+} RistFecPacket;
+
+struct _GstRistFecDec
+{
+  GstElement parent;
+
+  GstPad *srcpad, *sinkpad;
+
+  /* Protected by the object lock */
+  guint n_fec_pads;
+  guint fec_pad_counter;
+
+  /* All the recovery state is protected by the object lock, as the media
+   * and FEC packets come from different threads */
+  GstBuffer *store[STORE_SIZE];
+  guint16 store_seq[STORE_SIZE];
+  /* Whether the stored packet was rebuilt from a FEC packet */
+  gboolean store_recovered[STORE_SIZE];
+  guint16 last_seq;
+  gboolean have_seq;
+  guint32 ssrc;
+
+  /* Not yet usable FEC packets */
+  GQueue pending;
+
+  guint64 recovered;
+};
+
+G_DEFINE_TYPE_WITH_CODE (GstRistFecDec, gst_rist_fec_dec, GST_TYPE_ELEMENT,
+    GST_DEBUG_CATEGORY_INIT (gst_rist_fec_dec_debug, "ristfecdec", 0,
+        "RIST FEC Decoder"));
+GST_ELEMENT_REGISTER_DEFINE (ristfecdec, "ristfecdec", GST_RANK_NONE,
+    GST_TYPE_RIST_FEC_DEC);
+
+static void
+rist_fec_packet_free (RistFecPacket * fec)
+{
+  gst_rist_fec_block_clear (&fec->block);
+  g_slice_free (RistFecPacket, fec);
+}
+
+/* called with the object lock */
+static void
+gst_rist_fec_dec_reset (GstRistFecDec * self)
+{
+  guint i;
+
+  for (i = 0; i < STORE_SIZE; i++)
+    gst_clear_buffer (&self->store[i]);
+  self->have_seq = FALSE;
+
+  g_queue_foreach (&self->pending, (GFunc) rist_fec_packet_free, NULL);
+  g_queue_clear (&self->pending);
+}
+
+/* called with the object lock */
+static GstBuffer *
+gst_rist_fec_dec_lookup (GstRistFecDec * self, guint16 seq)
+{
+  guint slot = seq % STORE_SIZE;
+
+  if (self->store[slot] && self->store_seq[slot] == seq)
+    return self->store[slot];
+
+  return NULL;
+}
+
+/* called with the object lock */
+static gboolean
+gst_rist_fec_dec_store (GstRistFecDec * self, guint16 seq, GstBuffer * buffer,
+    gboolean recovered)
+{
+  guint slot = seq % STORE_SIZE;
+
+  if (self->store[slot] && self->store_seq[slot] == seq)
+    return FALSE;
+
+  gst_buffer_replace (&self->store[slot], buffer);
+  self->store_seq[slot] = seq;
+  self->store_recovered[slot] = recovered;
+
+  if (!self->have_seq || gst_rtp_buffer_compare_seqnum (self->last_seq,
+          seq) > 0) {
+    self->last_seq = seq;
+    self->have_seq = TRUE;
+  }
+
+  return TRUE;
+}
+
+/* Rebuilds the one packet protected by @fec that is missing.
+ *
+ * called with the object lock */
+static GstBuffer *
+gst_rist_fec_dec_rebuild (GstRistFecDec * self, RistFecPacket * fec,
+    guint16 missing)
+{
+  RistFecBlock *block = &fec->block;
+  GstBuffer *buffer;
+  GstMapInfo map;
+  guint i;
+
+  for (i = 0; i < fec->na; i++) {
+    guint16 seq = block->base + i * fec->offset;
+    GstBuffer *media;
+
+    if (seq == missing)
+      continue;
+
+    media = gst_rist_fec_dec_lookup (self, seq);
+    gst_buffer_map (media, &map, GST_MAP_READ);
+    gst_rist_fec_block_add (block, map.data, map.size);
+    gst_buffer_unmap (media, &map);
+  }
+
+  if (block->length > block->size) {
+    GST_WARNING_OBJECT (self, "Invalid recovered length %u for packet %u",
+        block->length, missing);
+    return NULL;
+  }
+
+  buffer = gst_buffer_new_allocate (NULL,
+      RIST_FEC_RTP_HEADER_LEN + block->length, NULL);
+  gst_buffer_map (buffer, &map, GST_MAP_WRITE);
+  map.data[0] = 0x80 | block->bits;
+  map.data[1] = block->marker_pt;
+  GST_WRITE_UINT16_BE (map.data + 2, missing);
+  GST_WRITE_UINT32_BE (map.data + 4, block->timestamp);
+  GST_WRITE_UINT32_BE (map.data + 8, self->ssrc);
+  memcpy (map.data + RIST_FEC_RTP_HEADER_LEN, block->data, block->length);
+  gst_buffer_unmap (buffer, &map);
+
+  return buffer;
+}
+
+/* Tries to use the pending FEC packets, as many times as recovering a packet
+ * makes another FEC packet usable. Recovered packets are added to
+ * @recovered.
+ *
+ * called with the object lock */
+static void
+gst_rist_fec_dec_process_pending (GstRistFecDec * self, GstClockTime dts,
+    GList ** recovered)
+{
+  gboolean progress = TRUE;
+
+  while (progress) {
+    GList *l, *next;
+
+    progress = FALSE;
+
+    for (l = self->pending.head; l; l = next) {
+      RistFecPacket *fec = l->data;
+      guint16 last = fec->block.base + (fec->na - 1) * fec->offset;
+      guint16 missing = 0;
+      guint n_missing = 0;
+      GstBuffer *buffer = NULL;
+      guint i;
+
+      next = l->next;
+
+      for (i = 0; i < fec->na && n_missing < 2; i++) {
+        guint16 seq = fec->block.base + i * fec->offset;
+
+        if (!gst_rist_fec_dec_lookup (self, seq)) {
+          missing = seq;
+          n_missing++;
+        }
+      }
+
+      if (n_missing == 1) {
+        buffer = gst_rist_fec_dec_rebuild (self, fec, missing);
+      } else if (n_missing > 1) {
+        /* Wait for more packets, unless they are too old to arrive */
+        if (!self->have_seq ||
+            gst_rtp_buffer_compare_seqnum (last, self->last_seq) <
+            STORE_SIZE / 2)
+          continue;
+
+        GST_LOG_OBJECT (self, "Giving up on the FEC packet protecting %u"
+            " packets from %u", fec->na, fec->block.base);
+      }
+
+      g_queue_delete_link (&self->pending, l);
+      rist_fec_packet_free (fec);
+
+      if (buffer) {
+        GST_DEBUG_OBJECT (self, "Recovered packet %u", missing);
+        GST_BUFFER_DTS (buffer) = dts;
+        gst_rist_fec_dec_store (self, missing, buffer, TRUE);
+        *recovered = g_list_prepend (*recovered, buffer);
+        self->recovered++;
+        progress = TRUE;
+      }
+    }
+  }
+}
+
+static GstFlowReturn
+gst_rist_fec_dec_push_recovered (GstRistFecDec * self, GList * recovered)
+{
+  GstFlowReturn ret = GST_FLOW_OK;
+  GList *l;
+
+  recovered = g_list_reverse (recovered);
+  for (l = recovered; l; l = l->next) {
+    GstFlowReturn push_ret = gst_pad_push (self->srcpad, l->data);
+
+    if (ret == GST_FLOW_OK)
+      ret = push_ret;
+  }
+  g_list_free (recovered);
+
+  return ret;
+}
+
+static GstFlowReturn
+gst_rist_fec_dec_chain (GstPad * pad, GstObject * parent, GstBuffer * buffer)
+{
+  GstRistFecDec *self = GST_RIST_FEC_DEC (parent);
+  GList *recovered = NULL;
+  GstFlowReturn ret;
+  GstMapInfo map;
+  guint16 seq = 0;
+  gboolean valid;
+
+  GST_OBJECT_LOCK (self);
+  if (self->n_fec_pads == 0) {
+    GST_OBJECT_UNLOCK (self);
+    return gst_pad_push (self->srcpad, buffer);
+  }
+
+  if (!gst_buffer_map (buffer, &map, GST_MAP_READ)) {
+    GST_OBJECT_UNLOCK (self);
+    return gst_pad_push (self->srcpad, buffer);
+  }
+  valid = map.size >= RIST_FEC_RTP_HEADER_LEN && (map.data[0] >> 6) == 2;
+  if (valid) {
+    seq = GST_READ_UINT16_BE (map.data + 2);
+    self->ssrc = GST_READ_UINT32_BE (map.data + 8);
+  }
+  gst_buffer_unmap (buffer, &map);
+
+  if (valid && gst_rist_fec_dec_lookup (self, seq) &&
+      self->store_recovered[seq % STORE_SIZE]) {
+    GST_LOG_OBJECT (self, "Dropping packet %u, it was already recovered", seq);
+    GST_OBJECT_UNLOCK (self);
+    gst_buffer_unref (buffer);
+    return GST_FLOW_OK;
+  }
+
+  if (valid && gst_rist_fec_dec_store (self, seq, buffer, FALSE) &&
+      self->pending.length > 0)
+    gst_rist_fec_dec_process_pending (self, GST_BUFFER_DTS (buffer),
+        &recovered);
+  GST_OBJECT_UNLOCK (self);
+
+  ret = gst_pad_push (self->srcpad, buffer);
+  if (recovered) {
+    GstFlowReturn rec_ret = gst_rist_fec_dec_push_recovered (self, recovered);
+
+    if (ret == GST_FLOW_OK)
+      ret = rec_ret;
+  }
+
+  return ret;
+}
+
+static GstFlowReturn
+gst_rist_fec_dec_fec_chain (GstPad * pad, GstObject * parent,
+    GstBuffer * buffer)
+{
+  GstRistFecDec *self = GST_RIST_FEC_DEC (parent);
+  RistFecPacket *fec;
+  GList *recovered = NULL;
+  GstMapInfo map;
+  const guint8 *header;
+  GList *l;
+
+  if (!gst_buffer_map (buffer, &map, GST_MAP_READ))
+    goto invalid;
+
+  if (map.size < RIST_FEC_RTP_HEADER_LEN + RIST_FEC_HEADER_LEN ||
+      (map.data[0] >> 6) != 2)
+    goto invalid_mapped;
+
+  header = map.data + RIST_FEC_RTP_HEADER_LEN;
+
+  /* Only XOR FEC with the extended header is supported, and the offset and
+   * number of packets have to be within the store */
+  if (!(header[4] & 0x80) || (header[12] & 0x80) || (header[12] & 0x38) ||
+      header[13] == 0 || header[14] == 0 ||
+      header[13] * header[14] > STORE_SIZE / 2)
+    goto invalid_mapped;
+
+  fec = g_slice_new0 (RistFecPacket);
+  fec->row = (header[12] & 0x40) != 0;
+  fec->offset = header[13];
+  fec->na = header[14];
+  fec->block.base = GST_READ_UINT16_BE (header);
+  fec->block.length = GST_READ_UINT16_BE (header + 2);
+  fec->block.marker_pt = (map.data[1] & 0x80) | (header[4] & 0x7f);
+  fec->block.bits = map.data[0] & 0x3f;
+  fec->block.timestamp = GST_READ_UINT32_BE (header + 8);
+  fec->block.size = fec->block.allocated =
+      map.size - RIST_FEC_RTP_HEADER_LEN - RIST_FEC_HEADER_LEN;
+  fec->block.data = g_memdup2 (header + RIST_FEC_HEADER_LEN, fec->block.size);
+  gst_buffer_unmap (buffer, &map);
+
+  GST_LOG_OBJECT (self, "%s FEC packet protecting %u packets from %u",
+      fec->row ? "Row" : "Column", fec->na, fec->block.base);
+
+  GST_OBJECT_LOCK (self);
+  /* The same FEC packet can come through several links */
+  for (l = self->pending.head; l; l = l->next) {
+    RistFecPacket *other = l->data;
+
+    if (other->block.base == fec->block.base && other->row == fec->row &&
+        other->na == fec->na && other->offset == fec->offset) {
+      rist_fec_packet_free (fec);
+      fec = NULL;
+      break;
+    }
+  }
+
+  if (fec) {
+    g_queue_push_tail (&self->pending, fec);
+    gst_rist_fec_dec_process_pending (self, GST_BUFFER_DTS (buffer),
+        &recovered);
+  }
+  GST_OBJECT_UNLOCK (self);
+
+  gst_buffer_unref (buffer);
+
+  if (recovered)
+    return gst_rist_fec_dec_push_recovered (self, recovered);
+
+  return GST_FLOW_OK;
+
+invalid_mapped:
+  gst_buffer_unmap (buffer, &map);
+invalid:
+  GST_WARNING_OBJECT (self, "Ignoring invalid FEC packet");
+  gst_buffer_unref (buffer);
+  return GST_FLOW_OK;
+}
+
+static gboolean
+gst_rist_fec_dec_sink_event (GstPad * pad, GstObject * parent,
+    GstEvent * event)
+{
+  GstRistFecDec *self = GST_RIST_FEC_DEC (parent);
+
+  if (GST_EVENT_TYPE (event) == GST_EVENT_FLUSH_STOP) {
+    GST_OBJECT_LOCK (self);
+    gst_rist_fec_dec_reset (self);
+    GST_OBJECT_UNLOCK (self);
+  }
+
+  return gst_pad_event_default (pad, parent, event);
+}
+
+static gboolean
+gst_rist_fec_dec_fec_event (GstPad * pad, GstObject * parent, GstEvent * event)
+{
+  /* The FEC streams don't make it downstream */
+  gst_event_unref (event);
+  return TRUE;
+}
+
+static GstPad *
+gst_rist_fec_dec_request_new_pad (GstElement * element, GstPadTemplate * templ,
+    const gchar * name, const GstCaps * caps)
+{
+  GstRistFecDec *self = GST_RIST_FEC_DEC (element);
+  GstPad *pad;
+  gchar *pad_name = NULL;
+
+  GST_OBJECT_LOCK (self);
+  if (!name)
+    name = pad_name = g_strdup_printf ("fec_%u", self->fec_pad_counter++);
+  self->n_fec_pads++;
+  GST_OBJECT_UNLOCK (self);
+
+  pad = gst_pad_new_from_template (templ, name);
+  g_free (pad_name);
+
+  gst_pad_set_chain_function (pad, gst_rist_fec_dec_fec_chain);
+  gst_pad_set_event_function (pad, gst_rist_fec_dec_fec_event);
+
+  if (GST_STATE (element) > GST_STATE_READY)
+    gst_pad_set_active (pad, TRUE);
+
+  if (!gst_element_add_pad (element, pad)) {
+    GST_OBJECT_LOCK (self);
+    self->n_fec_pads--;
+    GST_OBJECT_UNLOCK (self);
+    return NULL;
+  }
+
+  return pad;
+}
+
+static void
+gst_rist_fec_dec_release_pad (GstElement * element, GstPad * pad)
+{
+  GstRistFecDec *self = GST_RIST_FEC_DEC (element);
+
+  GST_OBJECT_LOCK (self);
+  self->n_fec_pads--;
+  if (self->n_fec_pads == 0)
+    gst_rist_fec_dec_reset (self);
+  GST_OBJECT_UNLOCK (self);
+
+  gst_pad_set_active (pad, FALSE);
+  gst_element_remove_pad (element, pad);
+}
+
+static GstStateChangeReturn
+gst_rist_fec_dec_change_state (GstElement * element, GstStateChange transition)
+{
+  GstRistFecDec *self = GST_RIST_FEC_DEC (element);
+  GstStateChangeReturn ret;
+
+  ret = GST_ELEMENT_CLASS (gst_rist_fec_dec_parent_class)->change_state
+      (element, transition);
+
+  switch (transition) {
+    case GST_STATE_CHANGE_PAUSED_TO_READY:
+      GST_OBJECT_LOCK (self);
+      gst_rist_fec_dec_reset (self);
+      self->recovered = 0;
+      GST_OBJECT_UNLOCK (self);
+      break;
+    default:
+      break;
+  }
+
+  return ret;
+}
+
+static void
+gst_rist_fec_dec_init (GstRistFecDec * self)
+{
+  g_queue_init (&self->pending);
+
+  self->sinkpad = gst_pad_new_from_static_template (&sink_templ,
+      sink_templ.name_template);
+  self->srcpad = gst_pad_new_from_static_template (&src_templ,
+      src_templ.name_template);
+
+  GST_PAD_SET_PROXY_ALLOCATION (self->sinkpad);
+  GST_PAD_SET_PROXY_CAPS (self->sinkpad);
+  gst_pad_set_chain_function (self->sinkpad, gst_rist_fec_dec_chain);
+  gst_pad_set_event_function (self->sinkpad, gst_rist_fec_dec_sink_event);
+
+  gst_element_add_pad (GST_ELEMENT (self), self->sinkpad);
+  gst_element_add_pad (GST_ELEMENT (self), self->srcpad);
+}
+
+static void
+gst_rist_fec_dec_finalize (GObject * object)
+{
+  GstRistFecDec *self = GST_RIST_FEC_DEC (object);
+
+  gst_rist_fec_dec_reset (self);
+
+  G_OBJECT_CLASS (gst_rist_fec_dec_parent_class)->finalize (object);
+}
+
+static void
+gst_rist_fec_dec_get_property (GObject * object, guint prop_id,
+    GValue * value, GParamSpec * pspec)
+{
+  GstRistFecDec *self = GST_RIST_FEC_DEC (object);
+
+  GST_OBJECT_LOCK (self);
+  switch (prop_id) {
+    case PROP_RECOVERED:
+      g_value_set_uint64 (value, self->recovered);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+  GST_OBJECT_UNLOCK (self);
+}
+
+static void
+gst_rist_fec_dec_class_init (GstRistFecDecClass * klass)
+{
+  GstElementClass *element_class = (GstElementClass *) klass;
+  GObjectClass *object_class = (GObjectClass *) klass;
+
+  gst_element_class_set_metadata (element_class,
+      "RIST FEC Decoder", "Codec/Decoder/Network",
+      "Recovers lost RTP packets from SMPTE 2022-1 FEC streams",
+      "agent <agent@local>");
+  gst_element_class_add_static_pad_template (element_class, &src_templ);
+  gst_element_class_add_static_pad_template (element_class, &sink_templ);
+  gst_element_class_add_static_pad_template (element_class, &fec_templ);
+
+  element_class->change_state = gst_rist_fec_dec_change_state;
+  element_class->request_new_pad = gst_rist_fec_dec_request_new_pad;
+  element_class->release_pad = gst_rist_fec_dec_release_pad;
+
+  object_class->get_property = gst_rist_fec_dec_get_property;
+  object_class->finalize = gst_rist_fec_dec_finalize;
+
+  /**
+   * GstRistFecDec:recovered:
+   *
+   * The number of packets recovered from the FEC streams.
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (object_class, PROP_RECOVERED,
+      g_param_spec_uint64 ("recovered", "Recovered",
+          "Number of recovered packets", 0, G_MAXUINT64, 0,
+          G_PARAM_READABLE | G_PARAM_STATIC_STRINGS));
+}
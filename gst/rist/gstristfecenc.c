@@ -0,0 +1,517 @@
+/* GStreamer RIST plugin
+ * Copyright (C) 2026 agent <agent@local>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/**
+ * SECTION:element-ristfecenc
+ * @title: ristfecenc
+ * @see_also: ristfecdec, ristsink
+ *
+ * This element generates the SMPTE 2022-1 forward error correction streams
+ * protecting an RTP stream. The RTP packets are laid out in a matrix of
+ * #GstRistFecEnc:columns packets by #GstRistFecEnc:rows packets. For each
+ * column, a FEC packet that is the XOR of the packets of the column is
+ * pushed on the `fec_0` pad, and if #GstRistFecEnc:enable-row-fec is set,
+ * a FEC packet that is the XOR of the packets of each row is pushed on the
+ * `fec_1` pad. The RTP stream itself goes through unchanged.
+ *
+ * The column FEC allows recovering from bursts of up to
+ * #GstRistFecEnc:columns lost packets, the row FEC from isolated losses, and
+ * together they can recover most of the packets lost within a matrix.
+ *
+ * Since: 1.20
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <string.h>
+
+#include <gst/rtp/rtp.h>
+
+#include "gstrist.h"
+
+GST_DEBUG_CATEGORY_STATIC (gst_rist_fec_enc_debug);
+#define GST_CAT_DEFAULT gst_rist_fec_enc_debug
+
+#define DEFAULT_COLUMNS 0
+#define DEFAULT_ROWS 0
+#define DEFAULT_ENABLE_ROW_FEC TRUE
+
+enum
+{
+  PROP_COLUMNS = 1,
+  PROP_ROWS,
+  PROP_ENABLE_ROW_FEC
+};
+
+enum
+{
+  FEC_COLUMN,
+  FEC_ROW,
+  N_FEC_STREAMS
+};
+
+static GstStaticPadTemplate src_templ = GST_STATIC_PAD_TEMPLATE ("src",
+    GST_PAD_SRC,
+    GST_PAD_ALWAYS,
+    GST_STATIC_CAPS ("application/x-rtp"));
+
+static GstStaticPadTemplate sink_templ = GST_STATIC_PAD_TEMPLATE ("sink",
+    GST_PAD_SINK,
+    GST_PAD_ALWAYS,
+    GST_STATIC_CAPS ("application/x-rtp"));
+
+static GstStaticPadTemplate fec_templ = GST_STATIC_PAD_TEMPLATE ("fec_%u",
+    GST_PAD_SRC,
+    GST_PAD_ALWAYS,
+    GST_STATIC_CAPS ("application/x-rtp"));
+
+struct _GstRistFecEnc
+{
+  GstElement parent;
+
+  GstPad *srcpad, *sinkpad;
+  GstPad *fec_pads[N_FEC_STREAMS];
+
+  /* Properties, protected by the object lock */
+  guint columns;
+  guint rows;
+  gboolean enable_row_fec;
+
+  /* Streaming thread, the matrix in use is only changed between two
+   * matrices */
+  guint cur_columns;
+  guint cur_rows;
+  gboolean cur_row_fec;
+  guint index;
+  guint16 next_seq;
+  gboolean have_seq;
+
+  RistFecBlock row;
+  RistFecBlock cols[RIST_FEC_MAX_COLUMNS];
+  guint16 fec_seq[N_FEC_STREAMS];
+};
+
+G_DEFINE_TYPE_WITH_CODE (GstRistFecEnc, gst_rist_fec_enc, GST_TYPE_ELEMENT,
+    GST_DEBUG_CATEGORY_INIT (gst_rist_fec_enc_debug, "ristfecenc", 0,
+        "RIST FEC Encoder"));
+GST_ELEMENT_REGISTER_DEFINE (ristfecenc, "ristfecenc", GST_RANK_NONE,
+    GST_TYPE_RIST_FEC_ENC);
+
+static void
+gst_rist_fec_enc_reset (GstRistFecEnc * self)
+{
+  self->index = 0;
+  self->have_seq = FALSE;
+}
+
+static GstBuffer *
+gst_rist_fec_enc_make_packet (GstRistFecEnc * self, guint stream,
+    RistFecBlock * block, GstBuffer * media)
+{
+  GstBuffer *buffer;
+  GstMapInfo map;
+  guint8 *data;
+  gboolean row = (stream == FEC_ROW);
+
+  buffer = gst_buffer_new_allocate (NULL,
+      RIST_FEC_RTP_HEADER_LEN + RIST_FEC_HEADER_LEN + block->size, NULL);
+  gst_buffer_map (buffer, &map, GST_MAP_WRITE);
+  data = map.data;
+
+  /* The P, X and CC bits and the marker of the RTP header carry the
+   * recovery of those fields, as in RFC 2733. The CSRC list and the header
+   * extension are never present. */
+  data[0] = 0x80 | block->bits;
+  data[1] = (block->marker_pt & 0x80) | RIST_FEC_PT;
+  GST_WRITE_UINT16_BE (data + 2, self->fec_seq[stream]++);
+  GST_WRITE_UINT32_BE (data + 4, block->timestamp);
+  GST_WRITE_UINT32_BE (data + 8, 0);
+  data += RIST_FEC_RTP_HEADER_LEN;
+
+  GST_WRITE_UINT16_BE (data, block->base);
+  GST_WRITE_UINT16_BE (data + 2, block->length);
+  data[4] = 0x80 | (block->marker_pt & 0x7f);
+  GST_WRITE_UINT24_BE (data + 5, 0);
+  GST_WRITE_UINT32_BE (data + 8, block->timestamp);
+  /* X = 0, D, type = XOR, index = 0 */
+  data[12] = row ? 0x40 : 0x00;
+  data[13] = row ? 1 : self->cur_columns;
+  data[14] = row ? self->cur_columns : self->cur_rows;
+  data[15] = 0;
+  data += RIST_FEC_HEADER_LEN;
+
+  memcpy (data, block->data, block->size);
+  gst_buffer_unmap (buffer, &map);
+
+  GST_BUFFER_PTS (buffer) = GST_BUFFER_PTS (media);
+  GST_BUFFER_DTS (buffer) = GST_BUFFER_DTS (media);
+
+  GST_LOG_OBJECT (self, "%s FEC packet protecting %u packets from %u",
+      row ? "Row" : "Column", block->count, block->base);
+
+  return buffer;
+}
+
+static GstFlowReturn
+gst_rist_fec_enc_chain (GstPad * pad, GstObject * parent, GstBuffer * buffer)
+{
+  GstRistFecEnc *self = GST_RIST_FEC_ENC (parent);
+  GstBuffer *fec[N_FEC_STREAMS] = { NULL, };
+  GstFlowReturn ret;
+  GstMapInfo map;
+  guint16 seq;
+  guint col, row, i;
+
+  if (self->index == 0) {
+    GST_OBJECT_LOCK (self);
+    self->cur_columns = self->columns;
+    self->cur_rows = self->rows;
+    self->cur_row_fec = self->enable_row_fec;
+    GST_OBJECT_UNLOCK (self);
+  }
+
+  if (self->cur_columns == 0 || (self->cur_rows == 0 && !self->cur_row_fec))
+    return gst_pad_push (self->srcpad, buffer);
+
+  if (!gst_buffer_map (buffer, &map, GST_MAP_READ))
+    goto map_failed;
+
+  if (map.size < RIST_FEC_RTP_HEADER_LEN || (map.data[0] >> 6) != 2) {
+    GST_WARNING_OBJECT (self, "Not protecting invalid RTP packet");
+    gst_buffer_unmap (buffer, &map);
+    return gst_pad_push (self->srcpad, buffer);
+  }
+
+  /* The matrix only describes consecutive packets */
+  seq = GST_READ_UINT16_BE (map.data + 2);
+  if (self->have_seq && seq != self->next_seq && self->index != 0) {
+    GST_DEBUG_OBJECT (self, "Gap in the sequence numbers, expected %u got %u,"
+        " starting a new matrix", self->next_seq, seq);
+    self->index = 0;
+  }
+  self->next_seq = seq + 1;
+  self->have_seq = TRUE;
+
+  col = self->index % self->cur_columns;
+  row = self->index / self->cur_columns;
+
+  if (self->cur_row_fec) {
+    if (col == 0)
+      gst_rist_fec_block_reset (&self->row, seq);
+    gst_rist_fec_block_add (&self->row, map.data, map.size);
+    if (col == self->cur_columns - 1)
+      fec[FEC_ROW] = gst_rist_fec_enc_make_packet (self, FEC_ROW, &self->row,
+          buffer);
+  }
+
+  if (self->cur_rows > 0) {
+    if (row == 0)
+      gst_rist_fec_block_reset (&self->cols[col], seq);
+    gst_rist_fec_block_add (&self->cols[col], map.data, map.size);
+    if (row == self->cur_rows - 1)
+      fec[FEC_COLUMN] = gst_rist_fec_enc_make_packet (self, FEC_COLUMN,
+          &self->cols[col], buffer);
+  }
+
+  gst_buffer_unmap (buffer, &map);
+
+  self->index++;
+  if (self->index == self->cur_columns * MAX (self->cur_rows, 1))
+    self->index = 0;
+
+  /* The FEC packets follow the last packet they protect */
+  ret = gst_pad_push (self->srcpad, buffer);
+
+  for (i = 0; i < N_FEC_STREAMS; i++) {
+    if (fec[i]) {
+      GstFlowReturn fec_ret = gst_pad_push (self->fec_pads[i], fec[i]);
+
+      /* The FEC streams are optional */
+      if (fec_ret != GST_FLOW_OK && fec_ret != GST_FLOW_NOT_LINKED &&
+          ret == GST_FLOW_OK)
+        ret = fec_ret;
+    }
+  }
+
+  return ret;
+
+map_failed:
+  GST_ELEMENT_ERROR (self, STREAM, FAILED, (NULL), ("Could not map buffer"));
+  gst_buffer_unref (buffer);
+  return GST_FLOW_ERROR;
+}
+
+static void
+gst_rist_fec_enc_push_fec_event (GstRistFecEnc * self, GstEvent * event)
+{
+  guint i;
+
+  for (i = 0; i < N_FEC_STREAMS; i++)
+    gst_pad_push_event (self->fec_pads[i], gst_event_ref (event));
+}
+
+static gboolean
+gst_rist_fec_enc_sink_event (GstPad * pad, GstObject * parent,
+    GstEvent * event)
+{
+  GstRistFecEnc *self = GST_RIST_FEC_ENC (parent);
+  guint i;
+
+  switch (GST_EVENT_TYPE (event)) {
+    case GST_EVENT_STREAM_START:
+      for (i = 0; i < N_FEC_STREAMS; i++) {
+        gchar *stream_id = gst_pad_create_stream_id (self->fec_pads[i],
+            GST_ELEMENT (self), GST_PAD_NAME (self->fec_pads[i]));
+
+        gst_pad_push_event (self->fec_pads[i],
+            gst_event_new_stream_start (stream_id));
+        g_free (stream_id);
+      }
+      break;
+    case GST_EVENT_CAPS:{
+      GstCaps *caps, *fec_caps;
+      const GstStructure *s;
+      gint clock_rate;
+
+      gst_event_parse_caps (event, &caps);
+      s = gst_caps_get_structure (caps, 0);
+
+      fec_caps = gst_caps_new_simple ("application/x-rtp",
+          "media", G_TYPE_STRING, "application",
+          "payload", G_TYPE_INT, RIST_FEC_PT, NULL);
+      if (gst_structure_get_int (s, "clock-rate", &clock_rate))
+        gst_caps_set_simple (fec_caps, "clock-rate", G_TYPE_INT, clock_rate,
+            NULL);
+
+      for (i = 0; i < N_FEC_STREAMS; i++)
+        gst_pad_push_event (self->fec_pads[i], gst_event_new_caps (fec_caps));
+      gst_caps_unref (fec_caps);
+      break;
+    }
+    case GST_EVENT_FLUSH_STOP:
+      gst_rist_fec_enc_reset (self);
+      /* fall through */
+    case GST_EVENT_FLUSH_START:
+    case GST_EVENT_SEGMENT:
+    case GST_EVENT_EOS:
+      gst_rist_fec_enc_push_fec_event (self, event);
+      break;
+    default:
+      break;
+  }
+
+  return gst_pad_event_default (pad, parent, event);
+}
+
+static gboolean
+gst_rist_fec_enc_fec_event (GstPad * pad, GstObject * parent, GstEvent * event)
+{
+  /* Nothing to tell upstream about the FEC streams */
+  gst_event_unref (event);
+  return TRUE;
+}
+
+static GstStateChangeReturn
+gst_rist_fec_enc_change_state (GstElement * element, GstStateChange transition)
+{
+  GstRistFecEnc *self = GST_RIST_FEC_ENC (element);
+
+  switch (transition) {
+    case GST_STATE_CHANGE_READY_TO_PAUSED:
+      gst_rist_fec_enc_reset (self);
+      self->fec_seq[FEC_COLUMN] = g_random_int ();
+      self->fec_seq[FEC_ROW] = g_random_int ();
+      break;
+    default:
+      break;
+  }
+
+  return GST_ELEMENT_CLASS (gst_rist_fec_enc_parent_class)->change_state
+      (element, transition);
+}
+
+static void
+gst_rist_fec_enc_init (GstRistFecEnc * self)
+{
+  GstPadTemplate *templ;
+  guint i;
+
+  self->columns = DEFAULT_COLUMNS;
+  self->rows = DEFAULT_ROWS;
+  self->enable_row_fec = DEFAULT_ENABLE_ROW_FEC;
+
+  self->sinkpad = gst_pad_new_from_static_template (&sink_templ,
+      sink_templ.name_template);
+  self->srcpad = gst_pad_new_from_static_template (&src_templ,
+      src_templ.name_template);
+
+  GST_PAD_SET_PROXY_ALLOCATION (self->sinkpad);
+  GST_PAD_SET_PROXY_CAPS (self->sinkpad);
+  gst_pad_set_chain_function (self->sinkpad, gst_rist_fec_enc_chain);
+  gst_pad_set_event_function (self->sinkpad, gst_rist_fec_enc_sink_event);
+
+  gst_element_add_pad (GST_ELEMENT (self), self->sinkpad);
+  gst_element_add_pad (GST_ELEMENT (self), self->srcpad);
+
+  templ = gst_static_pad_template_get (&fec_templ);
+  for (i = 0; i < N_FEC_STREAMS; i++) {
+    gchar name[16];
+
+    g_snprintf (name, sizeof (name), "fec_%u", i);
+    self->fec_pads[i] = gst_pad_new_from_template (templ, name);
+    gst_pad_set_event_function (self->fec_pads[i], gst_rist_fec_enc_fec_event);
+    gst_pad_use_fixed_caps (self->fec_pads[i]);
+    gst_element_add_pad (GST_ELEMENT (self), self->fec_pads[i]);
+  }
+  gst_object_unref (templ);
+}
+
+static void
+gst_rist_fec_enc_finalize (GObject * object)
+{
+  GstRistFecEnc *self = GST_RIST_FEC_ENC (object);
+  guint i;
+
+  gst_rist_fec_block_clear (&self->row);
+  for (i = 0; i < RIST_FEC_MAX_COLUMNS; i++)
+    gst_rist_fec_block_clear (&self->cols[i]);
+
+  G_OBJECT_CLASS (gst_rist_fec_enc_parent_class)->finalize (object);
+}
+
+static void
+gst_rist_fec_enc_get_property (GObject * object, guint prop_id,
+    GValue * value, GParamSpec * pspec)
+{
+  GstRistFecEnc *self = GST_RIST_FEC_ENC (object);
+
+  GST_OBJECT_LOCK (self);
+  switch (prop_id) {
+    case PROP_COLUMNS:
+      g_value_set_uint (value, self->columns);
+      break;
+    case PROP_ROWS:
+      g_value_set_uint (value, self->rows);
+      break;
+    case PROP_ENABLE_ROW_FEC:
+      g_value_set_boolean (value, self->enable_row_fec);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+  GST_OBJECT_UNLOCK (self);
+}
+
+static void
+gst_rist_fec_enc_set_property (GObject * object, guint prop_id,
+    const GValue * value, GParamSpec * pspec)
+{
+  GstRistFecEnc *self = GST_RIST_FEC_ENC (object);
+
+  GST_OBJECT_LOCK (self);
+  switch (prop_id) {
+    case PROP_COLUMNS:
+      self->columns = g_value_get_uint (value);
+      break;
+    case PROP_ROWS:
+      self->rows = g_value_get_uint (value);
+      if (self->rows > 0 && self->rows < RIST_FEC_MIN_ROWS) {
+        GST_WARNING_OBJECT (self, "SMPTE 2022-1 requires at least %u rows, "
+            "using %u instead of %u", RIST_FEC_MIN_ROWS, RIST_FEC_MIN_ROWS,
+            self->rows);
+        self->rows = RIST_FEC_MIN_ROWS;
+      }
+      break;
+    case PROP_ENABLE_ROW_FEC:
+      self->enable_row_fec = g_value_get_boolean (value);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+  GST_OBJECT_UNLOCK (self);
+}
+
+static void
+gst_rist_fec_enc_class_init (GstRistFecEncClass * klass)
+{
+  GstElementClass *element_class = (GstElementClass *) klass;
+  GObjectClass *object_class = (GObjectClass *) klass;
+
+  gst_element_class_set_metadata (element_class,
+      "RIST FEC Encoder", "Codec/Encoder/Network",
+      "Generates SMPTE 2022-1 row and column FEC streams",
+      "agent <agent@local>");
+  gst_element_class_add_static_pad_template (element_class, &src_templ);
+  gst_element_class_add_static_pad_template (element_class, &sink_templ);
+  gst_element_class_add_static_pad_template (element_class, &fec_templ);
+
+  element_class->change_state = gst_rist_fec_enc_change_state;
+
+  object_class->get_property = gst_rist_fec_enc_get_property;
+  object_class->set_property = gst_rist_fec_enc_set_property;
+  object_class->finalize = gst_rist_fec_enc_finalize;
+
+  /**
+   * GstRistFecEnc:columns:
+   *
+   * The number of packets of a row of the matrix, known as L. SMPTE 2022-1
+   * limits L x D to 100 packets.
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (object_class, PROP_COLUMNS,
+      g_param_spec_uint ("columns", "Columns",
+          "Number of columns of the FEC matrix (L) (0 = disabled)",
+          0, RIST_FEC_MAX_COLUMNS, DEFAULT_COLUMNS,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS |
+          GST_PARAM_MUTABLE_PLAYING));
+
+  /**
+   * GstRistFecEnc:rows:
+   *
+   * The number of packets of a column of the matrix, known as D. SMPTE 2022-1
+   * requires 4 to 20, values from 1 to 3 are raised to 4. With 0, no column
+   * FEC is generated.
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (object_class, PROP_ROWS,
+      g_param_spec_uint ("rows", "Rows",
+          "Number of rows of the FEC matrix (D), 4 to 20 (0 = no column FEC)",
+          0, RIST_FEC_MAX_ROWS, DEFAULT_ROWS,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS |
+          GST_PARAM_MUTABLE_PLAYING));
+
+  /**
+   * GstRistFecEnc:enable-row-fec:
+   *
+   * Whether to generate the row FEC stream in addition to the column one.
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (object_class, PROP_ENABLE_ROW_FEC,
+      g_param_spec_boolean ("enable-row-fec", "Enable Row FEC",
+          "Generate the row FEC stream", DEFAULT_ENABLE_ROW_FEC,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS |
+          GST_PARAM_MUTABLE_PLAYING));
+}
@@ -37,6 +37,8 @@ plugin_init (GstPlugin * plugin)
   ret |= GST_ELEMENT_REGISTER (roundrobin, plugin);
   ret |= GST_ELEMENT_REGISTER (ristrtpext, plugin);
   ret |= GST_ELEMENT_REGISTER (ristrtpdeext, plugin);
+  ret |= GST_ELEMENT_REGISTER (ristfecenc, plugin);
+  ret |= GST_ELEMENT_REGISTER (ristfecdec, plugin);
 
   return ret;
 }
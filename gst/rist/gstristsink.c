@@ -51,19 +51,35 @@
  * mapped to its own RTP session. RTX request are only replied to on the
  * link the NACK was received from.
  *
- * There are currently two bonding methods in place: "broadcast" and "round-robin".
- * In "broadcast" mode, all the packets are duplicated over all sessions.
- * While in "round-robin" mode, packets are evenly distributed over the links. One
- * can also implement its own dispatcher element and configure it using the
- * "dispatcher" property. As a reference, "broadcast" mode is implemented with
- * the "tee" element, while "round-robin" mode is implemented with the
- * "round-robin" element.
+ * There are currently three bonding methods in place: "broadcast", "round-robin"
+ * and "weighted". In "broadcast" mode, all the packets are duplicated over all
+ * sessions. While in "round-robin" mode, packets are evenly distributed over
+ * the links. In "weighted" mode, packets are distributed in proportion to the
+ * quality of each link, as measured from the RTCP receiver reports: a link
+ * with half the round-trip time of another gets twice the packets, losses
+ * reduce the share of a link further and a link that stopped reporting is
+ * not used anymore. One can also implement its own dispatcher element and
+ * configure it using the "dispatcher" property. As a reference, "broadcast"
+ * mode is implemented with the "tee" element, while "round-robin" and
+ * "weighted" modes are implemented with the "round-robin" element.
  *
  * ## Example gst-launch line for bonding
  * |[
  * gst-launch-1.0 udpsrc ! tsparse set-timestamps=1 smoothing-latency=40000 ! \
  *  rtpmp2tpay ! ristsink bonding-addresses="10.0.0.1:5004,11.0.0.1:5006"
  * ]|
+ *
+ * Forward error correction as defined in SMPTE 2022-1 is enabled by setting
+ * the "fec-columns" property. The column FEC stream is then sent to the RTP
+ * port + 2 of every link, and the row FEC stream to the RTP port + 4, so that
+ * a ristsrc with "enable-fec" set can recover lost packets without waiting
+ * for a retransmission.
+ *
+ * ## Example gst-launch line for FEC
+ * |[
+ * gst-launch-1.0 udpsrc ! tsparse set-timestamps=1 smoothing-latency=40000 ! \
+ *  rtpmp2tpay ! ristsink address=10.0.0.1 port=5004 fec-columns=10 fec-rows=5
+ * ]|
  */
 
 /* using GValueArray, which has not replacement */
@@ -101,15 +117,25 @@ enum
   PROP_BONDING_METHOD,
   PROP_DISPATCHER,
   PROP_DROP_NULL_TS_PACKETS,
-  PROP_SEQUENCE_NUMBER_EXTENSION
+  PROP_SEQUENCE_NUMBER_EXTENSION,
+  PROP_FEC_COLUMNS,
+  PROP_FEC_ROWS,
+  PROP_FEC_ENABLE_ROW
 };
 
 typedef enum
 {
   GST_RIST_BONDING_METHOD_BROADCAST,
   GST_RIST_BONDING_METHOD_ROUND_ROBIN,
+  GST_RIST_BONDING_METHOD_WEIGHTED,
 } GstRistBondingMethod;
 
+/* Smoothing of the link measurements, the weight of the latest report */
+#define LINK_REPORT_SMOOTHING 0.25
+/* Lower bound of the round-trip time used for weighting, so that links on a
+ * LAN don't get an absurd share */
+#define LINK_MIN_RTT_MS 1.0
+
 static GstStaticPadTemplate sink_templ = GST_STATIC_PAD_TEMPLATE ("sink",
     GST_PAD_SINK,
     GST_PAD_ALWAYS,
@@ -126,7 +152,16 @@ typedef struct
   GstElement *rtcp_sink;
   GstElement *rtx_send;
   GstElement *rtx_queue;
+  GstElement *fec_sinks[2];
   guint32 rtcp_ssrc;
+
+  /* Link quality for the weighted bonding method, protected by bonds_lock */
+  GstPad *dispatcher_pad;
+  gboolean have_report;
+  GstClockTime last_report;
+  gdouble rtt_ms;
+  gdouble loss;
+  gdouble weight;
 } RistSenderBond;
 
 struct _GstRistSink
@@ -140,6 +175,7 @@ struct _GstRistSink
   GstElement *rtxbin;
   GstElement *dispatcher;
   GstElement *rtpext;
+  GstElement *fecenc;
 
   /* Common properties, protected by bonds_lock */
   gint multicast_ttl;
@@ -175,6 +211,8 @@ gst_rist_bonding_method_get_type (void)
         "GST_RIST_BONDING_METHOD_BROADCAST", "broadcast"},
     {GST_RIST_BONDING_METHOD_ROUND_ROBIN,
         "GST_RIST_BONDING_METHOD_ROUND_ROBIN", "round-robin"},
+    {GST_RIST_BONDING_METHOD_WEIGHTED,
+        "GST_RIST_BONDING_METHOD_WEIGHTED", "weighted"},
     {0, NULL, NULL}
   };
 
@@ -464,6 +502,106 @@ gst_rist_sink_on_new_sender_ssrc (GstRistSink * sink, guint session_id,
   g_object_unref (session);
 }
 
+/* Weights the links by their measured quality. Links that have not reported
+ * yet get the average weight and links that stopped reporting get none,
+ * unless none of the links is reporting anymore.
+ *
+ * called with bonds_lock */
+static void
+gst_rist_sink_update_weights (GstRistSink * sink)
+{
+  GstClockTime now = gst_util_get_timestamp ();
+  GstClockTime timeout;
+  gdouble total = 0.0;
+  gdouble *weights = g_newa (gdouble, sink->bonds->len);
+  guint i, n_measured = 0, n_alive = 0;
+
+  /* A report is sent at least every few RTCP intervals */
+  timeout = MAX (10 * sink->min_rtcp_interval, GST_SECOND);
+
+  for (i = 0; i < sink->bonds->len; i++) {
+    RistSenderBond *bond = g_ptr_array_index (sink->bonds, i);
+
+    if (now - bond->last_report > timeout) {
+      weights[i] = 0.0;
+    } else if (!bond->have_report) {
+      weights[i] = -1.0;
+      n_alive++;
+    } else {
+      weights[i] = (1.0 - bond->loss) * (1.0 - bond->loss) /
+          MAX (bond->rtt_ms, LINK_MIN_RTT_MS);
+      total += weights[i];
+      n_measured++;
+      n_alive++;
+    }
+  }
+
+  for (i = 0; i < sink->bonds->len; i++) {
+    RistSenderBond *bond = g_ptr_array_index (sink->bonds, i);
+
+    if (n_alive == 0)
+      weights[i] = 1.0;
+    else if (weights[i] < 0.0)
+      weights[i] = n_measured ? total / n_measured : 1.0;
+
+    GST_LOG_OBJECT (sink, "Link %u: rtt %.1f ms, loss %.3f, weight %f",
+        bond->session, bond->rtt_ms, bond->loss, weights[i]);
+
+    /* setting a weight makes the dispatcher start its schedule over */
+    if (weights[i] == bond->weight)
+      continue;
+
+    bond->weight = weights[i];
+    if (bond->dispatcher_pad)
+      g_object_set (bond->dispatcher_pad, "weight", bond->weight, NULL);
+  }
+}
+
+static void
+on_ssrc_active (GObject * session, GObject * source, GstRistSink * sink)
+{
+  GstStructure *stats;
+  gboolean internal = FALSE, have_rb = FALSE;
+  guint fraction_lost = 0, rb_rtt = 0;
+  guint session_id;
+  RistSenderBond *bond;
+
+  g_object_get (source, "stats", &stats, NULL);
+  gst_structure_get_boolean (stats, "internal", &internal);
+  gst_structure_get_boolean (stats, "have-rb", &have_rb);
+  gst_structure_get_uint (stats, "rb-fractionlost", &fraction_lost);
+  gst_structure_get_uint (stats, "rb-round-trip", &rb_rtt);
+  gst_structure_free (stats);
+
+  /* Only the receiver reports of the remote peer tell about the link */
+  if (internal || !have_rb)
+    return;
+
+  session_id =
+      GPOINTER_TO_UINT (g_object_get_qdata (session, session_id_quark));
+
+  g_mutex_lock (&sink->bonds_lock);
+  if (session_id < sink->bonds->len) {
+    /* rb_rtt is in Q16 in NTP time */
+    gdouble rtt_ms = rb_rtt * 1000.0 / 65536.0;
+    gdouble loss = fraction_lost / 256.0;
+
+    bond = g_ptr_array_index (sink->bonds, session_id);
+    if (bond->have_report) {
+      bond->rtt_ms += LINK_REPORT_SMOOTHING * (rtt_ms - bond->rtt_ms);
+      bond->loss += LINK_REPORT_SMOOTHING * (loss - bond->loss);
+    } else {
+      bond->rtt_ms = rtt_ms;
+      bond->loss = loss;
+      bond->have_report = TRUE;
+    }
+    bond->last_report = gst_util_get_timestamp ();
+
+    gst_rist_sink_update_weights (sink);
+  }
+  g_mutex_unlock (&sink->bonds_lock);
+}
+
 static void
 gst_rist_sink_on_new_receiver_ssrc (GstRistSink * sink, guint session_id,
     guint ssrc, GstElement * rtpbin)
@@ -560,6 +698,9 @@ gst_rist_sink_init (GstRistSink * sink)
   RistSenderBond *bond;
 
   sink->rtpext = gst_element_factory_make ("ristrtpext", "ristrtpext");
+  /* Only added to the bin when FEC is enabled */
+  sink->fecenc = gst_object_ref_sink (gst_element_factory_make ("ristfecenc",
+          "rist_fec_enc"));
 
   g_mutex_init (&sink->bonds_lock);
   sink->bonds = g_ptr_array_new ();
@@ -708,10 +849,67 @@ dns_resolve_failed:
   return GST_STATE_CHANGE_FAILURE;
 }
 
+/* Inserts the FEC encoder after the RTP extension, so that the packets are
+ * protected as they are sent, and sends the FEC streams over every link.
+ * Returns FALSE if FEC is disabled. */
+static gboolean
+gst_rist_sink_setup_fec (GstRistSink * sink)
+{
+  guint columns, rows;
+  gboolean enable_row;
+  gint i, j;
+
+  g_object_get (sink->fecenc, "columns", &columns, "rows", &rows,
+      "enable-row-fec", &enable_row, NULL);
+  if (columns == 0 || (rows == 0 && !enable_row))
+    return FALSE;
+
+  if (columns * MAX (rows, 1) > 100)
+    GST_WARNING_OBJECT (sink, "FEC matrix of %u x %u packets is larger than"
+        " allowed by SMPTE 2022-1", columns, rows);
+
+  gst_bin_add (GST_BIN (sink), sink->fecenc);
+  gst_element_link_many (sink->rtpext, sink->fecenc, sink->dispatcher, NULL);
+
+  for (i = 0; i < 2; i++) {
+    gboolean row = (i == 1);
+    guint port_offset =
+        row ? RIST_FEC_ROW_PORT_OFFSET : RIST_FEC_COLUMN_PORT_OFFSET;
+    GstElement *tee;
+    gchar name[32];
+
+    if ((row && !enable_row) || (!row && rows == 0))
+      continue;
+
+    g_snprintf (name, 32, "rist_fec_tee%u", i);
+    tee = gst_element_factory_make ("tee", name);
+    gst_bin_add (GST_BIN (sink), tee);
+    g_snprintf (name, 32, "fec_%u", i);
+    gst_element_link_pads (sink->fecenc, name, tee, "sink");
+
+    for (j = 0; j < sink->bonds->len; j++) {
+      RistSenderBond *bond = g_ptr_array_index (sink->bonds, j);
+
+      g_snprintf (name, 32, "rist_fec_udpsink%u_%u", bond->session, i);
+      bond->fec_sinks[i] = gst_element_factory_make ("udpsink", name);
+      g_object_set (bond->fec_sinks[i], "host", bond->address,
+          "port", bond->port + port_offset,
+          "multicast-iface", bond->multicast_iface,
+          "loop", sink->multicast_loopback, "ttl-mc", sink->multicast_ttl,
+          "async", FALSE, NULL);
+      gst_bin_add (GST_BIN (sink), bond->fec_sinks[i]);
+      gst_element_link (tee, bond->fec_sinks[i]);
+    }
+  }
+
+  return TRUE;
+}
+
 static GstStateChangeReturn
 gst_rist_sink_start (GstRistSink * sink)
 {
   GstPad *rtxbin_gpad, *rtpext_sinkpad;
+  gboolean weighted = FALSE;
   gint i;
 
   /* Unless a custom dispatcher was provided, use the specified bonding method
@@ -726,9 +924,11 @@ gst_rist_sink_start (GstRistSink * sink)
         }
         break;
       case GST_RIST_BONDING_METHOD_ROUND_ROBIN:
+      case GST_RIST_BONDING_METHOD_WEIGHTED:
         sink->dispatcher = gst_element_factory_make ("roundrobin",
             "rist_dispatcher");
         g_assert (sink->dispatcher);
+        weighted = (sink->bonding_method == GST_RIST_BONDING_METHOD_WEIGHTED);
         break;
     }
   }
@@ -747,7 +947,8 @@ gst_rist_sink_start (GstRistSink * sink)
   gst_object_unref (rtpext_sinkpad);
 
   gst_bin_add (GST_BIN (sink->rtxbin), sink->dispatcher);
-  gst_element_link (sink->rtpext, sink->dispatcher);
+  if (!gst_rist_sink_setup_fec (sink))
+    gst_element_link (sink->rtpext, sink->dispatcher);
 
   for (i = 0; i < sink->bonds->len; i++) {
     RistSenderBond *bond = g_ptr_array_index (sink->bonds, i);
@@ -763,6 +964,24 @@ gst_rist_sink_start (GstRistSink * sink)
     g_snprintf (name, 32, "src_%u", bond->session);
     pad = gst_element_request_pad_simple (sink->dispatcher, name);
     gst_element_link_pads (sink->dispatcher, name, bond->rtx_queue, "sink");
+
+    if (weighted) {
+      g_signal_emit_by_name (sink->rtpbin, "get-internal-session", i,
+          &session);
+      g_object_set_qdata (session, session_id_quark, GUINT_TO_POINTER (i));
+      g_signal_connect_object (session, "on-ssrc-active",
+          (GCallback) on_ssrc_active, sink, 0);
+      g_object_unref (session);
+
+      g_mutex_lock (&sink->bonds_lock);
+      gst_object_replace ((GstObject **) & bond->dispatcher_pad,
+          GST_OBJECT (pad));
+      g_object_get (pad, "weight", &bond->weight, NULL);
+      bond->have_report = FALSE;
+      /* Links get some time to report before being considered down */
+      bond->last_report = gst_util_get_timestamp ();
+      g_mutex_unlock (&sink->bonds_lock);
+    }
     gst_object_unref (pad);
 
     if (!gst_rist_sink_setup_rtcp_socket (sink, bond))
@@ -772,7 +991,7 @@ gst_rist_sink_start (GstRistSink * sink)
   return GST_STATE_CHANGE_SUCCESS;
 }
 
-
+/* called with bonds_lock */
 static GstStructure *
 gst_rist_sink_create_stats (GstRistSink * sink)
 {
@@ -828,6 +1047,9 @@ gst_rist_sink_create_stats (GstRistSink * sink)
         "sent-retransmitted-packets", G_TYPE_UINT64, rtx_sent,
         "round-trip-time", G_TYPE_UINT64, rtt, NULL);
 
+    if (bond->dispatcher_pad)
+      gst_structure_set (stats, "weight", G_TYPE_DOUBLE, bond->weight, NULL);
+
     g_value_init (&value, GST_TYPE_STRUCTURE);
     g_value_take_boxed (&value, stats);
     g_value_array_append (session_stats, &value);
@@ -851,7 +1073,11 @@ gst_rist_sink_dump_stats (GstClock * clock, GstClockTime time, GstClockID id,
     gpointer user_data)
 {
   GstRistSink *sink = GST_RIST_SINK (user_data);
-  GstStructure *stats = gst_rist_sink_create_stats (sink);
+  GstStructure *stats;
+
+  g_mutex_lock (&sink->bonds_lock);
+  stats = gst_rist_sink_create_stats (sink);
+  g_mutex_unlock (&sink->bonds_lock);
 
   gst_println ("%s: %" GST_PTR_FORMAT, GST_OBJECT_NAME (sink), stats);
 
@@ -1168,6 +1394,18 @@ gst_rist_sink_get_property (GObject * object, guint prop_id,
           "sequence-number-extension", value);
       break;
 
+    case PROP_FEC_COLUMNS:
+      g_object_get_property (G_OBJECT (sink->fecenc), "columns", value);
+      break;
+
+    case PROP_FEC_ROWS:
+      g_object_get_property (G_OBJECT (sink->fecenc), "rows", value);
+      break;
+
+    case PROP_FEC_ENABLE_ROW:
+      g_object_get_property (G_OBJECT (sink->fecenc), "enable-row-fec", value);
+      break;
+
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -1281,6 +1519,18 @@ gst_rist_sink_set_property (GObject * object, guint prop_id,
           "sequence-number-extension", value);
       break;
 
+    case PROP_FEC_COLUMNS:
+      g_object_set_property (G_OBJECT (sink->fecenc), "columns", value);
+      break;
+
+    case PROP_FEC_ROWS:
+      g_object_set_property (G_OBJECT (sink->fecenc), "rows", value);
+      break;
+
+    case PROP_FEC_ENABLE_ROW:
+      g_object_set_property (G_OBJECT (sink->fecenc), "enable-row-fec", value);
+      break;
+
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -1301,11 +1551,13 @@ gst_rist_sink_finalize (GObject * object)
     RistSenderBond *bond = g_ptr_array_index (sink->bonds, i);
     g_free (bond->address);
     g_free (bond->multicast_iface);
+    gst_clear_object (&bond->dispatcher_pad);
     g_slice_free (RistSenderBond, bond);
   }
   g_ptr_array_free (sink->bonds, TRUE);
 
   g_clear_object (&sink->rtxbin);
+  gst_clear_object (&sink->fecenc);
 
   g_mutex_unlock (&sink->bonds_lock);
   g_mutex_clear (&sink->bonds_lock);
@@ -1423,6 +1675,23 @@ gst_rist_sink_class_init (GstRistSinkClass * klass)
           "Sequence Number Extension",
           "Add sequence number extension to packets.", FALSE,
           G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS | G_PARAM_CONSTRUCT));
+  g_object_class_install_property (object_class, PROP_FEC_COLUMNS,
+      g_param_spec_uint ("fec-columns", "FEC Columns",
+          "Number of columns (L) of the SMPTE 2022-1 FEC matrix "
+          "(0 = FEC disabled)", 0, RIST_FEC_MAX_COLUMNS, 0,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS | G_PARAM_CONSTRUCT |
+          GST_PARAM_MUTABLE_READY));
+  g_object_class_install_property (object_class, PROP_FEC_ROWS,
+      g_param_spec_uint ("fec-rows", "FEC Rows",
+          "Number of rows (D) of the SMPTE 2022-1 FEC matrix, 4 to 20 "
+          "(0 = no column FEC)", 0, RIST_FEC_MAX_ROWS, 0,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS | G_PARAM_CONSTRUCT |
+          GST_PARAM_MUTABLE_READY));
+  g_object_class_install_property (object_class, PROP_FEC_ENABLE_ROW,
+      g_param_spec_boolean ("fec-enable-row", "FEC Enable Row",
+          "Also send the row FEC stream", TRUE,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS | G_PARAM_CONSTRUCT |
+          GST_PARAM_MUTABLE_READY));
 
   gst_type_mark_as_plugin_api (gst_rist_bonding_method_get_type (), 0);
 }
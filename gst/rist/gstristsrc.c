@@ -52,6 +52,15 @@
  * gst-launch-1.0 ristsrc bonding-addresses="10.0.0.1:5004,11.0.0.1:5006" ! rtpmp2tdepay ! udpsink
  * gst-play-1.0 "rist://0.0.0.0:5004?bonding-addresses=10.0.0.1:5004,11.0.0.1:5006"
  * ]|
+ *
+ * When "enable-fec" is set, the SMPTE 2022-1 column and row FEC streams are
+ * also received on the RTP port + 2 and + 4 of every link. They are used to
+ * recover lost packets before retransmission is requested for them.
+ *
+ * ## Example gst-launch line for FEC
+ * |[
+ * gst-launch-1.0 ristsrc address=0.0.0.0 port=5004 enable-fec=1 ! rtpmp2tdepay ! udpsink
+ * ]|
  */
 
 /* using GValueArray, which has not replacement */
@@ -92,7 +101,8 @@ enum
   PROP_MULTICAST_LOOPBACK,
   PROP_MULTICAST_IFACE,
   PROP_MULTICAST_TTL,
-  PROP_BONDING_ADDRESSES
+  PROP_BONDING_ADDRESSES,
+  PROP_ENABLE_FEC
 };
 
 static GstStaticPadTemplate src_templ = GST_STATIC_PAD_TEMPLATE ("src",
@@ -112,6 +122,7 @@ typedef struct
   GstElement *rtp_src;
   GstElement *rtcp_sink;
   GstElement *rtx_receive;
+  GstElement *fec_srcs[2];
   gulong rtcp_recv_probe;
   gulong rtcp_send_probe;
   GSocketAddress *rtcp_send_addr;
@@ -129,6 +140,7 @@ struct _GstRistSrc
   GstPad *srcpad;
   GstElement *rtxbin;
   GstElement *rtx_funnel;
+  GstElement *fecdec;
   GstElement *rtpdeext;
 
   /* Common properties, protected by bonds_lock */
@@ -138,6 +150,7 @@ struct _GstRistSrc
   gdouble max_rtcp_bandwidth;
   gint multicast_loopback;
   gint multicast_ttl;
+  gboolean enable_fec;
 
   /* Bonds */
   GPtrArray *bonds;
@@ -413,8 +426,9 @@ gst_rist_src_init (GstRistSrc * src)
    *                              | rtpbin |
    * udpsrc -> [recv_rtcp_sink_%u] --------  [send_rtcp_src_%u] -> udpsink
    *
-   * This pipeline is fixed for now, note that optionally an FEC stream could
-   * be added later.
+   * The aux receiver funnels the retransmitted and original packets into
+   * the FEC decoder, which receives the FEC streams from their own udpsrc
+   * when FEC is enabled, and passes the packets through otherwise.
    */
   src->srcpad = gst_ghost_pad_new_no_target_from_template ("src",
       gst_static_pad_template_get (&src_templ));
@@ -447,9 +461,12 @@ gst_rist_src_init (GstRistSrc * src)
   src->rtx_funnel = gst_element_factory_make ("funnel", "rist_rtx_funnel");
   gst_bin_add (GST_BIN (src->rtxbin), src->rtx_funnel);
 
+  src->fecdec = gst_element_factory_make ("ristfecdec", "rist_fec_dec");
+  gst_bin_add (GST_BIN (src->rtxbin), src->fecdec);
+
   src->rtpdeext = gst_element_factory_make ("ristrtpdeext", "rist_rtp_de_ext");
   gst_bin_add (GST_BIN (src->rtxbin), src->rtpdeext);
-  gst_element_link (src->rtx_funnel, src->rtpdeext);
+  gst_element_link_many (src->rtx_funnel, src->fecdec, src->rtpdeext, NULL);
 
   pad = gst_element_get_static_pad (src->rtpdeext, "src");
   gpad = gst_ghost_pad_new ("src_0", pad);
@@ -682,6 +699,35 @@ dns_resolve_failed:
 
 }
 
+/* Receives the column and row FEC streams of a bond on the RTP port + 2 and
+ * + 4 and feeds them to the FEC decoder */
+static void
+gst_rist_src_setup_fec (GstRistSrc * src, RistReceiverBond * bond)
+{
+  gint i;
+
+  for (i = 0; i < 2; i++) {
+    guint port_offset =
+        i == 0 ? RIST_FEC_COLUMN_PORT_OFFSET : RIST_FEC_ROW_PORT_OFFSET;
+    gchar name[32];
+
+    if (bond->fec_srcs[i])
+      continue;
+
+    g_snprintf (name, 32, "rist_fec_udpsrc%u_%u", bond->session, i);
+    bond->fec_srcs[i] = gst_element_factory_make ("udpsrc", name);
+    g_object_set (bond->fec_srcs[i], "address", bond->address,
+        "port", bond->port + port_offset,
+        "multicast-iface", bond->multicast_iface,
+        "loop", src->multicast_loopback, NULL);
+    gst_bin_add (GST_BIN (src), bond->fec_srcs[i]);
+
+    g_snprintf (name, 32, "fec_%u", bond->session * 2 + i);
+    gst_element_link_pads (bond->fec_srcs[i], "src", src->fecdec, name);
+    gst_element_sync_state_with_parent (bond->fec_srcs[i]);
+  }
+}
+
 static GstStateChangeReturn
 gst_rist_src_start (GstRistSrc * src)
 {
@@ -705,6 +751,9 @@ gst_rist_src_start (GstRistSrc * src)
 
     if (!gst_rist_src_setup_rtcp_socket (src, bond))
       return GST_STATE_CHANGE_FAILURE;
+
+    if (src->enable_fec)
+      gst_rist_src_setup_fec (src, bond);
   }
 
   return GST_STATE_CHANGE_SUCCESS;
@@ -716,7 +765,7 @@ gst_rist_src_create_stats (GstRistSrc * src)
   GstStructure *ret;
   GValueArray *session_stats;
   guint64 total_dropped = 0, total_received = 0, recovered = 0, lost = 0;
-  guint64 duplicates = 0, rtx_sent = 0, rtt = 0;
+  guint64 duplicates = 0, rtx_sent = 0, rtt = 0, fec_recovered = 0;
   gint i;
 
   ret = gst_structure_new_empty ("rist/x-receiver-stats");
@@ -779,6 +828,9 @@ gst_rist_src_create_stats (GstRistSrc * src)
     gst_structure_free (stats);
   }
 
+  if (src->fecdec)
+    g_object_get (src->fecdec, "recovered", &fec_recovered, NULL);
+
   gst_structure_set (ret, "dropped", G_TYPE_UINT64, total_dropped,
       "received", G_TYPE_UINT64, total_received,
       "recovered", G_TYPE_UINT64, recovered,
@@ -786,6 +838,7 @@ gst_rist_src_create_stats (GstRistSrc * src)
       "duplicates", G_TYPE_UINT64, duplicates,
       "retransmission-requests-sent", G_TYPE_UINT64, rtx_sent,
       "rtx-roundtrip-time", G_TYPE_UINT64, rtt,
+      "fec-recovered", G_TYPE_UINT64, fec_recovered,
       "session-stats", G_TYPE_VALUE_ARRAY, session_stats, NULL);
   g_value_array_free (session_stats);
 
@@ -1118,6 +1171,10 @@ gst_rist_src_get_property (GObject * object, guint prop_id,
       g_value_take_string (value, gst_rist_src_get_bonds (src));
       break;
 
+    case PROP_ENABLE_FEC:
+      g_value_set_boolean (value, src->enable_fec);
+      break;
+
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -1218,6 +1275,10 @@ gst_rist_src_set_property (GObject * object, guint prop_id,
       gst_rist_src_set_bonds (src, g_value_get_string (value));
       break;
 
+    case PROP_ENABLE_FEC:
+      src->enable_fec = g_value_get_boolean (value);
+      break;
+
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -1350,6 +1411,13 @@ gst_rist_src_class_init (GstRistSrcClass * klass)
           "Comma (,) separated list of <address>:<port> to receive from. "
           "Only used if 'enable-bonding' is set.", NULL,
           G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (object_class, PROP_ENABLE_FEC,
+      g_param_spec_boolean ("enable-fec", "Enable FEC",
+          "Receive the SMPTE 2022-1 FEC streams on the RTP port + 2 and + 4 "
+          "and use them to recover lost packets.", FALSE,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS | G_PARAM_CONSTRUCT |
+          GST_PARAM_MUTABLE_READY));
 }
 
 static GstURIType
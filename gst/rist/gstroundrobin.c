@@ -27,13 +27,40 @@
  * element, which duplicates buffers over all pads. This element 
  * can be used to distrute load across multiple branches when the buffer
  * can be processed independently.
+ *
+ * Each src pad has a #GstRoundRobinPad:weight, buffers are distributed in
+ * proportion to the weights and pads with a weight of 0 are skipped. In
+ * #GstRoundRobin:mode broadcast, every buffer is pushed to all the pads that
+ * have a weight, which allows to stop duplicating over a broken link.
  */
 
+#include <stdio.h>
+#include <string.h>
+
 #include "gstroundrobin.h"
 
 GST_DEBUG_CATEGORY_STATIC (gst_round_robin_debug);
 #define GST_CAT_DEFAULT gst_round_robin_debug
 
+/* Resolution of the weights in the schedule, the weight of the heaviest pad
+ * maps to this many slots */
+#define MAX_SLOTS_PER_PAD 16
+
+#define DEFAULT_WEIGHT 1.0
+#define DEFAULT_MODE GST_ROUND_ROBIN_MODE_LOAD_BALANCE
+
+enum
+{
+  PROP_0,
+  PROP_MODE,
+};
+
+enum
+{
+  PROP_PAD_0,
+  PROP_PAD_WEIGHT,
+};
+
 static GstStaticPadTemplate sink_templ = GST_STATIC_PAD_TEMPLATE ("sink",
     GST_PAD_SINK,
     GST_PAD_ALWAYS,
@@ -44,41 +71,278 @@ static GstStaticPadTemplate src_templ = GST_STATIC_PAD_TEMPLATE ("src_%d",
     GST_PAD_REQUEST,
     GST_STATIC_CAPS ("ANY"));
 
+struct _GstRoundRobinPad
+{
+  GstPad parent;
+
+  /* protected by the object lock of the element */
+  gdouble weight;
+};
+
 struct _GstRoundRobin
 {
   GstElement parent;
-  gint index;
+
+  /* protected by the object lock */
+  GstRoundRobinMode mode;
+  /* GstRoundRobinPad, in the order they were requested */
+  GPtrArray *pads;
+  /* index in pads of each slot, pads appear as many times as their weight */
+  GArray *schedule;
+  guint index;
+  gboolean schedule_dirty;
+  guint pad_counter;
 };
 
+G_DEFINE_TYPE (GstRoundRobinPad, gst_round_robin_pad, GST_TYPE_PAD);
+
 G_DEFINE_TYPE_WITH_CODE (GstRoundRobin, gst_round_robin,
     GST_TYPE_ELEMENT, GST_DEBUG_CATEGORY_INIT (gst_round_robin_debug,
         "roundrobin", 0, "Round Robin"));
 GST_ELEMENT_REGISTER_DEFINE (roundrobin, "roundrobin", GST_RANK_NONE,
     GST_TYPE_ROUND_ROBIN);
 
+GType
+gst_round_robin_mode_get_type (void)
+{
+  static gsize id = 0;
+  static const GEnumValue values[] = {
+    {GST_ROUND_ROBIN_MODE_LOAD_BALANCE,
+        "GST_ROUND_ROBIN_MODE_LOAD_BALANCE", "load-balance"},
+    {GST_ROUND_ROBIN_MODE_BROADCAST,
+        "GST_ROUND_ROBIN_MODE_BROADCAST", "broadcast"},
+    {0, NULL, NULL}
+  };
+
+  if (g_once_init_enter (&id)) {
+    GType tmp = g_enum_register_static ("GstRoundRobinMode", values);
+    g_once_init_leave (&id, tmp);
+  }
+
+  return (GType) id;
+}
+
+static void
+gst_round_robin_pad_set_property (GObject * object, guint prop_id,
+    const GValue * value, GParamSpec * pspec)
+{
+  GstRoundRobinPad *pad = GST_ROUND_ROBIN_PAD (object);
+  GstObject *parent = gst_object_get_parent (GST_OBJECT (pad));
+
+  switch (prop_id) {
+    case PROP_PAD_WEIGHT:
+      if (parent) {
+        gdouble weight = g_value_get_double (value);
+
+        GST_OBJECT_LOCK (parent);
+        if (pad->weight != weight) {
+          pad->weight = weight;
+          GST_ROUND_ROBIN (parent)->schedule_dirty = TRUE;
+        }
+        GST_OBJECT_UNLOCK (parent);
+      } else {
+        pad->weight = g_value_get_double (value);
+      }
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+
+  if (parent)
+    gst_object_unref (parent);
+}
+
+static void
+gst_round_robin_pad_get_property (GObject * object, guint prop_id,
+    GValue * value, GParamSpec * pspec)
+{
+  GstRoundRobinPad *pad = GST_ROUND_ROBIN_PAD (object);
+  GstObject *parent = gst_object_get_parent (GST_OBJECT (pad));
+
+  switch (prop_id) {
+    case PROP_PAD_WEIGHT:
+      if (parent)
+        GST_OBJECT_LOCK (parent);
+      g_value_set_double (value, pad->weight);
+      if (parent)
+        GST_OBJECT_UNLOCK (parent);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+
+  if (parent)
+    gst_object_unref (parent);
+}
+
+static void
+gst_round_robin_pad_init (GstRoundRobinPad * pad)
+{
+  pad->weight = DEFAULT_WEIGHT;
+}
+
+static void
+gst_round_robin_pad_class_init (GstRoundRobinPadClass * klass)
+{
+  GObjectClass *object_class = (GObjectClass *) klass;
+
+  object_class->set_property = gst_round_robin_pad_set_property;
+  object_class->get_property = gst_round_robin_pad_get_property;
+
+  /**
+   * GstRoundRobinPad:weight:
+   *
+   * The share of the buffers pushed on this pad relative to the other pads.
+   * Pads with a weight of 0 do not get any buffer.
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (object_class, PROP_PAD_WEIGHT,
+      g_param_spec_double ("weight", "Weight",
+          "Share of the buffers pushed on this pad (0 = disabled)", 0.0,
+          G_MAXDOUBLE, DEFAULT_WEIGHT,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+}
+
+/* Lays out the pads in the schedule so that each pad gets slots in
+ * proportion to its weight, interleaved as evenly as possible (smooth
+ * weighted round robin). Picking a pad is then a lookup. The position in the
+ * schedule is kept if the weights still give the same layout.
+ *
+ * called with the object lock */
+static void
+gst_round_robin_update_schedule (GstRoundRobin * disp)
+{
+  GArray *schedule;
+  gdouble max_weight = 0.0;
+  guint *slots;
+  gint *credits;
+  guint total = 0;
+  guint i, n;
+
+  disp->schedule_dirty = FALSE;
+  schedule = g_array_new (FALSE, FALSE, sizeof (guint));
+
+  for (i = 0; i < disp->pads->len; i++) {
+    GstRoundRobinPad *pad = g_ptr_array_index (disp->pads, i);
+    max_weight = MAX (max_weight, pad->weight);
+  }
+
+  if (max_weight <= 0.0)
+    goto done;
+
+  slots = g_newa (guint, disp->pads->len);
+  credits = g_newa (gint, disp->pads->len);
+
+  for (i = 0; i < disp->pads->len; i++) {
+    GstRoundRobinPad *pad = g_ptr_array_index (disp->pads, i);
+
+    slots[i] = 0;
+    if (pad->weight > 0.0) {
+      slots[i] = (guint) (pad->weight / max_weight * MAX_SLOTS_PER_PAD + 0.5);
+      slots[i] = MAX (slots[i], 1);
+    }
+    credits[i] = 0;
+    total += slots[i];
+  }
+
+  for (n = 0; n < total; n++) {
+    guint best = 0;
+
+    for (i = 0; i < disp->pads->len; i++) {
+      credits[i] += slots[i];
+      if (credits[i] > credits[best])
+        best = i;
+    }
+    credits[best] -= total;
+    g_array_append_val (schedule, best);
+  }
+
+  GST_DEBUG_OBJECT (disp, "Schedule of %u slots for %u pads", total,
+      disp->pads->len);
+
+done:
+  if (schedule->len != disp->schedule->len ||
+      memcmp (schedule->data, disp->schedule->data,
+          schedule->len * sizeof (guint)) != 0)
+    disp->index = 0;
+  g_array_unref (disp->schedule);
+  disp->schedule = schedule;
+}
+
+static GstFlowReturn
+gst_round_robin_broadcast (GstRoundRobin * disp, GstBuffer * buffer)
+{
+  GstPad **pads;
+  GstFlowReturn ret = GST_FLOW_NOT_LINKED;
+  guint i, n_pads = 0;
+
+  GST_OBJECT_LOCK (disp);
+  pads = g_newa (GstPad *, disp->pads->len);
+  for (i = 0; i < disp->pads->len; i++) {
+    GstRoundRobinPad *pad = g_ptr_array_index (disp->pads, i);
+
+    if (pad->weight > 0.0)
+      pads[n_pads++] = gst_object_ref (pad);
+  }
+  GST_OBJECT_UNLOCK (disp);
+
+  /* Like tee, succeed as long as one pad is linked */
+  for (i = 0; i < n_pads; i++) {
+    GstFlowReturn pad_ret = gst_pad_push (pads[i], gst_buffer_ref (buffer));
+
+    if (pad_ret == GST_FLOW_OK || ret == GST_FLOW_NOT_LINKED)
+      ret = pad_ret;
+    else if (pad_ret != GST_FLOW_NOT_LINKED && ret != GST_FLOW_OK)
+      ret = pad_ret;
+
+    gst_object_unref (pads[i]);
+  }
+
+  gst_buffer_unref (buffer);
+
+  if (n_pads == 0)
+    /* no pad, that's fine */
+    return GST_FLOW_OK;
+
+  return ret;
+}
+
 static GstFlowReturn
 gst_round_robin_chain (GstPad * pad, GstObject * parent, GstBuffer * buffer)
 {
   GstRoundRobin *disp = (GstRoundRobin *) parent;
-  GstElement *elem = (GstElement *) parent;
   GstPad *src_pad = NULL;
   GstFlowReturn ret;
 
   GST_OBJECT_LOCK (disp);
-  if (disp->index >= elem->numsrcpads)
-    disp->index = 0;
+  if (disp->mode == GST_ROUND_ROBIN_MODE_BROADCAST) {
+    GST_OBJECT_UNLOCK (disp);
+    return gst_round_robin_broadcast (disp, buffer);
+  }
+
+  if (disp->schedule_dirty)
+    gst_round_robin_update_schedule (disp);
 
-  src_pad = g_list_nth_data (elem->srcpads, disp->index);
+  if (disp->schedule->len > 0) {
+    guint pad_index;
 
-  if (src_pad) {
-    gst_object_ref (src_pad);
+    if (disp->index >= disp->schedule->len)
+      disp->index = 0;
+
+    pad_index = g_array_index (disp->schedule, guint, disp->index);
+    src_pad = gst_object_ref (g_ptr_array_index (disp->pads, pad_index));
     disp->index += 1;
   }
   GST_OBJECT_UNLOCK (disp);
 
-  if (!src_pad)
+  if (!src_pad) {
     /* no pad, that's fine */
+    gst_buffer_unref (buffer);
     return GST_FLOW_OK;
+  }
 
   ret = gst_pad_push (src_pad, buffer);
   gst_object_unref (src_pad);
@@ -90,25 +354,119 @@ static GstPad *
 gst_round_robin_request_pad (GstElement * element, GstPadTemplate * templ,
     const gchar * name, const GstCaps * caps)
 {
+  GstRoundRobin *disp = GST_ROUND_ROBIN (element);
   GstPad *pad;
+  gchar *pad_name = NULL;
 
-  pad = gst_element_get_static_pad (element, name);
-  if (pad) {
-    gst_object_unref (pad);
-    return NULL;
+  if (name) {
+    guint index;
+
+    pad = gst_element_get_static_pad (element, name);
+    if (pad) {
+      gst_object_unref (pad);
+      return NULL;
+    }
+
+    /* the automatic names must not take this one later */
+    if (sscanf (name, "src_%u", &index) == 1) {
+      GST_OBJECT_LOCK (disp);
+      if (index >= disp->pad_counter)
+        disp->pad_counter = index + 1;
+      GST_OBJECT_UNLOCK (disp);
+    }
+  } else {
+    GST_OBJECT_LOCK (disp);
+    pad_name = g_strdup_printf ("src_%u", disp->pad_counter++);
+    GST_OBJECT_UNLOCK (disp);
+    name = pad_name;
   }
 
-  pad = gst_pad_new_from_static_template (&src_templ, name);
-  gst_element_add_pad (element, pad);
+  pad = g_object_new (GST_TYPE_ROUND_ROBIN_PAD, "name", name,
+      "direction", GST_PAD_SRC, "template", templ, NULL);
+  g_free (pad_name);
+
+  /* this drops the pad if it fails */
+  if (!gst_element_add_pad (element, pad))
+    return NULL;
+
+  GST_OBJECT_LOCK (disp);
+  g_ptr_array_add (disp->pads, pad);
+  disp->schedule_dirty = TRUE;
+  GST_OBJECT_UNLOCK (disp);
 
   return pad;
 }
 
+static void
+gst_round_robin_release_pad (GstElement * element, GstPad * pad)
+{
+  GstRoundRobin *disp = GST_ROUND_ROBIN (element);
+
+  GST_OBJECT_LOCK (disp);
+  g_ptr_array_remove (disp->pads, pad);
+  disp->schedule_dirty = TRUE;
+  GST_OBJECT_UNLOCK (disp);
+
+  gst_element_remove_pad (element, pad);
+}
+
+static void
+gst_round_robin_set_property (GObject * object, guint prop_id,
+    const GValue * value, GParamSpec * pspec)
+{
+  GstRoundRobin *disp = GST_ROUND_ROBIN (object);
+
+  switch (prop_id) {
+    case PROP_MODE:
+      GST_OBJECT_LOCK (disp);
+      disp->mode = g_value_get_enum (value);
+      GST_OBJECT_UNLOCK (disp);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+}
+
+static void
+gst_round_robin_get_property (GObject * object, guint prop_id,
+    GValue * value, GParamSpec * pspec)
+{
+  GstRoundRobin *disp = GST_ROUND_ROBIN (object);
+
+  switch (prop_id) {
+    case PROP_MODE:
+      GST_OBJECT_LOCK (disp);
+      g_value_set_enum (value, disp->mode);
+      GST_OBJECT_UNLOCK (disp);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+}
+
+static void
+gst_round_robin_finalize (GObject * object)
+{
+  GstRoundRobin *disp = GST_ROUND_ROBIN (object);
+
+  g_ptr_array_unref (disp->pads);
+  g_array_unref (disp->schedule);
+
+  G_OBJECT_CLASS (gst_round_robin_parent_class)->finalize (object);
+}
+
 static void
 gst_round_robin_init (GstRoundRobin * disp)
 {
   GstPad *pad;
 
+  disp->mode = DEFAULT_MODE;
+  /* the pads are owned by the element */
+  disp->pads = g_ptr_array_new ();
+  disp->schedule = g_array_new (FALSE, FALSE, sizeof (guint));
+
   gst_element_create_all_pads (GST_ELEMENT (disp));
   pad = GST_PAD (GST_ELEMENT (disp)->sinkpads->data);
 
@@ -122,16 +480,40 @@ gst_round_robin_init (GstRoundRobin * disp)
 static void
 gst_round_robin_class_init (GstRoundRobinClass * klass)
 {
+  GObjectClass *object_class = (GObjectClass *) klass;
   GstElementClass *element_class = (GstElementClass *) klass;
 
+  object_class->set_property = gst_round_robin_set_property;
+  object_class->get_property = gst_round_robin_get_property;
+  object_class->finalize = gst_round_robin_finalize;
+
+  /**
+   * GstRoundRobin:mode:
+   *
+   * Whether each buffer goes to one pad, chosen according to the weights,
+   * or to all the pads that have a weight.
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (object_class, PROP_MODE,
+      g_param_spec_enum ("mode", "Mode",
+          "How buffers are dispatched over the src pads",
+          GST_TYPE_ROUND_ROBIN_MODE, DEFAULT_MODE,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
   gst_element_class_set_metadata (element_class,
       "Round Robin", "Source/Network",
       "A round robin dispatcher element.",
       "Nicolas Dufresne <nicolas.dufresne@collabora.com");
 
   gst_element_class_add_static_pad_template (element_class, &sink_templ);
-  gst_element_class_add_static_pad_template (element_class, &src_templ);
+  gst_element_class_add_static_pad_template_with_gtype (element_class,
+      &src_templ, GST_TYPE_ROUND_ROBIN_PAD);
 
   element_class->request_new_pad =
       GST_DEBUG_FUNCPTR (gst_round_robin_request_pad);
+  element_class->release_pad = GST_DEBUG_FUNCPTR (gst_round_robin_release_pad);
+
+  gst_type_mark_as_plugin_api (GST_TYPE_ROUND_ROBIN_MODE, 0);
+  gst_type_mark_as_plugin_api (GST_TYPE_ROUND_ROBIN_PAD, 0);
 }
@@ -32,4 +32,28 @@ typedef struct {
 GType gst_round_robin_get_type (void);
 GST_ELEMENT_REGISTER_DECLARE (roundrobin);
 
+#define GST_TYPE_ROUND_ROBIN_PAD    (gst_round_robin_pad_get_type())
+#define GST_ROUND_ROBIN_PAD(obj)    (G_TYPE_CHECK_INSTANCE_CAST((obj),GST_TYPE_ROUND_ROBIN_PAD,GstRoundRobinPad))
+typedef struct _GstRoundRobinPad GstRoundRobinPad;
+typedef struct {
+  GstPadClass parent;
+} GstRoundRobinPadClass;
+GType gst_round_robin_pad_get_type (void);
+
+/**
+ * GstRoundRobinMode:
+ * @GST_ROUND_ROBIN_MODE_LOAD_BALANCE: push each buffer on one pad
+ * @GST_ROUND_ROBIN_MODE_BROADCAST: push each buffer on all the pads
+ *
+ * Since: 1.20
+ */
+typedef enum
+{
+  GST_ROUND_ROBIN_MODE_LOAD_BALANCE,
+  GST_ROUND_ROBIN_MODE_BROADCAST,
+} GstRoundRobinMode;
+
+#define GST_TYPE_ROUND_ROBIN_MODE (gst_round_robin_mode_get_type())
+GType gst_round_robin_mode_get_type (void);
+
 #endif
@@ -59,6 +59,9 @@ typedef enum
 
 static const gsize chunk_header_sizes[4] = { 11, 7, 3, 0 };
 
+/* Three bytes basic header, type 0 header and extended timestamp */
+#define CHUNK_HEADER_MAX_SIZE (3 + 11 + 4)
+
 struct _GstRtmpChunkStream
 {
   GstBuffer *buffer;
@@ -244,16 +247,15 @@ select_chunk_type (GstRtmpChunkStream * cstream, GstBuffer * buffer)
   return CHUNK_TYPE_3;
 }
 
-static GstBuffer *
-serialize_next (GstRtmpChunkStream * cstream, guint32 chunk_size,
-    ChunkType type)
+/* Writes the header of the next chunk into @data, which must have room for
+ * CHUNK_HEADER_MAX_SIZE bytes, and returns its size */
+static gsize
+serialize_header (GstRtmpChunkStream * cstream, ChunkType type, guint8 * data)
 {
   GstRtmpMeta *meta = cstream->meta;
   guint8 small_stream_id;
   gsize header_size = chunk_header_sizes[type], offset;
   gboolean ext_ts;
-  GstBuffer *ret;
-  GstMapInfo map;
 
   GST_TRACE ("Serializing a chunk of type %d, offset %" G_GUINT32_FORMAT,
       type, cstream->offset);
@@ -274,33 +276,18 @@ serialize_next (GstRtmpChunkStream * cstream, guint32 chunk_size,
     header_size += 4;
   }
 
-  GST_TRACE ("Allocating buffer, header size %" G_GSIZE_FORMAT, header_size);
-
-  ret = gst_buffer_new_allocate (NULL, header_size, NULL);
-  if (!ret) {
-    GST_ERROR ("Failed to allocate chunk buffer");
-    return NULL;
-  }
-
-  if (!gst_buffer_map (ret, &map, GST_MAP_WRITE)) {
-    GST_ERROR ("Failed to map %" GST_PTR_FORMAT, ret);
-    gst_buffer_unref (ret);
-    return NULL;
-  }
-
   /* Chunk Basic Header */
-  GST_WRITE_UINT8 (map.data, (type << 6) | small_stream_id);
+  GST_WRITE_UINT8 (data, (type << 6) | small_stream_id);
   offset = 1;
 
   switch (small_stream_id) {
     case CHUNK_BYTE_TWOBYTE:
-      GST_WRITE_UINT8 (map.data + 1, cstream->id - CHUNK_STREAM_MIN_TWOBYTE);
+      GST_WRITE_UINT8 (data + 1, cstream->id - CHUNK_STREAM_MIN_TWOBYTE);
       offset += 1;
       break;
 
     case CHUNK_BYTE_THREEBYTE:
-      GST_WRITE_UINT16_LE (map.data + 1,
-          cstream->id - CHUNK_STREAM_MIN_TWOBYTE);
+      GST_WRITE_UINT16_LE (data + 1, cstream->id - CHUNK_STREAM_MIN_TWOBYTE);
       offset += 2;
       break;
   }
@@ -308,29 +295,50 @@ serialize_next (GstRtmpChunkStream * cstream, guint32 chunk_size,
   switch (type) {
     case CHUNK_TYPE_0:
       /* SRSLY:  "Message stream ID is stored in little-endian format." */
-      GST_WRITE_UINT32_LE (map.data + offset + 7, meta->mstream);
+      GST_WRITE_UINT32_LE (data + offset + 7, meta->mstream);
       /* no break */
     case CHUNK_TYPE_1:
-      GST_WRITE_UINT24_BE (map.data + offset + 3, meta->size);
-      GST_WRITE_UINT8 (map.data + offset + 6, meta->type);
+      GST_WRITE_UINT24_BE (data + offset + 3, meta->size);
+      GST_WRITE_UINT8 (data + offset + 6, meta->type);
       /* no break */
     case CHUNK_TYPE_2:
-      GST_WRITE_UINT24_BE (map.data + offset,
-          ext_ts ? 0xffffff : meta->ts_delta);
+      GST_WRITE_UINT24_BE (data + offset, ext_ts ? 0xffffff : meta->ts_delta);
       /* no break */
     case CHUNK_TYPE_3:
       offset += chunk_header_sizes[type];
 
       if (ext_ts) {
-        GST_WRITE_UINT32_BE (map.data + offset, meta->ts_delta);
+        GST_WRITE_UINT32_BE (data + offset, meta->ts_delta);
         offset += 4;
       }
   }
 
   g_assert (offset == header_size);
-  GST_MEMDUMP (">>> chunk header", map.data, offset);
+  GST_MEMDUMP (">>> chunk header", data, offset);
+
+  return header_size;
+}
+
+static GstBuffer *
+serialize_next (GstRtmpChunkStream * cstream, guint32 chunk_size,
+    ChunkType type)
+{
+  GstRtmpMeta *meta = cstream->meta;
+  guint8 header[CHUNK_HEADER_MAX_SIZE];
+  gsize header_size;
+  GstBuffer *ret;
+
+  header_size = serialize_header (cstream, type, header);
+
+  GST_TRACE ("Allocating buffer, header size %" G_GSIZE_FORMAT, header_size);
+
+  ret = gst_buffer_new_allocate (NULL, header_size, NULL);
+  if (!ret) {
+    GST_ERROR ("Failed to allocate chunk buffer");
+    return NULL;
+  }
 
-  gst_buffer_unmap (ret, &map);
+  gst_buffer_fill (ret, 0, header, header_size);
 
   GST_BUFFER_OFFSET (ret) = GST_BUFFER_OFFSET_IS_VALID (cstream->buffer) ?
       GST_BUFFER_OFFSET (cstream->buffer) + cstream->offset : cstream->bytes;
@@ -357,6 +365,16 @@ serialize_next (GstRtmpChunkStream * cstream, guint32 chunk_size,
   return ret;
 }
 
+static inline void
+chunk_vectors_append (GstRtmpChunkVectors * chunks, const guint8 * data,
+    gsize size)
+{
+  chunks->vectors[chunks->n_vectors].buffer = data;
+  chunks->vectors[chunks->n_vectors].size = size;
+  chunks->n_vectors++;
+  chunks->size += size;
+}
+
 void
 gst_rtmp_chunk_stream_clear (GstRtmpChunkStream * cstream)
 {
@@ -666,21 +684,120 @@ gst_rtmp_chunk_stream_serialize_next (GstRtmpChunkStream * cstream,
   return serialize_next (cstream, chunk_size, CHUNK_TYPE_3);
 }
 
-GstBuffer *
-gst_rtmp_chunk_stream_serialize_all (GstRtmpChunkStream * cstream,
+/* Serializes the whole message for a single vectored write. The headers of
+ * all the chunks are written into one allocation, and the vectors interleave
+ * them with the payload, read in place from the mapped memories of the
+ * message instead of being copied. */
+GstRtmpChunkVectors *
+gst_rtmp_chunk_stream_serialize_vectors (GstRtmpChunkStream * cstream,
     GstBuffer * buffer, guint32 chunk_size)
 {
-  GstBuffer *outbuf, *nextbuf;
+  GstRtmpChunkVectors *chunks;
+  GstRtmpMeta *meta;
+  ChunkType type;
+  guint32 n_chunks;
+  gsize header_offset = 0, mem_offset = 0;
+  guint i, mem_idx = 0;
+
+  g_return_val_if_fail (cstream, NULL);
+  g_return_val_if_fail (GST_IS_BUFFER (buffer), NULL);
+  g_return_val_if_fail (chunk_size, NULL);
+
+  type = select_chunk_type (cstream, buffer);
+  g_return_val_if_fail (type >= 0, NULL);
+
+  /* The payload slices below are taken from the mapped memories, and must
+   * not run past them */
+  meta = gst_buffer_get_rtmp_meta (buffer);
+  if (meta->size != gst_buffer_get_size (buffer)) {
+    GST_ERROR ("Message size %" G_GUINT32_FORMAT " does not match the size of %"
+        GST_PTR_FORMAT, meta->size, buffer);
+    return NULL;
+  }
+
+  GST_TRACE ("Serializing message %" GST_PTR_FORMAT " into stream %"
+      G_GUINT32_FORMAT, buffer, cstream->id);
+
+  gst_rtmp_buffer_dump (buffer, ">>> message");
+
+  chunk_stream_clear (cstream);
+  chunk_stream_take_buffer (cstream, gst_buffer_ref (buffer));
+  meta = cstream->meta;
+
+  chunks = g_slice_new0 (GstRtmpChunkVectors);
+  chunks->message = gst_buffer_ref (buffer);
+  chunks->maps = g_new0 (GstMapInfo, gst_buffer_n_memory (buffer));
 
-  outbuf = gst_rtmp_chunk_stream_serialize_start (cstream, buffer, chunk_size);
-  nextbuf = gst_rtmp_chunk_stream_serialize_next (cstream, chunk_size);
+  for (i = 0; i < gst_buffer_n_memory (buffer); i++) {
+    GstMemory *mem = gst_buffer_peek_memory (buffer, i);
 
-  while (nextbuf) {
-    outbuf = gst_buffer_append (outbuf, nextbuf);
-    nextbuf = gst_rtmp_chunk_stream_serialize_next (cstream, chunk_size);
+    if (!gst_memory_map (mem, &chunks->maps[i], GST_MAP_READ)) {
+      GST_ERROR ("Failed to map memory %u of %" GST_PTR_FORMAT, i, buffer);
+      gst_rtmp_chunk_vectors_free (chunks);
+      return NULL;
+    }
+    chunks->n_maps++;
   }
 
-  return outbuf;
+  /* A chunk's payload can span two memories */
+  n_chunks = MAX ((meta->size + chunk_size - 1) / chunk_size, 1);
+  chunks->headers = g_malloc (n_chunks * CHUNK_HEADER_MAX_SIZE);
+  chunks->vectors = g_new (GOutputVector, 2 * n_chunks + chunks->n_maps);
+
+  do {
+    gsize header_size;
+    guint32 payload_size;
+
+    header_size = serialize_header (cstream, type,
+        chunks->headers + header_offset);
+    chunk_vectors_append (chunks, chunks->headers + header_offset,
+        header_size);
+    header_offset += header_size;
+
+    payload_size = chunk_stream_next_size (cstream, chunk_size);
+    cstream->offset += payload_size;
+    cstream->bytes += payload_size;
+
+    while (payload_size > 0) {
+      GstMapInfo *map = &chunks->maps[mem_idx];
+      gsize size = MIN (payload_size, map->size - mem_offset);
+
+      if (size > 0)
+        chunk_vectors_append (chunks, map->data + mem_offset, size);
+      payload_size -= size;
+      mem_offset += size;
+
+      /* meta->size was checked against the buffer, this does not overrun */
+      if (mem_offset == map->size) {
+        mem_idx++;
+        mem_offset = 0;
+      }
+    }
+
+    type = CHUNK_TYPE_3;
+  } while (chunk_stream_next_size (cstream, chunk_size) > 0);
+
+  GST_TRACE ("Serialized %" G_GSIZE_FORMAT " bytes in %" G_GUINT32_FORMAT
+      " chunks", chunks->size, n_chunks);
+
+  return chunks;
+}
+
+void
+gst_rtmp_chunk_vectors_free (GstRtmpChunkVectors * chunks)
+{
+  guint i;
+
+  g_return_if_fail (chunks);
+
+  for (i = 0; i < chunks->n_maps; i++)
+    gst_memory_unmap (chunks->maps[i].memory, &chunks->maps[i]);
+
+  g_free (chunks->maps);
+  g_free (chunks->headers);
+  g_free (chunks->vectors);
+  gst_buffer_unref (chunks->message);
+  g_slice_free (GstRtmpChunkVectors, chunks);
 }
 
 GstRtmpChunkStreams *
@@ -21,6 +21,7 @@
 #ifndef _GST_RTMP_CHUNK_STREAM_H_
 #define _GST_RTMP_CHUNK_STREAM_H_
 
+#include <gio/gio.h>
 #include "rtmpmessage.h"
 
 G_BEGIN_DECLS
@@ -30,6 +31,18 @@ G_BEGIN_DECLS
 typedef struct _GstRtmpChunkStream GstRtmpChunkStream;
 typedef struct _GstRtmpChunkStreams GstRtmpChunkStreams;
 
+/* A message serialized into chunks. The vectors point into the headers and
+ * into the mapped memories of the message, and are valid until freed. */
+typedef struct {
+  GstBuffer *message;
+  GstMapInfo *maps;
+  guint n_maps;
+  guint8 *headers;
+  GOutputVector *vectors;
+  gsize n_vectors;
+  gsize size;
+} GstRtmpChunkVectors;
+
 void gst_rtmp_chunk_stream_clear (GstRtmpChunkStream * cstream);
 
 guint32 gst_rtmp_chunk_stream_parse_id (const guint8 * data, gsize size);
@@ -45,8 +58,9 @@ GstBuffer * gst_rtmp_chunk_stream_serialize_start (GstRtmpChunkStream * cstream,
     GstBuffer * buffer, guint32 chunk_size);
 GstBuffer * gst_rtmp_chunk_stream_serialize_next (GstRtmpChunkStream * cstream,
     guint32 chunk_size);
-GstBuffer * gst_rtmp_chunk_stream_serialize_all (GstRtmpChunkStream * cstream,
-    GstBuffer * buffer, guint32 chunk_size);
+GstRtmpChunkVectors * gst_rtmp_chunk_stream_serialize_vectors (
+    GstRtmpChunkStream * cstream, GstBuffer * buffer, guint32 chunk_size);
+void gst_rtmp_chunk_vectors_free (GstRtmpChunkVectors * chunks);
 
 GstRtmpChunkStreams * gst_rtmp_chunk_streams_new (void);
 void gst_rtmp_chunk_streams_free (gpointer ptr);
@@ -110,7 +110,7 @@ static void gst_rtmp_connection_emit_error (GstRtmpConnection * self);
 static gboolean gst_rtmp_connection_input_ready (GInputStream * is,
     gpointer user_data);
 static void gst_rtmp_connection_start_write (GstRtmpConnection * self);
-static void gst_rtmp_connection_write_buffer_done (GObject * obj,
+static void gst_rtmp_connection_write_chunks_done (GObject * obj,
     GAsyncResult * result, gpointer user_data);
 static void gst_rtmp_connection_start_read (GstRtmpConnection * sc,
     guint needed_bytes);
@@ -517,7 +517,8 @@ static void
 gst_rtmp_connection_start_write (GstRtmpConnection * self)
 {
   GOutputStream *os;
-  GstBuffer *message, *chunks;
+  GstBuffer *message;
+  GstRtmpChunkVectors *chunks;
   GstRtmpMeta *meta;
   GstRtmpChunkStream *cstream;
 
@@ -551,7 +552,9 @@ gst_rtmp_connection_start_write (GstRtmpConnection * self)
     goto out;
   }
 
-  chunks = gst_rtmp_chunk_stream_serialize_all (cstream, message,
+  /* The chunks of the message are written at once. The payload is only
+   * copied for streams that cannot write vectors, like TLS ones */
+  chunks = gst_rtmp_chunk_stream_serialize_vectors (cstream, message,
       self->out_chunk_size);
   if (!chunks) {
     GST_ERROR_OBJECT (self, "Failed to serialize %" GST_PTR_FORMAT, message);
@@ -564,12 +567,10 @@ gst_rtmp_connection_start_write (GstRtmpConnection * self)
   }
 
   os = g_io_stream_get_output_stream (G_IO_STREAM (self->connection));
-  gst_rtmp_output_stream_write_all_buffer_async (os, chunks, G_PRIORITY_DEFAULT,
-      self->cancellable, gst_rtmp_connection_write_buffer_done,
+  gst_rtmp_output_stream_write_all_chunks_async (os, chunks, G_PRIORITY_DEFAULT,
+      self->cancellable, gst_rtmp_connection_write_chunks_done,
       g_object_ref (self));
 
-  gst_buffer_unref (chunks);
-
 out:
   gst_buffer_unref (message);
 }
@@ -590,7 +591,7 @@ gst_rtmp_connection_emit_error (GstRtmpConnection * self)
 }
 
 static void
-gst_rtmp_connection_write_buffer_done (GObject * obj,
+gst_rtmp_connection_write_chunks_done (GObject * obj,
     GAsyncResult * result, gpointer user_data)
 {
   GOutputStream *os = G_OUTPUT_STREAM (obj);
@@ -601,7 +602,7 @@ gst_rtmp_connection_write_buffer_done (GObject * obj,
 
   self->writing = FALSE;
 
-  res = gst_rtmp_output_stream_write_all_buffer_finish (os, result,
+  res = gst_rtmp_output_stream_write_all_chunks_finish (os, result,
       &bytes_written, &error);
 
   g_mutex_lock (&self->stats_lock);
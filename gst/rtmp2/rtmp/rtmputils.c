@@ -30,7 +30,7 @@ static void read_all_bytes_done (GObject * source, GAsyncResult * result,
     gpointer user_data);
 static void write_all_bytes_done (GObject * source, GAsyncResult * result,
     gpointer user_data);
-static void write_all_buffer_done (GObject * source, GAsyncResult * result,
+static void write_all_chunks_done (GObject * source, GAsyncResult * result,
     gpointer user_data);
 
 void
@@ -158,75 +158,97 @@ gst_rtmp_output_stream_write_all_bytes_finish (GOutputStream * stream,
 
 typedef struct
 {
-  GstBuffer *buffer;
-  GstMapInfo map;
-  gboolean mapped;
+  GstRtmpChunkVectors *chunks;
+  guint8 *data;                 /* Only set when the chunks were coalesced */
   gsize bytes_written;
-} WriteAllBufferData;
+} WriteAllChunksData;
 
-static WriteAllBufferData *
-write_all_buffer_data_new (GstBuffer * buffer)
+static void
+write_all_chunks_data_free (gpointer ptr)
 {
-  WriteAllBufferData *data = g_slice_new0 (WriteAllBufferData);
-  data->buffer = gst_buffer_ref (buffer);
-  return data;
+  WriteAllChunksData *data = ptr;
+  g_clear_pointer (&data->chunks, gst_rtmp_chunk_vectors_free);
+  g_free (data->data);
+  g_slice_free (WriteAllChunksData, data);
 }
 
-static void
-write_all_buffer_data_free (gpointer ptr)
+#if GLIB_CHECK_VERSION(2,60,0)
+/* Whether @stream implements writev itself, like the socket streams do.
+ * The others, like the TLS streams, get the generic implementation that
+ * writes the vectors one by one, which for TLS means one record per chunk
+ * header and per payload slice. */
+static gboolean
+output_stream_has_native_writev (GOutputStream * stream)
 {
-  WriteAllBufferData *data = ptr;
-  if (data->mapped) {
-    gst_buffer_unmap (data->buffer, &data->map);
-  }
-  g_clear_pointer (&data->buffer, gst_buffer_unref);
-  g_slice_free (WriteAllBufferData, data);
+  GOutputStreamClass *klass = G_OUTPUT_STREAM_GET_CLASS (stream);
+  GOutputStreamClass *base_class = g_type_class_peek (G_TYPE_OUTPUT_STREAM);
+
+  return klass->writev_fn != base_class->writev_fn;
 }
+#endif
 
+/* Takes ownership of @chunks, and writes them with a single vectored write
+ * when the stream supports it. Otherwise they are copied into one buffer
+ * and written at once. */
 void
-gst_rtmp_output_stream_write_all_buffer_async (GOutputStream * stream,
-    GstBuffer * buffer, int io_priority, GCancellable * cancellable,
+gst_rtmp_output_stream_write_all_chunks_async (GOutputStream * stream,
+    GstRtmpChunkVectors * chunks, int io_priority, GCancellable * cancellable,
     GAsyncReadyCallback callback, gpointer user_data)
 {
   GTask *task;
-  WriteAllBufferData *data;
+  WriteAllChunksData *data;
+  gsize i, offset = 0;
 
   g_return_if_fail (G_IS_OUTPUT_STREAM (stream));
-  g_return_if_fail (GST_IS_BUFFER (buffer));
+  g_return_if_fail (chunks);
 
   task = g_task_new (stream, cancellable, callback, user_data);
 
-  data = write_all_buffer_data_new (buffer);
-  g_task_set_task_data (task, data, write_all_buffer_data_free);
+  data = g_slice_new0 (WriteAllChunksData);
+  data->chunks = chunks;
+  g_task_set_task_data (task, data, write_all_chunks_data_free);
 
-  if (!gst_buffer_map (buffer, &data->map, GST_MAP_READ)) {
-    g_task_return_new_error (task, GST_RESOURCE_ERROR, GST_RESOURCE_ERROR_READ,
-        "Failed to map buffer for reading");
-    g_object_unref (task);
+#if GLIB_CHECK_VERSION(2,60,0)
+  if (output_stream_has_native_writev (stream)) {
+    g_output_stream_writev_all_async (stream, chunks->vectors,
+        chunks->n_vectors, io_priority, cancellable, write_all_chunks_done,
+        task);
     return;
   }
+#endif
 
-  data->mapped = TRUE;
+  data->data = g_malloc (chunks->size);
+  for (i = 0; i < chunks->n_vectors; i++) {
+    memcpy (data->data + offset, chunks->vectors[i].buffer,
+        chunks->vectors[i].size);
+    offset += chunks->vectors[i].size;
+  }
 
-  g_output_stream_write_all_async (stream, data->map.data, data->map.size,
-      io_priority, cancellable, write_all_buffer_done, task);
+  g_output_stream_write_all_async (stream, data->data, chunks->size,
+      io_priority, cancellable, write_all_chunks_done, task);
 }
 
 static void
-write_all_buffer_done (GObject * source, GAsyncResult * result,
+write_all_chunks_done (GObject * source, GAsyncResult * result,
     gpointer user_data)
 {
   GOutputStream *os = G_OUTPUT_STREAM (source);
   GTask *task = user_data;
-  WriteAllBufferData *data = g_task_get_task_data (task);
+  WriteAllChunksData *data = g_task_get_task_data (task);
   GError *error = NULL;
   gboolean res;
 
-  res = g_output_stream_write_all_finish (os, result, &data->bytes_written,
-      &error);
+#if GLIB_CHECK_VERSION(2,60,0)
+  if (!data->data)
+    res = g_output_stream_writev_all_finish (os, result, &data->bytes_written,
+        &error);
+  else
+#endif
+    res = g_output_stream_write_all_finish (os, result, &data->bytes_written,
+        &error);
 
-  gst_buffer_unmap (data->buffer, &data->map);
-  data->mapped = FALSE;
+  /* The message is no longer needed */
+  g_clear_pointer (&data->chunks, gst_rtmp_chunk_vectors_free);
 
   if (!res) {
     g_task_return_error (task, error);
@@ -238,12 +260,11 @@ write_all_buffer_done (GObject * source, GAsyncResult * result,
   g_object_unref (task);
 }
 
-
 gboolean
-gst_rtmp_output_stream_write_all_buffer_finish (GOutputStream * stream,
+gst_rtmp_output_stream_write_all_chunks_finish (GOutputStream * stream,
     GAsyncResult * result, gsize * bytes_written, GError ** error)
 {
-  WriteAllBufferData *data;
+  WriteAllChunksData *data;
   GTask *task;
 
   g_return_val_if_fail (g_task_is_valid (result, stream), FALSE);
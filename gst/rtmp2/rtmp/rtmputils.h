@@ -23,6 +23,7 @@
 #include <gst/gst.h>
 #include <gio/gio.h>
 #include "rtmpmessage.h"
+#include "rtmpchunkstream.h"
 
 G_BEGIN_DECLS
 
@@ -40,10 +41,10 @@ void gst_rtmp_output_stream_write_all_bytes_async (GOutputStream * stream,
 gboolean gst_rtmp_output_stream_write_all_bytes_finish (GOutputStream * stream,
     GAsyncResult * result, GError ** error);
 
-void gst_rtmp_output_stream_write_all_buffer_async (GOutputStream * stream,
-    GstBuffer * buffer, int io_priority, GCancellable * cancellable,
+void gst_rtmp_output_stream_write_all_chunks_async (GOutputStream * stream,
+    GstRtmpChunkVectors * chunks, int io_priority, GCancellable * cancellable,
     GAsyncReadyCallback callback, gpointer user_data);
-gboolean gst_rtmp_output_stream_write_all_buffer_finish (GOutputStream * stream,
+gboolean gst_rtmp_output_stream_write_all_chunks_finish (GOutputStream * stream,
     GAsyncResult * result, gsize * bytes_written, GError ** error);
 
 void gst_rtmp_string_print_escaped (GString * string, const gchar * data,
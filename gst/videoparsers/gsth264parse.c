@@ -39,14 +39,38 @@ GST_DEBUG_CATEGORY (h264_parse_debug);
 
 #define DEFAULT_CONFIG_INTERVAL      (0)
 #define DEFAULT_UPDATE_TIMECODE       FALSE
+#define DEFAULT_PARSE_LEVEL           GST_H264_PARSE_LEVEL_FULL
 
 enum
 {
   PROP_0,
   PROP_CONFIG_INTERVAL,
   PROP_UPDATE_TIMECODE,
+  PROP_PARSE_LEVEL,
 };
 
+GType
+gst_h264_parse_level_get_type (void)
+{
+  static GType parse_level_type = 0;
+
+  if (g_once_init_enter (&parse_level_type)) {
+    GType type;
+    static const GEnumValue parse_levels[] = {
+      {GST_H264_PARSE_LEVEL_FULL, "Parse all headers and SEI messages", "full"},
+      {GST_H264_PARSE_LEVEL_MINIMAL,
+          "Only parse what is needed for frame boundaries and keyframes",
+          "minimal"},
+      {0, NULL, NULL},
+    };
+
+    type = g_enum_register_static ("GstH264ParseLevel", parse_levels);
+    g_once_init_leave (&parse_level_type, type);
+  }
+
+  return parse_level_type;
+}
+
 enum
 {
   GST_H264_PARSE_FORMAT_NONE,
@@ -173,6 +197,25 @@ gst_h264_parse_class_init (GstH264ParseClass * klass)
           "VUI and pic_struct_present_flag of VUI must be non-zero",
           DEFAULT_UPDATE_TIMECODE, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
+  /**
+   * GstH264Parse:parse-level:
+   *
+   * How much of the bitstream to parse. In minimal mode, only the first
+   * syntax elements of slice headers are read to find access unit boundaries
+   * and keyframes, repeated parameter sets are not parsed again and only
+   * the picture timing and recovery point SEI messages are handled. Use this
+   * when downstream does not need any of the other SEI derived metadata
+   * (closed captions, stereo video information, ...), e.g. when only
+   * remuxing the stream.
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (gobject_class, PROP_PARSE_LEVEL,
+      g_param_spec_enum ("parse-level", "Parse Level",
+          "How much of the bitstream to parse",
+          GST_TYPE_H264_PARSE_LEVEL, DEFAULT_PARSE_LEVEL,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
   /* Override BaseParse vfuncs */
   parse_class->start = GST_DEBUG_FUNCPTR (gst_h264_parse_start);
   parse_class->stop = GST_DEBUG_FUNCPTR (gst_h264_parse_stop);
@@ -191,12 +234,15 @@ gst_h264_parse_class_init (GstH264ParseClass * klass)
       "Codec/Parser/Converter/Video",
       "Parses H.264 streams",
       "Mark Nauwelaerts <mark.nauwelaerts@collabora.co.uk>");
+
+  gst_type_mark_as_plugin_api (GST_TYPE_H264_PARSE_LEVEL, 0);
 }
 
 static void
 gst_h264_parse_init (GstH264Parse * h264parse)
 {
   h264parse->frame_out = gst_adapter_new ();
+  h264parse->parse_level = DEFAULT_PARSE_LEVEL;
   gst_base_parse_set_pts_interpolation (GST_BASE_PARSE (h264parse), FALSE);
   gst_base_parse_set_infer_ts (GST_BASE_PARSE (h264parse), FALSE);
   GST_PAD_SET_ACCEPT_INTERSECT (GST_BASE_PARSE_SINK_PAD (h264parse));
@@ -605,15 +651,27 @@ gst_h264_parse_process_sei_user_data (GstH264Parse * h264parse,
 
 }
 
+static const guint minimal_sei_types[] = {
+  GST_H264_SEI_PIC_TIMING, GST_H264_SEI_RECOVERY_POINT
+};
+
 static void
 gst_h264_parse_process_sei (GstH264Parse * h264parse, GstH264NalUnit * nalu)
 {
+  gboolean minimal = h264parse->parse_level == GST_H264_PARSE_LEVEL_MINIMAL;
   GstH264SEIMessage sei;
   GstH264NalParser *nalparser = h264parse->nalparser;
   GstH264ParserResult pres;
   GArray *messages;
   guint i;
 
+  /* In minimal mode, only the messages needed for the timestamps and the
+   * keyframe flags are handled, don't even parse SEI NAL units without any */
+  if (minimal && !gst_video_parse_sei_has_payload_type (nalu->data +
+          nalu->offset + nalu->header_bytes, nalu->size - nalu->header_bytes,
+          minimal_sei_types, G_N_ELEMENTS (minimal_sei_types)))
+    return;
+
   pres = gst_h264_parser_parse_sei (nalparser, nalu, &messages);
   if (pres != GST_H264_PARSER_OK)
     GST_WARNING_OBJECT (h264parse, "failed to parse one or more SEI message");
@@ -623,6 +681,10 @@ gst_h264_parse_process_sei (GstH264Parse * h264parse, GstH264NalUnit * nalu)
    */
   for (i = 0; i < messages->len; i++) {
     sei = g_array_index (messages, GstH264SEIMessage, i);
+    if (minimal && sei.payloadType != GST_H264_SEI_PIC_TIMING &&
+        sei.payloadType != GST_H264_SEI_RECOVERY_POINT)
+      continue;
+
     switch (sei.payloadType) {
       case GST_H264_SEI_PIC_TIMING:
       {
@@ -925,6 +987,85 @@ gst_h264_parse_process_sei (GstH264Parse * h264parse, GstH264NalUnit * nalu)
   g_array_free (messages, TRUE);
 }
 
+/* Returns TRUE and sets @id if @nalu is an exact copy of one of the
+ * parameter sets in @store, which means there is no need to parse it again */
+static gboolean
+gst_h264_parse_find_stored_nal (GstBuffer ** store, guint store_size,
+    GstH264NalUnit * nalu, guint * id)
+{
+  guint i;
+
+  for (i = 0; i < store_size; i++) {
+    if (store[i] && gst_buffer_get_size (store[i]) == nalu->size &&
+        gst_buffer_memcmp (store[i], 0, nalu->data + nalu->offset,
+            nalu->size) == 0) {
+      *id = i;
+      return TRUE;
+    }
+  }
+
+  return FALSE;
+}
+
+/* Only parses the slice header up to field_pic_flag, which is all that is
+ * needed for frame boundaries, keyframes and field based durations.
+ * Everything past that is left zeroed in @slice */
+static GstH264ParserResult
+gst_h264_parse_parse_slice_hdr_minimal (GstH264Parse * h264parse,
+    GstH264NalUnit * nalu, GstH264SliceHdr * slice)
+{
+  GstH264NalParser *nalparser = h264parse->nalparser;
+  GstBitReader br;
+  GstH264PPS *pps;
+  GstH264SPS *sps;
+  guint8 data[16];
+  guint32 pps_id;
+  guint size;
+
+  memset (slice, 0, sizeof (*slice));
+
+  size = gst_video_parse_unescape_nal_prefix (nalu->data + nalu->offset +
+      nalu->header_bytes, nalu->size - nalu->header_bytes, data,
+      sizeof (data));
+  gst_bit_reader_init (&br, data, size);
+
+  if (!gst_video_parse_get_ue (&br, &slice->first_mb_in_slice) ||
+      !gst_video_parse_get_ue (&br, &slice->type) ||
+      !gst_video_parse_get_ue (&br, &pps_id) ||
+      pps_id >= GST_H264_MAX_PPS_COUNT)
+    return GST_H264_PARSER_ERROR;
+
+  pps = &nalparser->pps[pps_id];
+  if (!pps->valid || !pps->sequence) {
+    GST_WARNING_OBJECT (h264parse, "couldn't find PPS with id %u", pps_id);
+    return GST_H264_PARSER_BROKEN_LINK;
+  }
+
+  sps = pps->sequence;
+  if (sps->extension_type && sps->extension_type != GST_H264_NAL_EXTENSION_MVC)
+    return GST_H264_PARSER_BROKEN_DATA;
+
+  slice->pps = pps;
+
+  if (sps->separate_colour_plane_flag &&
+      !gst_bit_reader_get_bits_uint8 (&br, &slice->colour_plane_id, 2))
+    return GST_H264_PARSER_ERROR;
+
+  if (!gst_bit_reader_get_bits_uint16 (&br, &slice->frame_num,
+          sps->log2_max_frame_num_minus4 + 4))
+    return GST_H264_PARSER_ERROR;
+
+  if (!sps->frame_mbs_only_flag) {
+    if (!gst_bit_reader_get_bits_uint8 (&br, &slice->field_pic_flag, 1))
+      return GST_H264_PARSER_ERROR;
+    if (slice->field_pic_flag &&
+        !gst_bit_reader_get_bits_uint8 (&br, &slice->bottom_field_flag, 1))
+      return GST_H264_PARSER_ERROR;
+  }
+
+  return GST_H264_PARSER_OK;
+}
+
 /* caller guarantees 2 bytes of nal payload */
 static gboolean
 gst_h264_parse_process_nal (GstH264Parse * h264parse, GstH264NalUnit * nalu)
@@ -935,6 +1076,9 @@ gst_h264_parse_process_nal (GstH264Parse * h264parse, GstH264NalUnit * nalu)
   GstH264NalParser *nalparser = h264parse->nalparser;
   GstH264ParserResult pres;
   GstH264SliceHdr slice;
+  gboolean minimal = h264parse->parse_level == GST_H264_PARSE_LEVEL_MINIMAL;
+  gboolean unchanged = FALSE;
+  guint id;
 
   /* nothing to do for broken input */
   if (G_UNLIKELY (nalu->size < 2)) {
@@ -958,7 +1102,16 @@ gst_h264_parse_process_nal (GstH264Parse * h264parse, GstH264NalUnit * nalu)
     case GST_H264_NAL_SPS:
       /* reset state, everything else is obsolete */
       h264parse->state &= GST_H264_PARSE_STATE_GOT_PPS;
-      pres = gst_h264_parser_parse_sps (nalparser, nalu, &sps);
+
+      if (minimal && gst_h264_parse_find_stored_nal (h264parse->sps_nals,
+              GST_H264_MAX_SPS_COUNT, nalu, &id) && nalparser->sps[id].valid) {
+        GST_LOG_OBJECT (h264parse, "SPS %u unchanged, not parsing", id);
+        nalparser->last_sps = &nalparser->sps[id];
+        unchanged = TRUE;
+        pres = GST_H264_PARSER_OK;
+      } else {
+        pres = gst_h264_parser_parse_sps (nalparser, nalu, &sps);
+      }
 
     process_sps:
       /* arranged for a fallback sps.id, so use that one and only warn */
@@ -969,8 +1122,10 @@ gst_h264_parse_process_nal (GstH264Parse * h264parse, GstH264NalUnit * nalu)
         return FALSE;
       }
 
-      GST_DEBUG_OBJECT (h264parse, "triggering src caps check");
-      h264parse->update_caps = TRUE;
+      if (!unchanged) {
+        GST_DEBUG_OBJECT (h264parse, "triggering src caps check");
+        h264parse->update_caps = TRUE;
+      }
       h264parse->have_sps = TRUE;
       h264parse->have_sps_in_frame = TRUE;
       if (h264parse->push_codec && h264parse->have_pps) {
@@ -982,8 +1137,10 @@ gst_h264_parse_process_nal (GstH264Parse * h264parse, GstH264NalUnit * nalu)
         h264parse->have_pps = FALSE;
       }
 
-      gst_h264_parser_store_nal (h264parse, sps.id, nal_type, nalu);
-      gst_h264_sps_clear (&sps);
+      if (!unchanged) {
+        gst_h264_parser_store_nal (h264parse, sps.id, nal_type, nalu);
+        gst_h264_sps_clear (&sps);
+      }
       h264parse->state |= GST_H264_PARSE_STATE_GOT_SPS;
       h264parse->header = TRUE;
       break;
@@ -993,7 +1150,15 @@ gst_h264_parse_process_nal (GstH264Parse * h264parse, GstH264NalUnit * nalu)
       if (!GST_H264_PARSE_STATE_VALID (h264parse, GST_H264_PARSE_STATE_GOT_SPS))
         return FALSE;
 
-      pres = gst_h264_parser_parse_pps (nalparser, nalu, &pps);
+      if (minimal && gst_h264_parse_find_stored_nal (h264parse->pps_nals,
+              GST_H264_MAX_PPS_COUNT, nalu, &id) && nalparser->pps[id].valid) {
+        GST_LOG_OBJECT (h264parse, "PPS %u unchanged, not parsing", id);
+        nalparser->last_pps = &nalparser->pps[id];
+        unchanged = TRUE;
+        pres = GST_H264_PARSER_OK;
+      } else {
+        pres = gst_h264_parser_parse_pps (nalparser, nalu, &pps);
+      }
       /* arranged for a fallback pps.id, so use that one and only warn */
       if (pres != GST_H264_PARSER_OK) {
         GST_WARNING_OBJECT (h264parse, "failed to parse PPS:");
@@ -1017,8 +1182,10 @@ gst_h264_parse_process_nal (GstH264Parse * h264parse, GstH264NalUnit * nalu)
         h264parse->have_pps = FALSE;
       }
 
-      gst_h264_parser_store_nal (h264parse, pps.id, nal_type, nalu);
-      gst_h264_pps_clear (&pps);
+      if (!unchanged) {
+        gst_h264_parser_store_nal (h264parse, pps.id, nal_type, nalu);
+        gst_h264_pps_clear (&pps);
+      }
       h264parse->state |= GST_H264_PARSE_STATE_GOT_PPS;
       h264parse->header = TRUE;
       break;
@@ -1067,8 +1234,11 @@ gst_h264_parse_process_nal (GstH264Parse * h264parse, GstH264NalUnit * nalu)
       if (nal_type == GST_H264_NAL_SLICE_EXT && !GST_H264_IS_MVC_NALU (nalu))
         break;
 
-      pres = gst_h264_parser_parse_slice_hdr (nalparser, nalu, &slice,
-          FALSE, FALSE);
+      if (minimal)
+        pres = gst_h264_parse_parse_slice_hdr_minimal (h264parse, nalu, &slice);
+      else
+        pres = gst_h264_parser_parse_slice_hdr (nalparser, nalu, &slice,
+            FALSE, FALSE);
       GST_DEBUG_OBJECT (h264parse,
           "parse result %d, first MB: %u, slice type: %u",
           pres, slice.first_mb_in_slice, slice.type);
@@ -3767,6 +3937,9 @@ gst_h264_parse_set_property (GObject * object, guint prop_id,
     case PROP_UPDATE_TIMECODE:
       parse->update_timecode = g_value_get_boolean (value);
       break;
+    case PROP_PARSE_LEVEL:
+      parse->parse_level = g_value_get_enum (value);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -3788,6 +3961,9 @@ gst_h264_parse_get_property (GObject * object, guint prop_id,
     case PROP_UPDATE_TIMECODE:
       g_value_set_boolean (value, parse->update_timecode);
       break;
+    case PROP_PARSE_LEVEL:
+      g_value_set_enum (value, parse->parse_level);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
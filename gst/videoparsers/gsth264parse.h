@@ -48,6 +48,24 @@ typedef struct _H264Params H264Params;
 
 GType gst_h264_parse_get_type (void);
 
+/**
+ * GstH264ParseLevel:
+ * @GST_H264_PARSE_LEVEL_FULL: parse all parameter sets, SEI messages and
+ *   slice headers
+ * @GST_H264_PARSE_LEVEL_MINIMAL: only parse what is needed to find access
+ *   unit boundaries and keyframes, and parameter sets when they change
+ *
+ * Since: 1.20
+ */
+typedef enum
+{
+  GST_H264_PARSE_LEVEL_FULL,
+  GST_H264_PARSE_LEVEL_MINIMAL
+} GstH264ParseLevel;
+
+#define GST_TYPE_H264_PARSE_LEVEL (gst_h264_parse_level_get_type ())
+GType gst_h264_parse_level_get_type (void);
+
 typedef struct _GstH264Parse GstH264Parse;
 typedef struct _GstH264ParseClass GstH264ParseClass;
 
@@ -137,6 +155,7 @@ struct _GstH264Parse
   /* props */
   gint interval;
   gboolean update_timecode;
+  GstH264ParseLevel parse_level;
 
   GstClockTime pending_key_unit_ts;
   GstEvent *force_key_unit_event;
@@ -33,13 +33,37 @@ GST_DEBUG_CATEGORY (h265_parse_debug);
 #define GST_CAT_DEFAULT h265_parse_debug
 
 #define DEFAULT_CONFIG_INTERVAL      (0)
+#define DEFAULT_PARSE_LEVEL           GST_H265_PARSE_LEVEL_FULL
 
 enum
 {
   PROP_0,
-  PROP_CONFIG_INTERVAL
+  PROP_CONFIG_INTERVAL,
+  PROP_PARSE_LEVEL
 };
 
+GType
+gst_h265_parse_level_get_type (void)
+{
+  static GType parse_level_type = 0;
+
+  if (g_once_init_enter (&parse_level_type)) {
+    GType type;
+    static const GEnumValue parse_levels[] = {
+      {GST_H265_PARSE_LEVEL_FULL, "Parse all headers and SEI messages", "full"},
+      {GST_H265_PARSE_LEVEL_MINIMAL,
+          "Only parse what is needed for frame boundaries and keyframes",
+          "minimal"},
+      {0, NULL, NULL},
+    };
+
+    type = g_enum_register_static ("GstH265ParseLevel", parse_levels);
+    g_once_init_leave (&parse_level_type, type);
+  }
+
+  return parse_level_type;
+}
+
 enum
 {
   GST_H265_PARSE_FORMAT_NONE,
@@ -143,6 +167,25 @@ gst_h265_parse_class_init (GstH265ParseClass * klass)
           "(0 = disabled, -1 = send with every IDR frame)",
           -1, 3600, DEFAULT_CONFIG_INTERVAL,
           G_PARAM_READWRITE | G_PARAM_CONSTRUCT | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstH265Parse:parse-level:
+   *
+   * How much of the bitstream to parse. In minimal mode, only the first
+   * syntax elements of slice headers are read to find access unit boundaries
+   * and keyframes, repeated parameter sets are not parsed again and only
+   * the picture timing and recovery point SEI messages are handled. Use this
+   * when downstream does not need any of the other SEI derived metadata
+   * (closed captions, HDR metadata, ...), e.g. when only remuxing the stream.
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (gobject_class, PROP_PARSE_LEVEL,
+      g_param_spec_enum ("parse-level", "Parse Level",
+          "How much of the bitstream to parse",
+          GST_TYPE_H265_PARSE_LEVEL, DEFAULT_PARSE_LEVEL,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
   /* Override BaseParse vfuncs */
   parse_class->start = GST_DEBUG_FUNCPTR (gst_h265_parse_start);
   parse_class->stop = GST_DEBUG_FUNCPTR (gst_h265_parse_stop);
@@ -161,12 +204,15 @@ gst_h265_parse_class_init (GstH265ParseClass * klass)
       "Codec/Parser/Converter/Video",
       "Parses H.265 streams",
       "Sreerenj Balachandran <sreerenj.balachandran@intel.com>");
+
+  gst_type_mark_as_plugin_api (GST_TYPE_H265_PARSE_LEVEL, 0);
 }
 
 static void
 gst_h265_parse_init (GstH265Parse * h265parse)
 {
   h265parse->frame_out = gst_adapter_new ();
+  h265parse->parse_level = DEFAULT_PARSE_LEVEL;
   gst_base_parse_set_pts_interpolation (GST_BASE_PARSE (h265parse), FALSE);
   gst_base_parse_set_infer_ts (GST_BASE_PARSE (h265parse), FALSE);
   GST_PAD_SET_ACCEPT_INTERSECT (GST_BASE_PARSE_SINK_PAD (h265parse));
@@ -544,15 +590,27 @@ _nal_name (GstH265NalUnitType nal_type)
 }
 #endif
 
+static const guint minimal_sei_types[] = {
+  GST_H265_SEI_PIC_TIMING, GST_H265_SEI_RECOVERY_POINT
+};
+
 static void
 gst_h265_parse_process_sei (GstH265Parse * h265parse, GstH265NalUnit * nalu)
 {
+  gboolean minimal = h265parse->parse_level == GST_H265_PARSE_LEVEL_MINIMAL;
   GstH265SEIMessage sei;
   GstH265Parser *nalparser = h265parse->nalparser;
   GstH265ParserResult pres;
   GArray *messages;
   guint i;
 
+  /* In minimal mode, only the messages needed for the timestamps and the
+   * keyframe flags are handled, don't even parse SEI NAL units without any */
+  if (minimal && !gst_video_parse_sei_has_payload_type (nalu->data +
+          nalu->offset + nalu->header_bytes, nalu->size - nalu->header_bytes,
+          minimal_sei_types, G_N_ELEMENTS (minimal_sei_types)))
+    return;
+
   pres = gst_h265_parser_parse_sei (nalparser, nalu, &messages);
   if (pres != GST_H265_PARSER_OK)
     GST_WARNING_OBJECT (h265parse, "failed to parse one or more SEI message");
@@ -562,6 +620,10 @@ gst_h265_parse_process_sei (GstH265Parse * h265parse, GstH265NalUnit * nalu)
    */
   for (i = 0; i < messages->len; i++) {
     sei = g_array_index (messages, GstH265SEIMessage, i);
+    if (minimal && sei.payloadType != GST_H265_SEI_PIC_TIMING &&
+        sei.payloadType != GST_H265_SEI_RECOVERY_POINT)
+      continue;
+
     switch (sei.payloadType) {
       case GST_H265_SEI_RECOVERY_POINT:
         GST_LOG_OBJECT (h265parse, "recovery point found: %u %u %u",
@@ -709,6 +771,92 @@ gst_h265_parse_process_sei_user_data (GstH265Parse * h265parse,
 
 }
 
+/* Returns TRUE and sets @id if @nalu is an exact copy of one of the
+ * parameter sets in @store, which means there is no need to parse it again */
+static gboolean
+gst_h265_parse_find_stored_nal (GstBuffer ** store, guint store_size,
+    GstH265NalUnit * nalu, guint * id)
+{
+  guint i;
+
+  for (i = 0; i < store_size; i++) {
+    if (store[i] && gst_buffer_get_size (store[i]) == nalu->size &&
+        gst_buffer_memcmp (store[i], 0, nalu->data + nalu->offset,
+            nalu->size) == 0) {
+      *id = i;
+      return TRUE;
+    }
+  }
+
+  return FALSE;
+}
+
+/* Only parses the slice segment header up to slice_type, which is all that
+ * is needed for frame boundaries and keyframes. Everything past that is left
+ * zeroed in @slice */
+static GstH265ParserResult
+gst_h265_parse_parse_slice_hdr_minimal (GstH265Parse * h265parse,
+    GstH265NalUnit * nalu, GstH265SliceHdr * slice)
+{
+  GstH265Parser *nalparser = h265parse->nalparser;
+  GstBitReader br;
+  GstH265PPS *pps;
+  guint8 data[16];
+  guint32 pps_id, type;
+  guint size;
+
+  memset (slice, 0, sizeof (*slice));
+
+  size = gst_video_parse_unescape_nal_prefix (nalu->data + nalu->offset +
+      nalu->header_bytes, nalu->size - nalu->header_bytes, data,
+      sizeof (data));
+  gst_bit_reader_init (&br, data, size);
+
+  if (!gst_bit_reader_get_bits_uint8 (&br,
+          &slice->first_slice_segment_in_pic_flag, 1))
+    return GST_H265_PARSER_ERROR;
+
+  if (GST_H265_IS_NAL_TYPE_IRAP (nalu->type) &&
+      !gst_bit_reader_get_bits_uint8 (&br,
+          &slice->no_output_of_prior_pics_flag, 1))
+    return GST_H265_PARSER_ERROR;
+
+  if (!gst_video_parse_get_ue (&br, &pps_id) ||
+      pps_id >= GST_H265_MAX_PPS_COUNT)
+    return GST_H265_PARSER_ERROR;
+
+  pps = &nalparser->pps[pps_id];
+  if (!pps->valid || !pps->sps) {
+    GST_WARNING_OBJECT (h265parse, "couldn't find PPS with id %u", pps_id);
+    return GST_H265_PARSER_BROKEN_LINK;
+  }
+
+  slice->pps = pps;
+
+  if (!slice->first_slice_segment_in_pic_flag) {
+    guint32 pic_size_in_ctbs = pps->PicWidthInCtbsY * pps->PicHeightInCtbsY;
+
+    if (pps->dependent_slice_segments_enabled_flag &&
+        !gst_bit_reader_get_bits_uint8 (&br,
+            &slice->dependent_slice_segment_flag, 1))
+      return GST_H265_PARSER_ERROR;
+
+    /* Ceil (Log2 (PicSizeInCtbsY)) bits */
+    if (!gst_bit_reader_get_bits_uint32 (&br, &slice->segment_address,
+            g_bit_storage (pic_size_in_ctbs - 1)))
+      return GST_H265_PARSER_ERROR;
+  }
+
+  if (!slice->dependent_slice_segment_flag) {
+    if (!gst_bit_reader_skip (&br, pps->num_extra_slice_header_bits) ||
+        !gst_video_parse_get_ue (&br, &type) || type > 63)
+      return GST_H265_PARSER_ERROR;
+    slice->type = type;
+  }
+
+  return GST_H265_PARSER_OK;
+}
+
 /* caller guarantees 2 bytes of nal payload */
 static gboolean
 gst_h265_parse_process_nal (GstH265Parse * h265parse, GstH265NalUnit * nalu)
@@ -719,6 +867,9 @@ gst_h265_parse_process_nal (GstH265Parse * h265parse, GstH265NalUnit * nalu)
   guint nal_type;
   GstH265Parser *nalparser = h265parse->nalparser;
   GstH265ParserResult pres = GST_H265_PARSER_ERROR;
+  gboolean minimal = h265parse->parse_level == GST_H265_PARSE_LEVEL_MINIMAL;
+  gboolean unchanged = FALSE;
+  guint id;
 
   /* nothing to do for broken input */
   if (G_UNLIKELY (nalu->size < 2)) {
@@ -735,14 +886,23 @@ gst_h265_parse_process_nal (GstH265Parse * h265parse, GstH265NalUnit * nalu)
     case GST_H265_NAL_VPS:
       /* It is not mandatory to have VPS in the stream. But it might
        * be needed for other extensions like svc */
-      pres = gst_h265_parser_parse_vps (nalparser, nalu, &vps);
-      if (pres != GST_H265_PARSER_OK) {
-        GST_WARNING_OBJECT (h265parse, "failed to parse VPS");
-        return FALSE;
+      if (minimal && gst_h265_parse_find_stored_nal (h265parse->vps_nals,
+              GST_H265_MAX_VPS_COUNT, nalu, &id) && nalparser->vps[id].valid) {
+        GST_LOG_OBJECT (h265parse, "VPS %u unchanged, not parsing", id);
+        nalparser->last_vps = &nalparser->vps[id];
+        unchanged = TRUE;
+      } else {
+        pres = gst_h265_parser_parse_vps (nalparser, nalu, &vps);
+        if (pres != GST_H265_PARSER_OK) {
+          GST_WARNING_OBJECT (h265parse, "failed to parse VPS");
+          return FALSE;
+        }
       }
 
-      GST_DEBUG_OBJECT (h265parse, "triggering src caps check");
-      h265parse->update_caps = TRUE;
+      if (!unchanged) {
+        GST_DEBUG_OBJECT (h265parse, "triggering src caps check");
+        h265parse->update_caps = TRUE;
+      }
       h265parse->have_vps = TRUE;
       h265parse->have_vps_in_frame = TRUE;
       if (h265parse->push_codec && h265parse->have_pps) {
@@ -755,15 +915,23 @@ gst_h265_parse_process_nal (GstH265Parse * h265parse, GstH265NalUnit * nalu)
         h265parse->have_pps = FALSE;
       }
 
-      gst_h265_parser_store_nal (h265parse, vps.id, nal_type, nalu);
+      if (!unchanged)
+        gst_h265_parser_store_nal (h265parse, vps.id, nal_type, nalu);
       h265parse->header = TRUE;
       break;
     case GST_H265_NAL_SPS:
       /* reset state, everything else is obsolete */
       h265parse->state &= GST_H265_PARSE_STATE_GOT_PPS;
 
-      pres = gst_h265_parser_parse_sps (nalparser, nalu, &sps, TRUE);
-
+      if (minimal && gst_h265_parse_find_stored_nal (h265parse->sps_nals,
+              GST_H265_MAX_SPS_COUNT, nalu, &id) && nalparser->sps[id].valid) {
+        GST_LOG_OBJECT (h265parse, "SPS %u unchanged, not parsing", id);
+        nalparser->last_sps = &nalparser->sps[id];
+        unchanged = TRUE;
+        pres = GST_H265_PARSER_OK;
+      } else {
+        pres = gst_h265_parser_parse_sps (nalparser, nalu, &sps, TRUE);
+      }
 
       /* arranged for a fallback sps.id, so use that one and only warn */
       if (pres != GST_H265_PARSER_OK) {
@@ -779,8 +947,10 @@ gst_h265_parse_process_nal (GstH265Parse * h265parse, GstH265NalUnit * nalu)
             "failed to parse VUI of SPS, ignore VUI");
       }
 
-      GST_DEBUG_OBJECT (h265parse, "triggering src caps check");
-      h265parse->update_caps = TRUE;
+      if (!unchanged) {
+        GST_DEBUG_OBJECT (h265parse, "triggering src caps check");
+        h265parse->update_caps = TRUE;
+      }
       h265parse->have_sps = TRUE;
       h265parse->have_sps_in_frame = TRUE;
       if (h265parse->push_codec && h265parse->have_pps) {
@@ -792,7 +962,8 @@ gst_h265_parse_process_nal (GstH265Parse * h265parse, GstH265NalUnit * nalu)
         h265parse->have_pps = FALSE;
       }
 
-      gst_h265_parser_store_nal (h265parse, sps.id, nal_type, nalu);
+      if (!unchanged)
+        gst_h265_parser_store_nal (h265parse, sps.id, nal_type, nalu);
       h265parse->header = TRUE;
       h265parse->state |= GST_H265_PARSE_STATE_GOT_SPS;
       break;
@@ -802,8 +973,15 @@ gst_h265_parse_process_nal (GstH265Parse * h265parse, GstH265NalUnit * nalu)
       if (!GST_H265_PARSE_STATE_VALID (h265parse, GST_H265_PARSE_STATE_GOT_SPS))
         return FALSE;
 
-      pres = gst_h265_parser_parse_pps (nalparser, nalu, &pps);
-
+      if (minimal && gst_h265_parse_find_stored_nal (h265parse->pps_nals,
+              GST_H265_MAX_PPS_COUNT, nalu, &id) && nalparser->pps[id].valid) {
+        GST_LOG_OBJECT (h265parse, "PPS %u unchanged, not parsing", id);
+        nalparser->last_pps = &nalparser->pps[id];
+        unchanged = TRUE;
+        pres = GST_H265_PARSER_OK;
+      } else {
+        pres = gst_h265_parser_parse_pps (nalparser, nalu, &pps);
+      }
 
       /* arranged for a fallback pps.id, so use that one and only warn */
       if (pres != GST_H265_PARSER_OK) {
@@ -828,7 +1006,8 @@ gst_h265_parse_process_nal (GstH265Parse * h265parse, GstH265NalUnit * nalu)
         h265parse->have_pps = FALSE;
       }
 
-      gst_h265_parser_store_nal (h265parse, pps.id, nal_type, nalu);
+      if (!unchanged)
+        gst_h265_parser_store_nal (h265parse, pps.id, nal_type, nalu);
       h265parse->header = TRUE;
       h265parse->state |= GST_H265_PARSE_STATE_GOT_PPS;
       break;
@@ -884,7 +1063,10 @@ gst_h265_parse_process_nal (GstH265Parse * h265parse, GstH265NalUnit * nalu)
        * AU is complete. This is used to keep track of AU */
       h265parse->picture_start = TRUE;
 
-      pres = gst_h265_parser_parse_slice_hdr (nalparser, nalu, &slice);
+      if (minimal)
+        pres = gst_h265_parse_parse_slice_hdr_minimal (h265parse, nalu, &slice);
+      else
+        pres = gst_h265_parser_parse_slice_hdr (nalparser, nalu, &slice);
 
       if (pres == GST_H265_PARSER_OK) {
         if (GST_H265_IS_I_SLICE (&slice))
@@ -3378,6 +3560,9 @@ gst_h265_parse_set_property (GObject * object, guint prop_id,
     case PROP_CONFIG_INTERVAL:
       parse->interval = g_value_get_int (value);
       break;
+    case PROP_PARSE_LEVEL:
+      parse->parse_level = g_value_get_enum (value);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -3395,6 +3580,9 @@ gst_h265_parse_get_property (GObject * object, guint prop_id, GValue * value,
     case PROP_CONFIG_INTERVAL:
       g_value_set_int (value, parse->interval);
       break;
+    case PROP_PARSE_LEVEL:
+      g_value_set_enum (value, parse->parse_level);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
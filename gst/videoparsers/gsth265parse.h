@@ -42,6 +42,24 @@ G_BEGIN_DECLS
 
 GType gst_h265_parse_get_type (void);
 
+/**
+ * GstH265ParseLevel:
+ * @GST_H265_PARSE_LEVEL_FULL: parse all parameter sets, SEI messages and
+ *   slice headers
+ * @GST_H265_PARSE_LEVEL_MINIMAL: only parse what is needed to find access
+ *   unit boundaries and keyframes, and parameter sets when they change
+ *
+ * Since: 1.20
+ */
+typedef enum
+{
+  GST_H265_PARSE_LEVEL_FULL,
+  GST_H265_PARSE_LEVEL_MINIMAL
+} GstH265ParseLevel;
+
+#define GST_TYPE_H265_PARSE_LEVEL (gst_h265_parse_level_get_type ())
+GType gst_h265_parse_level_get_type (void);
+
 typedef struct _GstH265Parse GstH265Parse;
 typedef struct _GstH265ParseClass GstH265ParseClass;
 
@@ -118,6 +136,7 @@ struct _GstH265Parse
 
   /* props */
   gint interval;
+  GstH265ParseLevel parse_level;
 
   GstClockTime pending_key_unit_ts;
   GstEvent *force_key_unit_event;
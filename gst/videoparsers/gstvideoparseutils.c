@@ -436,3 +436,128 @@ gst_video_parse_utils_parse_afd (const guint8 data, GstVideoAFD * afd,
   afd->afd = (GstVideoAFDValue) afd_data;
   return TRUE;
 }
+
+/*
+ * gst_video_parse_unescape_nal_prefix:
+ * @data: H.264/H.265 NAL unit payload
+ * @size: size of @data
+ * @dest: destination array
+ * @dest_size: size of @dest
+ *
+ * Copy at most @dest_size bytes from the start of @data to @dest, removing
+ * emulation prevention bytes on the way, so that the first syntax elements
+ * of a header can be read without going through the full codec parser.
+ *
+ * Returns: the number of bytes written to @dest
+ */
+guint
+gst_video_parse_unescape_nal_prefix (const guint8 * data, guint size,
+    guint8 * dest, guint dest_size)
+{
+  guint i, n = 0, zeros = 0;
+
+  for (i = 0; i < size && n < dest_size; i++) {
+    if (zeros >= 2 && data[i] == 0x03) {
+      zeros = 0;
+      continue;
+    }
+
+    zeros = data[i] == 0x00 ? zeros + 1 : 0;
+    dest[n++] = data[i];
+  }
+
+  return n;
+}
+
+/*
+ * gst_video_parse_get_ue:
+ * @br: #GstBitReader
+ * @value: location of the parsed value
+ *
+ * Read an unsigned Exp-Golomb coded value.
+ *
+ * Returns: TRUE if parsing was successful, otherwise FALSE
+ */
+gboolean
+gst_video_parse_get_ue (GstBitReader * br, guint32 * value)
+{
+  guint leading_zeros = 0;
+  guint32 suffix = 0;
+  guint8 bit;
+
+  while (TRUE) {
+    if (!gst_bit_reader_get_bits_uint8 (br, &bit, 1))
+      return FALSE;
+    if (bit)
+      break;
+    if (++leading_zeros > 31)
+      return FALSE;
+  }
+
+  if (leading_zeros > 0 &&
+      !gst_bit_reader_get_bits_uint32 (br, &suffix, leading_zeros))
+    return FALSE;
+
+  *value = (1U << leading_zeros) - 1 + suffix;
+  return TRUE;
+}
+
+/*
+ * gst_video_parse_sei_has_payload_type:
+ * @data: H.264/H.265 SEI RBSP, after the NAL unit header
+ * @size: size of @data
+ * @types: payload types to look for
+ * @n_types: number of entries in @types
+ *
+ * Walk the payloadType/payloadSize headers of the SEI messages in @data,
+ * skipping emulation prevention bytes, without parsing the payloads.
+ *
+ * Returns: TRUE if one of the messages has one of @types as payload type,
+ * or if the SEI is malformed and the caller should leave the decision to
+ * the full parser
+ */
+gboolean
+gst_video_parse_sei_has_payload_type (const guint8 * data, guint size,
+    const guint * types, guint n_types)
+{
+  guint pos = 0, zeros = 0;
+
+#define NEXT_BYTE(b) G_STMT_START {                           \
+    if (pos < size && zeros >= 2 && data[pos] == 0x03) {      \
+      pos++;                                                  \
+      zeros = 0;                                              \
+    }                                                         \
+    if (pos >= size)                                          \
+      return TRUE;                                            \
+    b = data[pos++];                                          \
+    zeros = b == 0x00 ? zeros + 1 : 0;                        \
+  } G_STMT_END
+
+  /* stop at the rbsp_trailing_bits */
+  while (pos + 1 < size) {
+    guint payload_type = 0, payload_size = 0, i;
+    guint8 b;
+
+    do {
+      NEXT_BYTE (b);
+      payload_type += b;
+    } while (b == 0xff);
+
+    do {
+      NEXT_BYTE (b);
+      payload_size += b;
+    } while (b == 0xff);
+
+    for (i = 0; i < n_types; i++) {
+      if (types[i] == payload_type)
+        return TRUE;
+    }
+
+    for (i = 0; i < payload_size; i++)
+      NEXT_BYTE (b);
+  }
+
+#undef NEXT_BYTE
+
+  return FALSE;
+}
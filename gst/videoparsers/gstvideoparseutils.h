@@ -24,6 +24,7 @@
 #include <gst/gst.h>
 #include <gst/base/gstbaseparse.h>
 #include <gst/base/gstbytereader.h>
+#include <gst/base/gstbitreader.h>
 #include <gst/video/video-anc.h>
 
 #define GST_VIDEO_BAR_MAX_BYTES 9
@@ -182,5 +183,13 @@ void gst_video_parse_user_data(GstElement * elt, GstVideoParseUserData * user_da
 void gst_video_push_user_data(GstElement * elt, GstVideoParseUserData * user_data,
 			 GstBuffer * buf);
 
+guint gst_video_parse_unescape_nal_prefix(const guint8 * data, guint size,
+			guint8 * dest, guint dest_size);
+
+gboolean gst_video_parse_get_ue(GstBitReader * br, guint32 * value);
+
+gboolean gst_video_parse_sei_has_payload_type(const guint8 * data, guint size,
+			const guint * types, guint n_types);
+
 G_END_DECLS
 #endif /* __VIDEO_PARSE_UTILS_H__ */
@@ -33,16 +33,26 @@
 #endif
 #include <errno.h>
 #include <string.h>
+#include <glib/gstdio.h>
 #include <gst/base/gstbytewriter.h>
 #include <gst/gstprotection.h>
 #include "gstipcpipelinecomm.h"
 
+#ifdef G_OS_UNIX
+#  include <limits.h>
+#  include <sys/types.h>
+#  include <sys/stat.h>
+#  include <sys/socket.h>
+#  include <sys/uio.h>
+#endif
+
 GST_DEBUG_CATEGORY_STATIC (gst_ipc_pipeline_comm_debug);
 #define GST_CAT_DEFAULT gst_ipc_pipeline_comm_debug
 
 #define DEFAULT_ACK_TIME (10 * G_TIME_SPAN_SECOND)
 
 GQuark QUARK_ID;
+static GQuark QUARK_RELEASE;
 
 typedef enum
 {
@@ -192,6 +202,10 @@ gst_ipc_pipeline_comm_data_type_get_name (GstIpcPipelineCommDataType type)
       return "MESSAGE";
     case GST_IPC_PIPELINE_COMM_DATA_TYPE_GERROR_MESSAGE:
       return "GERROR_MESSAGE";
+    case GST_IPC_PIPELINE_COMM_DATA_TYPE_FD_BUFFER:
+      return "FD_BUFFER";
+    case GST_IPC_PIPELINE_COMM_DATA_TYPE_RELEASE:
+      return "RELEASE";
     default:
       return "UNKNOWN";
   }
@@ -503,26 +517,323 @@ typedef struct
   guint64 flags;
 } CommBufferMetadata;
 
-GstFlowReturn
-gst_ipc_pipeline_comm_write_buffer_to_fd (GstIpcPipelineComm * comm,
-    GstBuffer * buffer)
+/* How a memory of a FD_BUFFER chunk is transported */
+typedef enum
+{
+  COMM_MEMORY_INLINE = 0,
+  COMM_MEMORY_FD = 1,
+} CommMemoryKind;
+
+/* Bytes written for each memory of a FD_BUFFER chunk, not counting the
+ * data of inline memories */
+#define COMM_MEMORY_INLINE_HEADER_SIZE (1 + 4)
+#define COMM_MEMORY_FD_HEADER_SIZE (1 + 8 + 8 + 8)
+
+/* Maximum number of fds passed in a single message */
+#define COMM_MAX_FDS 64
+
+/* One vectored write: the chunk headers are accumulated in the byte writer
+ * and interleaved with the mapped memories of the buffers being sent */
+typedef struct
+{
+  const guint8 *data;           /* NULL for bytes from the byte writer */
+  gsize offset;
+  gsize size;
+} CommWriteVector;
+
+typedef struct
 {
-  const unsigned char payload_type = GST_IPC_PIPELINE_COMM_DATA_TYPE_BUFFER;
+  GstMemory *memory;
   GstMapInfo map;
-  guint32 ret32 = GST_FLOW_OK;
-  guint32 size, n;
-  CommBufferMetadata meta;
-  GstFlowReturn ret;
-  MetaListRepresentation repr = { comm, 0, 4, NULL };   /* starts a 4 for n_meta */
+} CommMappedMemory;
+
+typedef struct
+{
   GstByteWriter bw;
+  guint bw_offset;
+  GArray *vectors;              /* CommWriteVector */
+  GArray *maps;                 /* CommMappedMemory */
+  GArray *fds;                  /* gint */
+} CommWriteBatch;
 
-  g_mutex_lock (&comm->mutex);
-  ++comm->send_id;
+static void
+comm_write_batch_init (CommWriteBatch * batch)
+{
+  gst_byte_writer_init (&batch->bw);
+  batch->bw_offset = 0;
+  batch->vectors = g_array_new (FALSE, FALSE, sizeof (CommWriteVector));
+  batch->maps = g_array_new (FALSE, FALSE, sizeof (CommMappedMemory));
+  batch->fds = g_array_new (FALSE, FALSE, sizeof (gint));
+}
 
-  GST_TRACE_OBJECT (comm->element, "Writing buffer %u: %" GST_PTR_FORMAT,
-      comm->send_id, buffer);
+static void
+comm_write_batch_clear (CommWriteBatch * batch)
+{
+  guint n;
 
-  gst_byte_writer_init (&bw);
+  for (n = 0; n < batch->maps->len; n++) {
+    CommMappedMemory *m = &g_array_index (batch->maps, CommMappedMemory, n);
+    gst_memory_unmap (m->memory, &m->map);
+  }
+  g_array_free (batch->vectors, TRUE);
+  g_array_free (batch->maps, TRUE);
+  g_array_free (batch->fds, TRUE);
+  gst_byte_writer_reset (&batch->bw);
+}
+
+/* Ends the vector of bytes written in the byte writer so far */
+static void
+comm_write_batch_end_header (CommWriteBatch * batch)
+{
+  guint size = gst_byte_writer_get_size (&batch->bw);
+
+  if (size > batch->bw_offset) {
+    CommWriteVector v = { NULL, batch->bw_offset, size - batch->bw_offset };
+
+    g_array_append_val (batch->vectors, v);
+    batch->bw_offset = size;
+  }
+}
+
+static gboolean
+comm_write_batch_add_memory (CommWriteBatch * batch, GstMemory * memory)
+{
+  CommMappedMemory m;
+  CommWriteVector v;
+
+  if (!gst_memory_map (memory, &m.map, GST_MAP_READ))
+    return FALSE;
+  m.memory = memory;
+  g_array_append_val (batch->maps, m);
+
+  comm_write_batch_end_header (batch);
+  if (m.map.size > 0) {
+    v.data = m.map.data;
+    v.offset = 0;
+    v.size = m.map.size;
+    g_array_append_val (batch->vectors, v);
+  }
+  return TRUE;
+}
+
+#ifdef G_OS_UNIX
+#ifdef IOV_MAX
+#define COMM_MAX_IOV MIN (IOV_MAX, 1024)
+#else
+#define COMM_MAX_IOV 16
+#endif
+
+static gboolean
+writev_to_fd (GstIpcPipelineComm * comm, struct iovec *iov, guint n_iov,
+    const gint * fds, guint n_fds)
+{
+  GST_TRACE_OBJECT (comm->element, "Writing %u vectors and %u fds to fdout",
+      n_iov, n_fds);
+
+  while (n_iov > 0) {
+    ssize_t written;
+
+    if (n_fds > 0) {
+      gchar control[CMSG_SPACE (sizeof (gint) * COMM_MAX_FDS)];
+      struct msghdr msg = { 0, };
+      struct cmsghdr *cmsg;
+
+      memset (control, 0, sizeof (control));
+      msg.msg_iov = iov;
+      msg.msg_iovlen = MIN (n_iov, COMM_MAX_IOV);
+      msg.msg_control = control;
+      msg.msg_controllen = CMSG_SPACE (sizeof (gint) * n_fds);
+      cmsg = CMSG_FIRSTHDR (&msg);
+      cmsg->cmsg_level = SOL_SOCKET;
+      cmsg->cmsg_type = SCM_RIGHTS;
+      cmsg->cmsg_len = CMSG_LEN (sizeof (gint) * n_fds);
+      memcpy (CMSG_DATA (cmsg), fds, sizeof (gint) * n_fds);
+
+      written = sendmsg (comm->fdout, &msg, 0);
+    } else {
+      written = writev (comm->fdout, iov, MIN (n_iov, COMM_MAX_IOV));
+    }
+
+    if (written < 0) {
+      if (errno == EAGAIN || errno == EINTR)
+        continue;
+      GST_ERROR_OBJECT (comm->element, "Failed to write to fd: %s",
+          strerror (errno));
+      return FALSE;
+    }
+
+    /* the fds went along with the first byte */
+    n_fds = 0;
+
+    while (n_iov > 0 && (gsize) written >= iov->iov_len) {
+      written -= iov->iov_len;
+      iov++;
+      n_iov--;
+    }
+    if (written > 0) {
+      iov->iov_base = (guint8 *) iov->iov_base + written;
+      iov->iov_len -= written;
+    }
+  }
+
+  return TRUE;
+}
+#endif
+
+static gboolean
+write_batch_to_fd (GstIpcPipelineComm * comm, CommWriteBatch * batch)
+{
+  guint8 *header_data;
+  gboolean ret = TRUE;
+  guint n;
+
+  comm_write_batch_end_header (batch);
+  header_data = gst_byte_writer_reset_and_get_data (&batch->bw);
+  batch->bw_offset = 0;
+
+#ifdef G_OS_UNIX
+  {
+    struct iovec *iov = g_new (struct iovec, batch->vectors->len);
+
+    for (n = 0; n < batch->vectors->len; n++) {
+      CommWriteVector *v = &g_array_index (batch->vectors, CommWriteVector, n);
+
+      iov[n].iov_base = (void *) (v->data ? v->data : header_data + v->offset);
+      iov[n].iov_len = v->size;
+    }
+    ret = writev_to_fd (comm, iov, batch->vectors->len,
+        (const gint *) batch->fds->data, batch->fds->len);
+    g_free (iov);
+  }
+#else
+  for (n = 0; ret && n < batch->vectors->len; n++) {
+    CommWriteVector *v = &g_array_index (batch->vectors, CommWriteVector, n);
+
+    ret = write_to_fd_raw (comm, v->data ? v->data : header_data + v->offset,
+        v->size);
+  }
+#endif
+
+  g_free (header_data);
+  return ret;
+}
+
+/* Only UNIX domain sockets can carry file descriptors, fdout can as well
+ * be a pipe or a TCP socket */
+static gboolean
+comm_fd_is_unix_socket (gint fd)
+{
+#ifdef G_OS_UNIX
+  struct sockaddr_storage addr;
+  socklen_t addr_len = sizeof (addr);
+  struct stat st;
+
+  if (fd < 0 || fstat (fd, &st) != 0 || !S_ISSOCK (st.st_mode))
+    return FALSE;
+
+  memset (&addr, 0, sizeof (addr));
+  if (getsockname (fd, (struct sockaddr *) &addr, &addr_len) != 0)
+    return FALSE;
+
+  return addr.ss_family == AF_UNIX;
+#else
+  return FALSE;
+#endif
+}
+
+/* Returns the number of memories of @buffer that can be sent as fds */
+static guint
+comm_count_fd_memories (GstIpcPipelineComm * comm, GstBuffer * buffer)
+{
+  guint n, n_memories, n_fds = 0;
+
+  if (!comm->fd_passing)
+    return 0;
+
+  if (comm->fdout != comm->fdout_checked) {
+    comm->fdout_is_unix_socket = comm_fd_is_unix_socket (comm->fdout);
+    comm->fdout_checked = comm->fdout;
+    if (!comm->fdout_is_unix_socket)
+      GST_WARNING_OBJECT (comm->element, "fdout %d is not a UNIX socket, "
+          "cannot pass file descriptors", comm->fdout);
+  }
+  if (!comm->fdout_is_unix_socket)
+    return 0;
+
+  n_memories = gst_buffer_n_memory (buffer);
+  for (n = 0; n < n_memories; n++) {
+    if (gst_is_fd_memory (gst_buffer_peek_memory (buffer, n)))
+      n_fds++;
+  }
+  return n_fds;
+}
+
+static void
+meta_list_representation_clear (MetaListRepresentation * repr)
+{
+  guint32 n;
+
+  for (n = 0; n < repr->n_meta; ++n)
+    g_free (repr->info[n].str);
+  g_free (repr->info);
+}
+
+static gboolean
+write_meta_list (GstByteWriter * bw, const MetaListRepresentation * repr)
+{
+  guint32 n;
+
+  if (!gst_byte_writer_put_uint32_le (bw, repr->n_meta))
+    return FALSE;
+  for (n = 0; n < repr->n_meta; ++n) {
+    const MetaBuildInfo *info = repr->info + n;
+    guint32 len;
+    const char *s;
+
+    if (!gst_byte_writer_put_uint32_le (bw, info->bytes))
+      return FALSE;
+
+    if (!gst_byte_writer_put_uint32_le (bw, info->flags))
+      return FALSE;
+
+    s = g_type_name (info->api);
+    len = strlen (s) + 1;
+    if (!gst_byte_writer_put_uint32_le (bw, len))
+      return FALSE;
+    if (!gst_byte_writer_put_data (bw, (const guint8 *) s, len))
+      return FALSE;
+
+    if (!gst_byte_writer_put_uint64_le (bw, info->size))
+      return FALSE;
+
+    s = info->str;
+    len = s ? (strlen (s) + 1) : 0;
+    if (!gst_byte_writer_put_uint32_le (bw, len))
+      return FALSE;
+    if (len)
+      if (!gst_byte_writer_put_data (bw, (const guint8 *) s, len))
+        return FALSE;
+  }
+
+  return TRUE;
+}
+
+/* Serializes @buffer as a BUFFER chunk, or as a FD_BUFFER chunk if some of
+ * its memories are passed as fds. The memories are not copied, they are
+ * mapped and written directly from where they are. */
+static gboolean
+gst_ipc_pipeline_comm_add_buffer_to_batch (GstIpcPipelineComm * comm,
+    CommWriteBatch * batch, GstBuffer * buffer, guint32 id, gboolean pass_fds,
+    gboolean * map_failed)
+{
+  MetaListRepresentation repr = { comm, 0, 4, NULL };   /* starts a 4 for n_meta */
+  CommBufferMetadata meta;
+  guint n, n_memories;
+  guint32 size;
+  gboolean ret = FALSE;
+
+  GST_TRACE_OBJECT (comm->element, "Writing buffer %u: %" GST_PTR_FORMAT,
+      id, buffer);
 
   meta.pts = GST_BUFFER_PTS (buffer);
   meta.dts = GST_BUFFER_DTS (buffer);
@@ -534,78 +845,205 @@ gst_ipc_pipeline_comm_write_buffer_to_fd (GstIpcPipelineComm * comm,
   /* work out meta size */
   gst_buffer_foreach_meta (buffer, build_meta, &repr);
 
-  if (!gst_byte_writer_put_uint8 (&bw, payload_type))
-    goto write_failed;
-  if (!gst_byte_writer_put_uint32_le (&bw, comm->send_id))
-    goto write_failed;
-  size =
-      gst_buffer_get_size (buffer) + sizeof (guint32) +
-      sizeof (CommBufferMetadata) + repr.total_bytes;
-  if (!gst_byte_writer_put_uint32_le (&bw, size))
-    goto write_failed;
-  if (!gst_byte_writer_put_data (&bw, (const guint8 *) &meta, sizeof (meta)))
-    goto write_failed;
-  size = gst_buffer_get_size (buffer);
-  if (!gst_byte_writer_put_uint32_le (&bw, size))
-    goto write_failed;
-  if (!write_byte_writer_to_fd (comm, &bw))
-    goto write_failed;
+  n_memories = gst_buffer_n_memory (buffer);
 
-  if (!gst_buffer_map (buffer, &map, GST_MAP_READ))
-    goto map_failed;
-  ret = write_to_fd_raw (comm, map.data, map.size);
-  gst_buffer_unmap (buffer, &map);
-  if (!ret)
-    goto write_failed;
+  if (!gst_byte_writer_put_uint8 (&batch->bw, pass_fds ?
+          GST_IPC_PIPELINE_COMM_DATA_TYPE_FD_BUFFER :
+          GST_IPC_PIPELINE_COMM_DATA_TYPE_BUFFER))
+    goto done;
+  if (!gst_byte_writer_put_uint32_le (&batch->bw, id))
+    goto done;
 
-  /* meta */
-  gst_byte_writer_init (&bw);
-  if (!gst_byte_writer_put_uint32_le (&bw, repr.n_meta))
-    goto write_failed;
-  for (n = 0; n < repr.n_meta; ++n) {
-    const MetaBuildInfo *info = repr.info + n;
-    guint32 len;
-    const char *s;
+  if (pass_fds) {
+    size = sizeof (CommBufferMetadata) + sizeof (guint32) + repr.total_bytes;
+    for (n = 0; n < n_memories; n++) {
+      GstMemory *mem = gst_buffer_peek_memory (buffer, n);
 
-    if (!gst_byte_writer_put_uint32_le (&bw, info->bytes))
-      goto write_failed;
+      if (gst_is_fd_memory (mem))
+        size += COMM_MEMORY_FD_HEADER_SIZE;
+      else
+        size += COMM_MEMORY_INLINE_HEADER_SIZE + mem->size;
+    }
+  } else {
+    size =
+        gst_buffer_get_size (buffer) + sizeof (guint32) +
+        sizeof (CommBufferMetadata) + repr.total_bytes;
+  }
+  if (!gst_byte_writer_put_uint32_le (&batch->bw, size))
+    goto done;
+  if (!gst_byte_writer_put_data (&batch->bw, (const guint8 *) &meta,
+          sizeof (meta)))
+    goto done;
 
-    if (!gst_byte_writer_put_uint32_le (&bw, info->flags))
-      goto write_failed;
+  if (pass_fds) {
+    if (!gst_byte_writer_put_uint32_le (&batch->bw, n_memories))
+      goto done;
+    for (n = 0; n < n_memories; n++) {
+      GstMemory *mem = gst_buffer_peek_memory (buffer, n);
+      gsize offset, maxsize;
 
-    s = g_type_name (info->api);
-    len = strlen (s) + 1;
-    if (!gst_byte_writer_put_uint32_le (&bw, len))
-      goto write_failed;
-    if (!gst_byte_writer_put_data (&bw, (const guint8 *) s, len))
-      goto write_failed;
+      if (gst_is_fd_memory (mem)) {
+        gint fd = gst_fd_memory_get_fd (mem);
 
-    if (!gst_byte_writer_put_uint64_le (&bw, info->size))
-      goto write_failed;
+        gst_memory_get_sizes (mem, &offset, &maxsize);
+        if (!gst_byte_writer_put_uint8 (&batch->bw, COMM_MEMORY_FD))
+          goto done;
+        if (!gst_byte_writer_put_uint64_le (&batch->bw, offset))
+          goto done;
+        if (!gst_byte_writer_put_uint64_le (&batch->bw, mem->size))
+          goto done;
+        if (!gst_byte_writer_put_uint64_le (&batch->bw, maxsize))
+          goto done;
+        g_array_append_val (batch->fds, fd);
+      } else {
+        if (!gst_byte_writer_put_uint8 (&batch->bw, COMM_MEMORY_INLINE))
+          goto done;
+        if (!gst_byte_writer_put_uint32_le (&batch->bw, mem->size))
+          goto done;
+        if (!comm_write_batch_add_memory (batch, mem)) {
+          *map_failed = TRUE;
+          goto done;
+        }
+      }
+    }
 
-    s = info->str;
-    len = s ? (strlen (s) + 1) : 0;
-    if (!gst_byte_writer_put_uint32_le (&bw, len))
-      goto write_failed;
-    if (len)
-      if (!gst_byte_writer_put_data (&bw, (const guint8 *) s, len))
+    /* the peer maps the memory in place, it must not be reused before the
+     * peer is done with it */
+    g_hash_table_insert (comm->sent_buffers, GINT_TO_POINTER (id),
+        gst_buffer_ref (buffer));
+  } else {
+    size = gst_buffer_get_size (buffer);
+    if (!gst_byte_writer_put_uint32_le (&batch->bw, size))
+      goto done;
+    for (n = 0; n < n_memories; n++) {
+      if (!comm_write_batch_add_memory (batch,
+              gst_buffer_peek_memory (buffer, n))) {
+        *map_failed = TRUE;
+        goto done;
+      }
+    }
+  }
+
+  ret = write_meta_list (&batch->bw, &repr);
+
+done:
+  meta_list_representation_clear (&repr);
+  return ret;
+}
+
+/* Collects the results of the buffers in flight, waiting for the oldest
+ * ones until no more than @max_inflight are left. The first failure is kept
+ * until it can be returned upstream. */
+static void
+gst_ipc_pipeline_comm_wait_inflight (GstIpcPipelineComm * comm,
+    guint max_inflight)
+{
+  while (!g_queue_is_empty (&comm->inflight)) {
+    gpointer key = g_queue_peek_head (&comm->inflight);
+    CommRequest *req = g_hash_table_lookup (comm->inflight_waiting_ids, key);
+
+    if (req && !req->replied) {
+      if (g_queue_get_length (&comm->inflight) <= max_inflight)
+        break;
+      comm_request_wait (comm, req, ACK_TYPE_BLOCKING);
+    }
+
+    g_queue_pop_head (&comm->inflight);
+    if (req) {
+      if (req->ret != GST_FLOW_OK && comm->inflight_ret == GST_FLOW_OK)
+        comm->inflight_ret = (GstFlowReturn) req->ret;
+      g_hash_table_remove (comm->inflight_waiting_ids, key);
+    }
+  }
+}
+
+/* Drops the buffers in flight without waiting for their ack, only to be
+ * called while not streaming */
+void
+gst_ipc_pipeline_comm_reset_inflight (GstIpcPipelineComm * comm)
+{
+  g_mutex_lock (&comm->mutex);
+  while (!g_queue_is_empty (&comm->inflight))
+    g_hash_table_remove (comm->inflight_waiting_ids,
+        g_queue_pop_head (&comm->inflight));
+  g_clear_pointer (&comm->inflight_waiting_ids, g_hash_table_unref);
+  comm->inflight_ret = GST_FLOW_OK;
+  g_mutex_unlock (&comm->mutex);
+}
+
+/* Registers a request for the ack of buffer @id, without waiting for it */
+static void
+gst_ipc_pipeline_comm_add_inflight (GstIpcPipelineComm * comm, guint32 id)
+{
+  CommRequest *req;
+
+  if (comm->inflight_waiting_ids != comm->waiting_ids) {
+    /* the requests left in the old table were all cancelled, this does not
+     * block and only collects their result */
+    gst_ipc_pipeline_comm_wait_inflight (comm, 0);
+    if (comm->inflight_waiting_ids)
+      g_hash_table_unref (comm->inflight_waiting_ids);
+    comm->inflight_waiting_ids = g_hash_table_ref (comm->waiting_ids);
+  }
+
+  req = comm_request_new (id, COMM_REQUEST_TYPE_BUFFER, NULL);
+  g_hash_table_insert (comm->inflight_waiting_ids, GINT_TO_POINTER (id), req);
+  g_queue_push_tail (&comm->inflight, GINT_TO_POINTER (id));
+}
+
+static GstFlowReturn
+gst_ipc_pipeline_comm_write_buffers_to_fd (GstIpcPipelineComm * comm,
+    GstBuffer * buffer, GstBufferList * list)
+{
+  CommWriteBatch batch;
+  guint n, n_buffers;
+  guint32 first_id, id;
+  gboolean map_failed = FALSE;
+  GstFlowReturn ret;
+
+  n_buffers = list ? gst_buffer_list_length (list) : 1;
+  if (n_buffers == 0)
+    return GST_FLOW_OK;
+
+  g_mutex_lock (&comm->mutex);
+
+  comm_write_batch_init (&batch);
+  first_id = comm->send_id + 1;
+
+  for (n = 0; n < n_buffers; n++) {
+    GstBuffer *buf = list ? gst_buffer_list_get (list, n) : buffer;
+    guint n_fds = comm_count_fd_memories (comm, buf);
+
+    if (batch.fds->len + n_fds > COMM_MAX_FDS) {
+      if (!write_batch_to_fd (comm, &batch))
         goto write_failed;
+      comm_write_batch_clear (&batch);
+      comm_write_batch_init (&batch);
+    }
+
+    if (!gst_ipc_pipeline_comm_add_buffer_to_batch (comm, &batch, buf,
+            ++comm->send_id, n_fds > 0, &map_failed)) {
+      if (map_failed)
+        goto map_failed;
+      goto write_failed;
+    }
   }
 
-  if (!write_byte_writer_to_fd (comm, &bw))
+  if (!write_batch_to_fd (comm, &batch))
     goto write_failed;
 
-  if (!gst_ipc_pipeline_comm_sync_fd (comm, comm->send_id, NULL, &ret32,
-          ACK_TYPE_BLOCKING, COMM_REQUEST_TYPE_BUFFER))
-    goto wait_failed;
-  ret = ret32;
+  /* the peer only replies once the buffers are pushed, wait for the oldest
+   * ones until no more than window-size are left in flight */
+  for (id = first_id; id != comm->send_id + 1; id++)
+    gst_ipc_pipeline_comm_add_inflight (comm, id);
+  gst_ipc_pipeline_comm_wait_inflight (comm, comm->window_size);
+
+  ret = comm->inflight_ret;
+  comm->inflight_ret = GST_FLOW_OK;
 
 done:
   g_mutex_unlock (&comm->mutex);
-  gst_byte_writer_reset (&bw);
-  for (n = 0; n < repr.n_meta; ++n)
-    g_free (repr.info[n].str);
-  g_free (repr.info);
+  comm_write_batch_clear (&batch);
   return ret;
 
 write_failed:
@@ -614,12 +1052,6 @@ write_failed:
   ret = GST_FLOW_COMM_ERROR;
   goto done;
 
-wait_failed:
-  GST_ELEMENT_ERROR (comm->element, RESOURCE, WRITE, (NULL),
-      ("Failed to wait for reply on socket"));
-  ret = GST_FLOW_COMM_ERROR;
-  goto done;
-
 map_failed:
   GST_ELEMENT_ERROR (comm->element, RESOURCE, READ, (NULL),
       ("Failed to map buffer"));
@@ -627,55 +1059,73 @@ map_failed:
   goto done;
 }
 
-static GstBuffer *
-gst_ipc_pipeline_comm_read_buffer (GstIpcPipelineComm * comm, guint32 size)
+GstFlowReturn
+gst_ipc_pipeline_comm_write_buffer_to_fd (GstIpcPipelineComm * comm,
+    GstBuffer * buffer)
 {
-  GstBuffer *buffer;
-  CommBufferMetadata meta;
-  guint32 n_meta, n;
-  const guint8 *payload = NULL;
-  guint32 mapped_size, buffer_data_size;
+  return gst_ipc_pipeline_comm_write_buffers_to_fd (comm, buffer, NULL);
+}
 
-  /* this should not be called if we don't have enough yet */
-  g_return_val_if_fail (gst_adapter_available (comm->adapter) >= size, NULL);
-  g_return_val_if_fail (size >= sizeof (CommBufferMetadata), NULL);
+GstFlowReturn
+gst_ipc_pipeline_comm_write_buffer_list_to_fd (GstIpcPipelineComm * comm,
+    GstBufferList * list)
+{
+  return gst_ipc_pipeline_comm_write_buffers_to_fd (comm, NULL, list);
+}
 
-  mapped_size = sizeof (CommBufferMetadata) + sizeof (buffer_data_size);
-  payload = gst_adapter_map (comm->adapter, mapped_size);
-  if (!payload)
-    return NULL;
-  memcpy (&meta, payload, sizeof (CommBufferMetadata));
-  payload += sizeof (CommBufferMetadata);
-  memcpy (&buffer_data_size, payload, sizeof (buffer_data_size));
-  size -= mapped_size;
-  gst_adapter_unmap (comm->adapter);
-  gst_adapter_flush (comm->adapter, mapped_size);
+static void
+gst_ipc_pipeline_comm_write_release_to_fd (GstIpcPipelineComm * comm,
+    guint32 id)
+{
+  const unsigned char payload_type = GST_IPC_PIPELINE_COMM_DATA_TYPE_RELEASE;
+  GstByteWriter bw;
 
-  if (buffer_data_size == 0) {
-    buffer = gst_buffer_new ();
-  } else {
-    buffer = gst_adapter_get_buffer (comm->adapter, buffer_data_size);
-    gst_adapter_flush (comm->adapter, buffer_data_size);
-  }
-  size -= buffer_data_size;
+  g_mutex_lock (&comm->mutex);
+
+  GST_TRACE_OBJECT (comm->element, "Writing RELEASE for %u", id);
+  gst_byte_writer_init (&bw);
+  if (comm->fdout < 0 || !gst_byte_writer_put_uint8 (&bw, payload_type) ||
+      !gst_byte_writer_put_uint32_le (&bw, id) ||
+      !gst_byte_writer_put_uint32_le (&bw, 0) ||
+      !write_byte_writer_to_fd (comm, &bw))
+    GST_DEBUG_OBJECT (comm->element, "Could not release buffer %u", id);
+
+  g_mutex_unlock (&comm->mutex);
+  gst_byte_writer_reset (&bw);
+}
+
+/* Shared by the fd memories of a received buffer, the peer is told it can
+ * reuse them once they are all freed. This keeps the element alive, and
+ * the comm mutex must not be held when dropping such a buffer. */
+typedef struct
+{
+  GstElement *element;
+  GstIpcPipelineComm *comm;
+  guint32 id;
+  gint refcount;
+} CommReleaseData;
+
+static void
+comm_release_data_unref (CommReleaseData * release)
+{
+  if (!g_atomic_int_dec_and_test (&release->refcount))
+    return;
 
-  GST_BUFFER_PTS (buffer) = meta.pts;
-  GST_BUFFER_DTS (buffer) = meta.dts;
-  GST_BUFFER_DURATION (buffer) = meta.duration;
-  GST_BUFFER_OFFSET (buffer) = meta.offset;
-  GST_BUFFER_OFFSET_END (buffer) = meta.offset_end;
-  GST_BUFFER_FLAGS (buffer) = meta.flags;
+  gst_ipc_pipeline_comm_write_release_to_fd (release->comm, release->id);
+  gst_object_unref (release->element);
+  g_free (release);
+}
+
+static gboolean
+gst_ipc_pipeline_comm_read_meta_list (GstIpcPipelineComm * comm,
+    GstBuffer * buffer, const guint8 * payload)
+{
+  guint32 n_meta, n;
 
   /* If you don't call that, the GType isn't yet known at the
      g_type_from_name below */
   gst_protection_meta_get_info ();
 
-  mapped_size = size;
-  payload = gst_adapter_map (comm->adapter, mapped_size);
-  if (!payload) {
-    gst_buffer_unref (buffer);
-    return NULL;
-  }
   memcpy (&n_meta, payload, sizeof (n_meta));
   payload += sizeof (n_meta);
 
@@ -721,12 +1171,187 @@ gst_ipc_pipeline_comm_read_buffer (GstIpcPipelineComm * comm, guint32 size)
 
   }
 
+  return TRUE;
+}
+
+static void
+gst_ipc_pipeline_comm_set_buffer_metadata (GstBuffer * buffer,
+    const CommBufferMetadata * meta)
+{
+  GST_BUFFER_PTS (buffer) = meta->pts;
+  GST_BUFFER_DTS (buffer) = meta->dts;
+  GST_BUFFER_DURATION (buffer) = meta->duration;
+  GST_BUFFER_OFFSET (buffer) = meta->offset;
+  GST_BUFFER_OFFSET_END (buffer) = meta->offset_end;
+  GST_BUFFER_FLAGS (buffer) = meta->flags;
+}
+
+static GstBuffer *
+gst_ipc_pipeline_comm_read_buffer (GstIpcPipelineComm * comm, guint32 size)
+{
+  GstBuffer *buffer;
+  CommBufferMetadata meta;
+  const guint8 *payload = NULL;
+  guint32 mapped_size, buffer_data_size;
+
+  /* this should not be called if we don't have enough yet */
+  g_return_val_if_fail (gst_adapter_available (comm->adapter) >= size, NULL);
+  g_return_val_if_fail (size >= sizeof (CommBufferMetadata), NULL);
+
+  mapped_size = sizeof (CommBufferMetadata) + sizeof (buffer_data_size);
+  payload = gst_adapter_map (comm->adapter, mapped_size);
+  if (!payload)
+    return NULL;
+  memcpy (&meta, payload, sizeof (CommBufferMetadata));
+  payload += sizeof (CommBufferMetadata);
+  memcpy (&buffer_data_size, payload, sizeof (buffer_data_size));
+  size -= mapped_size;
+  gst_adapter_unmap (comm->adapter);
+  gst_adapter_flush (comm->adapter, mapped_size);
+
+  if (buffer_data_size == 0) {
+    buffer = gst_buffer_new ();
+  } else {
+    buffer = gst_adapter_get_buffer (comm->adapter, buffer_data_size);
+    gst_adapter_flush (comm->adapter, buffer_data_size);
+  }
+  size -= buffer_data_size;
+
+  gst_ipc_pipeline_comm_set_buffer_metadata (buffer, &meta);
+
+  mapped_size = size;
+  payload = gst_adapter_map (comm->adapter, mapped_size);
+  if (!payload) {
+    gst_buffer_unref (buffer);
+    return NULL;
+  }
+  gst_ipc_pipeline_comm_read_meta_list (comm, buffer, payload);
   gst_adapter_unmap (comm->adapter);
   gst_adapter_flush (comm->adapter, mapped_size);
 
   return buffer;
 }
 
+static GstBuffer *
+gst_ipc_pipeline_comm_read_fd_buffer (GstIpcPipelineComm * comm,
+    guint32 id, guint32 size)
+{
+  GstBuffer *buffer;
+  CommBufferMetadata meta;
+  CommReleaseData *release = NULL;
+  const guint8 *payload, *end;
+  guint32 n_memories, n;
+
+  /* this should not be called if we don't have enough yet */
+  g_return_val_if_fail (gst_adapter_available (comm->adapter) >= size, NULL);
+  g_return_val_if_fail (size >= sizeof (CommBufferMetadata) + sizeof (guint32),
+      NULL);
+
+  payload = gst_adapter_map (comm->adapter, size);
+  if (!payload)
+    return NULL;
+  end = payload + size;
+
+  memcpy (&meta, payload, sizeof (CommBufferMetadata));
+  payload += sizeof (CommBufferMetadata);
+  n_memories = GST_READ_UINT32_LE (payload);
+  payload += sizeof (guint32);
+
+  buffer = gst_buffer_new ();
+  for (n = 0; n < n_memories; n++) {
+    GstMemory *mem;
+
+    if (end - payload < 1)
+      goto invalid;
+
+    if (*payload == COMM_MEMORY_INLINE) {
+      guint32 len;
+
+      if (end - payload < COMM_MEMORY_INLINE_HEADER_SIZE)
+        goto invalid;
+      len = GST_READ_UINT32_LE (payload + 1);
+      payload += COMM_MEMORY_INLINE_HEADER_SIZE;
+      if (end - payload < len)
+        goto invalid;
+
+      mem = gst_allocator_alloc (NULL, len, NULL);
+      if (len > 0) {
+        GstMapInfo map;
+
+        gst_memory_map (mem, &map, GST_MAP_WRITE);
+        memcpy (map.data, payload, len);
+        gst_memory_unmap (mem, &map);
+      }
+      payload += len;
+    } else if (*payload == COMM_MEMORY_FD) {
+      guint64 offset, msize, maxsize;
+      gint fd;
+
+      if (end - payload < COMM_MEMORY_FD_HEADER_SIZE)
+        goto invalid;
+      offset = GST_READ_UINT64_LE (payload + 1);
+      msize = GST_READ_UINT64_LE (payload + 9);
+      maxsize = GST_READ_UINT64_LE (payload + 17);
+      payload += COMM_MEMORY_FD_HEADER_SIZE;
+
+      if (g_queue_is_empty (&comm->received_fds)) {
+        GST_ERROR_OBJECT (comm->element, "No fd received for buffer %u", id);
+        goto invalid;
+      }
+      fd = GPOINTER_TO_INT (g_queue_pop_head (&comm->received_fds));
+
+      if (offset > maxsize || msize > maxsize - offset) {
+        g_close (fd, NULL);
+        goto invalid;
+      }
+
+      if (!comm->fd_allocator)
+        comm->fd_allocator = gst_fd_allocator_new ();
+      mem = gst_fd_allocator_alloc (comm->fd_allocator, fd, maxsize,
+          GST_FD_MEMORY_FLAG_NONE);
+      if (!mem) {
+        g_close (fd, NULL);
+        goto invalid;
+      }
+      gst_memory_resize (mem, offset, msize);
+      GST_MINI_OBJECT_FLAG_SET (mem, GST_MEMORY_FLAG_READONLY);
+
+      if (!release) {
+        release = g_new (CommReleaseData, 1);
+        release->element = gst_object_ref (comm->element);
+        release->comm = comm;
+        release->id = id;
+        release->refcount = 0;
+      }
+      g_atomic_int_inc (&release->refcount);
+      gst_mini_object_set_qdata (GST_MINI_OBJECT (mem), QUARK_RELEASE,
+          release, (GDestroyNotify) comm_release_data_unref);
+    } else {
+      goto invalid;
+    }
+
+    gst_buffer_append_memory (buffer, mem);
+  }
+
+  gst_ipc_pipeline_comm_set_buffer_metadata (buffer, &meta);
+
+  if (end - payload < sizeof (guint32))
+    goto invalid;
+  gst_ipc_pipeline_comm_read_meta_list (comm, buffer, payload);
+
+  gst_adapter_unmap (comm->adapter);
+  gst_adapter_flush (comm->adapter, size);
+
+  return buffer;
+
+invalid:
+  GST_ERROR_OBJECT (comm->element, "Invalid fd buffer %u", id);
+  gst_adapter_unmap (comm->adapter);
+  gst_adapter_flush (comm->adapter, size);
+  gst_buffer_unref (buffer);
+  return NULL;
+}
+
 static gboolean
 gst_ipc_pipeline_comm_write_sink_message_event_to_fd (GstIpcPipelineComm * comm,
     GstEvent * event)
@@ -976,6 +1601,15 @@ gst_ipc_pipeline_comm_write_event_to_fd (GstIpcPipelineComm * comm,
     goto write_failed;
   ret = ret32;
 
+  /* The peer acks serialized events in order with the buffers, so all the
+   * buffers sent before are acked by now. Results from before a flush are
+   * not relevant anymore. */
+  if (!upstream && GST_EVENT_IS_SERIALIZED (event)) {
+    gst_ipc_pipeline_comm_wait_inflight (comm, 0);
+    if (GST_EVENT_TYPE (event) == GST_EVENT_FLUSH_STOP)
+      comm->inflight_ret = GST_FLOW_OK;
+  }
+
 done:
   g_mutex_unlock (&comm->mutex);
   g_free (str);
@@ -1614,11 +2248,27 @@ gst_ipc_pipeline_comm_init (GstIpcPipelineComm * comm, GstElement * element)
   comm->adapter = gst_adapter_new ();
   comm->poll = gst_poll_new (TRUE);
   gst_poll_fd_init (&comm->pollFDin);
+  g_queue_init (&comm->inflight);
+  comm->inflight_ret = GST_FLOW_OK;
+  comm->fdout_checked = -1;
+  comm->sent_buffers =
+      g_hash_table_new_full (g_direct_hash, g_direct_equal, NULL,
+      (GDestroyNotify) gst_buffer_unref);
+  g_queue_init (&comm->received_fds);
 }
 
 void
 gst_ipc_pipeline_comm_clear (GstIpcPipelineComm * comm)
 {
+  g_queue_clear (&comm->inflight);
+  if (comm->inflight_waiting_ids)
+    g_hash_table_unref (comm->inflight_waiting_ids);
+  g_hash_table_destroy (comm->sent_buffers);
+  while (!g_queue_is_empty (&comm->received_fds))
+    g_close (GPOINTER_TO_INT (g_queue_pop_head (&comm->received_fds)),
+        NULL);
+  if (comm->fd_allocator)
+    gst_object_unref (comm->fd_allocator);
   g_hash_table_destroy (comm->waiting_ids);
   gst_object_unref (comm->adapter);
   gst_poll_free (comm->poll);
@@ -1706,6 +2356,55 @@ gst_ipc_pipeline_comm_reply_request (GstIpcPipelineComm * comm, guint32 id,
   return TRUE;
 }
 
+#ifdef G_OS_UNIX
+/* Reads like read(), keeping the fds passed along with the data */
+static ssize_t
+recv_with_fds (GstIpcPipelineComm * comm, guint8 * data, gsize size)
+{
+  gchar control[CMSG_SPACE (sizeof (gint) * COMM_MAX_FDS)];
+  struct iovec iov;
+  struct msghdr msg = { 0, };
+  struct cmsghdr *cmsg;
+  gint flags = 0;
+  ssize_t sz;
+
+  iov.iov_base = data;
+  iov.iov_len = size;
+  msg.msg_iov = &iov;
+  msg.msg_iovlen = 1;
+  msg.msg_control = control;
+  msg.msg_controllen = sizeof (control);
+#ifdef MSG_CMSG_CLOEXEC
+  flags |= MSG_CMSG_CLOEXEC;
+#endif
+
+  sz = recvmsg (comm->pollFDin.fd, &msg, flags);
+  if (sz <= 0)
+    return sz;
+
+  for (cmsg = CMSG_FIRSTHDR (&msg); cmsg; cmsg = CMSG_NXTHDR (&msg, cmsg)) {
+    guint n, n_fds;
+
+    if (cmsg->cmsg_level != SOL_SOCKET || cmsg->cmsg_type != SCM_RIGHTS)
+      continue;
+
+    n_fds = (cmsg->cmsg_len - CMSG_LEN (0)) / sizeof (gint);
+    for (n = 0; n < n_fds; n++) {
+      gint fd;
+
+      memcpy (&fd, CMSG_DATA (cmsg) + n * sizeof (gint), sizeof (gint));
+      g_queue_push_tail (&comm->received_fds, GINT_TO_POINTER (fd));
+    }
+    GST_TRACE_OBJECT (comm->element, "Received %u fds", n_fds);
+  }
+
+  if (msg.msg_flags & MSG_CTRUNC)
+    GST_WARNING_OBJECT (comm->element, "Some file descriptors were dropped");
+
+  return sz;
+}
+#endif
+
 static gint
 update_adapter (GstIpcPipelineComm * comm)
 {
@@ -1731,6 +2430,7 @@ again:
     if (comm->fdin != -1 && GST_OBJECT_PARENT (comm->element)) {
       GST_DEBUG_OBJECT (comm->element, "Start watching fd %d", comm->fdin);
       comm->pollFDin.fd = comm->fdin;
+      comm->fdin_is_unix_socket = comm_fd_is_unix_socket (comm->fdin);
       gst_poll_add_fd (comm->poll, &comm->pollFDin);
       gst_poll_fd_ctl_read (comm->poll, &comm->pollFDin, TRUE);
     }
@@ -1752,7 +2452,12 @@ again:
       mem = gst_allocator_alloc (NULL, comm->read_chunk_size, NULL);
 
     gst_memory_map (mem, &map, GST_MAP_WRITE);
-    sz = read (comm->pollFDin.fd, map.data, map.size);
+#ifdef G_OS_UNIX
+    if (comm->fdin_is_unix_socket)
+      sz = recv_with_fds (comm, map.data, map.size);
+    else
+#endif
+      sz = read (comm->pollFDin.fd, map.data, map.size);
     gst_memory_unmap (mem, &map);
 
     if (sz <= 0) {
@@ -1817,6 +2522,8 @@ read_many (GstIpcPipelineComm * comm)
           case GST_IPC_PIPELINE_COMM_DATA_TYPE_STATE_LOST:
           case GST_IPC_PIPELINE_COMM_DATA_TYPE_MESSAGE:
           case GST_IPC_PIPELINE_COMM_DATA_TYPE_GERROR_MESSAGE:
+          case GST_IPC_PIPELINE_COMM_DATA_TYPE_FD_BUFFER:
+          case GST_IPC_PIPELINE_COMM_DATA_TYPE_RELEASE:
             GST_TRACE_OBJECT (comm->element, "switching to state %s",
                 gst_ipc_pipeline_comm_data_type_get_name (type));
             comm->state = type;
@@ -1881,6 +2588,7 @@ read_many (GstIpcPipelineComm * comm)
         break;
       }
       case GST_IPC_PIPELINE_COMM_DATA_TYPE_BUFFER:
+      case GST_IPC_PIPELINE_COMM_DATA_TYPE_FD_BUFFER:
       {
         GstBuffer *buf;
 
@@ -1888,7 +2596,11 @@ read_many (GstIpcPipelineComm * comm)
         if (available < comm->payload_length)
           goto done;
 
-        buf = gst_ipc_pipeline_comm_read_buffer (comm, comm->payload_length);
+        if (comm->state == GST_IPC_PIPELINE_COMM_DATA_TYPE_FD_BUFFER)
+          buf = gst_ipc_pipeline_comm_read_fd_buffer (comm, comm->id,
+              comm->payload_length);
+        else
+          buf = gst_ipc_pipeline_comm_read_buffer (comm, comm->payload_length);
         if (!buf)
           goto buffer_failed;
 
@@ -2078,6 +2790,36 @@ read_many (GstIpcPipelineComm * comm)
         if (comm->on_message)
           (*comm->on_message) (comm->id, message, comm->user_data);
 
+        GST_TRACE_OBJECT (comm->element, "switching to state TYPE");
+        comm->state = GST_IPC_PIPELINE_COMM_STATE_TYPE;
+        break;
+      }
+      case GST_IPC_PIPELINE_COMM_DATA_TYPE_RELEASE:
+      {
+        GstBuffer *buf;
+
+        available = gst_adapter_available (comm->adapter);
+        if (available < comm->payload_length)
+          goto done;
+
+        gst_adapter_flush (comm->adapter, comm->payload_length);
+
+        g_mutex_lock (&comm->mutex);
+        buf = g_hash_table_lookup (comm->sent_buffers,
+            GINT_TO_POINTER (comm->id));
+        if (buf)
+          g_hash_table_steal (comm->sent_buffers, GINT_TO_POINTER (comm->id));
+        g_mutex_unlock (&comm->mutex);
+
+        if (buf) {
+          GST_TRACE_OBJECT (comm->element, "Peer released buffer %u",
+              comm->id);
+          gst_buffer_unref (buf);
+        } else {
+          GST_WARNING_OBJECT (comm->element, "Got release for unknown buffer "
+              "%u", comm->id);
+        }
+
         GST_TRACE_OBJECT (comm->element, "switching to state TYPE");
         comm->state = GST_IPC_PIPELINE_COMM_STATE_TYPE;
         break;
@@ -2324,6 +3066,7 @@ gst_ipc_pipeline_comm_plugin_init (void)
     GST_DEBUG_CATEGORY_INIT (gst_ipc_pipeline_comm_debug, "ipcpipelinecomm", 0,
         "ipc pipeline comm");
     QUARK_ID = g_quark_from_static_string ("ipcpipeline-id");
+    QUARK_RELEASE = g_quark_from_static_string ("ipcpipeline-release");
     REGISTER_SERIALIZATION_NO_COMPARE (gst_event_get_type (), event);
     g_once_init_leave (&once, (gsize) 1);
   }
@@ -26,6 +26,7 @@
 
 #include <gst/gst.h>
 #include <gst/base/gstadapter.h>
+#include <gst/allocators/gstfdmemory.h>
 
 G_BEGIN_DECLS
 
@@ -51,6 +52,8 @@ typedef enum {
   GST_IPC_PIPELINE_COMM_DATA_TYPE_STATE_LOST,
   GST_IPC_PIPELINE_COMM_DATA_TYPE_MESSAGE,
   GST_IPC_PIPELINE_COMM_DATA_TYPE_GERROR_MESSAGE,
+  GST_IPC_PIPELINE_COMM_DATA_TYPE_FD_BUFFER,
+  GST_IPC_PIPELINE_COMM_DATA_TYPE_RELEASE,
 } GstIpcPipelineCommDataType;
 
 typedef struct
@@ -76,6 +79,23 @@ typedef struct
   guint read_chunk_size;
   GstClockTime ack_time;
 
+  /* buffers sent without waiting for their ack */
+  guint window_size;
+  GQueue inflight;
+  GHashTable *inflight_waiting_ids;
+  GstFlowReturn inflight_ret;
+
+  /* fd-backed memories sent as fds, kept until the peer releases them */
+  gboolean fd_passing;
+  gint fdout_checked;
+  gboolean fdout_is_unix_socket;
+  GHashTable *sent_buffers;
+
+  /* fds received along with the data read by the reader thread */
+  gboolean fdin_is_unix_socket;
+  GQueue received_fds;
+  GstAllocator *fd_allocator;
+
   void (*on_buffer) (guint32, GstBuffer *, gpointer);
   void (*on_event) (guint32, GstEvent *, gboolean, gpointer);
   void (*on_query) (guint32, GstQuery *, gboolean, gpointer);
@@ -105,6 +125,9 @@ void gst_ipc_pipeline_comm_write_query_result_to_fd (GstIpcPipelineComm * comm,
 
 GstFlowReturn gst_ipc_pipeline_comm_write_buffer_to_fd (
     GstIpcPipelineComm * comm, GstBuffer * buffer);
+GstFlowReturn gst_ipc_pipeline_comm_write_buffer_list_to_fd (
+    GstIpcPipelineComm * comm, GstBufferList * list);
+void gst_ipc_pipeline_comm_reset_inflight (GstIpcPipelineComm * comm);
 gboolean gst_ipc_pipeline_comm_write_event_to_fd (GstIpcPipelineComm * comm,
     gboolean upstream, GstEvent * event);
 gboolean gst_ipc_pipeline_comm_write_query_to_fd (GstIpcPipelineComm * comm,
@@ -55,7 +55,10 @@
  * Communication with ipcpipelinesrc on the slave happens via a socket, using a
  * custom protocol. Each buffer, event, query, message or state change is
  * serialized in a "packet" and sent over the socket. The sender then
- * performs a blocking wait for a reply, if a return code is needed.
+ * performs a blocking wait for a reply, if a return code is needed. With
+ * #GstIpcPipelineSink:window-size, up to that many buffers are sent ahead
+ * without waiting for their reply, and a failure is returned upstream with
+ * the next buffer.
  *
  * All objects that contain a GstStructure (messages, queries, events) are
  * serialized by serializing the GstStructure to a string
@@ -65,8 +68,12 @@
  * serialization may occur (ex error/warning/info messages that contain a
  * GError are serialized differently).
  *
- * Buffers are transported by writing their content directly on the socket.
- * More efficient ways for memory sharing could be implemented in the future.
+ * Buffers are transported by writing their content directly on the socket,
+ * each buffer or buffer list in a single write. When
+ * #GstIpcPipelineSink:fd-passing is enabled and the socket is a UNIX
+ * socket, memories backed by a file descriptor (memfd, dmabuf) are not
+ * copied: their file descriptor is passed instead, and the buffer is kept
+ * until the slave has released it.
  */
 
 #ifdef HAVE_CONFIG_H
@@ -99,11 +106,15 @@ enum
   PROP_FDOUT,
   PROP_READ_CHUNK_SIZE,
   PROP_ACK_TIME,
+  PROP_WINDOW_SIZE,
+  PROP_FD_PASSING,
 };
 
 
 #define DEFAULT_READ_CHUNK_SIZE 4096
 #define DEFAULT_ACK_TIME (10 * G_TIME_SPAN_SECOND)
+#define DEFAULT_WINDOW_SIZE 0
+#define DEFAULT_FD_PASSING FALSE
 
 #define _do_init \
     GST_DEBUG_CATEGORY_INIT (gst_ipc_pipeline_sink_debug, "ipcpipelinesink", 0, "ipcpipelinesink element");
@@ -130,6 +141,8 @@ static GstStateChangeReturn gst_ipc_pipeline_sink_change_state (GstElement *
 
 static GstFlowReturn gst_ipc_pipeline_sink_chain (GstPad * pad,
     GstObject * parent, GstBuffer * buffer);
+static GstFlowReturn gst_ipc_pipeline_sink_chain_list (GstPad * pad,
+    GstObject * parent, GstBufferList * list);
 static gboolean gst_ipc_pipeline_sink_event (GstPad * pad, GstObject * parent,
     GstEvent * event);
 static gboolean gst_ipc_pipeline_sink_element_query (GstElement * element,
@@ -179,6 +192,38 @@ gst_ipc_pipeline_sink_class_init (GstIpcPipelineSinkClass * klass)
           0, G_MAXUINT64, DEFAULT_ACK_TIME,
           G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
+  /**
+   * GstIpcPipelineSink:window-size:
+   *
+   * Number of buffers that can be sent without waiting for the slave to
+   * reply. With 0, each buffer waits for its reply before the next one is
+   * sent.
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (gobject_class, PROP_WINDOW_SIZE,
+      g_param_spec_uint ("window-size", "Window size",
+          "Number of buffers sent without waiting for a reply (0 = wait for "
+          "each buffer)", 0, 1024, DEFAULT_WINDOW_SIZE,
+          G_PARAM_READWRITE | GST_PARAM_MUTABLE_READY |
+          G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstIpcPipelineSink:fd-passing:
+   *
+   * Pass the file descriptor of fd-backed memories instead of copying their
+   * content. This requires fdout to be a UNIX socket, and a slave that
+   * supports it.
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (gobject_class, PROP_FD_PASSING,
+      g_param_spec_boolean ("fd-passing", "FD passing",
+          "Pass the file descriptor of fd-backed memories instead of copying "
+          "them", DEFAULT_FD_PASSING,
+          G_PARAM_READWRITE | GST_PARAM_MUTABLE_READY |
+          G_PARAM_STATIC_STRINGS));
+
   gst_ipc_pipeline_sink_signals[SIGNAL_DISCONNECT] =
       g_signal_new ("disconnect",
       G_TYPE_FROM_CLASS (klass),
@@ -214,6 +259,8 @@ gst_ipc_pipeline_sink_init (GstIpcPipelineSink * sink)
   gst_ipc_pipeline_comm_init (&sink->comm, GST_ELEMENT (sink));
   sink->comm.read_chunk_size = DEFAULT_READ_CHUNK_SIZE;
   sink->comm.ack_time = DEFAULT_ACK_TIME;
+  sink->comm.window_size = DEFAULT_WINDOW_SIZE;
+  sink->comm.fd_passing = DEFAULT_FD_PASSING;
   sink->comm.fdin = -1;
   sink->comm.fdout = -1;
   sink->threads = g_thread_pool_new (pusher, sink, -1, FALSE, NULL);
@@ -230,6 +277,8 @@ gst_ipc_pipeline_sink_init (GstIpcPipelineSink * sink)
   gst_pad_set_query_function (sink->sinkpad, gst_ipc_pipeline_sink_query);
   gst_pad_set_event_function (sink->sinkpad, gst_ipc_pipeline_sink_event);
   gst_pad_set_chain_function (sink->sinkpad, gst_ipc_pipeline_sink_chain);
+  gst_pad_set_chain_list_function (sink->sinkpad,
+      gst_ipc_pipeline_sink_chain_list);
   gst_element_add_pad (GST_ELEMENT_CAST (sink), sink->sinkpad);
 
 }
@@ -275,6 +324,12 @@ gst_ipc_pipeline_sink_set_property (GObject * object, guint prop_id,
     case PROP_ACK_TIME:
       sink->comm.ack_time = g_value_get_uint64 (value);
       break;
+    case PROP_WINDOW_SIZE:
+      sink->comm.window_size = g_value_get_uint (value);
+      break;
+    case PROP_FD_PASSING:
+      sink->comm.fd_passing = g_value_get_boolean (value);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -300,6 +355,12 @@ gst_ipc_pipeline_sink_get_property (GObject * object, guint prop_id,
     case PROP_ACK_TIME:
       g_value_set_uint64 (value, sink->comm.ack_time);
       break;
+    case PROP_WINDOW_SIZE:
+      g_value_set_uint (value, sink->comm.window_size);
+      break;
+    case PROP_FD_PASSING:
+      g_value_set_boolean (value, sink->comm.fd_passing);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -337,6 +398,24 @@ gst_ipc_pipeline_sink_chain (GstPad * pad, GstObject * parent,
   return ret;
 }
 
+static GstFlowReturn
+gst_ipc_pipeline_sink_chain_list (GstPad * pad, GstObject * parent,
+    GstBufferList * list)
+{
+  GstIpcPipelineSink *sink = GST_IPC_PIPELINE_SINK (parent);
+  GstFlowReturn ret;
+
+  GST_DEBUG_OBJECT (sink, "Rendering buffer list %p of length %u", list,
+      gst_buffer_list_length (list));
+
+  ret = gst_ipc_pipeline_comm_write_buffer_list_to_fd (&sink->comm, list);
+  if (ret != GST_FLOW_OK)
+    GST_DEBUG_OBJECT (sink, "Peer result was %s", gst_flow_get_name (ret));
+
+  gst_buffer_list_unref (list);
+  return ret;
+}
+
 static gboolean
 gst_ipc_pipeline_sink_query (GstPad * pad, GstObject * parent, GstQuery * query)
 {
@@ -405,8 +484,15 @@ static gboolean
 gst_ipc_pipeline_sink_pad_activate_mode (GstPad * pad,
     GstObject * parent, GstPadMode mode, gboolean active)
 {
+  GstIpcPipelineSink *sink = GST_IPC_PIPELINE_SINK (parent);
+
   if (mode == GST_PAD_MODE_PULL)
     return FALSE;
+
+  /* streaming has stopped, acks still in flight are not waited for */
+  if (!active)
+    gst_ipc_pipeline_comm_reset_inflight (&sink->comm);
+
   return TRUE;
 }
 
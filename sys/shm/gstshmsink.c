@@ -39,6 +39,7 @@
 #include "gstshmsink.h"
 
 #include <gst/gst.h>
+#include <gst/allocators/allocators.h>
 
 #include <string.h>
 
@@ -58,7 +59,9 @@ enum
   PROP_PERMS,
   PROP_SHM_SIZE,
   PROP_WAIT_FOR_CONNECTION,
-  PROP_BUFFER_TIME
+  PROP_BUFFER_TIME,
+  PROP_RING_SLOTS,
+  PROP_FD_PASSING
 };
 
 struct GstShmClient
@@ -69,6 +72,8 @@ struct GstShmClient
 
 #define DEFAULT_SIZE ( 64 * 1024 * 1024 )
 #define DEFAULT_WAIT_FOR_CONNECTION (TRUE)
+#define DEFAULT_RING_SLOTS 0
+#define DEFAULT_FD_PASSING FALSE
 /* Default is user read/write, group read */
 #define DEFAULT_PERMS ( S_IRUSR | S_IWUSR | S_IRGRP )
 
@@ -357,6 +362,8 @@ gst_shm_sink_init (GstShmSink * self)
   self->unlock = FALSE;
   self->wait_for_connection = DEFAULT_WAIT_FOR_CONNECTION;
   self->perms = DEFAULT_PERMS;
+  self->ring_slots = DEFAULT_RING_SLOTS;
+  self->fd_passing = DEFAULT_FD_PASSING;
 
   gst_allocation_params_init (&self->params);
 }
@@ -419,6 +426,41 @@ gst_shm_sink_class_init (GstShmSinkClass * klass)
           -1, G_MAXINT64, -1,
           G_PARAM_CONSTRUCT | G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
+  /**
+   * GstShmSink:ring-slots:
+   *
+   * Number of slots of the rings in shared memory used to pass buffers to
+   * and from each client, rounded up to a power of two. Buffers and
+   * acknowledgements then only go through the control socket to wake up a
+   * side that was idle, instead of once per buffer. 0 sends everything over
+   * the socket. Only applies to clients connecting after it was set, and
+   * requires a shmsrc that supports it.
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (gobject_class, PROP_RING_SLOTS,
+      g_param_spec_uint ("ring-slots",
+          "Ring slots",
+          "Number of shared memory ring slots per client (0 = disabled)",
+          0, 65536, DEFAULT_RING_SLOTS,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstShmSink:fd-passing:
+   *
+   * Send buffers backed by a memfd or a dmabuf by passing their fd to the
+   * clients instead of copying them into the shared memory area. Each fd
+   * is only sent once per client, so buffers coming from a pool don't cost
+   * anything after their first use. Requires a shmsrc that supports it.
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (gobject_class, PROP_FD_PASSING,
+      g_param_spec_boolean ("fd-passing",
+          "Pass fds",
+          "Pass memfd and dmabuf backed buffers as fds instead of copying them",
+          DEFAULT_FD_PASSING, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
   signals[SIGNAL_CLIENT_CONNECTED] = g_signal_new ("client-connected",
       GST_TYPE_SHM_SINK, G_SIGNAL_RUN_LAST, 0, NULL, NULL, NULL,
       G_TYPE_NONE, 1, G_TYPE_INT);
@@ -507,6 +549,18 @@ gst_shm_sink_set_property (GObject * object, guint prop_id,
       GST_OBJECT_UNLOCK (object);
       g_cond_broadcast (&self->cond);
       break;
+    case PROP_RING_SLOTS:
+      GST_OBJECT_LOCK (object);
+      self->ring_slots = g_value_get_uint (value);
+      if (self->pipe)
+        sp_writer_set_ring_slots (self->pipe, self->ring_slots);
+      GST_OBJECT_UNLOCK (object);
+      break;
+    case PROP_FD_PASSING:
+      GST_OBJECT_LOCK (object);
+      self->fd_passing = g_value_get_boolean (value);
+      GST_OBJECT_UNLOCK (object);
+      break;
     default:
       break;
   }
@@ -536,6 +590,12 @@ gst_shm_sink_get_property (GObject * object, guint prop_id,
     case PROP_BUFFER_TIME:
       g_value_set_int64 (value, self->buffer_time);
       break;
+    case PROP_RING_SLOTS:
+      g_value_set_uint (value, self->ring_slots);
+      break;
+    case PROP_FD_PASSING:
+      g_value_set_boolean (value, self->fd_passing);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -572,6 +632,8 @@ gst_shm_sink_start (GstBaseSink * bsink)
   }
 
   sp_set_data (self->pipe, self);
+  if (self->ring_slots)
+    sp_writer_set_ring_slots (self->pipe, self->ring_slots);
   g_free (self->socket_path);
   self->socket_path = g_strdup (sp_writer_get_path (self->pipe));
 
@@ -647,6 +709,10 @@ gst_shm_sink_can_render (GstShmSink * self, GstClockTime time)
 {
   ShmBuffer *b;
 
+  /* Wait for a free slot in the ring of every client */
+  if (!sp_writer_can_send (self->pipe))
+    return FALSE;
+
   if (time == GST_CLOCK_TIME_NONE || self->buffer_time == GST_CLOCK_TIME_NONE)
     return TRUE;
 
@@ -667,6 +733,7 @@ gst_shm_sink_render (GstBaseSink * bsink, GstBuffer * buf)
   int rv = 0;
   GstMapInfo map;
   gboolean need_new_memory = FALSE;
+  gboolean pass_fd = FALSE;
   GstFlowReturn ret = GST_FLOW_OK;
   GstMemory *memory = NULL;
   GstBuffer *sendbuf = NULL;
@@ -710,13 +777,18 @@ gst_shm_sink_render (GstBaseSink * bsink, GstBuffer * buf)
   } else {
     memory = gst_buffer_peek_memory (buf, 0);
 
-    if (memory->allocator != GST_ALLOCATOR (self->allocator)) {
+    if (self->fd_passing && gst_is_fd_memory (memory)) {
+      pass_fd = TRUE;
+      GST_LOG_OBJECT (self, "Memory in buffer %p has fd %d, passing it",
+          buf, gst_fd_memory_get_fd (memory));
+    } else if (memory->allocator != GST_ALLOCATOR (self->allocator)) {
       need_new_memory = TRUE;
       GST_LOG_OBJECT (self, "Memory in buffer %p was not allocated by "
           "%" GST_PTR_FORMAT ", will memcpy", buf, memory->allocator);
     }
   }
 
+copy:
   if (need_new_memory) {
     if (gst_buffer_get_size (buf) > sp_writer_get_max_buf_size (self->pipe)) {
       gsize area_size = sp_writer_get_max_buf_size (self->pipe);
@@ -780,26 +852,42 @@ gst_shm_sink_render (GstBaseSink * bsink, GstBuffer * buf)
     sendbuf = gst_buffer_ref (buf);
   }
 
-  if (!gst_buffer_map (sendbuf, &map, GST_MAP_READ)) {
-    GST_ELEMENT_ERROR (self, STREAM, FAILED,
-        (NULL), ("Failed to map data into send buffer"));
-    goto error;
-  }
+  if (pass_fd) {
+    rv = sp_writer_send_fd_buf (self->pipe, gst_fd_memory_get_fd (memory),
+        gst_is_dmabuf_memory (memory), memory->offset, memory->size, sendbuf);
+    if (rv == -1) {
+      /* The fd can't be passed, e.g. it can't be stat()ed or the range is
+       * outside of it, send a copy of the data like for any other memory */
+      GST_WARNING_OBJECT (self, "Failed to pass fd %d over SHM, copying",
+          gst_fd_memory_get_fd (memory));
+      gst_buffer_unref (sendbuf);
+      pass_fd = FALSE;
+      need_new_memory = TRUE;
+      goto copy;
+    }
+  } else {
+    if (!gst_buffer_map (sendbuf, &map, GST_MAP_READ)) {
+      GST_ELEMENT_ERROR (self, STREAM, FAILED,
+          (NULL), ("Failed to map data into send buffer"));
+      goto error;
+    }
+
+    /* Make the memory readonly as of now as we've sent it to the other side
+     * We know it's not mapped for writing anywhere as we just mapped it for
+     * reading
+     */
+    rv = sp_writer_send_buf (self->pipe, (char *) map.data, map.size,
+        sendbuf);
+    if (rv == -1) {
+      GST_ELEMENT_ERROR (self, STREAM, FAILED,
+          (NULL), ("Failed to send data over SHM"));
+      gst_buffer_unmap (sendbuf, &map);
+      goto error;
+    }
 
-  /* Make the memory readonly as of now as we've sent it to the other side
-   * We know it's not mapped for writing anywhere as we just mapped it for
-   * reading
-   */
-  rv = sp_writer_send_buf (self->pipe, (char *) map.data, map.size, sendbuf);
-  if (rv == -1) {
-    GST_ELEMENT_ERROR (self, STREAM, FAILED,
-        (NULL), ("Failed to send data over SHM"));
     gst_buffer_unmap (sendbuf, &map);
-    goto error;
   }
 
-  gst_buffer_unmap (sendbuf, &map);
-
   GST_OBJECT_UNLOCK (self);
 
   if (rv == 0) {
@@ -910,12 +998,19 @@ pollthread_func (gpointer data)
 
       if (gst_poll_fd_can_read (self->poll, &gclient->pollfd)) {
         int rv;
+        int acks = 0;
         gpointer tag = NULL;
+        GSList *list = NULL;
 
         GST_OBJECT_LOCK (self);
         rv = sp_writer_recv (self->pipe, gclient->client, &tag);
+        if (rv >= 0)
+          acks = sp_writer_recv_acks (self->pipe, gclient->client,
+              (sp_buffer_free_callback) free_buffer_locked, (void **) &list);
         GST_OBJECT_UNLOCK (self);
 
+        g_slist_free_full (list, (GDestroyNotify) gst_buffer_unref);
+
         if (rv < 0) {
           GST_WARNING_OBJECT (self, "One client has read error,"
               " closing (retval: %d errno: %d)", rv, errno);
@@ -926,6 +1021,12 @@ pollthread_func (gpointer data)
 
         if (rv == 0)
           gst_buffer_unref (tag);
+
+        if (acks < 0) {
+          GST_WARNING_OBJECT (self, "One client has an invalid ring,"
+              " closing (retval: %d)", acks);
+          goto close_client;
+        }
       }
       continue;
     close_client:
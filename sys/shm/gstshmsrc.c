@@ -41,8 +41,10 @@
 #include "gstshmsrc.h"
 
 #include <gst/gst.h>
+#include <gst/allocators/allocators.h>
 
 #include <string.h>
+#include <unistd.h>
 
 /* signals */
 enum
@@ -65,6 +67,8 @@ struct GstShmBuffer
   GstShmPipe *pipe;
 };
 
+G_DEFINE_QUARK (GstShmSrcBuffer, gst_shm_src_buffer);
+
 
 GST_DEBUG_CATEGORY_STATIC (shmsrc_debug);
 #define GST_CAT_DEFAULT shmsrc_debug
@@ -153,6 +157,8 @@ gst_shm_src_init (GstShmSrc * self)
 {
   self->poll = gst_poll_new (TRUE);
   gst_poll_fd_init (&self->pollfd);
+  self->dmabuf_allocator = gst_dmabuf_allocator_new ();
+  self->fd_allocator = gst_fd_allocator_new ();
 }
 
 static void
@@ -162,6 +168,8 @@ gst_shm_src_finalize (GObject * object)
 
   gst_poll_free (self->poll);
   g_free (self->socket_path);
+  gst_object_unref (self->dmabuf_allocator);
+  gst_object_unref (self->fd_allocator);
 
   G_OBJECT_CLASS (parent_class)->finalize (object);
 }
@@ -327,6 +335,9 @@ gst_shm_src_create (GstPushSrc * psrc, GstBuffer ** outbuf)
   gchar *buf = NULL;
   int rv = 0;
   struct GstShmBuffer *gsb;
+  unsigned long offset = 0;
+  int is_dmabuf = 0;
+  int fd;
 
   GST_DEBUG_OBJECT (self, "Stopping %p", self);
 
@@ -341,6 +352,19 @@ gst_shm_src_create (GstPushSrc * psrc, GstBuffer ** outbuf)
   GST_OBJECT_UNLOCK (self);
 
   do {
+    /* Buffers queued in the shared memory ring don't need the socket, it is
+     * only woken up once the ring is empty */
+    GST_OBJECT_LOCK (self);
+    rv = sp_client_recv_ring (pipe->pipe, &buf);
+    GST_OBJECT_UNLOCK (self);
+    if (rv < 0) {
+      GST_ELEMENT_ERROR (self, RESOURCE, READ, ("Failed to read from shmsrc"),
+          ("Error reading from ring: %d", rv));
+      goto error;
+    }
+    if (buf != NULL)
+      break;
+
     if (gst_poll_wait (self->poll, GST_CLOCK_TIME_NONE) < 0) {
       if (errno == EBUSY)
         goto flushing;
@@ -384,8 +408,46 @@ gst_shm_src_create (GstPushSrc * psrc, GstBuffer ** outbuf)
   gsb->buf = buf;
   gsb->pipe = pipe;
 
-  *outbuf = gst_buffer_new_wrapped_full (GST_MEMORY_FLAG_READONLY,
-      buf, rv, 0, rv, gsb, free_buffer);
+  GST_OBJECT_LOCK (self);
+  fd = sp_client_buf_get_fd (pipe->pipe, buf, &offset, &is_dmabuf);
+  if (fd >= 0) {
+    fd = dup (fd);
+    if (fd < 0) {
+      GST_OBJECT_UNLOCK (self);
+      GST_ELEMENT_ERROR (self, RESOURCE, READ, ("Failed to read from shmsrc"),
+          ("Failed to duplicate passed fd: %s", g_strerror (errno)));
+      free_buffer (gsb);
+      return GST_FLOW_ERROR;
+    }
+  }
+  GST_OBJECT_UNLOCK (self);
+
+  if (fd >= 0) {
+    GstMemory *mem;
+
+    /* Passed fds are not mapped by the pipe, dmabufs may not even be
+     * mappable. Hand out the fd itself, it is only mapped if downstream
+     * maps the memory, and dmabufs can be imported without a copy. The
+     * memory owns the dup()ed fd and the buffer is released with it */
+    GST_LOG_OBJECT (self, "Wrapping %s %d at offset %lu",
+        is_dmabuf ? "dmabuf" : "fd", fd, offset);
+    if (is_dmabuf)
+      mem = gst_dmabuf_allocator_alloc (self->dmabuf_allocator, fd,
+          offset + rv);
+    else
+      mem = gst_fd_allocator_alloc (self->fd_allocator, fd, offset + rv,
+          GST_FD_MEMORY_FLAG_NONE);
+    gst_memory_resize (mem, offset, rv);
+    GST_MINI_OBJECT_FLAG_SET (mem, GST_MEMORY_FLAG_READONLY);
+    gst_mini_object_set_qdata (GST_MINI_OBJECT_CAST (mem),
+        gst_shm_src_buffer_quark (), gsb, free_buffer);
+
+    *outbuf = gst_buffer_new ();
+    gst_buffer_append_memory (*outbuf, mem);
+  } else {
+    *outbuf = gst_buffer_new_wrapped_full (GST_MEMORY_FLAG_READONLY,
+        buf, rv, 0, rv, gsb, free_buffer);
+  }
 
   return GST_FLOW_OK;
 
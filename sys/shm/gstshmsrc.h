@@ -56,6 +56,9 @@ struct _GstShmSrc
 
   GstFlowReturn flow_return;
   gboolean unlocked;
+
+  GstAllocator *dmabuf_allocator;
+  GstAllocator *fd_allocator;
 };
 
 struct _GstShmSrcClass
@@ -33,6 +33,11 @@
 #include <string.h>
 #include <assert.h>
 
+/* Size classes are powers of two from 4 kB up to 256 MB, anything bigger
+ * is always allocated with its exact size */
+#define SIZE_CLASS_MIN_SHIFT 12
+#define SIZE_CLASS_COUNT 17
+
 /* This is the allocated space to hold multiple blocks */
 struct _ShmAllocSpace
 {
@@ -41,6 +46,12 @@ struct _ShmAllocSpace
 
   /* chained list of the blocks contained in this space */
   ShmAllocBlock *blocks;
+
+  /* If set, allocations are rounded up to their size class and released
+   * blocks are kept in place on a per-class free list so they can be handed
+   * out again without walking the block list */
+  int use_size_classes;
+  ShmAllocBlock *free_blocks[SIZE_CLASS_COUNT];
 };
 
 /* A single block of data */
@@ -58,8 +69,15 @@ struct _ShmAllocBlock
 
   /* Pointer to the next block in the chain */
   ShmAllocBlock *next;
+
+  /* Size class of the block, -1 if it was allocated with its exact size */
+  int size_class;
+  /* Pointer to the next block in the free list of its size class */
+  ShmAllocBlock *next_free;
 };
 
+static void shm_alloc_space_free_block (ShmAllocBlock * block);
+
 
 ShmAllocSpace *
 shm_alloc_space_new (size_t size)
@@ -73,16 +91,56 @@ shm_alloc_space_new (size_t size)
   return self;
 }
 
+/* Releases all the blocks cached in the size class free lists */
+static void
+shm_alloc_space_purge (ShmAllocSpace * self)
+{
+  int i;
+
+  for (i = 0; i < SIZE_CLASS_COUNT; i++) {
+    while (self->free_blocks[i]) {
+      ShmAllocBlock *block = self->free_blocks[i];
+
+      self->free_blocks[i] = block->next_free;
+      shm_alloc_space_free_block (block);
+    }
+  }
+}
+
 void
 shm_alloc_space_free (ShmAllocSpace * self)
 {
-  assert (self && self->blocks == NULL);
+  assert (self);
+  shm_alloc_space_purge (self);
+  assert (self->blocks == NULL);
   spalloc_free (ShmAllocSpace, self);
 }
 
+void
+shm_alloc_space_set_size_classes (ShmAllocSpace * self, int enable)
+{
+  self->use_size_classes = enable;
 
-ShmAllocBlock *
-shm_alloc_space_alloc_block (ShmAllocSpace * self, unsigned long size)
+  if (!enable)
+    shm_alloc_space_purge (self);
+}
+
+static int
+shm_alloc_get_size_class (unsigned long size)
+{
+  int i;
+
+  for (i = 0; i < SIZE_CLASS_COUNT; i++) {
+    if (size <= (1UL << (SIZE_CLASS_MIN_SHIFT + i)))
+      return i;
+  }
+
+  return -1;
+}
+
+static ShmAllocBlock *
+shm_alloc_space_alloc_block_first_fit (ShmAllocSpace * self,
+    unsigned long size)
 {
   ShmAllocBlock *block;
   ShmAllocBlock *item = NULL;
@@ -114,6 +172,7 @@ shm_alloc_space_alloc_block (ShmAllocSpace * self, unsigned long size)
   block->size = size;
   block->use_count = 1;
   block->space = self;
+  block->size_class = -1;
 
   if (prev_item)
     prev_item->next = block;
@@ -125,6 +184,53 @@ shm_alloc_space_alloc_block (ShmAllocSpace * self, unsigned long size)
   return block;
 }
 
+ShmAllocBlock *
+shm_alloc_space_alloc_block (ShmAllocSpace * self, unsigned long size)
+{
+  ShmAllocBlock *block;
+  unsigned long class_size;
+  int size_class;
+
+  if (!self->use_size_classes)
+    return shm_alloc_space_alloc_block_first_fit (self, size);
+
+  size_class = shm_alloc_get_size_class (size);
+  if (size_class < 0) {
+    block = shm_alloc_space_alloc_block_first_fit (self, size);
+    if (!block) {
+      shm_alloc_space_purge (self);
+      block = shm_alloc_space_alloc_block_first_fit (self, size);
+    }
+    return block;
+  }
+
+  /* Fast path, re-use a block of the same class */
+  block = self->free_blocks[size_class];
+  if (block) {
+    self->free_blocks[size_class] = block->next_free;
+    block->next_free = NULL;
+    block->use_count = 1;
+    return block;
+  }
+
+  class_size = 1UL << (SIZE_CLASS_MIN_SHIFT + size_class);
+  block = shm_alloc_space_alloc_block_first_fit (self, class_size);
+  if (!block) {
+    /* Give the cached blocks back and try again */
+    shm_alloc_space_purge (self);
+    block = shm_alloc_space_alloc_block_first_fit (self, class_size);
+  }
+
+  if (block) {
+    block->size_class = size_class;
+    return block;
+  }
+
+  /* Rounding up made it too big for the remaining space, try the exact
+   * size, such a block is never cached */
+  return shm_alloc_space_alloc_block_first_fit (self, size);
+}
+
 unsigned long
 shm_alloc_space_alloc_block_get_offset (ShmAllocBlock * block)
 {
@@ -177,6 +283,16 @@ shm_alloc_space_block_dec (ShmAllocBlock * block)
 {
   block->use_count--;
 
-  if (block->use_count <= 0)
-    shm_alloc_space_free_block (block);
+  if (block->use_count > 0)
+    return;
+
+  if (block->space->use_size_classes && block->size_class >= 0) {
+    ShmAllocSpace *space = block->space;
+
+    block->next_free = space->free_blocks[block->size_class];
+    space->free_blocks[block->size_class] = block;
+    return;
+  }
+
+  shm_alloc_space_free_block (block);
 }
@@ -55,6 +55,7 @@ typedef struct _ShmAllocBlock ShmAllocBlock;
 
 ShmAllocSpace *shm_alloc_space_new (size_t size);
 void shm_alloc_space_free (ShmAllocSpace * self);
+void shm_alloc_space_set_size_classes (ShmAllocSpace * self, int enable);
 
 
 ShmAllocBlock *shm_alloc_space_alloc_block (ShmAllocSpace * self,
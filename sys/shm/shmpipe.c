@@ -67,9 +67,36 @@
  * type 4: ack buffer
  * offset
  *
+ * type 5: new ring area
+ * Area length
+ * Size of path (followed by path)
+ *
+ * type 6: ring wake-up
+ * No payload
+ *
+ * type 7: new fd area
+ * Area length
+ * Flags
+ * The fd itself is attached to the message (SCM_RIGHTS)
+ *
  * Type 4 goes from the client to the server
+ * Type 6 goes both ways
  * The rest are from the server to the client
- * The client should never write in the SHM
+ * The client should never write in the SHM, except in the ring area
+ *
+ * If the writer has ring slots enabled, it creates a separate small shm
+ * area per client that both sides map read-write. It contains two single
+ * producer, single consumer rings: one carrying the buffers (what type 3
+ * carries) from the writer to the client and one carrying the acks (what
+ * type 4 carries) back. The indexes live in the shared mapping and are only
+ * ever advanced by their owner. Each side flags when it is about to sleep
+ * on the socket and type 6 is only sent if the other side had set that flag,
+ * so a busy pipe exchanges no messages on the socket at all.
+ *
+ * Buffers that already live in a memfd or a dmabuf are not copied, the fd
+ * is sent to each client once as a type 7 area, then its buffers are
+ * signalled like any other. Every client keeps a limited number of fd
+ * areas, the least recently used one gets a type 2 when it is evicted.
  */
 
 
@@ -80,10 +107,62 @@ enum
   COMMAND_NEW_SHM_AREA = 1,
   COMMAND_CLOSE_SHM_AREA = 2,
   COMMAND_NEW_BUFFER = 3,
-  COMMAND_ACK_BUFFER = 4
+  COMMAND_ACK_BUFFER = 4,
+  COMMAND_NEW_RING = 5,
+  COMMAND_RING_WAKE = 6,
+  COMMAND_NEW_FD_AREA = 7
 };
 
+#define FD_AREA_DMABUF (1 << 0)
+
+/* Number of fd areas each client keeps */
+#define FD_CACHE_SIZE 16
+
+#define RING_MAGIC 0x53485252
+#define RING_MAX_SLOTS 65536
+#define RING_CACHELINE 64
+
+#define RING_LOAD(p) __atomic_load_n ((p), __ATOMIC_ACQUIRE)
+#define RING_STORE(p, v) __atomic_store_n ((p), (v), __ATOMIC_RELEASE)
+#define RING_EXCHANGE(p, v) __atomic_exchange_n ((p), (v), __ATOMIC_SEQ_CST)
+#define RING_FENCE() __atomic_thread_fence (__ATOMIC_SEQ_CST)
+
+typedef struct
+{
+  int32_t area_id;
+  uint32_t reserved;
+  uint64_t offset;
+  uint64_t size;
+} ShmRingSlot;
+
+typedef struct
+{
+  /* Only advanced by the producer */
+  uint32_t head;
+  /* Set by the producer when it waits for a free slot */
+  uint32_t producer_waiting;
+  uint8_t padding1[RING_CACHELINE - 8];
+
+  /* Only advanced by the consumer */
+  uint32_t tail;
+  /* Set by the consumer when it waits for a new slot */
+  uint32_t consumer_waiting;
+  uint8_t padding2[RING_CACHELINE - 8];
+} ShmRingIndex;
+
+/* Layout of the ring area, followed by the buffer slots and the ack slots */
+typedef struct
+{
+  uint32_t magic;
+  uint32_t num_slots;
+  uint8_t padding[RING_CACHELINE - 8];
+
+  ShmRingIndex buffers;
+  ShmRingIndex acks;
+} ShmRingHeader;
+
 typedef struct _ShmArea ShmArea;
+typedef struct _ShmRing ShmRing;
 
 struct _ShmArea
 {
@@ -101,9 +180,27 @@ struct _ShmArea
 
   ShmAllocSpace *allocspace;
 
+  /* Set if this maps a memfd or dmabuf that was passed over the socket */
+  int is_fd;
+  int is_dmabuf;
+  dev_t dev;
+  ino_t ino;
+
   ShmArea *next;
 };
 
+struct _ShmRing
+{
+  ShmArea *area;
+
+  ShmRingHeader *header;
+  /* Local copy, never trust what is in the shared header */
+  uint32_t num_slots;
+
+  ShmRingSlot *buffer_slots;
+  ShmRingSlot *ack_slots;
+};
+
 struct _ShmBuffer
 {
   int use_count;
@@ -135,18 +232,31 @@ struct _ShmPipe
 
   int next_area_id;
 
+  /* memfd/dmabuf areas sent to clients, only used by writers */
+  ShmArea *fd_areas;
+
   ShmBuffer *buffers;
 
   int num_clients;
   ShmClient *clients;
 
   mode_t perms;
+
+  unsigned int ring_slots;
+  /* Ring shared with the writer, only used by clients */
+  ShmRing *ring;
 };
 
 struct _ShmClient
 {
   int fd;
 
+  ShmRing *ring;
+
+  ShmArea *fd_cache[FD_CACHE_SIZE];
+  unsigned long fd_cache_last_use[FD_CACHE_SIZE];
+  unsigned long fd_cache_counter;
+
   ShmClient *next;
 };
 
@@ -179,11 +289,18 @@ struct CommandBuffer
     {
       unsigned long offset;
     } ack_buffer;
+    struct
+    {
+      size_t size;
+      unsigned int flags;
+    } new_fd_area;
   } payload;
 };
 
-static ShmArea *sp_open_shm (char *path, int id, mode_t perms, size_t size);
+static ShmArea *sp_open_shm (char *path, int id, mode_t perms, size_t size,
+    int is_ring);
 static void sp_close_shm (ShmArea * area);
+static void sp_close_ring (ShmRing * ring);
 static int sp_shmbuf_dec (ShmPipe * self, ShmBuffer * buf,
     ShmBuffer * prev_buf, ShmClient * client, void **tag);
 static void sp_shm_area_dec (ShmPipe * self, ShmArea * area);
@@ -244,7 +361,7 @@ sp_writer_create (const char *path, size_t size, mode_t perms)
   if (listen (self->main_socket, LISTEN_BACKLOG) < 0)
     RETURN_ERROR ("listen() failed (%d): %s\n", errno, strerror (errno));
 
-  self->shm_area = sp_open_shm (NULL, ++self->next_area_id, perms, size);
+  self->shm_area = sp_open_shm (NULL, ++self->next_area_id, perms, size, 0);
 
   self->perms = perms;
 
@@ -266,12 +383,14 @@ sp_writer_create (const char *path, size_t size, mode_t perms)
 /* sp_open_shm:
  * @path: Path of the shm area for a reader,
  *  NULL if this is a writer (then it will allocate its own path)
+ * @is_ring: Whether this is a ring area, which the reader also maps
+ *  writable and which has no allocator
  *
  * Opens a ShmArea
  */
 
 static ShmArea *
-sp_open_shm (char *path, int id, mode_t perms, size_t size)
+sp_open_shm (char *path, int id, mode_t perms, size_t size, int is_ring)
 {
   ShmArea *area = spalloc_new (ShmArea);
   char tmppath[32];
@@ -290,7 +409,7 @@ sp_open_shm (char *path, int id, mode_t perms, size_t size)
 
 
   if (path)
-    flags = O_RDONLY;
+    flags = is_ring ? O_RDWR : O_RDONLY;
   else
 #ifdef HAVE_OSX
     flags = O_RDWR | O_CREAT | O_EXCL;
@@ -323,7 +442,7 @@ sp_open_shm (char *path, int id, mode_t perms, size_t size)
     prot = PROT_READ | PROT_WRITE;
   } else {
     area->shm_area_name = strdup (path);
-    prot = PROT_READ;
+    prot = is_ring ? PROT_READ | PROT_WRITE : PROT_READ;
   }
 
   area->shm_area_buf = mmap (NULL, size, prot, MAP_SHARED, area->shm_fd, 0);
@@ -333,7 +452,7 @@ sp_open_shm (char *path, int id, mode_t perms, size_t size)
 
   area->id = id;
 
-  if (!path)
+  if (!path && !is_ring)
     area->allocspace = shm_alloc_space_new (area->shm_area_len);
 
   return area;
@@ -379,13 +498,17 @@ sp_shm_area_dec (ShmPipe * self, ShmArea * area)
   if (area->use_count == 0) {
     ShmArea *item = NULL;
     ShmArea *prev_item = NULL;
+    /* The writer keeps the fd areas apart so the first shm area is always
+     * the one it allocates from */
+    ShmArea **head = (area->is_fd && area->is_writer) ?
+        &self->fd_areas : &self->shm_area;
 
-    for (item = self->shm_area; item; item = item->next) {
+    for (item = *head; item; item = item->next) {
       if (item == area) {
         if (prev_item)
           prev_item->next = item->next;
         else
-          self->shm_area = item->next;
+          *head = item->next;
         break;
       }
       prev_item = item;
@@ -425,6 +548,9 @@ sp_dec (ShmPipe * self)
   while (self->shm_area)
     sp_shm_area_dec (self, self->shm_area);
 
+  if (self->ring)
+    sp_close_ring (self->ring);
+
   spalloc_free (ShmPipe, self);
 }
 
@@ -484,6 +610,263 @@ send_command (int fd, struct CommandBuffer *cb, unsigned short int type,
   return 1;
 }
 
+static int
+send_command_fd (int fd, struct CommandBuffer *cb, unsigned short int type,
+    int area_id, int passed_fd)
+{
+  struct msghdr msg;
+  struct iovec iov;
+  struct cmsghdr *cmsg;
+  union
+  {
+    struct cmsghdr hdr;
+    char buf[CMSG_SPACE (sizeof (int))];
+  } control;
+
+  cb->type = type;
+  cb->area_id = area_id;
+
+  memset (&msg, 0, sizeof (msg));
+  memset (&control, 0, sizeof (control));
+  iov.iov_base = cb;
+  iov.iov_len = sizeof (struct CommandBuffer);
+  msg.msg_iov = &iov;
+  msg.msg_iovlen = 1;
+  msg.msg_control = control.buf;
+  msg.msg_controllen = sizeof (control.buf);
+
+  cmsg = CMSG_FIRSTHDR (&msg);
+  cmsg->cmsg_level = SOL_SOCKET;
+  cmsg->cmsg_type = SCM_RIGHTS;
+  cmsg->cmsg_len = CMSG_LEN (sizeof (int));
+  memcpy (CMSG_DATA (cmsg), &passed_fd, sizeof (int));
+
+  if (sendmsg (fd, &msg, MSG_NOSIGNAL) != sizeof (struct CommandBuffer))
+    return 0;
+
+  return 1;
+}
+
+static int
+send_ring_wake (int fd)
+{
+  struct CommandBuffer cb = { 0 };
+
+  return send_command (fd, &cb, COMMAND_RING_WAKE, 0);
+}
+
+static size_t
+sp_ring_area_size (uint32_t num_slots)
+{
+  return sizeof (ShmRingHeader) + 2 * num_slots * sizeof (ShmRingSlot);
+}
+
+static ShmRing *
+sp_ring_new (ShmArea * area, uint32_t num_slots)
+{
+  ShmRing *ring = spalloc_new (ShmRing);
+
+  ring->area = area;
+  ring->header = (ShmRingHeader *) area->shm_area_buf;
+  ring->num_slots = num_slots;
+  ring->buffer_slots = (ShmRingSlot *) (ring->header + 1);
+  ring->ack_slots = ring->buffer_slots + num_slots;
+
+  return ring;
+}
+
+static void
+sp_close_ring (ShmRing * ring)
+{
+  ring->area->use_count--;
+  sp_close_shm (ring->area);
+  spalloc_free (ShmRing, ring);
+}
+
+/* Queues @slot, returns 0 if the ring is full. @wake is set if the
+ * consumer was sleeping and must be sent a COMMAND_RING_WAKE */
+static int
+sp_ring_push (ShmRingIndex * index, ShmRingSlot * slots, uint32_t num_slots,
+    const ShmRingSlot * slot, int *wake)
+{
+  uint32_t head = index->head;
+
+  if (head - RING_LOAD (&index->tail) >= num_slots)
+    return 0;
+
+  slots[head & (num_slots - 1)] = *slot;
+  RING_STORE (&index->head, head + 1);
+
+  /* Pairs with the fence in sp_ring_wait_consumer() */
+  RING_FENCE ();
+  *wake = RING_LOAD (&index->consumer_waiting) &&
+      RING_EXCHANGE (&index->consumer_waiting, 0);
+
+  return 1;
+}
+
+/* Copies the oldest slot without releasing it. Returns 0 if the ring is
+ * empty and -1 if the indexes make no sense */
+static int
+sp_ring_peek (ShmRingIndex * index, ShmRingSlot * slots, uint32_t num_slots,
+    ShmRingSlot * slot)
+{
+  uint32_t tail = index->tail;
+  uint32_t head = RING_LOAD (&index->head);
+
+  if (head == tail)
+    return 0;
+
+  if (head - tail > num_slots)
+    return -1;
+
+  *slot = slots[tail & (num_slots - 1)];
+
+  return 1;
+}
+
+/* Releases the slot returned by sp_ring_peek(), returns 1 if the producer
+ * was waiting for a free slot and must be sent a COMMAND_RING_WAKE */
+static int
+sp_ring_advance (ShmRingIndex * index)
+{
+  RING_STORE (&index->tail, index->tail + 1);
+
+  /* Pairs with the fence in sp_ring_wait_producer() */
+  RING_FENCE ();
+  return RING_LOAD (&index->producer_waiting) &&
+      RING_EXCHANGE (&index->producer_waiting, 0);
+}
+
+/* Flags the consumer as sleeping, returns 0 if a slot was queued in the
+ * mean time, in which case it should not go to sleep */
+static int
+sp_ring_wait_consumer (ShmRingIndex * index)
+{
+  RING_STORE (&index->consumer_waiting, 1);
+  RING_FENCE ();
+
+  if (RING_LOAD (&index->head) != index->tail) {
+    RING_STORE (&index->consumer_waiting, 0);
+    return 0;
+  }
+
+  return 1;
+}
+
+/* Flags the producer as sleeping, returns 0 if a slot was freed in the
+ * mean time, in which case it should not go to sleep */
+static int
+sp_ring_wait_producer (ShmRingIndex * index, uint32_t num_slots)
+{
+  RING_STORE (&index->producer_waiting, 1);
+  RING_FENCE ();
+
+  if (index->head - RING_LOAD (&index->tail) < num_slots) {
+    RING_STORE (&index->producer_waiting, 0);
+    return 0;
+  }
+
+  return 1;
+}
+
+static ShmRing *
+sp_writer_open_ring (ShmPipe * self)
+{
+  ShmArea *area;
+  ShmRing *ring;
+
+  area = sp_open_shm (NULL, 0, self->perms,
+      sp_ring_area_size (self->ring_slots), 1);
+  if (!area)
+    return NULL;
+
+  ring = sp_ring_new (area, self->ring_slots);
+  ring->header->num_slots = self->ring_slots;
+
+  /* The client only starts looking at the rings once it got the
+   * COMMAND_NEW_RING, so the first slot of each must be signalled */
+  ring->header->buffers.consumer_waiting = 1;
+  ring->header->acks.consumer_waiting = 1;
+  RING_STORE (&ring->header->magic, RING_MAGIC);
+
+  return ring;
+}
+
+static int
+sp_client_open_ring (ShmPipe * self, char *path, size_t size)
+{
+  ShmArea *area;
+  ShmRingHeader *header;
+  uint32_t num_slots;
+
+  if (size < sizeof (ShmRingHeader))
+    return -5;
+
+  area = sp_open_shm (path, 0, 0, size, 1);
+  if (!area)
+    return -4;
+
+  header = (ShmRingHeader *) area->shm_area_buf;
+  num_slots = header->num_slots;
+
+  if (RING_LOAD (&header->magic) != RING_MAGIC || num_slots == 0 ||
+      num_slots > RING_MAX_SLOTS || (num_slots & (num_slots - 1)) != 0 ||
+      size < sp_ring_area_size (num_slots)) {
+    area->use_count--;
+    sp_close_shm (area);
+    return -5;
+  }
+
+  if (self->ring)
+    sp_close_ring (self->ring);
+  self->ring = sp_ring_new (area, num_slots);
+
+  return 0;
+}
+
+int
+sp_writer_set_ring_slots (ShmPipe * self, unsigned int slots)
+{
+  ShmArea *area;
+  unsigned int num_slots = 0;
+
+  if (slots > RING_MAX_SLOTS)
+    slots = RING_MAX_SLOTS;
+
+  if (slots > 0)
+    for (num_slots = 1; num_slots < slots; num_slots <<= 1);
+
+  self->ring_slots = num_slots;
+
+  for (area = self->shm_area; area; area = area->next) {
+    if (area->allocspace)
+      shm_alloc_space_set_size_classes (area->allocspace, num_slots > 0);
+  }
+
+  return num_slots;
+}
+
+int
+sp_writer_can_send (ShmPipe * self)
+{
+  ShmClient *client;
+
+  for (client = self->clients; client; client = client->next) {
+    ShmRing *ring = client->ring;
+
+    if (!ring)
+      continue;
+
+    if (ring->header->buffers.head -
+        RING_LOAD (&ring->header->buffers.tail) >= ring->num_slots &&
+        sp_ring_wait_producer (&ring->header->buffers, ring->num_slots))
+      return 0;
+  }
+
+  return 1;
+}
+
 int
 sp_writer_resize (ShmPipe * self, size_t size)
 {
@@ -496,11 +879,14 @@ sp_writer_resize (ShmPipe * self, size_t size)
   if (self->shm_area->shm_area_len == size)
     return 0;
 
-  newarea = sp_open_shm (NULL, ++self->next_area_id, self->perms, size);
+  newarea = sp_open_shm (NULL, ++self->next_area_id, self->perms, size, 0);
 
   if (!newarea)
     return -1;
 
+  if (self->ring_slots)
+    shm_alloc_space_set_size_classes (newarea->allocspace, 1);
+
   old_current = self->shm_area;
   newarea->next = self->shm_area;
   self->shm_area = newarea;
@@ -572,36 +958,108 @@ sp_writer_free_block (ShmBlock * block)
   spalloc_free (ShmBlock, block);
 }
 
-/* Returns the number of client this has successfully been sent to */
+/* Makes sure the client has @area mapped, evicting the fd area it used
+ * least recently if needed */
+static int
+sp_writer_cache_fd_area (ShmPipe * self, ShmClient * client, ShmArea * area)
+{
+  struct CommandBuffer cb = { 0 };
+  int slot = 0;
+  int i;
 
-int
-sp_writer_send_buf (ShmPipe * self, char *buf, size_t size, void *tag)
+  client->fd_cache_counter++;
+
+  for (i = 0; i < FD_CACHE_SIZE; i++) {
+    if (client->fd_cache[i] == area) {
+      client->fd_cache_last_use[i] = client->fd_cache_counter;
+      return 1;
+    }
+
+    if (client->fd_cache[slot] && (!client->fd_cache[i] ||
+            client->fd_cache_last_use[i] < client->fd_cache_last_use[slot]))
+      slot = i;
+  }
+
+  if (client->fd_cache[slot]) {
+    ShmArea *old_area = client->fd_cache[slot];
+
+    /* The client keeps it until it has released its buffers */
+    client->fd_cache[slot] = NULL;
+    send_command (client->fd, &cb, COMMAND_CLOSE_SHM_AREA, old_area->id);
+    sp_shm_area_dec (self, old_area);
+  }
+
+  cb.payload.new_fd_area.size = area->shm_area_len;
+  cb.payload.new_fd_area.flags = area->is_dmabuf ? FD_AREA_DMABUF : 0;
+  if (!send_command_fd (client->fd, &cb, COMMAND_NEW_FD_AREA, area->id,
+          area->shm_fd))
+    return 0;
+
+  client->fd_cache[slot] = area;
+  client->fd_cache_last_use[slot] = client->fd_cache_counter;
+  sp_shm_area_inc (area);
+
+  return 1;
+}
+
+/* Returns the area for this memfd or dmabuf, identified by its inode so a
+ * buffer pool re-using the same fds only gets them sent once */
+static ShmArea *
+sp_writer_get_fd_area (ShmPipe * self, int fd, int is_dmabuf)
+{
+  ShmArea *area;
+  struct stat st;
+  off_t size;
+
+  if (fstat (fd, &st) < 0)
+    return NULL;
+
+  for (area = self->fd_areas; area; area = area->next) {
+    if (area->dev == st.st_dev && area->ino == st.st_ino)
+      return area;
+  }
+
+  /* dmabufs report their size with lseek() only */
+  size = st.st_size;
+  if (size == 0)
+    size = lseek (fd, 0, SEEK_END);
+  if (size <= 0)
+    return NULL;
+
+  area = spalloc_new (ShmArea);
+  memset (area, 0, sizeof (ShmArea));
+
+  area->shm_fd = fcntl (fd, F_DUPFD_CLOEXEC, 0);
+  if (area->shm_fd < 0) {
+    spalloc_free (ShmArea, area);
+    return NULL;
+  }
+
+  area->id = ++self->next_area_id;
+  area->shm_area_buf = MAP_FAILED;
+  area->shm_area_len = size;
+  area->is_writer = 1;
+  area->is_fd = 1;
+  area->is_dmabuf = is_dmabuf;
+  area->dev = st.st_dev;
+  area->ino = st.st_ino;
+
+  area->next = self->fd_areas;
+  self->fd_areas = area;
+
+  return area;
+}
+
+static int
+sp_writer_send_area_buf (ShmPipe * self, ShmArea * area,
+    ShmAllocBlock * ablock, unsigned long offset, size_t size, void *tag)
 {
-  ShmArea *area = NULL;
-  unsigned long offset = 0;
   unsigned long bsize = size;
   ShmBuffer *sb;
   ShmClient *client = NULL;
-  ShmAllocBlock *ablock = NULL;
   int i = 0;
   int c = 0;
 
-  if (self->num_clients == 0)
-    return 0;
-
-  for (area = self->shm_area; area; area = area->next) {
-    if (buf >= area->shm_area_buf &&
-        buf < (area->shm_area_buf + area->shm_area_len)) {
-      offset = buf - area->shm_area_buf;
-      ablock = shm_alloc_space_block_get (area->allocspace, offset);
-      assert (ablock);
-      break;
-    }
-  }
-
-  if (!ablock)
-    return -1;
-
   sb = spalloc_alloc (sizeof (ShmBuffer) + sizeof (int) * self->num_clients);
   memset (sb, 0, sizeof (ShmBuffer));
   memset (sb->clients, -1, sizeof (int) * self->num_clients);
@@ -613,11 +1071,29 @@ sp_writer_send_buf (ShmPipe * self, char *buf, size_t size, void *tag)
   sb->tag = tag;
 
   for (client = self->clients; client; client = client->next) {
-    struct CommandBuffer cb = { 0 };
-    cb.payload.buffer.offset = offset;
-    cb.payload.buffer.size = bsize;
-    if (!send_command (client->fd, &cb, COMMAND_NEW_BUFFER, self->shm_area->id))
+    if (area->is_fd && !sp_writer_cache_fd_area (self, client, area))
       continue;
+
+    if (client->ring) {
+      ShmRing *ring = client->ring;
+      ShmRingSlot slot = { area->id, 0, offset, bsize };
+      int wake = 0;
+
+      if (!sp_ring_push (&ring->header->buffers, ring->buffer_slots,
+              ring->num_slots, &slot, &wake))
+        continue;
+
+      /* If this fails, the client is gone and will be closed from the
+       * socket, the slot has been queued so it must be accounted for */
+      if (wake)
+        send_ring_wake (client->fd);
+    } else {
+      struct CommandBuffer cb = { 0 };
+      cb.payload.buffer.offset = offset;
+      cb.payload.buffer.size = bsize;
+      if (!send_command (client->fd, &cb, COMMAND_NEW_BUFFER, area->id))
+        continue;
+    }
     sb->clients[i++] = client->fd;
     c++;
   }
@@ -628,7 +1104,8 @@ sp_writer_send_buf (ShmPipe * self, char *buf, size_t size, void *tag)
   }
 
   sp_shm_area_inc (area);
-  shm_alloc_space_block_inc (ablock);
+  if (ablock)
+    shm_alloc_space_block_inc (ablock);
 
   sb->use_count = c;
 
@@ -638,6 +1115,59 @@ sp_writer_send_buf (ShmPipe * self, char *buf, size_t size, void *tag)
   return c;
 }
 
+/* Returns the number of client this has successfully been sent to */
+
+int
+sp_writer_send_buf (ShmPipe * self, char *buf, size_t size, void *tag)
+{
+  ShmArea *area = NULL;
+  unsigned long offset = 0;
+  ShmAllocBlock *ablock = NULL;
+
+  if (self->num_clients == 0)
+    return 0;
+
+  for (area = self->shm_area; area; area = area->next) {
+    if (buf >= area->shm_area_buf &&
+        buf < (area->shm_area_buf + area->shm_area_len)) {
+      offset = buf - area->shm_area_buf;
+      ablock = shm_alloc_space_block_get (area->allocspace, offset);
+      assert (ablock);
+      break;
+    }
+  }
+
+  if (!ablock)
+    return -1;
+
+  return sp_writer_send_area_buf (self, area, ablock, offset, size, tag);
+}
+
+int
+sp_writer_send_fd_buf (ShmPipe * self, int fd, int is_dmabuf,
+    unsigned long offset, size_t size, void *tag)
+{
+  ShmArea *area;
+  int c = -1;
+
+  if (self->num_clients == 0)
+    return 0;
+
+  area = sp_writer_get_fd_area (self, fd, is_dmabuf);
+  if (!area)
+    return -1;
+
+  /* Hold it while sending, it is dropped again if nobody uses it */
+  sp_shm_area_inc (area);
+
+  if (offset <= area->shm_area_len && size <= area->shm_area_len - offset)
+    c = sp_writer_send_area_buf (self, area, NULL, offset, size, tag);
+
+  sp_shm_area_dec (self, area);
+
+  return c;
+}
+
 static int
 recv_command (int fd, struct CommandBuffer *cb)
 {
@@ -651,6 +1181,110 @@ recv_command (int fd, struct CommandBuffer *cb)
   }
 }
 
+/* Like recv_command(), @passed_fd is set to the fd attached to the
+ * message, or -1 */
+static int
+recv_command_fd (int fd, struct CommandBuffer *cb, int *passed_fd)
+{
+  struct msghdr msg;
+  struct iovec iov;
+  struct cmsghdr *cmsg;
+  union
+  {
+    struct cmsghdr hdr;
+    char buf[CMSG_SPACE (sizeof (int))];
+  } control;
+  int flags = MSG_DONTWAIT;
+  int retval;
+
+#ifdef MSG_CMSG_CLOEXEC
+  flags |= MSG_CMSG_CLOEXEC;
+#endif
+
+  *passed_fd = -1;
+
+  memset (&msg, 0, sizeof (msg));
+  iov.iov_base = cb;
+  iov.iov_len = sizeof (struct CommandBuffer);
+  msg.msg_iov = &iov;
+  msg.msg_iovlen = 1;
+  msg.msg_control = control.buf;
+  msg.msg_controllen = sizeof (control.buf);
+
+  retval = recvmsg (fd, &msg, flags);
+
+  for (cmsg = CMSG_FIRSTHDR (&msg); retval >= 0 && cmsg;
+      cmsg = CMSG_NXTHDR (&msg, cmsg)) {
+    if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_RIGHTS &&
+        cmsg->cmsg_len >= CMSG_LEN (sizeof (int))) {
+      memcpy (passed_fd, CMSG_DATA (cmsg), sizeof (int));
+      break;
+    }
+  }
+
+  if (retval == sizeof (struct CommandBuffer))
+    return 1;
+
+  if (*passed_fd >= 0) {
+    close (*passed_fd);
+    *passed_fd = -1;
+  }
+
+  return 0;
+}
+
+static ShmArea *
+sp_client_open_fd_area (int fd, int id, size_t size, unsigned int flags)
+{
+  ShmArea *area = spalloc_new (ShmArea);
+
+  memset (area, 0, sizeof (ShmArea));
+
+  area->id = id;
+  area->use_count = 1;
+  area->shm_fd = fd;
+  area->shm_area_len = size;
+  area->is_fd = 1;
+  area->is_dmabuf = (flags & FD_AREA_DMABUF) != 0;
+
+  /* The passed fd is not mapped here, dmabufs can't always be mapped by
+   * the CPU and the reader gets the fd back with sp_client_buf_get_fd() to
+   * map or import it itself. Only reserve an address range, the addresses
+   * identify the buffers of the area like for the other areas */
+  area->shm_area_buf = mmap (NULL, size, PROT_NONE,
+      MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (area->shm_area_buf == MAP_FAILED) {
+    fprintf (stderr, "Reserving %zu bytes for passed fd failed (%d): %s\n",
+        size, errno, strerror (errno));
+    area->use_count--;
+    sp_close_shm (area);
+    return NULL;
+  }
+
+  return area;
+}
+
+static char *
+recv_area_name (int fd, struct CommandBuffer *cb)
+{
+  char *area_name;
+  int retval;
+
+  assert (cb->payload.new_shm_area.path_size > 0);
+  assert (cb->payload.new_shm_area.size > 0);
+
+  area_name = malloc (cb->payload.new_shm_area.path_size + 1);
+  retval = recv (fd, area_name, cb->payload.new_shm_area.path_size, 0);
+  if (retval != cb->payload.new_shm_area.path_size) {
+    free (area_name);
+    return NULL;
+  }
+  /* Ensure area_name is NULL terminated */
+  area_name[retval] = 0;
+
+  return area_name;
+}
+
 long int
 sp_client_recv (ShmPipe * self, char **buf)
 {
@@ -658,28 +1292,25 @@ sp_client_recv (ShmPipe * self, char **buf)
   ShmArea *newarea;
   ShmArea *area;
   struct CommandBuffer cb;
+  int passed_fd;
   int retval;
 
-  if (!recv_command (self->main_socket, &cb))
+  if (!recv_command_fd (self->main_socket, &cb, &passed_fd))
     return -1;
 
+  if (passed_fd >= 0 && cb.type != COMMAND_NEW_FD_AREA) {
+    close (passed_fd);
+    passed_fd = -1;
+  }
+
   switch (cb.type) {
     case COMMAND_NEW_SHM_AREA:
-      assert (cb.payload.new_shm_area.path_size > 0);
-      assert (cb.payload.new_shm_area.size > 0);
-
-      area_name = malloc (cb.payload.new_shm_area.path_size + 1);
-      retval = recv (self->main_socket, area_name,
-          cb.payload.new_shm_area.path_size, 0);
-      if (retval != cb.payload.new_shm_area.path_size) {
-        free (area_name);
+      area_name = recv_area_name (self->main_socket, &cb);
+      if (!area_name)
         return -3;
-      }
-      /* Ensure area_name is NULL terminated */
-      area_name[retval] = 0;
 
       newarea = sp_open_shm (area_name, cb.area_id, 0,
-          cb.payload.new_shm_area.size);
+          cb.payload.new_shm_area.size, 0);
       free (area_name);
       if (!newarea)
         return -4;
@@ -708,6 +1339,34 @@ sp_client_recv (ShmPipe * self, char **buf)
       }
       return -23;
 
+    case COMMAND_NEW_RING:
+      area_name = recv_area_name (self->main_socket, &cb);
+      if (!area_name)
+        return -3;
+
+      retval = sp_client_open_ring (self, area_name,
+          cb.payload.new_shm_area.size);
+      free (area_name);
+      if (retval < 0)
+        return retval;
+      break;
+
+    case COMMAND_RING_WAKE:
+      break;
+
+    case COMMAND_NEW_FD_AREA:
+      if (passed_fd < 0)
+        return -6;
+
+      newarea = sp_client_open_fd_area (passed_fd, cb.area_id,
+          cb.payload.new_fd_area.size, cb.payload.new_fd_area.flags);
+      if (!newarea)
+        return -4;
+
+      newarea->next = self->shm_area;
+      self->shm_area = newarea;
+      break;
+
     default:
       return -99;
   }
@@ -715,10 +1374,68 @@ sp_client_recv (ShmPipe * self, char **buf)
   return 0;
 }
 
+long int
+sp_client_recv_ring (ShmPipe * self, char **buf)
+{
+  ShmRing *ring = self->ring;
+  ShmRingSlot slot;
+  ShmArea *area;
+  int retval;
+
+  if (!ring)
+    return 0;
+
+  while ((retval = sp_ring_peek (&ring->header->buffers, ring->buffer_slots,
+              ring->num_slots, &slot)) == 0) {
+    if (sp_ring_wait_consumer (&ring->header->buffers))
+      return 0;
+  }
+
+  if (retval < 0)
+    return -3;
+
+  for (area = self->shm_area; area; area = area->next) {
+    if (area->id == slot.area_id)
+      break;
+  }
+
+  /* A new area is announced on the socket before it is used, so leave the
+   * slot in the ring until that command has been read */
+  if (!area)
+    return 0;
+
+  if (slot.offset > area->shm_area_len ||
+      slot.size > area->shm_area_len - slot.offset)
+    return -23;
+
+  if (sp_ring_advance (&ring->header->buffers) &&
+      !send_ring_wake (self->main_socket))
+    return -1;
+
+  *buf = area->shm_area_buf + slot.offset;
+  sp_shm_area_inc (area);
+
+  return slot.size;
+}
+
+static int
+sp_writer_ack_buffer (ShmPipe * self, ShmClient * client, int area_id,
+    unsigned long offset, void **tag)
+{
+  ShmBuffer *buf = NULL, *prev_buf = NULL;
+
+  for (buf = self->buffers; buf; buf = buf->next) {
+    if (buf->shm_area->id == area_id && buf->offset == offset)
+      return sp_shmbuf_dec (self, buf, prev_buf, client, tag);
+    prev_buf = buf;
+  }
+
+  return -2;
+}
+
 int
 sp_writer_recv (ShmPipe * self, ShmClient * client, void **tag)
 {
-  ShmBuffer *buf = NULL, *prev_buf = NULL;
   struct CommandBuffer cb;
 
   if (!recv_command (client->fd, &cb))
@@ -726,16 +1443,11 @@ sp_writer_recv (ShmPipe * self, ShmClient * client, void **tag)
 
   switch (cb.type) {
     case COMMAND_ACK_BUFFER:
-
-      for (buf = self->buffers; buf; buf = buf->next) {
-        if (buf->shm_area->id == cb.area_id &&
-            buf->offset == cb.payload.ack_buffer.offset) {
-          return sp_shmbuf_dec (self, buf, prev_buf, client, tag);
-        }
-        prev_buf = buf;
-      }
-
-      return -2;
+      return sp_writer_ack_buffer (self, client, cb.area_id,
+          cb.payload.ack_buffer.offset, tag);
+    case COMMAND_RING_WAKE:
+      /* The acks are picked up by sp_writer_recv_acks() */
+      return 1;
     default:
       return -99;
   }
@@ -743,11 +1455,49 @@ sp_writer_recv (ShmPipe * self, ShmClient * client, void **tag)
   return 0;
 }
 
+int
+sp_writer_recv_acks (ShmPipe * self, ShmClient * client,
+    sp_buffer_free_callback callback, void *user_data)
+{
+  ShmRing *ring = client->ring;
+  ShmRingSlot slot;
+  int count = 0;
+  int retval;
+
+  if (!ring)
+    return 0;
+
+  do {
+    while ((retval = sp_ring_peek (&ring->header->acks, ring->ack_slots,
+                ring->num_slots, &slot)) > 0) {
+      void *tag = NULL;
+
+      /* The client never waits for room in the ack ring, it falls back to
+       * the socket instead */
+      sp_ring_advance (&ring->header->acks);
+
+      retval = sp_writer_ack_buffer (self, client, slot.area_id, slot.offset,
+          &tag);
+      if (retval < 0)
+        return retval;
+      if (retval == 0 && callback)
+        callback (tag, user_data);
+      count++;
+    }
+
+    if (retval < 0)
+      return -3;
+  } while (!sp_ring_wait_consumer (&ring->header->acks));
+
+  return count;
+}
+
 int
 sp_client_recv_finish (ShmPipe * self, char *buf)
 {
   ShmArea *shm_area = NULL;
   unsigned long offset;
+  int area_id;
   struct CommandBuffer cb = { 0 };
 
   for (shm_area = self->shm_area; shm_area; shm_area = shm_area->next) {
@@ -759,12 +1509,48 @@ sp_client_recv_finish (ShmPipe * self, char *buf)
   assert (shm_area);
 
   offset = buf - shm_area->shm_area_buf;
+  area_id = shm_area->id;
 
   sp_shm_area_dec (self, shm_area);
 
+  if (self->ring) {
+    ShmRing *ring = self->ring;
+    ShmRingSlot slot = { area_id, 0, offset, 0 };
+    int wake = 0;
+
+    if (sp_ring_push (&ring->header->acks, ring->ack_slots, ring->num_slots,
+            &slot, &wake))
+      return wake ? send_ring_wake (self->main_socket) : 1;
+
+    /* The ring is full, acks can arrive in any order so just use the
+     * socket for this one */
+    cb.payload.ack_buffer.offset = offset;
+    return send_command (self->main_socket, &cb, COMMAND_ACK_BUFFER, area_id);
+  }
+
   cb.payload.ack_buffer.offset = offset;
-  return send_command (self->main_socket, &cb, COMMAND_ACK_BUFFER,
-      self->shm_area->id);
+  return send_command (self->main_socket, &cb, COMMAND_ACK_BUFFER, area_id);
+}
+
+int
+sp_client_buf_get_fd (ShmPipe * self, char *buf, unsigned long *offset,
+    int *is_dmabuf)
+{
+  ShmArea *shm_area;
+
+  for (shm_area = self->shm_area; shm_area; shm_area = shm_area->next) {
+    if (buf >= shm_area->shm_area_buf &&
+        buf < shm_area->shm_area_buf + shm_area->shm_area_len)
+      break;
+  }
+
+  if (!shm_area || !shm_area->is_fd)
+    return -1;
+
+  *offset = buf - shm_area->shm_area_buf;
+  *is_dmabuf = shm_area->is_dmabuf;
+
+  return shm_area->shm_fd;
 }
 
 ShmPipe *
@@ -808,6 +1594,7 @@ ShmClient *
 sp_writer_accept_client (ShmPipe * self)
 {
   ShmClient *client = NULL;
+  ShmRing *ring = NULL;
   int fd;
   struct CommandBuffer cb = { 0 };
   int pathlen = strlen (self->shm_area->shm_area_name) + 1;
@@ -833,8 +1620,31 @@ sp_writer_accept_client (ShmPipe * self)
     goto error;
   }
 
+  if (self->ring_slots) {
+    ring = sp_writer_open_ring (self);
+
+    /* Without a ring, the client just uses the socket */
+    if (ring) {
+      pathlen = strlen (ring->area->shm_area_name) + 1;
+      cb.payload.new_shm_area.size = ring->area->shm_area_len;
+      cb.payload.new_shm_area.path_size = pathlen;
+      if (!send_command (fd, &cb, COMMAND_NEW_RING, 0)) {
+        fprintf (stderr, "Sending new ring failed: %s", strerror (errno));
+        goto error;
+      }
+
+      if (send (fd, ring->area->shm_area_name, pathlen, MSG_NOSIGNAL) !=
+          pathlen) {
+        fprintf (stderr, "Sending new ring path failed: %s", strerror (errno));
+        goto error;
+      }
+    }
+  }
+
   client = spalloc_new (ShmClient);
+  memset (client, 0, sizeof (ShmClient));
   client->fd = fd;
+  client->ring = ring;
 
   /* Prepend ot linked list */
   client->next = self->clients;
@@ -844,6 +1654,8 @@ sp_writer_accept_client (ShmPipe * self)
   return client;
 
 error:
+  if (ring)
+    sp_close_ring (ring);
   shutdown (fd, SHUT_RDWR);
   close (fd);
   return NULL;
@@ -881,7 +1693,8 @@ sp_shmbuf_dec (ShmPipe * self, ShmBuffer * buf, ShmBuffer * prev_buf,
 
     if (tag)
       *tag = buf->tag;
-    shm_alloc_space_block_dec (buf->ablock);
+    if (buf->ablock)
+      shm_alloc_space_block_dec (buf->ablock);
     sp_shm_area_dec (self, buf->shm_area);
     spalloc_free1 (sizeof (ShmBuffer) + sizeof (int) * buf->num_clients, buf);
     return 0;
@@ -895,6 +1708,7 @@ sp_writer_close_client (ShmPipe * self, ShmClient * client,
 {
   ShmBuffer *buffer = NULL, *prev_buf = NULL;
   ShmClient *item = NULL, *prev_item = NULL;
+  int j;
 
   shutdown (client->fd, SHUT_RDWR);
   close (client->fd);
@@ -931,6 +1745,14 @@ again:
 
   self->num_clients--;
 
+  if (client->ring)
+    sp_close_ring (client->ring);
+
+  for (j = 0; j < FD_CACHE_SIZE; j++) {
+    if (client->fd_cache[j])
+      sp_shm_area_dec (self, client->fd_cache[j]);
+  }
+
   spalloc_free (ShmClient, client);
 }
 
@@ -56,6 +56,20 @@
  * buffers are no longer valid. If was valid buffer was received, the
  * client must release it with sp_client_recv_finish() when it is done
  * reading from it.
+ *
+ * If the writer enabled ring slots with sp_writer_set_ring_slots(), the
+ * buffers and acks are exchanged through rings in shared memory instead
+ * of the socket, which then only carries wake-ups. The reader must call
+ * sp_client_recv_ring() before waiting on the socket, it returns 0 once
+ * it is safe to sleep. The writer must call sp_writer_recv_acks() every
+ * time sp_writer_recv() succeeded, and if sp_writer_can_send() returns 0,
+ * it must wait for events on the client fds before sending.
+ *
+ * Data that is already in a memfd or a dmabuf can be sent without copying
+ * with sp_writer_send_fd_buf(), the client receives it like any other
+ * buffer and gets the fd back with sp_client_buf_get_fd(). The pointer
+ * returned for such a buffer only identifies it, it must not be
+ * dereferenced, the data has to be accessed through the fd.
  */
 
 
@@ -89,6 +103,7 @@ void sp_set_data (ShmPipe * self, void *data);
 
 int sp_writer_setperms_shm (ShmPipe * self, mode_t perms);
 int sp_writer_resize (ShmPipe * self, size_t size);
+int sp_writer_set_ring_slots (ShmPipe * self, unsigned int slots);
 
 int sp_get_fd (ShmPipe * self);
 const char *sp_get_shm_area_name (ShmPipe *self);
@@ -97,6 +112,9 @@ int sp_writer_get_client_fd (ShmClient * client);
 ShmBlock *sp_writer_alloc_block (ShmPipe * self, size_t size);
 void sp_writer_free_block (ShmBlock *block);
 int sp_writer_send_buf (ShmPipe * self, char *buf, size_t size, void * tag);
+int sp_writer_send_fd_buf (ShmPipe * self, int fd, int is_dmabuf,
+    unsigned long offset, size_t size, void * tag);
+int sp_writer_can_send (ShmPipe * self);
 char *sp_writer_block_get_buf (ShmBlock *block);
 ShmPipe *sp_writer_block_get_pipe (ShmBlock *block);
 size_t sp_writer_get_max_buf_size (ShmPipe * self);
@@ -105,6 +123,8 @@ ShmClient * sp_writer_accept_client (ShmPipe * self);
 void sp_writer_close_client (ShmPipe *self, ShmClient * client,
     sp_buffer_free_callback callback, void * user_data);
 int sp_writer_recv (ShmPipe * self, ShmClient * client, void ** tag);
+int sp_writer_recv_acks (ShmPipe * self, ShmClient * client,
+    sp_buffer_free_callback callback, void * user_data);
 
 int sp_writer_pending_writes (ShmPipe * self);
 
@@ -114,7 +134,10 @@ void *sp_writer_buf_get_tag (ShmBuffer * buffer);
 
 ShmPipe *sp_client_open (const char *path);
 long int sp_client_recv (ShmPipe * self, char **buf);
+long int sp_client_recv_ring (ShmPipe * self, char **buf);
 int sp_client_recv_finish (ShmPipe * self, char *buf);
+int sp_client_buf_get_fd (ShmPipe * self, char *buf, unsigned long *offset,
+    int *is_dmabuf);
 void sp_client_close (ShmPipe * self);
 
 #ifdef __cplusplus
@@ -1013,35 +1013,47 @@ fail:
 }
 
 static GstFlowReturn
-gst_v4l2_codec_h264_dec_output_picture (GstH264Decoder * decoder,
-    GstVideoCodecFrame * frame, GstH264Picture * picture)
+gst_v4l2_codec_h264_dec_wait_picture (GstH264Decoder * decoder,
+    GstH264Picture * picture)
 {
   GstV4l2CodecH264Dec *self = GST_V4L2_CODEC_H264_DEC (decoder);
-  GstVideoDecoder *vdec = GST_VIDEO_DECODER (decoder);
   GstV4l2Request *request = gst_h264_picture_get_user_data (picture);
   gint ret;
 
-  GST_DEBUG_OBJECT (self, "Output picture %u", picture->system_frame_number);
+  GST_DEBUG_OBJECT (self, "Wait picture %u", picture->system_frame_number);
 
   ret = gst_v4l2_request_set_done (request);
   if (ret == 0) {
     GST_ELEMENT_ERROR (self, STREAM, DECODE,
         ("Decoding frame %u took too long", picture->system_frame_number),
         (NULL));
-    goto error;
+    return GST_FLOW_ERROR;
   } else if (ret < 0) {
     GST_ELEMENT_ERROR (self, STREAM, DECODE,
         ("Decoding request failed: %s", g_strerror (errno)), (NULL));
-    goto error;
+    return GST_FLOW_ERROR;
   }
-  g_return_val_if_fail (frame->output_buffer, GST_FLOW_ERROR);
 
   if (gst_v4l2_request_failed (request)) {
     GST_ELEMENT_ERROR (self, STREAM, DECODE,
         ("Failed to decode frame %u", picture->system_frame_number), (NULL));
-    goto error;
+    return GST_FLOW_ERROR;
   }
 
+  return GST_FLOW_OK;
+}
+
+static GstFlowReturn
+gst_v4l2_codec_h264_dec_output_picture (GstH264Decoder * decoder,
+    GstVideoCodecFrame * frame, GstH264Picture * picture)
+{
+  GstV4l2CodecH264Dec *self = GST_V4L2_CODEC_H264_DEC (decoder);
+  GstVideoDecoder *vdec = GST_VIDEO_DECODER (decoder);
+
+  GST_DEBUG_OBJECT (self, "Output picture %u", picture->system_frame_number);
+
+  g_return_val_if_fail (frame->output_buffer, GST_FLOW_ERROR);
+
   /* Hold on reference buffers for the rest of the picture lifetime */
   gst_h264_picture_set_user_data (picture,
       gst_buffer_ref (frame->output_buffer), (GDestroyNotify) gst_buffer_unref);
@@ -1052,12 +1064,6 @@ gst_v4l2_codec_h264_dec_output_picture (GstH264Decoder * decoder,
   gst_h264_picture_unref (picture);
 
   return gst_video_decoder_finish_frame (vdec, frame);
-
-error:
-  gst_video_decoder_drop_frame (vdec, frame);
-  gst_h264_picture_unref (picture);
-
-  return GST_FLOW_ERROR;
 }
 
 static void
@@ -1482,6 +1488,8 @@ gst_v4l2_codec_h264_dec_subclass_init (GstV4l2CodecH264DecClass * klass,
       GST_DEBUG_FUNCPTR (gst_v4l2_codec_h264_dec_decode_slice);
   h264decoder_class->end_picture =
       GST_DEBUG_FUNCPTR (gst_v4l2_codec_h264_dec_end_picture);
+  h264decoder_class->wait_picture =
+      GST_DEBUG_FUNCPTR (gst_v4l2_codec_h264_dec_wait_picture);
   h264decoder_class->new_field_picture =
       GST_DEBUG_FUNCPTR (gst_v4l2_codec_h264_dec_new_field_picture);
   h264decoder_class->get_preferred_output_delay =
@@ -101,8 +101,18 @@ struct _GstVaH265Dec
   struct slice prev_slice;
 
   gboolean need_negotiation;
+
+  guint slice_parse_threads;
+};
+
+enum
+{
+  PROP_0,
+  PROP_SLICE_PARSE_THREADS,
 };
 
+#define DEFAULT_SLICE_PARSE_THREADS 1
+
 /* *INDENT-OFF* */
 static const gchar *src_caps_str =
     GST_VIDEO_CAPS_MAKE_WITH_FEATURES (GST_CAPS_FEATURE_MEMORY_VA,
@@ -1241,6 +1251,40 @@ gst_va_h265_dec_negotiate (GstVideoDecoder * decoder)
       (decoder))->negotiate (decoder);
 }
 
+static void
+gst_va_h265_dec_set_property (GObject * object, guint prop_id,
+    const GValue * value, GParamSpec * pspec)
+{
+  GstVaH265Dec *self = GST_VA_H265_DEC (object);
+
+  switch (prop_id) {
+    case PROP_SLICE_PARSE_THREADS:
+      self->slice_parse_threads = g_value_get_uint (value);
+      gst_h265_decoder_set_slice_parse_threads (GST_H265_DECODER (object),
+          self->slice_parse_threads);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+}
+
+static void
+gst_va_h265_dec_get_property (GObject * object, guint prop_id,
+    GValue * value, GParamSpec * pspec)
+{
+  GstVaH265Dec *self = GST_VA_H265_DEC (object);
+
+  switch (prop_id) {
+    case PROP_SLICE_PARSE_THREADS:
+      g_value_set_uint (value, self->slice_parse_threads);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+}
+
 static void
 gst_va_h265_dec_dispose (GObject * object)
 {
@@ -1282,6 +1326,8 @@ gst_va_h265_dec_class_init (gpointer g_class, gpointer class_data)
       src_doc_caps, sink_doc_caps);
 
   gobject_class->dispose = gst_va_h265_dec_dispose;
+  gobject_class->set_property = gst_va_h265_dec_set_property;
+  gobject_class->get_property = gst_va_h265_dec_get_property;
 
   decoder_class->getcaps = GST_DEBUG_FUNCPTR (gst_va_h265_dec_getcaps);
   decoder_class->negotiate = GST_DEBUG_FUNCPTR (gst_va_h265_dec_negotiate);
@@ -1300,6 +1346,22 @@ gst_va_h265_dec_class_init (gpointer g_class, gpointer class_data)
   h265decoder_class->end_picture =
       GST_DEBUG_FUNCPTR (gst_va_h265_dec_end_picture);
 
+  /**
+   * GstVaH265Dec:slice-parse-threads:
+   *
+   * Number of threads used to parse the slice headers of an access unit,
+   * including the streaming thread. Only useful for streams with many
+   * slices per picture. Changes take effect on the next start.
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (gobject_class, PROP_SLICE_PARSE_THREADS,
+      g_param_spec_uint ("slice-parse-threads", "Slice Parse Threads",
+          "Number of threads used to parse slice headers (0, 1 = no threads)",
+          0, 64, DEFAULT_SLICE_PARSE_THREADS,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS |
+          GST_PARAM_MUTABLE_READY));
+
   g_free (long_name);
   g_free (cdata->description);
   g_free (cdata->render_device_path);
@@ -1314,6 +1376,9 @@ gst_va_h265_dec_init (GTypeInstance * instance, gpointer g_class)
   gst_va_base_dec_init (GST_VA_BASE_DEC (instance), GST_CAT_DEFAULT);
   gst_h265_decoder_set_process_ref_pic_lists (GST_H265_DECODER (instance),
       TRUE);
+
+  GST_VA_H265_DEC (instance)->slice_parse_threads =
+      DEFAULT_SLICE_PARSE_THREADS;
 }
 
 static gpointer
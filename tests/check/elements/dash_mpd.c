@@ -5123,6 +5123,196 @@ GST_START_TEST (dash_mpdparser_segment_timeline)
 
 GST_END_TEST;
 
+/*
+ * Generate a live manifest with a SegmentTimeline containing @count S
+ * elements, starting from the @first one of an endless sequence of segments
+ * with alternating durations
+ */
+static gchar *
+build_live_segment_timeline_mpd (guint first, guint count)
+{
+  GString *xml = g_string_new (NULL);
+  guint64 t = 0;
+  guint n;
+
+  for (n = 0; n < first; n++)
+    t += 90000 + (n % 3) * 10;
+
+  g_string_append (xml, "<?xml version=\"1.0\"?>"
+      "<MPD xmlns=\"urn:mpeg:dash:schema:mpd:2011\""
+      "     profiles=\"urn:mpeg:dash:profile:isoff-live:2011\""
+      "     type=\"dynamic\""
+      "     availabilityStartTime=\"2015-03-24T0:0:0\""
+      "     minimumUpdatePeriod=\"PT2S\">"
+      "  <Period id=\"Period0\" start=\"PT0S\">"
+      "    <AdaptationSet id=\"1\" mimeType=\"video/mp4\">"
+      "      <SegmentTemplate timescale=\"90000\""
+      "                       media=\"$RepresentationID$-$Number$.mp4\"");
+  g_string_append_printf (xml, " startNumber=\"%u\">", first + 1);
+  g_string_append (xml, "        <SegmentTimeline>");
+  for (n = first; n < first + count; n++) {
+    if (n == first)
+      g_string_append_printf (xml, "<S t=\"%" G_GUINT64_FORMAT "\" d=\"%u\"/>",
+          t, 90000 + (n % 3) * 10);
+    else
+      g_string_append_printf (xml, "<S d=\"%u\"/>", 90000 + (n % 3) * 10);
+  }
+  g_string_append (xml, "        </SegmentTimeline>"
+      "      </SegmentTemplate>"
+      "      <Representation id=\"low\" bandwidth=\"250000\"/>"
+      "      <Representation id=\"high\" bandwidth=\"1000000\"/>"
+      "    </AdaptationSet></Period></MPD>");
+
+  return g_string_free (xml, FALSE);
+}
+
+static GstActiveStream *
+setup_live_segment_timeline_stream (GstMPDClient * mpdclient,
+    const gchar * xml)
+{
+  GList *adaptationSets;
+  GstMPDAdaptationSetNode *adapt_set;
+  GstActiveStream *activeStream;
+  gboolean ret;
+
+  ret = gst_mpd_client_parse (mpdclient, xml, (gint) strlen (xml));
+  assert_equals_int (ret, TRUE);
+
+  ret =
+      gst_mpd_client_setup_media_presentation (mpdclient, GST_CLOCK_TIME_NONE,
+      -1, NULL);
+  assert_equals_int (ret, TRUE);
+
+  adaptationSets = gst_mpd_client_get_adaptation_sets (mpdclient);
+  fail_if (adaptationSets == NULL);
+  adapt_set = (GstMPDAdaptationSetNode *) g_list_nth_data (adaptationSets, 0);
+  fail_if (adapt_set == NULL);
+  ret = gst_mpd_client_setup_streaming (mpdclient, adapt_set);
+  assert_equals_int (ret, TRUE);
+
+  activeStream = gst_mpd_client_get_active_stream_by_index (mpdclient, 0);
+  fail_if (activeStream == NULL);
+
+  return activeStream;
+}
+
+static void
+assert_same_segments (GstActiveStream * stream, GstActiveStream * expected)
+{
+  guint n;
+
+  assert_equals_int (stream->segments->len, expected->segments->len);
+  for (n = 0; n < stream->segments->len; n++) {
+    GstMediaSegment *segment = g_ptr_array_index (stream->segments, n);
+    GstMediaSegment *expected_segment =
+        g_ptr_array_index (expected->segments, n);
+
+    assert_equals_int (segment->number, expected_segment->number);
+    assert_equals_int (segment->repeat, expected_segment->repeat);
+    assert_equals_uint64 (segment->scale_start, expected_segment->scale_start);
+    assert_equals_uint64 (segment->scale_duration,
+        expected_segment->scale_duration);
+    assert_equals_uint64 (segment->start, expected_segment->start);
+    assert_equals_uint64 (segment->duration, expected_segment->duration);
+  }
+}
+
+/*
+ * Test that the segment list built for a Representation is reused when
+ * switching back to it
+ *
+ */
+GST_START_TEST (dash_mpdparser_segment_timeline_cache)
+{
+  GstActiveStream *activeStream;
+  GstMPDRepresentationNode *low, *high;
+  GPtrArray *low_segments;
+  gchar *xml;
+  gboolean ret;
+  GstMPDClient *mpdclient = gst_mpd_client_new ();
+
+  xml = build_live_segment_timeline_mpd (0, 5000);
+  activeStream = setup_live_segment_timeline_stream (mpdclient, xml);
+  g_free (xml);
+
+  low = g_list_nth_data (activeStream->cur_adapt_set->Representations, 0);
+  high = g_list_nth_data (activeStream->cur_adapt_set->Representations, 1);
+  fail_unless (activeStream->cur_representation == low);
+  low_segments = g_ptr_array_ref (activeStream->segments);
+  assert_equals_int (low_segments->len, 5000);
+
+  ret = gst_mpd_client_setup_representation (mpdclient, activeStream, high);
+  assert_equals_int (ret, TRUE);
+  fail_unless (activeStream->segments != low_segments);
+  assert_equals_int (activeStream->segments->len, 5000);
+
+  ret = gst_mpd_client_setup_representation (mpdclient, activeStream, low);
+  assert_equals_int (ret, TRUE);
+  fail_unless (activeStream->segments == low_segments);
+
+  g_ptr_array_unref (low_segments);
+  gst_mpd_client_free (mpdclient);
+}
+
+GST_END_TEST;
+
+/*
+ * Test that a refreshed manifest reuses the segments of the previous one
+ * and gives the same segment list as parsing it from scratch
+ *
+ */
+GST_START_TEST (dash_mpdparser_segment_timeline_update)
+{
+  GstActiveStream *activeStream, *updatedStream, *expectedStream;
+  GstMPDClient *mpdclient = gst_mpd_client_new ();
+  GstMPDClient *updated_client = gst_mpd_client_new ();
+  GstMPDClient *expected_client = gst_mpd_client_new ();
+  GstMPDClient *rewritten_client = gst_mpd_client_new ();
+  GstMediaSegment *segment;
+  gchar *xml, *updated_xml, *rewritten_xml, *p;
+
+  xml = build_live_segment_timeline_mpd (0, 5000);
+  activeStream = setup_live_segment_timeline_stream (mpdclient, xml);
+  g_free (xml);
+
+  /* the live window moved forward: 10 segments were removed and 50 added */
+  updated_xml = build_live_segment_timeline_mpd (10, 5040);
+  gst_mpd_client_inherit_segments (updated_client, mpdclient);
+  updatedStream =
+      setup_live_segment_timeline_stream (updated_client, updated_xml);
+  expectedStream =
+      setup_live_segment_timeline_stream (expected_client, updated_xml);
+
+  assert_equals_int (updatedStream->segments->len, 5040);
+  assert_same_segments (updatedStream, expectedStream);
+  segment = g_ptr_array_index (updatedStream->segments, 0);
+  assert_equals_int (segment->number, 11);
+  fail_unless (segment != g_ptr_array_index (activeStream->segments, 10));
+
+  /* segments following a change of the timeline are built again */
+  rewritten_xml = g_strdup (updated_xml);
+  p = strstr (rewritten_xml, "<S d=\"90010\"/>");
+  fail_unless (p != NULL);
+  p[7] = '9';
+  gst_mpd_client_inherit_segments (rewritten_client, mpdclient);
+  updatedStream =
+      setup_live_segment_timeline_stream (rewritten_client, rewritten_xml);
+  gst_mpd_client_free (expected_client);
+  expected_client = gst_mpd_client_new ();
+  expectedStream =
+      setup_live_segment_timeline_stream (expected_client, rewritten_xml);
+  assert_same_segments (updatedStream, expectedStream);
+
+  g_free (updated_xml);
+  g_free (rewritten_xml);
+  gst_mpd_client_free (mpdclient);
+  gst_mpd_client_free (updated_client);
+  gst_mpd_client_free (expected_client);
+  gst_mpd_client_free (rewritten_client);
+}
+
+GST_END_TEST;
+
 /*
  * Test SegmentList with multiple inherited segmentURLs
  *
@@ -6641,6 +6831,8 @@ dash_suite (void)
   tcase_add_test (tc_complexMPD, dash_mpdparser_segment_list);
   tcase_add_test (tc_complexMPD, dash_mpdparser_segment_template);
   tcase_add_test (tc_complexMPD, dash_mpdparser_segment_timeline);
+  tcase_add_test (tc_complexMPD, dash_mpdparser_segment_timeline_cache);
+  tcase_add_test (tc_complexMPD, dash_mpdparser_segment_timeline_update);
   tcase_add_test (tc_complexMPD, dash_mpdparser_multiple_inherited_segmentURL);
 
   /* tests checking the parsing of missing/incomplete attributes of xml */
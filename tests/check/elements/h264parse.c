@@ -1257,6 +1257,54 @@ GST_START_TEST (test_parse_skip_to_4bytes_sc)
 
 GST_END_TEST;
 
+GST_START_TEST (test_parse_level_minimal)
+{
+  GstHarness *h = gst_harness_new ("h264parse");
+  GstStructure *s;
+  GstBuffer *buf;
+  GstCaps *caps;
+  gint i, width, height;
+
+  gst_util_set_object_arg (G_OBJECT (h->element), "parse-level", "minimal");
+
+  gst_harness_set_caps_str (h,
+      "video/x-h264,stream-format=byte-stream,alignment=au,parsed=false,framerate=30/1",
+      "video/x-h264,stream-format=byte-stream,alignment=au,parsed=true");
+
+  /* SPS/PPS are repeated in each AU, only the first ones need parsing */
+  for (i = 0; i < 3; i++) {
+    buf = composite_buffer (100 * i, 0, 4,
+        h264_slicing_sps, sizeof (h264_slicing_sps),
+        h264_slicing_pps, sizeof (h264_slicing_pps),
+        h264_idr_slice_1, sizeof (h264_idr_slice_1),
+        h264_idr_slice_2, sizeof (h264_idr_slice_2));
+    fail_unless_equals_int (gst_harness_push (h, buf), GST_FLOW_OK);
+  }
+  fail_unless (gst_harness_push_event (h, gst_event_new_eos ()));
+
+  /* all AUs must still be detected, and flagged as keyframes */
+  fail_unless_equals_int (gst_harness_buffers_in_queue (h), 3);
+  for (i = 0; i < 3; i++) {
+    buf = gst_harness_pull (h);
+    fail_unless_equals_clocktime (GST_BUFFER_PTS (buf), 100 * i);
+    fail_if (GST_BUFFER_FLAG_IS_SET (buf, GST_BUFFER_FLAG_DELTA_UNIT));
+    gst_buffer_unref (buf);
+  }
+
+  caps = gst_pad_get_current_caps (h->sinkpad);
+  fail_unless (caps != NULL);
+  s = gst_caps_get_structure (caps, 0);
+  fail_unless (gst_structure_get_int (s, "width", &width));
+  fail_unless (gst_structure_get_int (s, "height", &height));
+  fail_unless_equals_int (width, 128);
+  fail_unless_equals_int (height, 128);
+  gst_caps_unref (caps);
+
+  gst_harness_teardown (h);
+}
+
+GST_END_TEST;
+
 
 /*
  * TODO:
@@ -1369,6 +1417,7 @@ main (int argc, char **argv)
     tcase_add_test (tc_chain, test_parse_sei_closedcaptions);
     tcase_add_test (tc_chain, test_parse_compatible_caps);
     tcase_add_test (tc_chain, test_parse_skip_to_4bytes_sc);
+    tcase_add_test (tc_chain, test_parse_level_minimal);
     nf += gst_check_run_suite (s, "h264parse", __FILE__);
   }
 
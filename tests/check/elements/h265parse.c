@@ -106,6 +106,11 @@ static const guint8 h265_sei_mdcv[] = {
   0x96, 0x80, 0x00, 0x00, 0x03, 0x00, 0x01, 0x80
 };
 
+/* Recovery point SEI message, recovery_poc_cnt 0 */
+static const guint8 h265_sei_recovery_point[] = {
+  0x00, 0x00, 0x00, 0x01, 0x4e, 0x01, 0x06, 0x01, 0x90, 0x80
+};
+
 
 /* single-sliced data, generated with:
  * gst-launch-1.0 videotestsrc num-buffers=1 pattern=green \
@@ -1030,6 +1035,62 @@ GST_START_TEST (test_parse_sc_with_half_header)
 GST_END_TEST;
 
 
+/* P slice of a TRAIL_R picture, only valid up to the slice_type */
+static const guint8 h265_128x128_slice_trail_r[] = {
+  0x00, 0x00, 0x00, 0x01, 0x02, 0x01, 0xd0, 0x80
+};
+
+GST_START_TEST (test_parse_level_minimal)
+{
+  GstHarness *h = gst_harness_new ("h265parse");
+  GstBuffer *buf;
+  gint i;
+
+  gst_util_set_object_arg (G_OBJECT (h->element), "parse-level", "minimal");
+
+  gst_harness_set_caps_str (h,
+      "video/x-h265,stream-format=byte-stream,alignment=au,parsed=false,framerate=30/1",
+      "video/x-h265,stream-format=byte-stream,alignment=au,parsed=true");
+
+  buf = composite_buffer (0, 0, 4,
+      h265_128x128_vps, sizeof (h265_128x128_vps),
+      h265_128x128_sps, sizeof (h265_128x128_sps),
+      h265_128x128_pps, sizeof (h265_128x128_pps),
+      h265_128x128_slice_idr_n_lp, sizeof (h265_128x128_slice_idr_n_lp));
+  fail_unless_equals_int (gst_harness_push (h, buf), GST_FLOW_OK);
+
+  buf = composite_buffer (100, 0, 1,
+      h265_128x128_slice_trail_r, sizeof (h265_128x128_slice_trail_r));
+  fail_unless_equals_int (gst_harness_push (h, buf), GST_FLOW_OK);
+
+  /* the recovery point SEI must still be handled in minimal mode */
+  buf = composite_buffer (200, 0, 2,
+      h265_sei_recovery_point, sizeof (h265_sei_recovery_point),
+      h265_128x128_slice_trail_r, sizeof (h265_128x128_slice_trail_r));
+  fail_unless_equals_int (gst_harness_push (h, buf), GST_FLOW_OK);
+
+  /* while other SEI messages are skipped */
+  buf = composite_buffer (300, 0, 2,
+      h265_sei_clli, sizeof (h265_sei_clli),
+      h265_128x128_slice_trail_r, sizeof (h265_128x128_slice_trail_r));
+  fail_unless_equals_int (gst_harness_push (h, buf), GST_FLOW_OK);
+
+  fail_unless (gst_harness_push_event (h, gst_event_new_eos ()));
+
+  fail_unless_equals_int (gst_harness_buffers_in_queue (h), 4);
+  for (i = 0; i < 4; i++) {
+    buf = gst_harness_pull (h);
+    fail_unless_equals_clocktime (GST_BUFFER_PTS (buf), 100 * i);
+    fail_unless_equals_int (GST_BUFFER_FLAG_IS_SET (buf,
+            GST_BUFFER_FLAG_DELTA_UNIT), i == 1 || i == 3);
+    gst_buffer_unref (buf);
+  }
+
+  gst_harness_teardown (h);
+}
+
+GST_END_TEST;
+
 
 /* nal->au has latency, but EOS should force the last AU out */
 GST_START_TEST (test_drain)
@@ -1084,6 +1145,7 @@ h265parse_harnessed_suite (void)
 
   tcase_add_test (tc_chain, test_parse_skip_to_4bytes_sc);
   tcase_add_test (tc_chain, test_parse_sc_with_half_header);
+  tcase_add_test (tc_chain, test_parse_level_minimal);
 
   tcase_add_test (tc_chain, test_drain);
 
@@ -726,6 +726,199 @@ GST_START_TEST (testFragmentDownloadError)
 
 GST_END_TEST;
 
+static void
+setPrefetchFragments (GstAdaptiveDemuxTestEngine * engine, gpointer user_data)
+{
+  g_object_set (engine->demux, "prefetch-fragments", 2, NULL);
+}
+
+/*
+ * Test that prefetched fragments are pushed in order while they are being
+ * downloaded in several chunks
+ */
+GST_START_TEST (testPrefetchFragments)
+{
+  const guint segment_size = 30 * TS_PACKET_LEN;
+  const gchar *manifest =
+      "#EXTM3U \n"
+      "#EXT-X-TARGETDURATION:1\n"
+      "#EXTINF:1,Test\n" "001.ts\n"
+      "#EXTINF:1,Test\n" "002.ts\n"
+      "#EXTINF:1,Test\n" "003.ts\n" "#EXT-X-ENDLIST\n";
+  GstHlsDemuxTestInputData inputTestData[] = {
+    {"http://unit.test/media.m3u8", (guint8 *) manifest, 0},
+    {"http://unit.test/001.ts", NULL, segment_size},
+    {"http://unit.test/002.ts", NULL, segment_size},
+    {"http://unit.test/003.ts", NULL, segment_size},
+    {NULL, NULL, 0},
+  };
+  GstAdaptiveDemuxTestExpectedOutput outputTestData[] = {
+    {"src_0", 3 * segment_size, NULL},
+    {NULL, 0, NULL}
+  };
+  TESTCASE_INIT_BOILERPLATE (segment_size);
+
+  gst_test_http_src_set_default_blocksize (10 * TS_PACKET_LEN);
+
+  http_src_callbacks.src_start = gst_hlsdemux_test_src_start;
+  http_src_callbacks.src_create = gst_hlsdemux_test_src_create;
+  engine_callbacks.pre_test = setPrefetchFragments;
+  engine_callbacks.appsink_received_data =
+      gst_adaptive_demux_test_check_received_data;
+  engine_callbacks.appsink_eos =
+      gst_adaptive_demux_test_check_size_of_received_data;
+
+  gst_test_http_src_install_callbacks (&http_src_callbacks, &hlsTestCase);
+  gst_adaptive_demux_test_run (DEMUX_ELEMENT_NAME,
+      inputTestData[0].uri, &engine_callbacks, engineTestData);
+  TESTCASE_UNREF_BOILERPLATE;
+}
+
+GST_END_TEST;
+
+static void
+setPrefetchMaxBytes (GstAdaptiveDemuxTestEngine * engine, gpointer user_data)
+{
+  g_object_set (engine->demux, "prefetch-fragments", 3,
+      "max-concurrent-downloads", 2,
+      "prefetch-max-bytes", (guint64) 10 * TS_PACKET_LEN, NULL);
+}
+
+/*
+ * Test that prefetched fragments are still pushed completely and in order
+ * when the prefetch downloads have to wait for room in the prefetch queue
+ */
+GST_START_TEST (testPrefetchFragmentsMaxBytes)
+{
+  const guint segment_size = 30 * TS_PACKET_LEN;
+  const gchar *manifest =
+      "#EXTM3U \n"
+      "#EXT-X-TARGETDURATION:1\n"
+      "#EXTINF:1,Test\n" "001.ts\n"
+      "#EXTINF:1,Test\n" "002.ts\n"
+      "#EXTINF:1,Test\n" "003.ts\n"
+      "#EXTINF:1,Test\n" "004.ts\n"
+      "#EXTINF:1,Test\n" "005.ts\n" "#EXT-X-ENDLIST\n";
+  GstHlsDemuxTestInputData inputTestData[] = {
+    {"http://unit.test/media.m3u8", (guint8 *) manifest, 0},
+    {"http://unit.test/001.ts", NULL, segment_size},
+    {"http://unit.test/002.ts", NULL, segment_size},
+    {"http://unit.test/003.ts", NULL, segment_size},
+    {"http://unit.test/004.ts", NULL, segment_size},
+    {"http://unit.test/005.ts", NULL, segment_size},
+    {NULL, NULL, 0},
+  };
+  GstAdaptiveDemuxTestExpectedOutput outputTestData[] = {
+    {"src_0", 5 * segment_size, NULL},
+    {NULL, 0, NULL}
+  };
+  TESTCASE_INIT_BOILERPLATE (segment_size);
+
+  gst_test_http_src_set_default_blocksize (4 * TS_PACKET_LEN);
+
+  http_src_callbacks.src_start = gst_hlsdemux_test_src_start;
+  http_src_callbacks.src_create = gst_hlsdemux_test_src_create;
+  engine_callbacks.pre_test = setPrefetchMaxBytes;
+  engine_callbacks.appsink_received_data =
+      gst_adaptive_demux_test_check_received_data;
+  engine_callbacks.appsink_eos =
+      gst_adaptive_demux_test_check_size_of_received_data;
+
+  gst_test_http_src_install_callbacks (&http_src_callbacks, &hlsTestCase);
+  gst_adaptive_demux_test_run (DEMUX_ELEMENT_NAME,
+      inputTestData[0].uri, &engine_callbacks, engineTestData);
+  TESTCASE_UNREF_BOILERPLATE;
+}
+
+GST_END_TEST;
+
+static void
+setLowLatency (GstAdaptiveDemuxTestEngine * engine, gpointer user_data)
+{
+  g_object_set (engine->demux, "low-latency", TRUE, NULL);
+}
+
+/*
+ * Test a Low-Latency HLS live playlist: playback starts at the partial
+ * segment PART-HOLD-BACK from the end and the next partial segment is
+ * fetched with a blocking playlist reload
+ */
+GST_START_TEST (testLowLatencyPartialSegments)
+{
+  const guint segment_size = 30 * TS_PACKET_LEN;
+  const gchar *media_playlist =
+      "#EXTM3U\n"
+      "#EXT-X-VERSION:6\n"
+      "#EXT-X-TARGETDURATION:1\n"
+      "#EXT-X-SERVER-CONTROL:CAN-BLOCK-RELOAD=YES,PART-HOLD-BACK=1.0\n"
+      "#EXT-X-PART-INF:PART-TARGET=0.5\n"
+      "#EXT-X-MEDIA-SEQUENCE:0\n"
+      "#EXT-X-PART:DURATION=0.5,URI=\"000.0.ts\",INDEPENDENT=YES\n"
+      "#EXT-X-PART:DURATION=0.5,URI=\"000.1.ts\"\n"
+      "#EXTINF:1,Test\n" "000.ts\n"
+      "#EXT-X-PART:DURATION=0.5,URI=\"001.0.ts\",INDEPENDENT=YES\n"
+      "#EXT-X-PRELOAD-HINT:TYPE=PART,URI=\"001.1.ts\"\n";
+  const gchar *final_playlist =
+      "#EXTM3U\n"
+      "#EXT-X-VERSION:6\n"
+      "#EXT-X-TARGETDURATION:1\n"
+      "#EXT-X-SERVER-CONTROL:CAN-BLOCK-RELOAD=YES,PART-HOLD-BACK=1.0\n"
+      "#EXT-X-PART-INF:PART-TARGET=0.5\n"
+      "#EXT-X-MEDIA-SEQUENCE:0\n"
+      "#EXT-X-PART:DURATION=0.5,URI=\"000.0.ts\",INDEPENDENT=YES\n"
+      "#EXT-X-PART:DURATION=0.5,URI=\"000.1.ts\"\n"
+      "#EXTINF:1,Test\n" "000.ts\n"
+      "#EXT-X-PART:DURATION=0.5,URI=\"001.0.ts\",INDEPENDENT=YES\n"
+      "#EXT-X-PART:DURATION=0.5,URI=\"001.1.ts\"\n"
+      "#EXTINF:1,Test\n" "001.ts\n" "#EXT-X-ENDLIST\n";
+  GstHlsDemuxTestInputData inputTestData[] = {
+    {"http://unit.test/media.m3u8", (guint8 *) media_playlist, 0},
+    {"http://unit.test/media.m3u8?_HLS_msn=1&_HLS_part=1",
+        (guint8 *) final_playlist, 0},
+    {"http://unit.test/000.0.ts", NULL, segment_size},
+    {"http://unit.test/000.1.ts", NULL, segment_size},
+    {"http://unit.test/001.0.ts", NULL, segment_size},
+    {"http://unit.test/001.1.ts", NULL, segment_size},
+    {NULL, NULL, 0},
+  };
+  GstAdaptiveDemuxTestExpectedOutput outputTestData[] = {
+    {"src_0", 4 * segment_size, NULL},
+    {NULL, 0, NULL}
+  };
+  const GValue *requests;
+  gboolean blocking_reload = FALSE;
+  guint i;
+  TESTCASE_INIT_BOILERPLATE (segment_size);
+
+  http_src_callbacks.src_start = gst_hlsdemux_test_src_start;
+  http_src_callbacks.src_create = gst_hlsdemux_test_src_create;
+  engine_callbacks.pre_test = setLowLatency;
+  engine_callbacks.appsink_received_data =
+      gst_adaptive_demux_test_check_received_data;
+  engine_callbacks.appsink_eos =
+      gst_adaptive_demux_test_check_size_of_received_data;
+
+  gst_test_http_src_install_callbacks (&http_src_callbacks, &hlsTestCase);
+  gst_adaptive_demux_test_run (DEMUX_ELEMENT_NAME,
+      inputTestData[0].uri, &engine_callbacks, engineTestData);
+
+  /* Full segments are never requested, only their partial segments */
+  fail_if (gst_structure_has_field (hlsTestCase.state, "failure-count"));
+  requests = gst_structure_get_value (hlsTestCase.state, "requests");
+  fail_unless (requests != NULL);
+  for (i = 0; i < gst_value_array_get_size (requests); ++i) {
+    const GValue *uri = gst_value_array_get_value (requests, i);
+
+    if (g_strcmp0 (g_value_get_string (uri), inputTestData[1].uri) == 0)
+      blocking_reload = TRUE;
+  }
+  fail_unless (blocking_reload);
+
+  TESTCASE_UNREF_BOILERPLATE;
+}
+
+GST_END_TEST;
+
 static Suite *
 hls_demux_suite (void)
 {
@@ -734,6 +927,9 @@ hls_demux_suite (void)
 
   tcase_add_test (tc_basicTest, simpleTest);
   tcase_add_test (tc_basicTest, testMasterPlaylist);
+  tcase_add_test (tc_basicTest, testLowLatencyPartialSegments);
+  tcase_add_test (tc_basicTest, testPrefetchFragments);
+  tcase_add_test (tc_basicTest, testPrefetchFragmentsMaxBytes);
   tcase_add_test (tc_basicTest, testMediaPlaylistNotFound);
   tcase_add_test (tc_basicTest, testFragmentNotFound);
   tcase_add_test (tc_basicTest, testFragmentDownloadError);
@@ -69,6 +69,41 @@ https://priv.example.com/fileSequence2682.ts\n\
 #EXTINF:8,\n\
 https://priv.example.com/fileSequence2683.ts";
 
+static const gchar *LOW_LATENCY_PLAYLIST = "#EXTM3U\n\
+#EXT-X-TARGETDURATION:4\n\
+#EXT-X-VERSION:6\n\
+#EXT-X-SERVER-CONTROL:CAN-BLOCK-RELOAD=YES,PART-HOLD-BACK=3.0\n\
+#EXT-X-PART-INF:PART-TARGET=1.0\n\
+#EXT-X-MEDIA-SEQUENCE:100\n\
+#EXTINF:4.0,\n\
+seg100.ts\n\
+#EXT-X-PART:DURATION=1.0,URI=\"seg101.0.ts\",INDEPENDENT=YES\n\
+#EXT-X-PART:DURATION=1.0,URI=\"seg101.1.ts\"\n\
+#EXT-X-PART:DURATION=1.0,URI=\"seg101.2.ts\",INDEPENDENT=YES\n\
+#EXT-X-PART:DURATION=1.0,URI=\"seg101.3.ts\"\n\
+#EXTINF:4.0,\n\
+seg101.ts\n\
+#EXT-X-PART:DURATION=1.0,URI=\"seg102.ts\",BYTERANGE=1000@0,INDEPENDENT=YES\n\
+#EXT-X-PART:DURATION=1.0,URI=\"seg102.ts\",BYTERANGE=1200\n\
+#EXT-X-PRELOAD-HINT:TYPE=PART,URI=\"seg102.ts\",BYTERANGE-START=2200\n";
+
+static const gchar *LOW_LATENCY_UPDATED_PLAYLIST = "#EXTM3U\n\
+#EXT-X-TARGETDURATION:4\n\
+#EXT-X-VERSION:6\n\
+#EXT-X-SERVER-CONTROL:CAN-BLOCK-RELOAD=YES,PART-HOLD-BACK=3.0\n\
+#EXT-X-PART-INF:PART-TARGET=1.0\n\
+#EXT-X-MEDIA-SEQUENCE:101\n\
+#EXTINF:4.0,\n\
+seg101.ts\n\
+#EXT-X-PART:DURATION=1.0,URI=\"seg102.ts\",BYTERANGE=1000@0,INDEPENDENT=YES\n\
+#EXT-X-PART:DURATION=1.0,URI=\"seg102.ts\",BYTERANGE=1200\n\
+#EXT-X-PART:DURATION=1.0,URI=\"seg102.ts\",BYTERANGE=1100\n\
+#EXT-X-PART:DURATION=1.0,URI=\"seg102.ts\",BYTERANGE=900\n\
+#EXTINF:4.0,\n\
+seg102.ts\n\
+#EXT-X-PART:DURATION=1.0,URI=\"seg103.0.ts\",INDEPENDENT=YES\n\
+#EXT-X-PRELOAD-HINT:TYPE=PART,URI=\"seg103.1.ts\"\n";
+
 static const gchar *LIVE_ROTATED_PLAYLIST = "#EXTM3U\n\
 #EXT-X-TARGETDURATION:8\n\
 #EXT-X-MEDIA-SEQUENCE:3001\n\
@@ -366,7 +401,7 @@ GST_START_TEST (test_load_main_playlist_rendition)
   master = load_playlist (ON_DEMAND_PLAYLIST);
   variant = master->default_variant;
 
-  assert_equals_int (g_list_length (variant->m3u8->files), 4);
+  assert_equals_int (variant->m3u8->files->len, 4);
   assert_equals_int (master->version, 0);
 
   gst_hls_master_playlist_unref (master);
@@ -476,13 +511,14 @@ check_on_demand_playlist (const gchar * data)
   /* Check that we are not live */
   assert_equals_int (gst_m3u8_is_live (pl), FALSE);
   /* Check number of entries */
-  assert_equals_int (g_list_length (pl->files), 4);
+  assert_equals_int (pl->files->len, 4);
   /* Check first media segments */
-  file = GST_M3U8_MEDIA_FILE (g_list_first (pl->files)->data);
+  file = GST_M3U8_MEDIA_FILE (g_ptr_array_index (pl->files, 0));
   assert_equals_string (file->uri, "http://media.example.com/001.ts");
   assert_equals_int (file->sequence, 0);
   /* Check last media segments */
-  file = GST_M3U8_MEDIA_FILE (g_list_last (pl->files)->data);
+  file = GST_M3U8_MEDIA_FILE (g_ptr_array_index (pl->files,
+          pl->files->len - 1));
   assert_equals_string (file->uri, "http://media.example.com/004.ts");
   assert_equals_int (file->sequence, 3);
 
@@ -532,14 +568,15 @@ GST_START_TEST (test_live_playlist)
   assert_equals_int (gst_m3u8_is_live (pl), TRUE);
   assert_equals_int (pl->sequence, 2680);
   /* Check number of entries */
-  assert_equals_int (g_list_length (pl->files), 4);
+  assert_equals_int (pl->files->len, 4);
   /* Check first media segments */
-  file = GST_M3U8_MEDIA_FILE (g_list_first (pl->files)->data);
+  file = GST_M3U8_MEDIA_FILE (g_ptr_array_index (pl->files, 0));
   assert_equals_string (file->uri,
       "https://priv.example.com/fileSequence2680.ts");
   assert_equals_int (file->sequence, 2680);
   /* Check last media segments */
-  file = GST_M3U8_MEDIA_FILE (g_list_last (pl->files)->data);
+  file = GST_M3U8_MEDIA_FILE (g_ptr_array_index (pl->files,
+          pl->files->len - 1));
   assert_equals_string (file->uri,
       "https://priv.example.com/fileSequence2683.ts");
   assert_equals_int (file->sequence, 2683);
@@ -567,7 +604,7 @@ GST_START_TEST (test_live_playlist_rotated)
 
   assert_equals_int (pl->sequence, 2680);
   /* Check first media segments */
-  file = GST_M3U8_MEDIA_FILE (g_list_first (pl->files)->data);
+  file = GST_M3U8_MEDIA_FILE (g_ptr_array_index (pl->files, 0));
   assert_equals_int (file->sequence, 2680);
 
   ret = gst_m3u8_update (pl, g_strdup (LIVE_ROTATED_PLAYLIST));
@@ -579,7 +616,7 @@ GST_START_TEST (test_live_playlist_rotated)
   /* FIXME: Sequence should last - 3. Should it? */
   assert_equals_int (pl->sequence, 3001);
   /* Check first media segments */
-  file = GST_M3U8_MEDIA_FILE (g_list_first (pl->files)->data);
+  file = GST_M3U8_MEDIA_FILE (g_ptr_array_index (pl->files, 0));
   assert_equals_int (file->sequence, 3001);
 
   gst_hls_master_playlist_unref (master);
@@ -599,13 +636,13 @@ GST_START_TEST (test_playlist_with_doubles_duration)
   pl = master->default_variant->m3u8;
 
   /* Check first media segments */
-  file = GST_M3U8_MEDIA_FILE (g_list_nth_data (pl->files, 0));
+  file = GST_M3U8_MEDIA_FILE (g_ptr_array_index (pl->files, 0));
   assert_equals_float (file->duration / (double) GST_SECOND, 10.321);
-  file = GST_M3U8_MEDIA_FILE (g_list_nth_data (pl->files, 1));
+  file = GST_M3U8_MEDIA_FILE (g_ptr_array_index (pl->files, 1));
   assert_equals_float (file->duration / (double) GST_SECOND, 9.6789);
-  file = GST_M3U8_MEDIA_FILE (g_list_nth_data (pl->files, 2));
+  file = GST_M3U8_MEDIA_FILE (g_ptr_array_index (pl->files, 2));
   assert_equals_float (file->duration / (double) GST_SECOND, 10.2344);
-  file = GST_M3U8_MEDIA_FILE (g_list_nth_data (pl->files, 3));
+  file = GST_M3U8_MEDIA_FILE (g_ptr_array_index (pl->files, 3));
   assert_equals_float (file->duration / (double) GST_SECOND, 9.92);
   fail_unless (gst_m3u8_get_seek_range (pl, &start, &stop));
   assert_equals_int64 (start, 0);
@@ -631,26 +668,26 @@ GST_START_TEST (test_playlist_with_encryption)
   master = load_playlist (AES_128_ENCRYPTED_PLAYLIST);
   pl = master->default_variant->m3u8;
 
-  assert_equals_int (g_list_length (pl->files), 5);
+  assert_equals_int (pl->files->len, 5);
 
   /* Check all media segments */
-  file = GST_M3U8_MEDIA_FILE (g_list_nth_data (pl->files, 0));
+  file = GST_M3U8_MEDIA_FILE (g_ptr_array_index (pl->files, 0));
   fail_unless (file->key == NULL);
 
-  file = GST_M3U8_MEDIA_FILE (g_list_nth_data (pl->files, 1));
+  file = GST_M3U8_MEDIA_FILE (g_ptr_array_index (pl->files, 1));
   fail_unless (file->key == NULL);
 
-  file = GST_M3U8_MEDIA_FILE (g_list_nth_data (pl->files, 2));
+  file = GST_M3U8_MEDIA_FILE (g_ptr_array_index (pl->files, 2));
   fail_unless (file->key != NULL);
   assert_equals_string (file->key, "https://priv.example.com/key.bin");
   fail_unless (memcmp (&file->iv, iv2, 16) == 0);
 
-  file = GST_M3U8_MEDIA_FILE (g_list_nth_data (pl->files, 3));
+  file = GST_M3U8_MEDIA_FILE (g_ptr_array_index (pl->files, 3));
   fail_unless (file->key != NULL);
   assert_equals_string (file->key, "https://priv.example.com/key2.bin");
   fail_unless (memcmp (&file->iv, iv1, 16) == 0);
 
-  file = GST_M3U8_MEDIA_FILE (g_list_nth_data (pl->files, 4));
+  file = GST_M3U8_MEDIA_FILE (g_ptr_array_index (pl->files, 4));
   fail_unless (file->key != NULL);
   assert_equals_string (file->key, "https://priv.example.com/key2.bin");
   fail_unless (memcmp (&file->iv, iv1, 16) == 0);
@@ -670,7 +707,7 @@ GST_START_TEST (test_update_invalid_playlist)
   /* Test updates in on-demand playlists */
   master = load_playlist (ON_DEMAND_PLAYLIST);
   pl = master->default_variant->m3u8;
-  assert_equals_int (g_list_length (pl->files), 4);
+  assert_equals_int (pl->files->len, 4);
   ret = gst_m3u8_update (pl, g_strdup ("#INVALID"));
   assert_equals_int (ret, FALSE);
 
@@ -689,26 +726,223 @@ GST_START_TEST (test_update_playlist)
   /* Test updates in on-demand playlists */
   master = load_playlist (ON_DEMAND_PLAYLIST);
   pl = master->default_variant->m3u8;
-  assert_equals_int (g_list_length (pl->files), 4);
+  assert_equals_int (pl->files->len, 4);
   ret = gst_m3u8_update (pl, g_strdup (ON_DEMAND_PLAYLIST));
   assert_equals_int (ret, TRUE);
-  assert_equals_int (g_list_length (pl->files), 4);
+  assert_equals_int (pl->files->len, 4);
   gst_hls_master_playlist_unref (master);
 
   /* Test updates in live playlists */
   master = load_playlist (LIVE_PLAYLIST);
   pl = master->default_variant->m3u8;
-  assert_equals_int (g_list_length (pl->files), 4);
+  assert_equals_int (pl->files->len, 4);
   /* Add a new entry to the playlist and check the update */
   live_pl = g_strdup_printf ("%s\n%s\n%s", LIVE_PLAYLIST, "#EXTINF:8",
       "https://priv.example.com/fileSequence2683.ts");
   ret = gst_m3u8_update (pl, live_pl);
   assert_equals_int (ret, TRUE);
-  assert_equals_int (g_list_length (pl->files), 5);
+  assert_equals_int (pl->files->len, 5);
   /* Test sliding window */
   ret = gst_m3u8_update (pl, g_strdup (LIVE_PLAYLIST));
   assert_equals_int (ret, TRUE);
-  assert_equals_int (g_list_length (pl->files), 4);
+  assert_equals_int (pl->files->len, 4);
+  gst_hls_master_playlist_unref (master);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_update_appended_playlist)
+{
+  GstHLSMasterPlaylist *master;
+  GstM3U8 *pl;
+  GstM3U8MediaFile *file, *mf;
+  gchar *event_pl;
+  gboolean ret;
+
+  event_pl = g_strdup_printf ("%s\n", LIVE_PLAYLIST);
+  master = load_playlist (event_pl);
+  pl = master->default_variant->m3u8;
+  assert_equals_int (pl->files->len, 4);
+  file = g_ptr_array_index (pl->files, 0);
+
+  mf = gst_m3u8_get_next_fragment (pl, TRUE, NULL, NULL);
+  fail_unless (mf != NULL);
+  assert_equals_int (mf->sequence, 2680);
+  gst_m3u8_media_file_unref (mf);
+
+  /* Updating with the same data keeps everything as is */
+  ret = gst_m3u8_update (pl, g_strdup (event_pl));
+  assert_equals_int (ret, TRUE);
+  assert_equals_int (pl->files->len, 4);
+  fail_unless (g_ptr_array_index (pl->files, 0) == file);
+
+  /* Only the appended lines are parsed, the files and the current one
+   * stay the same */
+  ret = gst_m3u8_update (pl, g_strdup_printf ("%s%s\n%s\n%s\n%s\n", event_pl,
+          "#EXTINF:8,", "https://priv.example.com/fileSequence2684.ts",
+          "#EXTINF:4,", "https://priv.example.com/fileSequence2685.ts"));
+  assert_equals_int (ret, TRUE);
+  assert_equals_int (pl->files->len, 6);
+  fail_unless (g_ptr_array_index (pl->files, 0) == file);
+  file = g_ptr_array_index (pl->files, 5);
+  assert_equals_string (file->uri,
+      "https://priv.example.com/fileSequence2685.ts");
+  assert_equals_int (file->sequence, 2685);
+  assert_equals_uint64 (file->duration, 4 * GST_SECOND);
+  assert_equals_uint64 (pl->duration, 44 * GST_SECOND);
+  assert_equals_int (pl->highest_sequence_number, 2685);
+
+  mf = gst_m3u8_get_next_fragment (pl, TRUE, NULL, NULL);
+  fail_unless (mf != NULL);
+  assert_equals_int (mf->sequence, 2680);
+  gst_m3u8_media_file_unref (mf);
+
+  /* Segments can be looked up by time */
+  assert_equals_int (gst_m3u8_find_file_by_offset (pl, 0), 0);
+  assert_equals_int (gst_m3u8_find_file_by_offset (pl, 8 * GST_SECOND), 1);
+  assert_equals_int (gst_m3u8_find_file_by_offset (pl, 39 * GST_SECOND), 4);
+  assert_equals_int (gst_m3u8_find_file_by_offset (pl, 40 * GST_SECOND), 5);
+  assert_equals_int (gst_m3u8_find_file_by_offset (pl, 44 * GST_SECOND), -1);
+
+  /* Removing lines at the start still needs a full update */
+  ret = gst_m3u8_update (pl, g_strdup (LIVE_ROTATED_PLAYLIST));
+  assert_equals_int (ret, TRUE);
+  file = g_ptr_array_index (pl->files, 0);
+  assert_equals_int (file->sequence, 3001);
+
+  g_free (event_pl);
+  gst_hls_master_playlist_unref (master);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_low_latency_playlist)
+{
+  GstHLSMasterPlaylist *master;
+  GstM3U8 *pl;
+  GstM3U8MediaFile *file, *part;
+  gchar *uri;
+
+  master = load_playlist (LOW_LATENCY_PLAYLIST);
+  pl = master->default_variant->m3u8;
+
+  assert_equals_uint64 (pl->part_target, GST_SECOND);
+  assert_equals_uint64 (pl->part_hold_back, 3 * GST_SECOND);
+  assert_equals_int (pl->can_block_reload, TRUE);
+  fail_unless (gst_m3u8_has_partial_segments (pl));
+
+  assert_equals_int (pl->files->len, 2);
+  file = g_ptr_array_index (pl->files, 0);
+  fail_unless (file->partial_segments == NULL);
+  file = g_ptr_array_index (pl->files, 1);
+  assert_equals_int (file->sequence, 101);
+  fail_unless (file->partial_segments != NULL);
+  assert_equals_int (file->partial_segments->len, 4);
+  part = g_ptr_array_index (file->partial_segments, 2);
+  assert_equals_string (part->uri, "http://localhost/seg101.2.ts");
+  assert_equals_int (part->sequence, 101);
+  assert_equals_int (part->part_index, 2);
+  assert_equals_uint64 (part->duration, GST_SECOND);
+  assert_equals_int (part->independent, TRUE);
+  assert_equals_int (part->size, -1);
+  part = g_ptr_array_index (file->partial_segments, 3);
+  assert_equals_int (part->independent, FALSE);
+
+  /* Partial segments of the segment being produced */
+  fail_unless (pl->partial_segments != NULL);
+  assert_equals_int (pl->partial_segments->len, 2);
+  part = g_ptr_array_index (pl->partial_segments, 1);
+  assert_equals_string (part->uri, "http://localhost/seg102.ts");
+  assert_equals_int (part->sequence, 102);
+  assert_equals_int (part->offset, 1000);
+  assert_equals_int (part->size, 1200);
+
+  fail_unless (pl->preload_hint != NULL);
+  assert_equals_string (pl->preload_hint->uri, "http://localhost/seg102.ts");
+  assert_equals_int (pl->preload_hint->sequence, 102);
+  assert_equals_int (pl->preload_hint->part_index, 2);
+  assert_equals_int (pl->preload_hint->offset, 2200);
+  assert_equals_int (pl->preload_hint->size, -1);
+
+  uri = gst_m3u8_get_blocking_reload_uri (pl);
+  assert_equals_string (uri,
+      "http://localhost/test.m3u8?_HLS_msn=102&_HLS_part=2");
+  g_free (uri);
+
+  /* Renditions wait for the last partial segment of the main playlist */
+  uri = gst_m3u8_get_aligned_blocking_reload_uri (pl, pl);
+  assert_equals_string (uri,
+      "http://localhost/test.m3u8?_HLS_msn=102&_HLS_part=1");
+  g_free (uri);
+
+  gst_hls_master_playlist_unref (master);
+}
+
+GST_END_TEST;
+
+static void
+check_next_partial_segment (GstM3U8 * pl, const gchar * uri, gint64 offset,
+    GstClockTime position)
+{
+  GstM3U8MediaFile *file;
+  GstClockTime sequence_position;
+
+  file = gst_m3u8_get_next_fragment (pl, TRUE, &sequence_position, NULL);
+  fail_unless (file != NULL);
+  assert_equals_string (file->uri, uri);
+  assert_equals_int (file->offset, offset);
+  assert_equals_uint64 (sequence_position, position);
+  gst_m3u8_media_file_unref (file);
+}
+
+GST_START_TEST (test_low_latency_next_fragment)
+{
+  GstHLSMasterPlaylist *master;
+  GstM3U8 *pl;
+  gboolean ret;
+
+  master = load_playlist (LOW_LATENCY_PLAYLIST);
+  pl = master->default_variant->m3u8;
+
+  /* Start at the last independent partial segment at least PART-HOLD-BACK
+   * from the end */
+  fail_unless (gst_m3u8_seek_live_edge_part (pl));
+  assert_equals_int (pl->sequence, 101);
+  assert_equals_int (pl->current_part_idx, 2);
+
+  check_next_partial_segment (pl, "http://localhost/seg101.2.ts", 0,
+      6 * GST_SECOND);
+  gst_m3u8_advance_fragment (pl, TRUE);
+  check_next_partial_segment (pl, "http://localhost/seg101.3.ts", 0,
+      7 * GST_SECOND);
+  gst_m3u8_advance_fragment (pl, TRUE);
+  check_next_partial_segment (pl, "http://localhost/seg102.ts", 0,
+      8 * GST_SECOND);
+  gst_m3u8_advance_fragment (pl, TRUE);
+  check_next_partial_segment (pl, "http://localhost/seg102.ts", 1000,
+      9 * GST_SECOND);
+  fail_unless (gst_m3u8_has_next_fragment (pl, TRUE));
+  gst_m3u8_advance_fragment (pl, TRUE);
+
+  /* The preload hint comes last */
+  check_next_partial_segment (pl, "http://localhost/seg102.ts", 2200,
+      10 * GST_SECOND);
+  fail_if (gst_m3u8_has_next_fragment (pl, TRUE));
+  gst_m3u8_advance_fragment (pl, TRUE);
+  fail_unless (gst_m3u8_get_next_fragment (pl, TRUE, NULL, NULL) == NULL);
+
+  /* Continue with the rest of the segment once it is complete */
+  ret = gst_m3u8_update (pl, g_strdup (LOW_LATENCY_UPDATED_PLAYLIST));
+  assert_equals_int (ret, TRUE);
+  check_next_partial_segment (pl, "http://localhost/seg102.ts", 3300,
+      11 * GST_SECOND);
+  gst_m3u8_advance_fragment (pl, TRUE);
+  check_next_partial_segment (pl, "http://localhost/seg103.0.ts", 0,
+      12 * GST_SECOND);
+  gst_m3u8_advance_fragment (pl, TRUE);
+  check_next_partial_segment (pl, "http://localhost/seg103.1.ts", 0,
+      13 * GST_SECOND);
+
   gst_hls_master_playlist_unref (master);
 }
 
@@ -724,9 +958,9 @@ GST_START_TEST (test_playlist_media_files)
   pl = master->default_variant->m3u8;
 
   /* Check number of entries */
-  assert_equals_int (g_list_length (pl->files), 4);
+  assert_equals_int (pl->files->len, 4);
   /* Check first media segments */
-  file = GST_M3U8_MEDIA_FILE (g_list_first (pl->files)->data);
+  file = GST_M3U8_MEDIA_FILE (g_ptr_array_index (pl->files, 0));
   assert_equals_string (file->uri, "http://media.example.com/001.ts");
   assert_equals_int (file->sequence, 0);
   assert_equals_float (file->duration, 10 * (double) GST_SECOND);
@@ -749,16 +983,17 @@ GST_START_TEST (test_playlist_byte_range_media_files)
   pl = master->default_variant->m3u8;
 
   /* Check number of entries */
-  assert_equals_int (g_list_length (pl->files), 4);
+  assert_equals_int (pl->files->len, 4);
   /* Check first media segments */
-  file = GST_M3U8_MEDIA_FILE (g_list_first (pl->files)->data);
+  file = GST_M3U8_MEDIA_FILE (g_ptr_array_index (pl->files, 0));
   assert_equals_string (file->uri, "http://media.example.com/all.ts");
   assert_equals_int (file->sequence, 0);
   assert_equals_float (file->duration, 10 * (double) GST_SECOND);
   assert_equals_int (file->offset, 100);
   assert_equals_int (file->size, 1000);
   /* Check last media segments */
-  file = GST_M3U8_MEDIA_FILE (g_list_last (pl->files)->data);
+  file = GST_M3U8_MEDIA_FILE (g_ptr_array_index (pl->files,
+          pl->files->len - 1));
   assert_equals_string (file->uri, "http://media.example.com/all.ts");
   assert_equals_int (file->sequence, 3);
   assert_equals_float (file->duration, 10 * (double) GST_SECOND);
@@ -772,16 +1007,17 @@ GST_START_TEST (test_playlist_byte_range_media_files)
   pl = master->default_variant->m3u8;
 
   /* Check number of entries */
-  assert_equals_int (g_list_length (pl->files), 4);
+  assert_equals_int (pl->files->len, 4);
   /* Check first media segments */
-  file = GST_M3U8_MEDIA_FILE (g_list_first (pl->files)->data);
+  file = GST_M3U8_MEDIA_FILE (g_ptr_array_index (pl->files, 0));
   assert_equals_string (file->uri, "http://media.example.com/all.ts");
   assert_equals_int (file->sequence, 0);
   assert_equals_float (file->duration, 10 * (double) GST_SECOND);
   assert_equals_int (file->offset, 0);
   assert_equals_int (file->size, 1000);
   /* Check last media segments */
-  file = GST_M3U8_MEDIA_FILE (g_list_last (pl->files)->data);
+  file = GST_M3U8_MEDIA_FILE (g_ptr_array_index (pl->files,
+          pl->files->len - 1));
   assert_equals_string (file->uri, "http://media.example.com/all.ts");
   assert_equals_int (file->sequence, 3);
   assert_equals_float (file->duration, 10 * (double) GST_SECOND);
@@ -845,6 +1081,51 @@ GST_START_TEST (test_get_next_fragment)
 
 GST_END_TEST;
 
+GST_START_TEST (test_peek_fragment)
+{
+  GstHLSMasterPlaylist *master;
+  GstM3U8 *pl;
+  GstM3U8MediaFile *mf;
+
+  master = load_playlist (BYTE_RANGES_PLAYLIST);
+  pl = master->default_variant->m3u8;
+
+  mf = gst_m3u8_get_next_fragment (pl, TRUE, NULL, NULL);
+  fail_unless (mf != NULL);
+  assert_equals_uint64 (mf->offset, 100);
+  gst_m3u8_media_file_unref (mf);
+
+  /* Peeking does not move the current position */
+  mf = gst_m3u8_peek_fragment (pl, TRUE, 2);
+  fail_unless (mf != NULL);
+  assert_equals_uint64 (mf->offset, 2000);
+  gst_m3u8_media_file_unref (mf);
+
+  mf = gst_m3u8_peek_fragment (pl, TRUE, 1);
+  fail_unless (mf != NULL);
+  assert_equals_uint64 (mf->offset, 1000);
+  gst_m3u8_media_file_unref (mf);
+
+  fail_unless (gst_m3u8_peek_fragment (pl, TRUE, 4) == NULL);
+  fail_unless (gst_m3u8_peek_fragment (pl, FALSE, 1) == NULL);
+
+  gst_m3u8_advance_fragment (pl, TRUE);
+
+  mf = gst_m3u8_peek_fragment (pl, TRUE, 0);
+  fail_unless (mf != NULL);
+  assert_equals_uint64 (mf->offset, 1000);
+  gst_m3u8_media_file_unref (mf);
+
+  mf = gst_m3u8_peek_fragment (pl, FALSE, 1);
+  fail_unless (mf != NULL);
+  assert_equals_uint64 (mf->offset, 100);
+  gst_m3u8_media_file_unref (mf);
+
+  gst_hls_master_playlist_unref (master);
+}
+
+GST_END_TEST;
+
 GST_START_TEST (test_get_duration)
 {
   GstHLSMasterPlaylist *master;
@@ -1413,8 +1694,9 @@ GST_START_TEST (test_map_tag)
   GstHLSMasterPlaylist *master;
   GstHLSVariantStream *stream;
   GstM3U8 *m3u8;
-  GList *files, *walk;
+  GPtrArray *files;
   GstM3U8MediaFile *seg1, *seg2, *seg3;
+  guint i;
   GstM3U8InitFile *init1, *init2;
 
   /* Test EXT-X-MAP tag
@@ -1434,25 +1716,26 @@ GST_START_TEST (test_map_tag)
 
   files = m3u8->files;
   fail_unless (m3u8 != NULL);
-  assert_equals_int (g_list_length (files), 3);
-  for (walk = files; walk; walk = g_list_next (walk)) {
-    GstM3U8MediaFile *file = (GstM3U8MediaFile *) walk->data;
+  assert_equals_int (files->len, 3);
+  for (i = 0; i < files->len; i++) {
+    GstM3U8MediaFile *file = g_ptr_array_index (files, i);
 
     GstM3U8InitFile *init_file = file->init_file;
     fail_unless (init_file != NULL);
     fail_unless (init_file->uri != NULL);
   }
 
-  seg1 = g_list_nth_data (files, 0);
-  seg2 = g_list_nth_data (files, 1);
-  seg3 = g_list_nth_data (files, 2);
+  seg1 = g_ptr_array_index (files, 0);
+  seg2 = g_ptr_array_index (files, 1);
+  seg3 = g_ptr_array_index (files, 2);
 
   /* Segment 1 and 2 share the identical init segment */
   fail_unless (seg1->init_file == seg2->init_file);
   assert_equals_int (seg1->init_file->ref_count, 2);
 
   fail_unless (seg2->init_file != seg3->init_file);
-  assert_equals_int (seg3->init_file->ref_count, 1);
+  /* The last one is also kept to parse segments appended later on */
+  assert_equals_int (seg3->init_file->ref_count, 2);
 
   init1 = seg1->init_file;
   init2 = seg3->init_file;
@@ -1495,9 +1778,13 @@ hlsdemux_suite (void)
   tcase_add_test (tc_m3u8, test_playlist_with_encryption);
   tcase_add_test (tc_m3u8, test_update_invalid_playlist);
   tcase_add_test (tc_m3u8, test_update_playlist);
+  tcase_add_test (tc_m3u8, test_update_appended_playlist);
+  tcase_add_test (tc_m3u8, test_low_latency_playlist);
+  tcase_add_test (tc_m3u8, test_low_latency_next_fragment);
   tcase_add_test (tc_m3u8, test_playlist_media_files);
   tcase_add_test (tc_m3u8, test_playlist_byte_range_media_files);
   tcase_add_test (tc_m3u8, test_get_next_fragment);
+  tcase_add_test (tc_m3u8, test_peek_fragment);
   tcase_add_test (tc_m3u8, test_get_duration);
   tcase_add_test (tc_m3u8, test_get_target_duration);
   tcase_add_test (tc_m3u8, test_get_stream_for_bitrate);
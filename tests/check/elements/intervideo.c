@@ -0,0 +1,270 @@
+/* GStreamer
+ * unit test for intervideosink and intervideosrc
+ *
+ * Copyright (C) 2026 agent <agent@local>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include <gst/check/gstcheck.h>
+#include <gst/check/gstharness.h>
+#include <gst/video/video.h>
+
+#define VIDEO_CAPS_STR \
+    "video/x-raw,format=I420,width=64,height=48,framerate=30/1"
+#define FRAME_SIZE (64 * 48 * 3 / 2)
+#define SMALL_VIDEO_CAPS_STR \
+    "video/x-raw,format=I420,width=32,height=24,framerate=30/1"
+#define SMALL_FRAME_SIZE (32 * 24 * 3 / 2)
+
+/* Pushes a frame of the current caps filled with @n */
+static void
+push_frame (GstHarness * h, guint8 n)
+{
+  GstBuffer *buffer;
+  GstVideoInfo info;
+  GstCaps *caps;
+
+  caps = gst_pad_get_current_caps (h->srcpad);
+  fail_unless (gst_video_info_from_caps (&info, caps));
+  gst_caps_unref (caps);
+
+  buffer = gst_harness_create_buffer (h, info.size);
+  gst_buffer_memset (buffer, 0, n, info.size);
+  GST_BUFFER_PTS (buffer) = (n - 1) * GST_SECOND / 30;
+  GST_BUFFER_DURATION (buffer) = GST_SECOND / 30;
+  fail_unless_equals_int (gst_harness_push (h, buffer), GST_FLOW_OK);
+}
+
+static GstHarness *
+start_src (const gchar * frame_selection)
+{
+  GstHarness *h;
+
+  h = gst_harness_new ("intervideosrc");
+  gst_util_set_object_arg (G_OBJECT (h->element), "frame-selection",
+      frame_selection);
+  gst_harness_play (h);
+  fail_unless (gst_harness_wait_for_clock_id_waits (h, 1, 5));
+
+  return h;
+}
+
+/* Returns the frame number of the next output frame, or 0 if it is a
+ * repeat, and its size in @size. The frame after that is selected already
+ * when this returns. */
+static guint8
+pull_frame_full (GstHarness * h, gsize * size)
+{
+  GstBuffer *buffer;
+  guint8 n = 0;
+
+  fail_unless (gst_harness_crank_single_clock_wait (h));
+  buffer = gst_harness_pull (h);
+  fail_unless (buffer != NULL);
+  fail_unless (gst_harness_wait_for_clock_id_waits (h, 1, 5));
+
+  if (!GST_BUFFER_FLAG_IS_SET (buffer, GST_BUFFER_FLAG_GAP))
+    fail_unless_equals_int (gst_buffer_extract (buffer, 0, &n, 1), 1);
+  if (size)
+    *size = gst_buffer_get_size (buffer);
+  gst_buffer_unref (buffer);
+
+  return n;
+}
+
+static guint8
+pull_frame (GstHarness * h)
+{
+  return pull_frame_full (h, NULL);
+}
+
+GST_START_TEST (test_fan_out)
+{
+  GstHarness *sink, *sequential, *latest;
+  guint64 dropped, duplicated;
+  guint8 n;
+
+  sink = gst_harness_new_parse ("intervideosink queue-size=4 sync=false");
+  gst_harness_set_src_caps_str (sink, VIDEO_CAPS_STR);
+  push_frame (sink, 1);
+
+  sequential = start_src ("sequential");
+  latest = start_src ("latest");
+  fail_unless_equals_int (pull_frame (sequential), 1);
+  fail_unless_equals_int (pull_frame (latest), 1);
+
+  /* Four frames fit in the queue, the sequential reader outputs all of them
+   * while the other one skips to the most recent */
+  for (n = 2; n <= 5; n++)
+    push_frame (sink, n);
+
+  fail_unless_equals_int (pull_frame (sequential), 0);
+  for (n = 2; n <= 5; n++)
+    fail_unless_equals_int (pull_frame (sequential), n);
+  fail_unless_equals_int (pull_frame (sequential), 0);
+
+  fail_unless_equals_int (pull_frame (latest), 0);
+  fail_unless_equals_int (pull_frame (latest), 5);
+  fail_unless_equals_int (pull_frame (latest), 0);
+
+  g_object_get (sequential->element, "drop", &dropped, "duplicate",
+      &duplicated, NULL);
+  fail_unless_equals_uint64 (dropped, 0);
+  fail_unless (duplicated >= 2);
+
+  g_object_get (latest->element, "drop", &dropped, "duplicate",
+      &duplicated, NULL);
+  fail_unless_equals_uint64 (dropped, 3);
+  fail_unless (duplicated >= 2);
+
+  gst_harness_teardown (latest);
+  gst_harness_teardown (sequential);
+  gst_harness_teardown (sink);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_sequential_overrun)
+{
+  GstHarness *sink, *src;
+  guint64 dropped;
+  guint8 n;
+
+  sink = gst_harness_new_parse ("intervideosink queue-size=2 sync=false");
+  gst_harness_set_src_caps_str (sink, VIDEO_CAPS_STR);
+  push_frame (sink, 1);
+
+  src = start_src ("sequential");
+  fail_unless_equals_int (pull_frame (src), 1);
+
+  /* Only the last two frames are still queued when the reader catches up */
+  for (n = 2; n <= 6; n++)
+    push_frame (sink, n);
+
+  fail_unless_equals_int (pull_frame (src), 0);
+  fail_unless_equals_int (pull_frame (src), 5);
+  fail_unless_equals_int (pull_frame (src), 6);
+  g_object_get (src->element, "drop", &dropped, NULL);
+  fail_unless_equals_uint64 (dropped, 3);
+
+  gst_harness_teardown (src);
+  gst_harness_teardown (sink);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_timestamp_selection)
+{
+  GstHarness *sink, *src;
+  guint64 dropped;
+  guint8 n;
+
+  /* Queue six frames ahead, each one is due one output frame later */
+  sink = gst_harness_new_parse ("intervideosink queue-size=8 sync=false");
+  gst_harness_set_src_caps_str (sink, VIDEO_CAPS_STR);
+  for (n = 1; n <= 6; n++)
+    push_frame (sink, n);
+
+  src = start_src ("timestamp");
+  for (n = 1; n <= 6; n++)
+    fail_unless_equals_int (pull_frame (src), n);
+  fail_unless_equals_int (pull_frame (src), 0);
+
+  g_object_get (src->element, "drop", &dropped, NULL);
+  fail_unless_equals_uint64 (dropped, 0);
+
+  gst_harness_teardown (src);
+  gst_harness_teardown (sink);
+}
+
+GST_END_TEST;
+
+static void
+check_caps_change (const gchar * frame_selection)
+{
+  GstHarness *sink, *src;
+  GstVideoInfo info;
+  GstCaps *caps;
+  gsize size;
+  guint8 n = 0;
+  guint i;
+
+  sink = gst_harness_new_parse ("intervideosink queue-size=4 sync=false");
+  gst_harness_set_src_caps_str (sink, VIDEO_CAPS_STR);
+  push_frame (sink, 1);
+
+  src = start_src (frame_selection);
+  fail_unless_equals_int (pull_frame (src), 1);
+
+  /* Two frames are still queued when the format changes */
+  push_frame (sink, 2);
+  push_frame (sink, 3);
+  gst_harness_set_src_caps_str (sink, SMALL_VIDEO_CAPS_STR);
+  push_frame (sink, 4);
+
+  /* The repeat of the first frame was made before the change */
+  fail_unless_equals_int (pull_frame_full (src, &size), 0);
+  fail_unless_equals_int (size, FRAME_SIZE);
+
+  /* Then only frames of the new format, the queued ones are dropped */
+  for (i = 0; i < 4 && n == 0; i++) {
+    n = pull_frame_full (src, &size);
+    fail_unless_equals_int (size, SMALL_FRAME_SIZE);
+  }
+  fail_unless_equals_int (n, 4);
+
+  caps = gst_pad_get_current_caps (src->sinkpad);
+  fail_unless (gst_video_info_from_caps (&info, caps));
+  fail_unless_equals_int (GST_VIDEO_INFO_WIDTH (&info), 32);
+  fail_unless_equals_int (GST_VIDEO_INFO_HEIGHT (&info), 24);
+  gst_caps_unref (caps);
+
+  gst_harness_teardown (src);
+  gst_harness_teardown (sink);
+}
+
+GST_START_TEST (test_caps_change_sequential)
+{
+  check_caps_change ("sequential");
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_caps_change_timestamp)
+{
+  check_caps_change ("timestamp");
+}
+
+GST_END_TEST;
+
+static Suite *
+intervideo_suite (void)
+{
+  Suite *s = suite_create ("intervideo");
+  TCase *tc_chain = tcase_create ("general");
+
+  suite_add_tcase (s, tc_chain);
+  tcase_add_test (tc_chain, test_fan_out);
+  tcase_add_test (tc_chain, test_sequential_overrun);
+  tcase_add_test (tc_chain, test_timestamp_selection);
+  tcase_add_test (tc_chain, test_caps_change_sequential);
+  tcase_add_test (tc_chain, test_caps_change_timestamp);
+
+  return s;
+}
+
+GST_CHECK_MAIN (intervideo);
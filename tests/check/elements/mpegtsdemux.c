@@ -335,6 +335,155 @@ GST_START_TEST (test_tsparse_padding)
 
 GST_END_TEST;
 
+/* Minimal transport stream writer, for the streams built by the tests.
+ * The PMT of program N is on PID 0x1000 + N and there is no PCR PID, so
+ * that tsdemux times the streams from their PTS */
+static guint32
+ts_crc32 (const guint8 * data, guint len)
+{
+  guint32 crc = 0xffffffff;
+  guint i, j;
+
+  for (i = 0; i < len; i++) {
+    crc ^= (guint32) data[i] << 24;
+    for (j = 0; j < 8; j++)
+      crc = (crc & 0x80000000) ? (crc << 1) ^ 0x04c11db7 : crc << 1;
+  }
+
+  return crc;
+}
+
+static void
+ts_append_section (GByteArray * ts, guint16 pid, guint8 * section, guint len,
+    guint8 * cc)
+{
+  guint8 packet[PACKETSIZE];
+
+  /* section_length covers the CRC */
+  section[1] = 0xb0 | ((len + 1) >> 8);
+  section[2] = (len + 1) & 0xff;
+
+  memset (packet, 0xff, PACKETSIZE);
+  packet[0] = 0x47;
+  packet[1] = 0x40 | (pid >> 8);
+  packet[2] = pid & 0xff;
+  packet[3] = 0x10 | ((*cc)++ & 0x0f);
+  /* pointer_field */
+  packet[4] = 0;
+  memcpy (packet + 5, section, len);
+  GST_WRITE_UINT32_BE (packet + 5 + len, ts_crc32 (section, len));
+
+  g_byte_array_append (ts, packet, PACKETSIZE);
+}
+
+static void
+ts_append_pat (GByteArray * ts, const guint16 * programs, guint n_programs,
+    guint8 * cc)
+{
+  guint8 section[64] = { 0x00, 0, 0, 0x00, 0x01, 0xc1, 0x00, 0x00 };
+  guint i, len = 8;
+
+  for (i = 0; i < n_programs; i++) {
+    guint16 pmt_pid = 0x1000 + programs[i];
+
+    GST_WRITE_UINT16_BE (section + len, programs[i]);
+    section[len + 2] = 0xe0 | (pmt_pid >> 8);
+    section[len + 3] = pmt_pid & 0xff;
+    len += 4;
+  }
+
+  ts_append_section (ts, 0, section, len, cc);
+}
+
+/* @streams are pairs of PID and stream type */
+static void
+ts_append_pmt (GByteArray * ts, guint16 program, const guint16 * streams,
+    guint n_streams, guint8 * cc)
+{
+  guint8 section[128] = { 0x02, 0, 0, 0, 0, 0xc1, 0x00, 0x00, 0xff, 0xff,
+    0xf0, 0x00
+  };
+  guint i, len = 12;
+
+  GST_WRITE_UINT16_BE (section + 3, program);
+  for (i = 0; i < n_streams; i++) {
+    section[len] = streams[2 * i + 1];
+    section[len + 1] = 0xe0 | (streams[2 * i] >> 8);
+    section[len + 2] = streams[2 * i] & 0xff;
+    section[len + 3] = 0xf0;
+    section[len + 4] = 0x00;
+    len += 5;
+  }
+
+  ts_append_section (ts, 0x1000 + program, section, len, cc);
+}
+
+/* Appends a PES packet with a PTS, of unbounded size unless @bounded */
+static void
+ts_append_pes (GByteArray * ts, guint16 pid, guint8 stream_id, guint64 pts,
+    const guint8 * data, gsize size, gboolean bounded, guint8 * cc)
+{
+  guint8 header[14] = { 0x00, 0x00, 0x01, stream_id, 0, 0, 0x80, 0x80, 0x05 };
+  gboolean first = TRUE;
+  gsize offset = 0;
+
+  if (bounded)
+    GST_WRITE_UINT16_BE (header + 4, size + 8);
+  header[9] = 0x21 | ((pts >> 29) & 0x0e);
+  header[10] = (pts >> 22) & 0xff;
+  header[11] = ((pts >> 14) & 0xfe) | 0x01;
+  header[12] = (pts >> 7) & 0xff;
+  header[13] = ((pts << 1) & 0xfe) | 0x01;
+
+  while (first || offset < size) {
+    guint8 packet[PACKETSIZE], *p = packet;
+    guint header_size = first ? sizeof (header) : 0;
+    gsize payload = MIN (PACKETSIZE - 4 - header_size, size - offset);
+    guint stuffing = PACKETSIZE - 4 - header_size - payload;
+
+    p[0] = 0x47;
+    p[1] = (first ? 0x40 : 0) | (pid >> 8);
+    p[2] = pid & 0xff;
+    p[3] = (stuffing ? 0x30 : 0x10) | ((*cc)++ & 0x0f);
+    p += 4;
+
+    /* Adaptation field stuffing */
+    if (stuffing) {
+      p[0] = stuffing - 1;
+      if (stuffing > 1) {
+        p[1] = 0x00;
+        memset (p + 2, 0xff, stuffing - 2);
+      }
+      p += stuffing;
+    }
+
+    memcpy (p, header, header_size);
+    memcpy (p + header_size, data + offset, payload);
+    offset += payload;
+    first = FALSE;
+
+    g_byte_array_append (ts, packet, PACKETSIZE);
+  }
+}
+
+static guint8 *
+create_frame (guint index, gsize size)
+{
+  guint8 *data = g_malloc (size);
+  gsize i;
+
+  for (i = 0; i < size; i++)
+    data[i] = index * 7 + i;
+
+  return data;
+}
+
+static void
+tsdemux_any_pad_added (GstElement * tsdemux, GstPad * pad, GstHarness * h)
+{
+  gst_harness_add_element_src_pad (h, pad);
+}
+
 static void
 tsdemux_simple_pad_added (GstElement * tsdemux, GstPad * pad, GstHarness * h)
 {
@@ -377,6 +526,317 @@ GST_START_TEST (test_tsdemux_simple)
 
 GST_END_TEST;
 
+/* Pushes @ts as if it was received live at @time */
+static void
+push_ts (GstHarness * h, GByteArray * ts, GstClockTime time)
+{
+  GstBuffer *buf = gst_buffer_new_allocate (NULL, ts->len, NULL);
+
+  gst_buffer_fill (buf, 0, ts->data, ts->len);
+  GST_BUFFER_PTS (buf) = time;
+  fail_unless (gst_harness_push (h, buf) == GST_FLOW_OK);
+  g_byte_array_set_size (ts, 0);
+}
+
+GST_START_TEST (test_tsdemux_discard_unknown_pids)
+{
+  GstHarness *h = gst_harness_new_with_padnames ("tsdemux", "sink", NULL);
+  GstBuffer *buf, *padding;
+  GstStructure *stats;
+  GstCaps *caps;
+  GstSegment segment;
+  guint64 processed, discarded;
+
+  caps = gst_caps_from_string ("video/mpegts,systemstream=true");
+  gst_harness_push_event (h, gst_event_new_caps (caps));
+  gst_caps_unref (caps);
+
+  gst_segment_init (&segment, GST_FORMAT_BYTES);
+  gst_harness_push_event (h, gst_event_new_segment (&segment));
+
+  gst_harness_set_sink_caps_str (h,
+      "audio/mpeg,mpegversion=4,stream-format=adts");
+
+  g_signal_connect (h->element, "pad-added",
+      G_CALLBACK (tsdemux_simple_pad_added), h);
+
+  buf =
+      gst_buffer_new_wrapped_full (GST_MEMORY_FLAG_READONLY, (guint8 *) aac_ts,
+      sizeof aac_ts, 0, sizeof aac_ts, NULL, NULL);
+  padding =
+      gst_buffer_new_wrapped_full (GST_MEMORY_FLAG_READONLY,
+      (guint8 *) padding_ts, sizeof padding_ts, 0, sizeof padding_ts, NULL,
+      NULL);
+
+  fail_unless (gst_harness_push (h, gst_buffer_ref (padding)) == GST_FLOW_OK);
+  fail_unless (gst_harness_push (h, buf) == GST_FLOW_OK);
+  fail_unless (gst_harness_push (h, padding) == GST_FLOW_OK);
+  gst_harness_push_event (h, gst_event_new_eos ());
+
+  buf = gst_harness_take_all_data_as_buffer (h);
+  gst_check_buffer_data (buf, aac_data, sizeof aac_data);
+  gst_buffer_unref (buf);
+
+  /* The padding packets are dropped by the packetizer */
+  g_object_get (h->element, "stats", &stats, NULL);
+  fail_unless (gst_structure_get_uint64 (stats, "packets-processed",
+          &processed));
+  fail_unless (gst_structure_get_uint64 (stats, "packets-discarded",
+          &discarded));
+  fail_unless_equals_uint64 (processed, aac_ts_packets);
+  fail_unless_equals_uint64 (discarded, 2);
+  gst_structure_free (stats);
+
+  gst_harness_teardown (h);
+}
+
+GST_END_TEST;
+
+static void
+tsdemux_program_2_pad_added (GstElement * tsdemux, GstPad * pad,
+    GstHarness * h)
+{
+  fail_unless (g_str_has_suffix (GST_PAD_NAME (pad), "_0200"));
+  gst_harness_add_element_src_pad (h, pad);
+}
+
+GST_START_TEST (test_tsdemux_discard_unselected_programs)
+{
+  static const guint16 programs[] = { 1, 2 };
+  static const guint16 streams_1[] = { 0x100, 0x02 };
+  static const guint16 streams_2[] = { 0x200, 0x02 };
+  GstHarness *h = gst_harness_new_with_padnames ("tsdemux", "sink", NULL);
+  GByteArray *ts = g_byte_array_new ();
+  guint8 ccs[5] = { 0, };
+  guint64 processed, discarded, total = 0, program_1 = 0;
+  GstStructure *stats;
+  GstSegment segment;
+  GstCaps *caps;
+  guint i;
+
+  g_object_set (h->element, "program-number", 2, NULL);
+
+  caps = gst_caps_from_string ("video/mpegts,systemstream=true");
+  gst_harness_push_event (h, gst_event_new_caps (caps));
+  gst_caps_unref (caps);
+
+  gst_segment_init (&segment, GST_FORMAT_TIME);
+  gst_harness_push_event (h, gst_event_new_segment (&segment));
+
+  gst_harness_set_sink_caps_str (h, "video/mpeg,mpegversion=2");
+  g_signal_connect (h->element, "pad-added",
+      G_CALLBACK (tsdemux_program_2_pad_added), h);
+
+  /* Both programs get activated, but only the second one is selected */
+  ts_append_pat (ts, programs, 2, &ccs[0]);
+  ts_append_pmt (ts, 1, streams_1, 1, &ccs[1]);
+  ts_append_pmt (ts, 2, streams_2, 1, &ccs[2]);
+  total += ts->len / PACKETSIZE;
+  push_ts (h, ts, 0);
+
+  for (i = 0; i < 4; i++) {
+    guint8 *data = create_frame (i, 1000);
+
+    ts_append_pes (ts, 0x100, 0xe0, 90000 + i * 3600, data, 1000, FALSE,
+        &ccs[3]);
+    program_1 += ts->len / PACKETSIZE;
+    ts_append_pes (ts, 0x200, 0xe0, 90000 + i * 3600, data, 1000, FALSE,
+        &ccs[4]);
+    total += ts->len / PACKETSIZE;
+    push_ts (h, ts, i * 40 * GST_MSECOND);
+    g_free (data);
+  }
+  gst_harness_push_event (h, gst_event_new_eos ());
+
+  fail_unless_equals_int (gst_harness_buffers_received (h), 4);
+  for (i = 0; i < 4; i++) {
+    GstBuffer *buf = gst_harness_pull (h);
+    guint8 *data = create_frame (i, 1000);
+
+    gst_check_buffer_data (buf, data, 1000);
+    gst_buffer_unref (buf);
+    g_free (data);
+  }
+
+  /* The packets of the first program don't go past the packetizer */
+  g_object_get (h->element, "stats", &stats, NULL);
+  fail_unless (gst_structure_get_uint64 (stats, "packets-processed",
+          &processed));
+  fail_unless (gst_structure_get_uint64 (stats, "packets-discarded",
+          &discarded));
+  fail_unless_equals_uint64 (discarded, program_1);
+  fail_unless_equals_uint64 (processed, total - program_1);
+  gst_structure_free (stats);
+
+  g_byte_array_unref (ts);
+  gst_harness_teardown (h);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_tsparse_extra_pids)
+{
+  static const guint16 programs[] = { 1 };
+  static const guint16 streams[] = { 0x100, 0x02 };
+  GstHarness *h = gst_harness_new ("tsparse");
+  GByteArray *ts = g_byte_array_new (), *expected = g_byte_array_new ();
+  guint8 ccs[4] = { 0, }, *data = create_frame (0, 500);
+  GValue pids = G_VALUE_INIT, pid = G_VALUE_INIT;
+  GstBuffer *buf;
+  guint i;
+
+  /* Keep PID 0x300 besides the PSI and the program, drop 0x301 */
+  g_value_init (&pids, GST_TYPE_ARRAY);
+  g_value_init (&pid, G_TYPE_INT);
+  g_value_set_int (&pid, 0x300);
+  gst_value_array_append_value (&pids, &pid);
+  g_object_set_property (G_OBJECT (h->element), "extra-pids", &pids);
+  g_value_unset (&pid);
+  g_value_unset (&pids);
+
+  gst_harness_set_src_caps_str (h, "video/mpegts,systemstream=true");
+  gst_harness_set_sink_caps_str (h,
+      "video/mpegts,systemstream=true,packetsize=" G_STRINGIFY (PACKETSIZE));
+
+  ts_append_pat (ts, programs, 1, &ccs[0]);
+  ts_append_pmt (ts, 1, streams, 1, &ccs[1]);
+  ts_append_pes (ts, 0x100, 0xe0, 90000, data, 500, FALSE, &ccs[2]);
+  ts_append_pes (ts, 0x300, 0xbd, 90000, data, 500, TRUE, &ccs[3]);
+  g_byte_array_append (expected, ts->data, ts->len);
+  for (i = 0; i < 2; i++)
+    ts_append_pes (ts, 0x301, 0xbd, 90000, data, 500, TRUE, &ccs[3]);
+  g_free (data);
+
+  buf = gst_buffer_new_allocate (NULL, ts->len, NULL);
+  gst_buffer_fill (buf, 0, ts->data, ts->len);
+  fail_unless (gst_harness_push (h, buf) == GST_FLOW_OK);
+  gst_harness_push_event (h, gst_event_new_eos ());
+
+  buf = gst_harness_take_all_data_as_buffer (h);
+  gst_check_buffer_data (buf, expected->data, expected->len);
+  gst_buffer_unref (buf);
+
+  g_byte_array_unref (expected);
+  g_byte_array_unref (ts);
+  gst_harness_teardown (h);
+}
+
+GST_END_TEST;
+
+/* Returns the bytes copied to collect the PES packets, beyond the single
+ * copy of their payload out of the TS packets */
+static guint64
+get_pes_extra_copies (GstHarness * h)
+{
+  GstStructure *stats;
+  guint64 pes_bytes, copied;
+
+  g_object_get (h->element, "stats", &stats, NULL);
+  fail_unless (gst_structure_get_uint64 (stats, "pes-bytes", &pes_bytes));
+  fail_unless (gst_structure_get_uint64 (stats, "pes-bytes-copied", &copied));
+  gst_structure_free (stats);
+
+  fail_unless (copied >= pes_bytes);
+
+  return copied - pes_bytes;
+}
+
+/* Unbounded video PES packets: keyframes separated by small frames */
+static const gsize pes_frame_sizes[] = {
+  200000, 5000, 5000, 5000, 180000, 5000, 200000, 3000
+};
+
+static void
+check_pes_collection (gboolean pes_arena)
+{
+  static const guint16 programs[] = { 1 };
+  static const guint16 streams[] = { 0x100, 0x02 };
+  GstHarness *h = gst_harness_new_with_padnames ("tsdemux", "sink", NULL);
+  GByteArray *ts = g_byte_array_new ();
+  guint8 ccs[3] = { 0, };
+  guint64 first_copies = 0;
+  GstSegment segment;
+  GstCaps *caps;
+  guint i;
+
+  g_object_set (h->element, "pes-arena", pes_arena, NULL);
+
+  caps = gst_caps_from_string ("video/mpegts,systemstream=true");
+  gst_harness_push_event (h, gst_event_new_caps (caps));
+  gst_caps_unref (caps);
+
+  gst_segment_init (&segment, GST_FORMAT_TIME);
+  gst_harness_push_event (h, gst_event_new_segment (&segment));
+
+  gst_harness_set_sink_caps_str (h, "video/mpeg,mpegversion=2");
+  g_signal_connect (h->element, "pad-added",
+      G_CALLBACK (tsdemux_any_pad_added), h);
+
+  ts_append_pat (ts, programs, 1, &ccs[0]);
+  ts_append_pmt (ts, 1, streams, 1, &ccs[1]);
+  push_ts (h, ts, 0);
+
+  /* Each PES packet is collected until the next one starts */
+  for (i = 0; i < G_N_ELEMENTS (pes_frame_sizes); i++) {
+    guint8 *data = create_frame (i, pes_frame_sizes[i]);
+
+    ts_append_pes (ts, 0x100, 0xe0, 90000 + i * 3600, data,
+        pes_frame_sizes[i], FALSE, &ccs[2]);
+    push_ts (h, ts, i * 40 * GST_MSECOND);
+    g_free (data);
+
+    if (i == 1)
+      first_copies = get_pes_extra_copies (h);
+  }
+  gst_harness_push_event (h, gst_event_new_eos ());
+
+  if (pes_arena) {
+    /* The arenas have room for the first keyframe */
+    fail_unless_equals_uint64 (first_copies, 0);
+  } else {
+    /* Only the first keyframe was grown, the size of the next ones was known
+     * even after the smaller frames */
+    fail_unless (first_copies > 0);
+  }
+  fail_unless_equals_uint64 (get_pes_extra_copies (h), first_copies);
+
+  fail_unless_equals_int (gst_harness_buffers_received (h),
+      G_N_ELEMENTS (pes_frame_sizes));
+
+  for (i = 0; i < G_N_ELEMENTS (pes_frame_sizes); i++) {
+    GstBuffer *buf = gst_harness_pull (h);
+    guint8 *data = create_frame (i, pes_frame_sizes[i]);
+    GstMemory *mem;
+
+    gst_check_buffer_data (buf, data, pes_frame_sizes[i]);
+    g_free (data);
+
+    /* The small frames don't keep memory sized for the keyframes */
+    fail_unless_equals_int (gst_buffer_n_memory (buf), 1);
+    mem = gst_buffer_peek_memory (buf, 0);
+    fail_unless_equals_int (mem->maxsize, pes_frame_sizes[i]);
+
+    gst_buffer_unref (buf);
+  }
+
+  g_byte_array_unref (ts);
+  gst_harness_teardown (h);
+}
+
+GST_START_TEST (test_tsdemux_pes_collection)
+{
+  check_pes_collection (FALSE);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_tsdemux_pes_arena)
+{
+  check_pes_collection (TRUE);
+}
+
+GST_END_TEST;
+
 static Suite *
 mpegtsdemux_suite (void)
 {
@@ -390,10 +850,15 @@ mpegtsdemux_suite (void)
   tcase_add_test (tc, test_tsparse_align_fuse);
   tcase_add_test (tc, test_tsparse_align_split);
   tcase_add_test (tc, test_tsparse_padding);
+  tcase_add_test (tc, test_tsparse_extra_pids);
 
   tc = tcase_create ("tsdemux");
   suite_add_tcase (s, tc);
   tcase_add_test (tc, test_tsdemux_simple);
+  tcase_add_test (tc, test_tsdemux_discard_unknown_pids);
+  tcase_add_test (tc, test_tsdemux_discard_unselected_programs);
+  tcase_add_test (tc, test_tsdemux_pes_collection);
+  tcase_add_test (tc, test_tsdemux_pes_arena);
 
   return s;
 }
@@ -586,6 +586,198 @@ GST_START_TEST (test_keyframe_flag_propagation)
 
 GST_END_TEST;
 
+#define CBR_BITRATE (4 * 1000 * 1000)
+
+static void
+test_cbr_check_output (GList * bufs)
+{
+  guint64 offset = 0, first_pcr_offset = 0, prev_pcr_offset = 0;
+  gint64 first_pcr = -1, prev_pcr = -1;
+  guint n_pcr = 0, n_pes = 0;
+
+  for (; bufs != NULL; bufs = bufs->next) {
+    GstBuffer *buf = bufs->data;
+    GstMapInfo map;
+    guint8 *data;
+    gsize size;
+
+    gst_buffer_map (buf, &map, GST_MAP_READ);
+    data = map.data;
+    size = map.size;
+    fail_unless (size % 188 == 0);
+
+    for (; size; data += 188, size -= 188, offset += 188) {
+      guint8 *payload = data + 4;
+      guint pid = GST_READ_UINT16_BE (data + 1) & 0x1FFF;
+      gboolean pusi = (data[1] & 0x40) != 0;
+      gint64 expected;
+
+      fail_unless (data[0] == 0x47);
+
+      if (data[3] & 0x20) {
+        guint8 af_len = data[4];
+
+        /* adaptation field with PCR */
+        if (af_len > 0 && (data[5] & 0x10)) {
+          guint64 base = ((guint64) GST_READ_UINT32_BE (data + 6) << 1) |
+              (data[10] >> 7);
+          guint ext = ((data[10] & 0x01) << 8) | data[11];
+          gint64 pcr = base * 300 + ext;
+
+          if (first_pcr == -1) {
+            first_pcr = pcr;
+            first_pcr_offset = offset;
+          } else {
+            /* PCR must match the byte position at the nominal bitrate,
+             * within the +/- 500ns accuracy required by the spec */
+            expected = first_pcr +
+                gst_util_uint64_scale (offset - first_pcr_offset, 8 * 27000000,
+                CBR_BITRATE);
+            fail_unless (ABS (pcr - expected) <= 13,
+                "PCR %" G_GINT64_FORMAT " at offset %" G_GUINT64_FORMAT
+                " expected %" G_GINT64_FORMAT, pcr, offset, expected);
+
+            /* default pcr-interval is 40ms */
+            fail_unless (offset - prev_pcr_offset <=
+                gst_util_uint64_scale (CBR_BITRATE, 41, 8 * 1000));
+            fail_unless (pcr > prev_pcr);
+          }
+          prev_pcr = pcr;
+          prev_pcr_offset = offset;
+          n_pcr++;
+        }
+        payload += af_len + 1;
+      }
+
+      /* video PES start: the data must be delivered before its DTS */
+      if (pid >= 0x40 && pid < 0x1FFF && pusi && first_pcr != -1 &&
+          GST_READ_UINT24_BE (payload) == 0x000001 &&
+          (payload[3] & 0xF0) == 0xE0) {
+        guint8 pts_dts_flags = payload[7] >> 6;
+        const guint8 *ts = payload + (pts_dts_flags == 3 ? 14 : 9);
+        guint64 dts;
+
+        fail_unless (pts_dts_flags & 0x2);
+        dts = ((guint64) (ts[0] & 0x0E) << 29) |
+            ((GST_READ_UINT16_BE (ts + 1) >> 1) << 15) |
+            (GST_READ_UINT16_BE (ts + 3) >> 1);
+
+        expected = first_pcr + gst_util_uint64_scale (offset - first_pcr_offset,
+            8 * 27000000, CBR_BITRATE);
+        fail_unless (expected <= dts * 300,
+            "PES with DTS %" G_GUINT64_FORMAT " output at PCR %" G_GINT64_FORMAT,
+            dts * 300, expected);
+        n_pes++;
+      }
+    }
+
+    gst_buffer_unmap (buf, &map);
+  }
+
+  fail_unless (n_pcr > 0);
+  fail_unless (n_pes > 0);
+
+  /* the output must be padded to the configured bitrate: 50 frames of 40ms */
+  fail_unless (offset >= gst_util_uint64_scale (CBR_BITRATE, 49 * 40,
+          8 * 1000));
+}
+
+GST_START_TEST (test_cbr)
+{
+  gchar *padname;
+  GstElement *mux;
+
+  mux = setup_tsmux (&video_src_template, "sink_%d", &padname);
+  g_object_set (mux, "bitrate", (guint64) CBR_BITRATE, NULL);
+
+  fail_unless (gst_element_set_state (mux,
+          GST_STATE_PLAYING) == GST_STATE_CHANGE_SUCCESS,
+      "could not set to playing");
+
+  check_tsmux_pad_given_muxer (mux, VIDEO_CAPS_STRING, 0xE0, 0x1b,
+      test_cbr_check_output, 50, 8000);
+
+  cleanup_tsmux (mux, padname);
+  g_free (padname);
+}
+
+GST_END_TEST;
+
+#define TSTD_TB_SIZE 512
+#define TSTD_AUDIO_RX 2000000
+
+/* Replays the T-STD transport buffer model on the audio PID of the output
+ * and checks that it never overflows */
+static void
+test_cbr_tstd_check_output (GList * bufs)
+{
+  guint64 offset = 0, prev_offset = 0;
+  gint64 fullness = 0;
+  guint n_packets = 0;
+
+  for (; bufs != NULL; bufs = bufs->next) {
+    GstBuffer *buf = bufs->data;
+    GstMapInfo map;
+    guint8 *data;
+    gsize size;
+
+    gst_buffer_map (buf, &map, GST_MAP_READ);
+    data = map.data;
+    size = map.size;
+    fail_unless (size % 188 == 0);
+
+    for (; size; data += 188, size -= 188, offset += 188) {
+      guint pid = GST_READ_UINT16_BE (data + 1) & 0x1FFF;
+
+      /* only packets carrying elementary stream data enter the buffer */
+      if (pid < 0x40 || pid == 0x1FFF || !(data[3] & 0x10))
+        continue;
+
+      if (n_packets > 0) {
+        fullness -= gst_util_uint64_scale (offset - prev_offset,
+            8 * TSTD_AUDIO_RX, CBR_BITRATE);
+        fullness = MAX (fullness, 0);
+      }
+      fullness += 188 * 8;
+
+      /* allow a byte for the rounding of the muxer's clock */
+      fail_unless (fullness <= TSTD_TB_SIZE * 8 + 8,
+          "transport buffer overflow at offset %" G_GUINT64_FORMAT
+          ": %" G_GINT64_FORMAT " bits", offset, fullness);
+
+      prev_offset = offset;
+      n_packets++;
+    }
+
+    gst_buffer_unmap (buf, &map);
+  }
+
+  fail_unless (n_packets > 0);
+}
+
+GST_START_TEST (test_cbr_tstd)
+{
+  gchar *padname;
+  GstElement *mux;
+
+  mux = setup_tsmux (&audio_src_template, "sink_%d", &padname);
+  g_object_set (mux, "bitrate", (guint64) CBR_BITRATE, NULL);
+
+  fail_unless (gst_element_set_state (mux,
+          GST_STATE_PLAYING) == GST_STATE_CHANGE_SUCCESS,
+      "could not set to playing");
+
+  /* 2000 byte frames are 11 packets, sent back to back they would
+   * overflow the 512 byte transport buffer */
+  check_tsmux_pad_given_muxer (mux, AUDIO_CAPS_STRING, 0xC0, 0x03,
+      test_cbr_tstd_check_output, 50, 2000);
+
+  cleanup_tsmux (mux, padname);
+  g_free (padname);
+}
+
+GST_END_TEST;
+
 static Suite *
 mpegtsmux_suite (void)
 {
@@ -599,6 +791,8 @@ mpegtsmux_suite (void)
   tcase_add_test (tc_chain, test_multiple_state_change);
   tcase_add_test (tc_chain, test_align);
   tcase_add_test (tc_chain, test_keyframe_flag_propagation);
+  tcase_add_test (tc_chain, test_cbr);
+  tcase_add_test (tc_chain, test_cbr_tstd);
   tcase_add_test (tc_chain, test_reappearing_pad_while_playing);
   tcase_add_test (tc_chain, test_reappearing_pad_while_stopped);
   tcase_add_test (tc_chain, test_unused_pad);
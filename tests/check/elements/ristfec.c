@@ -0,0 +1,476 @@
+/* GStreamer
+ * unit test for the RIST SMPTE 2022-1 FEC encoder and decoder
+ *
+ * Copyright (C) 2026 agent <agent@local>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include <gst/check/gstcheck.h>
+#include <gst/check/gstharness.h>
+#include <gst/rtp/rtp.h>
+
+/* Close to the wrap around, to check that it is handled */
+#define BASE_SEQ 65000
+#define N_FEC_STREAMS 2
+
+typedef gboolean (*LossFunc) (guint index, gpointer user_data);
+
+typedef struct
+{
+  GstHarness *enc;
+  GstHarness *enc_fec[N_FEC_STREAMS];
+  GstHarness *dec;
+  /* One pair of FEC pads per link */
+  GstHarness *dec_fec[2][N_FEC_STREAMS];
+  guint n_links;
+
+  guint n_packets;
+  GstBuffer **packets;
+  gboolean *lost;
+  guint *received;
+  guint n_lost;
+  guint n_recovered;
+  guint max_latency;
+} FecTest;
+
+static GstBuffer *
+create_packet (guint index)
+{
+  GstRTPBuffer rtp = GST_RTP_BUFFER_INIT;
+  guint payload_len = 20 + (index * 151) % 1300;
+  GstBuffer *buffer;
+  guint8 *payload;
+  guint i;
+
+  buffer = gst_rtp_buffer_new_allocate (payload_len, 0, 0);
+  gst_rtp_buffer_map (buffer, GST_MAP_WRITE, &rtp);
+  gst_rtp_buffer_set_seq (&rtp, (guint16) (BASE_SEQ + index));
+  gst_rtp_buffer_set_timestamp (&rtp, index / 3 * 3000);
+  gst_rtp_buffer_set_ssrc (&rtp, 0x12345678);
+  gst_rtp_buffer_set_payload_type (&rtp, 33);
+  gst_rtp_buffer_set_marker (&rtp, index % 7 == 0);
+  payload = gst_rtp_buffer_get_payload (&rtp);
+  for (i = 0; i < payload_len; i++)
+    payload[i] = (i * 7 + index) & 0xff;
+  gst_rtp_buffer_unmap (&rtp);
+
+  return buffer;
+}
+
+static void
+fec_test_setup (FecTest * t, guint columns, guint rows, gboolean row_fec,
+    guint n_links, guint n_packets)
+{
+  guint i, j;
+
+  memset (t, 0, sizeof (FecTest));
+
+  t->enc = gst_harness_new_with_padnames ("ristfecenc", "sink", "src");
+  g_object_set (t->enc->element, "columns", columns, "rows", rows,
+      "enable-row-fec", row_fec, NULL);
+  for (i = 0; i < N_FEC_STREAMS; i++) {
+    gchar name[16];
+
+    g_snprintf (name, sizeof (name), "fec_%u", i);
+    t->enc_fec[i] = gst_harness_new_with_element (t->enc->element, NULL, name);
+  }
+  gst_harness_set_src_caps_str (t->enc,
+      "application/x-rtp, media=video, clock-rate=90000, "
+      "encoding-name=MP2T, payload=33");
+
+  t->dec = gst_harness_new_with_padnames ("ristfecdec", "sink", "src");
+  gst_harness_set_src_caps_str (t->dec, "application/x-rtp");
+  t->n_links = n_links;
+  for (j = 0; j < n_links; j++) {
+    for (i = 0; i < N_FEC_STREAMS; i++) {
+      gchar name[16];
+
+      g_snprintf (name, sizeof (name), "fec_%u", j * N_FEC_STREAMS + i);
+      t->dec_fec[j][i] = gst_harness_new_with_element (t->dec->element,
+          name, NULL);
+      gst_harness_set_src_caps_str (t->dec_fec[j][i], "application/x-rtp");
+    }
+  }
+
+  t->n_packets = n_packets;
+  t->packets = g_new0 (GstBuffer *, n_packets);
+  t->lost = g_new0 (gboolean, n_packets);
+  t->received = g_new0 (guint, n_packets);
+}
+
+static void
+fec_test_teardown (FecTest * t)
+{
+  guint i, j;
+
+  for (i = 0; i < t->n_packets; i++)
+    gst_clear_buffer (&t->packets[i]);
+  g_free (t->packets);
+  g_free (t->lost);
+  g_free (t->received);
+
+  for (j = 0; j < t->n_links; j++)
+    for (i = 0; i < N_FEC_STREAMS; i++)
+      gst_harness_teardown (t->dec_fec[j][i]);
+  gst_harness_teardown (t->dec);
+
+  for (i = 0; i < N_FEC_STREAMS; i++)
+    gst_harness_teardown (t->enc_fec[i]);
+  gst_harness_teardown (t->enc);
+}
+
+/* Checks what came out of the decoder while packet @current was sent */
+static void
+pull_decoded (FecTest * t, guint current)
+{
+  GstBuffer *buffer;
+
+  while ((buffer = gst_harness_try_pull (t->dec))) {
+    GstRTPBuffer rtp = GST_RTP_BUFFER_INIT;
+    guint index;
+
+    fail_unless (gst_rtp_buffer_map (buffer, GST_MAP_READ, &rtp));
+    index = (guint16) (gst_rtp_buffer_get_seq (&rtp) - BASE_SEQ);
+    gst_rtp_buffer_unmap (&rtp);
+
+    fail_unless (index <= current);
+    fail_unless_equals_int (t->received[index], 0);
+    t->received[index]++;
+
+    /* Recovered packets are identical to the ones that were sent */
+    fail_unless_equals_int (gst_buffer_get_size (buffer),
+        gst_buffer_get_size (t->packets[index]));
+    fail_unless (gst_buffer_memcmp (buffer, 0, t->packets[index],
+            gst_buffer_get_size (buffer)) == 0);
+
+    if (t->lost[index]) {
+      t->n_recovered++;
+      t->max_latency = MAX (t->max_latency, current - index);
+    }
+
+    gst_buffer_unref (buffer);
+  }
+}
+
+/* Sends all the packets through the encoder and the decoder, dropping the
+ * media packets for which @media_loss returns TRUE, and the FEC packets for
+ * which @fec_loss returns TRUE, if set. */
+static void
+fec_test_run (FecTest * t, LossFunc media_loss, LossFunc fec_loss,
+    gpointer user_data)
+{
+  guint fec_index = 0;
+  guint i, j, k;
+
+  for (i = 0; i < t->n_packets; i++) {
+    GstBuffer *buffer;
+
+    t->packets[i] = create_packet (i);
+    fail_unless_equals_int (gst_harness_push (t->enc,
+            gst_buffer_ref (t->packets[i])), GST_FLOW_OK);
+
+    buffer = gst_harness_pull (t->enc);
+    if (media_loss (i, user_data)) {
+      gst_buffer_unref (buffer);
+      t->lost[i] = TRUE;
+      t->n_lost++;
+    } else {
+      fail_unless_equals_int (gst_harness_push (t->dec, buffer), GST_FLOW_OK);
+    }
+
+    /* The FEC packets follow the last packet they protect */
+    for (j = 0; j < N_FEC_STREAMS; j++) {
+      while ((buffer = gst_harness_try_pull (t->enc_fec[j]))) {
+        for (k = 0; k < t->n_links; k++) {
+          if (fec_loss && fec_loss (fec_index++, user_data))
+            continue;
+          fail_unless_equals_int (gst_harness_push (t->dec_fec[k][j],
+                  gst_buffer_ref (buffer)), GST_FLOW_OK);
+        }
+        gst_buffer_unref (buffer);
+      }
+    }
+
+    pull_decoded (t, i);
+  }
+}
+
+static guint
+fec_test_count_received (FecTest * t)
+{
+  guint i, n = 0;
+
+  for (i = 0; i < t->n_packets; i++)
+    n += t->received[i];
+
+  return n;
+}
+
+static guint64
+fec_test_get_recovered (FecTest * t)
+{
+  guint64 recovered;
+
+  g_object_get (t->dec->element, "recovered", &recovered, NULL);
+  return recovered;
+}
+
+static gboolean
+no_loss (guint index, gpointer user_data)
+{
+  return FALSE;
+}
+
+/* Loses the packet at the given column of every row */
+static gboolean
+one_per_row_loss (guint index, gpointer user_data)
+{
+  return index % 5 == GPOINTER_TO_UINT (user_data);
+}
+
+/* Loses a whole row of every 5x5 matrix */
+static gboolean
+burst_loss (guint index, gpointer user_data)
+{
+  return index % 25 >= 10 && index % 25 < 15;
+}
+
+static gboolean
+random_loss (guint index, gpointer user_data)
+{
+  return g_rand_double (user_data) < 0.01;
+}
+
+GST_START_TEST (test_no_fec)
+{
+  FecTest t;
+
+  /* With no columns, the encoder is disabled */
+  fec_test_setup (&t, 0, 5, TRUE, 1, 50);
+  fec_test_run (&t, no_loss, NULL, NULL);
+
+  fail_unless_equals_int (gst_harness_buffers_received (t.enc_fec[0]), 0);
+  fail_unless_equals_int (gst_harness_buffers_received (t.enc_fec[1]), 0);
+  fail_unless_equals_int (fec_test_count_received (&t), 50);
+  fail_unless_equals_int (t.n_recovered, 0);
+
+  fec_test_teardown (&t);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_fec_packets)
+{
+  FecTest t;
+  GstBuffer *buffer;
+  GstMapInfo map;
+  guint i;
+
+  fec_test_setup (&t, 5, 4, TRUE, 1, 40);
+  fec_test_run (&t, no_loss, NULL, NULL);
+
+  /* One column FEC packet per column and one row FEC packet per row of each
+   * matrix */
+  fail_unless_equals_int (gst_harness_buffers_received (t.enc_fec[0]), 10);
+  fail_unless_equals_int (gst_harness_buffers_received (t.enc_fec[1]), 8);
+  fail_unless_equals_int (fec_test_count_received (&t), 40);
+  fail_unless_equals_int (t.n_recovered, 0);
+
+  /* Check the header of the row FEC packet of the next row */
+  for (i = 40; i < 45; i++)
+    gst_harness_push (t.enc, create_packet (i));
+  buffer = gst_harness_pull (t.enc_fec[1]);
+  gst_buffer_map (buffer, &map, GST_MAP_READ);
+  fail_unless_equals_int (map.data[1] & 0x7f, 96);
+  fail_unless_equals_int (GST_READ_UINT16_BE (map.data + 12),
+      (guint16) (BASE_SEQ + 40));
+  fail_unless_equals_int (map.data[12 + 12], 0x40);
+  fail_unless_equals_int (map.data[12 + 13], 1);
+  fail_unless_equals_int (map.data[12 + 14], 5);
+  gst_buffer_unmap (buffer, &map);
+  gst_buffer_unref (buffer);
+
+  fec_test_teardown (&t);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_row_recovery)
+{
+  FecTest t;
+  guint column;
+
+  for (column = 0; column < 5; column++) {
+    fec_test_setup (&t, 5, 0, TRUE, 1, 200);
+    fec_test_run (&t, one_per_row_loss, NULL, GUINT_TO_POINTER (column));
+
+    fail_unless_equals_int (gst_harness_buffers_received (t.enc_fec[0]), 0);
+    fail_unless_equals_int (t.n_lost, 40);
+    fail_unless_equals_int (t.n_recovered, 40);
+    fail_unless_equals_int (fec_test_get_recovered (&t), 40);
+    fail_unless_equals_int (fec_test_count_received (&t), 200);
+    /* Recovered as soon as the row is complete */
+    fail_unless (t.max_latency <= 5 - 1 - column);
+
+    fec_test_teardown (&t);
+  }
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_column_burst_recovery)
+{
+  FecTest t;
+
+  fec_test_setup (&t, 5, 5, FALSE, 1, 500);
+  fec_test_run (&t, burst_loss, NULL, NULL);
+
+  fail_unless_equals_int (gst_harness_buffers_received (t.enc_fec[1]), 0);
+  fail_unless_equals_int (t.n_lost, 100);
+  fail_unless_equals_int (t.n_recovered, 100);
+  fail_unless_equals_int (fec_test_count_received (&t), 500);
+  /* Recovered with the last row of the matrix */
+  fail_unless (t.max_latency <= 5 * 5);
+
+  fec_test_teardown (&t);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_duplicate_fec)
+{
+  FecTest t;
+
+  /* The same FEC packets come through two links, each loss must only be
+   * recovered once */
+  fec_test_setup (&t, 5, 5, TRUE, 2, 250);
+  fec_test_run (&t, one_per_row_loss, NULL, GUINT_TO_POINTER (2));
+
+  fail_unless_equals_int (t.n_lost, 50);
+  fail_unless_equals_int (t.n_recovered, 50);
+  fail_unless_equals_int (fec_test_get_recovered (&t), 50);
+  fail_unless_equals_int (fec_test_count_received (&t), 250);
+
+  fec_test_teardown (&t);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_random_loss)
+{
+  FecTest t;
+  GRand *rand = g_rand_new_with_seed (42);
+  gdouble ratio;
+
+  /* 1% of the media and FEC packets are lost */
+  fec_test_setup (&t, 5, 5, TRUE, 1, 10000);
+  fec_test_run (&t, random_loss, random_loss, rand);
+
+  fail_unless (t.n_lost > 0);
+  ratio = (gdouble) t.n_recovered / t.n_lost;
+  GST_INFO ("Recovered %u of %u lost packets (%.1f%%), latency at most %u "
+      "packets", t.n_recovered, t.n_lost, ratio * 100, t.max_latency);
+
+  fail_unless (ratio >= 0.9);
+  fail_unless_equals_int (fec_test_get_recovered (&t), t.n_recovered);
+  fail_unless_equals_int (fec_test_count_received (&t),
+      t.n_packets - t.n_lost + t.n_recovered);
+  fail_unless (t.max_latency <= 5 * 5 + 5);
+
+  fec_test_teardown (&t);
+  g_rand_free (rand);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_reordered_after_recovery)
+{
+  FecTest t;
+  GstBuffer *late = NULL, *buffer;
+  guint i;
+
+  /* Packet 2 is delayed behind the row FEC packet of its row */
+  fec_test_setup (&t, 5, 0, TRUE, 1, 5);
+  for (i = 0; i < 5; i++) {
+    t.packets[i] = create_packet (i);
+    gst_harness_push (t.enc, gst_buffer_ref (t.packets[i]));
+    buffer = gst_harness_pull (t.enc);
+    if (i == 2) {
+      late = buffer;
+      t.lost[i] = TRUE;
+      t.n_lost++;
+    } else {
+      fail_unless_equals_int (gst_harness_push (t.dec, buffer), GST_FLOW_OK);
+    }
+  }
+
+  buffer = gst_harness_pull (t.enc_fec[1]);
+  fail_unless_equals_int (gst_harness_push (t.dec_fec[0][1], buffer),
+      GST_FLOW_OK);
+  pull_decoded (&t, 4);
+  fail_unless_equals_int (t.n_recovered, 1);
+
+  /* The original is dropped, pull_decoded() fails on duplicates */
+  fail_unless_equals_int (gst_harness_push (t.dec, late), GST_FLOW_OK);
+  pull_decoded (&t, 4);
+  fail_unless_equals_int (gst_harness_buffers_received (t.dec), 5);
+  fail_unless_equals_int (fec_test_count_received (&t), 5);
+
+  fec_test_teardown (&t);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_rows_clamped)
+{
+  GstElement *enc = gst_element_factory_make ("ristfecenc", NULL);
+  guint rows;
+
+  /* SMPTE 2022-1 has no matrices of 1 to 3 rows */
+  g_object_set (enc, "rows", 2, NULL);
+  g_object_get (enc, "rows", &rows, NULL);
+  fail_unless_equals_int (rows, 4);
+
+  g_object_set (enc, "rows", 0, NULL);
+  g_object_get (enc, "rows", &rows, NULL);
+  fail_unless_equals_int (rows, 0);
+
+  gst_object_unref (enc);
+}
+
+GST_END_TEST;
+
+static Suite *
+ristfec_suite (void)
+{
+  Suite *s = suite_create ("ristfec");
+  TCase *tc_chain = tcase_create ("general");
+
+  suite_add_tcase (s, tc_chain);
+  tcase_add_test (tc_chain, test_no_fec);
+  tcase_add_test (tc_chain, test_fec_packets);
+  tcase_add_test (tc_chain, test_row_recovery);
+  tcase_add_test (tc_chain, test_column_burst_recovery);
+  tcase_add_test (tc_chain, test_duplicate_fec);
+  tcase_add_test (tc_chain, test_random_loss);
+  tcase_add_test (tc_chain, test_reordered_after_recovery);
+  tcase_add_test (tc_chain, test_rows_clamped);
+
+  return s;
+}
+
+GST_CHECK_MAIN (ristfec);
@@ -0,0 +1,292 @@
+/* GStreamer
+ * unit test for the RIST roundrobin dispatcher
+ *
+ * Copyright (C) 2026 agent <agent@local>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include <gst/check/gstcheck.h>
+#include <gst/check/gstharness.h>
+
+#define N_LINKS 3
+
+typedef struct
+{
+  GstHarness *h;
+  GstHarness *links[N_LINKS];
+} Dispatcher;
+
+static void
+dispatcher_setup (Dispatcher * d, const gchar * mode)
+{
+  guint i;
+
+  d->h = gst_harness_new_with_padnames ("roundrobin", "sink", NULL);
+  if (mode)
+    gst_util_set_object_arg (G_OBJECT (d->h->element), "mode", mode);
+
+  for (i = 0; i < N_LINKS; i++) {
+    gchar name[16];
+
+    g_snprintf (name, sizeof (name), "src_%u", i);
+    d->links[i] = gst_harness_new_with_element (d->h->element, NULL, name);
+  }
+
+  gst_harness_set_src_caps_str (d->h, "application/x-rtp");
+}
+
+static void
+dispatcher_teardown (Dispatcher * d)
+{
+  guint i;
+
+  for (i = 0; i < N_LINKS; i++)
+    if (d->links[i])
+      gst_harness_teardown (d->links[i]);
+  gst_harness_teardown (d->h);
+}
+
+static void
+set_weight (Dispatcher * d, guint link, gdouble weight)
+{
+  gchar name[16];
+  GstPad *pad;
+
+  g_snprintf (name, sizeof (name), "src_%u", link);
+  pad = gst_element_get_static_pad (d->h->element, name);
+  fail_unless (pad != NULL);
+  g_object_set (pad, "weight", weight, NULL);
+  gst_object_unref (pad);
+}
+
+static void
+push_buffers (Dispatcher * d, guint n)
+{
+  guint i;
+
+  for (i = 0; i < n; i++)
+    fail_unless_equals_int (gst_harness_push (d->h,
+            gst_buffer_new_allocate (NULL, 16, NULL)), GST_FLOW_OK);
+}
+
+/* Returns the number of buffers sent to @link and drops them */
+static guint
+pull_all (Dispatcher * d, guint link)
+{
+  guint n = 0;
+  GstBuffer *buffer;
+
+  while ((buffer = gst_harness_try_pull (d->links[link]))) {
+    gst_buffer_unref (buffer);
+    n++;
+  }
+
+  return n;
+}
+
+GST_START_TEST (test_equal_weights)
+{
+  Dispatcher d;
+  guint i, j;
+
+  dispatcher_setup (&d, NULL);
+
+  /* Every link gets one buffer in turn */
+  for (i = 0; i < 4; i++) {
+    guint n_sent = 0;
+
+    push_buffers (&d, N_LINKS);
+    for (j = 0; j < N_LINKS; j++) {
+      guint n = pull_all (&d, j);
+
+      fail_unless_equals_int (n, 1);
+      n_sent += n;
+    }
+    fail_unless_equals_int (n_sent, N_LINKS);
+  }
+
+  dispatcher_teardown (&d);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_weighted)
+{
+  Dispatcher d;
+
+  dispatcher_setup (&d, NULL);
+  set_weight (&d, 0, 4.0);
+  set_weight (&d, 1, 1.0);
+  set_weight (&d, 2, 2.0);
+
+  push_buffers (&d, 700);
+  fail_unless_equals_int (pull_all (&d, 0), 400);
+  fail_unless_equals_int (pull_all (&d, 1), 100);
+  fail_unless_equals_int (pull_all (&d, 2), 200);
+
+  /* The shares are interleaved, not sent in bursts */
+  push_buffers (&d, 7);
+  fail_unless_equals_int (pull_all (&d, 0), 4);
+  fail_unless_equals_int (pull_all (&d, 1), 1);
+  fail_unless_equals_int (pull_all (&d, 2), 2);
+
+  dispatcher_teardown (&d);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_disabled_link)
+{
+  Dispatcher d;
+
+  dispatcher_setup (&d, NULL);
+  set_weight (&d, 1, 0.0);
+
+  push_buffers (&d, 10);
+  fail_unless_equals_int (pull_all (&d, 0), 5);
+  fail_unless_equals_int (pull_all (&d, 1), 0);
+  fail_unless_equals_int (pull_all (&d, 2), 5);
+
+  /* Enabling it again takes effect right away */
+  set_weight (&d, 1, 1.0);
+  push_buffers (&d, 9);
+  fail_unless_equals_int (pull_all (&d, 0), 3);
+  fail_unless_equals_int (pull_all (&d, 1), 3);
+  fail_unless_equals_int (pull_all (&d, 2), 3);
+
+  /* Without any usable link, buffers are dropped */
+  set_weight (&d, 0, 0.0);
+  set_weight (&d, 1, 0.0);
+  set_weight (&d, 2, 0.0);
+  push_buffers (&d, 3);
+  fail_unless_equals_int (pull_all (&d, 0), 0);
+  fail_unless_equals_int (pull_all (&d, 1), 0);
+  fail_unless_equals_int (pull_all (&d, 2), 0);
+
+  dispatcher_teardown (&d);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_broadcast)
+{
+  Dispatcher d;
+
+  dispatcher_setup (&d, "broadcast");
+  set_weight (&d, 2, 0.0);
+
+  push_buffers (&d, 5);
+  fail_unless_equals_int (pull_all (&d, 0), 5);
+  fail_unless_equals_int (pull_all (&d, 1), 5);
+  fail_unless_equals_int (pull_all (&d, 2), 0);
+
+  dispatcher_teardown (&d);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_release_pad)
+{
+  Dispatcher d;
+  GstPad *pad;
+
+  dispatcher_setup (&d, NULL);
+
+  /* Tearing down the harness releases the request pad */
+  gst_harness_teardown (d.links[1]);
+  d.links[1] = NULL;
+  pad = gst_element_get_static_pad (d.h->element, "src_1");
+  fail_unless (pad == NULL);
+
+  push_buffers (&d, 10);
+  fail_unless_equals_int (pull_all (&d, 0), 5);
+  fail_unless_equals_int (pull_all (&d, 2), 5);
+
+  dispatcher_teardown (&d);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_unchanged_weight)
+{
+  Dispatcher d;
+
+  dispatcher_setup (&d, NULL);
+
+  push_buffers (&d, 1);
+  fail_unless_equals_int (pull_all (&d, 0), 1);
+
+  /* Setting the same weight again does not start the schedule over */
+  set_weight (&d, 0, 1.0);
+  push_buffers (&d, 2);
+  fail_unless_equals_int (pull_all (&d, 0), 0);
+  fail_unless_equals_int (pull_all (&d, 1), 1);
+  fail_unless_equals_int (pull_all (&d, 2), 1);
+
+  dispatcher_teardown (&d);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_pad_names)
+{
+  GstElement *element = gst_element_factory_make ("roundrobin", NULL);
+  GstPad *named, *pad1, *pad2;
+
+  /* Automatic names never take the one of a pad requested by name */
+  named = gst_element_request_pad_simple (element, "src_1");
+  fail_unless (named != NULL);
+  pad1 = gst_element_request_pad_simple (element, "src_%d");
+  pad2 = gst_element_request_pad_simple (element, "src_%d");
+  fail_unless (pad1 != NULL);
+  fail_unless (pad2 != NULL);
+  fail_unless_equals_string (GST_PAD_NAME (pad1), "src_2");
+  fail_unless_equals_string (GST_PAD_NAME (pad2), "src_3");
+
+  /* and a name cannot be requested twice */
+  fail_unless (gst_element_request_pad_simple (element, "src_2") == NULL);
+
+  gst_element_release_request_pad (element, named);
+  gst_element_release_request_pad (element, pad1);
+  gst_element_release_request_pad (element, pad2);
+  gst_object_unref (named);
+  gst_object_unref (pad1);
+  gst_object_unref (pad2);
+  gst_object_unref (element);
+}
+
+GST_END_TEST;
+
+static Suite *
+roundrobin_suite (void)
+{
+  Suite *s = suite_create ("roundrobin");
+  TCase *tc_chain = tcase_create ("general");
+
+  suite_add_tcase (s, tc_chain);
+  tcase_add_test (tc_chain, test_equal_weights);
+  tcase_add_test (tc_chain, test_weighted);
+  tcase_add_test (tc_chain, test_disabled_link);
+  tcase_add_test (tc_chain, test_broadcast);
+  tcase_add_test (tc_chain, test_release_pad);
+  tcase_add_test (tc_chain, test_unchanged_weight);
+  tcase_add_test (tc_chain, test_pad_names);
+
+  return s;
+}
+
+GST_CHECK_MAIN (roundrobin);
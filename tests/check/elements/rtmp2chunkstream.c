@@ -0,0 +1,212 @@
+/* GStreamer
+ *
+ * Copyright (C) 2026 agent <agent@local>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include <gst/check/gstcheck.h>
+
+#include "../../gst/rtmp2/rtmp/rtmpchunkstream.h"
+#include "../../gst/rtmp2/rtmp/rtmpmessage.h"
+
+/* Builds a message of @size bytes, with its payload split into memories of
+ * the given sizes, the last one taking the rest. Empty memories are kept. */
+static GstBuffer *
+create_message (guint32 cstream, gsize size, GstClockTime dts,
+    const gsize * splits, guint n_splits)
+{
+  GstBuffer *message = gst_rtmp_message_new (GST_RTMP_MESSAGE_TYPE_VIDEO,
+      cstream, 1);
+  gsize offset = 0;
+  guint i;
+
+  for (i = 0; i <= n_splits; i++) {
+    gsize part = i < n_splits ? MIN (splits[i], size - offset) : size - offset;
+    guint8 *data = g_malloc (part);
+    gsize j;
+
+    for (j = 0; j < part; j++)
+      data[j] = (offset + j) * 13 + cstream;
+
+    gst_buffer_append_memory (message,
+        gst_memory_new_wrapped (0, data, part, 0, part, data, g_free));
+    offset += part;
+  }
+
+  GST_BUFFER_DTS (message) = dts;
+
+  return message;
+}
+
+/* The reference serialization, one buffer per chunk */
+static GByteArray *
+serialize_chunks (GstRtmpChunkStream * cstream, GstBuffer * message,
+    guint32 chunk_size, guint * n_chunks)
+{
+  GByteArray *bytes = g_byte_array_new ();
+  GstBuffer *chunk;
+
+  *n_chunks = 0;
+  chunk = gst_rtmp_chunk_stream_serialize_start (cstream, message, chunk_size);
+  while (chunk) {
+    GstMapInfo map;
+
+    fail_unless (gst_buffer_map (chunk, &map, GST_MAP_READ));
+    g_byte_array_append (bytes, map.data, map.size);
+    gst_buffer_unmap (chunk, &map);
+    gst_buffer_unref (chunk);
+    (*n_chunks)++;
+
+    chunk = gst_rtmp_chunk_stream_serialize_next (cstream, chunk_size);
+  }
+
+  return bytes;
+}
+
+static GByteArray *
+serialize_vectors (GstRtmpChunkStream * cstream, GstBuffer * message,
+    guint32 chunk_size)
+{
+  GByteArray *bytes = g_byte_array_new ();
+  GstRtmpChunkVectors *chunks;
+  gsize i;
+
+  chunks = gst_rtmp_chunk_stream_serialize_vectors (cstream, message,
+      chunk_size);
+  fail_unless (chunks != NULL);
+
+  for (i = 0; i < chunks->n_vectors; i++) {
+    /* No empty vectors are written */
+    fail_unless (chunks->vectors[i].size > 0);
+    g_byte_array_append (bytes, chunks->vectors[i].buffer,
+        chunks->vectors[i].size);
+  }
+  fail_unless_equals_int (bytes->len, chunks->size);
+
+  gst_rtmp_chunk_vectors_free (chunks);
+
+  return bytes;
+}
+
+/* Serializes the same sequence of messages both ways, on chunk streams
+ * with the same history, and checks that the bytes are identical */
+static void
+check_messages (guint32 cstream_id, guint32 chunk_size, const gsize * sizes,
+    guint n_messages, const gsize * splits, guint n_splits, GstClockTime dts,
+    GstClockTime dts_step)
+{
+  GstRtmpChunkStreams *ref_cstreams = gst_rtmp_chunk_streams_new ();
+  GstRtmpChunkStreams *vec_cstreams = gst_rtmp_chunk_streams_new ();
+  GstRtmpChunkStream *ref, *vec;
+  guint i;
+
+  ref = gst_rtmp_chunk_streams_get (ref_cstreams, cstream_id);
+  vec = gst_rtmp_chunk_streams_get (vec_cstreams, cstream_id);
+
+  for (i = 0; i < n_messages; i++) {
+    GstBuffer *message = create_message (cstream_id, sizes[i], dts, splits,
+        n_splits);
+    GByteArray *expected, *actual;
+    guint n_chunks;
+
+    expected = serialize_chunks (ref, message, chunk_size, &n_chunks);
+    actual = serialize_vectors (vec, message, chunk_size);
+
+    GST_DEBUG ("Message %u of %" G_GSIZE_FORMAT " bytes in %u chunks of %"
+        G_GUINT32_FORMAT ", %u bytes", i, sizes[i], n_chunks, chunk_size,
+        expected->len);
+
+    fail_unless_equals_int (actual->len, expected->len);
+    fail_unless (memcmp (actual->data, expected->data, expected->len) == 0);
+
+    g_byte_array_unref (expected);
+    g_byte_array_unref (actual);
+    gst_buffer_unref (message);
+    dts += dts_step;
+  }
+
+  gst_rtmp_chunk_streams_free (ref_cstreams);
+  gst_rtmp_chunk_streams_free (vec_cstreams);
+}
+
+static const gsize message_sizes[] = {
+  0, 1, 127, 128, 129, 1000, 1000, 4096, 4097, 70000, 70000, 3, 0,
+};
+
+GST_START_TEST (test_serialize_vectors_single_memory)
+{
+  check_messages (3, 128, message_sizes, G_N_ELEMENTS (message_sizes), NULL,
+      0, 0, 40 * GST_MSECOND);
+  check_messages (3, 4096, message_sizes, G_N_ELEMENTS (message_sizes), NULL,
+      0, 0, 40 * GST_MSECOND);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_serialize_vectors_memories)
+{
+  /* Chunks that start and end inside memories, span several of them, and
+   * memories that end exactly on a chunk boundary */
+  static const gsize splits[] = { 7, 0, 121, 128, 1, 2000, 0, 300, 64 };
+
+  check_messages (3, 128, message_sizes, G_N_ELEMENTS (message_sizes), splits,
+      G_N_ELEMENTS (splits), 0, 40 * GST_MSECOND);
+  check_messages (3, 1000, message_sizes, G_N_ELEMENTS (message_sizes),
+      splits, G_N_ELEMENTS (splits), 0, 40 * GST_MSECOND);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_serialize_vectors_headers)
+{
+  static const gsize splits[] = { 100, 100 };
+  GstClockTime ext_dts = (GstClockTime) 0x1000000 * GST_MSECOND;
+
+  /* Two and three byte basic headers */
+  check_messages (64, 128, message_sizes, G_N_ELEMENTS (message_sizes), splits,
+      G_N_ELEMENTS (splits), 0, 40 * GST_MSECOND);
+  check_messages (400, 128, message_sizes, G_N_ELEMENTS (message_sizes),
+      splits, G_N_ELEMENTS (splits), 0, 40 * GST_MSECOND);
+
+  /* Extended timestamps, repeated in every chunk */
+  check_messages (3, 128, message_sizes, G_N_ELEMENTS (message_sizes), splits,
+      G_N_ELEMENTS (splits), ext_dts, 40 * GST_MSECOND);
+  check_messages (3, 128, message_sizes, G_N_ELEMENTS (message_sizes), splits,
+      G_N_ELEMENTS (splits), 0, ext_dts);
+
+  /* Same timestamp delta, down to type 3 headers */
+  check_messages (3, 128, message_sizes, G_N_ELEMENTS (message_sizes), splits,
+      G_N_ELEMENTS (splits), 0, 0);
+}
+
+GST_END_TEST;
+
+static Suite *
+rtmp2chunkstream_suite (void)
+{
+  Suite *s = suite_create ("rtmp2chunkstream");
+  TCase *tc_chain = tcase_create ("general");
+
+  suite_add_tcase (s, tc_chain);
+  tcase_add_test (tc_chain, test_serialize_vectors_single_memory);
+  tcase_add_test (tc_chain, test_serialize_vectors_memories);
+  tcase_add_test (tc_chain, test_serialize_vectors_headers);
+
+  return s;
+}
+
+GST_CHECK_MAIN (rtmp2chunkstream);
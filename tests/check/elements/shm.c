@@ -20,12 +20,21 @@
  * Boston, MA 02110-1301, USA.
  */
 
+/* For memfd_create() */
+#define _GNU_SOURCE
+
 #ifdef HAVE_CONFIG_H
 #include "config.h"
 #endif
 
 #include <gst/gst.h>
 #include <gst/check/gstcheck.h>
+#include <gst/allocators/allocators.h>
+
+#ifdef HAVE_MEMFD_CREATE
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
 
 
 static GstStaticPadTemplate sink_template = GST_STATIC_PAD_TEMPLATE ("sink",
@@ -169,6 +178,64 @@ GST_START_TEST (test_shm_alloc)
 
 GST_END_TEST;
 
+#ifdef HAVE_MEMFD_CREATE
+GST_START_TEST (test_shm_fd_passing)
+{
+  GstAllocator *alloc;
+  GstBuffer *buf;
+  GstMapInfo map;
+  GstSegment segment;
+  gint fd, i;
+
+  g_object_set (sink, "fd-passing", TRUE, NULL);
+
+  gst_pad_push_event (srcpad, gst_event_new_stream_start ("test"));
+  gst_segment_init (&segment, GST_FORMAT_BYTES);
+  gst_pad_push_event (srcpad, gst_event_new_segment (&segment));
+
+  fd = memfd_create ("shm-unit-test", MFD_CLOEXEC);
+  fail_unless (fd >= 0);
+  fail_unless (ftruncate (fd, 4096) == 0);
+
+  alloc = gst_fd_allocator_new ();
+  buf = gst_buffer_new ();
+  gst_buffer_append_memory (buf, gst_fd_allocator_alloc (alloc, fd, 4096,
+          GST_FD_MEMORY_FLAG_NONE));
+  gst_object_unref (alloc);
+
+  fail_unless (gst_buffer_map (buf, &map, GST_MAP_WRITE));
+  for (i = 0; i < map.size; i++)
+    map.data[i] = i & 0xff;
+  gst_buffer_unmap (buf, &map);
+
+  /* Push a sub-buffer of it twice, the fd only has to be sent once */
+  gst_buffer_resize (buf, 100, 1000);
+  fail_unless (gst_pad_push (srcpad, gst_buffer_ref (buf)) == GST_FLOW_OK);
+  fail_unless (gst_pad_push (srcpad, buf) == GST_FLOW_OK);
+
+  g_mutex_lock (&check_mutex);
+  while (g_list_length (buffers) < 2)
+    g_cond_wait (&check_cond, &check_mutex);
+  g_mutex_unlock (&check_mutex);
+
+  for (i = 0; i < 2; i++) {
+    buf = g_list_nth_data (buffers, i);
+    fail_unless_equals_int (gst_buffer_get_size (buf), 1000);
+    /* The passed fd is handed out and only mapped on demand */
+    fail_unless (gst_is_fd_memory (gst_buffer_peek_memory (buf, 0)));
+    fail_unless (gst_buffer_map (buf, &map, GST_MAP_READ));
+    fail_unless_equals_int (map.data[0], 100);
+    fail_unless_equals_int (map.data[999], (1099 & 0xff));
+    gst_buffer_unmap (buf, &map);
+  }
+
+  gst_check_drop_buffers ();
+  teardown_shm ();
+}
+
+GST_END_TEST;
+#endif
+
 GST_START_TEST (test_shm_live)
 {
   GstElement *producer, *consumer;
@@ -229,6 +296,71 @@ GST_START_TEST (test_shm_live)
 
 GST_END_TEST;
 
+GST_START_TEST (test_shm_ring)
+{
+  GstElement *producer, *consumer;
+  GstElement *src, *sink;
+  gchar *socket_path = NULL;
+  GstStateChangeReturn state_res;
+  GstSample *sample = NULL;
+  guint ring_slots;
+  gint i;
+
+  src = gst_element_factory_make ("fakesrc", NULL);
+  g_object_set (src, "sizetype", 2, "sizemax", 4096, "num-buffers", 20, NULL);
+
+  /* Fewer slots than buffers, so the sink has to wait for the ring */
+  sink = gst_element_factory_make ("shmsink", NULL);
+  g_object_set (sink, "socket-path", "shm-unit-test", "ring-slots", 3, NULL);
+  g_object_get (sink, "ring-slots", &ring_slots, NULL);
+  fail_unless_equals_int (ring_slots, 3);
+
+  producer = gst_pipeline_new ("producer-pipeline");
+  gst_bin_add_many (GST_BIN (producer), src, sink, NULL);
+  fail_unless (gst_element_link (src, sink));
+
+  state_res = gst_element_set_state (producer, GST_STATE_PLAYING);
+  fail_unless (state_res != GST_STATE_CHANGE_FAILURE);
+
+  g_object_get (sink, "socket-path", &socket_path, NULL);
+  fail_unless (socket_path != NULL);
+
+  src = gst_element_factory_make ("shmsrc", NULL);
+  sink = gst_element_factory_make ("appsink", NULL);
+  g_object_set (src, "is-live", TRUE, NULL);
+  g_object_set (sink, "async", FALSE, "enable-last-sample", FALSE, NULL);
+
+  consumer = gst_pipeline_new ("consumer-pipeline");
+  gst_bin_add_many (GST_BIN (consumer), src, sink, NULL);
+  fail_unless (gst_element_link (src, sink));
+
+  g_object_set (src, "socket-path", socket_path, NULL);
+
+  state_res = gst_element_set_state (consumer, GST_STATE_PLAYING);
+  fail_unless (state_res != GST_STATE_CHANGE_FAILURE);
+
+  for (i = 0; i < 20; i++) {
+    g_signal_emit_by_name (sink, "pull-sample", &sample);
+    fail_unless (sample != NULL);
+    fail_unless_equals_int (gst_buffer_get_size (gst_sample_get_buffer
+            (sample)), 4096);
+    gst_sample_unref (sample);
+  }
+
+  state_res = gst_element_set_state (producer, GST_STATE_NULL);
+  fail_unless (state_res != GST_STATE_CHANGE_FAILURE);
+
+  state_res = gst_element_set_state (consumer, GST_STATE_NULL);
+  fail_unless (state_res != GST_STATE_CHANGE_FAILURE);
+
+  gst_object_unref (consumer);
+  gst_object_unref (producer);
+
+  g_free (socket_path);
+}
+
+GST_END_TEST;
+
 static Suite *
 shm_suite (void)
 {
@@ -239,10 +371,14 @@ shm_suite (void)
   tcase_add_checked_fixture (tc, setup_shm, NULL);
   tcase_add_test (tc, test_shm_sysmem_alloc);
   tcase_add_test (tc, test_shm_alloc);
+#ifdef HAVE_MEMFD_CREATE
+  tcase_add_test (tc, test_shm_fd_passing);
+#endif
   suite_add_tcase (s, tc);
 
   tc = tcase_create ("shm2");
   tcase_add_test (tc, test_shm_live);
+  tcase_add_test (tc, test_shm_ring);
   suite_add_tcase (s, tc);
 
   return s;
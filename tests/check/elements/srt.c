@@ -0,0 +1,479 @@
+/* GStreamer
+ *
+ * Copyright (C) 2026 agent <agent@local>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include <gst/check/gstcheck.h>
+#include <gst/check/gstharness.h>
+
+#define TEST_PORT 7361
+#define MESSAGE_SIZE 1316
+#define N_MESSAGES 10
+/* room for 4 messages, see GstSRTSrc:aggregate-size */
+#define MESSAGES_PER_BUFFER 4
+#define AGGREGATE_SIZE (MESSAGES_PER_BUFFER * MESSAGE_SIZE + 1456 - MESSAGE_SIZE)
+
+typedef struct
+{
+  GMutex lock;
+  GCond cond;
+  gboolean caller_added;
+  /* the streaming thread of srtsrc waits while this is set, so that the
+   * messages pile up in the socket */
+  gboolean blocked;
+  gboolean got_first;
+  GList *lists;
+  guint n_messages;
+} BatchData;
+
+static void
+caller_added (GstElement * srtsink, gint unused, GSocketAddress * addr,
+    BatchData * data)
+{
+  g_mutex_lock (&data->lock);
+  data->caller_added = TRUE;
+  g_cond_broadcast (&data->cond);
+  g_mutex_unlock (&data->lock);
+}
+
+static GstPadProbeReturn
+batch_probe (GstPad * pad, GstPadProbeInfo * info, BatchData * data)
+{
+  g_mutex_lock (&data->lock);
+  if (!data->got_first) {
+    data->got_first = TRUE;
+    g_cond_broadcast (&data->cond);
+    while (data->blocked)
+      g_cond_wait (&data->cond, &data->lock);
+  } else if (info->type & GST_PAD_PROBE_TYPE_BUFFER_LIST) {
+    GstBufferList *list = GST_PAD_PROBE_INFO_BUFFER_LIST (info);
+    guint i;
+
+    data->lists = g_list_append (data->lists, gst_buffer_list_ref (list));
+    for (i = 0; i < gst_buffer_list_length (list); i++)
+      data->n_messages +=
+          gst_buffer_get_size (gst_buffer_list_get (list, i)) / MESSAGE_SIZE;
+  } else {
+    data->n_messages +=
+        gst_buffer_get_size (GST_PAD_PROBE_INFO_BUFFER (info)) / MESSAGE_SIZE;
+  }
+  g_cond_broadcast (&data->cond);
+  g_mutex_unlock (&data->lock);
+
+  return GST_PAD_PROBE_OK;
+}
+
+static GstBuffer *
+make_message (guint8 value)
+{
+  GstBuffer *buf = gst_buffer_new_allocate (NULL, MESSAGE_SIZE, NULL);
+
+  gst_buffer_memset (buf, 0, value, MESSAGE_SIZE);
+
+  return buf;
+}
+
+static gboolean
+wait_for (BatchData * data, gboolean * flag)
+{
+  gint64 end_time = g_get_monotonic_time () + 5 * G_TIME_SPAN_SECOND;
+  gboolean ret;
+
+  g_mutex_lock (&data->lock);
+  while (!*flag && g_cond_wait_until (&data->cond, &data->lock, end_time));
+  ret = *flag;
+  g_mutex_unlock (&data->lock);
+
+  return ret;
+}
+
+GST_START_TEST (test_srtsrc_batch)
+{
+  BatchData data = { {0,}, };
+  GstElement *receiver, *src, *srtsink;
+  GstHarness *h;
+  GstBufferList *list;
+  GstPad *pad;
+  gchar *desc;
+  gint64 end_time;
+  guint i, n;
+
+  g_mutex_init (&data.lock);
+  g_cond_init (&data.cond);
+  data.blocked = TRUE;
+
+  desc = g_strdup_printf ("srtsink uri=srt://:%u", TEST_PORT);
+  h = gst_harness_new_parse (desc);
+  g_free (desc);
+  srtsink = gst_harness_find_element (h, "srtsink");
+  g_signal_connect (srtsink, "caller-added", G_CALLBACK (caller_added), &data);
+  gst_object_unref (srtsink);
+
+  desc = g_strdup_printf ("srtsrc name=src uri=srt://127.0.0.1:%u "
+      "batch-size=64 aggregate-size=%u ! fakesink sync=false", TEST_PORT,
+      AGGREGATE_SIZE);
+  receiver = gst_parse_launch (desc, NULL);
+  g_free (desc);
+  fail_unless (receiver != NULL);
+
+  src = gst_bin_get_by_name (GST_BIN (receiver), "src");
+  pad = gst_element_get_static_pad (src, "src");
+  gst_pad_add_probe (pad,
+      GST_PAD_PROBE_TYPE_BUFFER | GST_PAD_PROBE_TYPE_BUFFER_LIST,
+      (GstPadProbeCallback) batch_probe, &data, NULL);
+  gst_object_unref (pad);
+  gst_object_unref (src);
+
+  gst_element_set_state (receiver, GST_STATE_PLAYING);
+  fail_unless (wait_for (&data, &data.caller_added));
+
+  /* the first message blocks srtsrc while the batch is sent */
+  fail_unless_equals_int (gst_harness_push (h, make_message (0xff)),
+      GST_FLOW_OK);
+  fail_unless (wait_for (&data, &data.got_first));
+
+  for (i = 0; i < N_MESSAGES; i++)
+    fail_unless_equals_int (gst_harness_push (h, make_message (i)),
+        GST_FLOW_OK);
+
+  /* well past the default 125 ms latency, all the messages of the batch
+   * can be read by then */
+  g_usleep (G_USEC_PER_SEC / 2);
+
+  end_time = g_get_monotonic_time () + 5 * G_TIME_SPAN_SECOND;
+  g_mutex_lock (&data.lock);
+  data.blocked = FALSE;
+  g_cond_broadcast (&data.cond);
+  while (data.n_messages < N_MESSAGES &&
+      g_cond_wait_until (&data.cond, &data.lock, end_time));
+  g_mutex_unlock (&data.lock);
+
+  gst_element_set_state (receiver, GST_STATE_NULL);
+  gst_object_unref (receiver);
+  gst_harness_teardown (h);
+
+  /* the whole batch is pushed at once, packed into buffers of whole
+   * messages */
+  fail_unless_equals_int (data.n_messages, N_MESSAGES);
+  fail_unless_equals_int (g_list_length (data.lists), 1);
+  list = data.lists->data;
+  fail_unless_equals_int (gst_buffer_list_length (list),
+      (N_MESSAGES + MESSAGES_PER_BUFFER - 1) / MESSAGES_PER_BUFFER);
+
+  for (i = 0, n = 0; i < gst_buffer_list_length (list); i++) {
+    GstBuffer *buf = gst_buffer_list_get (list, i);
+    guint expected = MIN (MESSAGES_PER_BUFFER, N_MESSAGES - n);
+    GstMapInfo map;
+    guint j;
+
+    fail_unless_equals_int (gst_buffer_get_size (buf), expected * MESSAGE_SIZE);
+    fail_unless (gst_buffer_map (buf, &map, GST_MAP_READ));
+    for (j = 0; j < map.size; j++)
+      fail_unless_equals_int (map.data[j], n + j / MESSAGE_SIZE);
+    gst_buffer_unmap (buf, &map);
+    n += expected;
+  }
+
+  g_list_free_full (data.lists, (GDestroyNotify) gst_buffer_list_unref);
+  g_mutex_clear (&data.lock);
+  g_cond_clear (&data.cond);
+}
+
+GST_END_TEST;
+
+#define N_FAN_OUT_MESSAGES 300
+#define FAN_OUT_QUEUE_SIZE 8
+
+typedef struct
+{
+  GMutex lock;
+  GCond cond;
+  guint n_callers;
+  GSocketAddress *slow_addr;
+  gboolean slow_removed;
+  /* the slow receiver stops reading after its first message, until this is
+   * cleared */
+  gboolean slow_blocked;
+  guint n_fast;
+  gboolean fast_in_order;
+} FanOutData;
+
+static gboolean
+is_slow_caller (FanOutData * data, GSocketAddress * addr)
+{
+  return data->slow_addr &&
+      g_inet_socket_address_get_port (G_INET_SOCKET_ADDRESS (addr)) ==
+      g_inet_socket_address_get_port (G_INET_SOCKET_ADDRESS (data->slow_addr));
+}
+
+static void
+fan_out_caller_added (GstElement * srtsink, gint unused, GSocketAddress * addr,
+    FanOutData * data)
+{
+  g_mutex_lock (&data->lock);
+  /* the slow receiver is connected first */
+  if (data->n_callers == 0)
+    data->slow_addr = g_object_ref (addr);
+  data->n_callers++;
+  g_cond_broadcast (&data->cond);
+  g_mutex_unlock (&data->lock);
+}
+
+static void
+fan_out_caller_removed (GstElement * srtsink, gint unused,
+    GSocketAddress * addr, FanOutData * data)
+{
+  g_mutex_lock (&data->lock);
+  if (is_slow_caller (data, addr))
+    data->slow_removed = TRUE;
+  g_cond_broadcast (&data->cond);
+  g_mutex_unlock (&data->lock);
+}
+
+static void
+fan_out_check_buffer (FanOutData * data, GstBuffer * buf)
+{
+  gsize offset;
+
+  for (offset = 0; offset < gst_buffer_get_size (buf); offset += MESSAGE_SIZE) {
+    guint8 value;
+
+    gst_buffer_extract (buf, offset, &value, 1);
+    if (value != (data->n_fast & 0xff))
+      data->fast_in_order = FALSE;
+    data->n_fast++;
+  }
+}
+
+static GstPadProbeReturn
+fast_probe (GstPad * pad, GstPadProbeInfo * info, FanOutData * data)
+{
+  g_mutex_lock (&data->lock);
+  if (info->type & GST_PAD_PROBE_TYPE_BUFFER_LIST) {
+    GstBufferList *list = GST_PAD_PROBE_INFO_BUFFER_LIST (info);
+    guint i;
+
+    for (i = 0; i < gst_buffer_list_length (list); i++)
+      fan_out_check_buffer (data, gst_buffer_list_get (list, i));
+  } else {
+    fan_out_check_buffer (data, GST_PAD_PROBE_INFO_BUFFER (info));
+  }
+  g_cond_broadcast (&data->cond);
+  g_mutex_unlock (&data->lock);
+
+  return GST_PAD_PROBE_OK;
+}
+
+static GstPadProbeReturn
+slow_probe (GstPad * pad, GstPadProbeInfo * info, FanOutData * data)
+{
+  g_mutex_lock (&data->lock);
+  while (data->slow_blocked)
+    g_cond_wait (&data->cond, &data->lock);
+  g_mutex_unlock (&data->lock);
+
+  return GST_PAD_PROBE_OK;
+}
+
+static gboolean
+fan_out_wait (FanOutData * data, guint * value, guint target)
+{
+  gint64 end_time = g_get_monotonic_time () + 5 * G_TIME_SPAN_SECOND;
+  gboolean ret;
+
+  g_mutex_lock (&data->lock);
+  while (*value < target &&
+      g_cond_wait_until (&data->cond, &data->lock, end_time));
+  ret = *value >= target;
+  g_mutex_unlock (&data->lock);
+
+  return ret;
+}
+
+static GstElement *
+start_receiver (const gchar * options, GstPadProbeCallback probe,
+    FanOutData * data)
+{
+  GstElement *receiver, *src;
+  GstPad *pad;
+  gchar *desc;
+
+  desc = g_strdup_printf ("srtsrc name=src uri=\"srt://127.0.0.1:%u%s\" ! "
+      "fakesink sync=false", TEST_PORT, options);
+  receiver = gst_parse_launch (desc, NULL);
+  g_free (desc);
+  fail_unless (receiver != NULL);
+
+  src = gst_bin_get_by_name (GST_BIN (receiver), "src");
+  pad = gst_element_get_static_pad (src, "src");
+  gst_pad_add_probe (pad,
+      GST_PAD_PROBE_TYPE_BUFFER | GST_PAD_PROBE_TYPE_BUFFER_LIST, probe, data,
+      NULL);
+  gst_object_unref (pad);
+  gst_object_unref (src);
+
+  gst_element_set_state (receiver, GST_STATE_PLAYING);
+
+  return receiver;
+}
+
+/* Sends to a fast receiver and to one that stops reading after the first
+ * message. Too-late packet drop is disabled and the socket buffers are
+ * small, so that the messages pile up in the srtsink queue of the slow
+ * caller after a few dozens. Returns the srtsink stats of the slow caller
+ * if it is still connected. */
+static GstStructure *
+check_fan_out (const gchar * drop_policy, FanOutData * data)
+{
+  GstElement *slow, *fast, *srtsink;
+  GstStructure *stats, *slow_stats = NULL;
+  const GValue *callers;
+  GValueArray *array;
+  GstHarness *h;
+  gchar *desc;
+  guint i;
+
+  g_mutex_init (&data->lock);
+  g_cond_init (&data->cond);
+  data->slow_blocked = TRUE;
+  data->fast_in_order = TRUE;
+
+  desc = g_strdup_printf ("srtsink uri=\"srt://:%u?tlpktdrop=false"
+      "&sndbuf=65536\" caller-queue-size=%u caller-drop-policy=%s", TEST_PORT,
+      FAN_OUT_QUEUE_SIZE, drop_policy);
+  h = gst_harness_new_parse (desc);
+  g_free (desc);
+  srtsink = gst_harness_find_element (h, "srtsink");
+  g_signal_connect (srtsink, "caller-added",
+      G_CALLBACK (fan_out_caller_added), data);
+  g_signal_connect (srtsink, "caller-removed",
+      G_CALLBACK (fan_out_caller_removed), data);
+
+  slow = start_receiver ("?fc=32&rcvbuf=47104&tlpktdrop=false",
+      (GstPadProbeCallback) slow_probe, data);
+  fail_unless (fan_out_wait (data, &data->n_callers, 1));
+  fast = start_receiver ("", (GstPadProbeCallback) fast_probe, data);
+  fail_unless (fan_out_wait (data, &data->n_callers, 2));
+
+  /* slow enough for the fast caller to keep up */
+  for (i = 0; i < N_FAN_OUT_MESSAGES; i++) {
+    fail_unless_equals_int (gst_harness_push (h, make_message (i & 0xff)),
+        GST_FLOW_OK);
+    g_usleep (G_USEC_PER_SEC / 500);
+  }
+
+  /* the fast caller gets every message, whatever happens to the slow one */
+  fail_unless (fan_out_wait (data, &data->n_fast, N_FAN_OUT_MESSAGES));
+  fail_unless (data->fast_in_order);
+
+  g_object_get (srtsink, "stats", &stats, NULL);
+  callers = gst_structure_get_value (stats, "callers");
+  fail_unless (callers != NULL);
+
+  G_GNUC_BEGIN_IGNORE_DEPRECATIONS;
+  array = g_value_get_boxed (callers);
+  for (i = 0; i < array->n_values; i++) {
+    const GstStructure *s =
+        gst_value_get_structure (g_value_array_get_nth (array, i));
+    const GValue *addr = gst_structure_get_value (s, "caller-address");
+    guint64 dropped;
+
+    fail_unless (gst_structure_get_uint64 (s, "buffers-dropped", &dropped));
+    if (is_slow_caller (data, g_value_get_object (addr))) {
+      slow_stats = gst_structure_copy (s);
+    } else {
+      fail_unless_equals_uint64 (dropped, 0);
+    }
+  }
+  G_GNUC_END_IGNORE_DEPRECATIONS;
+  gst_structure_free (stats);
+  gst_object_unref (srtsink);
+
+  g_mutex_lock (&data->lock);
+  data->slow_blocked = FALSE;
+  g_cond_broadcast (&data->cond);
+  g_mutex_unlock (&data->lock);
+
+  gst_element_set_state (slow, GST_STATE_NULL);
+  gst_object_unref (slow);
+  gst_element_set_state (fast, GST_STATE_NULL);
+  gst_object_unref (fast);
+  gst_harness_teardown (h);
+
+  g_clear_object (&data->slow_addr);
+  g_mutex_clear (&data->lock);
+  g_cond_clear (&data->cond);
+
+  return slow_stats;
+}
+
+GST_START_TEST (test_srtsink_slow_caller_drop_oldest)
+{
+  FanOutData data = { {0,}, };
+  GstStructure *stats;
+  guint64 dropped;
+  guint depth;
+
+  stats = check_fan_out ("drop-oldest", &data);
+
+  fail_if (data.slow_removed);
+  fail_unless (stats != NULL);
+  fail_unless (gst_structure_get_uint64 (stats, "buffers-dropped", &dropped));
+  fail_unless (gst_structure_get_uint (stats, "queue-depth", &depth));
+  gst_structure_free (stats);
+
+  /* the socket buffers of the slow caller cannot take more than ~80
+   * messages, the others are either queued or dropped */
+  fail_unless (dropped > 0);
+  fail_unless (dropped < N_FAN_OUT_MESSAGES);
+  /* the queue stays bounded, with one more for the message that may be
+   * partially sent */
+  fail_unless (depth <= FAN_OUT_QUEUE_SIZE + 1);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_srtsink_slow_caller_disconnect)
+{
+  FanOutData data = { {0,}, };
+  GstStructure *stats;
+
+  stats = check_fan_out ("disconnect", &data);
+
+  /* the slow caller is gone from the stats once removed */
+  fail_unless (data.slow_removed);
+  fail_unless (stats == NULL);
+}
+
+GST_END_TEST;
+
+static Suite *
+srt_suite (void)
+{
+  Suite *s = suite_create ("srt");
+  TCase *tc_chain = tcase_create ("general");
+
+  suite_add_tcase (s, tc_chain);
+  tcase_add_test (tc_chain, test_srtsrc_batch);
+  tcase_add_test (tc_chain, test_srtsink_slow_caller_drop_oldest);
+  tcase_add_test (tc_chain, test_srtsink_slow_caller_disconnect);
+
+  return s;
+}
+
+GST_CHECK_MAIN (srt);
@@ -0,0 +1,392 @@
+/* GStreamer unit tests for the adaptive demux bitrate adaptation
+ *
+ * Copyright (C) 2026 agent <agent@local>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include <gst/check/gstcheck.h>
+#include <gst/adaptivedemux/gstadaptivedemuxabr.h>
+
+#define BANDWIDTH_USAGE 0.8
+
+/* Parameters of the simulated session */
+#define FRAGMENT_DURATION (2 * GST_SECOND)
+#define CHUNK_SIZE (16 * 1024)
+#define REQUEST_LATENCY (100 * GST_MSECOND)
+#define MAX_BUFFER (30 * GST_SECOND)
+#define MAX_FRAGMENTS 100
+
+static const guint64 ladder[] = { 400000, 1000000, 2500000, 5000000, 8000000 };
+
+#define N_LADDER G_N_ELEMENTS (ladder)
+#define TOP_BITRATE ladder[N_LADDER - 1]
+
+/* The bandwidth is @bandwidth from @start until the start of the next point */
+typedef struct
+{
+  GstClockTime start;
+  guint64 bandwidth;
+} TracePoint;
+
+typedef struct
+{
+  guint64 bitrates[MAX_FRAGMENTS];
+  guint n_fragments;
+  GstClockTime stall_time;
+  guint n_switches;
+} SimResult;
+
+static guint64
+trace_get_bandwidth (const TracePoint * trace, guint n_points,
+    GstClockTime now)
+{
+  guint i;
+
+  for (i = 1; i < n_points; i++) {
+    if (now < trace[i].start)
+      break;
+  }
+
+  return trace[i - 1].bandwidth;
+}
+
+/* The estimates are computed with floating point */
+#define assert_rate(rate, expected) \
+  fail_unless (ABS ((gint64) (rate) - (gint64) (expected)) <= (expected) / 1000)
+
+static guint64
+sim_result_get_average_bitrate (SimResult * res, guint first)
+{
+  guint64 total = 0;
+  guint i;
+
+  for (i = first; i < res->n_fragments; i++)
+    total += res->bitrates[i];
+
+  return total / (res->n_fragments - first);
+}
+
+/* Plays @n_fragments fragments on a link following @trace. Time is virtual
+ * so that results don't depend on the machine running the test. Downloads
+ * are made of CHUNK_SIZE buffers after REQUEST_LATENCY, playback drains
+ * the buffer in real time from the end of the first download and the next
+ * download only starts once the buffer is below MAX_BUFFER, like with
+ * the queues downstream of the demuxer. */
+static void
+simulate (GstAdaptiveDemuxAbrPolicy policy, const TracePoint * trace,
+    guint n_points, guint n_fragments, SimResult * res)
+{
+  GstAdaptiveDemuxAbr *abr = gst_adaptive_demux_abr_new (policy);
+  GstClockTime now = 0, buffer = 0;
+  guint i;
+
+  fail_unless (n_fragments <= MAX_FRAGMENTS);
+  memset (res, 0, sizeof (SimResult));
+
+  for (i = 0; i < n_fragments; i++) {
+    GstClockTime start = now;
+    guint64 bitrate, size, received = 0;
+
+    if (i == 0)
+      bitrate = ladder[0];
+    else
+      bitrate = gst_adaptive_demux_abr_select_bitrate (abr, ladder, N_LADDER,
+          buffer, BANDWIDTH_USAGE);
+    res->bitrates[i] = bitrate;
+    if (i > 0 && bitrate != res->bitrates[i - 1])
+      res->n_switches++;
+
+    size = gst_util_uint64_scale (bitrate, FRAGMENT_DURATION, 8 * GST_SECOND);
+
+    gst_adaptive_demux_abr_download_started (abr, now);
+    now += REQUEST_LATENCY;
+    while (received < size) {
+      guint64 chunk = MIN (CHUNK_SIZE, size - received);
+
+      now += gst_util_uint64_scale (chunk, 8 * GST_SECOND,
+          trace_get_bandwidth (trace, n_points, now));
+      received += chunk;
+      gst_adaptive_demux_abr_data_received (abr, chunk, now);
+    }
+    gst_adaptive_demux_abr_download_finished (abr, now);
+
+    if (i > 0) {
+      if (now - start > buffer) {
+        res->stall_time += now - start - buffer;
+        buffer = 0;
+      } else {
+        buffer -= now - start;
+      }
+    }
+
+    buffer += FRAGMENT_DURATION;
+    if (buffer > MAX_BUFFER) {
+      now += buffer - MAX_BUFFER;
+      buffer = MAX_BUFFER;
+    }
+  }
+
+  res->n_fragments = n_fragments;
+  gst_adaptive_demux_abr_free (abr);
+}
+
+GST_START_TEST (test_throughput_estimate)
+{
+  GstAdaptiveDemuxAbr *abr;
+  guint64 throughput;
+  guint i;
+
+  abr = gst_adaptive_demux_abr_new (GST_ADAPTIVE_DEMUX_ABR_POLICY_THROUGHPUT);
+  fail_unless_equals_uint64 (gst_adaptive_demux_abr_get_throughput (abr), 0);
+
+  /* Empty samples are ignored */
+  gst_adaptive_demux_abr_add_sample (abr, 1000, 0);
+  fail_unless_equals_uint64 (gst_adaptive_demux_abr_get_throughput (abr), 0);
+
+  /* Constant 8 Mbps, the estimate is not biased by its initial value */
+  for (i = 0; i < 4; i++) {
+    gst_adaptive_demux_abr_add_sample (abr, 1000000, GST_SECOND);
+    throughput = gst_adaptive_demux_abr_get_throughput (abr);
+    assert_rate (throughput, 8000000);
+  }
+
+  /* A drop to 1 Mbps is followed within a few seconds */
+  gst_adaptive_demux_abr_add_sample (abr, 125000, GST_SECOND);
+  throughput = gst_adaptive_demux_abr_get_throughput (abr);
+  fail_unless (throughput < 7000000);
+  for (i = 0; i < 9; i++)
+    gst_adaptive_demux_abr_add_sample (abr, 125000, GST_SECOND);
+  throughput = gst_adaptive_demux_abr_get_throughput (abr);
+  fail_unless (throughput < 2000000);
+
+  gst_adaptive_demux_abr_reset (abr);
+  fail_unless_equals_uint64 (gst_adaptive_demux_abr_get_throughput (abr), 0);
+
+  gst_adaptive_demux_abr_free (abr);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_chunk_samples)
+{
+  GstAdaptiveDemuxAbr *abr;
+  GstClockTime now = 0;
+  guint i;
+
+  abr = gst_adaptive_demux_abr_new (GST_ADAPTIVE_DEMUX_ABR_POLICY_THROUGHPUT);
+
+  /* 10 Mbps transfer after 1 second of latency. Measuring the whole
+   * download would give 5.5 Mbps */
+  gst_adaptive_demux_abr_download_started (abr, now);
+  now += GST_SECOND;
+  gst_adaptive_demux_abr_data_received (abr, 125000, now);
+  for (i = 0; i < 10; i++) {
+    now += 100 * GST_MSECOND;
+    gst_adaptive_demux_abr_data_received (abr, 125000, now);
+  }
+  gst_adaptive_demux_abr_download_finished (abr, now);
+  assert_rate (gst_adaptive_demux_abr_get_throughput (abr), 10000000);
+
+  /* Downloads too short for a chunk sample are measured as a whole */
+  gst_adaptive_demux_abr_reset (abr);
+  gst_adaptive_demux_abr_download_started (abr, 0);
+  gst_adaptive_demux_abr_data_received (abr, 250000, 500 * GST_MSECOND);
+  gst_adaptive_demux_abr_download_finished (abr, 500 * GST_MSECOND);
+  assert_rate (gst_adaptive_demux_abr_get_throughput (abr), 4000000);
+
+  gst_adaptive_demux_abr_free (abr);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_select_without_bitrates)
+{
+  GstAdaptiveDemuxAbr *abr;
+
+  abr = gst_adaptive_demux_abr_new (GST_ADAPTIVE_DEMUX_ABR_POLICY_HYBRID);
+  gst_adaptive_demux_abr_add_sample (abr, 1000000, GST_SECOND);
+
+  assert_rate (gst_adaptive_demux_abr_select_bitrate (abr, NULL, 0,
+          10 * GST_SECOND, BANDWIDTH_USAGE), 6400000);
+
+  gst_adaptive_demux_abr_free (abr);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_bola_buffer_level)
+{
+  GstAdaptiveDemuxAbr *abr;
+  GstClockTime level;
+  guint64 bitrate, prev_bitrate = 0;
+
+  abr = gst_adaptive_demux_abr_new (GST_ADAPTIVE_DEMUX_ABR_POLICY_BOLA);
+  /* 3 Mbps */
+  gst_adaptive_demux_abr_add_sample (abr, 375000, GST_SECOND);
+
+  /* Only the buffer level matters */
+  fail_unless_equals_uint64 (gst_adaptive_demux_abr_select_bitrate (abr,
+          ladder, N_LADDER, 0, BANDWIDTH_USAGE), ladder[0]);
+  fail_unless_equals_uint64 (gst_adaptive_demux_abr_select_bitrate (abr,
+          ladder, N_LADDER, MAX_BUFFER, BANDWIDTH_USAGE), TOP_BITRATE);
+
+  for (level = 0; level <= MAX_BUFFER; level += GST_SECOND) {
+    bitrate = gst_adaptive_demux_abr_select_bitrate (abr, ladder, N_LADDER,
+        level, BANDWIDTH_USAGE);
+    fail_unless (bitrate >= prev_bitrate);
+    prev_bitrate = bitrate;
+  }
+
+  /* Without buffer level, the throughput is used */
+  fail_unless_equals_uint64 (gst_adaptive_demux_abr_select_bitrate (abr,
+          ladder, N_LADDER, GST_CLOCK_TIME_NONE, BANDWIDTH_USAGE), ladder[1]);
+
+  gst_adaptive_demux_abr_free (abr);
+}
+
+GST_END_TEST;
+
+/* Link much faster than the highest bitrate */
+GST_START_TEST (test_sim_fast_link)
+{
+  static const TracePoint trace[] = { {0, 100000000} };
+  GstAdaptiveDemuxAbrPolicy policies[] = {
+    GST_ADAPTIVE_DEMUX_ABR_POLICY_THROUGHPUT,
+    GST_ADAPTIVE_DEMUX_ABR_POLICY_HYBRID,
+  };
+  SimResult res;
+  guint i, j;
+
+  for (i = 0; i < G_N_ELEMENTS (policies); i++) {
+    simulate (policies[i], trace, G_N_ELEMENTS (trace), 30, &res);
+
+    for (j = 2; j < res.n_fragments; j++)
+      fail_unless_equals_uint64 (res.bitrates[j], TOP_BITRATE);
+    fail_unless_equals_uint64 (res.stall_time, 0);
+  }
+}
+
+GST_END_TEST;
+
+/* Link slightly faster than the second highest bitrate. Once enough is
+ * buffered the hybrid policy uses it, without oscillating, while the
+ * throughput policy stays below the bandwidth usage */
+GST_START_TEST (test_sim_buffer_headroom)
+{
+  static const TracePoint trace[] = { {0, 6000000} };
+  SimResult throughput_res, hybrid_res;
+  guint i;
+
+  simulate (GST_ADAPTIVE_DEMUX_ABR_POLICY_THROUGHPUT, trace,
+      G_N_ELEMENTS (trace), 60, &throughput_res);
+  simulate (GST_ADAPTIVE_DEMUX_ABR_POLICY_HYBRID, trace,
+      G_N_ELEMENTS (trace), 60, &hybrid_res);
+
+  for (i = 5; i < throughput_res.n_fragments; i++)
+    fail_unless_equals_uint64 (throughput_res.bitrates[i], ladder[2]);
+  fail_unless_equals_uint64 (throughput_res.stall_time, 0);
+
+  fail_unless (sim_result_get_average_bitrate (&hybrid_res, 5) >
+      sim_result_get_average_bitrate (&throughput_res, 5));
+  for (i = hybrid_res.n_fragments - 20; i < hybrid_res.n_fragments; i++)
+    fail_unless_equals_uint64 (hybrid_res.bitrates[i], ladder[3]);
+  fail_unless_equals_uint64 (hybrid_res.stall_time, 0);
+}
+
+GST_END_TEST;
+
+/* Bandwidth drops between the second and third lowest bitrates */
+GST_START_TEST (test_sim_bandwidth_drop)
+{
+  static const TracePoint trace[] = {
+    {0, 20000000},
+    {60 * GST_SECOND, 1500000},
+  };
+  GstAdaptiveDemuxAbrPolicy policies[] = {
+    GST_ADAPTIVE_DEMUX_ABR_POLICY_THROUGHPUT,
+    GST_ADAPTIVE_DEMUX_ABR_POLICY_HYBRID,
+  };
+  SimResult res;
+  guint i, j;
+
+  for (i = 0; i < G_N_ELEMENTS (policies); i++) {
+    simulate (policies[i], trace, G_N_ELEMENTS (trace), 80, &res);
+
+    /* Settled on the bitrate the link can sustain */
+    for (j = res.n_fragments - 20; j < res.n_fragments; j++)
+      fail_unless_equals_uint64 (res.bitrates[j], ladder[1]);
+    fail_unless (res.n_switches <= 3);
+    fail_unless_equals_uint64 (res.stall_time, 0);
+  }
+
+  /* Plain BOLA oscillates around the bandwidth but never runs out of
+   * buffer */
+  simulate (GST_ADAPTIVE_DEMUX_ABR_POLICY_BOLA, trace, G_N_ELEMENTS (trace),
+      80, &res);
+  fail_unless_equals_uint64 (res.stall_time, 0);
+}
+
+GST_END_TEST;
+
+/* Same input, same decisions */
+GST_START_TEST (test_sim_deterministic)
+{
+  static const TracePoint trace[] = {
+    {0, 3000000},
+    {20 * GST_SECOND, 12000000},
+    {50 * GST_SECOND, 2000000},
+    {70 * GST_SECOND, 9000000},
+  };
+  SimResult res1, res2;
+
+  simulate (GST_ADAPTIVE_DEMUX_ABR_POLICY_HYBRID, trace,
+      G_N_ELEMENTS (trace), 60, &res1);
+  simulate (GST_ADAPTIVE_DEMUX_ABR_POLICY_HYBRID, trace,
+      G_N_ELEMENTS (trace), 60, &res2);
+
+  fail_unless (memcmp (&res1, &res2, sizeof (SimResult)) == 0);
+  fail_unless (res1.n_switches > 0);
+}
+
+GST_END_TEST;
+
+static Suite *
+adaptivedemux_abr_suite (void)
+{
+  Suite *s = suite_create ("adaptivedemuxabr");
+  TCase *tc_estimate = tcase_create ("estimate");
+  TCase *tc_select = tcase_create ("select");
+  TCase *tc_sim = tcase_create ("simulation");
+
+  tcase_add_test (tc_estimate, test_throughput_estimate);
+  tcase_add_test (tc_estimate, test_chunk_samples);
+  suite_add_tcase (s, tc_estimate);
+
+  tcase_add_test (tc_select, test_select_without_bitrates);
+  tcase_add_test (tc_select, test_bola_buffer_level);
+  suite_add_tcase (s, tc_select);
+
+  tcase_add_test (tc_sim, test_sim_fast_link);
+  tcase_add_test (tc_sim, test_sim_buffer_headroom);
+  tcase_add_test (tc_sim, test_sim_bandwidth_drop);
+  tcase_add_test (tc_sim, test_sim_deterministic);
+  suite_add_tcase (s, tc_sim);
+
+  return s;
+}
+
+GST_CHECK_MAIN (adaptivedemux_abr);
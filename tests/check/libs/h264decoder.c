@@ -0,0 +1,572 @@
+/* GStreamer
+ *
+ * Copyright (C) 2026 agent <agent@local>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include <gst/check/gstcheck.h>
+#include <gst/check/gstharness.h>
+#include <gst/base/gstbitwriter.h>
+#include <gst/codecs/gsth264decoder.h>
+
+/* An IDR picture followed by P pictures, each followed by a non-reference
+ * B picture displayed before it. In decoding order, the POCs are
+ * 0 4 2 8 6 12 10 16 14 */
+#define N_PICTURES 9
+#define NO_POC G_MININT32
+
+typedef enum
+{
+  EVENT_END,
+  EVENT_WAIT,
+  EVENT_OUTPUT,
+} EventType;
+
+/* What the subclass was called for, in call order */
+typedef struct
+{
+  EventType type;
+  gint32 poc;
+} Event;
+
+typedef struct
+{
+  GstH264Decoder parent;
+
+  GArray *events;
+  gint max_dpb_size;
+  gint32 fail_poc;
+} GstH264TestDecoder;
+
+typedef struct
+{
+  GstH264DecoderClass parent_class;
+} GstH264TestDecoderClass;
+
+/* Same without wait_picture(), for reference */
+typedef GstH264TestDecoder GstH264TestSyncDecoder;
+typedef GstH264TestDecoderClass GstH264TestSyncDecoderClass;
+
+static GstStaticPadTemplate sink_template = GST_STATIC_PAD_TEMPLATE ("sink",
+    GST_PAD_SINK, GST_PAD_ALWAYS,
+    GST_STATIC_CAPS ("video/x-h264, stream-format=byte-stream, alignment=au"));
+
+static GstStaticPadTemplate src_template = GST_STATIC_PAD_TEMPLATE ("src",
+    GST_PAD_SRC, GST_PAD_ALWAYS,
+    GST_STATIC_CAPS ("video/x-raw, format=NV12"));
+
+GType gst_h264_test_decoder_get_type (void);
+G_DEFINE_TYPE (GstH264TestDecoder, gst_h264_test_decoder,
+    GST_TYPE_H264_DECODER);
+
+GType gst_h264_test_sync_decoder_get_type (void);
+G_DEFINE_TYPE (GstH264TestSyncDecoder, gst_h264_test_sync_decoder,
+    gst_h264_test_decoder_get_type ());
+
+static void
+add_event (GstH264Decoder * decoder, EventType type, GstH264Picture * picture)
+{
+  GstH264TestDecoder *self = (GstH264TestDecoder *) decoder;
+  Event event;
+
+  event.type = type;
+  event.poc = picture->pic_order_cnt;
+  g_array_append_val (self->events, event);
+}
+
+static gboolean
+gst_h264_test_decoder_new_sequence (GstH264Decoder * decoder,
+    const GstH264SPS * sps, gint max_dpb_size)
+{
+  GstH264TestDecoder *self = (GstH264TestDecoder *) decoder;
+  GstVideoCodecState *state;
+
+  self->max_dpb_size = max_dpb_size;
+
+  state = gst_video_decoder_set_output_state (GST_VIDEO_DECODER (decoder),
+      GST_VIDEO_FORMAT_NV12, sps->width, sps->height, decoder->input_state);
+  gst_video_codec_state_unref (state);
+
+  return gst_video_decoder_negotiate (GST_VIDEO_DECODER (decoder));
+}
+
+static gboolean
+gst_h264_test_decoder_decode_slice (GstH264Decoder * decoder,
+    GstH264Picture * picture, GstH264Slice * slice, GArray * ref_pic_list0,
+    GArray * ref_pic_list1)
+{
+  return TRUE;
+}
+
+static gboolean
+gst_h264_test_decoder_end_picture (GstH264Decoder * decoder,
+    GstH264Picture * picture)
+{
+  add_event (decoder, EVENT_END, picture);
+
+  return TRUE;
+}
+
+static GstFlowReturn
+gst_h264_test_decoder_wait_picture (GstH264Decoder * decoder,
+    GstH264Picture * picture)
+{
+  GstH264TestDecoder *self = (GstH264TestDecoder *) decoder;
+
+  add_event (decoder, EVENT_WAIT, picture);
+
+  if (picture->pic_order_cnt == self->fail_poc)
+    return GST_FLOW_ERROR;
+
+  return GST_FLOW_OK;
+}
+
+static GstFlowReturn
+gst_h264_test_decoder_output_picture (GstH264Decoder * decoder,
+    GstVideoCodecFrame * frame, GstH264Picture * picture)
+{
+  add_event (decoder, EVENT_OUTPUT, picture);
+
+  frame->output_buffer = gst_buffer_new ();
+  gst_h264_picture_unref (picture);
+
+  return gst_video_decoder_finish_frame (GST_VIDEO_DECODER (decoder), frame);
+}
+
+static void
+gst_h264_test_decoder_finalize (GObject * object)
+{
+  GstH264TestDecoder *self = (GstH264TestDecoder *) object;
+
+  g_array_unref (self->events);
+
+  G_OBJECT_CLASS (gst_h264_test_decoder_parent_class)->finalize (object);
+}
+
+static void
+gst_h264_test_decoder_class_init (GstH264TestDecoderClass * klass)
+{
+  GObjectClass *gobject_class = G_OBJECT_CLASS (klass);
+  GstElementClass *element_class = GST_ELEMENT_CLASS (klass);
+  GstH264DecoderClass *h264decoder_class = GST_H264_DECODER_CLASS (klass);
+
+  gobject_class->finalize = gst_h264_test_decoder_finalize;
+
+  gst_element_class_add_static_pad_template (element_class, &sink_template);
+  gst_element_class_add_static_pad_template (element_class, &src_template);
+  gst_element_class_set_static_metadata (element_class,
+      "H.264 test decoder", "Codec/Decoder/Video", "H.264 test decoder",
+      "GStreamer");
+
+  h264decoder_class->new_sequence = gst_h264_test_decoder_new_sequence;
+  h264decoder_class->decode_slice = gst_h264_test_decoder_decode_slice;
+  h264decoder_class->end_picture = gst_h264_test_decoder_end_picture;
+  h264decoder_class->wait_picture = gst_h264_test_decoder_wait_picture;
+  h264decoder_class->output_picture = gst_h264_test_decoder_output_picture;
+}
+
+static void
+gst_h264_test_decoder_init (GstH264TestDecoder * self)
+{
+  self->events = g_array_new (FALSE, FALSE, sizeof (Event));
+  self->fail_poc = NO_POC;
+}
+
+static void
+gst_h264_test_sync_decoder_class_init (GstH264TestSyncDecoderClass * klass)
+{
+  GstH264DecoderClass *h264decoder_class = GST_H264_DECODER_CLASS (klass);
+
+  h264decoder_class->wait_picture = NULL;
+}
+
+static void
+gst_h264_test_sync_decoder_init (GstH264TestSyncDecoder * self)
+{
+}
+
+static void
+put_ue (GstBitWriter * bw, guint32 value)
+{
+  guint len = g_bit_storage (value + 1);
+
+  /* len - 1 leading zero bits, then value + 1 on len bits */
+  gst_bit_writer_put_bits_uint32 (bw, value + 1, 2 * len - 1);
+}
+
+/* Appends the rbsp written in @bw as a NAL unit, with emulation prevention
+ * bytes, and resets @bw */
+static void
+append_nal (GByteArray * au, guint8 header, GstBitWriter * bw)
+{
+  static const guint8 start_code[] = { 0x00, 0x00, 0x00, 0x01 };
+  static const guint8 epb = 0x03;
+  const guint8 *data;
+  guint size, zeros = 0, i;
+
+  gst_bit_writer_put_bits_uint8 (bw, 1, 1);     /* rbsp_stop_one_bit */
+  gst_bit_writer_align_bytes (bw, 0);
+
+  g_byte_array_append (au, start_code, sizeof (start_code));
+  g_byte_array_append (au, &header, 1);
+
+  data = GST_BIT_WRITER_DATA (bw);
+  size = GST_BIT_WRITER_BIT_SIZE (bw) / 8;
+  for (i = 0; i < size; i++) {
+    if (zeros == 2 && data[i] <= 0x03) {
+      g_byte_array_append (au, &epb, 1);
+      zeros = 0;
+    }
+    g_byte_array_append (au, &data[i], 1);
+    zeros = data[i] ? 0 : zeros + 1;
+  }
+
+  gst_bit_writer_reset (bw);
+}
+
+/* Main profile 32x32, with a VUI allowing one picture of reordering */
+static void
+append_parameter_sets (GByteArray * au)
+{
+  GstBitWriter bw;
+
+  gst_bit_writer_init (&bw);
+  gst_bit_writer_put_bits_uint8 (&bw, 77, 8);   /* profile_idc */
+  gst_bit_writer_put_bits_uint8 (&bw, 0, 8);    /* constraint_set flags */
+  gst_bit_writer_put_bits_uint8 (&bw, 30, 8);   /* level_idc */
+  put_ue (&bw, 0);              /* seq_parameter_set_id */
+  put_ue (&bw, 0);              /* log2_max_frame_num_minus4 */
+  put_ue (&bw, 0);              /* pic_order_cnt_type */
+  put_ue (&bw, 2);              /* log2_max_pic_order_cnt_lsb_minus4 */
+  put_ue (&bw, 2);              /* max_num_ref_frames */
+  gst_bit_writer_put_bits_uint8 (&bw, 0, 1);    /* gaps_in_frame_num_value_allowed_flag */
+  put_ue (&bw, 1);              /* pic_width_in_mbs_minus1 */
+  put_ue (&bw, 1);              /* pic_height_in_map_units_minus1 */
+  gst_bit_writer_put_bits_uint8 (&bw, 1, 1);    /* frame_mbs_only_flag */
+  gst_bit_writer_put_bits_uint8 (&bw, 1, 1);    /* direct_8x8_inference_flag */
+  gst_bit_writer_put_bits_uint8 (&bw, 0, 1);    /* frame_cropping_flag */
+  gst_bit_writer_put_bits_uint8 (&bw, 1, 1);    /* vui_parameters_present_flag */
+  /* aspect ratio, overscan, video signal type, chroma location, timing,
+   * nal/vcl hrd and pic_struct not present */
+  gst_bit_writer_put_bits_uint8 (&bw, 0, 8);
+  gst_bit_writer_put_bits_uint8 (&bw, 1, 1);    /* bitstream_restriction_flag */
+  gst_bit_writer_put_bits_uint8 (&bw, 1, 1);    /* motion_vectors_over_pic_boundaries_flag */
+  put_ue (&bw, 0);              /* max_bytes_per_pic_denom */
+  put_ue (&bw, 0);              /* max_bits_per_mb_denom */
+  put_ue (&bw, 16);             /* log2_max_mv_length_horizontal */
+  put_ue (&bw, 16);             /* log2_max_mv_length_vertical */
+  put_ue (&bw, 1);              /* max_num_reorder_frames */
+  put_ue (&bw, 2);              /* max_dec_frame_buffering */
+  append_nal (au, 0x67, &bw);
+
+  gst_bit_writer_init (&bw);
+  put_ue (&bw, 0);              /* pic_parameter_set_id */
+  put_ue (&bw, 0);              /* seq_parameter_set_id */
+  gst_bit_writer_put_bits_uint8 (&bw, 0, 1);    /* entropy_coding_mode_flag */
+  gst_bit_writer_put_bits_uint8 (&bw, 0, 1);    /* bottom_field_pic_order_in_frame_present_flag */
+  put_ue (&bw, 0);              /* num_slice_groups_minus1 */
+  put_ue (&bw, 0);              /* num_ref_idx_l0_default_active_minus1 */
+  put_ue (&bw, 0);              /* num_ref_idx_l1_default_active_minus1 */
+  gst_bit_writer_put_bits_uint8 (&bw, 0, 1);    /* weighted_pred_flag */
+  gst_bit_writer_put_bits_uint8 (&bw, 0, 2);    /* weighted_bipred_idc */
+  put_ue (&bw, 0);              /* pic_init_qp_minus26 */
+  put_ue (&bw, 0);              /* pic_init_qs_minus26 */
+  put_ue (&bw, 0);              /* chroma_qp_index_offset */
+  gst_bit_writer_put_bits_uint8 (&bw, 0, 1);    /* deblocking_filter_control_present_flag */
+  gst_bit_writer_put_bits_uint8 (&bw, 0, 1);    /* constrained_intra_pred_flag */
+  gst_bit_writer_put_bits_uint8 (&bw, 0, 1);    /* redundant_pic_cnt_present_flag */
+  append_nal (au, 0x68, &bw);
+}
+
+/* The access unit of the picture @index in decoding order */
+static GstBuffer *
+create_au (guint index)
+{
+  GByteArray *au = g_byte_array_new ();
+  guint k = (index + 1) / 2, frame_num, slice_type;
+  gboolean idr = index == 0, ref = index % 2 == 1 || idr;
+  GstBitWriter bw;
+  GstBuffer *buf;
+  gint32 poc;
+  guint8 header;
+  gsize size;
+
+  if (idr) {
+    append_parameter_sets (au);
+    header = 0x65;
+    slice_type = 7;
+    frame_num = 0;
+    poc = 0;
+  } else if (ref) {
+    header = 0x41;
+    slice_type = 5;
+    frame_num = k;
+    poc = 4 * k;
+  } else {
+    header = 0x01;
+    slice_type = 6;
+    frame_num = k + 1;
+    poc = 4 * k - 2;
+  }
+
+  gst_bit_writer_init (&bw);
+  put_ue (&bw, 0);              /* first_mb_in_slice */
+  put_ue (&bw, slice_type);
+  put_ue (&bw, 0);              /* pic_parameter_set_id */
+  gst_bit_writer_put_bits_uint8 (&bw, frame_num % 16, 4);
+  if (idr)
+    put_ue (&bw, 0);            /* idr_pic_id */
+  gst_bit_writer_put_bits_uint8 (&bw, poc % 64, 6);     /* pic_order_cnt_lsb */
+  if (slice_type == 6)
+    gst_bit_writer_put_bits_uint8 (&bw, 1, 1);  /* direct_spatial_mv_pred_flag */
+  if (!idr) {
+    gst_bit_writer_put_bits_uint8 (&bw, 0, 1);  /* num_ref_idx_active_override_flag */
+    gst_bit_writer_put_bits_uint8 (&bw, 0, 1);  /* ref_pic_list_modification_flag_l0 */
+  }
+  if (slice_type == 6)
+    gst_bit_writer_put_bits_uint8 (&bw, 0, 1);  /* ref_pic_list_modification_flag_l1 */
+  if (idr) {
+    gst_bit_writer_put_bits_uint8 (&bw, 0, 1);  /* no_output_of_prior_pics_flag */
+    gst_bit_writer_put_bits_uint8 (&bw, 0, 1);  /* long_term_reference_flag */
+  } else if (ref) {
+    gst_bit_writer_put_bits_uint8 (&bw, 0, 1);  /* adaptive_ref_pic_marking_mode_flag */
+  }
+  put_ue (&bw, 0);              /* slice_qp_delta */
+  /* Some slice data, the subclass doesn't look at it */
+  gst_bit_writer_put_bits_uint8 (&bw, 0xa5, 8);
+  append_nal (au, header, &bw);
+
+  size = au->len;
+  buf = gst_buffer_new_wrapped (g_byte_array_free (au, FALSE), size);
+  GST_BUFFER_PTS (buf) = poc / 2 * 40 * GST_MSECOND;
+  GST_BUFFER_DURATION (buf) = 40 * GST_MSECOND;
+
+  return buf;
+}
+
+static GstPadProbeReturn
+latency_probe (GstPad * pad, GstPadProbeInfo * info, gpointer live)
+{
+  GstQuery *query = GST_PAD_PROBE_INFO_QUERY (info);
+
+  if (GST_QUERY_TYPE (query) != GST_QUERY_LATENCY)
+    return GST_PAD_PROBE_OK;
+
+  gst_query_set_latency (query, GPOINTER_TO_INT (live), 0,
+      GST_CLOCK_TIME_NONE);
+
+  return GST_PAD_PROBE_HANDLED;
+}
+
+typedef struct
+{
+  GArray *events;
+  gint max_dpb_size;
+  GstFlowReturn ret[N_PICTURES];
+  /* Pictures output after each access unit was pushed */
+  guint n_output[N_PICTURES];
+  /* And after EOS */
+  guint n_output_total;
+} DecodeResult;
+
+static void
+decode_stream (GType type, gboolean live, gint32 fail_poc,
+    DecodeResult * result)
+{
+  GstH264TestDecoder *dec;
+  GstHarness *h;
+  guint i;
+
+  dec = g_object_new (type, NULL);
+  dec->fail_poc = fail_poc;
+
+  h = gst_harness_new_with_element (GST_ELEMENT (dec), "sink", "src");
+  /* The decoder asks upstream whether it's live when it gets the caps */
+  gst_pad_add_probe (h->srcpad, GST_PAD_PROBE_TYPE_QUERY_UPSTREAM,
+      latency_probe, GINT_TO_POINTER (live), NULL);
+  gst_harness_set_src_caps_str (h,
+      "video/x-h264, stream-format=byte-stream, alignment=au");
+
+  for (i = 0; i < N_PICTURES; i++) {
+    result->ret[i] = gst_harness_push (h, create_au (i));
+    result->n_output[i] = gst_harness_buffers_received (h);
+  }
+  fail_unless (gst_harness_push_event (h, gst_event_new_eos ()));
+  result->n_output_total = gst_harness_buffers_received (h);
+
+  result->events = g_array_ref (dec->events);
+  result->max_dpb_size = dec->max_dpb_size;
+
+  gst_harness_teardown (h);
+}
+
+/* Checks that each picture was waited for right before being output, in
+ * output order, and returns how many were */
+static guint
+check_waits (GArray * events, gint32 fail_poc)
+{
+  gint32 last_poc = NO_POC;
+  guint i, n_waits = 0;
+
+  for (i = 0; i < events->len; i++) {
+    Event *event = &g_array_index (events, Event, i);
+    Event *next;
+
+    if (event->type == EVENT_OUTPUT) {
+      /* Never output without waiting first */
+      fail_unless (i > 0);
+      fail_unless_equals_int (g_array_index (events, Event, i - 1).type,
+          EVENT_WAIT);
+      continue;
+    }
+
+    if (event->type != EVENT_WAIT)
+      continue;
+
+    n_waits++;
+    fail_unless (event->poc > last_poc);
+    last_poc = event->poc;
+
+    if (event->poc == fail_poc) {
+      /* The failed picture is dropped */
+      fail_unless (i + 1 == events->len ||
+          g_array_index (events, Event, i + 1).type != EVENT_OUTPUT ||
+          g_array_index (events, Event, i + 1).poc != fail_poc);
+      continue;
+    }
+
+    fail_unless (i + 1 < events->len);
+    next = &g_array_index (events, Event, i + 1);
+    fail_unless_equals_int (next->type, EVENT_OUTPUT);
+    fail_unless_equals_int (next->poc, event->poc);
+  }
+
+  return n_waits;
+}
+
+GST_START_TEST (test_h264_decoder_wait_picture)
+{
+  DecodeResult async, sync;
+  guint i, n_end = 0, n_output = 0;
+
+  decode_stream (gst_h264_test_decoder_get_type (), FALSE, NO_POC, &async);
+  decode_stream (gst_h264_test_sync_decoder_get_type (), FALSE, NO_POC,
+      &sync);
+
+  for (i = 0; i < N_PICTURES; i++)
+    fail_unless_equals_int (async.ret[i], GST_FLOW_OK);
+  fail_unless_equals_int (async.n_output_total, N_PICTURES);
+  fail_unless_equals_int (sync.n_output_total, N_PICTURES);
+
+  /* Once per picture, in output order and right before the output */
+  fail_unless_equals_int (check_waits (async.events, NO_POC), N_PICTURES);
+  for (i = 0; i < async.events->len; i++) {
+    Event *event = &g_array_index (async.events, Event, i);
+
+    if (event->type == EVENT_END)
+      n_end++;
+    else if (event->type == EVENT_OUTPUT)
+      fail_unless_equals_int (event->poc, 2 * n_output++);
+  }
+  fail_unless_equals_int (n_end, N_PICTURES);
+
+  /* Without get_preferred_output_delay(), one more picture is kept in
+   * flight for non-live streams, so each is waited for one access unit
+   * later than it would be output otherwise */
+  fail_unless_equals_int (async.max_dpb_size, sync.max_dpb_size + 1);
+  for (i = 0; i < N_PICTURES; i++)
+    fail_unless_equals_int (async.n_output[i], MAX (sync.n_output[i], 1) - 1);
+  fail_unless (sync.n_output[N_PICTURES - 1] > 0);
+
+  g_array_unref (async.events);
+  g_array_unref (sync.events);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_h264_decoder_wait_picture_error)
+{
+  DecodeResult result;
+  guint i, n_errors = 0;
+
+  decode_stream (gst_h264_test_decoder_get_type (), FALSE, 6, &result);
+
+  /* The access unit during which the failed picture was to be output gets
+   * the error, the others are decoded as usual */
+  for (i = 0; i < N_PICTURES; i++) {
+    if (result.ret[i] == GST_FLOW_ERROR)
+      n_errors++;
+    else
+      fail_unless_equals_int (result.ret[i], GST_FLOW_OK);
+  }
+  fail_unless_equals_int (n_errors, 1);
+
+  /* Only that frame is dropped */
+  fail_unless_equals_int (check_waits (result.events, 6), N_PICTURES);
+  fail_unless_equals_int (result.n_output_total, N_PICTURES - 1);
+  for (i = 0; i < result.events->len; i++) {
+    Event *event = &g_array_index (result.events, Event, i);
+
+    if (event->type == EVENT_OUTPUT)
+      fail_if (event->poc == 6);
+  }
+
+  g_array_unref (result.events);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_h264_decoder_wait_picture_live)
+{
+  DecodeResult async, sync;
+  guint i;
+
+  decode_stream (gst_h264_test_decoder_get_type (), TRUE, NO_POC, &async);
+  decode_stream (gst_h264_test_sync_decoder_get_type (), TRUE, NO_POC, &sync);
+
+  fail_unless_equals_int (check_waits (async.events, NO_POC), N_PICTURES);
+
+  /* No added delay for live streams */
+  fail_unless_equals_int (async.max_dpb_size, sync.max_dpb_size);
+  for (i = 0; i < N_PICTURES; i++) {
+    fail_unless_equals_int (async.ret[i], GST_FLOW_OK);
+    fail_unless_equals_int (async.n_output[i], sync.n_output[i]);
+  }
+  fail_unless_equals_int (async.n_output_total, N_PICTURES);
+
+  g_array_unref (async.events);
+  g_array_unref (sync.events);
+}
+
+GST_END_TEST;
+
+static Suite *
+h264decoder_suite (void)
+{
+  Suite *s = suite_create ("H264 Decoder library");
+
+  TCase *tc_chain = tcase_create ("general");
+
+  suite_add_tcase (s, tc_chain);
+  tcase_add_test (tc_chain, test_h264_decoder_wait_picture);
+  tcase_add_test (tc_chain, test_h264_decoder_wait_picture_error);
+  tcase_add_test (tc_chain, test_h264_decoder_wait_picture_live);
+
+  return s;
+}
+
+GST_CHECK_MAIN (h264decoder);
@@ -0,0 +1,308 @@
+/* GStreamer
+ *
+ * Copyright (C) 2026 agent <agent@local>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include <gst/check/gstcheck.h>
+#include <gst/check/gstharness.h>
+#include <gst/codecs/gsth265decoder.h>
+
+/* multi-sliced data, generated on zynqultrascaleplus with:
+ * gst-launch-1.0 videotestsrc num-buffers=1 pattern=green \
+ *    ! video/x-raw,width=128,height=128 \
+ *    ! omxh265enc num-slices=2 \
+ *    ! fakesink dump=1
+ */
+static const guint8 h265_128x128_sliced_vps[] = {
+  0x00, 0x00, 0x00, 0x01, 0x40, 0x01, 0x0c, 0x01,
+  0xff, 0xff, 0x01, 0x40, 0x00, 0x00, 0x03, 0x00,
+  0x90, 0x00, 0x00, 0x03, 0x00, 0x00, 0x03, 0x00,
+  0x1e, 0x25, 0x02, 0x40
+};
+
+static const guint8 h265_128x128_sliced_sps[] = {
+  0x00, 0x00, 0x00, 0x01, 0x42, 0x01, 0x01, 0x01,
+  0x40, 0x00, 0x00, 0x03, 0x00, 0x90, 0x00, 0x00,
+  0x03, 0x00, 0x00, 0x03, 0x00, 0x1e, 0xa0, 0x10,
+  0x20, 0x20, 0x59, 0xe9, 0x6e, 0x44, 0xa1, 0x73,
+  0x50, 0x60, 0x20, 0x2e, 0x10, 0x00, 0x00, 0x03,
+  0x00, 0x10, 0x00, 0x00, 0x03, 0x01, 0xe5, 0x1a,
+  0xff, 0xff, 0x10, 0x3e, 0x80, 0x5d, 0xf7, 0xc2,
+  0x01, 0x04
+};
+
+static const guint8 h265_128x128_sliced_pps[] = {
+  0x00, 0x00, 0x00, 0x01, 0x44, 0x01, 0xc0, 0x71,
+  0x81, 0x8d, 0xb2
+};
+
+static const guint8 h265_128x128_slice_1_idr_n_lp[] = {
+  0x00, 0x00, 0x00, 0x01, 0x28, 0x01, 0xac, 0x46,
+  0x13, 0xb6, 0x45, 0x43, 0xaf, 0xee, 0x3d, 0x3f,
+  0x76, 0xe5, 0x73, 0x2f, 0xee, 0xd2, 0xeb, 0xbf,
+  0x80
+};
+
+static const guint8 h265_128x128_slice_2_idr_n_lp[] = {
+  0x00, 0x00, 0x00, 0x01, 0x28, 0x01, 0x30, 0xc4,
+  0x60, 0x13, 0xb6, 0x45, 0x43, 0xaf, 0xee, 0x3d,
+  0x3f, 0x76, 0xe5, 0x73, 0x2f, 0xee, 0xd2, 0xeb,
+  0xbf, 0x80
+};
+
+#define N_PICTURES 8
+
+/* What the subclass got in decode_slice(), in call order */
+typedef struct
+{
+  GThread *thread;
+  guint32 segment_address;
+  guint8 type;
+  guint8 first_slice_segment_in_pic_flag;
+  guint nalu_offset;
+  guint nalu_size;
+  gint32 poc;
+} SliceInfo;
+
+typedef struct
+{
+  GstH265Decoder parent;
+
+  GArray *slices;
+  guint n_pictures;
+} GstH265TestDecoder;
+
+typedef struct
+{
+  GstH265DecoderClass parent_class;
+} GstH265TestDecoderClass;
+
+static GstStaticPadTemplate sink_template = GST_STATIC_PAD_TEMPLATE ("sink",
+    GST_PAD_SINK, GST_PAD_ALWAYS,
+    GST_STATIC_CAPS ("video/x-h265, stream-format=byte-stream, alignment=au"));
+
+static GstStaticPadTemplate src_template = GST_STATIC_PAD_TEMPLATE ("src",
+    GST_PAD_SRC, GST_PAD_ALWAYS,
+    GST_STATIC_CAPS ("video/x-raw, format=NV12"));
+
+GType gst_h265_test_decoder_get_type (void);
+G_DEFINE_TYPE (GstH265TestDecoder, gst_h265_test_decoder,
+    GST_TYPE_H265_DECODER);
+
+static gboolean
+gst_h265_test_decoder_new_sequence (GstH265Decoder * decoder,
+    const GstH265SPS * sps, gint max_dpb_size)
+{
+  GstVideoCodecState *state;
+
+  state = gst_video_decoder_set_output_state (GST_VIDEO_DECODER (decoder),
+      GST_VIDEO_FORMAT_NV12, sps->width, sps->height, decoder->input_state);
+  gst_video_codec_state_unref (state);
+
+  return gst_video_decoder_negotiate (GST_VIDEO_DECODER (decoder));
+}
+
+static gboolean
+gst_h265_test_decoder_decode_slice (GstH265Decoder * decoder,
+    GstH265Picture * picture, GstH265Slice * slice, GArray * ref_pic_list0,
+    GArray * ref_pic_list1)
+{
+  GstH265TestDecoder *self = (GstH265TestDecoder *) decoder;
+  SliceInfo info;
+
+  info.thread = g_thread_self ();
+  info.segment_address = slice->header.segment_address;
+  info.type = slice->header.type;
+  info.first_slice_segment_in_pic_flag =
+      slice->header.first_slice_segment_in_pic_flag;
+  info.nalu_offset = slice->nalu.offset;
+  info.nalu_size = slice->nalu.size;
+  info.poc = picture->pic_order_cnt;
+  g_array_append_val (self->slices, info);
+
+  return TRUE;
+}
+
+static gboolean
+gst_h265_test_decoder_end_picture (GstH265Decoder * decoder,
+    GstH265Picture * picture)
+{
+  GstH265TestDecoder *self = (GstH265TestDecoder *) decoder;
+
+  self->n_pictures++;
+
+  return TRUE;
+}
+
+static GstFlowReturn
+gst_h265_test_decoder_output_picture (GstH265Decoder * decoder,
+    GstVideoCodecFrame * frame, GstH265Picture * picture)
+{
+  frame->output_buffer = gst_buffer_new ();
+  gst_h265_picture_unref (picture);
+
+  return gst_video_decoder_finish_frame (GST_VIDEO_DECODER (decoder), frame);
+}
+
+static void
+gst_h265_test_decoder_finalize (GObject * object)
+{
+  GstH265TestDecoder *self = (GstH265TestDecoder *) object;
+
+  g_array_unref (self->slices);
+
+  G_OBJECT_CLASS (gst_h265_test_decoder_parent_class)->finalize (object);
+}
+
+static void
+gst_h265_test_decoder_class_init (GstH265TestDecoderClass * klass)
+{
+  GObjectClass *gobject_class = G_OBJECT_CLASS (klass);
+  GstElementClass *element_class = GST_ELEMENT_CLASS (klass);
+  GstH265DecoderClass *h265decoder_class = GST_H265_DECODER_CLASS (klass);
+
+  gobject_class->finalize = gst_h265_test_decoder_finalize;
+
+  gst_element_class_add_static_pad_template (element_class, &sink_template);
+  gst_element_class_add_static_pad_template (element_class, &src_template);
+  gst_element_class_set_static_metadata (element_class,
+      "H.265 test decoder", "Codec/Decoder/Video", "H.265 test decoder",
+      "GStreamer");
+
+  h265decoder_class->new_sequence = gst_h265_test_decoder_new_sequence;
+  h265decoder_class->decode_slice = gst_h265_test_decoder_decode_slice;
+  h265decoder_class->end_picture = gst_h265_test_decoder_end_picture;
+  h265decoder_class->output_picture = gst_h265_test_decoder_output_picture;
+}
+
+static void
+gst_h265_test_decoder_init (GstH265TestDecoder * self)
+{
+  self->slices = g_array_new (FALSE, FALSE, sizeof (SliceInfo));
+}
+
+static GstBuffer *
+make_sliced_au (guint idx)
+{
+  GstBuffer *buf = gst_buffer_new ();
+
+#define APPEND(data) \
+  gst_buffer_append_memory (buf, gst_memory_new_wrapped ( \
+      GST_MEMORY_FLAG_READONLY, (gpointer) data, sizeof (data), 0, \
+      sizeof (data), NULL, NULL))
+
+  APPEND (h265_128x128_sliced_vps);
+  APPEND (h265_128x128_sliced_sps);
+  APPEND (h265_128x128_sliced_pps);
+  APPEND (h265_128x128_slice_1_idr_n_lp);
+  APPEND (h265_128x128_slice_2_idr_n_lp);
+
+#undef APPEND
+
+  GST_BUFFER_PTS (buf) = idx * 40 * GST_MSECOND;
+  GST_BUFFER_DURATION (buf) = 40 * GST_MSECOND;
+
+  return buf;
+}
+
+static GArray *
+decode_sliced_stream (guint n_threads, guint * n_pictures, guint * n_output)
+{
+  GstH265TestDecoder *dec;
+  GstHarness *h;
+  GArray *slices;
+  guint i;
+
+  dec = g_object_new (gst_h265_test_decoder_get_type (), NULL);
+  gst_h265_decoder_set_slice_parse_threads (GST_H265_DECODER (dec),
+      n_threads);
+
+  h = gst_harness_new_with_element (GST_ELEMENT (dec), "sink", "src");
+  gst_harness_set_src_caps_str (h,
+      "video/x-h265, stream-format=byte-stream, alignment=au");
+
+  for (i = 0; i < N_PICTURES; i++)
+    fail_unless_equals_int (gst_harness_push (h, make_sliced_au (i)),
+        GST_FLOW_OK);
+  fail_unless (gst_harness_push_event (h, gst_event_new_eos ()));
+
+  *n_output = gst_harness_buffers_in_queue (h);
+  *n_pictures = dec->n_pictures;
+  slices = g_array_ref (dec->slices);
+
+  gst_harness_teardown (h);
+
+  return slices;
+}
+
+GST_START_TEST (test_h265_decoder_slice_parse_threads)
+{
+  GArray *serial, *threaded;
+  guint n_pictures, n_output, i;
+  gboolean other_thread = FALSE;
+
+  serial = decode_sliced_stream (0, &n_pictures, &n_output);
+  fail_unless_equals_int (n_pictures, N_PICTURES);
+  fail_unless_equals_int (n_output, N_PICTURES);
+  fail_unless_equals_int (serial->len, 2 * N_PICTURES);
+
+  threaded = decode_sliced_stream (4, &n_pictures, &n_output);
+  fail_unless_equals_int (n_pictures, N_PICTURES);
+  fail_unless_equals_int (n_output, N_PICTURES);
+  fail_unless_equals_int (threaded->len, serial->len);
+
+  /* decode_slice() must see the very same slices, in bitstream order and
+   * always from the streaming thread */
+  for (i = 0; i < serial->len; i++) {
+    SliceInfo *a = &g_array_index (serial, SliceInfo, i);
+    SliceInfo *b = &g_array_index (threaded, SliceInfo, i);
+
+    fail_unless_equals_int (a->segment_address, b->segment_address);
+    fail_unless_equals_int (a->type, b->type);
+    fail_unless_equals_int (a->first_slice_segment_in_pic_flag,
+        b->first_slice_segment_in_pic_flag);
+    fail_unless_equals_int (a->nalu_offset, b->nalu_offset);
+    fail_unless_equals_int (a->nalu_size, b->nalu_size);
+    fail_unless_equals_int (a->poc, b->poc);
+    fail_unless_equals_int (b->first_slice_segment_in_pic_flag, i % 2 == 0);
+
+    if (b->thread != g_array_index (threaded, SliceInfo, 0).thread)
+      other_thread = TRUE;
+  }
+  fail_if (other_thread);
+
+  g_array_unref (serial);
+  g_array_unref (threaded);
+}
+
+GST_END_TEST;
+
+static Suite *
+h265decoder_suite (void)
+{
+  Suite *s = suite_create ("H265 Decoder library");
+
+  TCase *tc_chain = tcase_create ("general");
+
+  suite_add_tcase (s, tc_chain);
+  tcase_add_test (tc_chain, test_h265_decoder_slice_parse_threads);
+
+  return s;
+}
+
+GST_CHECK_MAIN (h265decoder);
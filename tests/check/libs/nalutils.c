@@ -20,6 +20,7 @@
 
 #include <gst/check/gstcheck.h>
 #include <gst/codecparsers/nalutils.h>
+#include <gst/base/gstbitreader.h>
 #include <string.h>
 
 GST_START_TEST (test_nal_writer_init)
@@ -102,6 +103,216 @@ GST_START_TEST (test_nal_writer_emulation_preventation)
 
 GST_END_TEST;
 
+static gint
+scan_for_start_codes_bytewise (const guint8 * data, guint size)
+{
+  guint i;
+
+  for (i = 0; i + 4 <= size; i++) {
+    if (data[i] == 0x00 && data[i + 1] == 0x00 && data[i + 2] == 0x01)
+      return i;
+  }
+
+  return -1;
+}
+
+GST_START_TEST (test_scan_for_start_codes)
+{
+  guint8 data[64];
+  guint size, pos, i;
+  GRand *rand = g_rand_new_with_seed (0xcafe);
+
+  /* No start code in data without zero bytes, or with too few bytes */
+  memset (data, 0xff, sizeof (data));
+  for (size = 0; size <= sizeof (data); size++)
+    assert_equals_int (scan_for_start_codes (data, size), -1);
+
+  memset (data, 0x00, sizeof (data));
+  for (size = 0; size <= sizeof (data); size++)
+    assert_equals_int (scan_for_start_codes (data, size), -1);
+
+  data[0] = data[1] = 0x00;
+  data[2] = 0x01;
+  assert_equals_int (scan_for_start_codes (data, 3), -1);
+  assert_equals_int (scan_for_start_codes (data, 4), 0);
+
+  /* Start code at every position, with every buffer size */
+  for (pos = 0; pos + 3 <= sizeof (data); pos++) {
+    memset (data, 0xff, sizeof (data));
+    data[pos] = data[pos + 1] = 0x00;
+    data[pos + 2] = 0x01;
+
+    for (size = 0; size <= sizeof (data); size++) {
+      assert_equals_int (scan_for_start_codes (data, size),
+          scan_for_start_codes_bytewise (data, size));
+    }
+  }
+
+  /* Random data with lots of zero bytes */
+  for (i = 0; i < 10000; i++) {
+    for (pos = 0; pos < sizeof (data); pos++) {
+      guint32 r = g_rand_int_range (rand, 0, 8);
+      data[pos] = r < 4 ? 0x00 : (r < 6 ? 0x01 : g_rand_int (rand) & 0xff);
+    }
+
+    size = g_rand_int_range (rand, 0, sizeof (data) + 1);
+    assert_equals_int (scan_for_start_codes (data, size),
+        scan_for_start_codes_bytewise (data, size));
+  }
+
+  g_rand_free (rand);
+}
+
+GST_END_TEST;
+
+static guint
+unescape_nal (const guint8 * data, guint size, guint8 * dest)
+{
+  guint i, n = 0, zeros = 0;
+
+  for (i = 0; i < size; i++) {
+    if (zeros >= 2 && data[i] == 0x03) {
+      zeros = 0;
+      continue;
+    }
+
+    zeros = data[i] == 0x00 ? zeros + 1 : 0;
+    dest[n++] = data[i];
+  }
+
+  return n;
+}
+
+static gboolean
+bit_reader_get_ue (GstBitReader * br, guint32 * val)
+{
+  guint i = 0;
+  guint32 value = 0;
+  guint8 bit;
+
+  while (TRUE) {
+    if (!gst_bit_reader_get_bits_uint8 (br, &bit, 1))
+      return FALSE;
+    if (bit)
+      break;
+    if (++i > 31)
+      return FALSE;
+  }
+
+  if (i > 0 && !gst_bit_reader_get_bits_uint32 (br, &value, i))
+    return FALSE;
+
+  *val = (1U << i) - 1 + value;
+  return TRUE;
+}
+
+GST_START_TEST (test_nal_reader)
+{
+  guint8 data[128], rbsp[128];
+  GRand *rand = g_rand_new_with_seed (0xbeef);
+  guint i, j;
+
+  for (i = 0; i < 10000; i++) {
+    NalReader nr;
+    GstBitReader br;
+    guint size, rbsp_size;
+
+    /* Random data with lots of zero and emulation prevention bytes */
+    size = g_rand_int_range (rand, 0, sizeof (data) + 1);
+    for (j = 0; j < size; j++) {
+      guint32 r = g_rand_int_range (rand, 0, 8);
+      data[j] = r < 2 ? 0x00 : (r < 3 ? 0x03 : g_rand_int (rand) & 0xff);
+    }
+
+    rbsp_size = unescape_nal (data, size, rbsp);
+    nal_reader_init (&nr, data, size);
+    gst_bit_reader_init (&br, rbsp, rbsp_size);
+
+    for (j = 0; j < 100; j++) {
+      guint32 val = 0, expected = 0;
+      gboolean ret, expected_ret;
+
+      if (g_rand_boolean (rand)) {
+        GstBitReader tmp = br;
+
+        ret = nal_reader_get_ue (&nr, &val);
+        expected_ret = bit_reader_get_ue (&br, &expected);
+        if (!expected_ret)
+          br = tmp;
+      } else {
+        guint nbits = g_rand_int_range (rand, 0, 33);
+
+        ret = nal_reader_get_bits_uint32 (&nr, &val, nbits);
+        expected_ret = gst_bit_reader_get_bits_uint32 (&br, &expected, nbits);
+      }
+
+      assert_equals_int (ret, expected_ret);
+      if (!ret)
+        break;
+
+      assert_equals_uint64 (val, expected);
+      assert_equals_int (nal_reader_get_pos (&nr) -
+          8 * nal_reader_get_epb_count (&nr), gst_bit_reader_get_pos (&br));
+      assert_equals_int (nal_reader_is_byte_aligned (&nr),
+          gst_bit_reader_get_pos (&br) % 8 == 0);
+    }
+  }
+
+  g_rand_free (rand);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_scan_for_all_start_codes)
+{
+  guint8 data[256];
+  guint offsets[16], n, j, pos, size, i;
+  GRand *rand = g_rand_new_with_seed (0xbeef);
+
+  /* Back to back start codes, and one without a byte after it */
+  memset (data, 0xff, sizeof (data));
+  for (pos = 0; pos < 12; pos += 3) {
+    data[pos] = data[pos + 1] = 0x00;
+    data[pos + 2] = 0x01;
+  }
+  n = scan_for_all_start_codes (data, 12, offsets, G_N_ELEMENTS (offsets));
+  assert_equals_int (n, 3);
+  assert_equals_int (offsets[0], 0);
+  assert_equals_int (offsets[1], 3);
+  assert_equals_int (offsets[2], 6);
+
+  /* The number of offsets is capped */
+  n = scan_for_all_start_codes (data, 13, offsets, 2);
+  assert_equals_int (n, 2);
+
+  /* Same results as calling scan_for_start_codes() after each prefix */
+  for (i = 0; i < 10000; i++) {
+    for (pos = 0; pos < sizeof (data); pos++) {
+      guint32 r = g_rand_int_range (rand, 0, 8);
+      data[pos] = r < 4 ? 0x00 : (r < 6 ? 0x01 : g_rand_int (rand) & 0xff);
+    }
+
+    size = g_rand_int_range (rand, 0, sizeof (data) + 1);
+    n = scan_for_all_start_codes (data, size, offsets,
+        G_N_ELEMENTS (offsets));
+
+    pos = 0;
+    for (j = 0; j < n; j++) {
+      gint off = scan_for_start_codes (data + pos, size - pos);
+
+      fail_unless (off >= 0);
+      assert_equals_int (pos + off, offsets[j]);
+      pos = offsets[j] + 3;
+    }
+    if (n < G_N_ELEMENTS (offsets) && pos < size)
+      assert_equals_int (scan_for_start_codes (data + pos, size - pos), -1);
+  }
+
+  g_rand_free (rand);
+}
+
+GST_END_TEST;
+
 static Suite *
 nalutils_suite (void)
 {
@@ -112,6 +323,9 @@ nalutils_suite (void)
   suite_add_tcase (s, tc_chain);
   tcase_add_test (tc_chain, test_nal_writer_init);
   tcase_add_test (tc_chain, test_nal_writer_emulation_preventation);
+  tcase_add_test (tc_chain, test_scan_for_start_codes);
+  tcase_add_test (tc_chain, test_scan_for_all_start_codes);
+  tcase_add_test (tc_chain, test_nal_reader);
 
   return s;
 }
@@ -34,7 +34,12 @@
 #include <sys/file.h>
 #include <sys/types.h>
 #include <sys/socket.h>
+#ifdef HAVE_MEMFD_CREATE
+#include <sys/mman.h>
+#endif
 #include <gst/check/gstcheck.h>
+#include <gst/check/gstharness.h>
+#include <gst/allocators/gstfdmemory.h>
 #include <string.h>
 
 #ifndef HAVE_PIPE2
@@ -71,6 +76,7 @@ typedef enum
   TEST_FEATURE_ERROR_SINK = 0x80,       /* generates error message in the slave */
   TEST_FEATURE_LONG_DURATION = 0x100,   /* bigger num-buffers in {audio,video}testsrc */
   TEST_FEATURE_FILTER_SINK_CAPS = 0x200,        /* plugs capsfilter before fakesink */
+  TEST_FEATURE_PIPELINED = 0x2000,      /* sets window-size in ipcpipelinesink */
 
   /* Source selection; Use only one of those, do not combine! */
   TEST_FEATURE_TEST_SOURCE = 0x400,
@@ -542,6 +548,12 @@ create_test_source (gboolean live, int fdina, int fdouta, int fdinv, int fdoutv,
   return pipeline;
 }
 
+static void
+set_window_size (const GValue * v, gpointer user_data)
+{
+  g_object_set (g_value_get_object (v), "window-size", 16, NULL);
+}
+
 static GstElement *
 create_source (TestFeatures features, int fdina, int fdouta, int fdinv,
     int fdoutv, test_data * td)
@@ -565,6 +577,15 @@ create_source (TestFeatures features, int fdina, int fdouta, int fdinv,
     g_assert_not_reached ();
   }
 
+  if (pipeline && (features & TEST_FEATURE_PIPELINED)) {
+    GstIterator *it;
+
+    it = gst_bin_iterate_all_by_element_factory_name (GST_BIN (pipeline),
+        "ipcpipelinesink");
+    gst_iterator_foreach (it, set_window_size, NULL);
+    gst_iterator_free (it);
+  }
+
   td->two_streams = has_video;
   td->p = pipeline;
 
@@ -1182,6 +1203,18 @@ GST_START_TEST (test_empty_play_pause)
 
 GST_END_TEST;
 
+GST_START_TEST (test_pipelined_play_pause)
+{
+  play_pause_master_data md = PLAY_PAUSE_MASTER_DATA_INIT;
+  play_pause_slave_data sd = PLAY_PAUSE_SLAVE_DATA_INIT;
+
+  TEST_BASE (TEST_FEATURE_TEST_SOURCE | TEST_FEATURE_PIPELINED,
+      play_pause_source, setup_sink_play_pause, check_success_source_play_pause,
+      check_success_sink_play_pause, NULL, &md, &sd);
+}
+
+GST_END_TEST;
+
 GST_START_TEST (test_wavparse_play_pause)
 {
   play_pause_master_data md = PLAY_PAUSE_MASTER_DATA_INIT;
@@ -1484,6 +1517,20 @@ GST_START_TEST (test_empty_flushing_seek)
 
 GST_END_TEST;
 
+GST_START_TEST (test_pipelined_flushing_seek)
+{
+  flushing_seek_input_data id = FLUSHING_SEEK_INPUT_DATA_INIT;
+  flushing_seek_master_data md = FLUSHING_SEEK_MASTER_DATA_INIT;
+  flushing_seek_slave_data sd = FLUSHING_SEEK_SLAVE_DATA_INIT;
+
+  TEST_BASE (TEST_FEATURE_WAV_SOURCE | TEST_FEATURE_PIPELINED,
+      flushing_seek_source, setup_sink_flushing_seek,
+      check_success_source_flushing_seek, check_success_sink_flushing_seek,
+      &id, &md, &sd);
+}
+
+GST_END_TEST;
+
 GST_START_TEST (test_wavparse_flushing_seek)
 {
   flushing_seek_input_data id = FLUSHING_SEEK_INPUT_DATA_INIT;
@@ -5804,6 +5851,210 @@ GST_START_TEST (test_wavparse_master_process_crash)
 
 GST_END_TEST;
 
+#ifdef HAVE_MEMFD_CREATE
+/* fd_passing tests run the master and the slave pipeline in the same
+   process, and push a memfd backed buffer through them. */
+#define FD_PASSING_BUFFER_SIZE 4096
+
+typedef struct
+{
+  GMutex lock;
+  GCond cond;
+  gboolean hold;
+  GstBuffer *held;
+  gboolean received;
+  gboolean received_fd_memory;
+  gboolean content_ok;
+  gboolean released;
+} fd_passing_data;
+
+static void
+fd_passing_buffer_freed (gpointer user_data)
+{
+  fd_passing_data *d = user_data;
+
+  g_mutex_lock (&d->lock);
+  d->released = TRUE;
+  g_cond_signal (&d->cond);
+  g_mutex_unlock (&d->lock);
+}
+
+static void
+fd_passing_handoff (GstElement * fakesink, GstBuffer * buf, GstPad * pad,
+    gpointer user_data)
+{
+  fd_passing_data *d = user_data;
+  GstMapInfo map;
+  gboolean content_ok = FALSE;
+
+  if (gst_buffer_map (buf, &map, GST_MAP_READ)) {
+    content_ok = map.size == FD_PASSING_BUFFER_SIZE && map.data[0] == 0xab &&
+        map.data[map.size - 1] == 0xab;
+    gst_buffer_unmap (buf, &map);
+  }
+
+  g_mutex_lock (&d->lock);
+  d->received = TRUE;
+  d->received_fd_memory = gst_buffer_n_memory (buf) == 1 &&
+      gst_is_fd_memory (gst_buffer_peek_memory (buf, 0));
+  d->content_ok = content_ok;
+  if (d->hold)
+    d->held = gst_buffer_ref (buf);
+  g_mutex_unlock (&d->lock);
+}
+
+static GstBuffer *
+fd_passing_make_buffer (fd_passing_data * d)
+{
+  static GQuark quark = 0;
+  GstAllocator *allocator;
+  GstBuffer *buf;
+  GstMapInfo map;
+  int fd;
+
+  if (!quark)
+    quark = g_quark_from_static_string ("fd-passing-test");
+
+  fd = memfd_create ("ipcpipeline-test", MFD_CLOEXEC);
+  FAIL_IF (fd < 0);
+  FAIL_IF (ftruncate (fd, FD_PASSING_BUFFER_SIZE) < 0);
+
+  allocator = gst_fd_allocator_new ();
+  buf = gst_buffer_new ();
+  gst_buffer_append_memory (buf, gst_fd_allocator_alloc (allocator, fd,
+          FD_PASSING_BUFFER_SIZE, GST_FD_MEMORY_FLAG_NONE));
+  gst_object_unref (allocator);
+
+  fail_unless (gst_buffer_map (buf, &map, GST_MAP_WRITE));
+  memset (map.data, 0xab, map.size);
+  gst_buffer_unmap (buf, &map);
+
+  gst_mini_object_set_qdata (GST_MINI_OBJECT (buf), quark, d,
+      fd_passing_buffer_freed);
+
+  return buf;
+}
+
+static gboolean
+fd_passing_wait_released (fd_passing_data * d)
+{
+  gint64 end_time = g_get_monotonic_time () + 5 * G_TIME_SPAN_SECOND;
+  gboolean released;
+
+  g_mutex_lock (&d->lock);
+  while (!d->released && g_cond_wait_until (&d->cond, &d->lock, end_time));
+  released = d->released;
+  g_mutex_unlock (&d->lock);
+
+  return released;
+}
+
+/* Pushes one buffer from a master to a slave talking over
+   master_fdin/master_fdout and slave_fdin/slave_fdout */
+static void
+fd_passing_push_buffer (fd_passing_data * d, int master_fdin,
+    int master_fdout, int slave_fdin, int slave_fdout)
+{
+  GstElement *slave, *ipcpipelinesrc, *fakesink, *ipcpipelinesink;
+  GstHarness *h;
+
+  slave = gst_element_factory_make ("ipcslavepipeline", NULL);
+  ipcpipelinesrc = gst_element_factory_make ("ipcpipelinesrc", NULL);
+  fakesink = gst_element_factory_make ("fakesink", NULL);
+  g_object_set (ipcpipelinesrc, "fdin", slave_fdin, "fdout", slave_fdout,
+      NULL);
+  g_object_set (fakesink, "sync", FALSE, "async", FALSE,
+      "enable-last-sample", FALSE, "signal-handoffs", TRUE, NULL);
+  g_signal_connect (fakesink, "handoff", G_CALLBACK (fd_passing_handoff), d);
+  gst_bin_add_many (GST_BIN (slave), ipcpipelinesrc, fakesink, NULL);
+  fail_unless (gst_element_link (ipcpipelinesrc, fakesink));
+
+  ipcpipelinesink = gst_element_factory_make ("ipcpipelinesink", NULL);
+  g_object_set (ipcpipelinesink, "fdin", master_fdin, "fdout", master_fdout,
+      "window-size", 0, "fd-passing", TRUE, NULL);
+  h = gst_harness_new_with_element (ipcpipelinesink, "sink", NULL);
+  gst_harness_set_src_caps_str (h, "application/x-fd-passing-test");
+
+  /* with no window, this only returns once the slave pushed the buffer */
+  fail_unless_equals_int (gst_harness_push (h, fd_passing_make_buffer (d)),
+      GST_FLOW_OK);
+
+  g_mutex_lock (&d->lock);
+  fail_unless (d->received);
+  fail_unless (d->content_ok);
+  g_mutex_unlock (&d->lock);
+
+  if (d->hold) {
+    GstBuffer *held;
+
+    /* the master must keep the memfd until the slave releases it */
+    g_mutex_lock (&d->lock);
+    fail_if (d->released);
+    held = d->held;
+    d->held = NULL;
+    g_mutex_unlock (&d->lock);
+    gst_buffer_unref (held);
+  }
+  fail_unless (fd_passing_wait_released (d));
+
+  gst_harness_teardown (h);
+  gst_object_unref (ipcpipelinesink);
+  gst_element_set_state (slave, GST_STATE_NULL);
+  gst_object_unref (slave);
+}
+
+GST_START_TEST (test_fd_passing_socketpair)
+{
+  fd_passing_data d = { {0,}, };
+  int sockets[2];
+
+  g_mutex_init (&d.lock);
+  g_cond_init (&d.cond);
+  d.hold = TRUE;
+
+  FAIL_IF (socketpair (AF_UNIX, SOCK_STREAM, 0, sockets) < 0);
+  FAIL_IF (fcntl (sockets[0], F_SETFL, O_NONBLOCK) < 0);
+  FAIL_IF (fcntl (sockets[1], F_SETFL, O_NONBLOCK) < 0);
+
+  /* the slave gets the memfd itself, in a FD_BUFFER chunk, and the master
+     only drops the buffer once it gets the RELEASE for it */
+  fd_passing_push_buffer (&d, sockets[0], sockets[0], sockets[1], sockets[1]);
+  fail_unless (d.received_fd_memory);
+
+  close (sockets[0]);
+  close (sockets[1]);
+  g_mutex_clear (&d.lock);
+  g_cond_clear (&d.cond);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_fd_passing_pipe_fallback)
+{
+  fd_passing_data d = { {0,}, };
+  int pipesf[2], pipesb[2];
+
+  g_mutex_init (&d.lock);
+  g_cond_init (&d.cond);
+
+  FAIL_IF (pipe2 (pipesf, O_NONBLOCK) < 0);
+  FAIL_IF (pipe2 (pipesb, O_NONBLOCK) < 0);
+
+  /* fds cannot be passed over pipes, the content is sent inline */
+  fd_passing_push_buffer (&d, pipesb[0], pipesf[1], pipesf[0], pipesb[1]);
+  fail_if (d.received_fd_memory);
+
+  close (pipesf[0]);
+  close (pipesf[1]);
+  close (pipesb[0]);
+  close (pipesb[1]);
+  g_mutex_clear (&d.lock);
+  g_cond_clear (&d.cond);
+}
+
+GST_END_TEST;
+#endif
+
 static Suite *
 ipcpipeline_suite (void)
 {
@@ -5826,6 +6077,7 @@ ipcpipeline_suite (void)
     tcase_add_test (tc_chain, test_live_a_play_pause);
     tcase_add_test (tc_chain, test_live_av_play_pause);
     tcase_add_test (tc_chain, test_live_av_2_play_pause);
+    tcase_add_test (tc_chain, test_pipelined_play_pause);
   }
 
   /* flushing_seek tests perform a flushing seek in PLAYING
@@ -5839,6 +6091,7 @@ ipcpipeline_suite (void)
     tcase_add_test (tc_chain, test_live_a_flushing_seek);
     tcase_add_test (tc_chain, test_live_av_flushing_seek);
     tcase_add_test (tc_chain, test_live_av_2_flushing_seek);
+    tcase_add_test (tc_chain, test_pipelined_flushing_seek);
   }
 
   /* flushing_seek_in_pause tests perform a flushing seek in
@@ -6061,6 +6314,13 @@ ipcpipeline_suite (void)
      with the master pipeline. */
   tcase_add_test (tc_chain, test_wavparse_master_process_crash);
 
+#ifdef HAVE_MEMFD_CREATE
+  /* fd_passing tests check that memfd backed buffers are passed as fds
+     over UNIX sockets, and copied over anything else. */
+  tcase_add_test (tc_chain, test_fd_passing_socketpair);
+  tcase_add_test (tc_chain, test_fd_passing_pipe_fallback);
+#endif
+
   return s;
 }
 
@@ -0,0 +1,316 @@
+/* GStreamer
+ *
+ * Copyright (C) 2026 agent <agent@local>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/*
+ * Measures how many buffers per second go from an ipcpipelinesink to an
+ * ipcpipelinesrc in a forked process: first waiting for the ack of each
+ * buffer, then with a window of buffers in flight, and then passing memfd
+ * backed buffers as fds.
+ *
+ *   ipc-bench [-n buffers] [-s size] [-w window-size]
+ *
+ * The slave process re-executes the program with -S, so that it does not
+ * inherit the threads of the master.
+ */
+
+#ifdef HAVE_CONFIG_H
+#  include "config.h"
+#endif
+
+#define _GNU_SOURCE
+#include <unistd.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#ifdef HAVE_MEMFD_CREATE
+#include <sys/mman.h>
+#endif
+#include <gst/gst.h>
+#include <gst/allocators/gstfdmemory.h>
+
+#define N_BUFFERS_ALLOCATED 8
+
+static const char *program;
+
+typedef struct
+{
+  GMainLoop *loop;
+  GstBuffer *buffers[N_BUFFERS_ALLOCATED];
+  guint n_buffers;
+  guint pushed;
+  gboolean failed;
+} BenchData;
+
+static gboolean
+bus_msg (GstBus * bus, GstMessage * msg, gpointer user_data)
+{
+  BenchData *data = user_data;
+
+  switch (GST_MESSAGE_TYPE (msg)) {
+    case GST_MESSAGE_ERROR:{
+      GError *err;
+      gchar *dbg;
+
+      gst_message_parse_error (msg, &err, &dbg);
+      g_printerr ("ERROR: %s\n", err->message);
+      if (dbg != NULL)
+        g_printerr ("ERROR debug information: %s\n", dbg);
+      g_error_free (err);
+      g_free (dbg);
+      data->failed = TRUE;
+      g_main_loop_quit (data->loop);
+      break;
+    }
+    case GST_MESSAGE_EOS:
+      g_main_loop_quit (data->loop);
+      break;
+    default:
+      break;
+  }
+  return TRUE;
+}
+
+static void
+need_data (GstElement * appsrc, guint length, gpointer user_data)
+{
+  BenchData *data = user_data;
+  GstFlowReturn ret;
+
+  if (data->pushed == data->n_buffers) {
+    g_signal_emit_by_name (appsrc, "end-of-stream", &ret);
+    return;
+  }
+
+  g_signal_emit_by_name (appsrc, "push-buffer",
+      data->buffers[data->pushed % N_BUFFERS_ALLOCATED], &ret);
+  data->pushed++;
+}
+
+static gboolean
+allocate_buffers (BenchData * data, gsize size, gboolean memfd)
+{
+  GstAllocator *allocator = NULL;
+  guint n;
+
+  if (memfd) {
+#ifdef HAVE_MEMFD_CREATE
+    allocator = gst_fd_allocator_new ();
+#else
+    return FALSE;
+#endif
+  }
+
+  for (n = 0; n < N_BUFFERS_ALLOCATED; n++) {
+    if (allocator) {
+#ifdef HAVE_MEMFD_CREATE
+      GstMemory *mem;
+      int fd = memfd_create ("ipc-bench", MFD_CLOEXEC);
+
+      if (fd < 0 || ftruncate (fd, size) < 0) {
+        if (fd >= 0)
+          close (fd);
+        gst_object_unref (allocator);
+        return FALSE;
+      }
+      mem = gst_fd_allocator_alloc (allocator, fd, size,
+          GST_FD_MEMORY_FLAG_NONE);
+      data->buffers[n] = gst_buffer_new ();
+      gst_buffer_append_memory (data->buffers[n], mem);
+#endif
+    } else {
+      data->buffers[n] = gst_buffer_new_allocate (NULL, size, NULL);
+      gst_buffer_memset (data->buffers[n], 0, n, size);
+    }
+  }
+
+  if (allocator)
+    gst_object_unref (allocator);
+  return TRUE;
+}
+
+static void
+run_slave (int fd)
+{
+  GstElement *pipeline, *ipcpipelinesrc, *sink;
+  GMainLoop *loop;
+
+  pipeline = gst_element_factory_make ("ipcslavepipeline", NULL);
+  ipcpipelinesrc = gst_element_factory_make ("ipcpipelinesrc", NULL);
+  sink = gst_element_factory_make ("fakesink", NULL);
+  g_object_set (ipcpipelinesrc, "fdin", fd, "fdout", fd, NULL);
+  g_object_set (sink, "sync", FALSE, NULL);
+  gst_bin_add_many (GST_BIN (pipeline), ipcpipelinesrc, sink, NULL);
+  gst_element_link (ipcpipelinesrc, sink);
+
+  /* The slave follows the state of the master until it is killed */
+  loop = g_main_loop_new (NULL, FALSE);
+  g_main_loop_run (loop);
+}
+
+static int
+run_mode (const char *name, guint n_buffers, gsize size, guint window_size,
+    gboolean fd_passing)
+{
+  BenchData data = { NULL, };
+  GstElement *pipeline, *appsrc, *ipcpipelinesink;
+  GstCaps *caps;
+  gint64 start, stop;
+  int sockets[2];
+  pid_t pid;
+  guint n;
+
+  if (socketpair (AF_UNIX, SOCK_STREAM, 0, sockets) ||
+      fcntl (sockets[0], F_SETFL, O_NONBLOCK) < 0 ||
+      fcntl (sockets[1], F_SETFL, O_NONBLOCK) < 0) {
+    fprintf (stderr, "Error creating sockets: %s\n", strerror (errno));
+    return 1;
+  }
+
+  pid = fork ();
+  if (pid < 0) {
+    fprintf (stderr, "Error forking: %s\n", strerror (errno));
+    return 1;
+  } else if (pid == 0) {
+    gchar fd[16];
+
+    close (sockets[0]);
+    g_snprintf (fd, sizeof (fd), "%d", sockets[1]);
+    execlp (program, program, "-S", fd, NULL);
+    _exit (1);
+  }
+  close (sockets[1]);
+
+  if (!allocate_buffers (&data, size, fd_passing)) {
+    printf ("%-16s not supported\n", name);
+    kill (pid, SIGTERM);
+    waitpid (pid, NULL, 0);
+    close (sockets[0]);
+    return 0;
+  }
+  data.n_buffers = n_buffers;
+  data.loop = g_main_loop_new (NULL, FALSE);
+
+  pipeline = gst_pipeline_new (NULL);
+  gst_bus_add_watch (GST_ELEMENT_BUS (pipeline), bus_msg, &data);
+
+  appsrc = gst_element_factory_make ("appsrc", NULL);
+  caps = gst_caps_new_empty_simple ("application/x-ipc-bench");
+  g_object_set (appsrc, "caps", caps, "max-buffers", (guint64) 64, NULL);
+  gst_caps_unref (caps);
+  g_signal_connect (appsrc, "need-data", G_CALLBACK (need_data), &data);
+
+  ipcpipelinesink = gst_element_factory_make ("ipcpipelinesink", NULL);
+  g_object_set (ipcpipelinesink, "fdin", sockets[0], "fdout", sockets[0],
+      "window-size", window_size, "fd-passing", fd_passing, NULL);
+
+  gst_bin_add_many (GST_BIN (pipeline), appsrc, ipcpipelinesink, NULL);
+  gst_element_link (appsrc, ipcpipelinesink);
+
+  start = g_get_monotonic_time ();
+  gst_element_set_state (pipeline, GST_STATE_PLAYING);
+  g_main_loop_run (data.loop);
+  stop = g_get_monotonic_time ();
+
+  gst_element_set_state (pipeline, GST_STATE_NULL);
+  gst_bus_remove_watch (GST_ELEMENT_BUS (pipeline));
+  gst_object_unref (pipeline);
+  g_main_loop_unref (data.loop);
+  for (n = 0; n < N_BUFFERS_ALLOCATED; n++)
+    gst_buffer_unref (data.buffers[n]);
+
+  kill (pid, SIGTERM);
+  waitpid (pid, NULL, 0);
+  close (sockets[0]);
+
+  if (data.failed)
+    return 1;
+
+  printf ("%-16s %12.0f %12.1f\n", name,
+      n_buffers * 1e6 / (stop - start),
+      (double) n_buffers * size / (stop - start));
+
+  return 0;
+}
+
+int
+main (int argc, char **argv)
+{
+  guint n_buffers = 10000;
+  guint window_size = 32;
+  gsize size = 4096;
+  gchar *window_name;
+  int slave_fd = -1;
+  int opt;
+
+  program = argv[0];
+
+  while ((opt = getopt (argc, argv, "n:s:w:S:")) != -1) {
+    switch (opt) {
+      case 'n':
+        n_buffers = strtoul (optarg, NULL, 10);
+        break;
+      case 's':
+        size = strtoul (optarg, NULL, 10);
+        break;
+      case 'w':
+        window_size = strtoul (optarg, NULL, 10);
+        break;
+      case 'S':
+        slave_fd = atoi (optarg);
+        break;
+      default:
+        fprintf (stderr, "Usage: %s [-n buffers] [-s size] [-w window-size]\n",
+            argv[0]);
+        return 1;
+    }
+  }
+
+  if (n_buffers == 0 || size == 0 || window_size == 0) {
+    fprintf (stderr, "Invalid parameters\n");
+    return 1;
+  }
+
+  gst_init (&argc, &argv);
+
+  if (slave_fd >= 0) {
+    run_slave (slave_fd);
+    return 0;
+  }
+
+  printf ("%u buffers of %" G_GSIZE_FORMAT " bytes\n", n_buffers, size);
+  printf ("%-16s %12s %12s\n", "mode", "buffers/s", "MB/s");
+
+  window_name = g_strdup_printf ("window (%u)", window_size);
+  if (run_mode ("sync", n_buffers, size, 0, FALSE) ||
+      run_mode (window_name, n_buffers, size, window_size, FALSE) ||
+      run_mode ("window + fds", n_buffers, size, window_size, TRUE)) {
+    g_free (window_name);
+    return 1;
+  }
+  g_free (window_name);
+
+  return 0;
+}
@@ -0,0 +1,273 @@
+/* GStreamer
+ *
+ * Copyright (C) 2026 agent <agent@local>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/*
+ * Measures the cost of receiving a stream with srtsrc over loopback, first
+ * with one buffer per SRT message, then with batched reads pushed as buffer
+ * lists, and then with the messages of a batch packed into larger buffers.
+ *
+ * The stream comes from an srtsink listener in the same process, sending
+ * 1316 bytes messages at the given bitrate. The CPU time is the one of the
+ * srtsrc streaming thread.
+ *
+ *   srt-bench [-b bitrate-mbps] [-d duration-s] [-p port] [-n batch-size]
+ */
+
+#ifdef HAVE_CONFIG_H
+#  include "config.h"
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+#include <gst/gst.h>
+
+#define MESSAGE_SIZE 1316
+/* SRT_LIVE_MAX_PLSIZE, srtsrc only adds a message to a buffer while one of
+ * this size still fits */
+#define MAX_MESSAGE_SIZE 1456
+
+typedef struct
+{
+  GMainLoop *loop;
+  gboolean failed;
+
+  guint64 bytes;
+  guint64 pushes;
+  gint64 first_cpu;
+  gint64 last_cpu;
+} BenchData;
+
+static gint64
+thread_cpu_us (void)
+{
+#ifdef CLOCK_THREAD_CPUTIME_ID
+  struct timespec ts;
+
+  clock_gettime (CLOCK_THREAD_CPUTIME_ID, &ts);
+  return (gint64) ts.tv_sec * G_USEC_PER_SEC + ts.tv_nsec / 1000;
+#else
+  return 0;
+#endif
+}
+
+static gboolean
+bus_msg (GstBus * bus, GstMessage * msg, gpointer user_data)
+{
+  BenchData *data = user_data;
+
+  switch (GST_MESSAGE_TYPE (msg)) {
+    case GST_MESSAGE_ERROR:{
+      GError *err;
+      gchar *dbg;
+
+      gst_message_parse_error (msg, &err, &dbg);
+      g_printerr ("ERROR: %s\n", err->message);
+      if (dbg != NULL)
+        g_printerr ("ERROR debug information: %s\n", dbg);
+      g_error_free (err);
+      g_free (dbg);
+      data->failed = TRUE;
+      g_main_loop_quit (data->loop);
+      break;
+    }
+    case GST_MESSAGE_EOS:
+      g_main_loop_quit (data->loop);
+      break;
+    default:
+      break;
+  }
+  return TRUE;
+}
+
+static gboolean
+list_size (GstBuffer ** buffer, guint idx, gpointer user_data)
+{
+  guint64 *bytes = user_data;
+
+  *bytes += gst_buffer_get_size (*buffer);
+  return TRUE;
+}
+
+static GstPadProbeReturn
+count_probe (GstPad * pad, GstPadProbeInfo * info, gpointer user_data)
+{
+  BenchData *data = user_data;
+
+  /* Runs in the streaming thread of srtsrc */
+  data->last_cpu = thread_cpu_us ();
+  if (data->pushes == 0)
+    data->first_cpu = data->last_cpu;
+
+  if (info->type & GST_PAD_PROBE_TYPE_BUFFER_LIST)
+    gst_buffer_list_foreach (GST_PAD_PROBE_INFO_BUFFER_LIST (info),
+        list_size, &data->bytes);
+  else
+    data->bytes += gst_buffer_get_size (GST_PAD_PROBE_INFO_BUFFER (info));
+  data->pushes++;
+
+  return GST_PAD_PROBE_OK;
+}
+
+static gboolean
+stop_loop (gpointer user_data)
+{
+  BenchData *data = user_data;
+
+  g_main_loop_quit (data->loop);
+  return G_SOURCE_REMOVE;
+}
+
+static int
+run_mode (const char *name, guint port, guint bitrate, guint duration,
+    guint batch_size, guint aggregate_size)
+{
+  BenchData data = { NULL, };
+  GstElement *sender, *receiver, *src;
+  GstPad *pad;
+  gchar *desc;
+  guint64 messages;
+
+  data.loop = g_main_loop_new (NULL, FALSE);
+
+  desc = g_strdup_printf ("fakesrc sizetype=fixed sizemax=%u filltype=zero "
+      "datarate=%u ! srtsink uri=srt://:%u wait-for-connection=true",
+      MESSAGE_SIZE, bitrate / 8, port);
+  sender = gst_parse_launch (desc, NULL);
+  g_free (desc);
+
+  desc = g_strdup_printf ("srtsrc name=src uri=srt://127.0.0.1:%u "
+      "batch-size=%u aggregate-size=%u ! fakesink sync=false",
+      port, batch_size, aggregate_size);
+  receiver = gst_parse_launch (desc, NULL);
+  g_free (desc);
+
+  if (!sender || !receiver) {
+    fprintf (stderr, "Could not create the pipelines\n");
+    return 1;
+  }
+
+  gst_bus_add_watch (GST_ELEMENT_BUS (sender), bus_msg, &data);
+  gst_bus_add_watch (GST_ELEMENT_BUS (receiver), bus_msg, &data);
+
+  src = gst_bin_get_by_name (GST_BIN (receiver), "src");
+  pad = gst_element_get_static_pad (src, "src");
+  gst_pad_add_probe (pad,
+      GST_PAD_PROBE_TYPE_BUFFER | GST_PAD_PROBE_TYPE_BUFFER_LIST,
+      count_probe, &data, NULL);
+  gst_object_unref (pad);
+  gst_object_unref (src);
+
+  /* The listener has to be up before srtsrc connects */
+  gst_element_set_state (sender, GST_STATE_PLAYING);
+  gst_element_set_state (receiver, GST_STATE_PLAYING);
+
+  g_timeout_add_seconds (duration, stop_loop, &data);
+  g_main_loop_run (data.loop);
+
+  gst_element_set_state (receiver, GST_STATE_NULL);
+  gst_element_set_state (sender, GST_STATE_NULL);
+  gst_bus_remove_watch (GST_ELEMENT_BUS (receiver));
+  gst_bus_remove_watch (GST_ELEMENT_BUS (sender));
+  gst_object_unref (receiver);
+  gst_object_unref (sender);
+  g_main_loop_unref (data.loop);
+
+  if (data.failed)
+    return 1;
+
+  messages = data.bytes / MESSAGE_SIZE;
+  if (messages == 0) {
+    printf ("%-16s no data received\n", name);
+    return 0;
+  }
+
+  printf ("%-16s %12.0f %12.0f %12.1f %12.3f\n", name,
+      (double) messages / duration, (double) data.pushes / duration,
+      data.bytes * 8.0 / 1e6 / duration,
+      (double) (data.last_cpu - data.first_cpu) / messages);
+
+  return 0;
+}
+
+int
+main (int argc, char **argv)
+{
+  guint bitrate_mbps = 100;
+  guint duration = 5;
+  guint port = 7001;
+  guint batch_size = 64;
+  gchar *name;
+  int opt;
+
+  while ((opt = getopt (argc, argv, "b:d:p:n:")) != -1) {
+    switch (opt) {
+      case 'b':
+        bitrate_mbps = strtoul (optarg, NULL, 10);
+        break;
+      case 'd':
+        duration = strtoul (optarg, NULL, 10);
+        break;
+      case 'p':
+        port = strtoul (optarg, NULL, 10);
+        break;
+      case 'n':
+        batch_size = strtoul (optarg, NULL, 10);
+        break;
+      default:
+        fprintf (stderr, "Usage: %s [-b bitrate-mbps] [-d duration-s] "
+            "[-p port] [-n batch-size]\n", argv[0]);
+        return 1;
+    }
+  }
+
+  if (bitrate_mbps == 0 || duration == 0 || port == 0 || port > 65533 ||
+      batch_size < 2) {
+    fprintf (stderr, "Invalid parameters\n");
+    return 1;
+  }
+
+  gst_init (&argc, &argv);
+
+  printf ("%u Mbit/s of %u bytes messages for %u s\n", bitrate_mbps,
+      MESSAGE_SIZE, duration);
+  printf ("%-16s %12s %12s %12s %12s\n", "mode", "messages/s", "pushes/s",
+      "Mbit/s", "cpu/msg (us)");
+
+  /* Each mode uses its own port, so that the previous connection does not
+   * get in the way */
+  if (run_mode ("message", port, bitrate_mbps * 1000000, duration, 1, 0))
+    return 1;
+
+  name = g_strdup_printf ("batch (%u)", batch_size);
+  if (run_mode (name, port + 1, bitrate_mbps * 1000000, duration,
+          batch_size, 0)) {
+    g_free (name);
+    return 1;
+  }
+  g_free (name);
+
+  if (run_mode ("batch + pack", port + 2, bitrate_mbps * 1000000, duration,
+          batch_size, 10 * MESSAGE_SIZE + MAX_MESSAGE_SIZE - MESSAGE_SIZE))
+    return 1;
+
+  return 0;
+}
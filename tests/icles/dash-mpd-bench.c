@@ -0,0 +1,297 @@
+/* GStreamer
+ *
+ * Copyright (C) 2026 agent <agent@local>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/* Measures the cost of the MPD refreshes and Representation switches of
+ * dashdemux for live manifests with long SegmentTimelines.
+ *
+ * The manifests are the live SegmentTimeline manifests of the dash_mpd unit
+ * tests, scaled up to the requested number of S elements. Each refresh
+ * slides the timeline window by a few segments, like a live packager does.
+ * Manifests given on the command line are only parsed and set up.
+ *
+ *   dash-mpd-bench [-s segments] [-a appended] [-r runs] [file...]
+ */
+
+/* The MPD client is not a public API, build it in like the unit tests do */
+#include "../../ext/dash/gstmpdparser.c"
+#include "../../ext/dash/gstxmlhelper.c"
+#include "../../ext/dash/gstmpdhelper.c"
+#include "../../ext/dash/gstmpdnode.c"
+#include "../../ext/dash/gstmpdrepresentationbasenode.c"
+#include "../../ext/dash/gstmpdmultsegmentbasenode.c"
+#include "../../ext/dash/gstmpdrootnode.c"
+#include "../../ext/dash/gstmpdbaseurlnode.c"
+#include "../../ext/dash/gstmpdutctimingnode.c"
+#include "../../ext/dash/gstmpdmetricsnode.c"
+#include "../../ext/dash/gstmpdmetricsrangenode.c"
+#include "../../ext/dash/gstmpdsnode.c"
+#include "../../ext/dash/gstmpdsegmenttimelinenode.c"
+#include "../../ext/dash/gstmpdsegmenttemplatenode.c"
+#include "../../ext/dash/gstmpdsegmenturlnode.c"
+#include "../../ext/dash/gstmpdsegmentlistnode.c"
+#include "../../ext/dash/gstmpdsegmentbasenode.c"
+#include "../../ext/dash/gstmpdperiodnode.c"
+#include "../../ext/dash/gstmpdsubrepresentationnode.c"
+#include "../../ext/dash/gstmpdrepresentationnode.c"
+#include "../../ext/dash/gstmpdcontentcomponentnode.c"
+#include "../../ext/dash/gstmpdadaptationsetnode.c"
+#include "../../ext/dash/gstmpdsubsetnode.c"
+#include "../../ext/dash/gstmpdprograminformationnode.c"
+#include "../../ext/dash/gstmpdlocationnode.c"
+#include "../../ext/dash/gstmpdreportingnode.c"
+#include "../../ext/dash/gstmpdurltypenode.c"
+#include "../../ext/dash/gstmpddescriptortypenode.c"
+#include "../../ext/dash/gstmpdclient.c"
+#undef GST_CAT_DEFAULT
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+GST_DEBUG_CATEGORY (gst_dash_demux_debug);
+
+/* Same manifest as build_live_segment_timeline_mpd() in the dash_mpd unit
+ * tests: @count S elements, starting from the @first one of an endless
+ * sequence of segments with alternating durations */
+static gchar *
+build_live_segment_timeline_mpd (guint first, guint count)
+{
+  GString *xml = g_string_new (NULL);
+  guint64 t = 0;
+  guint n;
+
+  for (n = 0; n < first; n++)
+    t += 90000 + (n % 3) * 10;
+
+  g_string_append (xml, "<?xml version=\"1.0\"?>"
+      "<MPD xmlns=\"urn:mpeg:dash:schema:mpd:2011\""
+      "     profiles=\"urn:mpeg:dash:profile:isoff-live:2011\""
+      "     type=\"dynamic\""
+      "     availabilityStartTime=\"2015-03-24T0:0:0\""
+      "     minimumUpdatePeriod=\"PT2S\">"
+      "  <Period id=\"Period0\" start=\"PT0S\">"
+      "    <AdaptationSet id=\"1\" mimeType=\"video/mp4\">"
+      "      <SegmentTemplate timescale=\"90000\""
+      "                       media=\"$RepresentationID$-$Number$.mp4\"");
+  g_string_append_printf (xml, " startNumber=\"%u\">", first + 1);
+  g_string_append (xml, "        <SegmentTimeline>");
+  for (n = first; n < first + count; n++) {
+    if (n == first)
+      g_string_append_printf (xml, "<S t=\"%" G_GUINT64_FORMAT "\" d=\"%u\"/>",
+          t, 90000 + (n % 3) * 10);
+    else
+      g_string_append_printf (xml, "<S d=\"%u\"/>", 90000 + (n % 3) * 10);
+  }
+  g_string_append (xml, "        </SegmentTimeline>"
+      "      </SegmentTemplate>"
+      "      <Representation id=\"low\" bandwidth=\"250000\"/>"
+      "      <Representation id=\"high\" bandwidth=\"1000000\"/>"
+      "    </AdaptationSet></Period></MPD>");
+
+  return g_string_free (xml, FALSE);
+}
+
+/* What dashdemux does with a new manifest: parse it, optionally take over
+ * the segment lists of the previous client, and set up the stream */
+static GstMPDClient *
+load_manifest (const gchar * xml, GstMPDClient * previous)
+{
+  GstMPDClient *client = gst_mpd_client_new ();
+  GstMPDAdaptationSetNode *adapt_set;
+  GList *adapt_sets;
+
+  if (!gst_mpd_client_parse (client, xml, (gint) strlen (xml)))
+    g_error ("Failed to parse the manifest");
+
+  if (previous)
+    gst_mpd_client_inherit_segments (client, previous);
+
+  if (!gst_mpd_client_setup_media_presentation (client, GST_CLOCK_TIME_NONE,
+          -1, NULL))
+    g_error ("Failed to set up the media presentation");
+
+  adapt_sets = gst_mpd_client_get_adaptation_sets (client);
+  adapt_set = g_list_nth_data (adapt_sets, 0);
+  if (!adapt_set || !gst_mpd_client_setup_streaming (client, adapt_set))
+    g_error ("Failed to set up streaming");
+  g_list_free (adapt_sets);
+
+  return client;
+}
+
+static void
+switch_representation (GstMPDClient * client, guint idx)
+{
+  GstActiveStream *stream =
+      gst_mpd_client_get_active_stream_by_index (client, 0);
+  GstMPDRepresentationNode *rep =
+      g_list_nth_data (stream->cur_adapt_set->Representations, idx);
+
+  if (!gst_mpd_client_setup_representation (client, stream, rep))
+    g_error ("Failed to set up the Representation");
+}
+
+typedef struct
+{
+  const gchar *name;
+  gint64 best;
+} Result;
+
+static void
+report (Result * result, gint64 elapsed)
+{
+  if (result->best < 0 || elapsed < result->best)
+    result->best = elapsed;
+}
+
+static void
+usage (const gchar * name)
+{
+  g_printerr ("usage: %s [-s segments] [-a appended] [-r runs] [file...]\n",
+      name);
+}
+
+int
+main (int argc, char **argv)
+{
+  guint n_segments = 20000, appended = 2, runs = 5, r, i;
+  Result results[] = {
+    {"parse", -1},
+    {"setup", -1},
+    {"switch, new list", -1},
+    {"switch, cached list", -1},
+    {"refresh, full", -1},
+    {"refresh, incremental", -1},
+    {"refresh, unchanged", -1},
+  };
+  gchar *xml, *next_xml, *same_xml;
+  gsize len;
+  int opt, f;
+
+  gst_init (&argc, &argv);
+  GST_DEBUG_CATEGORY_INIT (gst_dash_demux_debug, "dashdemux", 0, "dashdemux");
+
+  while ((opt = getopt (argc, argv, "s:a:r:h")) != -1) {
+    switch (opt) {
+      case 's':
+        n_segments = atoi (optarg);
+        break;
+      case 'a':
+        appended = atoi (optarg);
+        break;
+      case 'r':
+        runs = atoi (optarg);
+        break;
+      default:
+        usage (argv[0]);
+        return 1;
+    }
+  }
+
+  if (n_segments == 0 || runs == 0) {
+    usage (argv[0]);
+    return 1;
+  }
+
+  /* The refreshed manifest drops the @appended oldest segments and adds as
+   * many new ones */
+  xml = build_live_segment_timeline_mpd (0, n_segments);
+  next_xml = build_live_segment_timeline_mpd (appended, n_segments);
+  same_xml = g_strdup (xml);
+  len = strlen (xml);
+
+  for (r = 0; r < runs; r++) {
+    GstMPDClient *client, *next;
+    gint64 start;
+
+    start = g_get_monotonic_time ();
+    client = gst_mpd_client_new ();
+    gst_mpd_client_parse (client, xml, (gint) len);
+    report (&results[0], g_get_monotonic_time () - start);
+    gst_mpd_client_free (client);
+
+    start = g_get_monotonic_time ();
+    client = load_manifest (xml, NULL);
+    report (&results[1], g_get_monotonic_time () - start);
+
+    start = g_get_monotonic_time ();
+    switch_representation (client, 1);
+    report (&results[2], g_get_monotonic_time () - start);
+
+    start = g_get_monotonic_time ();
+    switch_representation (client, 0);
+    report (&results[3], g_get_monotonic_time () - start);
+
+    start = g_get_monotonic_time ();
+    next = load_manifest (next_xml, NULL);
+    report (&results[4], g_get_monotonic_time () - start);
+    gst_mpd_client_free (next);
+
+    start = g_get_monotonic_time ();
+    next = load_manifest (next_xml, client);
+    report (&results[5], g_get_monotonic_time () - start);
+    gst_mpd_client_free (next);
+
+    /* dashdemux skips refreshes that are byte for byte identical */
+    start = g_get_monotonic_time ();
+    if (strlen (same_xml) != len || memcmp (same_xml, xml, len) != 0)
+      g_error ("Manifest should be unchanged");
+    report (&results[6], g_get_monotonic_time () - start);
+
+    gst_mpd_client_free (client);
+  }
+
+  printf ("%u S elements, %u appended per refresh, %" G_GSIZE_FORMAT
+      " bytes\n", n_segments, appended, len);
+  printf ("  %-22s %12s\n", "operation", "usec");
+  for (i = 0; i < G_N_ELEMENTS (results); i++)
+    printf ("  %-22s %12" G_GINT64_FORMAT "\n", results[i].name,
+        results[i].best);
+
+  g_free (xml);
+  g_free (next_xml);
+  g_free (same_xml);
+
+  for (f = optind; f < argc; f++) {
+    Result setup = { "setup", -1 };
+    GError *err = NULL;
+    gchar *data;
+
+    if (!g_file_get_contents (argv[f], &data, &len, &err)) {
+      g_printerr ("%s\n", err->message);
+      g_clear_error (&err);
+      return 1;
+    }
+
+    for (r = 0; r < runs; r++) {
+      gint64 start = g_get_monotonic_time ();
+
+      gst_mpd_client_free (load_manifest (data, NULL));
+      report (&setup, g_get_monotonic_time () - start);
+    }
+
+    printf ("%s: %" G_GSIZE_FORMAT " bytes\n", argv[f], len);
+    printf ("  %-22s %12" G_GINT64_FORMAT "\n", setup.name, setup.best);
+    g_free (data);
+  }
+
+  return 0;
+}
@@ -0,0 +1,344 @@
+/* GStreamer
+ *
+ * Copyright (C) 2026 agent <agent@local>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/* Measures the throughput of GstH265Decoder on pictures of many slices,
+ * with the slice headers parsed by the streaming thread only and by
+ * gst_h265_decoder_set_slice_parse_threads() threads.
+ *
+ * The subclass is the one of tests/check/libs/h265decoder.c: it doesn't
+ * decode anything, so the time is spent in the base class. The pictures
+ * are the 128x128 IDR picture of that test, with its second slice repeated
+ * to get -l slices per picture.
+ *
+ *   h265-slice-bench [-l slices] [-p pictures] [-t threads] [-r runs]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <gst/gst.h>
+#include <gst/app/gstappsrc.h>
+#include <gst/codecs/gsth265decoder.h>
+
+/* multi-sliced data, generated on zynqultrascaleplus with:
+ * gst-launch-1.0 videotestsrc num-buffers=1 pattern=green \
+ *    ! video/x-raw,width=128,height=128 \
+ *    ! omxh265enc num-slices=2 \
+ *    ! fakesink dump=1
+ */
+static const guint8 h265_128x128_sliced_vps[] = {
+  0x00, 0x00, 0x00, 0x01, 0x40, 0x01, 0x0c, 0x01,
+  0xff, 0xff, 0x01, 0x40, 0x00, 0x00, 0x03, 0x00,
+  0x90, 0x00, 0x00, 0x03, 0x00, 0x00, 0x03, 0x00,
+  0x1e, 0x25, 0x02, 0x40
+};
+
+static const guint8 h265_128x128_sliced_sps[] = {
+  0x00, 0x00, 0x00, 0x01, 0x42, 0x01, 0x01, 0x01,
+  0x40, 0x00, 0x00, 0x03, 0x00, 0x90, 0x00, 0x00,
+  0x03, 0x00, 0x00, 0x03, 0x00, 0x1e, 0xa0, 0x10,
+  0x20, 0x20, 0x59, 0xe9, 0x6e, 0x44, 0xa1, 0x73,
+  0x50, 0x60, 0x20, 0x2e, 0x10, 0x00, 0x00, 0x03,
+  0x00, 0x10, 0x00, 0x00, 0x03, 0x01, 0xe5, 0x1a,
+  0xff, 0xff, 0x10, 0x3e, 0x80, 0x5d, 0xf7, 0xc2,
+  0x01, 0x04
+};
+
+static const guint8 h265_128x128_sliced_pps[] = {
+  0x00, 0x00, 0x00, 0x01, 0x44, 0x01, 0xc0, 0x71,
+  0x81, 0x8d, 0xb2
+};
+
+static const guint8 h265_128x128_slice_1_idr_n_lp[] = {
+  0x00, 0x00, 0x00, 0x01, 0x28, 0x01, 0xac, 0x46,
+  0x13, 0xb6, 0x45, 0x43, 0xaf, 0xee, 0x3d, 0x3f,
+  0x76, 0xe5, 0x73, 0x2f, 0xee, 0xd2, 0xeb, 0xbf,
+  0x80
+};
+
+static const guint8 h265_128x128_slice_2_idr_n_lp[] = {
+  0x00, 0x00, 0x00, 0x01, 0x28, 0x01, 0x30, 0xc4,
+  0x60, 0x13, 0xb6, 0x45, 0x43, 0xaf, 0xee, 0x3d,
+  0x3f, 0x76, 0xe5, 0x73, 0x2f, 0xee, 0xd2, 0xeb,
+  0xbf, 0x80
+};
+
+typedef struct
+{
+  GstH265Decoder parent;
+
+  guint n_slices;
+  guint n_pictures;
+} GstH265TestDecoder;
+
+typedef struct
+{
+  GstH265DecoderClass parent_class;
+} GstH265TestDecoderClass;
+
+static GstStaticPadTemplate sink_template = GST_STATIC_PAD_TEMPLATE ("sink",
+    GST_PAD_SINK, GST_PAD_ALWAYS,
+    GST_STATIC_CAPS ("video/x-h265, stream-format=byte-stream, alignment=au"));
+
+static GstStaticPadTemplate src_template = GST_STATIC_PAD_TEMPLATE ("src",
+    GST_PAD_SRC, GST_PAD_ALWAYS,
+    GST_STATIC_CAPS ("video/x-raw, format=NV12"));
+
+GType gst_h265_test_decoder_get_type (void);
+G_DEFINE_TYPE (GstH265TestDecoder, gst_h265_test_decoder,
+    GST_TYPE_H265_DECODER);
+
+static gboolean
+gst_h265_test_decoder_new_sequence (GstH265Decoder * decoder,
+    const GstH265SPS * sps, gint max_dpb_size)
+{
+  GstVideoCodecState *state;
+
+  state = gst_video_decoder_set_output_state (GST_VIDEO_DECODER (decoder),
+      GST_VIDEO_FORMAT_NV12, sps->width, sps->height, decoder->input_state);
+  gst_video_codec_state_unref (state);
+
+  return gst_video_decoder_negotiate (GST_VIDEO_DECODER (decoder));
+}
+
+static gboolean
+gst_h265_test_decoder_decode_slice (GstH265Decoder * decoder,
+    GstH265Picture * picture, GstH265Slice * slice, GArray * ref_pic_list0,
+    GArray * ref_pic_list1)
+{
+  GstH265TestDecoder *self = (GstH265TestDecoder *) decoder;
+
+  self->n_slices++;
+
+  return TRUE;
+}
+
+static gboolean
+gst_h265_test_decoder_end_picture (GstH265Decoder * decoder,
+    GstH265Picture * picture)
+{
+  GstH265TestDecoder *self = (GstH265TestDecoder *) decoder;
+
+  self->n_pictures++;
+
+  return TRUE;
+}
+
+static GstFlowReturn
+gst_h265_test_decoder_output_picture (GstH265Decoder * decoder,
+    GstVideoCodecFrame * frame, GstH265Picture * picture)
+{
+  frame->output_buffer = gst_buffer_new ();
+  gst_h265_picture_unref (picture);
+
+  return gst_video_decoder_finish_frame (GST_VIDEO_DECODER (decoder), frame);
+}
+
+static void
+gst_h265_test_decoder_class_init (GstH265TestDecoderClass * klass)
+{
+  GstElementClass *element_class = GST_ELEMENT_CLASS (klass);
+  GstH265DecoderClass *h265decoder_class = GST_H265_DECODER_CLASS (klass);
+
+  gst_element_class_add_static_pad_template (element_class, &sink_template);
+  gst_element_class_add_static_pad_template (element_class, &src_template);
+  gst_element_class_set_static_metadata (element_class,
+      "H.265 test decoder", "Codec/Decoder/Video", "H.265 test decoder",
+      "GStreamer");
+
+  h265decoder_class->new_sequence = gst_h265_test_decoder_new_sequence;
+  h265decoder_class->decode_slice = gst_h265_test_decoder_decode_slice;
+  h265decoder_class->end_picture = gst_h265_test_decoder_end_picture;
+  h265decoder_class->output_picture = gst_h265_test_decoder_output_picture;
+}
+
+static void
+gst_h265_test_decoder_init (GstH265TestDecoder * self)
+{
+}
+
+/* The base class doesn't check the slice segment addresses, so repeating
+ * the second slice gives pictures of as many slices as wanted */
+static GstBuffer *
+make_sliced_au (guint idx, guint n_slices)
+{
+  GstBuffer *buf = gst_buffer_new ();
+  guint i;
+
+#define APPEND(data) \
+  gst_buffer_append_memory (buf, gst_memory_new_wrapped ( \
+      GST_MEMORY_FLAG_READONLY, (gpointer) data, sizeof (data), 0, \
+      sizeof (data), NULL, NULL))
+
+  APPEND (h265_128x128_sliced_vps);
+  APPEND (h265_128x128_sliced_sps);
+  APPEND (h265_128x128_sliced_pps);
+  APPEND (h265_128x128_slice_1_idr_n_lp);
+  for (i = 1; i < n_slices; i++)
+    APPEND (h265_128x128_slice_2_idr_n_lp);
+
+#undef APPEND
+
+  GST_BUFFER_PTS (buf) = idx * 40 * GST_MSECOND;
+  GST_BUFFER_DURATION (buf) = 40 * GST_MSECOND;
+
+  return buf;
+}
+
+/* Returns the time it took to decode @aus, in microseconds */
+static gint64
+decode_sliced_stream (GstBuffer ** aus, guint n_aus, guint n_threads,
+    guint * n_pictures, guint * n_slices)
+{
+  GstElement *pipeline, *src, *sink;
+  GstH265TestDecoder *dec;
+  GstMessage *msg;
+  GstCaps *caps;
+  gint64 start, end;
+  guint i;
+
+  pipeline = gst_pipeline_new (NULL);
+  src = gst_element_factory_make ("appsrc", NULL);
+  sink = gst_element_factory_make ("fakesink", NULL);
+  if (!src || !sink)
+    g_error ("Failed to create appsrc or fakesink");
+
+  dec = g_object_new (gst_h265_test_decoder_get_type (), NULL);
+  gst_h265_decoder_set_slice_parse_threads (GST_H265_DECODER (dec),
+      n_threads);
+
+  caps = gst_caps_from_string
+      ("video/x-h265, stream-format=byte-stream, alignment=au");
+  g_object_set (src, "caps", caps, "format", GST_FORMAT_TIME, "max-bytes",
+      (guint64) 0, NULL);
+  gst_caps_unref (caps);
+  g_object_set (sink, "sync", FALSE, NULL);
+
+  gst_bin_add_many (GST_BIN (pipeline), src, GST_ELEMENT (dec), sink, NULL);
+  if (!gst_element_link_many (src, GST_ELEMENT (dec), sink, NULL))
+    g_error ("Failed to link the decoder");
+
+  /* Everything is queued upfront so that only the decoding is timed */
+  for (i = 0; i < n_aus; i++)
+    gst_app_src_push_buffer (GST_APP_SRC (src), gst_buffer_ref (aus[i]));
+  gst_app_src_end_of_stream (GST_APP_SRC (src));
+
+  start = g_get_monotonic_time ();
+  gst_element_set_state (pipeline, GST_STATE_PLAYING);
+  msg = gst_bus_timed_pop_filtered (GST_ELEMENT_BUS (pipeline),
+      GST_CLOCK_TIME_NONE, GST_MESSAGE_EOS | GST_MESSAGE_ERROR);
+  end = g_get_monotonic_time ();
+
+  if (GST_MESSAGE_TYPE (msg) == GST_MESSAGE_ERROR)
+    g_error ("Failed to decode the stream");
+  gst_message_unref (msg);
+
+  *n_pictures = dec->n_pictures;
+  *n_slices = dec->n_slices;
+
+  gst_element_set_state (pipeline, GST_STATE_NULL);
+  gst_object_unref (pipeline);
+
+  return end - start;
+}
+
+static void
+usage (const gchar * name)
+{
+  g_printerr ("usage: %s [-l slices] [-p pictures] [-t threads] [-r runs]\n",
+      name);
+}
+
+int
+main (int argc, char **argv)
+{
+  guint n_slices = 64, n_aus = 2000, runs = 5, i, r;
+  guint n_threads = g_get_num_processors ();
+  guint threads[2];
+  gint64 serial = 0;
+  GstBuffer **aus;
+  int opt;
+
+  gst_init (&argc, &argv);
+
+  while ((opt = getopt (argc, argv, "l:p:t:r:h")) != -1) {
+    switch (opt) {
+      case 'l':
+        n_slices = atoi (optarg);
+        break;
+      case 'p':
+        n_aus = atoi (optarg);
+        break;
+      case 't':
+        n_threads = atoi (optarg);
+        break;
+      case 'r':
+        runs = atoi (optarg);
+        break;
+      default:
+        usage (argv[0]);
+        return 1;
+    }
+  }
+
+  if (n_slices == 0 || n_aus == 0 || n_threads < 2 || runs == 0) {
+    usage (argv[0]);
+    return 1;
+  }
+
+  aus = g_new (GstBuffer *, n_aus);
+  for (i = 0; i < n_aus; i++)
+    aus[i] = make_sliced_au (i, n_slices);
+
+  printf ("%u pictures of %u slices\n", n_aus, n_slices);
+  printf ("  %-8s %12s %12s %12s %8s\n", "threads", "usec", "pictures/s",
+      "slices/s", "speedup");
+
+  threads[0] = 1;
+  threads[1] = n_threads;
+  for (i = 0; i < G_N_ELEMENTS (threads); i++) {
+    gint64 best = G_MAXINT64;
+    guint n_pictures = 0, n_decoded_slices = 0;
+
+    for (r = 0; r < runs; r++) {
+      best = MIN (best, decode_sliced_stream (aus, n_aus, threads[i],
+              &n_pictures, &n_decoded_slices));
+    }
+
+    if (n_pictures != n_aus || n_decoded_slices != n_aus * n_slices)
+      g_error ("Decoded %u pictures of %u slices, expected %u of %u",
+          n_pictures, n_decoded_slices, n_aus, n_aus * n_slices);
+
+    if (i == 0)
+      serial = best;
+
+    printf ("  %-8u %12" G_GINT64_FORMAT " %12.1f %12.1f %8.2f\n", threads[i],
+        best, best > 0 ? (gdouble) n_pictures * G_USEC_PER_SEC / best : 0.0,
+        best > 0 ? (gdouble) n_decoded_slices * G_USEC_PER_SEC / best : 0.0,
+        best > 0 ? (gdouble) serial / best : 0.0);
+  }
+
+  for (i = 0; i < n_aus; i++)
+    gst_buffer_unref (aus[i]);
+  g_free (aus);
+
+  return 0;
+}
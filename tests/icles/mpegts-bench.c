@@ -0,0 +1,523 @@
+/* GStreamer
+ *
+ * Copyright (C) 2026 agent <agent@local>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/* Measures the throughput of the MPEG-TS packetizer by pushing a stream
+ * generated in memory through tsparse or tsdemux.
+ *
+ * The stream has a PAT, a PMT with one video and one audio stream, and
+ * packets on a number of PIDs nobody asked for. The video stream has
+ * unbounded PES packets, with keyframes much larger than the other frames,
+ * and the audio stream small bounded ones. Every Nth packet can have its
+ * sync byte corrupted to measure resynchronization.
+ *
+ * Each element description given with -e is measured, by default tsparse
+ * and tsdemux collecting the PES packets with and without "pes-arena".
+ * Besides the throughput, the CPU time used per Gbit of input and, for
+ * tsdemux, the bytes copied per byte of PES payload are reported.
+ *
+ *   mpegts-bench [-e element]... [-n packets] [-p pids] [-m] [-c every]
+ *                [-g gop] [-k keyframe-size] [-f frame-size]
+ *                [-b buffer-size] [-r runs]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <gst/gst.h>
+#include <gst/app/gstappsrc.h>
+
+#define TS_PACKET_SIZE 188
+#define M2TS_PACKET_SIZE 192
+
+#define PMT_PID 0x1000
+#define VIDEO_PID 0x100
+#define AUDIO_PID 0x101
+#define FIRST_OTHER_PID 0x200
+
+#define AUDIO_FRAME_SIZE 1500
+
+/* Input bitrate the buffers are timestamped for, in bytes per second */
+#define INPUT_BYTE_RATE 2500000
+
+static guint32
+crc32_mpeg (const guint8 * data, guint len)
+{
+  guint32 crc = 0xffffffff;
+  guint i, j;
+
+  for (i = 0; i < len; i++) {
+    crc ^= (guint32) data[i] << 24;
+    for (j = 0; j < 8; j++)
+      crc = (crc & 0x80000000) ? (crc << 1) ^ 0x04c11db7 : crc << 1;
+  }
+
+  return crc;
+}
+
+static guint8 *
+write_header (guint8 * p, guint16 pid, gboolean pusi, guint8 * cc)
+{
+  p[0] = 0x47;
+  p[1] = (pusi ? 0x40 : 0) | (pid >> 8);
+  p[2] = pid & 0xff;
+  p[3] = 0x10 | (*cc & 0x0f);
+  (*cc)++;
+
+  return p + 4;
+}
+
+static void
+write_section (guint8 * p, guint16 pid, const guint8 * section, guint len,
+    guint8 * cc)
+{
+  guint32 crc;
+
+  p = write_header (p, pid, TRUE, cc);
+  memset (p, 0xff, TS_PACKET_SIZE - 4);
+  /* pointer_field */
+  *p++ = 0;
+  memcpy (p, section, len);
+  crc = crc32_mpeg (section, len);
+  GST_WRITE_UINT32_BE (p + len, crc);
+}
+
+static void
+write_pat (guint8 * p, guint8 * cc)
+{
+  static const guint8 pat[] = {
+    0x00, 0xb0, 0x0d, 0x00, 0x01, 0xc1, 0x00, 0x00,
+    0x00, 0x01, 0xe0 | (PMT_PID >> 8), PMT_PID & 0xff
+  };
+
+  write_section (p, 0, pat, sizeof (pat), cc);
+}
+
+static void
+write_pmt (guint8 * p, guint8 * cc)
+{
+  /* No PCR PID, the streams are timed from their PTS */
+  static const guint8 pmt[] = {
+    0x02, 0xb0, 0x17, 0x00, 0x01, 0xc1, 0x00, 0x00,
+    0xff, 0xff, 0xf0, 0x00,
+    0x1b, 0xe0 | (VIDEO_PID >> 8), VIDEO_PID & 0xff, 0xf0, 0x00,
+    0x0f, 0xe0 | (AUDIO_PID >> 8), AUDIO_PID & 0xff, 0xf0, 0x00
+  };
+
+  write_section (p, PMT_PID, pmt, sizeof (pmt), cc);
+}
+
+static void
+write_payload (guint8 * p, guint16 pid, guint8 * cc)
+{
+  p = write_header (p, pid, FALSE, cc);
+  memset (p, 0xaa, TS_PACKET_SIZE - 4);
+}
+
+typedef struct
+{
+  guint16 pid;
+  guint8 stream_id;
+  gboolean bounded;
+  guint8 cc;
+  guint frame;
+  /* Payload bytes of the current PES packet left to write */
+  gsize remaining;
+} EsWriter;
+
+typedef struct
+{
+  guint gop;
+  gsize keyframe_size;
+  gsize frame_size;
+} StreamParams;
+
+/* Writes the next packet of the elementary stream, starting a new PES
+ * packet after the previous one was completely written */
+static void
+write_es_packet (guint8 * p, EsWriter * es, const StreamParams * params)
+{
+  guint8 header[14];
+  guint header_size = 0, stuffing;
+  gboolean pusi = es->remaining == 0;
+  gsize payload;
+
+  if (pusi) {
+    guint64 pts;
+
+    if (es->bounded) {
+      es->remaining = AUDIO_FRAME_SIZE;
+      pts = 90000 + es->frame * 2880;
+    } else {
+      es->remaining = es->frame % params->gop == 0 ?
+          params->keyframe_size : params->frame_size;
+      pts = 90000 + es->frame * 3600;
+    }
+
+    header[0] = 0x00;
+    header[1] = 0x00;
+    header[2] = 0x01;
+    header[3] = es->stream_id;
+    GST_WRITE_UINT16_BE (header + 4, es->bounded ? es->remaining + 8 : 0);
+    header[6] = 0x80;
+    header[7] = 0x80;
+    header[8] = 0x05;
+    header[9] = 0x21 | ((pts >> 29) & 0x0e);
+    header[10] = (pts >> 22) & 0xff;
+    header[11] = ((pts >> 14) & 0xfe) | 0x01;
+    header[12] = (pts >> 7) & 0xff;
+    header[13] = ((pts << 1) & 0xfe) | 0x01;
+    header_size = sizeof (header);
+  }
+
+  payload = MIN (TS_PACKET_SIZE - 4 - header_size, es->remaining);
+  stuffing = TS_PACKET_SIZE - 4 - header_size - payload;
+
+  p = write_header (p, es->pid, pusi, &es->cc);
+  /* Adaptation field stuffing for the end of the PES packet */
+  if (stuffing) {
+    p[-1] |= 0x20;
+    p[0] = stuffing - 1;
+    if (stuffing > 1) {
+      p[1] = 0x00;
+      memset (p + 2, 0xff, stuffing - 2);
+    }
+    p += stuffing;
+  }
+
+  memcpy (p, header, header_size);
+  memset (p + header_size, 0xaa, payload);
+
+  es->remaining -= payload;
+  if (es->remaining == 0)
+    es->frame++;
+}
+
+/* Generates @n_packets packets. The PSI is repeated every 1000 packets,
+ * half of the remaining packets are elementary stream data and the other
+ * half is spread over @n_pids unwanted PIDs */
+static guint8 *
+generate_stream (guint n_packets, guint n_pids, gboolean m2ts,
+    guint corrupt_every, const StreamParams * params, gsize * size)
+{
+  EsWriter video = { VIDEO_PID, 0xe0, FALSE, 0, 0, 0 };
+  EsWriter audio = { AUDIO_PID, 0xc0, TRUE, 0, 0, 0 };
+  guint packet_size = m2ts ? M2TS_PACKET_SIZE : TS_PACKET_SIZE;
+  guint offset = m2ts ? 4 : 0;
+  guint8 *ccs = g_new0 (guint8, 0x2000);
+  guint8 *data, *p;
+  guint i;
+
+  *size = (gsize) n_packets * packet_size;
+  data = g_malloc (*size);
+
+  for (i = 0, p = data; i < n_packets; i++, p += packet_size) {
+    guint16 pid;
+
+    if (m2ts)
+      GST_WRITE_UINT32_BE (p, (i * 1000) & 0x3fffffff);
+
+    if (i % 1000 == 0) {
+      write_pat (p + offset, &ccs[0]);
+      continue;
+    } else if (i % 1000 == 1) {
+      write_pmt (p + offset, &ccs[PMT_PID]);
+      continue;
+    }
+
+    if (i % 2 == 0 || n_pids == 0) {
+      write_es_packet (p + offset, (i % 8 == 0) ? &audio : &video, params);
+    } else {
+      pid = FIRST_OTHER_PID + (i / 2) % n_pids;
+      write_payload (p + offset, pid, &ccs[pid]);
+    }
+
+    if (corrupt_every && i % corrupt_every == 0)
+      p[offset] = 0x00;
+  }
+
+  g_free (ccs);
+
+  return data;
+}
+
+typedef struct
+{
+  GMainLoop *loop;
+  gboolean error;
+} RunData;
+
+static gboolean
+bus_cb (GstBus * bus, GstMessage * msg, gpointer user_data)
+{
+  RunData *run = user_data;
+
+  switch (GST_MESSAGE_TYPE (msg)) {
+    case GST_MESSAGE_ERROR:{
+      GError *err = NULL;
+
+      gst_message_parse_error (msg, &err, NULL);
+      g_printerr ("ERROR: %s\n", err->message);
+      g_clear_error (&err);
+      run->error = TRUE;
+      g_main_loop_quit (run->loop);
+      break;
+    }
+    case GST_MESSAGE_EOS:
+      g_main_loop_quit (run->loop);
+      break;
+    default:
+      break;
+  }
+
+  return TRUE;
+}
+
+typedef struct
+{
+  gdouble seconds;
+  gdouble cpu_seconds;
+  /* 0 if the element doesn't collect PES packets */
+  guint64 pes_bytes;
+  guint64 pes_bytes_copied;
+} RunResult;
+
+static void
+pad_added_cb (GstElement * element, GstPad * pad, GstBin * pipeline)
+{
+  GstElement *sink = gst_element_factory_make ("fakesink", NULL);
+  GstPad *sinkpad;
+
+  g_object_set (sink, "sync", FALSE, NULL);
+  gst_bin_add (pipeline, sink);
+  gst_element_sync_state_with_parent (sink);
+
+  sinkpad = gst_element_get_static_pad (sink, "sink");
+  if (gst_pad_link (pad, sinkpad) != GST_PAD_LINK_OK)
+    g_printerr ("Failed to link %s\n", GST_PAD_NAME (pad));
+  gst_object_unref (sinkpad);
+}
+
+static gboolean
+run_once (const gchar * element, GBytes * stream, gsize buffer_size,
+    RunResult * result)
+{
+  GstElement *pipeline, *src, *e;
+  GstStructure *stats = NULL;
+  GstPad *srcpad;
+  GstBus *bus;
+  gchar *desc;
+  RunData run = { NULL, FALSE };
+  gsize size, offset;
+  gint64 start, end;
+  clock_t cpu_start, cpu_end;
+
+  desc = g_strdup_printf ("appsrc name=src format=time ! %s name=e", element);
+  pipeline = gst_parse_launch (desc, NULL);
+  g_free (desc);
+  if (!pipeline)
+    return FALSE;
+
+  /* tsparse has an always source pad, tsdemux one per elementary stream */
+  e = gst_bin_get_by_name (GST_BIN (pipeline), "e");
+  srcpad = gst_element_get_static_pad (e, "src");
+  if (srcpad) {
+    GstElement *sink = gst_element_factory_make ("fakesink", NULL);
+
+    g_object_set (sink, "sync", FALSE, NULL);
+    gst_bin_add (GST_BIN (pipeline), sink);
+    gst_element_link (e, sink);
+    gst_object_unref (srcpad);
+  } else {
+    g_signal_connect (e, "pad-added", G_CALLBACK (pad_added_cb), pipeline);
+  }
+
+  src = gst_bin_get_by_name (GST_BIN (pipeline), "src");
+  g_object_set (src, "max-bytes", G_GUINT64_CONSTANT (0), "block", FALSE,
+      NULL);
+
+  /* Queue all the data before starting the clock, timestamped like it was
+   * received live */
+  size = g_bytes_get_size (stream);
+  for (offset = 0; offset < size; offset += buffer_size) {
+    GBytes *chunk = g_bytes_new_from_bytes (stream, offset,
+        MIN (buffer_size, size - offset));
+    GstBuffer *buffer = gst_buffer_new_wrapped_bytes (chunk);
+
+    GST_BUFFER_PTS (buffer) = gst_util_uint64_scale (offset, GST_SECOND,
+        INPUT_BYTE_RATE);
+    gst_app_src_push_buffer (GST_APP_SRC (src), buffer);
+    g_bytes_unref (chunk);
+  }
+  gst_app_src_end_of_stream (GST_APP_SRC (src));
+  gst_object_unref (src);
+
+  run.loop = g_main_loop_new (NULL, FALSE);
+  bus = gst_element_get_bus (pipeline);
+  gst_bus_add_watch (bus, bus_cb, &run);
+
+  start = g_get_monotonic_time ();
+  cpu_start = clock ();
+  gst_element_set_state (pipeline, GST_STATE_PLAYING);
+  g_main_loop_run (run.loop);
+  cpu_end = clock ();
+  end = g_get_monotonic_time ();
+
+  result->seconds = (gdouble) (end - start) / G_USEC_PER_SEC;
+  result->cpu_seconds = (gdouble) (cpu_end - cpu_start) / CLOCKS_PER_SEC;
+  result->pes_bytes = result->pes_bytes_copied = 0;
+
+  g_object_get (e, "stats", &stats, NULL);
+  if (stats) {
+    gst_structure_get_uint64 (stats, "pes-bytes", &result->pes_bytes);
+    gst_structure_get_uint64 (stats, "pes-bytes-copied",
+        &result->pes_bytes_copied);
+    gst_structure_free (stats);
+  }
+  gst_object_unref (e);
+
+  gst_element_set_state (pipeline, GST_STATE_NULL);
+  gst_bus_remove_watch (bus);
+  gst_object_unref (bus);
+  gst_object_unref (pipeline);
+  g_main_loop_unref (run.loop);
+
+  return !run.error;
+}
+
+static void
+usage (const gchar * name)
+{
+  g_printerr ("usage: %s [-e element]... [-n packets] [-p pids] [-m] "
+      "[-c corrupt-every] [-g gop] [-k keyframe-size] [-f frame-size] "
+      "[-b buffer-size] [-r runs]\n", name);
+}
+
+int
+main (int argc, char **argv)
+{
+  static const gchar *default_elements[] = {
+    "tsparse", "tsdemux pes-arena=false", "tsdemux pes-arena=true", NULL
+  };
+  GPtrArray *elements = g_ptr_array_new ();
+  StreamParams params = { 50, 150000, 15000 };
+  guint n_packets = 1000000, n_pids = 16, corrupt_every = 0, runs = 5;
+  gsize buffer_size = 7 * TS_PACKET_SIZE * 64;
+  gboolean m2ts = FALSE;
+  GBytes *stream;
+  guint8 *data;
+  gsize size;
+  guint e, i;
+  int opt;
+
+  gst_init (&argc, &argv);
+
+  while ((opt = getopt (argc, argv, "e:n:p:mc:g:k:f:b:r:h")) != -1) {
+    switch (opt) {
+      case 'e':
+        g_ptr_array_add (elements, optarg);
+        break;
+      case 'n':
+        n_packets = atoi (optarg);
+        break;
+      case 'p':
+        n_pids = atoi (optarg);
+        break;
+      case 'm':
+        m2ts = TRUE;
+        break;
+      case 'c':
+        corrupt_every = atoi (optarg);
+        break;
+      case 'g':
+        params.gop = atoi (optarg);
+        break;
+      case 'k':
+        params.keyframe_size = atoi (optarg);
+        break;
+      case 'f':
+        params.frame_size = atoi (optarg);
+        break;
+      case 'b':
+        buffer_size = atoi (optarg);
+        break;
+      case 'r':
+        runs = atoi (optarg);
+        break;
+      default:
+        usage (argv[0]);
+        return 1;
+    }
+  }
+
+  if (n_packets < 2 || buffer_size == 0 || runs == 0 || params.gop == 0 ||
+      params.keyframe_size == 0 || params.frame_size == 0) {
+    usage (argv[0]);
+    return 1;
+  }
+
+  if (elements->len == 0) {
+    for (i = 0; default_elements[i]; i++)
+      g_ptr_array_add (elements, (gpointer) default_elements[i]);
+  }
+
+  data = generate_stream (n_packets, n_pids, m2ts, corrupt_every, &params,
+      &size);
+  stream = g_bytes_new_take (data, size);
+
+  printf ("%u packets, %u pids, m2ts %s, corrupt every %u, gop %u, "
+      "frames of %" G_GSIZE_FORMAT "/%" G_GSIZE_FORMAT " bytes\n", n_packets,
+      n_pids, m2ts ? "yes" : "no", corrupt_every, params.gop,
+      params.keyframe_size, params.frame_size);
+  printf ("  %-26s %10s %10s %12s %14s\n", "element", "seconds", "MB/s",
+      "cpu s/Gbit", "copied/byte");
+
+  for (e = 0; e < elements->len; e++) {
+    const gchar *element = g_ptr_array_index (elements, e);
+    RunResult best = { -1, };
+
+    for (i = 0; i < runs; i++) {
+      RunResult result;
+
+      if (!run_once (element, stream, buffer_size, &result)) {
+        g_bytes_unref (stream);
+        g_ptr_array_unref (elements);
+        return 1;
+      }
+      if (best.seconds < 0 || result.seconds < best.seconds)
+        best = result;
+    }
+
+    printf ("  %-26s %10.3f %10.1f %12.3f", element, best.seconds,
+        size / best.seconds / (1024 * 1024),
+        best.cpu_seconds / (size * 8 / 1e9));
+    if (best.pes_bytes)
+      printf (" %14.3f\n", (gdouble) best.pes_bytes_copied / best.pes_bytes);
+    else
+      printf (" %14s\n", "-");
+  }
+
+  g_bytes_unref (stream);
+  g_ptr_array_unref (elements);
+
+  return 0;
+}
@@ -0,0 +1,715 @@
+/* GStreamer
+ *
+ * Copyright (C) 2026 agent <agent@local>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/* Measures the throughput of the start code scanners of the codec parsers
+ * library, and of the NAL/packet identification functions built on them.
+ * Then measures the parse rate of the parameter sets and slice headers,
+ * which is bound by the NAL reader. nalutils-bench-legacy is the same
+ * program with the NAL reader as it was before it cached a word at a time,
+ * so comparing the output of both gives the before/after parse rates.
+ *
+ * The bitstreams are Annex B H.264/H.265 or MPEG-1/2 video elementary
+ * streams read from the files given on the command line, the headers of
+ * which are parsed as -c codec. Without files, a synthetic stream of NAL
+ * units of random data is generated for the scanners, and a synthetic
+ * 1080p H.264 stream of -p pictures of -l slices for the headers.
+ *
+ *   nalutils-bench [-s size-mb] [-n nal-size] [-z zero-percent] [-r runs]
+ *                  [-c h264|h265] [-p pictures] [-l slices] [file...]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <gst/gst.h>
+#include <gst/base/gstbytereader.h>
+#include <gst/codecparsers/nalutils.h>
+#include <gst/codecparsers/gsth264parser.h>
+#include <gst/codecparsers/gsth265parser.h>
+#include <gst/codecparsers/gstmpegvideoparser.h>
+
+#ifdef NALUTILS_BENCH_LEGACY_READER
+#define NAL_READER_NAME "legacy, a byte at a time"
+#else
+#define NAL_READER_NAME "word cache"
+#endif
+
+/* Each kind of header is parsed over and over until at least that many
+ * were parsed, as streams have few parameter sets */
+#define MIN_HEADERS 200000
+
+/* Payload of the synthetic slices */
+#define SLICE_DATA_SIZE 512
+
+typedef guint (*BenchFunc) (const guint8 * data, gsize size);
+
+/* What the scanners used before, for reference */
+static guint
+bench_byte_reader (const guint8 * data, gsize size)
+{
+  GstByteReader br;
+  guint n = 0, pos = 0;
+
+  while (pos < size) {
+    gint off;
+
+    gst_byte_reader_init (&br, data + pos, size - pos);
+    off = gst_byte_reader_masked_scan_uint32 (&br, 0xffffff00, 0x00000100,
+        0, size - pos);
+    if (off < 0)
+      break;
+    pos += off + 3;
+    n++;
+  }
+
+  return n;
+}
+
+static guint
+bench_scan (const guint8 * data, gsize size)
+{
+  guint n = 0, pos = 0;
+
+  while (pos < size) {
+    gint off = scan_for_start_codes (data + pos, size - pos);
+
+    if (off < 0)
+      break;
+    pos += off + 3;
+    n++;
+  }
+
+  return n;
+}
+
+static guint
+bench_scan_all (const guint8 * data, gsize size)
+{
+  guint offsets[256];
+  guint n = 0, pos = 0, found;
+
+  do {
+    found = scan_for_all_start_codes (data + pos, size - pos, offsets,
+        G_N_ELEMENTS (offsets));
+    if (found)
+      pos += offsets[found - 1] + 3;
+    n += found;
+  } while (found == G_N_ELEMENTS (offsets));
+
+  return n;
+}
+
+static guint
+bench_h264 (const guint8 * data, gsize size)
+{
+  GstH264NalParser *parser = gst_h264_nal_parser_new ();
+  GstH264NalUnit nalu;
+  guint n = 0, offset = 0;
+
+  while (gst_h264_parser_identify_nalu (parser, data, offset, size,
+          &nalu) == GST_H264_PARSER_OK) {
+    offset = nalu.offset + nalu.size;
+    n++;
+  }
+  gst_h264_nal_parser_free (parser);
+
+  return n;
+}
+
+static guint
+bench_h265 (const guint8 * data, gsize size)
+{
+  GstH265Parser *parser = gst_h265_parser_new ();
+  GstH265NalUnit nalu;
+  guint n = 0, offset = 0;
+
+  while (gst_h265_parser_identify_nalu (parser, data, offset, size,
+          &nalu) == GST_H265_PARSER_OK) {
+    offset = nalu.offset + nalu.size;
+    n++;
+  }
+  gst_h265_parser_free (parser);
+
+  return n;
+}
+
+static guint
+bench_mpeg_video (const guint8 * data, gsize size)
+{
+  GstMpegVideoPacket packet;
+  guint n = 0, offset = 0;
+
+  while (gst_mpeg_video_parse (&packet, data, size, offset)) {
+    n++;
+    if (packet.size < 0)
+      break;
+    offset = packet.offset + packet.size;
+  }
+
+  return n;
+}
+
+static const struct
+{
+  const gchar *name;
+  BenchFunc func;
+} benches[] = {
+  {"byte-reader", bench_byte_reader},
+  {"scan", bench_scan},
+  {"scan-all", bench_scan_all},
+  {"h264-identify", bench_h264},
+  {"h265-identify", bench_h265},
+  {"mpeg-video-parse", bench_mpeg_video},
+};
+
+/* NAL units of @nal_size bytes of random data, @zero_percent of which are
+ * zero bytes. Emulation prevention bytes are inserted like an encoder
+ * would, so that the only start codes are the ones of the NAL units */
+static guint8 *
+generate_stream (gsize size, guint nal_size, guint zero_percent,
+    gsize * out_size)
+{
+  GRand *rand = g_rand_new_with_seed (42);
+  guint8 *data = g_malloc (size + 16);
+  gsize pos = 0;
+
+  while (pos + 5 < size) {
+    guint zeros = 0, i;
+
+    data[pos++] = 0x00;
+    data[pos++] = 0x00;
+    data[pos++] = 0x01;
+    /* non-IDR slice, for both H.264 and H.265 this is a valid header */
+    data[pos++] = 0x02;
+    data[pos++] = 0x01;
+
+    for (i = 0; i < nal_size && pos < size; i++) {
+      guint8 b;
+
+      if (g_rand_int_range (rand, 0, 100) < (gint) zero_percent)
+        b = 0x00;
+      else
+        b = g_rand_int_range (rand, 1, 256);
+
+      if (zeros >= 2 && b <= 0x03) {
+        data[pos++] = 0x03;
+        zeros = 0;
+        if (pos >= size)
+          break;
+      }
+
+      data[pos++] = b;
+      zeros = b ? 0 : zeros + 1;
+    }
+
+    /* NAL units don't end with a zero byte */
+    if (data[pos - 1] == 0x00)
+      data[pos - 1] = 0x80;
+  }
+
+  g_rand_free (rand);
+  *out_size = pos;
+
+  return data;
+}
+
+static void
+run_benches (const gchar * name, const guint8 * data, gsize size, guint runs)
+{
+  guint i, r;
+
+  printf ("%s: %" G_GSIZE_FORMAT " bytes\n", name, size);
+  printf ("  %-18s %10s %10s\n", "function", "units", "MB/s");
+
+  for (i = 0; i < G_N_ELEMENTS (benches); i++) {
+    gint64 best = G_MAXINT64;
+    guint n = 0;
+
+    for (r = 0; r < runs; r++) {
+      gint64 start = g_get_monotonic_time ();
+
+      n = benches[i].func (data, size);
+      best = MIN (best, g_get_monotonic_time () - start);
+    }
+
+    printf ("  %-18s %10u %10.1f\n", benches[i].name, n,
+        best > 0 ? (gdouble) size / best : 0.0);
+  }
+}
+
+enum
+{
+  HEADER_VPS,
+  HEADER_SPS,
+  HEADER_PPS,
+  HEADER_SLICE,
+  N_HEADERS
+};
+
+static const gchar *header_names[N_HEADERS] = {
+  "vps", "sps", "pps", "slice-header"
+};
+
+typedef gboolean (*ParseFunc) (gpointer parser, gpointer nalu);
+
+static gboolean
+parse_h264_header (GstH264NalParser * parser, GstH264NalUnit * nalu)
+{
+  GstH264ParserResult res;
+
+  switch (nalu->type) {
+    case GST_H264_NAL_SPS:{
+      GstH264SPS sps;
+
+      res = gst_h264_parser_parse_sps (parser, nalu, &sps);
+      if (res == GST_H264_PARSER_OK)
+        gst_h264_sps_clear (&sps);
+      break;
+    }
+    case GST_H264_NAL_PPS:{
+      GstH264PPS pps;
+
+      res = gst_h264_parser_parse_pps (parser, nalu, &pps);
+      if (res == GST_H264_PARSER_OK)
+        gst_h264_pps_clear (&pps);
+      break;
+    }
+    default:{
+      GstH264SliceHdr slice;
+
+      res = gst_h264_parser_parse_slice_hdr (parser, nalu, &slice, TRUE,
+          TRUE);
+      break;
+    }
+  }
+
+  return res == GST_H264_PARSER_OK;
+}
+
+static gboolean
+parse_h265_header (GstH265Parser * parser, GstH265NalUnit * nalu)
+{
+  GstH265ParserResult res;
+
+  switch (nalu->type) {
+    case GST_H265_NAL_VPS:{
+      GstH265VPS vps;
+
+      res = gst_h265_parser_parse_vps (parser, nalu, &vps);
+      break;
+    }
+    case GST_H265_NAL_SPS:{
+      GstH265SPS sps;
+
+      res = gst_h265_parser_parse_sps (parser, nalu, &sps, TRUE);
+      break;
+    }
+    case GST_H265_NAL_PPS:{
+      GstH265PPS pps;
+
+      res = gst_h265_parser_parse_pps (parser, nalu, &pps);
+      break;
+    }
+    default:{
+      GstH265SliceHdr slice;
+
+      res = gst_h265_parser_parse_slice_hdr (parser, nalu, &slice);
+      if (res == GST_H265_PARSER_OK)
+        gst_h265_slice_hdr_free (&slice);
+      break;
+    }
+  }
+
+  return res == GST_H265_PARSER_OK;
+}
+
+/* Times the parsing of each kind of header of @nalus, which the parameter
+ * sets of the stream were already parsed into @parser */
+static void
+run_header_benches (gpointer parser, ParseFunc parse, GArray ** nalus,
+    guint runs)
+{
+  guint k, r, i;
+
+  printf ("  %-18s %10s %10s %10s %10s\n", "header", "count", "failed",
+      "ns/header", "k/s");
+
+  for (k = 0; k < N_HEADERS; k++) {
+    guint elt_size = g_array_get_element_size (nalus[k]);
+    gint64 best = G_MAXINT64;
+    guint n = 0, failed = 0;
+
+    if (nalus[k]->len == 0)
+      continue;
+
+    for (r = 0; r < runs; r++) {
+      gint64 start = g_get_monotonic_time ();
+
+      n = failed = 0;
+      while (n < MIN_HEADERS) {
+        for (i = 0; i < nalus[k]->len; i++) {
+          if (!parse (parser, nalus[k]->data + i * elt_size))
+            failed++;
+        }
+        n += nalus[k]->len;
+      }
+      best = MIN (best, g_get_monotonic_time () - start);
+    }
+
+    printf ("  %-18s %10u %10u %10.1f %10.1f\n", header_names[k],
+        nalus[k]->len, failed / (n / nalus[k]->len),
+        (gdouble) best * 1000 / n, best > 0 ? (gdouble) n * 1000 / best : 0.0);
+  }
+}
+
+static void
+run_h264_header_benches (const guint8 * data, gsize size, guint runs)
+{
+  GstH264NalParser *parser = gst_h264_nal_parser_new ();
+  GstH264ParserResult res;
+  GstH264NalUnit nalu;
+  GArray *nalus[N_HEADERS];
+  guint offset = 0, k;
+
+  for (k = 0; k < N_HEADERS; k++)
+    nalus[k] = g_array_new (FALSE, FALSE, sizeof (GstH264NalUnit));
+
+  do {
+    res = gst_h264_parser_identify_nalu (parser, data, offset, size, &nalu);
+    if (res != GST_H264_PARSER_OK && res != GST_H264_PARSER_NO_NAL_END)
+      break;
+    offset = nalu.offset + nalu.size;
+
+    switch (nalu.type) {
+      case GST_H264_NAL_SPS:
+        k = HEADER_SPS;
+        break;
+      case GST_H264_NAL_PPS:
+        k = HEADER_PPS;
+        break;
+      case GST_H264_NAL_SLICE:
+      case GST_H264_NAL_SLICE_IDR:
+        k = HEADER_SLICE;
+        break;
+      default:
+        continue;
+    }
+
+    /* The slice headers refer to the parameter sets */
+    if (k != HEADER_SLICE)
+      parse_h264_header (parser, &nalu);
+    g_array_append_val (nalus[k], nalu);
+  } while (res == GST_H264_PARSER_OK);
+
+  run_header_benches (parser, (ParseFunc) parse_h264_header, nalus, runs);
+
+  for (k = 0; k < N_HEADERS; k++)
+    g_array_unref (nalus[k]);
+  gst_h264_nal_parser_free (parser);
+}
+
+static void
+run_h265_header_benches (const guint8 * data, gsize size, guint runs)
+{
+  GstH265Parser *parser = gst_h265_parser_new ();
+  GstH265ParserResult res;
+  GstH265NalUnit nalu;
+  GArray *nalus[N_HEADERS];
+  guint offset = 0, k;
+
+  for (k = 0; k < N_HEADERS; k++)
+    nalus[k] = g_array_new (FALSE, FALSE, sizeof (GstH265NalUnit));
+
+  do {
+    res = gst_h265_parser_identify_nalu (parser, data, offset, size, &nalu);
+    if (res != GST_H265_PARSER_OK && res != GST_H265_PARSER_NO_NAL_END)
+      break;
+    offset = nalu.offset + nalu.size;
+
+    if (nalu.type == GST_H265_NAL_VPS)
+      k = HEADER_VPS;
+    else if (nalu.type == GST_H265_NAL_SPS)
+      k = HEADER_SPS;
+    else if (nalu.type == GST_H265_NAL_PPS)
+      k = HEADER_PPS;
+    else if (nalu.type <= GST_H265_NAL_SLICE_CRA_NUT)
+      k = HEADER_SLICE;
+    else
+      continue;
+
+    if (k != HEADER_SLICE)
+      parse_h265_header (parser, &nalu);
+    g_array_append_val (nalus[k], nalu);
+  } while (res == GST_H265_PARSER_OK);
+
+  run_header_benches (parser, (ParseFunc) parse_h265_header, nalus, runs);
+
+  for (k = 0; k < N_HEADERS; k++)
+    g_array_unref (nalus[k]);
+  gst_h265_parser_free (parser);
+}
+
+static void
+append_nal (GByteArray * stream, NalWriter * nw)
+{
+  GstMemory *mem;
+  GstMapInfo map;
+
+  nal_writer_do_rbsp_trailing_bits (nw);
+  mem = nal_writer_reset_and_get_memory (nw);
+  gst_memory_map (mem, &map, GST_MAP_READ);
+  g_byte_array_append (stream, map.data, map.size);
+  gst_memory_unmap (mem, &map);
+  gst_memory_unref (mem);
+}
+
+static void
+put_se (NalWriter * nw, gint32 value)
+{
+  nal_writer_put_ue (nw, value > 0 ? 2 * value - 1 : -2 * value);
+}
+
+/* SPS and PPS of a 1080p High profile stream with CABAC, like most
+ * encoders produce */
+static void
+append_h264_parameter_sets (GByteArray * stream)
+{
+  NalWriter nw;
+
+  nal_writer_init (&nw, 4, FALSE);
+  nal_writer_put_bits_uint8 (&nw, 0x67, 8);     /* nal_ref_idc 3, SPS */
+  nal_writer_put_bits_uint8 (&nw, 100, 8);      /* profile_idc */
+  nal_writer_put_bits_uint8 (&nw, 0, 8);        /* constraint_set flags */
+  nal_writer_put_bits_uint8 (&nw, 40, 8);       /* level_idc */
+  nal_writer_put_ue (&nw, 0);   /* seq_parameter_set_id */
+  nal_writer_put_ue (&nw, 1);   /* chroma_format_idc */
+  nal_writer_put_ue (&nw, 0);   /* bit_depth_luma_minus8 */
+  nal_writer_put_ue (&nw, 0);   /* bit_depth_chroma_minus8 */
+  nal_writer_put_bits_uint8 (&nw, 0, 1);        /* qpprime_y_zero_transform_bypass_flag */
+  nal_writer_put_bits_uint8 (&nw, 0, 1);        /* seq_scaling_matrix_present_flag */
+  nal_writer_put_ue (&nw, 4);   /* log2_max_frame_num_minus4 */
+  nal_writer_put_ue (&nw, 0);   /* pic_order_cnt_type */
+  nal_writer_put_ue (&nw, 4);   /* log2_max_pic_order_cnt_lsb_minus4 */
+  nal_writer_put_ue (&nw, 4);   /* max_num_ref_frames */
+  nal_writer_put_bits_uint8 (&nw, 0, 1);        /* gaps_in_frame_num_value_allowed_flag */
+  nal_writer_put_ue (&nw, 119); /* pic_width_in_mbs_minus1 */
+  nal_writer_put_ue (&nw, 67);  /* pic_height_in_map_units_minus1 */
+  nal_writer_put_bits_uint8 (&nw, 1, 1);        /* frame_mbs_only_flag */
+  nal_writer_put_bits_uint8 (&nw, 1, 1);        /* direct_8x8_inference_flag */
+  nal_writer_put_bits_uint8 (&nw, 1, 1);        /* frame_cropping_flag */
+  nal_writer_put_ue (&nw, 0);   /* frame_crop_left_offset */
+  nal_writer_put_ue (&nw, 0);   /* frame_crop_right_offset */
+  nal_writer_put_ue (&nw, 0);   /* frame_crop_top_offset */
+  nal_writer_put_ue (&nw, 4);   /* frame_crop_bottom_offset */
+  nal_writer_put_bits_uint8 (&nw, 0, 1);        /* vui_parameters_present_flag */
+  append_nal (stream, &nw);
+
+  nal_writer_init (&nw, 4, FALSE);
+  nal_writer_put_bits_uint8 (&nw, 0x68, 8);     /* nal_ref_idc 3, PPS */
+  nal_writer_put_ue (&nw, 0);   /* pic_parameter_set_id */
+  nal_writer_put_ue (&nw, 0);   /* seq_parameter_set_id */
+  nal_writer_put_bits_uint8 (&nw, 1, 1);        /* entropy_coding_mode_flag */
+  nal_writer_put_bits_uint8 (&nw, 0, 1);        /* bottom_field_pic_order_in_frame_present_flag */
+  nal_writer_put_ue (&nw, 0);   /* num_slice_groups_minus1 */
+  nal_writer_put_ue (&nw, 2);   /* num_ref_idx_l0_default_active_minus1 */
+  nal_writer_put_ue (&nw, 0);   /* num_ref_idx_l1_default_active_minus1 */
+  nal_writer_put_bits_uint8 (&nw, 0, 1);        /* weighted_pred_flag */
+  nal_writer_put_bits_uint8 (&nw, 0, 2);        /* weighted_bipred_idc */
+  put_se (&nw, 0);              /* pic_init_qp_minus26 */
+  put_se (&nw, 0);              /* pic_init_qs_minus26 */
+  put_se (&nw, -2);             /* chroma_qp_index_offset */
+  nal_writer_put_bits_uint8 (&nw, 1, 1);        /* deblocking_filter_control_present_flag */
+  nal_writer_put_bits_uint8 (&nw, 0, 1);        /* constrained_intra_pred_flag */
+  nal_writer_put_bits_uint8 (&nw, 0, 1);        /* redundant_pic_cnt_present_flag */
+  nal_writer_put_bits_uint8 (&nw, 1, 1);        /* transform_8x8_mode_flag */
+  nal_writer_put_bits_uint8 (&nw, 0, 1);        /* pic_scaling_matrix_present_flag */
+  put_se (&nw, -2);             /* second_chroma_qp_index_offset */
+  append_nal (stream, &nw);
+}
+
+static void
+append_h264_slice (GByteArray * stream, GRand * rand, guint picture,
+    guint first_mb, gboolean idr)
+{
+  guint8 data[SLICE_DATA_SIZE];
+  NalWriter nw;
+  guint i;
+
+  nal_writer_init (&nw, 4, FALSE);
+  /* nal_ref_idc 3 and IDR, or nal_ref_idc 2 and non-IDR slice */
+  nal_writer_put_bits_uint8 (&nw, idr ? 0x65 : 0x41, 8);
+  nal_writer_put_ue (&nw, first_mb);    /* first_mb_in_slice */
+  nal_writer_put_ue (&nw, idr ? 7 : 5); /* slice_type: all I or all P */
+  nal_writer_put_ue (&nw, 0);   /* pic_parameter_set_id */
+  nal_writer_put_bits_uint8 (&nw, picture, 8);  /* frame_num */
+  if (idr)
+    nal_writer_put_ue (&nw, picture & 1);       /* idr_pic_id */
+  nal_writer_put_bits_uint8 (&nw, 2 * picture, 8);      /* pic_order_cnt_lsb */
+  if (!idr) {
+    nal_writer_put_bits_uint8 (&nw, 0, 1);      /* num_ref_idx_active_override_flag */
+    nal_writer_put_bits_uint8 (&nw, 0, 1);      /* ref_pic_list_modification_flag_l0 */
+  }
+  /* dec_ref_pic_marking () */
+  if (idr) {
+    nal_writer_put_bits_uint8 (&nw, 0, 1);      /* no_output_of_prior_pics_flag */
+    nal_writer_put_bits_uint8 (&nw, 0, 1);      /* long_term_reference_flag */
+  } else {
+    nal_writer_put_bits_uint8 (&nw, 0, 1);      /* adaptive_ref_pic_marking_mode_flag */
+    nal_writer_put_ue (&nw, 0); /* cabac_init_idc */
+  }
+  put_se (&nw, g_rand_int_range (rand, -4, 5)); /* slice_qp_delta */
+  nal_writer_put_ue (&nw, 0);   /* disable_deblocking_filter_idc */
+  put_se (&nw, 0);              /* slice_alpha_c0_offset_div2 */
+  put_se (&nw, 0);              /* slice_beta_offset_div2 */
+
+  /* cabac_alignment_one_bit, then the slice data */
+  while (GST_BIT_WRITER_BIT_SIZE (&nw.bw) % 8)
+    nal_writer_put_bits_uint8 (&nw, 1, 1);
+  for (i = 0; i < SLICE_DATA_SIZE; i++)
+    data[i] = g_rand_int_range (rand, 0, 64) ? g_rand_int (rand) : 0x00;
+  nal_writer_put_bytes (&nw, data, SLICE_DATA_SIZE);
+  append_nal (stream, &nw);
+}
+
+/* Pictures of @n_slices slices, in GOPs of 30 starting with the parameter
+ * sets and an IDR picture */
+static guint8 *
+generate_h264_stream (guint n_pictures, guint n_slices, gsize * out_size)
+{
+  GByteArray *stream = g_byte_array_new ();
+  GRand *rand = g_rand_new_with_seed (42);
+  guint mbs_per_slice = 120 * 68 / n_slices, p, s;
+
+  for (p = 0; p < n_pictures; p++) {
+    gboolean idr = p % 30 == 0;
+
+    if (idr)
+      append_h264_parameter_sets (stream);
+    for (s = 0; s < n_slices; s++)
+      append_h264_slice (stream, rand, p % 30, s * mbs_per_slice, idr);
+  }
+
+  g_rand_free (rand);
+  *out_size = stream->len;
+
+  return g_byte_array_free (stream, FALSE);
+}
+
+static void
+usage (const gchar * name)
+{
+  g_printerr ("usage: %s [-s size-mb] [-n nal-size] [-z zero-percent] "
+      "[-r runs] [-c h264|h265] [-p pictures] [-l slices] [file...]\n",
+      name);
+}
+
+int
+main (int argc, char **argv)
+{
+  guint size_mb = 64, nal_size = 100000, zero_percent = 1, runs = 5;
+  guint n_pictures = 1000, n_slices = 8;
+  gboolean h265 = FALSE;
+  int opt, i;
+
+  gst_init (&argc, &argv);
+
+  while ((opt = getopt (argc, argv, "s:n:z:r:c:p:l:h")) != -1) {
+    switch (opt) {
+      case 's':
+        size_mb = atoi (optarg);
+        break;
+      case 'n':
+        nal_size = atoi (optarg);
+        break;
+      case 'z':
+        zero_percent = atoi (optarg);
+        break;
+      case 'r':
+        runs = atoi (optarg);
+        break;
+      case 'c':
+        if (g_strcmp0 (optarg, "h264") && g_strcmp0 (optarg, "h265")) {
+          usage (argv[0]);
+          return 1;
+        }
+        h265 = !g_strcmp0 (optarg, "h265");
+        break;
+      case 'p':
+        n_pictures = atoi (optarg);
+        break;
+      case 'l':
+        n_slices = atoi (optarg);
+        break;
+      default:
+        usage (argv[0]);
+        return 1;
+    }
+  }
+
+  if (size_mb == 0 || runs == 0 || zero_percent > 100 || n_pictures == 0 ||
+      n_slices == 0 || n_slices > 120 * 68) {
+    usage (argv[0]);
+    return 1;
+  }
+
+  printf ("NAL reader: %s\n", NAL_READER_NAME);
+
+  if (optind == argc) {
+    gchar *name;
+    guint8 *data;
+    gsize size;
+
+    data = generate_stream ((gsize) size_mb * 1024 * 1024, nal_size,
+        zero_percent, &size);
+    name = g_strdup_printf ("synthetic, %u byte NAL units, %u%% zeros",
+        nal_size, zero_percent);
+    run_benches (name, data, size, runs);
+    g_free (name);
+    g_free (data);
+
+    data = generate_h264_stream (n_pictures, n_slices, &size);
+    printf ("synthetic H.264, %u pictures of %u slices: %" G_GSIZE_FORMAT
+        " bytes\n", n_pictures, n_slices, size);
+    run_h264_header_benches (data, size, runs);
+    g_free (data);
+  }
+
+  for (i = optind; i < argc; i++) {
+    GError *err = NULL;
+    gchar *data;
+    gsize size;
+
+    if (!g_file_get_contents (argv[i], &data, &size, &err)) {
+      g_printerr ("%s\n", err->message);
+      g_clear_error (&err);
+      return 1;
+    }
+    run_benches (argv[i], (const guint8 *) data, size, runs);
+    if (h265)
+      run_h265_header_benches ((const guint8 *) data, size, runs);
+    else
+      run_h264_header_benches ((const guint8 *) data, size, runs);
+    g_free (data);
+  }
+
+  return 0;
+}
@@ -0,0 +1,229 @@
+/* GStreamer
+ *
+ * Copyright (C) 2026 agent <agent@local>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/* Measures the cost of serializing outgoing RTMP messages into chunks.
+ *
+ * "buffers" is the serialization rtmp2 used before: one buffer per chunk,
+ * appended into one buffer for the whole message and mapped for writing,
+ * which copies the message when it has more than 16 memories. "vectors" is
+ * what is written to sockets now, and "vectors, coalesced" what is written
+ * to the streams that cannot write vectors, like the TLS ones.
+ *
+ *   rtmp2-chunk-bench [-s message-size] [-c chunk-size] [-m memories]
+ *                     [-n messages] [-r runs]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <gst/gst.h>
+
+#include "rtmp/rtmpchunkstream.h"
+#include "rtmp/rtmpmessage.h"
+
+#define CHUNK_STREAM_ID 4
+
+typedef gsize (*BenchFunc) (GstRtmpChunkStream * cstream, GstBuffer * message,
+    guint32 chunk_size);
+
+static gsize
+bench_buffers (GstRtmpChunkStream * cstream, GstBuffer * message,
+    guint32 chunk_size)
+{
+  GstBuffer *outbuf, *nextbuf;
+  GstMapInfo map;
+  gsize size;
+
+  outbuf = gst_rtmp_chunk_stream_serialize_start (cstream, message,
+      chunk_size);
+  while ((nextbuf = gst_rtmp_chunk_stream_serialize_next (cstream,
+              chunk_size)))
+    outbuf = gst_buffer_append (outbuf, nextbuf);
+
+  if (!gst_buffer_map (outbuf, &map, GST_MAP_READ))
+    g_error ("Failed to map the chunks");
+  size = map.size;
+  gst_buffer_unmap (outbuf, &map);
+  gst_buffer_unref (outbuf);
+
+  return size;
+}
+
+static gsize
+bench_vectors (GstRtmpChunkStream * cstream, GstBuffer * message,
+    guint32 chunk_size)
+{
+  GstRtmpChunkVectors *chunks;
+  gsize size;
+
+  chunks = gst_rtmp_chunk_stream_serialize_vectors (cstream, message,
+      chunk_size);
+  if (!chunks)
+    g_error ("Failed to serialize the message");
+  size = chunks->size;
+  gst_rtmp_chunk_vectors_free (chunks);
+
+  return size;
+}
+
+/* Same copy as gst_rtmp_output_stream_write_all_chunks_async() */
+static gsize
+bench_vectors_coalesced (GstRtmpChunkStream * cstream, GstBuffer * message,
+    guint32 chunk_size)
+{
+  GstRtmpChunkVectors *chunks;
+  guint8 *data;
+  gsize i, offset = 0;
+
+  chunks = gst_rtmp_chunk_stream_serialize_vectors (cstream, message,
+      chunk_size);
+  if (!chunks)
+    g_error ("Failed to serialize the message");
+
+  data = g_malloc (chunks->size);
+  for (i = 0; i < chunks->n_vectors; i++) {
+    memcpy (data + offset, chunks->vectors[i].buffer, chunks->vectors[i].size);
+    offset += chunks->vectors[i].size;
+  }
+  g_free (data);
+  gst_rtmp_chunk_vectors_free (chunks);
+
+  return offset;
+}
+
+static const struct
+{
+  const gchar *name;
+  BenchFunc func;
+} benches[] = {
+  {"buffers", bench_buffers},
+  {"vectors", bench_vectors},
+  {"vectors, coalesced", bench_vectors_coalesced},
+};
+
+/* Like the video messages of rtmp2sink: the FLV tag header and the frame,
+ * in as many memories as the encoder produced */
+static GstBuffer *
+create_message (gsize size, guint n_memories, guint index)
+{
+  GstBuffer *message = gst_rtmp_message_new (GST_RTMP_MESSAGE_TYPE_VIDEO,
+      CHUNK_STREAM_ID, 1);
+  gsize offset = 0;
+  guint i;
+
+  for (i = 0; i < n_memories; i++) {
+    gsize part = (size - offset) / (n_memories - i);
+    guint8 *data = g_malloc (part);
+
+    memset (data, i, part);
+    gst_buffer_append_memory (message,
+        gst_memory_new_wrapped (0, data, part, 0, part, data, g_free));
+    offset += part;
+  }
+
+  GST_BUFFER_DTS (message) = index * 40 * GST_MSECOND;
+
+  return message;
+}
+
+static void
+usage (const gchar * name)
+{
+  g_printerr ("usage: %s [-s message-size] [-c chunk-size] [-m memories] "
+      "[-n messages] [-r runs]\n", name);
+}
+
+int
+main (int argc, char **argv)
+{
+  guint message_size = 100000, chunk_size = 4096, n_memories = 4;
+  guint n_messages = 1000, runs = 5, i, r, m;
+  GstBuffer **messages;
+  int opt;
+
+  gst_init (&argc, &argv);
+
+  while ((opt = getopt (argc, argv, "s:c:m:n:r:h")) != -1) {
+    switch (opt) {
+      case 's':
+        message_size = atoi (optarg);
+        break;
+      case 'c':
+        chunk_size = atoi (optarg);
+        break;
+      case 'm':
+        n_memories = atoi (optarg);
+        break;
+      case 'n':
+        n_messages = atoi (optarg);
+        break;
+      case 'r':
+        runs = atoi (optarg);
+        break;
+      default:
+        usage (argv[0]);
+        return 1;
+    }
+  }
+
+  if (message_size == 0 || chunk_size == 0 || n_memories == 0 ||
+      n_messages == 0 || runs == 0) {
+    usage (argv[0]);
+    return 1;
+  }
+
+  messages = g_new (GstBuffer *, n_messages);
+  for (m = 0; m < n_messages; m++)
+    messages[m] = create_message (message_size, n_memories, m);
+
+  printf ("%u messages of %u bytes in %u memories, %u byte chunks\n",
+      n_messages, message_size, n_memories, chunk_size);
+  printf ("  %-20s %12s %10s\n", "serialization", "usec", "MB/s");
+
+  for (i = 0; i < G_N_ELEMENTS (benches); i++) {
+    gint64 best = G_MAXINT64;
+    gsize total = 0;
+
+    for (r = 0; r < runs; r++) {
+      GstRtmpChunkStreams *cstreams = gst_rtmp_chunk_streams_new ();
+      GstRtmpChunkStream *cstream =
+          gst_rtmp_chunk_streams_get (cstreams, CHUNK_STREAM_ID);
+      gint64 start = g_get_monotonic_time ();
+
+      total = 0;
+      for (m = 0; m < n_messages; m++)
+        total += benches[i].func (cstream, messages[m], chunk_size);
+      best = MIN (best, g_get_monotonic_time () - start);
+
+      gst_rtmp_chunk_streams_free (cstreams);
+    }
+
+    printf ("  %-20s %12" G_GINT64_FORMAT " %10.1f\n", benches[i].name, best,
+        best > 0 ? (gdouble) total / best : 0.0);
+  }
+
+  for (m = 0; m < n_messages; m++)
+    gst_buffer_unref (messages[m]);
+  g_free (messages);
+
+  return 0;
+}
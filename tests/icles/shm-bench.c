@@ -0,0 +1,369 @@
+/* GStreamer
+ *
+ * Copyright (C) 2026 agent <agent@local>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/* Measures the per-buffer latency and CPU usage of the shm transport used
+ * by shmsink and shmsrc, once with the buffers signalled over the socket
+ * and once with the shared memory rings.
+ *
+ * The writer runs in this process and the reader in a forked child, every
+ * buffer carries the time at which it was sent.
+ *
+ *   shm-bench [-n buffers] [-s size] [-r ring-slots] [-i interval-us]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#include <poll.h>
+#include <signal.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+
+#include "shmpipe.h"
+
+typedef struct
+{
+  uint64_t seq;
+  uint64_t timestamp;
+} BenchHeader;
+
+typedef struct
+{
+  int error;
+  double mean;
+  double p50;
+  double p99;
+  double max;
+  double cpu;
+} BenchStats;
+
+static uint64_t
+now_ns (void)
+{
+  struct timespec ts;
+
+  clock_gettime (CLOCK_MONOTONIC, &ts);
+  return (uint64_t) ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static double
+cpu_us (const struct rusage *start, const struct rusage *stop)
+{
+  return (stop->ru_utime.tv_sec - start->ru_utime.tv_sec) * 1e6 +
+      (stop->ru_utime.tv_usec - start->ru_utime.tv_usec) +
+      (stop->ru_stime.tv_sec - start->ru_stime.tv_sec) * 1e6 +
+      (stop->ru_stime.tv_usec - start->ru_stime.tv_usec);
+}
+
+static int
+compare_u64 (const void *a, const void *b)
+{
+  uint64_t x = *(const uint64_t *) a, y = *(const uint64_t *) b;
+
+  return x < y ? -1 : x > y;
+}
+
+static void
+run_reader (const char *path, unsigned int n_buffers, int result_fd)
+{
+  BenchStats stats = { 0 };
+  struct rusage start, stop;
+  uint64_t *latencies;
+  uint64_t total = 0;
+  unsigned int received = 0;
+  ShmPipe *pipe;
+  struct pollfd pfd;
+
+  latencies = calloc (n_buffers, sizeof (uint64_t));
+
+  pipe = sp_client_open (path);
+  if (!pipe) {
+    stats.error = 1;
+    goto done;
+  }
+
+  pfd.fd = sp_get_fd (pipe);
+  pfd.events = POLLIN;
+
+  getrusage (RUSAGE_SELF, &start);
+
+  while (received < n_buffers) {
+    BenchHeader header;
+    char *buf = NULL;
+    long int size;
+
+    size = sp_client_recv_ring (pipe, &buf);
+    if (size < 0) {
+      stats.error = 2;
+      break;
+    }
+
+    if (!buf) {
+      if (poll (&pfd, 1, -1) < 0 && errno != EINTR) {
+        stats.error = 3;
+        break;
+      }
+      if (!(pfd.revents & POLLIN))
+        continue;
+
+      size = sp_client_recv (pipe, &buf);
+      if (size < 0) {
+        stats.error = 4;
+        break;
+      }
+      if (!buf)
+        continue;
+    }
+
+    memcpy (&header, buf, sizeof (header));
+    latencies[received] = now_ns () - header.timestamp;
+    total += latencies[received];
+
+    /* Buffers must arrive in order */
+    if (header.seq != received) {
+      stats.error = 5;
+      break;
+    }
+    received++;
+
+    sp_client_recv_finish (pipe, buf);
+  }
+
+  getrusage (RUSAGE_SELF, &stop);
+
+  if (!stats.error) {
+    qsort (latencies, n_buffers, sizeof (uint64_t), compare_u64);
+    stats.mean = total / 1000.0 / n_buffers;
+    stats.p50 = latencies[n_buffers / 2] / 1000.0;
+    stats.p99 = latencies[(n_buffers * 99) / 100] / 1000.0;
+    stats.max = latencies[n_buffers - 1] / 1000.0;
+    stats.cpu = cpu_us (&start, &stop) / n_buffers;
+  }
+
+  sp_client_close (pipe);
+
+done:
+  free (latencies);
+  if (write (result_fd, &stats, sizeof (stats)) != sizeof (stats))
+    exit (1);
+}
+
+/* Handles everything the reader sent, waiting at most @timeout ms for
+ * the first message */
+static int
+service_client (ShmPipe * pipe, ShmClient * client, int timeout)
+{
+  struct pollfd pfd;
+  int ret;
+
+  pfd.fd = sp_writer_get_client_fd (client);
+  pfd.events = POLLIN;
+
+  while ((ret = poll (&pfd, 1, timeout)) > 0) {
+    if (!(pfd.revents & POLLIN))
+      return -1;
+
+    if (sp_writer_recv (pipe, client, NULL) < 0)
+      return -1;
+    if (sp_writer_recv_acks (pipe, client, NULL, NULL) < 0)
+      return -1;
+
+    /* The reader hangs up right after sending its last acks, read them
+     * one by one */
+    if (pfd.revents & POLLHUP)
+      break;
+
+    timeout = 0;
+  }
+
+  return ret;
+}
+
+static int
+run_mode (unsigned int n_buffers, size_t size, unsigned int ring_slots,
+    unsigned int interval_us)
+{
+  BenchStats stats;
+  struct rusage start, stop;
+  struct pollfd pfd;
+  char path[64];
+  ShmPipe *pipe;
+  ShmClient *client;
+  unsigned int i;
+  int result_fds[2];
+  pid_t pid;
+  double writer_cpu;
+
+  snprintf (path, sizeof (path), "/tmp/shm-bench.%d", (int) getpid ());
+
+  pipe = sp_writer_create (path, size * 32, 0600);
+  if (!pipe) {
+    fprintf (stderr, "Could not create the shm pipe\n");
+    return 1;
+  }
+
+  if (ring_slots)
+    ring_slots = sp_writer_set_ring_slots (pipe, ring_slots);
+
+  if (socketpair (AF_UNIX, SOCK_STREAM, 0, result_fds) < 0) {
+    sp_writer_close (pipe, NULL, NULL);
+    return 1;
+  }
+
+  pid = fork ();
+  if (pid == 0) {
+    close (result_fds[0]);
+    run_reader (sp_writer_get_path (pipe), n_buffers, result_fds[1]);
+    _exit (0);
+  }
+  close (result_fds[1]);
+
+  pfd.fd = sp_get_fd (pipe);
+  pfd.events = POLLIN;
+  if (poll (&pfd, 1, 5000) <= 0 ||
+      !(client = sp_writer_accept_client (pipe))) {
+    fprintf (stderr, "No reader connected\n");
+    goto error;
+  }
+
+  getrusage (RUSAGE_SELF, &start);
+
+  for (i = 0; i < n_buffers; i++) {
+    BenchHeader header;
+    ShmBlock *block;
+    char *buf;
+
+    if (service_client (pipe, client, 0) < 0)
+      goto client_error;
+
+    while (!(block = sp_writer_alloc_block (pipe, size))) {
+      if (service_client (pipe, client, -1) < 0)
+        goto client_error;
+    }
+
+    while (!sp_writer_can_send (pipe)) {
+      if (service_client (pipe, client, -1) < 0)
+        goto client_error;
+    }
+
+    buf = sp_writer_block_get_buf (block);
+    header.seq = i;
+    header.timestamp = now_ns ();
+    memcpy (buf, &header, sizeof (header));
+
+    if (sp_writer_send_buf (pipe, buf, size, NULL) != 1) {
+      sp_writer_free_block (block);
+      goto client_error;
+    }
+    sp_writer_free_block (block);
+
+    if (interval_us)
+      usleep (interval_us);
+  }
+
+  while (sp_writer_pending_writes (pipe)) {
+    if (service_client (pipe, client, -1) < 0)
+      goto client_error;
+  }
+
+  getrusage (RUSAGE_SELF, &stop);
+  writer_cpu = cpu_us (&start, &stop) / n_buffers;
+
+  if (read (result_fds[0], &stats, sizeof (stats)) != sizeof (stats) ||
+      stats.error) {
+    fprintf (stderr, "Reader failed\n");
+    goto error;
+  }
+
+  waitpid (pid, NULL, 0);
+  close (result_fds[0]);
+  sp_writer_close (pipe, NULL, NULL);
+
+  if (ring_slots)
+    printf ("ring (%5u) ", ring_slots);
+  else
+    printf ("socket      ");
+  printf ("%10.2f %10.2f %10.2f %10.2f %12.2f %12.2f\n", stats.mean,
+      stats.p50, stats.p99, stats.max, writer_cpu, stats.cpu);
+
+  return 0;
+
+client_error:
+  fprintf (stderr, "Reader went away\n");
+error:
+  kill (pid, SIGTERM);
+  waitpid (pid, NULL, 0);
+  close (result_fds[0]);
+  sp_writer_close (pipe, NULL, NULL);
+  return 1;
+}
+
+int
+main (int argc, char **argv)
+{
+  unsigned int n_buffers = 100000;
+  unsigned int ring_slots = 64;
+  unsigned int interval_us = 0;
+  size_t size = 4096;
+  int opt;
+
+  while ((opt = getopt (argc, argv, "n:s:r:i:")) != -1) {
+    switch (opt) {
+      case 'n':
+        n_buffers = strtoul (optarg, NULL, 10);
+        break;
+      case 's':
+        size = strtoul (optarg, NULL, 10);
+        break;
+      case 'r':
+        ring_slots = strtoul (optarg, NULL, 10);
+        break;
+      case 'i':
+        interval_us = strtoul (optarg, NULL, 10);
+        break;
+      default:
+        fprintf (stderr, "Usage: %s [-n buffers] [-s size] [-r ring-slots]"
+            " [-i interval-us]\n", argv[0]);
+        return 1;
+    }
+  }
+
+  if (n_buffers == 0 || ring_slots == 0 || size < sizeof (BenchHeader)) {
+    fprintf (stderr, "Invalid parameters\n");
+    return 1;
+  }
+
+  printf ("%u buffers of %zu bytes, %u us apart\n", n_buffers, size,
+      interval_us);
+  printf ("%-12s %10s %10s %10s %10s %12s %12s\n", "mode", "mean (us)",
+      "p50 (us)", "p99 (us)", "max (us)", "writer (us)", "reader (us)");
+
+  if (run_mode (n_buffers, size, 0, interval_us))
+    return 1;
+  if (run_mode (n_buffers, size, ring_slots, interval_us))
+    return 1;
+
+  return 0;
+}
@@ -0,0 +1,274 @@
+/* GStreamer
+ *
+ * Copyright (C) 2026 agent <agent@local>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/* Measures the throughput of mpegtsmux and the number of buffers it
+ * allocates and pushes for each output packet.
+ *
+ * A number of H.264 streams made of dummy access units are muxed as fast
+ * as possible into a fakesink. The buffers are counted with a probe on the
+ * muxer's source pad and the allocations with the buffer lifecycle
+ * tracer hooks.
+ *
+ *   tsmux-bench [-s streams] [-f frames] [-z frame-size] [-a alignment]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/resource.h>
+
+#include <gst/gst.h>
+#include <gst/app/gstappsrc.h>
+
+typedef struct
+{
+  guint64 pushes;
+  guint64 buffers;
+  guint64 bytes;
+} OutputStats;
+
+/* Minimal tracer that only exists to receive the buffer hooks */
+typedef struct
+{
+  GstTracer parent;
+} BenchTracer;
+
+typedef struct
+{
+  GstTracerClass parent_class;
+} BenchTracerClass;
+
+GType bench_tracer_get_type (void);
+G_DEFINE_TYPE (BenchTracer, bench_tracer, GST_TYPE_TRACER);
+
+static void
+bench_tracer_class_init (BenchTracerClass * klass)
+{
+}
+
+static void
+bench_tracer_init (BenchTracer * self)
+{
+}
+
+static gint buffers_allocated;
+
+static void
+buffer_alloc_cb (GObject * tracer, guint64 ts, GstMiniObject * object)
+{
+  if (GST_IS_BUFFER (object))
+    g_atomic_int_inc (&buffers_allocated);
+}
+
+static gboolean
+count_buffer (GstBuffer ** buf, guint idx, gpointer user_data)
+{
+  OutputStats *stats = user_data;
+
+  stats->buffers++;
+  stats->bytes += gst_buffer_get_size (*buf);
+
+  return TRUE;
+}
+
+static GstPadProbeReturn
+output_probe (GstPad * pad, GstPadProbeInfo * info, gpointer user_data)
+{
+  OutputStats *stats = user_data;
+
+  stats->pushes++;
+
+  if (info->type & GST_PAD_PROBE_TYPE_BUFFER_LIST) {
+    gst_buffer_list_foreach (GST_PAD_PROBE_INFO_BUFFER_LIST (info),
+        count_buffer, stats);
+  } else {
+    GstBuffer *buf = GST_PAD_PROBE_INFO_BUFFER (info);
+
+    count_buffer (&buf, 0, stats);
+  }
+
+  return GST_PAD_PROBE_OK;
+}
+
+static void
+queue_frames (GstElement * src, guint n_frames, gsize frame_size)
+{
+  static const guint8 aud[] = { 0x00, 0x00, 0x00, 0x01, 0x09, 0xf0 };
+  guint i;
+
+  for (i = 0; i < n_frames; i++) {
+    GstBuffer *buf = gst_buffer_new_allocate (NULL, frame_size, NULL);
+    GstMapInfo map;
+
+    gst_buffer_map (buf, &map, GST_MAP_WRITE);
+    memset (map.data, 0xaa, map.size);
+    memcpy (map.data, aud, MIN (sizeof (aud), map.size));
+    gst_buffer_unmap (buf, &map);
+
+    GST_BUFFER_PTS (buf) = GST_BUFFER_DTS (buf) =
+        gst_util_uint64_scale (i, GST_SECOND, 25) + GST_SECOND;
+    GST_BUFFER_DURATION (buf) = GST_SECOND / 25;
+    if (i % 25 != 0)
+      GST_BUFFER_FLAG_SET (buf, GST_BUFFER_FLAG_DELTA_UNIT);
+
+    gst_app_src_push_buffer (GST_APP_SRC (src), buf);
+  }
+  gst_app_src_end_of_stream (GST_APP_SRC (src));
+}
+
+static gint64
+cpu_time_usec (void)
+{
+  struct rusage ru;
+
+  getrusage (RUSAGE_SELF, &ru);
+
+  return (gint64) ru.ru_utime.tv_sec * G_USEC_PER_SEC + ru.ru_utime.tv_usec +
+      (gint64) ru.ru_stime.tv_sec * G_USEC_PER_SEC + ru.ru_stime.tv_usec;
+}
+
+static void
+usage (const gchar * name)
+{
+  g_printerr ("usage: %s [-s streams] [-f frames] [-z frame-size] "
+      "[-a alignment]\n", name);
+}
+
+int
+main (int argc, char **argv)
+{
+  guint n_streams = 4, n_frames = 2500, alignment = 7;
+  gsize frame_size = 20000;
+  GstElement *pipeline, *mux, *sink;
+  GstCaps *caps;
+  GstPad *pad;
+  GstBus *bus;
+  GstMessage *msg;
+  GstTracer *tracer;
+  OutputStats stats = { 0, };
+  gint64 start, end, cpu_start, cpu_end;
+  gdouble secs;
+  guint i;
+  int opt;
+
+  gst_init (&argc, &argv);
+
+  while ((opt = getopt (argc, argv, "s:f:z:a:h")) != -1) {
+    switch (opt) {
+      case 's':
+        n_streams = atoi (optarg);
+        break;
+      case 'f':
+        n_frames = atoi (optarg);
+        break;
+      case 'z':
+        frame_size = atoi (optarg);
+        break;
+      case 'a':
+        alignment = atoi (optarg);
+        break;
+      default:
+        usage (argv[0]);
+        return 1;
+    }
+  }
+
+  if (n_streams == 0 || n_frames == 0 || frame_size == 0) {
+    usage (argv[0]);
+    return 1;
+  }
+
+  tracer = g_object_new (bench_tracer_get_type (), NULL);
+  gst_tracing_register_hook (tracer, "mini-object-created",
+      G_CALLBACK (buffer_alloc_cb));
+
+  pipeline = gst_pipeline_new (NULL);
+  mux = gst_element_factory_make ("mpegtsmux", NULL);
+  sink = gst_element_factory_make ("fakesink", NULL);
+  if (!mux || !sink) {
+    g_printerr ("mpegtsmux or fakesink missing\n");
+    return 1;
+  }
+  g_object_set (mux, "alignment", alignment, NULL);
+  g_object_set (sink, "sync", FALSE, NULL);
+  gst_bin_add_many (GST_BIN (pipeline), mux, sink, NULL);
+  gst_element_link (mux, sink);
+
+  pad = gst_element_get_static_pad (mux, "src");
+  gst_pad_add_probe (pad, GST_PAD_PROBE_TYPE_BUFFER |
+      GST_PAD_PROBE_TYPE_BUFFER_LIST, output_probe, &stats, NULL);
+  gst_object_unref (pad);
+
+  caps = gst_caps_from_string ("video/x-h264, stream-format=byte-stream, "
+      "alignment=au, width=1920, height=1080, framerate=25/1");
+
+  for (i = 0; i < n_streams; i++) {
+    GstElement *src = gst_element_factory_make ("appsrc", NULL);
+
+    g_object_set (src, "caps", caps, "format", GST_FORMAT_TIME,
+        "max-bytes", G_GUINT64_CONSTANT (0), "block", FALSE, NULL);
+    gst_bin_add (GST_BIN (pipeline), src);
+    gst_element_link (src, mux);
+
+    queue_frames (src, n_frames, frame_size);
+  }
+  gst_caps_unref (caps);
+
+  g_atomic_int_set (&buffers_allocated, 0);
+  start = g_get_monotonic_time ();
+  cpu_start = cpu_time_usec ();
+
+  gst_element_set_state (pipeline, GST_STATE_PLAYING);
+  bus = gst_element_get_bus (pipeline);
+  msg = gst_bus_timed_pop_filtered (bus, GST_CLOCK_TIME_NONE,
+      GST_MESSAGE_EOS | GST_MESSAGE_ERROR);
+
+  end = g_get_monotonic_time ();
+  cpu_end = cpu_time_usec ();
+
+  if (GST_MESSAGE_TYPE (msg) == GST_MESSAGE_ERROR) {
+    GError *err = NULL;
+
+    gst_message_parse_error (msg, &err, NULL);
+    g_printerr ("ERROR: %s\n", err->message);
+    g_clear_error (&err);
+    return 1;
+  }
+  gst_message_unref (msg);
+  gst_object_unref (bus);
+
+  gst_element_set_state (pipeline, GST_STATE_NULL);
+  gst_object_unref (pipeline);
+  gst_object_unref (tracer);
+
+  secs = (gdouble) (end - start) / G_USEC_PER_SEC;
+
+  printf ("%8s %6s %10s %10s %10s %12s %10s %8s\n", "streams", "align",
+      "packets", "pushes", "buffers", "allocated", "MB/s", "cpu %");
+  printf ("%8u %6u %10" G_GUINT64_FORMAT " %10" G_GUINT64_FORMAT " %10"
+      G_GUINT64_FORMAT " %12d %10.1f %8.1f\n", n_streams, alignment,
+      stats.bytes / 188, stats.pushes, stats.buffers,
+      g_atomic_int_get (&buffers_allocated),
+      stats.bytes / secs / (1024 * 1024),
+      100.0 * (cpu_end - cpu_start) / (end - start));
+
+  return 0;
+}